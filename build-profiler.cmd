@@ -15,6 +15,11 @@ SET CPPFLAGS=%INCLUDES% /FC /nologo /W4 /WX /wd4505 /Zi /EHsc /Ob2it
 SET LIBRARIES=User32.lib Gdi32.lib Shell32.lib Advapi32.lib winmm.lib
 SET LNKFLAGS=%LIBRARIES%
 
+IF "%1" == "native" (
+    SET DEFINES=%DEFINES% /D PROFILER_NATIVE_BACKEND=1
+    @ECHO Building native ring-buffer backend...
+)
+
 IF NOT EXIST %OUTPUTDIR% mkdir %OUTPUTDIR%
 
 PUSHD %OUTPUTDIR%
@@ -0,0 +1,15 @@
+#!/bin/sh
+# Build the profiler shared library (native ring-buffer backend) on non-Windows platforms.
+
+SCRIPT_ROOT="$(cd "$(dirname "$0")" && pwd)"
+OUTPUTDIR="$SCRIPT_ROOT/build"
+INCLUDES="-I$SCRIPT_ROOT/include -I$SCRIPT_ROOT/src"
+DEFINES="-DENABLE_PROFILER=1 -DPROFILER_NATIVE_ALLOC_HOOKS=1 -D_GNU_SOURCE"
+CPPFLAGS="$INCLUDES -std=c++11 -Wall -Wextra -Werror -Wno-unused-function -g -O2 -fPIC -fno-exceptions -fno-rtti"
+LIBRARIES="-lpthread"
+CXX="${CXX:-c++}"
+
+mkdir -p "$OUTPUTDIR"
+
+cd "$OUTPUTDIR" || exit 1
+$CXX $CPPFLAGS $DEFINES -shared "$SCRIPT_ROOT/src/libmain.cc" -o libprofiler_p.so $LIBRARIES || exit 1
@@ -0,0 +1,15 @@
+#!/bin/sh
+# Build the tests for the portable parts of the profiler on non-Windows platforms.
+
+SCRIPT_ROOT="$(cd "$(dirname "$0")" && pwd)"
+OUTPUTDIR="$SCRIPT_ROOT/build"
+INCLUDES="-I$SCRIPT_ROOT/include -I$SCRIPT_ROOT/src"
+DEFINES="-D_GNU_SOURCE"
+CPPFLAGS="$INCLUDES -std=c++11 -Wall -Wextra -Werror -Wno-unused-function -g -O0"
+LIBRARIES="-lpthread"
+CXX="${CXX:-c++}"
+
+mkdir -p "$OUTPUTDIR"
+
+cd "$OUTPUTDIR" || exit 1
+$CXX $CPPFLAGS $DEFINES "$SCRIPT_ROOT/src/tests.cc" -o runtests $LIBRARIES || exit 1
@@ -18,7 +18,7 @@
 
 /// @summary Define the minor version of the profiler. The minor version increments when a backwards-compatible API change is introduced.
 #ifndef PROFILER_VERSION_MINOR
-#define PROFILER_VERSION_MINOR    0
+#define PROFILER_VERSION_MINOR    5
 #endif
 
 /// @summary Define the constant used to indicate an invalid or unused task identifier.
@@ -26,6 +26,20 @@
 #define INVALID_TASK_ID           0x7FFFFFFFUL
 #endif
 
+/// @summary Define the site identifier returned by RegisterZoneSite when a site can't be registered. Zones with this identifier aren't recorded.
+#ifndef INVALID_ZONE_SITE
+#define INVALID_ZONE_SITE         0
+#endif
+
+/// @summary Paste two tokens together after expanding them, so that PROFILER_ZONE can name its statics after the line number.
+#define PROFILER_CONCAT_INNER(a, b) a##b
+#define PROFILER_CONCAT(a, b)     PROFILER_CONCAT_INNER(a, b)
+
+/// @summary The public functions use the __cdecl calling convention, which is implicit on non-Windows targets.
+#if !defined(_MSC_VER) && !defined(__cdecl)
+#define __cdecl
+#endif
+
 /*//////////////////
 //   Data Types   //
 //////////////////*/
@@ -35,6 +49,8 @@ enum PROFILER_RESULT : int32_t
     PROFILER_RESULT_SUCCESS         = 0, /// The profiler was successfully initialized.
     PROFILER_RESULT_INVALID_VERSION = 1, /// The profiler does not support the requested API version.
     PROFILER_RESULT_INVALID_APPINFO = 2, /// The application information supplied in the PROFILER_CONFIG is not valid.
+    PROFILER_RESULT_OUTPUT_ERROR    = 3, /// The profiler could not open its output file or start its background thread.
+    PROFILER_RESULT_UNSUPPORTED     = 4, /// The PROFILER_CONFIG requests a feature that is not available in this build of the profiler.
 };
 
 /// @summary Define the configuration information passed by the application to the profiler.
@@ -47,11 +63,27 @@ struct PROFILER_CONFIG
     uint32_t    ProfilerMinorVersion;    /// The minor version of the profiler API the application is built against.
     uint32_t    ComputePoolSize;         /// The maximum number of worker threads in the application compute thread pool.
     uint32_t    GeneralPoolSize;         /// The maximum number of worker threads in the application general thread pool.
+    char const *TraceFilePath;           /// Version 1.1+: A NULL-terminated path of the trace file written by the native backend, or NULL to use the default path.
+    uint32_t    ThreadBufferSize;        /// Version 1.1+: The number of event records in each per-thread buffer of the native backend, or 0 to use the default size.
+    uint32_t    TaskSampleRate;          /// Version 1.2+: Record every transition of 1 in TaskSampleRate tasks, chosen by a hash of the task ID, and ignore the rest. 0 or 1 records every task.
+    uint32_t    TaskCounters;            /// Version 1.4+: Non-zero to record hardware counters for each task executed by a registered worker thread. Native backend on Linux only.
+    uint32_t    TaskAllocations;         /// Version 1.5+: Non-zero to record the heap allocations and frees made by each task. Native backend built with PROFILER_NATIVE_ALLOC_HOOKS only; InitializeProfiler returns PROFILER_RESULT_UNSUPPORTED otherwise.
+};
+
+/// @summary Define the static description of a code location marked with PROFILER_ZONE. Instances are constant-initialized by the
+/// compiler and must have static storage duration, since the profiler keeps a pointer to them.
+struct PROFILER_ZONE_SITE
+{
+    char const *Name;                    /// A NULL-terminated ANSI string naming the zone.
+    char const *File;                    /// The source file containing the zone, from __FILE__.
+    char const *Function;                /// The function containing the zone, from __FUNCTION__.
+    uint32_t    Line;                    /// The line number of the zone, from __LINE__.
 };
 
 /*///////////////
 //   Globals   //
 ///////////////*/
+#if defined(_WIN32)
 /// @summary The MOF class Image event GUID (ImageLoadGuid). The GUID is {2cb15d1d-5fc1-11d2-abe1-00a0c911f518}.
 /// See NT Kernel Logger Constants: https://msdn.microsoft.com/en-us/library/windows/desktop/aa364085(v=vs.85).aspx
 DEFINE_GUID(
@@ -111,6 +143,7 @@ DEFINE_GUID(
     0xfee0, 
     0x4797, 
     0x93, 0x0f, 0x2b, 0x08, 0x38, 0x9a, 0x3e, 0xfd);
+#endif /* defined(_WIN32) */
 
 /*//////////////////////////
 //   Internal Functions   //
@@ -119,6 +152,29 @@ DEFINE_GUID(
 /*////////////////////////
 //   Public Functions   //
 ////////////////////////*/
+/// @summary Determine whether the events of a task are recorded when sampling 1 in sample_rate tasks. The selection depends only
+/// on the task ID, so every transition of a chosen task is kept, and hashing spreads the chosen tasks evenly over entry points and
+/// sources even when task IDs are allocated sequentially. Applications may call this to skip work for tasks that won't be recorded.
+/// @param task_id The identifier of the task.
+/// @param sample_rate The value of PROFILER_CONFIG::TaskSampleRate. 0 or 1 selects every task.
+/// @return true if events for the task are recorded.
+static inline bool
+TaskSampled
+(
+    uint32_t     task_id,
+    uint32_t sample_rate
+)
+{
+    if (sample_rate <= 1)
+        return true;
+    uint32_t h = task_id;
+    h ^= h >> 16; h *= 0x85EBCA6BU;
+    h ^= h >> 13; h *= 0xC2B2AE35U;
+    h ^= h >> 16;
+    // keep hashes in the lowest 1/sample_rate of the range, which needs no division.
+    return ((uint64_t(h) * sample_rate) >> 32) == 0;
+}
+
 #if ENABLE_PROFILER
 /// @summary Initialize the profiler and register basic application properties.
 /// @param config An object describing the application to the profiler.
@@ -131,7 +187,7 @@ InitializeProfiler
 
 /// @summary Shutdown the profiler prior to application shutdown.
 extern void __cdecl
-ShowdownProfiler
+ShutdownProfiler
 (
     void
 );
@@ -203,6 +259,46 @@ MarkTaskFinish
 (
     uint32_t task_id
 );
+
+/// @summary Version 1.3+: Assign an identifier to a zone site. Called once per site by PROFILER_ZONE, from any thread, before or after InitializeProfiler.
+/// @param site The site description, which must have static storage duration.
+/// @return The site identifier, which fits in 16 bits, or INVALID_ZONE_SITE if too many sites have been registered.
+extern uint32_t __cdecl
+RegisterZoneSite
+(
+    PROFILER_ZONE_SITE const *site
+);
+
+/// @summary Version 1.3+: Mark the point in time at which the calling thread enters a zone. Zones on a thread must nest.
+/// @param site_id The identifier returned by RegisterZoneSite.
+extern void __cdecl
+MarkZoneBegin
+(
+    uint32_t site_id
+);
+
+/// @summary Version 1.3+: Mark the point in time at which the calling thread leaves the zone it entered most recently.
+/// @param site_id The identifier passed to the matching MarkZoneBegin.
+extern void __cdecl
+MarkZoneEnd
+(
+    uint32_t site_id
+);
+
+/// @summary Mark the enclosing scope as a zone for its lifetime. See PROFILER_ZONE.
+struct PROFILER_ZONE_SCOPE
+{
+    uint32_t SiteId;                     /// The identifier of the zone site.
+    explicit PROFILER_ZONE_SCOPE(uint32_t site_id) : SiteId(site_id) { MarkZoneBegin(site_id); }
+    ~PROFILER_ZONE_SCOPE() { MarkZoneEnd(SiteId); }
+};
+
+/// @summary Mark the rest of the enclosing scope as a named zone. The site description is constant-initialized, and its identifier is a
+/// function-local static assigned on first use, so the hot path writes only a timestamp and the site identifier. At most one per line.
+#define PROFILER_ZONE(name)                                                                                                            \
+    static PROFILER_ZONE_SITE const PROFILER_CONCAT(ProfilerZoneSite_, __LINE__) = { name, __FILE__, __FUNCTION__, uint32_t(__LINE__) }; \
+    static uint32_t const PROFILER_CONCAT(ProfilerZoneId_, __LINE__) = RegisterZoneSite(&PROFILER_CONCAT(ProfilerZoneSite_, __LINE__));   \
+    PROFILER_ZONE_SCOPE PROFILER_CONCAT(ProfilerZone_, __LINE__)(PROFILER_CONCAT(ProfilerZoneId_, __LINE__))
 #else /* the profiler is disabled */
 #define InitializeProfiler(config)        1
 #define ShutdownProfiler                  
@@ -212,5 +308,9 @@ MarkTaskFinish
 #define MarkTaskReadyToRun                
 #define MarkTaskLaunch                    
 #define MarkTaskFinish                    
+#define RegisterZoneSite(site)            INVALID_ZONE_SITE
+#define MarkZoneBegin(site_id)
+#define MarkZoneEnd(site_id)
+#define PROFILER_ZONE(name)
 #endif
 
@@ -0,0 +1,235 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Define the on-disk layout of the native .ptrace trace format. The
+/// format is written by the native profiler backend and read by the trace
+/// loader. A file is a PTRACE_FILE_HEADER followed by a sequence of blocks.
+/// Each block has a PTRACE_BLOCK_HEADER and holds data for a single thread.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////////
+//   Preprocessor   //
+////////////////////*/
+/// @summary Define the magic value at the start of a .ptrace file, 'PTRC' when read as bytes.
+#ifndef PTRACE_FILE_MAGIC
+#define PTRACE_FILE_MAGIC                  0x43525450UL
+#endif
+
+/// @summary Define the magic value at the start of each block, 'BLK0' when read as bytes. Used to validate block boundaries.
+#ifndef PTRACE_BLOCK_MAGIC
+#define PTRACE_BLOCK_MAGIC                 0x304B4C42UL
+#endif
+
+/// @summary Define the major version of the .ptrace format. Readers reject files with a different major version.
+#ifndef PTRACE_VERSION_MAJOR
+#define PTRACE_VERSION_MAJOR               1
+#endif
+
+/// @summary Define the minor version of the .ptrace format. Minor versions only add new block types, which readers skip, and fields at the end of the file header.
+#ifndef PTRACE_VERSION_MINOR
+#define PTRACE_VERSION_MINOR               6
+#endif
+
+/// @summary Define the number of bits of the event tag byte used for the event type.
+#ifndef PTRACE_TAG_TYPE_BITS
+#define PTRACE_TAG_TYPE_BITS               3
+#endif
+
+/// @summary Define the mask used to extract the event type from an event tag byte.
+#ifndef PTRACE_TAG_TYPE_MASK
+#define PTRACE_TAG_TYPE_MASK               ((1U << PTRACE_TAG_TYPE_BITS) - 1U)
+#endif
+
+/// @summary Define the largest source index that can be packed into the upper bits of an event tag byte. Larger indices follow as a varint.
+#ifndef PTRACE_TAG_MAX_PACKED_SOURCE
+#define PTRACE_TAG_MAX_PACKED_SOURCE       ((1U << (8 - PTRACE_TAG_TYPE_BITS)) - 2U)
+#endif
+
+/// @summary Define the maximum number of bytes produced by encoding a single event, excluding dependencies.
+#ifndef PTRACE_MAX_EVENT_SIZE
+#define PTRACE_MAX_EVENT_SIZE              48
+#endif
+
+/// @summary Define the maximum number of bytes produced by encoding a single dependency.
+#ifndef PTRACE_MAX_DEPENDENCY_SIZE
+#define PTRACE_MAX_DEPENDENCY_SIZE         5
+#endif
+
+/// @summary Define the maximum number of bytes produced by encoding a single zone event.
+#ifndef PTRACE_MAX_ZONE_EVENT_SIZE
+#define PTRACE_MAX_ZONE_EVENT_SIZE         13
+#endif
+
+/// @summary Define the number of hardware counters that can be recorded for each task. See PTRACE_COUNTER.
+#ifndef PTRACE_MAX_COUNTERS
+#define PTRACE_MAX_COUNTERS                5
+#endif
+
+/// @summary Define the maximum number of bytes produced by encoding the counters of a single task.
+#ifndef PTRACE_MAX_TASK_COUNTERS_SIZE
+#define PTRACE_MAX_TASK_COUNTERS_SIZE      (16 + (PTRACE_MAX_COUNTERS * 10))
+#endif
+
+/// @summary Define the maximum number of bytes produced by encoding the heap allocations of a single task.
+#ifndef PTRACE_MAX_TASK_ALLOCS_SIZE
+#define PTRACE_MAX_TASK_ALLOCS_SIZE        45
+#endif
+
+/*//////////////////
+//   Data Types   //
+//////////////////*/
+/// @summary Define the types of blocks that can appear in a .ptrace file. Unknown block types are skipped by readers.
+enum PTRACE_BLOCK_TYPE : uint32_t
+{
+    PTRACE_BLOCK_TYPE_EVENTS               = 1,   /// EventCount compact task events produced by ThreadId.
+    PTRACE_BLOCK_TYPE_WORKER               = 2,   /// EventCount PTRACE_WORKER_INFO records.
+    PTRACE_BLOCK_TYPE_TASK_SOURCE          = 3,   /// A single PTRACE_SOURCE_INFO followed by the source name.
+    PTRACE_BLOCK_TYPE_CLOCK_SYNC           = 4,   /// EventCount PTRACE_CLOCK_SYNC records. Added in minor version 1.
+    PTRACE_BLOCK_TYPE_ZONE_SITE            = 5,   /// A single PTRACE_ZONE_SITE_INFO followed by the site strings. Added in minor version 3.
+    PTRACE_BLOCK_TYPE_ZONES                = 6,   /// EventCount compact zone events produced by ThreadId. See PtraceEncodeZoneEvent. Added in minor version 3.
+    PTRACE_BLOCK_TYPE_TASK_COUNTERS        = 7,   /// EventCount compact per-task counter records produced by ThreadId. See PtraceEncodeTaskCounters. Added in minor version 4.
+    PTRACE_BLOCK_TYPE_TASK_ALLOCS          = 8,   /// EventCount compact per-task heap allocation records produced by ThreadId. See PtraceEncodeTaskAllocs. Added in minor version 5.
+    PTRACE_BLOCK_TYPE_TASK_HEAP            = 9,   /// EventCount compact per-task heap allocation and free records produced by ThreadId. See PtraceEncodeTaskAllocs. Added in minor version 6.
+};
+
+/// @summary Define the event types stored in the low PTRACE_TAG_TYPE_BITS bits of each event tag byte.
+enum PTRACE_EVENT_TYPE : uint8_t
+{
+    PTRACE_EVENT_TYPE_DEFINE_TASK          = 0,   /// A task was defined.
+    PTRACE_EVENT_TYPE_TASK_READY_TO_RUN    = 1,   /// A task became ready-to-run.
+    PTRACE_EVENT_TYPE_TASK_LAUNCH          = 2,   /// A worker thread started executing a task.
+    PTRACE_EVENT_TYPE_TASK_FINISH          = 3,   /// A worker thread finished executing a task.
+};
+
+/// @summary Define the hardware counters that can be recorded for each task. Values are bit positions in PTRACE_TASK_COUNTERS::CounterMask.
+enum PTRACE_COUNTER : uint32_t
+{
+    PTRACE_COUNTER_CYCLES                  = 0,   /// Core cycles spent executing the task in user mode.
+    PTRACE_COUNTER_INSTRUCTIONS            = 1,   /// Instructions retired by the task in user mode.
+    PTRACE_COUNTER_L1D_MISSES              = 2,   /// Level 1 data cache read misses.
+    PTRACE_COUNTER_LLC_MISSES              = 3,   /// Last level cache misses.
+    PTRACE_COUNTER_BRANCH_MISSES           = 4,   /// Mispredicted branch instructions.
+};
+
+/// @summary Define the data at the start of every .ptrace file. All values are little-endian.
+struct PTRACE_FILE_HEADER
+{
+    uint32_t                    Magic;            /// PTRACE_FILE_MAGIC.
+    uint16_t                    VersionMajor;     /// PTRACE_VERSION_MAJOR.
+    uint16_t                    VersionMinor;     /// PTRACE_VERSION_MINOR.
+    uint32_t                    HeaderSize;       /// The size of the file header, in bytes. The first block starts at this offset. Files before minor version 2 have a shorter header.
+    uint32_t                    ProcessId;        /// The operating system identifier of the profiled process.
+    uint32_t                    AppMajorVersion;  /// The major version of the application.
+    uint32_t                    AppMinorVersion;  /// The minor version of the application.
+    uint32_t                    ComputePoolSize;  /// The maximum number of worker threads in the application compute thread pool.
+    uint32_t                    GeneralPoolSize;  /// The maximum number of worker threads in the application general thread pool.
+    uint64_t                    ClockFrequency;   /// The number of timestamp ticks per second. An estimate if the file has PTRACE_BLOCK_TYPE_CLOCK_SYNC blocks, which take precedence.
+    uint64_t                    StartTime;        /// The timestamp at which the profiler was initialized, in ticks.
+    char                        AppName[64];      /// The zero-terminated, possibly truncated application name.
+    uint32_t                    TaskSampleRate;   /// Added in minor version 2. Events were recorded for 1 in TaskSampleRate tasks; see TaskSampled. Treat as 1 if HeaderSize doesn't include it.
+    uint32_t                    Reserved;         /// Reserved for future use. Set to 0.
+};
+
+/// @summary Define the data at the start of every block. A block never spans more than one thread.
+struct PTRACE_BLOCK_HEADER
+{
+    uint32_t                    Magic;            /// PTRACE_BLOCK_MAGIC.
+    uint32_t                    BlockType;        /// One of PTRACE_BLOCK_TYPE.
+    uint32_t                    ThreadId;         /// The operating system identifier of the thread that produced the data.
+    uint32_t                    EventCount;       /// The number of items in the block. The meaning depends on BlockType.
+    uint32_t                    DataSize;         /// The number of bytes of data following the block header.
+    uint32_t                    DroppedCount;     /// The number of events the thread dropped since its previous block because its buffer was full.
+    uint64_t                    FirstTime;        /// The timestamp of the first item in the block, in ticks. Event timestamps are delta-encoded from this value.
+    uint64_t                    LastTime;         /// The timestamp of the last item in the block, in ticks.
+};
+
+/// @summary Define the data stored for each worker thread registration in a PTRACE_BLOCK_TYPE_WORKER block.
+struct PTRACE_WORKER_INFO
+{
+    uint64_t                    Timestamp;        /// The timestamp at which the worker thread was registered, in ticks.
+    uint32_t                    ThreadId;         /// The operating system identifier of the worker thread.
+    uint32_t                    PoolId;           /// The application identifier of the thread pool.
+    uint32_t                    PoolIndex;        /// The zero-based index of the worker thread within the pool.
+    uint32_t                    Reserved;         /// Reserved for future use. Set to 0.
+};
+
+/// @summary Define the data stored in a PTRACE_BLOCK_TYPE_TASK_SOURCE block. NameLength bytes of name, not zero-terminated, follow.
+struct PTRACE_SOURCE_INFO
+{
+    uint64_t                    Timestamp;        /// The timestamp at which the task source was registered, in ticks.
+    uint32_t                    ThreadId;         /// The operating system identifier of the task producer thread.
+    uint32_t                    SourceIndex;      /// The zero-based index of the task source within the scheduler.
+    uint32_t                    NameLength;       /// The number of bytes in the source name.
+    uint32_t                    Reserved;         /// Reserved for future use. Set to 0.
+};
+
+/// @summary Define a calibration sample stored in a PTRACE_BLOCK_TYPE_CLOCK_SYNC block. When timestamps come from the processor
+/// cycle counter, samples are written at startup, periodically and at shutdown, and readers convert timestamps to nanoseconds by
+/// interpolating between them. This corrects for an inexact ClockFrequency over long captures.
+struct PTRACE_CLOCK_SYNC
+{
+    uint64_t                    Timestamp;        /// The timestamp counter, in ticks.
+    uint64_t                    ReferenceTime;    /// The system monotonic clock at the same instant, in nanoseconds.
+};
+
+/// @summary Define the data stored in a PTRACE_BLOCK_TYPE_ZONE_SITE block. The name, file and function strings follow in that
+/// order, none of them zero-terminated. A site is written again at the start of each profiler session, with the same SiteId.
+struct PTRACE_ZONE_SITE_INFO
+{
+    uint32_t                    SiteId;           /// The non-zero identifier written with each zone event at the site.
+    uint32_t                    Line;             /// The source line number of the site.
+    uint32_t                    NameLength;       /// The number of bytes in the zone name.
+    uint32_t                    FileLength;       /// The number of bytes in the source file path.
+    uint32_t                    FunctionLength;   /// The number of bytes in the function name.
+    uint32_t                    Reserved;         /// Reserved for future use. Set to 0.
+};
+
+/// @summary Define the running state used to delta-encode or decode the events in a single block. Reset at the start of each block.
+struct PTRACE_CODEC_STATE
+{
+    uint64_t                    PrevTime;         /// The timestamp of the previous event, in ticks.
+    uint64_t                    PrevEntry;        /// The entry point of the previous task definition.
+    uint32_t                    PrevTask;         /// The task identifier of the previous event.
+};
+
+/// @summary Define the decoded representation of a single compact event.
+struct PTRACE_EVENT
+{
+    uint64_t                    Timestamp;        /// The timestamp at which the event occurred, in ticks.
+    uint64_t                    EntryPoint;       /// PTRACE_EVENT_TYPE_DEFINE_TASK only: the entry point of the task.
+    uint32_t                    EventType;        /// One of PTRACE_EVENT_TYPE.
+    uint32_t                    TaskId;           /// The task identifier.
+    uint32_t                    ParentId;         /// PTRACE_EVENT_TYPE_DEFINE_TASK only: the parent task identifier, or INVALID_TASK_ID.
+    uint32_t                    SourceIndex;      /// PTRACE_EVENT_TYPE_DEFINE_TASK and PTRACE_EVENT_TYPE_TASK_READY_TO_RUN only: the task source index.
+    uint32_t                    DependencyCount;  /// PTRACE_EVENT_TYPE_DEFINE_TASK only: the number of dependencies.
+    uint8_t const              *DependencyData;   /// PTRACE_EVENT_TYPE_DEFINE_TASK only: the encoded dependencies. See PtraceDecodeDependencies.
+};
+
+/// @summary Define the decoded representation of a single zone event.
+struct PTRACE_ZONE_EVENT
+{
+    uint64_t                    Timestamp;        /// The timestamp at which the thread entered or left the zone, in ticks.
+    uint32_t                    SiteId;           /// The identifier of the zone site. See PTRACE_ZONE_SITE_INFO.
+    uint32_t                    IsEnd;            /// Non-zero if the thread left the zone, or zero if it entered it.
+};
+
+/// @summary Define the decoded representation of the hardware counters of a single task, recorded when the task finished. Each value is
+/// the change in the counter between the launch and the finish of the task, on the worker thread that executed it.
+struct PTRACE_TASK_COUNTERS
+{
+    uint64_t                    Timestamp;        /// The timestamp of the TaskFinish event of the task, in ticks.
+    uint32_t                    TaskId;           /// The task identifier.
+    uint32_t                    CounterMask;      /// Bit i is set if Values[i] holds the PTRACE_COUNTER with value i.
+    uint64_t                    Values[PTRACE_MAX_COUNTERS]; /// The counter deltas, indexed by PTRACE_COUNTER. Entries not in CounterMask are 0.
+};
+
+/// @summary Define the decoded representation of the heap allocations and frees made by a single task, recorded when the task finished. They
+/// are counted between the launch and the finish of the task on the worker thread that executed it. If the task launches another task inline,
+/// the inner task is charged with the allocations it makes and the outer task records none, as with the hardware counters.
+struct PTRACE_TASK_ALLOCS
+{
+    uint64_t                    Timestamp;        /// The timestamp of the TaskFinish event of the task, in ticks.
+    uint32_t                    TaskId;           /// The task identifier.
+    uint32_t                    Reserved;         /// Reserved for future use. Set to zero.
+    uint64_t                    AllocCount;       /// The number of calls to malloc, calloc, realloc and the aligned allocation functions.
+    uint64_t                    AllocBytes;       /// The total number of bytes requested by those calls.
+    uint64_t                    FreeBytes;        /// The total usable size of the blocks released by free, realloc and the delete operators. Zero in PTRACE_BLOCK_TYPE_TASK_ALLOCS blocks.
+};
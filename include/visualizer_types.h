@@ -6,6 +6,101 @@
 /*//////////////////
 //   Data Types   //
 //////////////////*/
+#if !defined(_WIN32)
+/// @summary Define the subset of Windows types used by the portable portions of the loader and analysis code.
+typedef wchar_t                         WCHAR;              /// A UTF-16 (Windows) or UTF-32 (elsewhere) character.
+typedef uint64_t                        TRACEHANDLE;        /// An ETW trace session handle. Unused outside of Windows.
+typedef void                           *HANDLE;             /// An operating system object handle. Unused outside of Windows.
+typedef union _LARGE_INTEGER {
+    struct {
+        uint32_t                        LowPart;            /// The low 32 bits of the value.
+        int32_t                         HighPart;           /// The high 32 bits of the value.
+    };
+    int64_t                             QuadPart;           /// The 64-bit value.
+} LARGE_INTEGER;
+#endif
+
+/// @summary Define a column of trivially copyable values. A column either owns its values, or is a view of values stored
+/// elsewhere, such as a mapped analysis cache file that outlives the column. Elements of a view may be modified in place, so
+/// the memory it refers to must be writable, or a copy-on-write mapping. Any change to the length of a view first copies its
+/// values into storage owned by the column, and copying a column always produces an owning column. Member functions follow
+/// std::vector, so that code filling and searching columns is independent of where the values are stored.
+template <typename T>
+struct WIN32_COLUMN
+{
+    typedef T                          *iterator;           /// Columns are contiguous, so iterators are pointers.
+    typedef T const                    *const_iterator;     /// Columns are contiguous, so iterators are pointers.
+
+    T                                  *Data;               /// The first element, or NULL if the column is empty.
+    size_t                              Count;              /// The number of elements.
+    std::vector<T>                      Storage;            /// The owned elements. Empty while the column is a view.
+
+    WIN32_COLUMN(void) : Data(NULL), Count(0) {}
+    WIN32_COLUMN(WIN32_COLUMN const &other) : Data(NULL), Count(0), Storage(other.Data, other.Data + other.Count) { Sync(); }
+    WIN32_COLUMN(WIN32_COLUMN &&other) noexcept : Data(other.Data), Count(other.Count), Storage(std::move(other.Storage)) { other.Data = NULL; other.Count = 0; }
+    WIN32_COLUMN& operator = (WIN32_COLUMN const &other) { if (this != &other) assign(other.begin(), other.end()); return *this; }
+    WIN32_COLUMN& operator = (WIN32_COLUMN &&other) noexcept { swap(other); return *this; }
+    WIN32_COLUMN& operator = (std::initializer_list<T> values) { assign(values.begin(), values.end()); return *this; }
+    bool          operator ==(WIN32_COLUMN const &other) const { return Count == other.Count && std::equal(begin(), end(), other.begin()); }
+
+    size_t          size (void) const   { return Count; }
+    bool            empty(void) const   { return Count == 0; }
+    T*              data (void)         { return Data; }
+    T const*        data (void) const   { return Data; }
+    iterator        begin(void)         { return Data; }
+    const_iterator  begin(void) const   { return Data; }
+    iterator        end  (void)         { return Data + Count; }
+    const_iterator  end  (void) const   { return Data + Count; }
+    T&              front(void)         { return Data[0]; }
+    T const&        front(void) const   { return Data[0]; }
+    T&              back (void)         { return Data[Count - 1]; }
+    T const&        back (void) const   { return Data[Count - 1]; }
+    T&              operator [] (size_t i)       { return Data[i]; }
+    T const&        operator [] (size_t i) const { return Data[i]; }
+
+    /// @summary Copy the values of a view into storage owned by the column. Owning columns are unchanged.
+    void Own(void)
+    {
+        if (Count != Storage.size()) Storage.assign(Data, Data + Count);
+    }
+
+    /// @summary Point Data and Count at the owned storage after it has been modified.
+    void Sync(void)
+    {
+        Data  = Storage.empty() ? NULL : &Storage[0];
+        Count = Storage.size();
+    }
+
+    /// @summary Release any owned storage and make the column a view of existing values.
+    /// @param data The first value. The memory must remain valid, and writable, for the lifetime of the column.
+    /// @param count The number of values.
+    void View(T *data, size_t count)
+    {
+        std::vector<T>().swap(Storage);
+        Data  = count != 0 ? data : NULL;
+        Count = count;
+    }
+
+    void clear    (void)                                { Storage.clear(); Sync(); }
+    void reserve  (size_t n)                            { Own(); Storage.reserve(n); Sync(); }
+    void resize   (size_t n)                            { Own(); Storage.resize(n); Sync(); }
+    void resize   (size_t n, T const &value)            { Own(); Storage.resize(n, value); Sync(); }
+    void push_back(T const &value)                      { Own(); Storage.push_back(value); Sync(); }
+    void assign   (size_t n, T const &value)            { Storage.assign(n, value); Sync(); }
+    void assign   (T const *first, T const *last)       { Storage.assign(first, last); Sync(); }
+    void insert   (T const *pos, T const *first, T const *last)
+    {
+        size_t const at = size_t(pos - Data);
+        Own(); Storage.insert(Storage.begin() + at, first, last); Sync();
+    }
+    void swap     (WIN32_COLUMN &other)
+    {
+        std::swap(Data , other.Data);
+        std::swap(Count, other.Count);
+        Storage.swap(other.Storage);
+    }
+};
+
 /// @summary Define the representation of a task handle within the scheduler.
 typedef uint32_t task_id_t;                                 /// Tasks are referred to by a 32-bit handle value.
 
@@ -14,7 +109,7 @@ typedef uint32_t task_id_t;                                 /// Tasks are referr
 struct WIN32_SWITCH_IN_DATA
 {
     uint32_t                            WaitTime;           /// The amount of time the thread spent waiting, in milliseconds.
-    int8_t                              Processor;          /// The zero-based index of the processor the thread is running on.
+    uint16_t                            Processor;          /// The zero-based index of the logical processor the thread is running on.
     int8_t                              Priority;           /// The scheduler priority of the thread when it was switched in.
 };
 
@@ -22,7 +117,7 @@ struct WIN32_SWITCH_IN_DATA
 /// See https://msdn.microsoft.com/en-us/library/windows/desktop/aa964744%28v=vs.85%29.aspx
 struct WIN32_SWITCH_OUT_DATA
 {
-    int8_t                              Processor;          /// The zero-based index of the processor the thread was running on?
+    uint16_t                            Processor;          /// The zero-based index of the logical processor the thread was running on.
     int8_t                              State;              /// The thread state when it was switched out.
     int8_t                              WaitReason;         /// The reason the thread is being placed into a wait state.
     int8_t                              WaitMode;           /// Whether the thread is being placed into a user-mode or kernel-mode wait state.
@@ -36,10 +131,90 @@ struct WIN32_LIFETIME
     uint64_t                            DestroyTime;        /// The timestamp value (in nanoseconds) at which the process or thread was destroyed, or the image was unloaded.
 };
 
+/// @summary Defines an open-addressing hash index over an object list (processes, threads or images).
+/// Each slot holds a key and the most recently inserted object with that key. Objects with the same key,
+/// such as threads whose identifier was reused, are chained from newest to oldest through ChainNext.
+struct WIN32_OBJECT_INDEX
+{
+    size_t                              SlotCount;          /// The number of slots in the table. Always zero or a power of two.
+    size_t                              KeyCount;           /// The number of occupied slots (distinct keys).
+    WIN32_COLUMN<uint64_t>              SlotKey;            /// The key stored in each slot.
+    WIN32_COLUMN<uint32_t>              SlotHead;           /// The index of the newest object with the slot key, or WIN32_OBJECT_INDEX_EMPTY.
+    WIN32_COLUMN<uint32_t>              ChainNext;          /// For each object, the index of the next-older object with the same key, or WIN32_OBJECT_INDEX_EMPTY.
+};
+
+/// @summary Define a chunked memory arena. Allocations are never freed individually; the whole arena is released in O(chunks).
+struct WIN32_MEMORY_ARENA
+{
+    std::vector<uint8_t*>               Chunks;             /// The base address of each chunk, in allocation order.
+    uint8_t                            *NextByte;           /// The next unused byte in the current chunk, or NULL.
+    uint8_t                            *LastByte;           /// One past the last byte of the current chunk, or NULL.
+    size_t                              ChunkSize;          /// The size of a regular chunk, in bytes. Zero selects WIN32_MEMORY_ARENA_CHUNK_SIZE.
+    size_t                              BytesUsed;          /// The total number of bytes handed out, including alignment padding.
+    size_t                              BytesReserved;      /// The total size of all chunks, in bytes.
+};
+
+/// @summary Define the identifier of an interned string. Identical strings have the same identifier.
+typedef uint32_t string_id_t;
+
+/// @summary Define the string identifier used for a missing or NULL string.
+#ifndef WIN32_STRING_ID_NONE
+#define WIN32_STRING_ID_NONE            0
+#endif
+
+/// @summary Define a table of interned wide strings. String data is stored in a WIN32_MEMORY_ARENA, or in the mapped analysis cache the table was loaded from, and never moves.
+struct WIN32_STRING_TABLE
+{
+    size_t                              SlotCount;          /// The number of hash table slots. Always zero or a power of two.
+    size_t                              StringCount;        /// The number of strings, including the reserved WIN32_STRING_ID_NONE entry once any string is interned.
+    WIN32_COLUMN<uint64_t>              SlotHash;           /// The full 64-bit hash of the string stored in each slot.
+    WIN32_COLUMN<string_id_t>           SlotId;             /// The identifier of the string stored in each slot, or WIN32_STRING_ID_NONE if the slot is empty.
+    std::vector<WCHAR const*>           String;             /// The zero-terminated contents of each string, indexed by identifier.
+    WIN32_COLUMN<uint32_t>              Length;             /// The length of each string in characters, not including the terminator.
+    WIN32_COLUMN<uint64_t>              Hash;               /// The 64-bit hash of each string.
+};
+
 /// @summary Defines the 
 struct WIN32_IMAGE_INFO
 {
-    WCHAR                              *ImagePath;          /// A zero-terminated string specifying the path of the image file.
+    WCHAR const                        *ImagePath;          /// A zero-terminated string specifying the path of the image file, interned in WIN32_PROFILER_EVENTS::Strings, or NULL.
+};
+
+/// @summary Define the scheduling states of a thread recorded in a WIN32_THREAD_INTERVALS.
+enum WIN32_THREAD_STATE : uint8_t
+{
+    WIN32_THREAD_STATE_RUNNING          = 0,                /// The thread was executing on a processor.
+    WIN32_THREAD_STATE_READY            = 1,                /// The thread was runnable but waiting for a processor, after being readied or preempted.
+    WIN32_THREAD_STATE_WAITING          = 2,                /// The thread was blocked, for the reason in WaitReason.
+};
+
+/// @summary Define the WaitReason of a running interval, or of a ready interval in which the thread was preempted rather than woken.
+#ifndef WIN32_WAIT_REASON_NONE
+#define WIN32_WAIT_REASON_NONE          (-1)
+#endif
+
+/// @summary Define the WaitReason of a ready interval that woke a thread whose earlier state is not in the trace.
+#ifndef WIN32_WAIT_REASON_UNKNOWN
+#define WIN32_WAIT_REASON_UNKNOWN       (-2)
+#endif
+
+/// @summary Define the number of intervals between entries of WIN32_THREAD_INTERVALS::IndexStart. Must be a power of two.
+#ifndef WIN32_THREAD_INTERVAL_INDEX_STRIDE
+#define WIN32_THREAD_INTERVAL_INDEX_STRIDE 64
+#endif
+
+/// @summary Define the scheduling history of one thread as contiguous, non-overlapping intervals in ascending time order, built from
+/// the ready and switch columns of WIN32_THREAD_INFO. No interval covers the time before the first scheduling event of the thread.
+/// Adjacent intervals have different states unless an interval longer than 0xFFFFFFFF nanoseconds was split to fit Duration.
+struct WIN32_THREAD_INTERVALS
+{
+    size_t                              IntervalCount;      /// The number of intervals.
+    WIN32_COLUMN<uint64_t>              Start;              /// The start time of each interval, in nanoseconds.
+    WIN32_COLUMN<uint32_t>              Duration;           /// The duration of each interval, in nanoseconds.
+    WIN32_COLUMN<uint8_t>               State;              /// One of WIN32_THREAD_STATE for each interval.
+    WIN32_COLUMN<int8_t>                WaitReason;         /// The WIN32_SWITCH_OUT_DATA::WaitReason of each waiting interval and of the wait ended by each ready interval that woke the thread, or WIN32_WAIT_REASON_NONE.
+    WIN32_COLUMN<int8_t>                WaitMode;           /// The WIN32_SWITCH_OUT_DATA::WaitMode of each waiting interval, or zero.
+    WIN32_COLUMN<uint64_t>              IndexStart;         /// The Start of every WIN32_THREAD_INTERVAL_INDEX_STRIDE-th interval, searched first by FindThreadInterval.
 };
 
 /// @summary Defines the data associated with each thread that existed at some point during a process lifetime.
@@ -47,15 +222,16 @@ struct WIN32_THREAD_INFO
 {
     uint32_t                            ThreadId;           /// The operating system thread identifier.
     uint64_t                            EntryAddress;       /// The address of the thread entry point relative to the image base address.
-    WCHAR                              *EntryPointName;     /// A zero-terminated string corresponding to the entry point symbol.
+    WCHAR const                        *EntryPointName;     /// A zero-terminated string corresponding to the entry point symbol, interned in WIN32_PROFILER_EVENTS::Strings, or NULL.
     size_t                              ReadyCount;         /// The number of times the thread was readied by the scheduler.
-    std::vector<uint64_t>               ReadyTimes;         /// The timestamp (in nanoseconds) at which the thread was readied by the scheduler.
+    WIN32_COLUMN<uint64_t>              ReadyTimes;         /// The timestamp (in nanoseconds) at which the thread was readied by the scheduler.
     size_t                              SwitchInCount;      /// The number of times the thread was switched in.
-    std::vector<uint64_t>               SwitchInTime;       /// The timestamp (in nanoseconds) at which the thread was switched in by the scheduler.
-    std::vector<WIN32_SWITCH_IN_DATA>   SwitchInData;       /// Additional information associated with the thread activation.
+    WIN32_COLUMN<uint64_t>              SwitchInTime;       /// The timestamp (in nanoseconds) at which the thread was switched in by the scheduler.
+    WIN32_COLUMN<WIN32_SWITCH_IN_DATA>  SwitchInData;       /// Additional information associated with the thread activation.
     size_t                              SwitchOutCount;     /// The number of times the thread was switched out.
-    std::vector<uint64_t>               SwitchOutTime;      /// The timestamp (in nanoseconds) at which the thread was switched out by the scheduler.
-    std::vector<WIN32_SWITCH_OUT_DATA>  SwitchOutData;      /// Additional information associated with the thread deactivation.
+    WIN32_COLUMN<uint64_t>              SwitchOutTime;      /// The timestamp (in nanoseconds) at which the thread was switched out by the scheduler.
+    WIN32_COLUMN<WIN32_SWITCH_OUT_DATA> SwitchOutData;      /// Additional information associated with the thread deactivation.
+    WIN32_THREAD_INTERVALS              Intervals;          /// The ready, switch-in and switch-out columns merged into intervals, built once loading is complete.
 };
 
 /// @summary Defines the data associated with each process that existed at some point during the trace capture.
@@ -63,26 +239,30 @@ struct WIN32_PROCESS_INFO
 {
     uint32_t                            ProcessId;          /// The operating system process identifier.
     uint32_t                            Reserved;           /// Reserved for future use. Set to 0.
-    WCHAR                              *Executable;         /// The path of the process executable image.
+    WCHAR const                        *Executable;         /// The path of the process executable image, interned in WIN32_PROFILER_EVENTS::Strings, or NULL.
     size_t                              ThreadCount;        /// The number of threads created during the process lifetime.
-    std::vector<uint32_t>               ThreadId;           /// The operating system identifier for each thread that existed at some point during the process lifetime.
-    std::vector<WIN32_LIFETIME>         ThreadLifetime;     /// The creation and destruction time for each thread that existed at some point during the process lifetime.
+    WIN32_COLUMN<uint32_t>              ThreadId;           /// The operating system identifier for each thread that existed at some point during the process lifetime.
+    WIN32_COLUMN<WIN32_LIFETIME>        ThreadLifetime;     /// The creation and destruction time for each thread that existed at some point during the process lifetime.
     std::vector<WIN32_THREAD_INFO>      ThreadInfo;         /// Additional information about each thread that existed at some point during the process lifetime.
+    WIN32_OBJECT_INDEX                  ThreadIndex;        /// The index used to locate threads by ThreadId.
     size_t                              ImageCount;         /// The number of executable images loaded into the process address space.
-    std::vector<uint64_t>               ImageBaseAddress;   /// The base load address for each image that existed at some point during the process lifetime.
-    std::vector<uint32_t>               ImagePathHash;      /// The 32-bit hash of the file path for each image that existed at some point during the process lifetime.
-    std::vector<WIN32_LIFETIME>         ImageLifetime;      /// The load and unload time for each image that existed at some point during the process lifetime.
+    WIN32_COLUMN<uint64_t>              ImageBaseAddress;   /// The base load address for each image that existed at some point during the process lifetime.
+    WIN32_COLUMN<string_id_t>           ImagePathId;        /// The interned file path for each image that existed at some point during the process lifetime.
+    WIN32_COLUMN<WIN32_LIFETIME>        ImageLifetime;      /// The load and unload time for each image that existed at some point during the process lifetime.
     std::vector<WIN32_IMAGE_INFO>       ImageInfo;          /// Additional information about each image that existed at some point during the process lifetime.
+    WIN32_OBJECT_INDEX                  ImageAddressIndex;  /// The index used to locate images by ImageBaseAddress.
+    WIN32_OBJECT_INDEX                  ImagePathIndex;     /// The index used to locate images by ImagePathId.
 };
 
 /// @summary Defines the data associated with the list of processes that have produced events in the trace.
 struct WIN32_PROCESS_LIST
 {
     size_t                              ProcessCount;       /// The number of processes defined in the process list.
-    std::vector<uint32_t>               ProcessId;          /// The operating system identifier for each process in the list.
-    std::vector<uint32_t>               ProcessHash;        /// The 32-bit hash value of the image path for each process.
-    std::vector<WIN32_LIFETIME>         ProcessLifetime;    /// The creation and destruction time for each process in the list.
+    WIN32_COLUMN<uint32_t>              ProcessId;          /// The operating system identifier for each process in the list.
+    WIN32_COLUMN<string_id_t>           ProcessNameId;      /// The interned executable image path for each process, or WIN32_STRING_ID_NONE.
+    WIN32_COLUMN<WIN32_LIFETIME>        ProcessLifetime;    /// The creation and destruction time for each process in the list.
     std::vector<WIN32_PROCESS_INFO>     ProcessInfo;        /// Additional information about each process in the list.
+    WIN32_OBJECT_INDEX                  ProcessIndex;       /// The index used to locate processes by ProcessId.
 };
 
 /// @summary Define the data used to locate a task definition at a specific time.
@@ -92,6 +272,584 @@ struct WIN32_TASK_AND_TIME
     task_id_t                           TaskId;             /// The task identifier.
 };
 
+/// @summary Define the types of task profiler events stored in a WIN32_TASK_EVENT_LIST. Values match PTRACE_EVENT_TYPE.
+enum WIN32_TASK_EVENT_TYPE : uint8_t
+{
+    WIN32_TASK_EVENT_DEFINE_TASK        = 0,                /// A task was defined.
+    WIN32_TASK_EVENT_READY_TO_RUN       = 1,                /// A task became ready-to-run.
+    WIN32_TASK_EVENT_LAUNCH             = 2,                /// A worker thread started executing a task.
+    WIN32_TASK_EVENT_FINISH             = 3,                /// A worker thread finished executing a task.
+};
+
+/// @summary Define the time-ordered log of task profiler events from all threads. Events with equal timestamps keep their per-thread order.
+struct WIN32_TASK_EVENT_LIST
+{
+    size_t                              EventCount;         /// The number of events in the list.
+    WIN32_COLUMN<uint64_t>              EventTime;          /// The timestamp (in nanoseconds) at which each event occurred, in ascending order.
+    WIN32_COLUMN<uint8_t>               EventType;          /// One of WIN32_TASK_EVENT_TYPE for each event.
+    WIN32_COLUMN<task_id_t>             TaskId;             /// The identifier of the task associated with each event.
+    WIN32_COLUMN<uint32_t>              ThreadId;           /// The operating system identifier of the thread that produced each event.
+    WIN32_COLUMN<uint32_t>              SourceIndex;        /// The task source index for definition and ready-to-run events, or 0.
+    WIN32_COLUMN<task_id_t>             ParentId;           /// The parent task identifier for definition events, or INVALID_TASK_ID.
+    WIN32_COLUMN<uint64_t>              EntryPoint;         /// The task entry point address for definition events, or 0.
+    WIN32_COLUMN<uint32_t>              DependencyStart;    /// EventCount+1 offsets into Dependencies. The dependencies of event i are [DependencyStart[i], DependencyStart[i+1]).
+    WIN32_COLUMN<task_id_t>             Dependencies;       /// The dependency task identifiers of all definition events.
+};
+
+/// @summary Define the columnar table of tasks observed in the trace, with one row per task definition.
+/// Timestamps are in nanoseconds, with 0 indicating that the transition was not observed. The Sorted columns
+/// list the time and row of every observed transition of one kind in ascending time order, and can be passed
+/// directly to FindEventsInTimeRange.
+struct WIN32_TASK_TABLE
+{
+    size_t                              TaskCount;          /// The number of rows in the table.
+    WIN32_COLUMN<task_id_t>             TaskId;             /// The task identifier of each row.
+    WIN32_COLUMN<task_id_t>             ParentId;           /// The parent task identifier of each row, or INVALID_TASK_ID.
+    WIN32_COLUMN<uint64_t>              EntryPoint;         /// The address of the task entry point of each row.
+    WIN32_COLUMN<uint32_t>              SourceIndex;        /// The index of the task source that defined each task.
+    WIN32_COLUMN<uint32_t>              WorkerThreadId;     /// The operating system identifier of the thread that executed each task, or 0.
+    WIN32_COLUMN<uint64_t>              DefineTime;         /// The time at which each task was defined.
+    WIN32_COLUMN<uint64_t>              ReadyTime;          /// The time at which each task became ready-to-run.
+    WIN32_COLUMN<uint64_t>              LaunchTime;         /// The time at which each task started executing.
+    WIN32_COLUMN<uint64_t>              FinishTime;         /// The time at which each task finished executing.
+    WIN32_COLUMN<uint64_t>              AllocCount;         /// The number of heap allocations made by each task, or 0 if none were recorded.
+    WIN32_COLUMN<uint64_t>              AllocBytes;         /// The number of bytes requested by the heap allocations of each task.
+    WIN32_COLUMN<uint64_t>              FreeBytes;          /// The usable size, in bytes, of the heap blocks freed by each task.
+    WIN32_COLUMN<uint64_t>              DefineSortedTime;   /// The time of each task definition, in ascending order.
+    WIN32_COLUMN<uint32_t>              DefineSortedRow;    /// The row corresponding to each entry of DefineSortedTime.
+    WIN32_COLUMN<uint64_t>              ReadySortedTime;    /// The time of each ready-to-run transition, in ascending order.
+    WIN32_COLUMN<uint32_t>              ReadySortedRow;     /// The row corresponding to each entry of ReadySortedTime.
+    WIN32_COLUMN<uint64_t>              LaunchSortedTime;   /// The time of each task launch, in ascending order.
+    WIN32_COLUMN<uint32_t>              LaunchSortedRow;    /// The row corresponding to each entry of LaunchSortedTime.
+    WIN32_COLUMN<uint64_t>              FinishSortedTime;   /// The time of each task finish, in ascending order.
+    WIN32_COLUMN<uint32_t>              FinishSortedRow;    /// The row corresponding to each entry of FinishSortedTime.
+    WIN32_OBJECT_INDEX                  TaskIndex;          /// The index used to locate rows by TaskId. Reused identifiers are chained newest first.
+    WIN32_COLUMN<uint32_t>              DependencyStart;    /// TaskCount+1 offsets into DependencyRow, built by BuildTaskDependencyGraph. The predecessors of row i are [DependencyStart[i], DependencyStart[i+1]).
+    WIN32_COLUMN<uint32_t>              DependencyRow;      /// The row of each predecessor, grouped by dependent row.
+    WIN32_COLUMN<uint32_t>              SuccessorStart;     /// TaskCount+1 offsets into SuccessorRow. The successors of row i are [SuccessorStart[i], SuccessorStart[i+1]).
+    WIN32_COLUMN<uint32_t>              SuccessorRow;       /// The row of each successor, grouped by predecessor row in ascending order.
+    WIN32_COLUMN<uint32_t>              ParentRow;          /// The row of the parent task of each row, built by BuildTaskDependencyGraph, or WIN32_OBJECT_INDEX_EMPTY.
+    size_t                              UnresolvedCount;    /// The number of dependencies on tasks that were never observed, which have no edge.
+};
+
+/// @summary Define the task scheduler configuration reported by the profiled application.
+struct WIN32_SCHEDULER_INFO
+{
+    uint32_t                            ComputePoolSize;    /// The maximum number of worker threads in the compute thread pool.
+    uint32_t                            GeneralPoolSize;    /// The maximum number of worker threads in the general thread pool.
+    size_t                              WorkerCount;        /// The number of registered worker threads.
+    WIN32_COLUMN<uint32_t>              WorkerThreadId;     /// The operating system identifier of each worker thread.
+    WIN32_COLUMN<uint32_t>              WorkerPoolId;       /// The application identifier of the thread pool of each worker thread.
+    WIN32_COLUMN<uint32_t>              WorkerPoolIndex;    /// The zero-based index of each worker thread within its pool.
+    size_t                              SourceCount;        /// The number of registered task sources.
+    WIN32_COLUMN<uint32_t>              SourceIndex;        /// The zero-based index of each task source within the scheduler.
+    WIN32_COLUMN<uint32_t>              SourceThreadId;     /// The operating system identifier of the thread that owns each task source.
+    std::vector<std::string>            SourceName;         /// The name of each task source.
+};
+
+/// @summary Define the key used to locate the decoder plan for an event schema. Keys are compared bytewise, so unused bytes must be zero.
+struct WIN32_EVENT_SCHEMA_KEY
+{
+    uint8_t                             ProviderId[16];     /// The GUID of the provider, or of the event class for MOF events.
+    uint16_t                            EventId;            /// The event identifier from the event descriptor.
+    uint8_t                             Opcode;             /// The opcode from the event descriptor.
+    uint8_t                             Version;            /// The schema version from the event descriptor.
+    uint8_t                             PointerSize;        /// The size of pointer values on the producer, in bytes.
+    uint8_t                             Reserved[3];        /// Reserved for future use. Set to 0.
+};
+
+/// @summary Define the maximum number of top-level properties whose offsets are recorded by a decoder plan.
+#ifndef WIN32_EVENT_DECODER_MAX_FIELDS
+#define WIN32_EVENT_DECODER_MAX_FIELDS  32
+#endif
+
+/// @summary Define the precomputed layout of an event schema. Fields before FixedCount are at fixed offsets from the start of the user data.
+struct WIN32_EVENT_DECODER_PLAN
+{
+    uint32_t                            FieldCount;         /// The number of top-level properties in the schema.
+    uint32_t                            FixedCount;         /// The number of leading properties whose offset and size do not depend on the payload.
+    uint32_t                            PayloadSize;        /// The number of bytes of user data spanned by the fixed properties.
+    uint32_t                            EventInfoSize;      /// The size of the cached schema metadata, in bytes.
+    uint8_t                            *EventInfo;          /// A copy of the TRACE_EVENT_INFO for the schema, used for properties without a fixed offset. May be NULL.
+    uint16_t                            FieldOffset[WIN32_EVENT_DECODER_MAX_FIELDS]; /// The byte offset of each fixed property.
+    uint8_t                             FieldSize  [WIN32_EVENT_DECODER_MAX_FIELDS]; /// The size of each fixed property, in bytes.
+};
+
+/// @summary Define a cache of decoder plans, built on the first sighting of each event schema and looked up by hash for every later event.
+struct WIN32_EVENT_DECODER_CACHE
+{
+    size_t                              SlotCount;          /// The number of hash table slots. Always zero or a power of two.
+    size_t                              PlanCount;          /// The number of plans in the cache.
+    std::vector<WIN32_EVENT_SCHEMA_KEY> SlotKey;            /// The schema key stored in each slot.
+    std::vector<uint32_t>               SlotPlan;           /// The index of the plan for each slot, or WIN32_OBJECT_INDEX_EMPTY.
+    std::vector<WIN32_EVENT_DECODER_PLAN> Plans;            /// The decoder plans, in the order they were built.
+    uint32_t                            LastPlan;           /// The slot of the most recently found plan, or WIN32_OBJECT_INDEX_EMPTY. Checked first since events of one schema arrive in runs.
+};
+
+/// @summary Define the base-2 logarithm of the number of events stored in each WIN32_TASK_EVENT_CHUNK and WIN32_SCHED_EVENT_CHUNK.
+#ifndef WIN32_SNAPSHOT_CHUNK_SHIFT
+#define WIN32_SNAPSHOT_CHUNK_SHIFT      14
+#endif
+
+/// @summary Define the number of events stored in each WIN32_TASK_EVENT_CHUNK and WIN32_SCHED_EVENT_CHUNK.
+#ifndef WIN32_SNAPSHOT_CHUNK_SIZE
+#define WIN32_SNAPSHOT_CHUNK_SIZE       (1U << WIN32_SNAPSHOT_CHUNK_SHIFT)
+#endif
+
+/// @summary Define the maximum number of threads that can hold a snapshot at the same time.
+#ifndef WIN32_SNAPSHOT_MAX_READERS
+#define WIN32_SNAPSHOT_MAX_READERS      4
+#endif
+
+/// @summary Define a fixed-size block of task events published to readers while a trace is loading. 
+/// A chunk never moves once allocated, and entries below a published event count are never modified.
+struct WIN32_TASK_EVENT_CHUNK
+{
+    uint64_t                            EventTime[WIN32_SNAPSHOT_CHUNK_SIZE]; /// The timestamp (in nanoseconds) of each event, in ascending order.
+    task_id_t                           TaskId   [WIN32_SNAPSHOT_CHUNK_SIZE]; /// The identifier of the task associated with each event.
+    uint32_t                            ThreadId [WIN32_SNAPSHOT_CHUNK_SIZE]; /// The operating system identifier of the thread that produced each event.
+    uint8_t                             EventType[WIN32_SNAPSHOT_CHUNK_SIZE]; /// One of WIN32_TASK_EVENT_TYPE for each event.
+};
+
+/// @summary Define the types of scheduling events published to readers while a trace is loading.
+enum WIN32_SCHED_EVENT_TYPE : uint8_t
+{
+    WIN32_SCHED_EVENT_READY             = 0,                /// A thread was readied. The same event appends to WIN32_THREAD_INFO::ReadyTimes.
+    WIN32_SCHED_EVENT_SWITCH_IN         = 1,                /// A thread was switched in. The same event appends to WIN32_THREAD_INFO::SwitchInTime.
+    WIN32_SCHED_EVENT_SWITCH_OUT        = 2,                /// A thread was switched out. The same event appends to WIN32_THREAD_INFO::SwitchOutTime.
+};
+
+/// @summary Define a fixed-size block of thread scheduling events published to readers while a trace is loading. Chunks follow the same
+/// rules as WIN32_TASK_EVENT_CHUNK, so the ready and switch columns of WIN32_THREAD_INFO, which may reallocate, are never read while loading.
+struct WIN32_SCHED_EVENT_CHUNK
+{
+    uint64_t                            EventTime[WIN32_SNAPSHOT_CHUNK_SIZE]; /// The timestamp (in nanoseconds) of each event, in ascending order.
+    uint32_t                            ProcessId[WIN32_SNAPSHOT_CHUNK_SIZE]; /// The operating system identifier of the process owning the thread.
+    uint32_t                            ThreadId [WIN32_SNAPSHOT_CHUNK_SIZE]; /// The operating system identifier of the thread that was readied or switched.
+    uint16_t                            Processor[WIN32_SNAPSHOT_CHUNK_SIZE]; /// The zero-based index of the logical processor that logged each event.
+    uint8_t                             EventType[WIN32_SNAPSHOT_CHUNK_SIZE]; /// One of WIN32_SCHED_EVENT_TYPE for each event.
+};
+
+/// @summary Define an immutable view of the prefix of a trace that has been loaded so far. Snapshots are published
+/// by the loading thread and read without locks; see AcquireProfilerSnapshot and ReleaseProfilerSnapshot.
+struct WIN32_PROFILER_SNAPSHOT
+{
+    uint64_t                            Epoch;              /// The version number of the snapshot. Each published snapshot has a larger epoch than the previous one.
+    size_t                              EventCount;         /// The number of task events visible through Chunks.
+    size_t                              ChunkCount;         /// The number of entries in the Chunks array.
+    WIN32_TASK_EVENT_CHUNK            **Chunks;             /// The chunks holding the first EventCount task events, in time order.
+    size_t                              SchedEventCount;    /// The number of scheduling events visible through SchedChunks.
+    size_t                              SchedChunkCount;    /// The number of entries in the SchedChunks array.
+    WIN32_SCHED_EVENT_CHUNK           **SchedChunks;        /// The chunks holding the first SchedEventCount scheduling events, in time order.
+    uint64_t                            FirstTime;          /// The timestamp of the first task or scheduling event, in nanoseconds, or 0.
+    uint64_t                            LastTime;           /// The timestamp of the last task or scheduling event, in nanoseconds, or 0.
+    size_t                              ProcessCount;       /// The number of processes observed so far.
+    size_t                              ThreadCount;        /// The number of threads observed so far.
+    size_t                              TaskCount;          /// The number of task table rows created so far.
+    float                               Progress;           /// The estimated fraction of the trace that has been loaded, in [0, 1].
+    bool                                Complete;           /// true once loading has finished. The columns of WIN32_PROFILER_EVENTS are then immutable and may be read directly.
+};
+
+/// @summary Define the state used by the loading thread to publish snapshots, and by readers to acquire them.
+struct WIN32_SNAPSHOT_PUBLISHER
+{
+    std::atomic<WIN32_PROFILER_SNAPSHOT*> Current;          /// The most recently published snapshot, or NULL.
+    std::atomic<WIN32_PROFILER_SNAPSHOT*> Hazard[WIN32_SNAPSHOT_MAX_READERS]; /// The snapshot held by each reader slot, or NULL.
+    std::vector<WIN32_PROFILER_SNAPSHOT*> Retired;          /// Snapshots replaced by a newer one that may still be held by a reader.
+    std::vector<WIN32_TASK_EVENT_CHUNK*>  Chunks;           /// All chunks allocated by the loading thread, in time order.
+    size_t                              EventCount;         /// The number of task events appended by the loading thread.
+    std::vector<WIN32_SCHED_EVENT_CHUNK*> SchedChunks;      /// All scheduling event chunks allocated by the loading thread, in time order.
+    size_t                              SchedEventCount;    /// The number of scheduling events appended by the loading thread.
+    uint64_t                            NextEpoch;          /// The epoch to assign to the next published snapshot.
+    uint64_t                            LastPublishTime;    /// The time at which the last snapshot was published, in caller-defined units.
+    uint64_t                            PublishInterval;    /// The minimum time between periodic snapshots, in the same units as LastPublishTime.
+    uint32_t                            PollCounter;        /// The number of trace events processed since the publish interval was last checked. Maintained by the loading thread.
+};
+
+/// @summary Define the label stored in a WIN32_LOD_PYRAMID bucket in which no labeled span was busy.
+#ifndef WIN32_LOD_NO_LABEL
+#define WIN32_LOD_NO_LABEL              0xFFFFFFFFUL
+#endif
+
+/// @summary Define a multi-resolution summary of the busy spans of one timeline row. Level l buckets are 2^(BaseShift+l)
+/// nanoseconds wide, and bucket g of any level starts at BaseTime + (g << (BaseShift+l)). Each level stores only the
+/// buckets between the first and last span of the row. Fractions are fixed-point, with 65535 meaning the whole bucket.
+struct WIN32_LOD_PYRAMID
+{
+    uint64_t                            BaseTime;           /// The start time of bucket 0 at every level, in nanoseconds.
+    uint32_t                            BaseShift;          /// The base-2 logarithm of the level 0 bucket width, in nanoseconds.
+    uint32_t                            LevelCount;         /// The number of levels. The last level holds a single bucket. Zero if the row has no spans.
+    WIN32_COLUMN<uint64_t>              LevelFirst;         /// The index of the first stored bucket of each level.
+    WIN32_COLUMN<size_t>                LevelStart;         /// LevelCount+1 offsets into the bucket columns. The buckets of level l are [LevelStart[l], LevelStart[l+1]).
+    WIN32_COLUMN<uint16_t>              BusyFraction;       /// The fraction of each bucket during which the row was busy.
+    WIN32_COLUMN<uint16_t>              DominantFraction;   /// The fraction of each bucket during which DominantLabel was busy.
+    WIN32_COLUMN<uint32_t>              DominantLabel;      /// The label busy for longest within each bucket, or WIN32_LOD_NO_LABEL.
+};
+
+/// @summary Define a multi-resolution summary of a step function, such as a queue depth. Buckets are laid out as in a WIN32_LOD_PYRAMID,
+/// and each level stores only the buckets between the first step and the end of the function.
+struct WIN32_STEP_PYRAMID
+{
+    uint64_t                            BaseTime;           /// The start time of bucket 0 at every level, in nanoseconds.
+    uint32_t                            BaseShift;          /// The base-2 logarithm of the level 0 bucket width, in nanoseconds.
+    uint32_t                            LevelCount;         /// The number of levels. The last level holds a single bucket. Zero if the function has no steps.
+    WIN32_COLUMN<uint64_t>              LevelFirst;         /// The index of the first stored bucket of each level.
+    WIN32_COLUMN<size_t>                LevelStart;         /// LevelCount+1 offsets into the bucket columns. The buckets of level l are [LevelStart[l], LevelStart[l+1]).
+    WIN32_COLUMN<uint32_t>              MaxValue;           /// The largest value taken by the function within each bucket.
+    WIN32_COLUMN<float>                 MeanValue;          /// The time-weighted mean value of the function over each bucket.
+};
+
+/// @summary Define the level-of-detail summaries for every timeline row of a loaded trace. All pyramids share BaseTime and BaseShift.
+struct WIN32_TIMELINE_LOD
+{
+    uint64_t                            FirstTime;          /// The start of the earliest span of any row, in nanoseconds. Used as the BaseTime of every pyramid.
+    uint64_t                            LastTime;           /// The end of the latest span of any row, in nanoseconds.
+    uint32_t                            BaseShift;          /// The base-2 logarithm of the level 0 bucket width, in nanoseconds.
+    size_t                              ThreadCount;        /// The number of thread rows. Threads that were never switched in have no row.
+    WIN32_COLUMN<uint32_t>              ThreadProcess;      /// The index in WIN32_PROCESS_LIST::ProcessInfo of the process owning each thread row.
+    WIN32_COLUMN<uint32_t>              ThreadIndex;        /// The index in WIN32_PROCESS_INFO::ThreadInfo of each thread row.
+    std::vector<WIN32_LOD_PYRAMID>      ThreadLod;          /// The summary of the time each thread was switched in. Spans are unlabeled.
+    size_t                              WorkerCount;        /// The number of worker rows.
+    WIN32_COLUMN<uint32_t>              WorkerThreadId;     /// The operating system identifier of each worker thread that executed at least one task.
+    std::vector<WIN32_LOD_PYRAMID>      WorkerLod;          /// The summary of the tasks executed by each worker. Spans are labeled with their WIN32_TASK_TABLE row.
+};
+
+/// @summary Define the result of critical path analysis of the task dependency graph. Each task is a node whose weight is its
+/// execution time; it may start once its dependencies have finished, and once its parent has run up to the point it defined the
+/// task. Times in the ideal schedule are measured in nanoseconds from the start of the earliest task, assuming unlimited workers.
+struct WIN32_CRITICAL_PATH
+{
+    size_t                              TaskCount;          /// The number of task table rows analyzed.
+    uint64_t                            TotalWork;          /// The sum of the execution time of every task, in nanoseconds.
+    uint64_t                            Span;               /// The length of the longest weighted path through the graph, in nanoseconds.
+    double                              MaxSpeedup;         /// TotalWork / Span, the speedup available from any number of workers, or 0 if Span is 0.
+    WIN32_COLUMN<uint64_t>              EarliestStart;      /// The earliest time each task can start in the ideal schedule.
+    WIN32_COLUMN<uint64_t>              Slack;              /// The time each task can be delayed in the ideal schedule without lengthening Span.
+    WIN32_COLUMN<uint32_t>              CriticalPred;       /// The predecessor or parent row that determines EarliestStart of each row, or WIN32_OBJECT_INDEX_EMPTY.
+    WIN32_COLUMN<uint32_t>              PathRow;            /// The task table rows on the critical path, from first to last.
+    size_t                              EntryPointCount;    /// The number of distinct entry points on the critical path.
+    WIN32_COLUMN<uint64_t>              EntryPoint;         /// Each entry point on the critical path, in descending order of EntryPointTime.
+    WIN32_COLUMN<uint64_t>              EntryPointTime;     /// The execution time of the tasks on the critical path with each entry point, in nanoseconds.
+    WIN32_LOD_PYRAMID                   PathLod;            /// The summary of the observed execution of the critical path tasks, labeled with their row.
+};
+
+/// @summary Define the run segments of each logical processor, reconstructed from the switch-in events of every thread. Segments are stored
+/// grouped by processor, and in ascending, non-overlapping time order within a processor, so that the segments of processor p are
+/// [ProcessorStart[p], ProcessorStart[p+1]). A processor with no segment covering a time was idle, or ran a thread outside the trace.
+struct WIN32_CPU_TIMELINE
+{
+    size_t                              ProcessorCount;     /// The number of logical processors, one more than the highest processor index seen.
+    size_t                              SegmentCount;       /// The number of run segments across all processors.
+    WIN32_COLUMN<size_t>                ProcessorStart;     /// The index of the first segment of each processor, plus a final entry equal to SegmentCount.
+    WIN32_COLUMN<uint64_t>              Start;              /// The time at which each segment started, in nanoseconds.
+    WIN32_COLUMN<uint64_t>              End;                /// The time at which each segment ended, in nanoseconds.
+    WIN32_COLUMN<uint32_t>              ThreadId;           /// The operating system identifier of the thread that ran during each segment.
+    WIN32_COLUMN<uint32_t>              ProcessIndex;       /// The index in WIN32_PROCESS_LIST::ProcessInfo of the process owning the thread.
+    WIN32_COLUMN<uint32_t>              ThreadIndex;        /// The index in WIN32_PROCESS_INFO::ThreadInfo of the thread.
+    WIN32_COLUMN<uint32_t>              TaskRow;            /// The task table row of the task the thread was executing during each segment, or WIN32_OBJECT_INDEX_EMPTY.
+    std::vector<WIN32_LOD_PYRAMID>      ProcessorLod;       /// The summary of each processor, labeled with TaskRow, for drawing a row per core.
+};
+
+/// @summary Define the base-2 logarithm of the number of linear sub-buckets per power of two in a WIN32_LATENCY_HISTOGRAM.
+/// Each recorded value is counted in a bucket no wider than 1/2^WIN32_LATENCY_HISTOGRAM_SUB_BITS of the value.
+#ifndef WIN32_LATENCY_HISTOGRAM_SUB_BITS
+#define WIN32_LATENCY_HISTOGRAM_SUB_BITS 5
+#endif
+
+/// @summary Define a log-linear histogram of latencies in nanoseconds. Values below 2^WIN32_LATENCY_HISTOGRAM_SUB_BITS are counted
+/// exactly; above that, each power of two is split into 2^WIN32_LATENCY_HISTOGRAM_SUB_BITS equal buckets. All histograms share the
+/// same bucket boundaries, so they merge by adding counts. Bucket is only as long as the highest bucket with a non-zero count.
+struct WIN32_LATENCY_HISTOGRAM
+{
+    uint64_t                            Count;              /// The number of values recorded.
+    uint64_t                            Total;              /// The sum of the values recorded, in nanoseconds.
+    uint64_t                            Min;                /// The smallest value recorded, in nanoseconds, or 0 if Count is 0.
+    uint64_t                            Max;                /// The largest value recorded, in nanoseconds, or 0 if Count is 0.
+    WIN32_COLUMN<uint64_t>              Bucket;             /// The number of values recorded in each bucket, indexed by LatencyHistogramBucket.
+};
+
+/// @summary Define the pool identifier of threads that are not registered as task scheduler workers.
+#ifndef WIN32_WAKE_LATENCY_NO_POOL
+#define WIN32_WAKE_LATENCY_NO_POOL      0xFFFFFFFFUL
+#endif
+
+/// @summary Define the scheduler latency of thread wakeups, measured from each ReadyThread event of a waiting thread to the switch-in
+/// that follows it. Histograms are kept for the whole trace, for each thread pool, and for each thread that was woken at least once.
+struct WIN32_WAKE_LATENCY
+{
+    uint64_t                            Threshold;          /// Wakeups with a latency greater than this value, in nanoseconds, are listed as slow.
+    WIN32_LATENCY_HISTOGRAM             All;                /// The latency of every wakeup in the trace.
+    size_t                              PoolCount;          /// The number of thread pools, including WIN32_WAKE_LATENCY_NO_POOL if any other thread was woken.
+    WIN32_COLUMN<uint32_t>              PoolId;             /// The WIN32_SCHEDULER_INFO::WorkerPoolId of each pool, in ascending order.
+    std::vector<WIN32_LATENCY_HISTOGRAM> PoolHistogram;     /// The latency of the wakeups of the threads in each pool.
+    size_t                              ThreadCount;        /// The number of threads that were woken at least once.
+    WIN32_COLUMN<uint32_t>              ThreadProcess;      /// The index in WIN32_PROCESS_LIST::ProcessInfo of each thread, in descending order of 99th percentile latency.
+    WIN32_COLUMN<uint32_t>              ThreadIndex;        /// The index in WIN32_PROCESS_INFO::ThreadInfo of each thread.
+    WIN32_COLUMN<uint32_t>              ThreadPoolId;       /// The pool identifier of each thread, or WIN32_WAKE_LATENCY_NO_POOL.
+    std::vector<WIN32_LATENCY_HISTOGRAM> ThreadHistogram;   /// The latency of the wakeups of each thread.
+    size_t                              SlowCount;          /// The number of wakeups with a latency greater than Threshold.
+    WIN32_COLUMN<uint64_t>              SlowReadyTime;      /// The time each slow wakeup was requested, in nanoseconds, in descending order of latency.
+    WIN32_COLUMN<uint64_t>              SlowLatency;        /// The latency of each slow wakeup, in nanoseconds.
+    WIN32_COLUMN<uint32_t>              SlowProcess;        /// The index in WIN32_PROCESS_LIST::ProcessInfo of the thread woken by each slow wakeup.
+    WIN32_COLUMN<uint32_t>              SlowThread;         /// The index in WIN32_PROCESS_INFO::ThreadInfo of the thread woken by each slow wakeup.
+};
+
+/// @summary Define the number of distinct wait reasons aggregated by off-CPU analysis. KWAIT_REASON values at or above this are counted as the last reason.
+#ifndef WIN32_WAIT_REASON_COUNT
+#define WIN32_WAIT_REASON_COUNT         64
+#endif
+
+/// @summary Define the value of WIN32_SWITCH_OUT_DATA::WaitMode for a user-mode wait, matching KPROCESSOR_MODE.
+#ifndef WIN32_WAIT_MODE_USER
+#define WIN32_WAIT_MODE_USER            1
+#endif
+
+/// @summary Define the result of off-CPU analysis. A thread is blocked from a switch-out into any state other than ready until it is readied
+/// or switched back in. Each blocked interval is counted under the wait reason of its switch-out, and is attributed to the task the thread was
+/// executing when it blocked. Per-reason and per-entry point arrays hold WIN32_WAIT_REASON_COUNT values for each row, indexed by wait reason.
+struct WIN32_OFF_CPU_REPORT
+{
+    WIN32_LATENCY_HISTOGRAM             All;                /// The duration of every blocked interval in the trace.
+    std::vector<WIN32_LATENCY_HISTOGRAM> ReasonHistogram;   /// The duration of the blocked intervals with each wait reason.
+    WIN32_COLUMN<uint64_t>              ReasonUserTime;     /// The blocked time with each wait reason spent in user-mode waits, in nanoseconds.
+    size_t                              ThreadCount;        /// The number of threads that blocked at least once.
+    WIN32_COLUMN<uint32_t>              ThreadProcess;      /// The index in WIN32_PROCESS_LIST::ProcessInfo of each thread, in descending order of total blocked time.
+    WIN32_COLUMN<uint32_t>              ThreadIndex;        /// The index in WIN32_PROCESS_INFO::ThreadInfo of each thread.
+    std::vector<WIN32_LATENCY_HISTOGRAM> ThreadHistogram;   /// The duration of the blocked intervals of each thread.
+    WIN32_COLUMN<uint64_t>              ThreadReasonTime;   /// The blocked time of each thread with each wait reason, in nanoseconds.
+    size_t                              EntryPointCount;    /// The number of task entry points whose tasks blocked at least once.
+    WIN32_COLUMN<uint64_t>              EntryPoint;         /// Each entry point, in descending order of EntryPointTime.
+    WIN32_COLUMN<uint64_t>              EntryPointTime;     /// The total blocked time of the tasks with each entry point, in nanoseconds.
+    WIN32_COLUMN<uint64_t>              EntryPointReasonTime; /// The blocked time of the tasks with each entry point with each wait reason, in nanoseconds.
+    WIN32_COLUMN<uint64_t>              TaskBlockedTime;    /// The blocked time attributed to each task table row, in nanoseconds.
+};
+
+/// @summary Define the kinds of series reconstructed by queue depth analysis.
+enum WIN32_QUEUE_SERIES_KIND : uint32_t
+{
+    WIN32_QUEUE_SERIES_TOTAL             = 0,               /// Every task in the trace.
+    WIN32_QUEUE_SERIES_SOURCE            = 1,               /// The tasks made ready by one task source. The key is the task source index.
+    WIN32_QUEUE_SERIES_POOL              = 2,               /// The tasks launched by the workers of one thread pool. The key is the pool identifier.
+};
+
+/// @summary Define the pool identifier of tasks that were never launched, or were launched by a thread that is not a registered worker.
+#ifndef WIN32_QUEUE_DEPTH_NO_POOL
+#define WIN32_QUEUE_DEPTH_NO_POOL       0xFFFFFFFFUL
+#endif
+
+/// @summary Define the backlog of ready tasks over time. A task is queued from its ready-to-run transition until it is launched, or until
+/// the end of the trace if it never launched. Each series is a step function: the depth is StepDepth[i] from StepTime[i] until the next step
+/// of the series, and the last step lasts until EndTime. Series are stored in the order total, sources by key, pools by key.
+struct WIN32_QUEUE_DEPTH
+{
+    uint64_t                            EndTime;            /// The time of the last task event, at which every series ends, in nanoseconds.
+    size_t                              TaskCount;          /// The number of tasks observed becoming ready.
+    size_t                              PendingCount;       /// The number of those tasks still queued at the end of the trace.
+    size_t                              SeriesCount;        /// The number of series.
+    WIN32_COLUMN<uint32_t>              SeriesKind;         /// One of WIN32_QUEUE_SERIES_KIND for each series.
+    WIN32_COLUMN<uint32_t>              SeriesKey;          /// The task source index or pool identifier of each series, or 0 for the total.
+    WIN32_COLUMN<size_t>                SeriesStart;        /// SeriesCount+1 offsets into the step columns. The steps of series s are [SeriesStart[s], SeriesStart[s+1]).
+    WIN32_COLUMN<uint64_t>              StepTime;           /// The time at which each step starts, in nanoseconds, ascending within a series.
+    WIN32_COLUMN<uint32_t>              StepDepth;          /// The number of queued tasks from each step until the next.
+    WIN32_COLUMN<uint32_t>              SeriesMaxDepth;     /// The largest depth reached by each series.
+    WIN32_COLUMN<uint64_t>              SeriesMaxTime;      /// The time at which each series first reached its largest depth, in nanoseconds.
+    std::vector<WIN32_LATENCY_HISTOGRAM> SeriesDelay;       /// The ready-to-launch delay of the launched tasks of each series.
+    std::vector<WIN32_STEP_PYRAMID>     SeriesLod;          /// The summary of each series, for drawing a row per series.
+};
+
+/// @summary Define the number of steps summarized by each entry of the first level of a WIN32_STEP_FUNCTION range index.
+#ifndef WIN32_STEP_FUNCTION_BLOCK_SIZE
+#define WIN32_STEP_FUNCTION_BLOCK_SIZE  64
+#endif
+
+/// @summary Define a step function of time, indexed for range queries. The function takes Value[i] from Time[i] until Time[i+1], and the last
+/// value until EndTime; it is zero before the first step. Level 0 of the range index holds the minimum and maximum of each block of
+/// WIN32_STEP_FUNCTION_BLOCK_SIZE steps, and entry k of level l+1 combines entries 2k and 2k+1 of level l.
+struct WIN32_STEP_FUNCTION
+{
+    size_t                              StepCount;          /// The number of steps.
+    uint64_t                            EndTime;            /// The time at which the function ends, in nanoseconds.
+    WIN32_COLUMN<uint64_t>              Time;               /// The time at which each step starts, in nanoseconds, in ascending order.
+    WIN32_COLUMN<uint32_t>              Value;              /// The value of the function from each step until the next.
+    WIN32_COLUMN<uint64_t>              Area;               /// The integral of the function from Time[0] to Time[i], in value-nanoseconds.
+    uint32_t                            LevelCount;         /// The number of levels in the range index. The last level holds a single entry.
+    WIN32_COLUMN<size_t>                LevelStart;         /// LevelCount+1 offsets into LevelMin and LevelMax. The entries of level l are [LevelStart[l], LevelStart[l+1]).
+    WIN32_COLUMN<uint32_t>              LevelMin;           /// The smallest value of the steps covered by each index entry.
+    WIN32_COLUMN<uint32_t>              LevelMax;           /// The largest value of the steps covered by each index entry.
+};
+
+/// @summary Define the result of a range query against a WIN32_STEP_FUNCTION.
+struct WIN32_STEP_RANGE
+{
+    uint32_t                            Min;                /// The smallest value taken within the range.
+    uint32_t                            Max;                /// The largest value taken within the range.
+    double                              Mean;               /// The time-weighted mean value over the range.
+};
+
+/// @summary Define the number of tasks executing in each thread pool over time, reconstructed from task launch and finish events and the pool
+/// of each launching worker. A task that never finished counts as executing until EndTime. Pools are listed by identifier, followed by
+/// WIN32_QUEUE_DEPTH_NO_POOL if any task was launched by a thread that is not a registered worker.
+struct WIN32_PARALLELISM_PROFILE
+{
+    uint64_t                            FirstTime;          /// The time of the first task launch, in nanoseconds.
+    uint64_t                            EndTime;            /// The time of the last task event, in nanoseconds.
+    size_t                              PoolCount;          /// The number of pools.
+    WIN32_COLUMN<uint32_t>              PoolId;             /// The WIN32_SCHEDULER_INFO::WorkerPoolId of each pool, in ascending order.
+    WIN32_COLUMN<uint32_t>              PoolWorkerCount;    /// The number of registered workers in each pool, or 0 for WIN32_QUEUE_DEPTH_NO_POOL.
+    WIN32_COLUMN<uint64_t>              PoolSaturatedTime;  /// The time each pool spent with every registered worker executing a task, in nanoseconds.
+    std::vector<WIN32_STEP_FUNCTION>    PoolRunning;        /// The number of tasks executing in each pool.
+};
+
+/// @summary Define the scheduling policies modeled by ReplaySchedule.
+enum WIN32_SCHEDULER_POLICY : uint32_t
+{
+    WIN32_SCHEDULER_POLICY_FIFO          = 0,               /// All workers share one queue, and the oldest ready task runs first.
+    WIN32_SCHEDULER_POLICY_LIFO          = 1,               /// All workers share one stack, and the newest ready task runs first.
+    WIN32_SCHEDULER_POLICY_WORK_STEALING = 2,               /// Each worker runs the newest task it made ready, then tasks submitted from outside, then steals the oldest task of another worker.
+    WIN32_SCHEDULER_POLICY_COUNT         = 3,               /// The number of scheduling policies.
+};
+
+/// @summary Define the parameters and predicted outcome of replaying the task dependency graph on a simulated scheduler.
+/// Tasks keep their observed execution time. Times are in nanoseconds from the earliest observed task definition or launch.
+struct WIN32_SCHEDULER_REPLAY
+{
+    uint32_t                            WorkerCount;        /// The number of simulated workers.
+    uint32_t                            Policy;             /// One of WIN32_SCHEDULER_POLICY.
+    uint64_t                            StealCost;          /// The time added to the start of a task taken from another worker.
+    uint64_t                            SpeedupEntryPoint;  /// The entry point whose tasks were sped up. Ignored if SpeedupPercent is 0.
+    uint32_t                            SpeedupPercent;     /// The percentage by which the execution time of tasks with SpeedupEntryPoint was reduced.
+    uint64_t                            TaskCount;          /// The number of tasks replayed.
+    uint64_t                            Makespan;           /// The predicted time at which the last task finishes.
+    uint64_t                            ObservedMakespan;   /// The observed time at which the last task finished, for comparison.
+    uint64_t                            BusyTime;           /// The total time workers spent executing tasks.
+    double                              Utilization;        /// BusyTime / (WorkerCount * Makespan), or 0 if Makespan is 0.
+    uint64_t                            StealCount;         /// The number of tasks taken from another worker.
+    uint64_t                            MaxReadyCount;      /// The largest number of tasks waiting for a worker at any time.
+};
+
+/// @summary Define the predicted effect on the makespan of speeding up every task with one entry point.
+struct WIN32_VIRTUAL_SPEEDUP
+{
+    uint64_t                            EntryPoint;         /// The address of the task entry point.
+    uint64_t                            TaskCount;          /// The number of tasks with the entry point.
+    uint64_t                            TaskTime;           /// The observed execution time of those tasks, in nanoseconds.
+    uint64_t                            Makespan;           /// The predicted makespan with those tasks sped up, in nanoseconds.
+    int64_t                             MakespanChange;     /// Makespan minus the baseline makespan, in nanoseconds. Negative values are improvements.
+    double                              Efficiency;         /// The makespan reduction divided by the execution time removed, or 0. Near 1 when the tasks bound the makespan, near 0 when they do not.
+};
+
+/// @summary Define a ranking of task entry points by the predicted makespan reduction from speeding them up, built by RankVirtualSpeedups.
+struct WIN32_VIRTUAL_SPEEDUP_REPORT
+{
+    uint32_t                            WorkerCount;        /// The number of simulated workers.
+    uint32_t                            Policy;             /// One of WIN32_SCHEDULER_POLICY.
+    uint64_t                            StealCost;          /// The time added to the start of a task taken from another worker.
+    uint32_t                            SpeedupPercent;     /// The percentage by which the execution time of each entry point was reduced.
+    uint64_t                            BaselineMakespan;   /// The predicted makespan with no tasks sped up, in nanoseconds.
+    size_t                              EntryCount;         /// The number of entry points ranked.
+    std::vector<WIN32_VIRTUAL_SPEEDUP>  Entries;            /// The ranked entry points, largest makespan reduction first.
+};
+
+/// @summary Define the types of zone events stored in a WIN32_ZONE_EVENT_LIST.
+enum WIN32_ZONE_EVENT_TYPE : uint8_t
+{
+    WIN32_ZONE_EVENT_BEGIN              = 0,                /// A thread entered a zone.
+    WIN32_ZONE_EVENT_END                = 1,                /// A thread left a zone.
+};
+
+/// @summary Define the zone events and zone sites loaded from the trace. Events from one thread are in the order they occurred, but
+/// events from different threads may be interleaved in any order. Site columns are indexed by site identifier; identifier 0 is never used.
+struct WIN32_ZONE_EVENT_LIST
+{
+    size_t                              EventCount;         /// The number of zone events.
+    WIN32_COLUMN<uint64_t>              EventTime;          /// The timestamp (in nanoseconds) at which each event occurred.
+    WIN32_COLUMN<uint32_t>              ThreadId;           /// The operating system identifier of the thread that produced each event.
+    WIN32_COLUMN<uint32_t>              SiteId;             /// The identifier of the zone site of each event.
+    WIN32_COLUMN<uint8_t>               EventType;          /// One of WIN32_ZONE_EVENT_TYPE for each event.
+    size_t                              SiteCount;          /// The number of entries in each site column, one more than the largest site identifier seen.
+    std::vector<std::string>            SiteName;           /// The name of each zone site, or empty if the site was never registered.
+    std::vector<std::string>            SiteFile;           /// The source file of each zone site.
+    std::vector<std::string>            SiteFunction;       /// The function containing each zone site.
+    WIN32_COLUMN<uint32_t>              SiteLine;           /// The source line of each zone site.
+};
+
+/// @summary Define the zones reconstructed from the zone events, nested by thread. Zones are stored in preorder: grouped by thread, and within
+/// a thread by begin time, with each zone before the zones nested inside it. Each zone is attributed to the task its thread was executing when
+/// the zone began. Per-site summaries are indexed by site identifier, like the site columns of WIN32_ZONE_EVENT_LIST.
+struct WIN32_ZONE_TREE
+{
+    size_t                              ZoneCount;          /// The number of zones.
+    WIN32_COLUMN<uint64_t>              BeginTime;          /// The time at which each zone began, in nanoseconds.
+    WIN32_COLUMN<uint64_t>              EndTime;            /// The time at which each zone ended, in nanoseconds.
+    WIN32_COLUMN<uint32_t>              ThreadId;           /// The operating system identifier of the thread of each zone.
+    WIN32_COLUMN<uint32_t>              SiteId;             /// The site identifier of each zone.
+    WIN32_COLUMN<uint32_t>              ParentZone;         /// The index of the zone enclosing each zone, or WIN32_OBJECT_INDEX_EMPTY.
+    WIN32_COLUMN<uint32_t>              TaskRow;            /// The task table row of the task enclosing each zone, or WIN32_OBJECT_INDEX_EMPTY.
+    WIN32_COLUMN<uint32_t>              Depth;              /// The nesting depth of each zone, 0 for zones with no parent.
+    size_t                              UnmatchedCount;     /// The number of end events with no open zone, plus the number of zones closed without an end event.
+    WIN32_COLUMN<uint64_t>              SiteZoneCount;      /// The number of zones at each site.
+    WIN32_COLUMN<uint64_t>              SiteInclusiveTime;  /// The total duration of the zones at each site, in nanoseconds. Recursive zones are counted at each level.
+    WIN32_COLUMN<uint64_t>              SiteSelfTime;       /// The total duration of the zones at each site less the time spent in nested zones, in nanoseconds.
+};
+
+/// @summary Define the number of hardware counters recorded for each task. Matches PTRACE_MAX_COUNTERS.
+#ifndef WIN32_TASK_COUNTER_COUNT
+#define WIN32_TASK_COUNTER_COUNT        5
+#endif
+
+/// @summary Define the hardware counters recorded for each task. Values index the counter values of each row of a WIN32_TASK_COUNTER_LIST
+/// or WIN32_TASK_COUNTER_REPORT, and are bit positions in their counter masks. Matches PTRACE_COUNTER.
+enum WIN32_TASK_COUNTER : uint32_t
+{
+    WIN32_TASK_COUNTER_CYCLES           = 0,                /// Core cycles spent executing the task in user mode.
+    WIN32_TASK_COUNTER_INSTRUCTIONS     = 1,                /// Instructions retired by the task in user mode.
+    WIN32_TASK_COUNTER_L1D_MISSES       = 2,                /// Level 1 data cache read misses.
+    WIN32_TASK_COUNTER_LLC_MISSES       = 3,                /// Last level cache misses.
+    WIN32_TASK_COUNTER_BRANCH_MISSES    = 4,                /// Mispredicted branch instructions.
+};
+
+/// @summary Define the hardware counter samples loaded from the trace, one for each task execution that recorded counters. Each sample
+/// holds the change in each counter between the launch and the finish of the task. Samples are in no particular order.
+struct WIN32_TASK_COUNTER_LIST
+{
+    size_t                              SampleCount;        /// The number of samples.
+    WIN32_COLUMN<uint64_t>              FinishTime;         /// The time at which the task of each sample finished, in nanoseconds.
+    WIN32_COLUMN<task_id_t>             TaskId;             /// The identifier of the task of each sample.
+    WIN32_COLUMN<uint32_t>              ThreadId;           /// The operating system identifier of the worker thread that executed the task.
+    WIN32_COLUMN<uint32_t>              CounterMask;        /// Bit i is set if counter i of the sample was recorded.
+    WIN32_COLUMN<uint64_t>              Value;              /// WIN32_TASK_COUNTER_COUNT counter deltas for each sample, indexed by WIN32_TASK_COUNTER.
+};
+
+/// @summary Define the hardware counters of each task and of each task entry point. Entry point totals include only the counters recorded
+/// for every one of its tasks. Use TaskCounterRatio to derive instructions per cycle and miss rates from a row of counter values.
+struct WIN32_TASK_COUNTER_REPORT
+{
+    size_t                              TaskCount;          /// The number of task table rows with counters.
+    size_t                              UnmatchedCount;     /// The number of samples whose task wasn't found in the task table, or whose task already had counters.
+    WIN32_COLUMN<uint32_t>              TaskCounterMask;    /// The counter mask of each task table row, or 0 if the task has no counters.
+    WIN32_COLUMN<uint64_t>              TaskValue;          /// WIN32_TASK_COUNTER_COUNT counter deltas for each task table row.
+    size_t                              EntryPointCount;    /// The number of task entry points with counters.
+    WIN32_COLUMN<uint64_t>              EntryPoint;         /// Each entry point, in descending order of total cycles.
+    WIN32_COLUMN<uint64_t>              EntryPointTasks;    /// The number of tasks with counters at each entry point.
+    WIN32_COLUMN<uint32_t>              EntryPointMask;     /// The counters recorded for every task at each entry point.
+    WIN32_COLUMN<uint64_t>              EntryPointValue;    /// WIN32_TASK_COUNTER_COUNT counter totals for each entry point.
+};
+
+/// @summary Define the heap allocations and frees of each task entry point, summed over the AllocCount, AllocBytes and FreeBytes columns of the task table.
+struct WIN32_TASK_ALLOC_REPORT
+{
+    size_t                              TaskCount;          /// The number of task table rows with allocations or frees.
+    uint64_t                            AllocCount;         /// The number of allocations made by all tasks.
+    uint64_t                            AllocBytes;         /// The number of bytes requested by all tasks.
+    uint64_t                            FreeBytes;          /// The usable size, in bytes, of the blocks freed by all tasks.
+    size_t                              EntryPointCount;    /// The number of task entry points with allocations or frees.
+    WIN32_COLUMN<uint64_t>              EntryPoint;         /// Each entry point, in descending order of allocation count.
+    WIN32_COLUMN<uint64_t>              EntryPointTasks;    /// The number of tasks with allocations or frees at each entry point.
+    WIN32_COLUMN<uint64_t>              EntryPointAllocs;   /// The number of allocations made by the tasks at each entry point.
+    WIN32_COLUMN<uint64_t>              EntryPointBytes;    /// The number of bytes requested by the tasks at each entry point.
+    WIN32_COLUMN<uint64_t>              EntryPointFreeBytes; /// The usable size, in bytes, of the blocks freed by the tasks at each entry point.
+};
+
 /// @summary Define the data for all profiler events the visualizer cares about. This is the top-level data object.
 struct WIN32_PROFILER_EVENTS
 {
@@ -106,7 +864,38 @@ struct WIN32_PROFILER_EVENTS
     size_t                              PointerSize;        /// The PointerSize field of the EVENT_TRACE_LOGFILE::LogfileHeader, specifying the size of pointer values on the producer, in bytes.
     uint64_t                            TimerResolution;    /// The TimerResolution field of the EVENT_TRACE_LOGFILE::LogfileHeader specifying the producer hardware timer resolution in 100-nanosecond units.
     LARGE_INTEGER                       ClockFrequency;     /// The PerfFreq field of the EVENT_TRACE_LOGFILE::LogfileHeader specifying the high-resolution timer counts-per-second on the producer.
+    uint64_t                            ClockScale;         /// The length of one ClockFrequency tick, used to convert event timestamps to nanoseconds. See TimestampScale.
+    WIN32_EVENT_DECODER_CACHE           DecoderCache;       /// The decoder plans for each event schema seen in the trace.
+    WIN32_EVENT_DECODER_PLAN const     *DecoderPlan;        /// The decoder plan for the event currently being dispatched. Valid only within ProfilerRecordEvent.
     WIN32_PROCESS_LIST                  ProcessList;        /// The list of information about all processes that were active during the trace.
+    WIN32_TASK_EVENT_LIST               TaskEvents;         /// The time-ordered log of task profiler events.
+    WIN32_TASK_TABLE                    TaskTable;          /// The table of tasks built from TaskEvents.
+    WIN32_SCHEDULER_INFO                Scheduler;          /// The task scheduler configuration of the profiled application.
+    WIN32_ZONE_EVENT_LIST               ZoneEvents;         /// The zone events and zone sites of the profiled application.
+    WIN32_TASK_COUNTER_LIST             TaskCounters;       /// The hardware counter samples of the tasks of the profiled application.
+    uint64_t                            DroppedEventCount;  /// The number of task profiler events lost by the producer because its buffers were full.
+    uint32_t                            TaskSampleRate;     /// The producer recorded the events of 1 in TaskSampleRate tasks, or every task if 1. Counts and totals over tasks are scaled by this value for display.
+    FILE                               *CacheFile;          /// The analysis cache file to write once all events have been consumed, or NULL.
+    uint64_t                            SourceSize;         /// The size of the trace file, in bytes.
+    uint64_t                            SourceTime;         /// The PLATFORM_FILE_MAPPING::ModifiedTime of the trace file.
+    uint64_t                            SourceHash;         /// The value returned by AnalysisCacheSourceHash for the trace file.
+    PLATFORM_FILE_MAPPING               CacheMapping;       /// The copy-on-write mapping of the analysis cache file viewed by the loaded columns, or empty if not loaded from a cache.
+    uint64_t                            FirstEventTime;     /// The timestamp of the first event consumed from the trace session, in nanoseconds, or 0.
+    uint64_t                            TraceDuration;      /// The duration of the trace session from the log file header, in nanoseconds, or 0 if unknown. Used to estimate progress.
+    WIN32_SNAPSHOT_PUBLISHER            Snapshots;          /// Snapshots of the loaded prefix of the trace, used by the user interface while loading.
+    WIN32_MEMORY_ARENA                  Arena;              /// The arena owning all strings referenced by the loaded data.
+    WIN32_STRING_TABLE                  Strings;            /// The interned strings referenced by the loaded data.
+    std::vector<uint8_t>                PropertyBuffer;     /// A scratch buffer used to read variable-length event properties before they are interned.
+    WIN32_TIMELINE_LOD                  TimelineLod;        /// The level-of-detail summaries of each timeline row, built once loading is complete.
+    WIN32_CRITICAL_PATH                 CriticalPath;       /// The critical path analysis of the task dependency graph, built once loading is complete.
+    WIN32_CPU_TIMELINE                  CpuTimeline;        /// The run segments of each logical processor, built once loading is complete.
+    WIN32_WAKE_LATENCY                  WakeLatency;        /// The scheduler latency of thread wakeups, built once loading is complete.
+    WIN32_OFF_CPU_REPORT                OffCpu;             /// The blocked time of each thread and task by wait reason, built once loading is complete.
+    WIN32_QUEUE_DEPTH                   QueueDepth;         /// The backlog of ready tasks per task source and per pool, built once loading is complete.
+    WIN32_PARALLELISM_PROFILE           Parallelism;        /// The number of tasks executing in each pool over time, built once loading is complete.
+    WIN32_ZONE_TREE                     ZoneTree;           /// The zones of each thread nested under their enclosing zones and tasks, built once loading is complete.
+    WIN32_TASK_COUNTER_REPORT           CounterReport;      /// The hardware counters of each task and task entry point, built once loading is complete.
+    WIN32_TASK_ALLOC_REPORT             AllocReport;        /// The heap allocations of each task entry point, built once loading is complete.
 };
 
 /*////////////////////////
@@ -0,0 +1,1433 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implement the analysis cache, a sidecar file holding the loaded
+/// columns of a WIN32_PROFILER_EVENTS container and the analyses built from
+/// them. Each column is stored as a byte count followed by the raw contents
+/// of the array, aligned so that it can be used in place. Reopening a trace
+/// with a valid cache maps the file and points every column at its data, so
+/// parsing, decoding, merging, index construction and analysis are replaced
+/// by a walk over the column headers. The cache records the size, the last
+/// modification time and a hash of the source file, and is ignored if any
+/// of them change.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////////
+//   Preprocessor   //
+////////////////////*/
+/// @summary Define the value of the Magic field of a complete cache file ('PCAC').
+#ifndef ANALYSIS_CACHE_MAGIC
+#define ANALYSIS_CACHE_MAGIC                   0x43414350UL
+#endif
+
+/// @summary Define the cache format version. Bump this value whenever the column list or any cached structure changes.
+#ifndef ANALYSIS_CACHE_VERSION
+#define ANALYSIS_CACHE_VERSION                 10
+#endif
+
+/// @summary Define the alignment of column data within the cache file, in bytes. Must be a power of two.
+#ifndef ANALYSIS_CACHE_ALIGNMENT
+#define ANALYSIS_CACHE_ALIGNMENT               16
+#endif
+
+/// @summary Define the number of evenly-spaced pages sampled from the source file when computing its hash.
+#ifndef ANALYSIS_CACHE_HASH_SAMPLES
+#define ANALYSIS_CACHE_HASH_SAMPLES            256
+#endif
+
+/// @summary Define the size of each page sampled from the source file when computing its hash, in bytes.
+#ifndef ANALYSIS_CACHE_HASH_PAGE_SIZE
+#define ANALYSIS_CACHE_HASH_PAGE_SIZE          4096
+#endif
+
+/*//////////////////
+//   Data Types   //
+//////////////////*/
+/// @summary Define the header at the start of a cache file. The Magic field is written last, so an interrupted write leaves an invalid file.
+struct ANALYSIS_CACHE_HEADER
+{
+    uint32_t                    Magic;            /// ANALYSIS_CACHE_MAGIC if the file is complete.
+    uint16_t                    Version;          /// ANALYSIS_CACHE_VERSION.
+    uint8_t                     WideCharSize;     /// The size of a WCHAR on the writer, in bytes.
+    uint8_t                     SizeTypeSize;     /// The size of a size_t on the writer, in bytes.
+    uint64_t                    FileSize;         /// The total size of the cache file, in bytes.
+    uint64_t                    SourceSize;       /// The size of the trace file the cache was built from, in bytes.
+    uint64_t                    SourceTime;       /// The PLATFORM_FILE_MAPPING::ModifiedTime of the trace file.
+    uint64_t                    SourceHash;       /// The value returned by AnalysisCacheSourceHash for the trace file.
+};
+
+/// @summary Define the state maintained while writing a cache file.
+struct ANALYSIS_CACHE_WRITER
+{
+    FILE                       *File;             /// The output file.
+    uint64_t                    Offset;           /// The current write offset, in bytes from the start of the file.
+    bool                        Error;            /// Set to true if any write failed.
+};
+
+/// @summary Define the state maintained while reading a cache file from memory.
+struct ANALYSIS_CACHE_READER
+{
+    uint8_t const              *Base;             /// The start of the cache file data.
+    size_t                      Offset;           /// The current read offset, in bytes from Base.
+    size_t                      Size;             /// The total number of bytes of cache file data.
+    bool                        Error;            /// Set to true if the data is truncated or malformed.
+};
+
+
+/*//////////////////////////
+//   Internal Functions   //
+//////////////////////////*/
+/// @summary Write bytes to a cache file and advance the write offset.
+/// @param w The cache writer.
+/// @param data The data to write.
+/// @param size The number of bytes to write.
+internal_function void
+AnalysisCacheWrite
+(
+    ANALYSIS_CACHE_WRITER *w,
+    void const         *data,
+    size_t              size
+)
+{
+    if (size > 0 && !w->Error && fwrite(data, 1, size, w->File) != size)
+    {   // the disk is full, or the file was closed.
+        w->Error = true;
+    }
+    w->Offset += size;
+}
+
+/// @summary Write a 64-bit scalar value to a cache file.
+/// @param w The cache writer.
+/// @param value The value to write.
+internal_function void
+AnalysisCacheWriteU64
+(
+    ANALYSIS_CACHE_WRITER *w,
+    uint64_t           value
+)
+{
+    AnalysisCacheWrite(w, &value, sizeof(value));
+}
+
+/// @summary Write a double-precision scalar value to a cache file.
+/// @param w The cache writer.
+/// @param value The value to write.
+internal_function void
+AnalysisCacheWriteF64
+(
+    ANALYSIS_CACHE_WRITER *w,
+    double             value
+)
+{
+    AnalysisCacheWrite(w, &value, sizeof(value));
+}
+
+/// @summary Write the byte count of a block to a cache file, followed by the padding that aligns the block data.
+/// @param w The cache writer.
+/// @param size The size of the block data that follows, in bytes.
+internal_function void
+AnalysisCacheWriteBlockHeader
+(
+    ANALYSIS_CACHE_WRITER *w,
+    size_t              size
+)
+{
+    static uint8_t const zero[ANALYSIS_CACHE_ALIGNMENT] = {};
+    AnalysisCacheWriteU64(w, uint64_t(size));
+    AnalysisCacheWrite(w, zero, size_t(-int64_t(w->Offset)) & (ANALYSIS_CACHE_ALIGNMENT - 1));
+}
+
+/// @summary Write a block of bytes to a cache file. The byte count is written first, followed by padding and then the data.
+/// @param w The cache writer.
+/// @param data The block data.
+/// @param size The size of the block data, in bytes.
+internal_function void
+AnalysisCacheWriteBlock
+(
+    ANALYSIS_CACHE_WRITER *w,
+    void const         *data,
+    size_t              size
+)
+{
+    AnalysisCacheWriteBlockHeader(w, size);
+    AnalysisCacheWrite(w, data, size);
+}
+
+/// @summary Write the contents of a column to a cache file as a single block.
+/// @param w The cache writer.
+/// @param column The column to write.
+template <typename T>
+internal_function void
+AnalysisCacheWriteColumn
+(
+    ANALYSIS_CACHE_WRITER        *w,
+    WIN32_COLUMN<T> const &column
+)
+{
+    AnalysisCacheWriteBlock(w, column.data(), column.size() * sizeof(T));
+}
+
+/// @summary Write a string table to a cache file. The hash table is written as-is, followed by a single block holding
+/// the zero-terminated contents of every string in identifier order, so that loading requires neither hashing nor copying.
+/// @param w The cache writer.
+/// @param table The string table to write.
+internal_function void
+AnalysisCacheWriteStrings
+(
+    ANALYSIS_CACHE_WRITER      *w,
+    WIN32_STRING_TABLE const &table
+)
+{
+    WCHAR const nul  = 0;
+    size_t      size = 0;
+    AnalysisCacheWriteU64(w, table.StringCount);
+    AnalysisCacheWriteU64(w, table.SlotCount);
+    AnalysisCacheWriteColumn(w, table.SlotHash);
+    AnalysisCacheWriteColumn(w, table.SlotId);
+    AnalysisCacheWriteColumn(w, table.Length);
+    AnalysisCacheWriteColumn(w, table.Hash);
+    for (size_t i = 1; i < table.StringCount; ++i)
+    {   // identifier zero is reserved and has no contents.
+        size += (table.Length[i] + 1) * sizeof(WCHAR);
+    }
+    AnalysisCacheWriteBlockHeader(w, size);
+    for (size_t i = 1; i < table.StringCount; ++i)
+    {
+        AnalysisCacheWrite(w, table.String[i], table.Length[i] * sizeof(WCHAR));
+        AnalysisCacheWrite(w, &nul, sizeof(nul));
+    }
+}
+
+/// @summary Write an object index to a cache file so that it doesn't need to be rebuilt on load.
+/// @param w The cache writer.
+/// @param index The object index to write.
+internal_function void
+AnalysisCacheWriteIndex
+(
+    ANALYSIS_CACHE_WRITER      *w,
+    WIN32_OBJECT_INDEX const &index
+)
+{
+    AnalysisCacheWriteU64(w, index.SlotCount);
+    AnalysisCacheWriteU64(w, index.KeyCount);
+    AnalysisCacheWriteColumn(w, index.SlotKey);
+    AnalysisCacheWriteColumn(w, index.SlotHead);
+    AnalysisCacheWriteColumn(w, index.ChainNext);
+}
+
+/// @summary Write the scheduling intervals of a thread to a cache file.
+/// @param w The cache writer.
+/// @param intervals The thread intervals to write.
+internal_function void
+AnalysisCacheWriteIntervals
+(
+    ANALYSIS_CACHE_WRITER          *w,
+    WIN32_THREAD_INTERVALS const &intervals
+)
+{
+    AnalysisCacheWriteU64(w, intervals.IntervalCount);
+    AnalysisCacheWriteColumn(w, intervals.Start);
+    AnalysisCacheWriteColumn(w, intervals.Duration);
+    AnalysisCacheWriteColumn(w, intervals.State);
+    AnalysisCacheWriteColumn(w, intervals.WaitReason);
+    AnalysisCacheWriteColumn(w, intervals.WaitMode);
+    AnalysisCacheWriteColumn(w, intervals.IndexStart);
+}
+
+/// @summary Write a level-of-detail pyramid to a cache file.
+/// @param w The cache writer.
+/// @param pyr The pyramid to write.
+internal_function void
+AnalysisCacheWriteLodPyramid
+(
+    ANALYSIS_CACHE_WRITER     *w,
+    WIN32_LOD_PYRAMID const &pyr
+)
+{
+    AnalysisCacheWriteU64(w, pyr.BaseTime);
+    AnalysisCacheWriteU64(w, pyr.BaseShift);
+    AnalysisCacheWriteU64(w, pyr.LevelCount);
+    AnalysisCacheWriteColumn(w, pyr.LevelFirst);
+    AnalysisCacheWriteColumn(w, pyr.LevelStart);
+    AnalysisCacheWriteColumn(w, pyr.BusyFraction);
+    AnalysisCacheWriteColumn(w, pyr.DominantFraction);
+    AnalysisCacheWriteColumn(w, pyr.DominantLabel);
+}
+
+/// @summary Write a list of level-of-detail pyramids to a cache file.
+/// @param w The cache writer.
+/// @param list The pyramids to write.
+internal_function void
+AnalysisCacheWriteLodPyramids
+(
+    ANALYSIS_CACHE_WRITER                  *w,
+    std::vector<WIN32_LOD_PYRAMID> const &list
+)
+{
+    AnalysisCacheWriteU64(w, list.size());
+    for (size_t i = 0, n = list.size(); i < n; ++i)
+    {
+        AnalysisCacheWriteLodPyramid(w, list[i]);
+    }
+}
+
+/// @summary Write a list of step function pyramids to a cache file.
+/// @param w The cache writer.
+/// @param list The pyramids to write.
+internal_function void
+AnalysisCacheWriteStepPyramids
+(
+    ANALYSIS_CACHE_WRITER                   *w,
+    std::vector<WIN32_STEP_PYRAMID> const &list
+)
+{
+    AnalysisCacheWriteU64(w, list.size());
+    for (size_t i = 0, n = list.size(); i < n; ++i)
+    {
+        AnalysisCacheWriteU64(w, list[i].BaseTime);
+        AnalysisCacheWriteU64(w, list[i].BaseShift);
+        AnalysisCacheWriteU64(w, list[i].LevelCount);
+        AnalysisCacheWriteColumn(w, list[i].LevelFirst);
+        AnalysisCacheWriteColumn(w, list[i].LevelStart);
+        AnalysisCacheWriteColumn(w, list[i].MaxValue);
+        AnalysisCacheWriteColumn(w, list[i].MeanValue);
+    }
+}
+
+/// @summary Write a latency histogram to a cache file.
+/// @param w The cache writer.
+/// @param h The histogram to write.
+internal_function void
+AnalysisCacheWriteHistogram
+(
+    ANALYSIS_CACHE_WRITER           *w,
+    WIN32_LATENCY_HISTOGRAM const &h
+)
+{
+    AnalysisCacheWriteU64(w, h.Count);
+    AnalysisCacheWriteU64(w, h.Total);
+    AnalysisCacheWriteU64(w, h.Min);
+    AnalysisCacheWriteU64(w, h.Max);
+    AnalysisCacheWriteColumn(w, h.Bucket);
+}
+
+/// @summary Write a list of latency histograms to a cache file.
+/// @param w The cache writer.
+/// @param list The histograms to write.
+internal_function void
+AnalysisCacheWriteHistograms
+(
+    ANALYSIS_CACHE_WRITER                        *w,
+    std::vector<WIN32_LATENCY_HISTOGRAM> const &list
+)
+{
+    AnalysisCacheWriteU64(w, list.size());
+    for (size_t i = 0, n = list.size(); i < n; ++i)
+    {
+        AnalysisCacheWriteHistogram(w, list[i]);
+    }
+}
+
+/// @summary Write a list of step functions to a cache file.
+/// @param w The cache writer.
+/// @param list The step functions to write.
+internal_function void
+AnalysisCacheWriteStepFunctions
+(
+    ANALYSIS_CACHE_WRITER                    *w,
+    std::vector<WIN32_STEP_FUNCTION> const &list
+)
+{
+    AnalysisCacheWriteU64(w, list.size());
+    for (size_t i = 0, n = list.size(); i < n; ++i)
+    {
+        AnalysisCacheWriteU64(w, list[i].StepCount);
+        AnalysisCacheWriteU64(w, list[i].EndTime);
+        AnalysisCacheWriteColumn(w, list[i].Time);
+        AnalysisCacheWriteColumn(w, list[i].Value);
+        AnalysisCacheWriteColumn(w, list[i].Area);
+        AnalysisCacheWriteU64(w, list[i].LevelCount);
+        AnalysisCacheWriteColumn(w, list[i].LevelStart);
+        AnalysisCacheWriteColumn(w, list[i].LevelMin);
+        AnalysisCacheWriteColumn(w, list[i].LevelMax);
+    }
+}
+
+/// @summary Write the analyses built by BuildProfilerAnalyses, other than those stored with the columns they are built from.
+/// @param w The cache writer.
+/// @param rtev The profiler events container.
+internal_function void
+AnalysisCacheWriteAnalyses
+(
+    ANALYSIS_CACHE_WRITER         *w,
+    WIN32_PROFILER_EVENTS const *rtev
+)
+{
+    WIN32_TIMELINE_LOD const &lod = rtev->TimelineLod;
+    AnalysisCacheWriteU64(w, lod.FirstTime);
+    AnalysisCacheWriteU64(w, lod.LastTime);
+    AnalysisCacheWriteU64(w, lod.BaseShift);
+    AnalysisCacheWriteU64(w, lod.ThreadCount);
+    AnalysisCacheWriteColumn(w, lod.ThreadProcess);
+    AnalysisCacheWriteColumn(w, lod.ThreadIndex);
+    AnalysisCacheWriteLodPyramids(w, lod.ThreadLod);
+    AnalysisCacheWriteU64(w, lod.WorkerCount);
+    AnalysisCacheWriteColumn(w, lod.WorkerThreadId);
+    AnalysisCacheWriteLodPyramids(w, lod.WorkerLod);
+
+    WIN32_CRITICAL_PATH const &cp = rtev->CriticalPath;
+    AnalysisCacheWriteU64(w, cp.TaskCount);
+    AnalysisCacheWriteU64(w, cp.TotalWork);
+    AnalysisCacheWriteU64(w, cp.Span);
+    AnalysisCacheWriteF64(w, cp.MaxSpeedup);
+    AnalysisCacheWriteColumn(w, cp.EarliestStart);
+    AnalysisCacheWriteColumn(w, cp.Slack);
+    AnalysisCacheWriteColumn(w, cp.CriticalPred);
+    AnalysisCacheWriteColumn(w, cp.PathRow);
+    AnalysisCacheWriteU64(w, cp.EntryPointCount);
+    AnalysisCacheWriteColumn(w, cp.EntryPoint);
+    AnalysisCacheWriteColumn(w, cp.EntryPointTime);
+    AnalysisCacheWriteLodPyramid(w, cp.PathLod);
+
+    WIN32_CPU_TIMELINE const &cpu = rtev->CpuTimeline;
+    AnalysisCacheWriteU64(w, cpu.ProcessorCount);
+    AnalysisCacheWriteU64(w, cpu.SegmentCount);
+    AnalysisCacheWriteColumn(w, cpu.ProcessorStart);
+    AnalysisCacheWriteColumn(w, cpu.Start);
+    AnalysisCacheWriteColumn(w, cpu.End);
+    AnalysisCacheWriteColumn(w, cpu.ThreadId);
+    AnalysisCacheWriteColumn(w, cpu.ProcessIndex);
+    AnalysisCacheWriteColumn(w, cpu.ThreadIndex);
+    AnalysisCacheWriteColumn(w, cpu.TaskRow);
+    AnalysisCacheWriteLodPyramids(w, cpu.ProcessorLod);
+
+    WIN32_WAKE_LATENCY const &wl = rtev->WakeLatency;
+    AnalysisCacheWriteU64(w, wl.Threshold);
+    AnalysisCacheWriteHistogram(w, wl.All);
+    AnalysisCacheWriteU64(w, wl.PoolCount);
+    AnalysisCacheWriteColumn(w, wl.PoolId);
+    AnalysisCacheWriteHistograms(w, wl.PoolHistogram);
+    AnalysisCacheWriteU64(w, wl.ThreadCount);
+    AnalysisCacheWriteColumn(w, wl.ThreadProcess);
+    AnalysisCacheWriteColumn(w, wl.ThreadIndex);
+    AnalysisCacheWriteColumn(w, wl.ThreadPoolId);
+    AnalysisCacheWriteHistograms(w, wl.ThreadHistogram);
+    AnalysisCacheWriteU64(w, wl.SlowCount);
+    AnalysisCacheWriteColumn(w, wl.SlowReadyTime);
+    AnalysisCacheWriteColumn(w, wl.SlowLatency);
+    AnalysisCacheWriteColumn(w, wl.SlowProcess);
+    AnalysisCacheWriteColumn(w, wl.SlowThread);
+
+    WIN32_OFF_CPU_REPORT const &oc = rtev->OffCpu;
+    AnalysisCacheWriteHistogram(w, oc.All);
+    AnalysisCacheWriteHistograms(w, oc.ReasonHistogram);
+    AnalysisCacheWriteColumn(w, oc.ReasonUserTime);
+    AnalysisCacheWriteU64(w, oc.ThreadCount);
+    AnalysisCacheWriteColumn(w, oc.ThreadProcess);
+    AnalysisCacheWriteColumn(w, oc.ThreadIndex);
+    AnalysisCacheWriteHistograms(w, oc.ThreadHistogram);
+    AnalysisCacheWriteColumn(w, oc.ThreadReasonTime);
+    AnalysisCacheWriteU64(w, oc.EntryPointCount);
+    AnalysisCacheWriteColumn(w, oc.EntryPoint);
+    AnalysisCacheWriteColumn(w, oc.EntryPointTime);
+    AnalysisCacheWriteColumn(w, oc.EntryPointReasonTime);
+    AnalysisCacheWriteColumn(w, oc.TaskBlockedTime);
+
+    WIN32_QUEUE_DEPTH const &qd = rtev->QueueDepth;
+    AnalysisCacheWriteU64(w, qd.EndTime);
+    AnalysisCacheWriteU64(w, qd.TaskCount);
+    AnalysisCacheWriteU64(w, qd.PendingCount);
+    AnalysisCacheWriteU64(w, qd.SeriesCount);
+    AnalysisCacheWriteColumn(w, qd.SeriesKind);
+    AnalysisCacheWriteColumn(w, qd.SeriesKey);
+    AnalysisCacheWriteColumn(w, qd.SeriesStart);
+    AnalysisCacheWriteColumn(w, qd.StepTime);
+    AnalysisCacheWriteColumn(w, qd.StepDepth);
+    AnalysisCacheWriteColumn(w, qd.SeriesMaxDepth);
+    AnalysisCacheWriteColumn(w, qd.SeriesMaxTime);
+    AnalysisCacheWriteHistograms(w, qd.SeriesDelay);
+    AnalysisCacheWriteStepPyramids(w, qd.SeriesLod);
+
+    WIN32_PARALLELISM_PROFILE const &par = rtev->Parallelism;
+    AnalysisCacheWriteU64(w, par.FirstTime);
+    AnalysisCacheWriteU64(w, par.EndTime);
+    AnalysisCacheWriteU64(w, par.PoolCount);
+    AnalysisCacheWriteColumn(w, par.PoolId);
+    AnalysisCacheWriteColumn(w, par.PoolWorkerCount);
+    AnalysisCacheWriteColumn(w, par.PoolSaturatedTime);
+    AnalysisCacheWriteStepFunctions(w, par.PoolRunning);
+
+    WIN32_ZONE_TREE const &zt = rtev->ZoneTree;
+    AnalysisCacheWriteU64(w, zt.ZoneCount);
+    AnalysisCacheWriteColumn(w, zt.BeginTime);
+    AnalysisCacheWriteColumn(w, zt.EndTime);
+    AnalysisCacheWriteColumn(w, zt.ThreadId);
+    AnalysisCacheWriteColumn(w, zt.SiteId);
+    AnalysisCacheWriteColumn(w, zt.ParentZone);
+    AnalysisCacheWriteColumn(w, zt.TaskRow);
+    AnalysisCacheWriteColumn(w, zt.Depth);
+    AnalysisCacheWriteU64(w, zt.UnmatchedCount);
+    AnalysisCacheWriteColumn(w, zt.SiteZoneCount);
+    AnalysisCacheWriteColumn(w, zt.SiteInclusiveTime);
+    AnalysisCacheWriteColumn(w, zt.SiteSelfTime);
+
+    WIN32_TASK_COUNTER_REPORT const &cr = rtev->CounterReport;
+    AnalysisCacheWriteU64(w, cr.TaskCount);
+    AnalysisCacheWriteU64(w, cr.UnmatchedCount);
+    AnalysisCacheWriteColumn(w, cr.TaskCounterMask);
+    AnalysisCacheWriteColumn(w, cr.TaskValue);
+    AnalysisCacheWriteU64(w, cr.EntryPointCount);
+    AnalysisCacheWriteColumn(w, cr.EntryPoint);
+    AnalysisCacheWriteColumn(w, cr.EntryPointTasks);
+    AnalysisCacheWriteColumn(w, cr.EntryPointMask);
+    AnalysisCacheWriteColumn(w, cr.EntryPointValue);
+
+    WIN32_TASK_ALLOC_REPORT const &ar = rtev->AllocReport;
+    AnalysisCacheWriteU64(w, ar.TaskCount);
+    AnalysisCacheWriteU64(w, ar.AllocCount);
+    AnalysisCacheWriteU64(w, ar.AllocBytes);
+    AnalysisCacheWriteU64(w, ar.FreeBytes);
+    AnalysisCacheWriteU64(w, ar.EntryPointCount);
+    AnalysisCacheWriteColumn(w, ar.EntryPoint);
+    AnalysisCacheWriteColumn(w, ar.EntryPointTasks);
+    AnalysisCacheWriteColumn(w, ar.EntryPointAllocs);
+    AnalysisCacheWriteColumn(w, ar.EntryPointBytes);
+    AnalysisCacheWriteColumn(w, ar.EntryPointFreeBytes);
+}
+
+/// @summary Mark a cache file as malformed if a consistency check fails.
+/// @param r The cache reader.
+/// @param valid The result of the consistency check.
+internal_function void
+AnalysisCacheExpect
+(
+    ANALYSIS_CACHE_READER *r,
+    bool               valid
+)
+{
+    if (!valid) r->Error = true;
+}
+
+/// @summary Read a 64-bit scalar value from a cache file.
+/// @param r The cache reader.
+/// @return The value, or 0 if the data is truncated.
+internal_function uint64_t
+AnalysisCacheReadU64
+(
+    ANALYSIS_CACHE_READER *r
+)
+{
+    uint64_t value = 0;
+    if (r->Error || r->Size - r->Offset < sizeof(value))
+    {   // the file is truncated.
+        r->Error = true;
+        return 0;
+    }
+    memcpy(&value, r->Base + r->Offset, sizeof(value));
+    r->Offset += sizeof(value);
+    return value;
+}
+
+/// @summary Read a double-precision scalar value from a cache file.
+/// @param r The cache reader.
+/// @return The value, or 0 if the data is truncated.
+internal_function double
+AnalysisCacheReadF64
+(
+    ANALYSIS_CACHE_READER *r
+)
+{
+    uint64_t const bits  = AnalysisCacheReadU64(r);
+    double         value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/// @summary Locate the next block in a cache file.
+/// @param r The cache reader.
+/// @param element_size The size of a single block element, in bytes. The block size must be a multiple of this value.
+/// @param size On return, set to the size of the block data, in bytes.
+/// @return A pointer to the block data within the cache file, or NULL if the block is empty or the data is malformed.
+internal_function uint8_t const*
+AnalysisCacheReadBlock
+(
+    ANALYSIS_CACHE_READER *r,
+    size_t      element_size,
+    size_t             &size
+)
+{
+    uint64_t const bytes = AnalysisCacheReadU64(r);
+    size_t   const start = (r->Offset + (ANALYSIS_CACHE_ALIGNMENT - 1)) & ~size_t(ANALYSIS_CACHE_ALIGNMENT - 1);
+    size = 0;
+    if (r->Error || start > r->Size || bytes > uint64_t(r->Size - start) || (bytes % element_size) != 0)
+    {   // the file is truncated or the block doesn't match the expected element type.
+        r->Error = true;
+        return NULL;
+    }
+    r->Offset = start + size_t(bytes);
+    size      = size_t(bytes);
+    return bytes != 0 ? r->Base + start : NULL;
+}
+
+/// @summary Read a column from a cache file. The column becomes a view of the cache file data; nothing is copied.
+/// @param r The cache reader.
+/// @param column The column to populate.
+template <typename T>
+internal_function void
+AnalysisCacheReadColumn
+(
+    ANALYSIS_CACHE_READER *r,
+    WIN32_COLUMN<T>  &column
+)
+{
+    size_t         size = 0;
+    uint8_t const *data = AnalysisCacheReadBlock(r, sizeof(T), size);
+    column.View((T*) data, size / sizeof(T));
+}
+
+/// @summary Read a string table from a cache file. The hash table columns become views of the cache file data, and each
+/// string points at its contents within the cache file, so identifiers are preserved without hashing or copying any string.
+/// @param r The cache reader.
+/// @param table The empty string table to populate.
+internal_function void
+AnalysisCacheReadStrings
+(
+    ANALYSIS_CACHE_READER *r,
+    WIN32_STRING_TABLE &table
+)
+{
+    size_t       size   = 0;
+    size_t       offset = 0;
+    table.StringCount   = size_t(AnalysisCacheReadU64(r));
+    table.SlotCount     = size_t(AnalysisCacheReadU64(r));
+    AnalysisCacheReadColumn(r, table.SlotHash);
+    AnalysisCacheReadColumn(r, table.SlotId);
+    AnalysisCacheReadColumn(r, table.Length);
+    AnalysisCacheReadColumn(r, table.Hash);
+    WCHAR const *chars  = (WCHAR const*) AnalysisCacheReadBlock(r, sizeof(WCHAR), size);
+    AnalysisCacheExpect(r, table.SlotHash.size() == table.SlotCount && table.SlotId.size() == table.SlotCount && (table.SlotCount & (table.SlotCount - 1)) == 0);
+    AnalysisCacheExpect(r, table.Length.size() == table.StringCount && table.Hash.size() == table.StringCount && table.StringCount * 2 <= table.SlotCount);
+    if (r->Error)
+    {   // the table is inconsistent; probing it could run forever.
+        InitStringTable(&table);
+        return;
+    }
+    table.String.resize(table.StringCount, NULL);
+    for (size_t i = 1; i < table.StringCount; ++i)
+    {   // strings are stored back-to-back, each followed by its terminator.
+        if (size / sizeof(WCHAR) - offset <= table.Length[i] || chars[offset + table.Length[i]] != 0)
+        {   // the string data is truncated.
+            r->Error = true;
+            InitStringTable(&table);
+            return;
+        }
+        table.String[i] = chars + offset;
+        offset += table.Length[i] + 1;
+    }
+}
+
+/// @summary Read an object index from a cache file.
+/// @param r The cache reader.
+/// @param index The object index to populate.
+internal_function void
+AnalysisCacheReadIndex
+(
+    ANALYSIS_CACHE_READER *r,
+    WIN32_OBJECT_INDEX &index
+)
+{
+    index.SlotCount = size_t(AnalysisCacheReadU64(r));
+    index.KeyCount  = size_t(AnalysisCacheReadU64(r));
+    AnalysisCacheReadColumn(r, index.SlotKey);
+    AnalysisCacheReadColumn(r, index.SlotHead);
+    AnalysisCacheReadColumn(r, index.ChainNext);
+    if (index.SlotKey.size() != index.SlotCount || index.SlotHead.size() != index.SlotCount || (index.SlotCount & (index.SlotCount - 1)) != 0)
+    {   // the index is inconsistent; probing it could run forever.
+        r->Error = true;
+        InitObjectIndex(index);
+    }
+}
+
+/// @summary Read the scheduling intervals of a thread from a cache file.
+/// @param r The cache reader.
+/// @param intervals The thread intervals to populate.
+internal_function void
+AnalysisCacheReadIntervals
+(
+    ANALYSIS_CACHE_READER    *r,
+    WIN32_THREAD_INTERVALS &intervals
+)
+{
+    intervals.IntervalCount = size_t(AnalysisCacheReadU64(r));
+    AnalysisCacheReadColumn(r, intervals.Start);
+    AnalysisCacheReadColumn(r, intervals.Duration);
+    AnalysisCacheReadColumn(r, intervals.State);
+    AnalysisCacheReadColumn(r, intervals.WaitReason);
+    AnalysisCacheReadColumn(r, intervals.WaitMode);
+    AnalysisCacheReadColumn(r, intervals.IndexStart);
+    AnalysisCacheExpect(r, intervals.Start.size() == intervals.IntervalCount && intervals.Duration.size() == intervals.IntervalCount && intervals.State.size() == intervals.IntervalCount);
+    AnalysisCacheExpect(r, intervals.WaitReason.size() == intervals.IntervalCount && intervals.WaitMode.size() == intervals.IntervalCount);
+}
+
+/// @summary Read a level-of-detail pyramid from a cache file.
+/// @param r The cache reader.
+/// @param pyr The pyramid to populate.
+internal_function void
+AnalysisCacheReadLodPyramid
+(
+    ANALYSIS_CACHE_READER *r,
+    WIN32_LOD_PYRAMID   &pyr
+)
+{
+    pyr.BaseTime   = AnalysisCacheReadU64(r);
+    pyr.BaseShift  = uint32_t(AnalysisCacheReadU64(r));
+    pyr.LevelCount = uint32_t(AnalysisCacheReadU64(r));
+    AnalysisCacheReadColumn(r, pyr.LevelFirst);
+    AnalysisCacheReadColumn(r, pyr.LevelStart);
+    AnalysisCacheReadColumn(r, pyr.BusyFraction);
+    AnalysisCacheReadColumn(r, pyr.DominantFraction);
+    AnalysisCacheReadColumn(r, pyr.DominantLabel);
+    if (pyr.LevelCount != 0)
+    {   // every bucket column holds LevelStart[LevelCount] entries.
+        AnalysisCacheExpect(r, pyr.LevelFirst.size() == pyr.LevelCount && pyr.LevelStart.size() == size_t(pyr.LevelCount) + 1);
+        AnalysisCacheExpect(r, !r->Error && pyr.BusyFraction.size() == pyr.LevelStart[pyr.LevelCount] && pyr.DominantFraction.size() == pyr.BusyFraction.size() && pyr.DominantLabel.size() == pyr.BusyFraction.size());
+    }
+}
+
+/// @summary Read a list of level-of-detail pyramids from a cache file.
+/// @param r The cache reader.
+/// @param list The pyramids to populate.
+internal_function void
+AnalysisCacheReadLodPyramids
+(
+    ANALYSIS_CACHE_READER            *r,
+    std::vector<WIN32_LOD_PYRAMID> &list
+)
+{
+    size_t const count = size_t(AnalysisCacheReadU64(r));
+    AnalysisCacheExpect(r, count <= r->Size - r->Offset);
+    list.resize(r->Error ? 0 : count);
+    for (size_t i = 0; i < list.size() && !r->Error; ++i)
+    {
+        AnalysisCacheReadLodPyramid(r, list[i]);
+    }
+}
+
+/// @summary Read a list of step function pyramids from a cache file.
+/// @param r The cache reader.
+/// @param list The pyramids to populate.
+internal_function void
+AnalysisCacheReadStepPyramids
+(
+    ANALYSIS_CACHE_READER             *r,
+    std::vector<WIN32_STEP_PYRAMID> &list
+)
+{
+    size_t const count = size_t(AnalysisCacheReadU64(r));
+    AnalysisCacheExpect(r, count <= r->Size - r->Offset);
+    list.resize(r->Error ? 0 : count);
+    for (size_t i = 0; i < list.size() && !r->Error; ++i)
+    {
+        WIN32_STEP_PYRAMID &pyr = list[i];
+        pyr.BaseTime   = AnalysisCacheReadU64(r);
+        pyr.BaseShift  = uint32_t(AnalysisCacheReadU64(r));
+        pyr.LevelCount = uint32_t(AnalysisCacheReadU64(r));
+        AnalysisCacheReadColumn(r, pyr.LevelFirst);
+        AnalysisCacheReadColumn(r, pyr.LevelStart);
+        AnalysisCacheReadColumn(r, pyr.MaxValue);
+        AnalysisCacheReadColumn(r, pyr.MeanValue);
+        if (pyr.LevelCount != 0)
+        {   // both bucket columns hold LevelStart[LevelCount] entries.
+            AnalysisCacheExpect(r, pyr.LevelFirst.size() == pyr.LevelCount && pyr.LevelStart.size() == size_t(pyr.LevelCount) + 1);
+            AnalysisCacheExpect(r, !r->Error && pyr.MaxValue.size() == pyr.LevelStart[pyr.LevelCount] && pyr.MeanValue.size() == pyr.MaxValue.size());
+        }
+    }
+}
+
+/// @summary Read a latency histogram from a cache file.
+/// @param r The cache reader.
+/// @param h The histogram to populate.
+internal_function void
+AnalysisCacheReadHistogram
+(
+    ANALYSIS_CACHE_READER     *r,
+    WIN32_LATENCY_HISTOGRAM &h
+)
+{
+    h.Count = AnalysisCacheReadU64(r);
+    h.Total = AnalysisCacheReadU64(r);
+    h.Min   = AnalysisCacheReadU64(r);
+    h.Max   = AnalysisCacheReadU64(r);
+    AnalysisCacheReadColumn(r, h.Bucket);
+}
+
+/// @summary Read a list of latency histograms from a cache file.
+/// @param r The cache reader.
+/// @param list The histograms to populate.
+internal_function void
+AnalysisCacheReadHistograms
+(
+    ANALYSIS_CACHE_READER                  *r,
+    std::vector<WIN32_LATENCY_HISTOGRAM> &list
+)
+{
+    size_t const count = size_t(AnalysisCacheReadU64(r));
+    AnalysisCacheExpect(r, count <= r->Size - r->Offset);
+    list.resize(r->Error ? 0 : count);
+    for (size_t i = 0; i < list.size() && !r->Error; ++i)
+    {
+        AnalysisCacheReadHistogram(r, list[i]);
+    }
+}
+
+/// @summary Read a list of step functions from a cache file.
+/// @param r The cache reader.
+/// @param list The step functions to populate.
+internal_function void
+AnalysisCacheReadStepFunctions
+(
+    ANALYSIS_CACHE_READER              *r,
+    std::vector<WIN32_STEP_FUNCTION> &list
+)
+{
+    size_t const count = size_t(AnalysisCacheReadU64(r));
+    AnalysisCacheExpect(r, count <= r->Size - r->Offset);
+    list.resize(r->Error ? 0 : count);
+    for (size_t i = 0; i < list.size() && !r->Error; ++i)
+    {
+        WIN32_STEP_FUNCTION &fn = list[i];
+        fn.StepCount  = size_t(AnalysisCacheReadU64(r));
+        fn.EndTime    = AnalysisCacheReadU64(r);
+        AnalysisCacheReadColumn(r, fn.Time);
+        AnalysisCacheReadColumn(r, fn.Value);
+        AnalysisCacheReadColumn(r, fn.Area);
+        fn.LevelCount = uint32_t(AnalysisCacheReadU64(r));
+        AnalysisCacheReadColumn(r, fn.LevelStart);
+        AnalysisCacheReadColumn(r, fn.LevelMin);
+        AnalysisCacheReadColumn(r, fn.LevelMax);
+        AnalysisCacheExpect(r, fn.Time.size() == fn.StepCount && fn.Value.size() == fn.StepCount && fn.Area.size() == fn.StepCount);
+        if (fn.LevelCount != 0)
+        {   // both index columns hold LevelStart[LevelCount] entries.
+            AnalysisCacheExpect(r, fn.LevelStart.size() == size_t(fn.LevelCount) + 1);
+            AnalysisCacheExpect(r, !r->Error && fn.LevelMin.size() == fn.LevelStart[fn.LevelCount] && fn.LevelMax.size() == fn.LevelMin.size());
+        }
+    }
+}
+
+/// @summary Read the analyses written by AnalysisCacheWriteAnalyses.
+/// @param r The cache reader.
+/// @param rtev The profiler events container to populate.
+internal_function void
+AnalysisCacheReadAnalyses
+(
+    ANALYSIS_CACHE_READER   *r,
+    WIN32_PROFILER_EVENTS *rtev
+)
+{
+    WIN32_TIMELINE_LOD &lod = rtev->TimelineLod;
+    lod.FirstTime   = AnalysisCacheReadU64(r);
+    lod.LastTime    = AnalysisCacheReadU64(r);
+    lod.BaseShift   = uint32_t(AnalysisCacheReadU64(r));
+    lod.ThreadCount = size_t(AnalysisCacheReadU64(r));
+    AnalysisCacheReadColumn(r, lod.ThreadProcess);
+    AnalysisCacheReadColumn(r, lod.ThreadIndex);
+    AnalysisCacheReadLodPyramids(r, lod.ThreadLod);
+    lod.WorkerCount = size_t(AnalysisCacheReadU64(r));
+    AnalysisCacheReadColumn(r, lod.WorkerThreadId);
+    AnalysisCacheReadLodPyramids(r, lod.WorkerLod);
+    AnalysisCacheExpect(r, lod.ThreadProcess.size() == lod.ThreadCount && lod.ThreadIndex.size() == lod.ThreadCount && lod.ThreadLod.size() == lod.ThreadCount);
+    AnalysisCacheExpect(r, lod.WorkerThreadId.size() == lod.WorkerCount && lod.WorkerLod.size() == lod.WorkerCount);
+
+    WIN32_CRITICAL_PATH &cp = rtev->CriticalPath;
+    cp.TaskCount       = size_t(AnalysisCacheReadU64(r));
+    cp.TotalWork       = AnalysisCacheReadU64(r);
+    cp.Span            = AnalysisCacheReadU64(r);
+    cp.MaxSpeedup      = AnalysisCacheReadF64(r);
+    AnalysisCacheReadColumn(r, cp.EarliestStart);
+    AnalysisCacheReadColumn(r, cp.Slack);
+    AnalysisCacheReadColumn(r, cp.CriticalPred);
+    AnalysisCacheReadColumn(r, cp.PathRow);
+    cp.EntryPointCount = size_t(AnalysisCacheReadU64(r));
+    AnalysisCacheReadColumn(r, cp.EntryPoint);
+    AnalysisCacheReadColumn(r, cp.EntryPointTime);
+    AnalysisCacheReadLodPyramid(r, cp.PathLod);
+    AnalysisCacheExpect(r, cp.EarliestStart.size() == cp.TaskCount && cp.Slack.size() == cp.TaskCount && cp.CriticalPred.size() == cp.TaskCount);
+    AnalysisCacheExpect(r, cp.EntryPoint.size() == cp.EntryPointCount && cp.EntryPointTime.size() == cp.EntryPointCount);
+
+    WIN32_CPU_TIMELINE &cpu = rtev->CpuTimeline;
+    cpu.ProcessorCount = size_t(AnalysisCacheReadU64(r));
+    cpu.SegmentCount   = size_t(AnalysisCacheReadU64(r));
+    AnalysisCacheReadColumn(r, cpu.ProcessorStart);
+    AnalysisCacheReadColumn(r, cpu.Start);
+    AnalysisCacheReadColumn(r, cpu.End);
+    AnalysisCacheReadColumn(r, cpu.ThreadId);
+    AnalysisCacheReadColumn(r, cpu.ProcessIndex);
+    AnalysisCacheReadColumn(r, cpu.ThreadIndex);
+    AnalysisCacheReadColumn(r, cpu.TaskRow);
+    AnalysisCacheReadLodPyramids(r, cpu.ProcessorLod);
+    AnalysisCacheExpect(r, (cpu.ProcessorStart.size() == cpu.ProcessorCount + 1 || (cpu.ProcessorCount == 0 && cpu.ProcessorStart.empty())) && cpu.ProcessorLod.size() == cpu.ProcessorCount);
+    AnalysisCacheExpect(r, cpu.Start.size() == cpu.SegmentCount && cpu.End.size() == cpu.SegmentCount && cpu.ThreadId.size() == cpu.SegmentCount);
+    AnalysisCacheExpect(r, cpu.ProcessIndex.size() == cpu.SegmentCount && cpu.ThreadIndex.size() == cpu.SegmentCount && cpu.TaskRow.size() == cpu.SegmentCount);
+
+    WIN32_WAKE_LATENCY &wl = rtev->WakeLatency;
+    wl.Threshold   = AnalysisCacheReadU64(r);
+    AnalysisCacheReadHistogram(r, wl.All);
+    wl.PoolCount   = size_t(AnalysisCacheReadU64(r));
+    AnalysisCacheReadColumn(r, wl.PoolId);
+    AnalysisCacheReadHistograms(r, wl.PoolHistogram);
+    wl.ThreadCount = size_t(AnalysisCacheReadU64(r));
+    AnalysisCacheReadColumn(r, wl.ThreadProcess);
+    AnalysisCacheReadColumn(r, wl.ThreadIndex);
+    AnalysisCacheReadColumn(r, wl.ThreadPoolId);
+    AnalysisCacheReadHistograms(r, wl.ThreadHistogram);
+    wl.SlowCount   = size_t(AnalysisCacheReadU64(r));
+    AnalysisCacheReadColumn(r, wl.SlowReadyTime);
+    AnalysisCacheReadColumn(r, wl.SlowLatency);
+    AnalysisCacheReadColumn(r, wl.SlowProcess);
+    AnalysisCacheReadColumn(r, wl.SlowThread);
+    AnalysisCacheExpect(r, wl.PoolId.size() == wl.PoolCount && wl.PoolHistogram.size() == wl.PoolCount);
+    AnalysisCacheExpect(r, wl.ThreadProcess.size() == wl.ThreadCount && wl.ThreadIndex.size() == wl.ThreadCount && wl.ThreadPoolId.size() == wl.ThreadCount && wl.ThreadHistogram.size() == wl.ThreadCount);
+    AnalysisCacheExpect(r, wl.SlowReadyTime.size() == wl.SlowCount && wl.SlowLatency.size() == wl.SlowCount && wl.SlowProcess.size() == wl.SlowCount && wl.SlowThread.size() == wl.SlowCount);
+
+    WIN32_OFF_CPU_REPORT &oc = rtev->OffCpu;
+    AnalysisCacheReadHistogram(r, oc.All);
+    AnalysisCacheReadHistograms(r, oc.ReasonHistogram);
+    AnalysisCacheReadColumn(r, oc.ReasonUserTime);
+    oc.ThreadCount     = size_t(AnalysisCacheReadU64(r));
+    AnalysisCacheReadColumn(r, oc.ThreadProcess);
+    AnalysisCacheReadColumn(r, oc.ThreadIndex);
+    AnalysisCacheReadHistograms(r, oc.ThreadHistogram);
+    AnalysisCacheReadColumn(r, oc.ThreadReasonTime);
+    oc.EntryPointCount = size_t(AnalysisCacheReadU64(r));
+    AnalysisCacheReadColumn(r, oc.EntryPoint);
+    AnalysisCacheReadColumn(r, oc.EntryPointTime);
+    AnalysisCacheReadColumn(r, oc.EntryPointReasonTime);
+    AnalysisCacheReadColumn(r, oc.TaskBlockedTime);
+    AnalysisCacheExpect(r, oc.ReasonUserTime.size() == oc.ReasonHistogram.size());
+    AnalysisCacheExpect(r, oc.ThreadProcess.size() == oc.ThreadCount && oc.ThreadIndex.size() == oc.ThreadCount && oc.ThreadHistogram.size() == oc.ThreadCount);
+    AnalysisCacheExpect(r, oc.EntryPoint.size() == oc.EntryPointCount && oc.EntryPointTime.size() == oc.EntryPointCount);
+
+    WIN32_QUEUE_DEPTH &qd = rtev->QueueDepth;
+    qd.EndTime      = AnalysisCacheReadU64(r);
+    qd.TaskCount    = size_t(AnalysisCacheReadU64(r));
+    qd.PendingCount = size_t(AnalysisCacheReadU64(r));
+    qd.SeriesCount  = size_t(AnalysisCacheReadU64(r));
+    AnalysisCacheReadColumn(r, qd.SeriesKind);
+    AnalysisCacheReadColumn(r, qd.SeriesKey);
+    AnalysisCacheReadColumn(r, qd.SeriesStart);
+    AnalysisCacheReadColumn(r, qd.StepTime);
+    AnalysisCacheReadColumn(r, qd.StepDepth);
+    AnalysisCacheReadColumn(r, qd.SeriesMaxDepth);
+    AnalysisCacheReadColumn(r, qd.SeriesMaxTime);
+    AnalysisCacheReadHistograms(r, qd.SeriesDelay);
+    AnalysisCacheReadStepPyramids(r, qd.SeriesLod);
+    AnalysisCacheExpect(r, qd.SeriesKind.size() == qd.SeriesCount && qd.SeriesKey.size() == qd.SeriesCount && (qd.SeriesStart.size() == qd.SeriesCount + 1 || (qd.SeriesCount == 0 && qd.SeriesStart.empty())));
+    AnalysisCacheExpect(r, qd.SeriesMaxDepth.size() == qd.SeriesCount && qd.SeriesMaxTime.size() == qd.SeriesCount && qd.SeriesDelay.size() == qd.SeriesCount && qd.SeriesLod.size() == qd.SeriesCount);
+    AnalysisCacheExpect(r, qd.StepDepth.size() == qd.StepTime.size());
+
+    WIN32_PARALLELISM_PROFILE &par = rtev->Parallelism;
+    par.FirstTime = AnalysisCacheReadU64(r);
+    par.EndTime   = AnalysisCacheReadU64(r);
+    par.PoolCount = size_t(AnalysisCacheReadU64(r));
+    AnalysisCacheReadColumn(r, par.PoolId);
+    AnalysisCacheReadColumn(r, par.PoolWorkerCount);
+    AnalysisCacheReadColumn(r, par.PoolSaturatedTime);
+    AnalysisCacheReadStepFunctions(r, par.PoolRunning);
+    AnalysisCacheExpect(r, par.PoolId.size() == par.PoolCount && par.PoolWorkerCount.size() == par.PoolCount && par.PoolSaturatedTime.size() == par.PoolCount && par.PoolRunning.size() == par.PoolCount);
+
+    WIN32_ZONE_TREE &zt = rtev->ZoneTree;
+    zt.ZoneCount      = size_t(AnalysisCacheReadU64(r));
+    AnalysisCacheReadColumn(r, zt.BeginTime);
+    AnalysisCacheReadColumn(r, zt.EndTime);
+    AnalysisCacheReadColumn(r, zt.ThreadId);
+    AnalysisCacheReadColumn(r, zt.SiteId);
+    AnalysisCacheReadColumn(r, zt.ParentZone);
+    AnalysisCacheReadColumn(r, zt.TaskRow);
+    AnalysisCacheReadColumn(r, zt.Depth);
+    zt.UnmatchedCount = size_t(AnalysisCacheReadU64(r));
+    AnalysisCacheReadColumn(r, zt.SiteZoneCount);
+    AnalysisCacheReadColumn(r, zt.SiteInclusiveTime);
+    AnalysisCacheReadColumn(r, zt.SiteSelfTime);
+    AnalysisCacheExpect(r, zt.BeginTime.size() == zt.ZoneCount && zt.EndTime.size() == zt.ZoneCount && zt.ThreadId.size() == zt.ZoneCount && zt.SiteId.size() == zt.ZoneCount);
+    AnalysisCacheExpect(r, zt.ParentZone.size() == zt.ZoneCount && zt.TaskRow.size() == zt.ZoneCount && zt.Depth.size() == zt.ZoneCount);
+    AnalysisCacheExpect(r, zt.SiteInclusiveTime.size() == zt.SiteZoneCount.size() && zt.SiteSelfTime.size() == zt.SiteZoneCount.size());
+
+    WIN32_TASK_COUNTER_REPORT &cr = rtev->CounterReport;
+    cr.TaskCount       = size_t(AnalysisCacheReadU64(r));
+    cr.UnmatchedCount  = size_t(AnalysisCacheReadU64(r));
+    AnalysisCacheReadColumn(r, cr.TaskCounterMask);
+    AnalysisCacheReadColumn(r, cr.TaskValue);
+    cr.EntryPointCount = size_t(AnalysisCacheReadU64(r));
+    AnalysisCacheReadColumn(r, cr.EntryPoint);
+    AnalysisCacheReadColumn(r, cr.EntryPointTasks);
+    AnalysisCacheReadColumn(r, cr.EntryPointMask);
+    AnalysisCacheReadColumn(r, cr.EntryPointValue);
+    AnalysisCacheExpect(r, cr.TaskValue.size() == cr.TaskCounterMask.size() * WIN32_TASK_COUNTER_COUNT);
+    AnalysisCacheExpect(r, cr.EntryPoint.size() == cr.EntryPointCount && cr.EntryPointTasks.size() == cr.EntryPointCount && cr.EntryPointMask.size() == cr.EntryPointCount);
+    AnalysisCacheExpect(r, cr.EntryPointValue.size() == cr.EntryPointCount * WIN32_TASK_COUNTER_COUNT);
+
+    WIN32_TASK_ALLOC_REPORT &ar = rtev->AllocReport;
+    ar.TaskCount       = size_t(AnalysisCacheReadU64(r));
+    ar.AllocCount      = AnalysisCacheReadU64(r);
+    ar.AllocBytes      = AnalysisCacheReadU64(r);
+    ar.FreeBytes       = AnalysisCacheReadU64(r);
+    ar.EntryPointCount = size_t(AnalysisCacheReadU64(r));
+    AnalysisCacheReadColumn(r, ar.EntryPoint);
+    AnalysisCacheReadColumn(r, ar.EntryPointTasks);
+    AnalysisCacheReadColumn(r, ar.EntryPointAllocs);
+    AnalysisCacheReadColumn(r, ar.EntryPointBytes);
+    AnalysisCacheReadColumn(r, ar.EntryPointFreeBytes);
+    AnalysisCacheExpect(r, ar.EntryPoint.size() == ar.EntryPointCount && ar.EntryPointTasks.size() == ar.EntryPointCount && ar.EntryPointAllocs.size() == ar.EntryPointCount);
+    AnalysisCacheExpect(r, ar.EntryPointBytes.size() == ar.EntryPointCount && ar.EntryPointFreeBytes.size() == ar.EntryPointCount);
+}
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Compute the hash used to detect changes to a trace file. The hash covers the file size and a fixed
+/// number of evenly-spaced pages, including the first and last pages, so that reopening a large trace doesn't
+/// require reading all of it. An edit to pages that aren't sampled is detected by the modification time, which
+/// is stored in the cache alongside the hash.
+/// @param data The start of the trace file data.
+/// @param size The size of the trace file, in bytes.
+/// @return The 64-bit hash value.
+public_function uint64_t
+AnalysisCacheSourceHash
+(
+    uint8_t const *data,
+    size_t         size
+)
+{
+    uint64_t const page_count = (uint64_t(size) + ANALYSIS_CACHE_HASH_PAGE_SIZE - 1) / ANALYSIS_CACHE_HASH_PAGE_SIZE;
+    uint64_t const   samples  = page_count < ANALYSIS_CACHE_HASH_SAMPLES ? page_count : ANALYSIS_CACHE_HASH_SAMPLES;
+    uint64_t             hash = ObjectIndexHash(uint64_t(size) ^ 0x9E3779B97F4A7C15ULL);
+    for (uint64_t i = 0; i < samples; ++i)
+    {   // sample i covers page (i * (page_count - 1)) / (samples - 1), so the first and last pages are always included.
+        uint64_t const page  = samples > 1 ? (i * (page_count - 1)) / (samples - 1) : 0;
+        size_t   const start = size_t(page * ANALYSIS_CACHE_HASH_PAGE_SIZE);
+        size_t   const end   = start + ANALYSIS_CACHE_HASH_PAGE_SIZE < size ? start + ANALYSIS_CACHE_HASH_PAGE_SIZE : size;
+        size_t         j     = start;
+        for ( ; j + sizeof(uint64_t) <= end; j += sizeof(uint64_t))
+        {
+            uint64_t word;
+            memcpy(&word, data + j, sizeof(word));
+            hash = ObjectIndexHash(hash ^ word) + page;
+        }
+        for ( ; j < end; ++j)
+        {
+            hash = ObjectIndexHash(hash ^ data[j]) + page;
+        }
+    }
+    return hash;
+}
+
+/// @summary Build every analysis derived from the loaded columns of a profiler events container. This is the work that
+/// LoadAnalysisCache replaces when a trace is reopened.
+/// @param rtev The profiler events container, which must be fully loaded.
+public_function void
+BuildProfilerAnalyses
+(
+    WIN32_PROFILER_EVENTS *rtev
+)
+{
+    BuildTaskDependencyGraph(&rtev->TaskTable, &rtev->TaskEvents);
+    BuildProcessThreadIntervals(&rtev->ProcessList);
+    BuildTimelineLod(&rtev->TimelineLod, &rtev->ProcessList, &rtev->TaskTable);
+    BuildCriticalPath(&rtev->CriticalPath, &rtev->TaskTable, rtev->TimelineLod.FirstTime, rtev->TimelineLod.BaseShift);
+    BuildCpuTimeline(&rtev->CpuTimeline, &rtev->ProcessList, &rtev->TaskTable, rtev->TimelineLod.FirstTime, rtev->TimelineLod.BaseShift);
+    BuildWakeLatency(&rtev->WakeLatency, &rtev->ProcessList, &rtev->Scheduler, WIN32_WAKE_LATENCY_DEFAULT_THRESHOLD);
+    BuildOffCpuReport(&rtev->OffCpu, &rtev->ProcessList, &rtev->TaskTable);
+    BuildQueueDepth(&rtev->QueueDepth, &rtev->TaskTable, &rtev->Scheduler, rtev->TimelineLod.FirstTime, rtev->TimelineLod.BaseShift);
+    BuildParallelismProfile(&rtev->Parallelism, &rtev->TaskTable, &rtev->Scheduler, 0);
+    BuildZoneTree(&rtev->ZoneTree, &rtev->ZoneEvents, &rtev->TaskTable);
+    BuildTaskCounterReport(&rtev->CounterReport, &rtev->TaskCounters, &rtev->TaskTable);
+    BuildTaskAllocReport(&rtev->AllocReport, &rtev->TaskTable);
+}
+
+/// @summary Write the loaded contents of a profiler events container, and the analyses built from them, to a cache file.
+/// @param rtev The profiler events container, which must be fully loaded and passed to BuildProfilerAnalyses.
+/// @param fp The cache file, opened for writing in binary mode and positioned at the start.
+/// @param source_size The size of the trace file, in bytes.
+/// @param source_time The PLATFORM_FILE_MAPPING::ModifiedTime of the trace file.
+/// @param source_hash The value returned by AnalysisCacheSourceHash for the trace file.
+/// @return true if the cache file was written successfully.
+public_function bool
+WriteAnalysisCache
+(
+    WIN32_PROFILER_EVENTS const *rtev,
+    FILE                          *fp,
+    uint64_t              source_size,
+    uint64_t              source_time,
+    uint64_t              source_hash
+)
+{
+    ANALYSIS_CACHE_WRITER w;
+    ANALYSIS_CACHE_HEADER hdr;
+    w.File   = fp;
+    w.Offset = 0;
+    w.Error  = false;
+
+    // write a placeholder header; the real one is written once everything else has been written.
+    memset(&hdr, 0, sizeof(hdr));
+    AnalysisCacheWrite(&w, &hdr, sizeof(hdr));
+
+    AnalysisCacheWriteU64(&w, rtev->PointerSize);
+    AnalysisCacheWriteU64(&w, rtev->TimerResolution);
+    AnalysisCacheWriteU64(&w, uint64_t(rtev->ClockFrequency.QuadPart));
+    AnalysisCacheWriteU64(&w, rtev->DroppedEventCount);
+    AnalysisCacheWriteU64(&w, rtev->TaskSampleRate);
+    AnalysisCacheWriteStrings(&w, rtev->Strings);
+
+    WIN32_PROCESS_LIST const &plist = rtev->ProcessList;
+    AnalysisCacheWriteU64(&w, plist.ProcessCount);
+    AnalysisCacheWriteColumn(&w, plist.ProcessId);
+    AnalysisCacheWriteColumn(&w, plist.ProcessNameId);
+    AnalysisCacheWriteColumn(&w, plist.ProcessLifetime);
+    AnalysisCacheWriteIndex (&w, plist.ProcessIndex);
+    for (size_t p = 0; p < plist.ProcessCount; ++p)
+    {
+        WIN32_PROCESS_INFO const &pinfo = plist.ProcessInfo[p];
+        AnalysisCacheWriteU64(&w, pinfo.ProcessId);
+        AnalysisCacheWriteU64(&w, pinfo.ThreadCount);
+        AnalysisCacheWriteColumn(&w, pinfo.ThreadId);
+        AnalysisCacheWriteColumn(&w, pinfo.ThreadLifetime);
+        AnalysisCacheWriteIndex (&w, pinfo.ThreadIndex);
+        for (size_t t = 0; t < pinfo.ThreadCount; ++t)
+        {
+            WIN32_THREAD_INFO const &tinfo = pinfo.ThreadInfo[t];
+            AnalysisCacheWriteU64(&w, tinfo.ThreadId);
+            AnalysisCacheWriteU64(&w, tinfo.EntryAddress);
+            AnalysisCacheWriteU64(&w, tinfo.EntryPointName != NULL ? FindInternedString(&rtev->Strings, tinfo.EntryPointName, wcslen(tinfo.EntryPointName)) : WIN32_STRING_ID_NONE);
+            AnalysisCacheWriteU64(&w, tinfo.ReadyCount);
+            AnalysisCacheWriteColumn(&w, tinfo.ReadyTimes);
+            AnalysisCacheWriteU64(&w, tinfo.SwitchInCount);
+            AnalysisCacheWriteColumn(&w, tinfo.SwitchInTime);
+            AnalysisCacheWriteColumn(&w, tinfo.SwitchInData);
+            AnalysisCacheWriteU64(&w, tinfo.SwitchOutCount);
+            AnalysisCacheWriteColumn(&w, tinfo.SwitchOutTime);
+            AnalysisCacheWriteColumn(&w, tinfo.SwitchOutData);
+            AnalysisCacheWriteIntervals(&w, tinfo.Intervals);
+        }
+        AnalysisCacheWriteU64(&w, pinfo.ImageCount);
+        AnalysisCacheWriteColumn(&w, pinfo.ImageBaseAddress);
+        AnalysisCacheWriteColumn(&w, pinfo.ImagePathId);
+        AnalysisCacheWriteColumn(&w, pinfo.ImageLifetime);
+        AnalysisCacheWriteIndex (&w, pinfo.ImageAddressIndex);
+        AnalysisCacheWriteIndex (&w, pinfo.ImagePathIndex);
+    }
+
+    WIN32_TASK_EVENT_LIST const &events = rtev->TaskEvents;
+    AnalysisCacheWriteU64(&w, events.EventCount);
+    AnalysisCacheWriteColumn(&w, events.EventTime);
+    AnalysisCacheWriteColumn(&w, events.EventType);
+    AnalysisCacheWriteColumn(&w, events.TaskId);
+    AnalysisCacheWriteColumn(&w, events.ThreadId);
+    AnalysisCacheWriteColumn(&w, events.SourceIndex);
+    AnalysisCacheWriteColumn(&w, events.ParentId);
+    AnalysisCacheWriteColumn(&w, events.EntryPoint);
+    AnalysisCacheWriteColumn(&w, events.DependencyStart);
+    AnalysisCacheWriteColumn(&w, events.Dependencies);
+
+    WIN32_TASK_TABLE const &table = rtev->TaskTable;
+    AnalysisCacheWriteU64(&w, table.TaskCount);
+    AnalysisCacheWriteColumn(&w, table.TaskId);
+    AnalysisCacheWriteColumn(&w, table.ParentId);
+    AnalysisCacheWriteColumn(&w, table.EntryPoint);
+    AnalysisCacheWriteColumn(&w, table.SourceIndex);
+    AnalysisCacheWriteColumn(&w, table.WorkerThreadId);
+    AnalysisCacheWriteColumn(&w, table.DefineTime);
+    AnalysisCacheWriteColumn(&w, table.ReadyTime);
+    AnalysisCacheWriteColumn(&w, table.LaunchTime);
+    AnalysisCacheWriteColumn(&w, table.FinishTime);
+    AnalysisCacheWriteColumn(&w, table.AllocCount);
+    AnalysisCacheWriteColumn(&w, table.AllocBytes);
+    AnalysisCacheWriteColumn(&w, table.FreeBytes);
+    AnalysisCacheWriteColumn(&w, table.DefineSortedTime);
+    AnalysisCacheWriteColumn(&w, table.DefineSortedRow);
+    AnalysisCacheWriteColumn(&w, table.ReadySortedTime);
+    AnalysisCacheWriteColumn(&w, table.ReadySortedRow);
+    AnalysisCacheWriteColumn(&w, table.LaunchSortedTime);
+    AnalysisCacheWriteColumn(&w, table.LaunchSortedRow);
+    AnalysisCacheWriteColumn(&w, table.FinishSortedTime);
+    AnalysisCacheWriteColumn(&w, table.FinishSortedRow);
+    AnalysisCacheWriteIndex (&w, table.TaskIndex);
+    AnalysisCacheWriteColumn(&w, table.DependencyStart);
+    AnalysisCacheWriteColumn(&w, table.DependencyRow);
+    AnalysisCacheWriteColumn(&w, table.SuccessorStart);
+    AnalysisCacheWriteColumn(&w, table.SuccessorRow);
+    AnalysisCacheWriteColumn(&w, table.ParentRow);
+    AnalysisCacheWriteU64(&w, table.UnresolvedCount);
+
+    WIN32_SCHEDULER_INFO const &sched = rtev->Scheduler;
+    AnalysisCacheWriteU64(&w, sched.ComputePoolSize);
+    AnalysisCacheWriteU64(&w, sched.GeneralPoolSize);
+    AnalysisCacheWriteU64(&w, sched.WorkerCount);
+    AnalysisCacheWriteColumn(&w, sched.WorkerThreadId);
+    AnalysisCacheWriteColumn(&w, sched.WorkerPoolId);
+    AnalysisCacheWriteColumn(&w, sched.WorkerPoolIndex);
+    AnalysisCacheWriteU64(&w, sched.SourceCount);
+    AnalysisCacheWriteColumn(&w, sched.SourceIndex);
+    AnalysisCacheWriteColumn(&w, sched.SourceThreadId);
+    for (size_t i = 0; i < sched.SourceCount; ++i)
+    {
+        AnalysisCacheWriteBlock(&w, sched.SourceName[i].data(), sched.SourceName[i].size());
+    }
+
+    WIN32_ZONE_EVENT_LIST const &zones = rtev->ZoneEvents;
+    AnalysisCacheWriteU64(&w, zones.EventCount);
+    AnalysisCacheWriteColumn(&w, zones.EventTime);
+    AnalysisCacheWriteColumn(&w, zones.ThreadId);
+    AnalysisCacheWriteColumn(&w, zones.SiteId);
+    AnalysisCacheWriteColumn(&w, zones.EventType);
+    AnalysisCacheWriteU64(&w, zones.SiteCount);
+    AnalysisCacheWriteColumn(&w, zones.SiteLine);
+    for (size_t i = 0; i < zones.SiteCount; ++i)
+    {
+        AnalysisCacheWriteBlock(&w, zones.SiteName[i].data(), zones.SiteName[i].size());
+        AnalysisCacheWriteBlock(&w, zones.SiteFile[i].data(), zones.SiteFile[i].size());
+        AnalysisCacheWriteBlock(&w, zones.SiteFunction[i].data(), zones.SiteFunction[i].size());
+    }
+
+    WIN32_TASK_COUNTER_LIST const &counters = rtev->TaskCounters;
+    AnalysisCacheWriteU64(&w, counters.SampleCount);
+    AnalysisCacheWriteColumn(&w, counters.FinishTime);
+    AnalysisCacheWriteColumn(&w, counters.TaskId);
+    AnalysisCacheWriteColumn(&w, counters.ThreadId);
+    AnalysisCacheWriteColumn(&w, counters.CounterMask);
+    AnalysisCacheWriteColumn(&w, counters.Value);
+    AnalysisCacheWriteAnalyses(&w, rtev);
+
+    // everything was written; fill in the header so the cache becomes valid.
+    hdr.Magic        = ANALYSIS_CACHE_MAGIC;
+    hdr.Version      = ANALYSIS_CACHE_VERSION;
+    hdr.WideCharSize = uint8_t(sizeof(WCHAR));
+    hdr.SizeTypeSize = uint8_t(sizeof(size_t));
+    hdr.FileSize     = w.Offset;
+    hdr.SourceSize   = source_size;
+    hdr.SourceTime   = source_time;
+    hdr.SourceHash   = source_hash;
+    if (w.Error || fflush(fp) != 0 || fseek(fp, 0, SEEK_SET) != 0)
+    {   // leave the zeroed header in place, so the file is never mistaken for a valid cache.
+        return false;
+    }
+    w.Offset = 0;
+    AnalysisCacheWrite(&w, &hdr, sizeof(hdr));
+    return !w.Error && fflush(fp) == 0;
+}
+
+/// @summary Load the contents of a profiler events container, and the analyses built from them, from a cache file. The
+/// container must be freshly allocated. Every column of the container becomes a view of the cache file data, and interned
+/// strings point into it, so the data must remain valid until the container is deleted. The data must be writable, or a
+/// copy-on-write mapping, because elements of a view may be modified in place.
+/// @param rtev The profiler events container to populate.
+/// @param data The start of the cache file data, aligned to ANALYSIS_CACHE_ALIGNMENT. Typically a mapped view of the file.
+/// @param size The size of the cache file, in bytes.
+/// @param source_size The size of the trace file, in bytes.
+/// @param source_time The PLATFORM_FILE_MAPPING::ModifiedTime of the trace file.
+/// @param source_hash The value returned by AnalysisCacheSourceHash for the trace file.
+/// @return true if the cache was valid for the trace file and was loaded. If false, the container must be discarded.
+public_function bool
+LoadAnalysisCache
+(
+    WIN32_PROFILER_EVENTS *rtev,
+    uint8_t const         *data,
+    size_t                 size,
+    uint64_t        source_size,
+    uint64_t        source_time,
+    uint64_t        source_hash
+)
+{
+    ANALYSIS_CACHE_HEADER hdr;
+    ANALYSIS_CACHE_READER r;
+    if (data == NULL || size < sizeof(hdr) || (uintptr_t(data) & (ANALYSIS_CACHE_ALIGNMENT - 1)) != 0) return false;
+    memcpy(&hdr, data, sizeof(hdr));
+    if (hdr.Magic != ANALYSIS_CACHE_MAGIC || hdr.Version != ANALYSIS_CACHE_VERSION || hdr.WideCharSize != sizeof(WCHAR) || hdr.SizeTypeSize != sizeof(size_t) || hdr.FileSize != size)
+    {   // the cache is incomplete, or was written by a different build of the visualizer.
+        return false;
+    }
+    if (hdr.SourceSize != source_size || hdr.SourceTime != source_time || hdr.SourceHash != source_hash)
+    {   // the trace file has changed since the cache was written.
+        return false;
+    }
+    r.Base   = data;
+    r.Offset = sizeof(hdr);
+    r.Size   = size;
+    r.Error  = false;
+
+    rtev->PointerSize       = size_t(AnalysisCacheReadU64(&r));
+    rtev->TimerResolution   = AnalysisCacheReadU64(&r);
+    rtev->ClockFrequency.QuadPart = int64_t(AnalysisCacheReadU64(&r));
+    rtev->ClockScale        = rtev->ClockFrequency.QuadPart > 0 ? TimestampScale(uint64_t(rtev->ClockFrequency.QuadPart), 1000000000ULL) : 0;
+    rtev->DroppedEventCount = AnalysisCacheReadU64(&r);
+    rtev->TaskSampleRate    = uint32_t(AnalysisCacheReadU64(&r));
+    AnalysisCacheReadStrings(&r, rtev->Strings);
+
+    WIN32_PROCESS_LIST &plist = rtev->ProcessList;
+    plist.ProcessCount = size_t(AnalysisCacheReadU64(&r));
+    AnalysisCacheReadColumn(&r, plist.ProcessId);
+    AnalysisCacheReadColumn(&r, plist.ProcessNameId);
+    AnalysisCacheReadColumn(&r, plist.ProcessLifetime);
+    AnalysisCacheReadIndex (&r, plist.ProcessIndex);
+    if (plist.ProcessId.size() != plist.ProcessCount || plist.ProcessNameId.size() != plist.ProcessCount || plist.ProcessLifetime.size() != plist.ProcessCount)
+    {   // the process list is inconsistent.
+        return false;
+    }
+    plist.ProcessInfo.resize(plist.ProcessCount);
+    for (size_t p = 0; p < plist.ProcessCount && !r.Error; ++p)
+    {
+        WIN32_PROCESS_INFO &pinfo = plist.ProcessInfo[p];
+        pinfo.ProcessId   = uint32_t(AnalysisCacheReadU64(&r));
+        pinfo.Reserved    = 0;
+        pinfo.Executable  = InternedString(&rtev->Strings, plist.ProcessNameId[p]);
+        pinfo.ThreadCount = size_t(AnalysisCacheReadU64(&r));
+        AnalysisCacheReadColumn(&r, pinfo.ThreadId);
+        AnalysisCacheReadColumn(&r, pinfo.ThreadLifetime);
+        AnalysisCacheReadIndex (&r, pinfo.ThreadIndex);
+        if (pinfo.ThreadId.size() != pinfo.ThreadCount || pinfo.ThreadLifetime.size() != pinfo.ThreadCount)
+        {   // the thread list is inconsistent.
+            return false;
+        }
+        pinfo.ThreadInfo.resize(pinfo.ThreadCount);
+        for (size_t t = 0; t < pinfo.ThreadCount && !r.Error; ++t)
+        {
+            WIN32_THREAD_INFO &tinfo = pinfo.ThreadInfo[t];
+            tinfo.ThreadId       = uint32_t(AnalysisCacheReadU64(&r));
+            tinfo.EntryAddress   = AnalysisCacheReadU64(&r);
+            tinfo.EntryPointName = InternedString(&rtev->Strings, string_id_t(AnalysisCacheReadU64(&r)));
+            tinfo.ReadyCount     = size_t(AnalysisCacheReadU64(&r));
+            AnalysisCacheReadColumn(&r, tinfo.ReadyTimes);
+            tinfo.SwitchInCount  = size_t(AnalysisCacheReadU64(&r));
+            AnalysisCacheReadColumn(&r, tinfo.SwitchInTime);
+            AnalysisCacheReadColumn(&r, tinfo.SwitchInData);
+            tinfo.SwitchOutCount = size_t(AnalysisCacheReadU64(&r));
+            AnalysisCacheReadColumn(&r, tinfo.SwitchOutTime);
+            AnalysisCacheReadColumn(&r, tinfo.SwitchOutData);
+            AnalysisCacheReadIntervals(&r, tinfo.Intervals);
+        }
+        pinfo.ImageCount = size_t(AnalysisCacheReadU64(&r));
+        AnalysisCacheReadColumn(&r, pinfo.ImageBaseAddress);
+        AnalysisCacheReadColumn(&r, pinfo.ImagePathId);
+        AnalysisCacheReadColumn(&r, pinfo.ImageLifetime);
+        AnalysisCacheReadIndex (&r, pinfo.ImageAddressIndex);
+        AnalysisCacheReadIndex (&r, pinfo.ImagePathIndex);
+        if (pinfo.ImageBaseAddress.size() != pinfo.ImageCount || pinfo.ImagePathId.size() != pinfo.ImageCount || pinfo.ImageLifetime.size() != pinfo.ImageCount)
+        {   // the image list is inconsistent.
+            return false;
+        }
+        pinfo.ImageInfo.resize(pinfo.ImageCount);
+        for (size_t i = 0; i < pinfo.ImageCount && !r.Error; ++i)
+        {
+            pinfo.ImageInfo[i].ImagePath = InternedString(&rtev->Strings, pinfo.ImagePathId[i]);
+        }
+    }
+
+    WIN32_TASK_EVENT_LIST &events = rtev->TaskEvents;
+    events.EventCount = size_t(AnalysisCacheReadU64(&r));
+    AnalysisCacheReadColumn(&r, events.EventTime);
+    AnalysisCacheReadColumn(&r, events.EventType);
+    AnalysisCacheReadColumn(&r, events.TaskId);
+    AnalysisCacheReadColumn(&r, events.ThreadId);
+    AnalysisCacheReadColumn(&r, events.SourceIndex);
+    AnalysisCacheReadColumn(&r, events.ParentId);
+    AnalysisCacheReadColumn(&r, events.EntryPoint);
+    AnalysisCacheReadColumn(&r, events.DependencyStart);
+    AnalysisCacheReadColumn(&r, events.Dependencies);
+    if (events.EventTime.size() != events.EventCount || events.DependencyStart.size() != events.EventCount + 1)
+    {   // the event list is inconsistent.
+        return false;
+    }
+
+    WIN32_TASK_TABLE &table = rtev->TaskTable;
+    table.TaskCount = size_t(AnalysisCacheReadU64(&r));
+    AnalysisCacheReadColumn(&r, table.TaskId);
+    AnalysisCacheReadColumn(&r, table.ParentId);
+    AnalysisCacheReadColumn(&r, table.EntryPoint);
+    AnalysisCacheReadColumn(&r, table.SourceIndex);
+    AnalysisCacheReadColumn(&r, table.WorkerThreadId);
+    AnalysisCacheReadColumn(&r, table.DefineTime);
+    AnalysisCacheReadColumn(&r, table.ReadyTime);
+    AnalysisCacheReadColumn(&r, table.LaunchTime);
+    AnalysisCacheReadColumn(&r, table.FinishTime);
+    AnalysisCacheReadColumn(&r, table.AllocCount);
+    AnalysisCacheReadColumn(&r, table.AllocBytes);
+    AnalysisCacheReadColumn(&r, table.FreeBytes);
+    AnalysisCacheReadColumn(&r, table.DefineSortedTime);
+    AnalysisCacheReadColumn(&r, table.DefineSortedRow);
+    AnalysisCacheReadColumn(&r, table.ReadySortedTime);
+    AnalysisCacheReadColumn(&r, table.ReadySortedRow);
+    AnalysisCacheReadColumn(&r, table.LaunchSortedTime);
+    AnalysisCacheReadColumn(&r, table.LaunchSortedRow);
+    AnalysisCacheReadColumn(&r, table.FinishSortedTime);
+    AnalysisCacheReadColumn(&r, table.FinishSortedRow);
+    AnalysisCacheReadIndex (&r, table.TaskIndex);
+    AnalysisCacheReadColumn(&r, table.DependencyStart);
+    AnalysisCacheReadColumn(&r, table.DependencyRow);
+    AnalysisCacheReadColumn(&r, table.SuccessorStart);
+    AnalysisCacheReadColumn(&r, table.SuccessorRow);
+    AnalysisCacheReadColumn(&r, table.ParentRow);
+    table.UnresolvedCount = size_t(AnalysisCacheReadU64(&r));
+    if (table.TaskId.size() != table.TaskCount || table.FinishTime.size() != table.TaskCount || table.AllocCount.size() != table.TaskCount || table.AllocBytes.size() != table.TaskCount || table.FreeBytes.size() != table.TaskCount ||
+       (table.DependencyStart.size() != table.TaskCount + 1 && !table.DependencyStart.empty()) || (table.SuccessorStart.size() != table.TaskCount + 1 && !table.SuccessorStart.empty()))
+    {   // the task table is inconsistent.
+        return false;
+    }
+
+    WIN32_SCHEDULER_INFO &sched = rtev->Scheduler;
+    sched.ComputePoolSize = uint32_t(AnalysisCacheReadU64(&r));
+    sched.GeneralPoolSize = uint32_t(AnalysisCacheReadU64(&r));
+    sched.WorkerCount     = size_t(AnalysisCacheReadU64(&r));
+    AnalysisCacheReadColumn(&r, sched.WorkerThreadId);
+    AnalysisCacheReadColumn(&r, sched.WorkerPoolId);
+    AnalysisCacheReadColumn(&r, sched.WorkerPoolIndex);
+    sched.SourceCount     = size_t(AnalysisCacheReadU64(&r));
+    AnalysisCacheReadColumn(&r, sched.SourceIndex);
+    AnalysisCacheReadColumn(&r, sched.SourceThreadId);
+    if (sched.SourceIndex.size() != sched.SourceCount)
+    {   // the task source list is inconsistent.
+        return false;
+    }
+    sched.SourceName.resize(sched.SourceCount);
+    for (size_t i = 0; i < sched.SourceCount && !r.Error; ++i)
+    {
+        size_t         len  = 0;
+        uint8_t const *name = AnalysisCacheReadBlock(&r, 1, len);
+        sched.SourceName[i].assign((char const*) name, len);
+    }
+
+    WIN32_ZONE_EVENT_LIST &zones = rtev->ZoneEvents;
+    zones.EventCount = size_t(AnalysisCacheReadU64(&r));
+    AnalysisCacheReadColumn(&r, zones.EventTime);
+    AnalysisCacheReadColumn(&r, zones.ThreadId);
+    AnalysisCacheReadColumn(&r, zones.SiteId);
+    AnalysisCacheReadColumn(&r, zones.EventType);
+    zones.SiteCount  = size_t(AnalysisCacheReadU64(&r));
+    AnalysisCacheReadColumn(&r, zones.SiteLine);
+    if (zones.EventTime.size() != zones.EventCount || zones.ThreadId.size() != zones.EventCount || zones.SiteId.size() != zones.EventCount || zones.EventType.size() != zones.EventCount || zones.SiteLine.size() != zones.SiteCount)
+    {   // the zone event list is inconsistent.
+        return false;
+    }
+    zones.SiteName.resize(zones.SiteCount);
+    zones.SiteFile.resize(zones.SiteCount);
+    zones.SiteFunction.resize(zones.SiteCount);
+    for (size_t i = 0; i < zones.SiteCount && !r.Error; ++i)
+    {
+        size_t         len  = 0;
+        uint8_t const *str  = AnalysisCacheReadBlock(&r, 1, len);
+        zones.SiteName[i].assign((char const*) str, len);
+        str = AnalysisCacheReadBlock(&r, 1, len);
+        zones.SiteFile[i].assign((char const*) str, len);
+        str = AnalysisCacheReadBlock(&r, 1, len);
+        zones.SiteFunction[i].assign((char const*) str, len);
+    }
+
+    WIN32_TASK_COUNTER_LIST &counters = rtev->TaskCounters;
+    counters.SampleCount = size_t(AnalysisCacheReadU64(&r));
+    AnalysisCacheReadColumn(&r, counters.FinishTime);
+    AnalysisCacheReadColumn(&r, counters.TaskId);
+    AnalysisCacheReadColumn(&r, counters.ThreadId);
+    AnalysisCacheReadColumn(&r, counters.CounterMask);
+    AnalysisCacheReadColumn(&r, counters.Value);
+    if (counters.FinishTime.size() != counters.SampleCount || counters.TaskId.size() != counters.SampleCount || counters.ThreadId.size() != counters.SampleCount || counters.CounterMask.size() != counters.SampleCount || counters.Value.size() != counters.SampleCount * WIN32_TASK_COUNTER_COUNT)
+    {   // the task counter list is inconsistent.
+        return false;
+    }
+    AnalysisCacheReadAnalyses(&r, rtev);
+    return !r.Error;
+}
@@ -0,0 +1,1259 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implement micro-benchmarks for the portable parts of the profiler.
+/// Run without arguments to execute all benchmarks.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////////
+//   Preprocessor   //
+////////////////////*/
+#define UNUSED(x)            (void)(x)
+#define public_function      static
+#define internal_function    static
+#define global_variable      static
+
+#ifndef ENABLE_PROFILER
+#define ENABLE_PROFILER      1
+#endif
+
+#ifndef PROFILER_NATIVE_ALLOC_HOOKS
+#define PROFILER_NATIVE_ALLOC_HOOKS 1
+#endif
+
+/*////////////////
+//   Includes   //
+////////////////*/
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+#include "profiler.h"
+#include "ptrace.h"
+#include "platform.cc"
+#include "visualizer_types.h"
+#include "ptrace_codec.cc"
+#include "memory_arena.cc"
+#include "string_table.cc"
+#include "object_index.cc"
+#include "thread_intervals.cc"
+#include "event_decoder.cc"
+#include "task_table.cc"
+#include "lod_pyramid.cc"
+#include "cpu_timeline.cc"
+#include "latency_histogram.cc"
+#include "wake_latency.cc"
+#include "off_cpu.cc"
+#include "queue_depth.cc"
+#include "step_function.cc"
+#include "parallelism.cc"
+#include "zone_tree.cc"
+#include "task_counters.cc"
+#include "critical_path.cc"
+#include "schedule_replay.cc"
+#include "analysis_cache.cc"
+#include "snapshot.cc"
+#include "ptrace_loader.cc"
+#include "profiler_native.cc"
+
+/*//////////////////
+//   Data Types   //
+//////////////////*/
+/// @summary Define the per-thread arguments and results of the event emission benchmark.
+struct EMIT_BENCHMARK_THREAD
+{
+    uint32_t                 PoolIndex;          /// The zero-based index of the simulated worker thread.
+    uint32_t                 TaskCount;          /// The number of tasks to simulate.
+    std::atomic<uint32_t>   *StartFlag;          /// Set to non-zero by the main thread to start all workers at once.
+    uint64_t                 ElapsedTicks;       /// On return, the number of timestamp ticks spent emitting events.
+};
+
+/// @summary Define the data passed to the reader thread of the snapshot benchmark.
+struct SNAPSHOT_BENCHMARK_READER
+{
+    WIN32_SNAPSHOT_PUBLISHER *Publisher;          /// The publisher being written by the main thread.
+    std::atomic<uint32_t>    *DoneFlag;           /// Set to non-zero by the main thread once all events have been published.
+    uint64_t                  AcquireCount;       /// On return, the number of snapshots acquired.
+    uint64_t                  EpochCount;         /// On return, the number of distinct epochs observed.
+    uint64_t                  Checksum;           /// On return, a value derived from query results so the queries aren't optimized away.
+};
+
+/*//////////////////////////
+//   Internal Functions   //
+//////////////////////////*/
+/// @summary Implement the entry point of a simulated worker thread that emits task definition, ready, launch and finish events.
+/// @param argp A pointer to the EMIT_BENCHMARK_THREAD for the thread.
+internal_function void
+EmitBenchmarkThreadMain
+(
+    void *argp
+)
+{
+    EMIT_BENCHMARK_THREAD *args = (EMIT_BENCHMARK_THREAD*) argp;
+    RegisterWorkerThread(PlatformThreadId(), 0, args->PoolIndex);
+    while (args->StartFlag->load(std::memory_order_acquire) == 0)
+    {   // spin until all threads have started.
+    }
+    uint64_t start = PlatformTimestamp();
+    for (uint32_t i = 0; i < args->TaskCount; ++i)
+    {
+        uint32_t task_id = (args->PoolIndex << 24) | (i & 0x00FFFFFF);
+        uint32_t dep_id  = task_id - 1;
+        MarkTaskDefinition(task_id, INVALID_TASK_ID, (void*) &EmitBenchmarkThreadMain, args->PoolIndex, i > 0 ? 1 : 0, &dep_id);
+        MarkTaskReadyToRun(task_id, args->PoolIndex);
+        MarkTaskLaunch(task_id);
+        MarkTaskFinish(task_id);
+    }
+    args->ElapsedTicks = PlatformTimestamp() - start;
+}
+
+/// @summary Implement the reader thread of the snapshot benchmark, which repeatedly acquires the latest snapshot and queries its second half, as the user interface would.
+/// @param argp A pointer to a SNAPSHOT_BENCHMARK_READER.
+internal_function void
+SnapshotBenchmarkReaderMain
+(
+    void *argp
+)
+{
+    SNAPSHOT_BENCHMARK_READER *args = (SNAPSHOT_BENCHMARK_READER*) argp;
+    uint64_t                  epoch = 0;
+    while (args->DoneFlag->load(std::memory_order_acquire) == 0)
+    {
+        WIN32_PROFILER_SNAPSHOT const *snap = AcquireProfilerSnapshot(args->Publisher, 0);
+        size_t lower = 0, upper = 0, count = 0;
+        if (snap != NULL)
+        {
+            if (snap->Epoch != epoch) { epoch = snap->Epoch; args->EpochCount++; }
+            if (FindSnapshotEventsInTimeRange(snap, snap->FirstTime + (snap->LastTime - snap->FirstTime) / 2, snap->LastTime, lower, upper, count))
+                args->Checksum += SnapshotEventTime(snap, upper) + count;
+        }
+        ReleaseProfilerSnapshot(args->Publisher, 0);
+        args->AcquireCount++;
+    }
+}
+
+/// @summary Measure the cost of appending task events to snapshot chunks and publishing snapshots while a reader thread queries them concurrently.
+/// @param event_count The number of events to append.
+/// @param publish_every The number of events appended between snapshots.
+internal_function void
+BenchmarkSnapshotPublish
+(
+    uint32_t   event_count,
+    uint32_t publish_every
+)
+{
+    WIN32_SNAPSHOT_PUBLISHER *pub = new WIN32_SNAPSHOT_PUBLISHER();
+    SNAPSHOT_BENCHMARK_READER args;
+    std::atomic<uint32_t>     done(0);
+    PLATFORM_THREAD           reader;
+    InitSnapshotPublisher(pub, 0);
+    args.Publisher    = pub;
+    args.DoneFlag     =&done;
+    args.AcquireCount = 0;
+    args.EpochCount   = 0;
+    args.Checksum     = 0;
+    PlatformCreateThread(&reader, SnapshotBenchmarkReaderMain, &args);
+
+    uint64_t start = PlatformTimestamp();
+    for (uint32_t i = 0; i < event_count; ++i)
+    {
+        SnapshotAppendTaskEvent(pub, uint8_t(i & 3), uint64_t(i) * 100, task_id_t(i >> 2), 1);
+        if ((i + 1) % publish_every == 0)
+            PublishProfilerSnapshot(pub, i, 0.0f, 1, 1, i >> 2, false);
+    }
+    PublishProfilerSnapshot(pub, event_count, 1.0f, 1, 1, event_count >> 2, true);
+    uint64_t ticks = PlatformTimestamp() - start;
+    done.store(1, std::memory_order_release);
+    PlatformJoinThread(reader);
+
+    double ns = double(ticks) * 1000000000.0 / double(PlatformTimestampFrequency());
+    printf("snapshot publish: %10u events, %6.2f ns/event, %6llu epochs, reader saw %6llu epochs in %llu acquires (checksum %llu)\n",
+        event_count, ns / double(event_count), (unsigned long long) pub->Current.load()->Epoch, (unsigned long long) args.EpochCount,
+        (unsigned long long) args.AcquireCount, (unsigned long long) args.Checksum);
+    DeleteSnapshotPublisher(pub);
+    delete pub;
+}
+
+/// @summary Measure the cost of reopening a .ptrace file and its analyses from the analysis cache, including hashing the trace file.
+/// @param data The contents of the .ptrace file.
+/// @param size The size of the .ptrace file, in bytes.
+internal_function void
+BenchmarkAnalysisCache
+(
+    uint8_t const *data,
+    size_t         size
+)
+{
+    WIN32_PROFILER_EVENTS *rtev = new WIN32_PROFILER_EVENTS();
+    FILE                    *fp = fopen("benchmark.pcache", "w+b");
+    bool                 parsed = fp != NULL && LoadPtraceEvents(rtev, data, size, 0);
+    if (parsed)
+    {   // the cache holds the analyses too, which are what a cache hit avoids rebuilding.
+        BuildProfilerAnalyses(rtev);
+    }
+    if (!parsed || !WriteAnalysisCache(rtev, fp, size, 0, AnalysisCacheSourceHash(data, size)))
+    {
+        fprintf(stderr, "ERROR: Unable to write the analysis cache.\n");
+        if (fp != NULL) fclose(fp);
+        remove("benchmark.pcache");
+        delete rtev;
+        return;
+    }
+    delete rtev;
+
+    PLATFORM_FILE_MAPPING map;
+    uint64_t start  = PlatformTimestamp();
+    bool     loaded = false;
+    size_t   bytes  = 0;
+    rtev = new WIN32_PROFILER_EVENTS();
+    if (PlatformMapFile(fp, &map, true))
+    {   // the loaded columns view the mapping, so it's released after the container.
+        bytes  = map.Size;
+        loaded = LoadAnalysisCache(rtev, map.Data, map.Size, size, 0, AnalysisCacheSourceHash(data, size));
+    }
+    uint64_t ticks  = PlatformTimestamp() - start;
+    double   sec    = double(ticks) / double(PlatformTimestampFrequency());
+    printf("cache load: %10llu events, %6.2f MB cache, %8.2f ms, %7.2f M events/sec%s\n",
+        (unsigned long long) rtev->TaskEvents.EventCount, double(bytes) / (1024.0 * 1024.0), sec * 1000.0, double(rtev->TaskEvents.EventCount) / (sec * 1000000.0), loaded ? "" : " (FAILED)");
+    fclose(fp);
+    delete rtev;
+    PlatformUnmapFile(&map);
+    remove("benchmark.pcache");
+}
+
+/// @summary Measure the per-call cost of the system timer and the cycle counter used to timestamp native events.
+/// @param read_count The number of times each clock is read.
+internal_function void
+BenchmarkTimestampRead
+(
+    uint32_t read_count
+)
+{
+    uint64_t sum   = 0;
+    uint64_t start = PlatformTimestamp();
+    for (uint32_t i = 0; i < read_count; ++i)
+    {
+        sum += PlatformTimestamp();
+    }
+    uint64_t timer_ticks = PlatformTimestamp() - start;
+
+    start = PlatformTimestamp();
+    for (uint32_t i = 0; i < read_count; ++i)
+    {
+        sum += PlatformCycleCounter();
+    }
+    uint64_t cycle_ticks = PlatformTimestamp() - start;
+
+    double const freq = double(PlatformTimestampFrequency());
+    printf("timestamp read: %10u reads, system timer %6.2f ns/read, cycle counter %6.2f ns/read (invariant %s, checksum %llu)\n", read_count,
+        double(timer_ticks) * 1000000000.0 / (freq * double(read_count)), double(cycle_ticks) * 1000000000.0 / (freq * double(read_count)),
+        PlatformHasInvariantCycleCounter() ? "yes" : "no", (unsigned long long) (sum & 0xFFFF));
+}
+
+/// @summary Measure the per-event cost of MarkTask* calls on the native backend with a given number of concurrent threads.
+/// @param thread_count The number of simulated worker threads.
+/// @param task_count The number of tasks simulated by each thread.
+/// @param load_thread_max The largest number of threads used to load the resulting trace. Loads are timed for each power of two up to this value.
+/// @param sample_rate The value of PROFILER_CONFIG::TaskSampleRate. Specify 1 to record every task.
+/// @param task_counters The value of PROFILER_CONFIG::TaskCounters. Specify non-zero to read hardware counters around every task.
+internal_function void
+BenchmarkNativeEmit
+(
+    uint32_t    thread_count,
+    uint32_t      task_count,
+    uint32_t load_thread_max,
+    uint32_t     sample_rate,
+    uint32_t   task_counters
+)
+{
+    PROFILER_CONFIG config;
+    memset(&config, 0, sizeof(config));
+    config.ApplicationName      = "benchmarks";
+    config.ProfilerMajorVersion = PROFILER_VERSION_MAJOR;
+    config.ProfilerMinorVersion = PROFILER_VERSION_MINOR;
+    config.ComputePoolSize      = thread_count;
+    config.TraceFilePath        = "benchmark.ptrace";
+    config.ThreadBufferSize     = 1 << 20;
+    config.TaskSampleRate       = sample_rate;
+    config.TaskCounters         = task_counters;
+    if (InitializeProfiler(&config) != PROFILER_RESULT_SUCCESS)
+    {
+        fprintf(stderr, "ERROR: Unable to initialize the profiler.\n");
+        return;
+    }
+
+    std::atomic<uint32_t>             start_flag(0);
+    std::vector<EMIT_BENCHMARK_THREAD> args(thread_count);
+    std::vector<PLATFORM_THREAD>    threads(thread_count);
+    for (uint32_t i = 0; i < thread_count; ++i)
+    {
+        args[i].PoolIndex    = i;
+        args[i].TaskCount    = task_count;
+        args[i].StartFlag    =&start_flag;
+        args[i].ElapsedTicks = 0;
+        PlatformCreateThread(&threads[i], EmitBenchmarkThreadMain, &args[i]);
+    }
+    start_flag.store(1, std::memory_order_release);
+
+    uint64_t total_ticks = 0;
+    for (uint32_t i = 0; i < thread_count; ++i)
+    {
+        PlatformJoinThread(threads[i]);
+        total_ticks += args[i].ElapsedTicks;
+    }
+    uint64_t drops    = 0;
+    uint32_t counting = 0;
+    for (uint32_t i = 0, n = ProfilerNative.BufferCount.load(); i < n; ++i)
+    {
+        drops += ProfilerNative.Buffers[i]->DropCount.load();
+        if (ProfilerNative.Buffers[i]->Counters.CounterMask != 0) counting++;
+    }
+    ShutdownProfiler();
+
+    std::vector<uint8_t> file_data;
+    long  file_size = 0;
+    FILE *fp = fopen("benchmark.ptrace", "rb");
+    if (fp != NULL)
+    {   // report the encoded size, which is compared against the size of the in-memory records.
+        fseek(fp, 0, SEEK_END);
+        file_size = ftell(fp);
+        fseek(fp, 0, SEEK_SET);
+        file_data.resize(size_t(file_size));
+        if (file_size > 0 && fread(&file_data[0], 1, file_data.size(), fp) != file_data.size()) file_data.clear();
+        fclose(fp);
+    }
+
+    double const events = double(thread_count) * double(task_count) * 4.0;
+    double const ns     = double(total_ticks) * 1000000000.0 / double(PlatformTimestampFrequency());
+    double const bpe    = double(file_size) / ((events / double(sample_rate)) - double(drops));
+    printf("native emit: %2u threads, %10.0f events, 1 in %2u tasks, %6.2f ns/event/thread, %llu dropped, %5.2f bytes/event (%4.1fx smaller than records)\n",
+        thread_count, events, sample_rate, ns / events, (unsigned long long) drops, bpe, (double(sizeof(PROFILER_EVENT_RECORD)) * 1.25) / bpe);
+    if (task_counters) printf("native emit: task counters open on %u of %u threads\n", counting, thread_count);
+    remove("benchmark.ptrace");
+
+    for (uint32_t loader_threads = 1; !file_data.empty() && loader_threads <= load_thread_max; loader_threads *= 2)
+    {   // measure the loader, which decodes and merges all of the per-thread streams, at increasing thread counts.
+        WIN32_PROFILER_EVENTS *rtev = new WIN32_PROFILER_EVENTS();
+        uint64_t load_start = PlatformTimestamp();
+        bool     loaded     = LoadPtraceEvents(rtev, &file_data[0], file_data.size(), loader_threads);
+        uint64_t load_ticks = PlatformTimestamp() - load_start;
+        double   load_sec   = double(load_ticks) / double(PlatformTimestampFrequency());
+        printf("ptrace load: %2u producers, %10llu events, %2u loader threads, %6.2f M events/sec%s\n",
+            thread_count, (unsigned long long) rtev->TaskEvents.EventCount, loader_threads, double(rtev->TaskEvents.EventCount) / (load_sec * 1000000.0), loaded ? "" : " (FAILED)");
+        delete rtev;
+    }
+    if (!file_data.empty() && load_thread_max > 1)
+    {   // compare against reopening the same trace from its analysis cache.
+        BenchmarkAnalysisCache(&file_data[0], file_data.size());
+    }
+}
+
+/// @summary Measure the cost the allocation hooks add to each allocation, and check that the allocations of each task are charged to it.
+/// @param alloc_count The number of allocations timed with and without the hooks.
+/// @param task_count The number of tasks recorded with PROFILER_CONFIG::TaskAllocations set.
+/// @param allocs_per_task The number of allocations made by each task.
+internal_function void
+BenchmarkNativeAllocations
+(
+    uint32_t     alloc_count,
+    uint32_t      task_count,
+    uint32_t allocs_per_task
+)
+{
+#if PROFILER_NATIVE_ALLOC_HOOKS
+    // call through volatile pointers, so the compiler can't pair the calls up and remove them.
+    void* (* volatile hooked)(size_t) = malloc;
+    void* (* volatile direct)(size_t) = __libc_malloc;
+    void  (* volatile release)(void*) = free;
+    uint64_t hooked_ticks = 0;
+    uint64_t direct_ticks = 0;
+    for (uint32_t pass = 0; pass < 2; ++pass)
+    {   // the first pass warms up the allocator.
+        uint64_t const t0 = PlatformTimestamp();
+        for (uint32_t i = 0; i < alloc_count; ++i) release(hooked(64));
+        uint64_t const t1 = PlatformTimestamp();
+        for (uint32_t i = 0; i < alloc_count; ++i) release(direct(64));
+        uint64_t const t2 = PlatformTimestamp();
+        hooked_ticks = t1 - t0;
+        direct_ticks = t2 - t1;
+    }
+    double const freq = double(PlatformTimestampFrequency());
+    double const hooked_ns = double(hooked_ticks) * 1000000000.0 / (freq * double(alloc_count));
+    double const direct_ns = double(direct_ticks) * 1000000000.0 / (freq * double(alloc_count));
+    printf("alloc hooks: %10u allocations, hooked %6.2f ns/alloc, glibc %6.2f ns/alloc, %5.2f ns/alloc overhead\n", alloc_count, hooked_ns, direct_ns, hooked_ns - direct_ns);
+
+    PROFILER_CONFIG config;
+    memset(&config, 0, sizeof(config));
+    config.ApplicationName      = "benchmarks";
+    config.ProfilerMajorVersion = PROFILER_VERSION_MAJOR;
+    config.ProfilerMinorVersion = PROFILER_VERSION_MINOR;
+    config.TraceFilePath        = "benchmark.ptrace";
+    config.ThreadBufferSize     = 1 << 20;
+    config.TaskAllocations      = 1;
+    if (InitializeProfiler(&config) != PROFILER_RESULT_SUCCESS)
+    {
+        fprintf(stderr, "ERROR: Unable to initialize the profiler.\n");
+        return;
+    }
+    for (uint32_t i = 0; i < task_count; ++i)
+    {   // each task allocates 32 bytes more than the one before and frees each block again, so the charged bytes show whether samples reached the right task.
+        MarkTaskDefinition(i, INVALID_TASK_ID, (void*) &BenchmarkNativeAllocations, 0, 0, NULL);
+        MarkTaskLaunch(i);
+        for (uint32_t j = 0; j < allocs_per_task; ++j) release(hooked(32 + (size_t(i) * 32)));
+        MarkTaskFinish(i);
+    }
+    ShutdownProfiler();
+
+    std::vector<uint8_t> file_data;
+    long  file_size = 0;
+    FILE *fp = fopen("benchmark.ptrace", "rb");
+    if (fp != NULL)
+    {
+        fseek(fp, 0, SEEK_END);
+        file_size = ftell(fp);
+        fseek(fp, 0, SEEK_SET);
+        file_data.resize(size_t(file_size));
+        if (file_size > 0 && fread(&file_data[0], 1, file_data.size(), fp) != file_data.size()) file_data.clear();
+        fclose(fp);
+    }
+    remove("benchmark.ptrace");
+    if (!file_data.empty())
+    {
+        WIN32_PROFILER_EVENTS *rtev   = new WIN32_PROFILER_EVENTS();
+        bool                   loaded = LoadPtraceEvents(rtev, &file_data[0], file_data.size(), 1);
+        uint64_t               exact  = 0;
+        for (size_t r = 0; r < rtev->TaskTable.TaskCount; ++r)
+        {
+            uint32_t const t = rtev->TaskTable.TaskId[r];
+            uint64_t const bytes = uint64_t(allocs_per_task) * (32 + (uint64_t(t) * 32));
+            if (rtev->TaskTable.AllocCount[r] == allocs_per_task && rtev->TaskTable.AllocBytes[r] == bytes && rtev->TaskTable.FreeBytes[r] >= bytes) exact++;
+        }
+        printf("alloc hooks: %10u tasks, %llu charged exactly%s\n", task_count, (unsigned long long) exact, loaded ? "" : " (FAILED)");
+        delete rtev;
+    }
+#else
+    UNUSED(alloc_count);
+    UNUSED(task_count);
+    UNUSED(allocs_per_task);
+#endif
+}
+
+/// @summary Measure the cost of a PROFILER_ZONE begin and end pair on the native backend, and of nesting the recorded zones at load time.
+/// @param pair_count The number of zones to record. Zones are recorded in rounds that fit in the thread buffer, so none are dropped.
+internal_function void
+BenchmarkNativeZone
+(
+    uint32_t pair_count
+)
+{
+    PROFILER_CONFIG config;
+    memset(&config, 0, sizeof(config));
+    config.ApplicationName      = "benchmarks";
+    config.ProfilerMajorVersion = PROFILER_VERSION_MAJOR;
+    config.ProfilerMinorVersion = PROFILER_VERSION_MINOR;
+    config.TraceFilePath        = "benchmark.ptrace";
+    config.ThreadBufferSize     = 1 << 20;
+    if (InitializeProfiler(&config) != PROFILER_RESULT_SUCCESS)
+    {
+        fprintf(stderr, "ERROR: Unable to initialize the profiler.\n");
+        return;
+    }
+
+    uint32_t const round_size  = 1 << 16;
+    uint64_t       total_ticks = 0;
+    for (uint32_t done = 0; done < pair_count; done += round_size)
+    {   // let the flush thread drain the buffer between rounds, outside of the timed region.
+        uint32_t const n     = pair_count - done < round_size ? pair_count - done : round_size;
+        uint64_t const start = PlatformTimestamp();
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            PROFILER_ZONE("benchmark");
+        }
+        total_ticks += PlatformTimestamp() - start;
+        PlatformSleep(PROFILER_NATIVE_FLUSH_INTERVAL * 2);
+    }
+    uint64_t drops = 0;
+    for (uint32_t i = 0, n = ProfilerNative.BufferCount.load(); i < n; ++i)
+    {
+        drops += ProfilerNative.Buffers[i]->DropCount.load();
+    }
+    ShutdownProfiler();
+
+    std::vector<uint8_t> file_data;
+    long  file_size = 0;
+    FILE *fp = fopen("benchmark.ptrace", "rb");
+    if (fp != NULL)
+    {
+        fseek(fp, 0, SEEK_END);
+        file_size = ftell(fp);
+        fseek(fp, 0, SEEK_SET);
+        file_data.resize(size_t(file_size));
+        if (file_size > 0 && fread(&file_data[0], 1, file_data.size(), fp) != file_data.size()) file_data.clear();
+        fclose(fp);
+    }
+    remove("benchmark.ptrace");
+
+    double const ns = double(total_ticks) * 1000000000.0 / double(PlatformTimestampFrequency());
+    printf("native zone: %10u pairs, %6.2f ns/pair, %llu dropped, %5.2f bytes/pair\n", pair_count, ns / double(pair_count), (unsigned long long) drops, double(file_size) / double(pair_count));
+    if (!file_data.empty())
+    {   // load the trace and nest the zones, as the visualizer does once loading completes.
+        WIN32_PROFILER_EVENTS *rtev = new WIN32_PROFILER_EVENTS();
+        bool     loaded     = LoadPtraceEvents(rtev, &file_data[0], file_data.size(), 1);
+        uint64_t tree_start = PlatformTimestamp();
+        BuildZoneTree(&rtev->ZoneTree, &rtev->ZoneEvents, &rtev->TaskTable);
+        double   tree_sec   = double(PlatformTimestamp() - tree_start) / double(PlatformTimestampFrequency());
+        printf("zone tree: %10llu zones, %llu unmatched, %6.2f M zones/sec%s\n", (unsigned long long) rtev->ZoneTree.ZoneCount, (unsigned long long) rtev->ZoneTree.UnmatchedCount,
+            double(rtev->ZoneTree.ZoneCount) / (tree_sec * 1000000.0), loaded ? "" : " (FAILED)");
+        DeleteZoneTree(&rtev->ZoneTree);
+        delete rtev;
+    }
+}
+
+/// @summary Measure the cost of locating a thread alive at a given time when many short-lived threads reuse identifiers.
+/// @param thread_count The number of thread records, each alive for a disjoint 1000ns interval.
+/// @param lookup_count The number of lookups to perform.
+internal_function void
+BenchmarkObjectIndex
+(
+    uint32_t thread_count,
+    uint32_t lookup_count
+)
+{
+    std::vector<WIN32_LIFETIME> lifetimes(thread_count);
+    WIN32_OBJECT_INDEX          index;
+    InitObjectIndex(index);
+    for (uint32_t i = 0; i < thread_count; ++i)
+    {   // the OS recycles thread IDs, so use 1/16th as many distinct IDs as threads.
+        lifetimes[i].CreateTime  = uint64_t(i) * 1000;
+        lifetimes[i].DestroyTime = uint64_t(i) * 1000 + 999;
+        ObjectIndexInsert(index, (i % (thread_count / 16)) * 4, i);
+    }
+    uint64_t start = PlatformTimestamp();
+    size_t   found = 0;
+    size_t   sum   = 0;
+    for (uint32_t i = 0; i < lookup_count; ++i)
+    {   // query the most recent threads, as a CSwitch stream would.
+        uint32_t t = thread_count - 1 - (uint32_t(ObjectIndexHash(i)) % 256);
+        if (FindObjectInIndex(index, lifetimes.data(), (t % (thread_count / 16)) * 4, uint64_t(t) * 1000 + 500, found)) sum += found;
+    }
+    uint64_t ticks = PlatformTimestamp() - start;
+    double   ns    = double(ticks) * 1000000000.0 / double(PlatformTimestampFrequency());
+    printf("object index: %6u threads, %8u lookups, %6.2f ns/lookup (checksum %llu)\n",
+        thread_count, lookup_count, ns / double(lookup_count), (unsigned long long) sum);
+}
+
+/// @summary Measure the cost of interning image paths as an image load stream would, where a small set of DLLs is loaded into many processes.
+/// @param distinct_count The number of distinct paths.
+/// @param intern_count The number of paths to intern.
+internal_function void
+BenchmarkStringIntern
+(
+    uint32_t distinct_count,
+    uint32_t   intern_count
+)
+{
+    std::vector<std::wstring> paths(distinct_count);
+    WIN32_MEMORY_ARENA        arena;
+    WIN32_STRING_TABLE        table;
+    WCHAR                     buf[128];
+    for (uint32_t i = 0; i < distinct_count; ++i)
+    {
+        swprintf(buf, 128, L"\\Device\\HarddiskVolume2\\Windows\\System32\\api-ms-win-core-%05u-l1-1-0.dll", i);
+        paths[i] = buf;
+    }
+    InitMemoryArena(&arena, 0);
+    InitStringTable(&table);
+    uint64_t start = PlatformTimestamp();
+    uint64_t sum   = 0;
+    for (uint32_t i = 0; i < intern_count; ++i)
+    {
+        std::wstring const &p = paths[uint32_t(ObjectIndexHash(i)) % distinct_count];
+        sum += InternWideString(&table, &arena, p.c_str(), p.size());
+    }
+    uint64_t ticks = PlatformTimestamp() - start;
+    double   ns    = double(ticks) * 1000000000.0 / double(PlatformTimestampFrequency());
+    printf("string intern: %6u distinct, %8u interned, %6.2f ns/intern, %7.1f KB in %u arena chunks (checksum %llu)\n",
+        distinct_count, intern_count, ns / double(intern_count), double(arena.BytesUsed) / 1024.0, unsigned(arena.Chunks.size()), (unsigned long long) sum);
+    DeleteMemoryArena(&arena);
+}
+
+/// @summary Measure the cost of decoding the CSwitch fields used by the trace loader from synthetic payloads through a decoder cache.
+/// @param event_count The number of events to decode.
+internal_function void
+BenchmarkEventDecoder
+(
+    uint32_t event_count
+)
+{
+    uint32_t const cswitch[12] = { 4, 4, 1, 1, 1, 1, 1, 1, 1, 1, 4, 4 };
+    uint32_t const   ready[ 6] = { 4, 1, 1, 1, 1, 4 };
+    WIN32_EVENT_DECODER_CACHE cache;
+    WIN32_EVENT_DECODER_PLAN   plan;
+    WIN32_EVENT_SCHEMA_KEY     keys[2];
+    std::vector<uint8_t>    payload(24 * 1024);
+    for (size_t i = 0; i < payload.size(); ++i) payload[i] = uint8_t(ObjectIndexHash(i));
+    memset(keys, 0, sizeof(keys));
+    keys[0].Opcode = 36; keys[0].Version = 2; keys[0].PointerSize = 8;
+    keys[1].Opcode = 50; keys[1].Version = 2; keys[1].PointerSize = 8;
+    InitEventDecoderCache(&cache);
+    InitEventDecoderPlan(&plan, cswitch, 12); InsertEventDecoderPlan(&cache, keys[0], &plan);
+    InitEventDecoderPlan(&plan, ready  ,  6); InsertEventDecoderPlan(&cache, keys[1], &plan);
+
+    uint64_t sum   = 0;
+    uint64_t start = PlatformTimestamp();
+    for (uint32_t i = 0; i < event_count; ++i)
+    {   // interleave the two schemas, as context switch and ready thread events are in a real trace.
+        uint8_t const *data = &payload[(i & 1023) * 24];
+        WIN32_EVENT_DECODER_PLAN const *p = FindEventDecoderPlan(&cache, keys[(i >> 2) & 1]);
+        if (EventDecoderHasField(p, 24, 0)) sum += EventDecoderGetUInt32(p, data, 0);
+        if (p->FixedCount == 12 && EventDecoderHasField(p, 24, 10))
+        {
+            sum += EventDecoderGetUInt32(p, data, 1) + EventDecoderGetUInt32(p, data, 10);
+            sum += uint8_t(EventDecoderGetSInt8(p, data, 2) + EventDecoderGetSInt8(p, data, 3) + EventDecoderGetSInt8(p, data, 6));
+            sum += uint8_t(EventDecoderGetSInt8(p, data, 7) + EventDecoderGetSInt8(p, data, 8) + EventDecoderGetSInt8(p, data, 9));
+        }
+    }
+    uint64_t ticks = PlatformTimestamp() - start;
+    double   ns    = double(ticks) * 1000000000.0 / double(PlatformTimestampFrequency());
+    printf("event decoder: %8u events, %6.2f ns/event (checksum %llu)\n", event_count, ns / double(event_count), (unsigned long long) sum);
+    DeleteEventDecoderCache(&cache);
+}
+
+/// @summary Measure the cost of building a task table from a synthetic event log, and of looking up tasks by identifier.
+/// @param task_count The number of tasks in the log. Each task has four events, and identifiers are reused.
+internal_function void
+BenchmarkTaskTable
+(
+    uint32_t task_count
+)
+{
+    WIN32_TASK_EVENT_LIST events;
+    WIN32_TASK_TABLE      table;
+    uint64_t              time = 0;
+    InitTaskEventList(&events);
+    for (uint32_t i = 0; i < task_count; ++i)
+    {   // 64 tasks are in flight at once; the scheduler recycles identifiers every 65536 tasks.
+        task_id_t id = (i & 0xFFFF) + 1;
+        AppendTaskEvent(&events, WIN32_TASK_EVENT_DEFINE_TASK , time += 10, id, 1, 0, INVALID_TASK_ID, 0x1000, NULL, 0);
+        AppendTaskEvent(&events, WIN32_TASK_EVENT_READY_TO_RUN, time += 10, id, 1, 0, INVALID_TASK_ID, 0, NULL, 0);
+        if (i >= 64)
+        {
+            task_id_t prev = ((i - 64) & 0xFFFF) + 1;
+            AppendTaskEvent(&events, WIN32_TASK_EVENT_LAUNCH, time += 10, prev, 2, 0, INVALID_TASK_ID, 0, NULL, 0);
+            AppendTaskEvent(&events, WIN32_TASK_EVENT_FINISH, time += 10, prev, 2, 0, INVALID_TASK_ID, 0, NULL, 0);
+        }
+    }
+    uint64_t start = PlatformTimestamp();
+    BuildTaskTable(&table, &events);
+    uint64_t build = PlatformTimestamp() - start;
+
+    size_t   row = 0;
+    uint64_t sum = 0;
+    start = PlatformTimestamp();
+    for (uint32_t i = 0; i < 1000000; ++i)
+    {
+        if (FindTaskById(&table, (uint32_t(ObjectIndexHash(i)) & 0xFFFF) + 1, row)) sum += table.LaunchTime[row];
+    }
+    uint64_t find = PlatformTimestamp() - start;
+    double   freq = double(PlatformTimestampFrequency());
+    printf("task table: %8u tasks, %7.2f ns/event build, %6.2f ns/lookup (checksum %llu)\n", task_count,
+        double(build) * 1000000000.0 / freq / double(events.EventCount), double(find) * 1000000000.0 / freq / 1000000.0, (unsigned long long) sum);
+}
+
+/// @summary Measure the cost of building the pyramid for a long, densely populated timeline row, and of sampling it for display.
+/// @param span_count The number of spans in the row. Spans are spread evenly over ten minutes.
+/// @param pixel_count The width of the row on screen, in pixels.
+internal_function void
+BenchmarkTimelineLod
+(
+    uint32_t  span_count,
+    uint32_t pixel_count
+)
+{
+    uint64_t const        duration = 600ULL * 1000000000ULL;
+    uint64_t const        period   = duration / span_count;
+    std::vector<uint64_t> span_start(span_count);
+    std::vector<uint64_t> span_end(span_count);
+    std::vector<uint32_t> span_label(span_count);
+    std::vector<float>    busy(pixel_count);
+    std::vector<uint32_t> label(pixel_count);
+    WIN32_LOD_PYRAMID     pyr;
+    for (uint32_t i = 0; i < span_count; ++i)
+    {   // busy for between 1/4 and 3/4 of each period.
+        span_start[i] = uint64_t(i) * period;
+        span_end  [i] = span_start[i] + period / 4 + (ObjectIndexHash(i) % (period / 2));
+        span_label[i] = i;
+    }
+    uint64_t start = PlatformTimestamp();
+    BuildLodPyramid(&pyr, &span_start[0], &span_end[0], &span_label[0], span_count, 0, LodBaseShift(0, duration));
+    uint64_t build = PlatformTimestamp() - start;
+
+    // sample the whole trace, then a window 1/1000th as wide; both should cost the same.
+    double   sum  = 0.0;
+    uint64_t full = 0, zoom = 0;
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        uint64_t const window = pass == 0 ? duration : duration / 1000;
+        start = PlatformTimestamp();
+        for (uint32_t i = 0; i < 1000; ++i)
+        {
+            uint64_t const lower = (duration - window) / 1000 * i;
+            SampleLodPyramid(&pyr, lower, lower + window, pixel_count, &busy[0], &label[0]);
+            sum += busy[i % pixel_count];
+        }
+        (pass == 0 ? full : zoom) = PlatformTimestamp() - start;
+    }
+    double   freq = double(PlatformTimestampFrequency());
+    printf("timeline lod: %8u spans, %6.2f ns/span build, %7.1f KB, %7.2f us/sample full, %7.2f us/sample zoomed (%u pixels, checksum %.3f)\n", span_count,
+        double(build) * 1000000000.0 / freq / double(span_count), double(pyr.LevelStart[pyr.LevelCount] * 8) / 1024.0,
+        double(full) * 1000000.0 / freq / 1000.0, double(zoom) * 1000000.0 / freq / 1000.0, pixel_count, sum);
+    DeleteLodPyramid(&pyr);
+}
+
+/// @summary Fill a task table with a large synthetic task graph. Each task is spawned by one of the previous 64 tasks and joins two of the previous 4096.
+/// @param table The task table to fill. Only the columns used by graph analysis are set.
+/// @param task_count The number of tasks in the graph.
+internal_function void
+BuildSyntheticTaskGraph
+(
+    WIN32_TASK_TABLE *table,
+    uint32_t     task_count
+)
+{
+    InitTaskTable(table);
+    table->TaskCount = task_count;
+    table->DefineTime.resize(task_count);
+    table->LaunchTime.resize(task_count);
+    table->FinishTime.resize(task_count);
+    table->EntryPoint.resize(task_count);
+    table->ParentRow.resize(task_count);
+    table->DependencyStart.resize(task_count + 1);
+    table->DependencyRow.reserve(size_t(task_count) * 2);
+    for (uint32_t r = 0; r < task_count; ++r)
+    {   // dependencies are drawn from a window of recent tasks, as in a frame-structured workload.
+        uint64_t const h = ObjectIndexHash(r);
+        table->DefineTime[r] = 1000 + uint64_t(r) * 100;
+        table->LaunchTime[r] = table->DefineTime[r] + 50;
+        table->FinishTime[r] = table->LaunchTime[r] + 100 + (h % 1000);
+        table->EntryPoint[r] = 0x1000 + (h >> 32) % 64;
+        table->ParentRow [r] = r > 0 ? r - 1 - uint32_t((h >> 8) % (r < 64 ? r : 64)) : WIN32_OBJECT_INDEX_EMPTY;
+        table->DependencyStart[r] = uint32_t(table->DependencyRow.size());
+        for (uint32_t d = 0; r > 0 && d < 2; ++d)
+        {
+            table->DependencyRow.push_back(r - 1 - uint32_t((h >> (16 + d * 16)) % (r < 4096 ? r : 4096)));
+        }
+    }
+    table->DependencyStart[task_count] = uint32_t(table->DependencyRow.size());
+    BuildTaskSuccessors(table);
+}
+
+/// @summary Measure the cost of building the interval history of a thread with many context switches, and of looking up random times in it.
+/// @param switch_count The number of times the thread is switched in.
+/// @param lookup_count The number of random lookups to perform.
+internal_function void
+BenchmarkThreadIntervals
+(
+    uint32_t switch_count,
+    uint32_t lookup_count
+)
+{
+    WIN32_THREAD_INFO     thread;
+    WIN32_SWITCH_OUT_DATA data;
+    uint64_t              time  = 1000;
+    uint32_t              rng   = 1;
+    size_t                found = 0;
+    size_t                index = 0;
+
+    data.Processor = 0; data.WaitMode = 0; data.Priority = 8;
+    for (uint32_t i = 0; i < switch_count; ++i)
+    {   // alternate between blocking waits and preemptions with a ready period.
+        rng  = rng * 1664525U + 1013904223U;
+        data.State      = (rng & 0x100) ? 5 : 1;
+        data.WaitReason = (rng & 0x100) ? int8_t(rng & 0x1F) : 0;
+        thread.SwitchInTime.push_back(time);
+        time += 1000 + ((rng >> 12) & 0xFFFF);
+        thread.SwitchOutTime.push_back(time);
+        thread.SwitchOutData.push_back(data);
+        time += 500 + ((rng >> 4) & 0xFF);
+        if (data.State == 5)
+        {
+            thread.ReadyTimes.push_back(time);
+            time += 100;
+        }
+    }
+
+    uint64_t start = PlatformTimestamp();
+    BuildThreadIntervals(&thread, time);
+    uint64_t build = PlatformTimestamp() - start;
+    start = PlatformTimestamp();
+    for (uint32_t i = 0; i < lookup_count; ++i)
+    {
+        rng = rng * 1664525U + 1013904223U;
+        found += FindThreadInterval(&thread.Intervals, 1000 + (uint64_t(rng) * (time - 1000) >> 32), index) ? 1 : 0;
+    }
+    uint64_t lookup = PlatformTimestamp() - start;
+    double   freq   = double(PlatformTimestampFrequency());
+    printf("thread intervals: %8u switches, %7.2f ms build (%5.2f ns/interval), %5.2f ns/lookup, %u of %u found\n", switch_count,
+        double(build) * 1000.0 / freq, double(build) * 1000000000.0 / freq / double(thread.Intervals.IntervalCount),
+        double(lookup) * 1000000000.0 / freq / double(lookup_count), unsigned(found), lookup_count);
+    DeleteThreadIntervals(&thread.Intervals);
+}
+
+/// @summary Measure the cost of reconstructing the per-core timeline of many threads, and of looking up what every core ran at random times.
+/// @param thread_count The number of threads.
+/// @param switch_count The number of times each thread is switched in.
+/// @param core_count The number of logical processors the threads are spread over.
+/// @param lookup_count The number of random all-core lookups to perform.
+internal_function void
+BenchmarkCpuTimeline
+(
+    uint32_t thread_count,
+    uint32_t switch_count,
+    uint32_t   core_count,
+    uint32_t lookup_count
+)
+{
+    WIN32_PROCESS_LIST    procs;
+    WIN32_TASK_TABLE      table;
+    WIN32_CPU_TIMELINE    cpu;
+    WIN32_SWITCH_IN_DATA  in  = { 0, 0, 8 };
+    WIN32_SWITCH_OUT_DATA out = { 0, 5, 6, 0, 8 };
+    std::vector<uint32_t> seg(core_count);
+    uint32_t              rng  = 1;
+    size_t                busy = 0;
+    uint64_t              last = 0;
+
+    BuildSyntheticTaskGraph(&table, 1000);
+    procs.ProcessCount = 1;
+    procs.ProcessInfo.resize(1);
+    WIN32_PROCESS_INFO &proc = procs.ProcessInfo[0];
+    proc.ThreadCount = thread_count;
+    proc.ThreadId.resize(thread_count);
+    proc.ThreadInfo.resize(thread_count);
+    proc.ThreadLifetime.resize(thread_count);
+    for (uint32_t i = 0; i < thread_count; ++i)
+    {   // each thread runs for a while on a random core, then waits for a while.
+        WIN32_THREAD_INFO &thread = proc.ThreadInfo[i];
+        uint64_t           time   = 1000 + i;
+        proc.ThreadId[i] = 100 + i;
+        proc.ThreadLifetime[i].DestroyTime = 0;
+        for (uint32_t j = 0; j < switch_count; ++j)
+        {
+            rng = rng * 1664525U + 1013904223U;
+            in.Processor = uint16_t((rng >> 8) % core_count);
+            thread.SwitchInTime.push_back(time);
+            thread.SwitchInData.push_back(in);
+            time += 1000 + ((rng >> 16) & 0x3FFF);
+            thread.SwitchOutTime.push_back(time);
+            thread.SwitchOutData.push_back(out);
+            time += uint64_t(thread_count / core_count) * 9000 + ((rng >> 4) & 0xFFF);
+        }
+        if (time > last) last = time;
+    }
+    BuildProcessThreadIntervals(&procs);
+
+    uint64_t start = PlatformTimestamp();
+    BuildCpuTimeline(&cpu, &procs, &table, 1000, LodBaseShift(1000, last));
+    uint64_t build = PlatformTimestamp() - start;
+    start = PlatformTimestamp();
+    for (uint32_t i = 0; i < lookup_count; ++i)
+    {
+        rng   = rng * 1664525U + 1013904223U;
+        busy += FindCpuSegmentsAtTime(&cpu, 1000 + (uint64_t(rng) * (last - 1000) >> 32), &seg[0]);
+    }
+    uint64_t lookup = PlatformTimestamp() - start;
+    double   freq   = double(PlatformTimestampFrequency());
+    printf("cpu timeline: %8u segments, %3u cores, %7.2f ms build (%5.2f ns/segment), %6.2f us/lookup, %5.2f cores busy on average\n", unsigned(cpu.SegmentCount), unsigned(cpu.ProcessorCount),
+        double(build) * 1000.0 / freq, double(build) * 1000000000.0 / freq / double(cpu.SegmentCount), double(lookup) * 1000000.0 / freq / double(lookup_count), double(busy) / double(lookup_count));
+    DeleteCpuTimeline(&cpu);
+}
+
+/// @summary Measure the cost of pairing the ready events and switch-ins of many threads and building their wake latency histograms.
+/// @param thread_count The number of threads.
+/// @param wake_count The number of times each thread is woken.
+internal_function void
+BenchmarkWakeLatency
+(
+    uint32_t thread_count,
+    uint32_t   wake_count
+)
+{
+    WIN32_PROCESS_LIST    procs;
+    WIN32_SCHEDULER_INFO  sched;
+    WIN32_WAKE_LATENCY    wl;
+    WIN32_SWITCH_IN_DATA  in  = { 0, 0, 8 };
+    WIN32_SWITCH_OUT_DATA out = { 0, 5, 6, 0, 8 };
+    uint32_t              rng = 1;
+
+    procs.ProcessCount = 1;
+    procs.ProcessInfo.resize(1);
+    WIN32_PROCESS_INFO &proc = procs.ProcessInfo[0];
+    proc.ThreadCount = thread_count;
+    proc.ThreadId.resize(thread_count);
+    proc.ThreadInfo.resize(thread_count);
+    proc.ThreadLifetime.assign(thread_count, WIN32_LIFETIME());
+    sched.WorkerCount = thread_count / 2;
+    for (uint32_t i = 0; i < thread_count; ++i)
+    {   // half of the threads are workers in one of two pools. latencies are mostly short, with a long tail.
+        WIN32_THREAD_INFO &thread = proc.ThreadInfo[i];
+        uint64_t           time   = 1000 + i;
+        proc.ThreadId[i] = 100 + i;
+        if (i < sched.WorkerCount)
+        {
+            sched.WorkerThreadId.push_back(100 + i);
+            sched.WorkerPoolId.push_back(i & 1);
+            sched.WorkerPoolIndex.push_back(i >> 1);
+        }
+        for (uint32_t j = 0; j < wake_count; ++j)
+        {
+            rng   = rng * 1664525U + 1013904223U;
+            thread.ReadyTimes.push_back(time);
+            time += ((rng >> 8) & 0xFFF) << ((rng >> 28) & 0x7);
+            thread.SwitchInTime.push_back(time);
+            thread.SwitchInData.push_back(in);
+            time += 1000 + ((rng >> 4) & 0x3FF);
+            thread.SwitchOutTime.push_back(time);
+            thread.SwitchOutData.push_back(out);
+            time += 5000;
+        }
+    }
+
+    BuildProcessThreadIntervals(&procs);
+    uint64_t start = PlatformTimestamp();
+    BuildWakeLatency(&wl, &procs, &sched, 100000);
+    uint64_t build = PlatformTimestamp() - start;
+    double   freq  = double(PlatformTimestampFrequency());
+    printf("wake latency: %8llu wakeups, %7.2f ms build (%5.2f ns/wakeup), p50 %6.1f us, p99 %7.1f us, %llu slow\n", (unsigned long long) wl.All.Count,
+        double(build) * 1000.0 / freq, double(build) * 1000000000.0 / freq / double(wl.All.Count), double(LatencyHistogramPercentile(&wl.All, 50.0)) / 1000.0,
+        double(LatencyHistogramPercentile(&wl.All, 99.0)) / 1000.0, (unsigned long long) wl.SlowCount);
+    DeleteWakeLatency(&wl);
+}
+
+/// @summary Measure the cost of building the off-CPU report of many threads that block often for a variety of reasons.
+/// @param thread_count The number of threads.
+/// @param block_count The number of times each thread blocks.
+internal_function void
+BenchmarkOffCpuReport
+(
+    uint32_t thread_count,
+    uint32_t  block_count
+)
+{
+    WIN32_PROCESS_LIST    procs;
+    WIN32_TASK_TABLE      table;
+    WIN32_OFF_CPU_REPORT  oc;
+    WIN32_SWITCH_IN_DATA  in  = { 0, 0, 8 };
+    WIN32_SWITCH_OUT_DATA out = { 0, 5, 0, 0, 8 };
+    uint32_t              rng = 1;
+
+    BuildSyntheticTaskGraph(&table, 100000);
+    table.WorkerThreadId.resize(table.TaskCount);
+    for (uint32_t r = 0; r < table.TaskCount; ++r)
+    {   // spread the tasks over the threads; launch and finish times are assigned below.
+        table.WorkerThreadId[r] = 100 + r % thread_count;
+    }
+    procs.ProcessCount = 1;
+    procs.ProcessInfo.resize(1);
+    WIN32_PROCESS_INFO &proc = procs.ProcessInfo[0];
+    proc.ThreadCount = thread_count;
+    proc.ThreadId.resize(thread_count);
+    proc.ThreadInfo.resize(thread_count);
+    proc.ThreadLifetime.resize(thread_count);
+    for (uint32_t i = 0; i < thread_count; ++i)
+    {   // each thread runs, then blocks with one of a handful of reasons until it is readied.
+        WIN32_THREAD_INFO &thread = proc.ThreadInfo[i];
+        uint64_t           time   = 1000 + i;
+        proc.ThreadId[i] = 100 + i;
+        proc.ThreadLifetime[i].DestroyTime = 0;
+        for (uint32_t j = 0; j < block_count; ++j)
+        {
+            rng   = rng * 1664525U + 1013904223U;
+            out.WaitReason = int8_t((rng >> 24) % 38);
+            out.WaitMode   = int8_t((rng >> 20) & 1);
+            thread.SwitchInTime.push_back(time);
+            thread.SwitchInData.push_back(in);
+            time += 1000 + ((rng >> 4) & 0x3FF);
+            thread.SwitchOutTime.push_back(time);
+            thread.SwitchOutData.push_back(out);
+            time += ((rng >> 8) & 0xFFF) << ((rng >> 28) & 0x7);
+            thread.ReadyTimes.push_back(time);
+            if (i + j * thread_count < table.TaskCount)
+            {   // the first blocks of each thread happen while it executes a task.
+                uint32_t const r = i + j * thread_count;
+                table.LaunchTime[r] = thread.SwitchInTime.back();
+                table.FinishTime[r] = time + 1;
+            }
+            time += 2000;
+        }
+    }
+    std::vector<std::pair<uint64_t, uint32_t> > launch(table.TaskCount);
+    for (uint32_t r = 0; r < table.TaskCount; ++r)
+    {
+        launch[r] = std::make_pair(table.LaunchTime[r], r);
+    }
+    std::sort(launch.begin(), launch.end());
+    table.LaunchSortedTime.resize(table.TaskCount);
+    table.LaunchSortedRow.resize(table.TaskCount);
+    for (uint32_t r = 0; r < table.TaskCount; ++r)
+    {
+        table.LaunchSortedTime[r] = launch[r].first;
+        table.LaunchSortedRow [r] = launch[r].second;
+    }
+    BuildProcessThreadIntervals(&procs);
+
+    uint64_t start = PlatformTimestamp();
+    BuildOffCpuReport(&oc, &procs, &table);
+    uint64_t build = PlatformTimestamp() - start;
+    double   freq  = double(PlatformTimestampFrequency());
+    printf("off-cpu report: %8llu blocked intervals, %7.2f ms build (%5.2f ns/interval), %u entry points blocked\n", (unsigned long long) oc.All.Count,
+        double(build) * 1000.0 / freq, double(build) * 1000000000.0 / freq / double(oc.All.Count), unsigned(oc.EntryPointCount));
+    DeleteOffCpuReport(&oc);
+}
+
+/// @summary Measure the cost of reconstructing the ready backlog of a long trace, and of sampling the total for display.
+/// @param task_count The number of tasks. Tasks come from eight sources, and are launched by sixteen workers in two pools.
+/// @param pixel_count The width of a queue depth row on screen, in pixels.
+internal_function void
+BenchmarkQueueDepth
+(
+    uint32_t  task_count,
+    uint32_t pixel_count
+)
+{
+    WIN32_TASK_EVENT_LIST events;
+    WIN32_TASK_TABLE      table;
+    WIN32_SCHEDULER_INFO  sched;
+    WIN32_QUEUE_DEPTH     qd;
+    std::vector<float>    peak(pixel_count);
+    std::vector<float>    mean(pixel_count);
+    uint64_t              time = 0;
+    uint32_t              next = 0;
+
+    sched.WorkerCount = 16;
+    for (uint32_t w = 0; w < 16; ++w)
+    {
+        sched.WorkerThreadId.push_back(100 + w);
+        sched.WorkerPoolId.push_back(w / 8);
+    }
+    InitTaskEventList(&events);
+    for (uint32_t i = 0; i < task_count; ++i)
+    {   // the backlog builds up to 512 tasks and drains again every 256K tasks.
+        uint32_t const phase  = (i >> 10) & 0xFF;
+        uint32_t const window = 4 * (phase < 128 ? phase : 255 - phase);
+        AppendTaskEvent(&events, WIN32_TASK_EVENT_READY_TO_RUN, time += 10, i + 1, 1, i & 7, INVALID_TASK_ID, 0, NULL, 0);
+        while (next + window < i)
+        {
+            AppendTaskEvent(&events, WIN32_TASK_EVENT_LAUNCH, time += 5, next + 1, 100 + (next & 15), 0, INVALID_TASK_ID, 0, NULL, 0);
+            next++;
+        }
+    }
+    BuildTaskTable(&table, &events);
+    uint32_t const shift = LodBaseShift(0, time);
+
+    uint64_t start = PlatformTimestamp();
+    BuildQueueDepth(&qd, &table, &sched, 0, shift);
+    uint64_t build = PlatformTimestamp() - start;
+    start = PlatformTimestamp();
+    for (int i = 0; i < 100; ++i)
+    {
+        SampleStepPyramid(&qd.SeriesLod[0], 0, time, pixel_count, &peak[0], &mean[0]);
+    }
+    uint64_t sample = PlatformTimestamp() - start;
+    double   freq   = double(PlatformTimestampFrequency());
+    printf("queue depth: %8u tasks, %2u series, %8u steps, %7.2f ms build (%5.2f ns/task), %7.2f us/sample, peak %u\n", task_count, unsigned(qd.SeriesCount), unsigned(qd.StepTime.size()),
+        double(build) * 1000.0 / freq, double(build) * 1000000000.0 / freq / double(task_count), double(sample) * 1000000.0 / freq / 100.0, qd.SeriesMaxDepth[0]);
+    DeleteQueueDepth(&qd);
+}
+
+/// @summary Measure the cost of building the parallelism profile of a long trace, serially and with one thread per processor, and of range queries against it.
+/// @param task_count The number of tasks. Tasks are launched by sixteen workers in two pools, and each contributes a launch and a finish transition.
+internal_function void
+BenchmarkParallelismProfile
+(
+    uint32_t task_count
+)
+{
+    WIN32_TASK_TABLE          table;
+    WIN32_SCHEDULER_INFO      sched;
+    WIN32_PARALLELISM_PROFILE profile;
+    WIN32_STEP_RANGE          range;
+    uint64_t                  finish_sum = 0;
+
+    sched.WorkerCount = 16;
+    for (uint32_t w = 0; w < 16; ++w)
+    {
+        sched.WorkerThreadId.push_back(100 + w);
+        sched.WorkerPoolId.push_back(w / 8);
+    }
+    // tasks run for 1-16us, so finishes arrive nearly in launch order; the finish column is sorted by a merge of short runs.
+    table.TaskCount = task_count;
+    table.LaunchTime.resize(task_count);
+    table.FinishTime.resize(task_count);
+    table.WorkerThreadId.resize(task_count);
+    table.LaunchSortedTime.resize(task_count);
+    table.LaunchSortedRow.resize(task_count);
+    std::vector<std::pair<uint64_t, uint32_t> > finish(task_count);
+    for (uint32_t r = 0; r < task_count; ++r)
+    {
+        table.LaunchTime[r]       = 1000 + uint64_t(r) * 500;
+        table.FinishTime[r]       = table.LaunchTime[r] + 1000 + ((r * 2654435761U) >> 20);
+        table.WorkerThreadId[r]   = 100 + (r & 15);
+        table.LaunchSortedTime[r] = table.LaunchTime[r];
+        table.LaunchSortedRow[r]  = r;
+        finish[r] = std::make_pair(table.FinishTime[r], r);
+    }
+    std::sort(finish.begin(), finish.end());
+    table.FinishSortedTime.resize(task_count);
+    table.FinishSortedRow.resize(task_count);
+    for (uint32_t i = 0; i < task_count; ++i)
+    {
+        table.FinishSortedTime[i] = finish[i].first;
+        table.FinishSortedRow[i]  = finish[i].second;
+    }
+    std::vector<std::pair<uint64_t, uint32_t> >().swap(finish);
+
+    double   freq   = double(PlatformTimestampFrequency());
+    uint32_t counts[2] = { 1, 0 };
+    for (int i = 0; i < 2; ++i)
+    {
+        uint64_t start = PlatformTimestamp();
+        BuildParallelismProfile(&profile, &table, &sched, counts[i]);
+        uint64_t build = PlatformTimestamp() - start;
+        printf("parallelism: %8u tasks, %2u threads, %8u steps, %7.2f ms build (%5.2f ns/transition)\n", task_count, counts[i] != 0 ? counts[i] : PlatformProcessorCount(),
+            unsigned(profile.PoolRunning[0].StepCount + profile.PoolRunning[1].StepCount), double(build) * 1000.0 / freq, double(build) * 1000000000.0 / freq / (2.0 * task_count));
+    }
+
+    uint64_t const span  = profile.EndTime - profile.FirstTime;
+    uint64_t       start = PlatformTimestamp();
+    for (uint32_t i = 0; i < 100000; ++i)
+    {   // windows from a few steps to the whole trace.
+        uint64_t const width = span >> (i % 24);
+        uint64_t const lower = profile.FirstTime + ((uint64_t(i) * 2654435761U) % (span - width + 1));
+        StepFunctionRange(&profile.PoolRunning[0], lower, lower + width, &range);
+        finish_sum += range.Max;
+    }
+    uint64_t query = PlatformTimestamp() - start;
+    StepFunctionRange(&profile.PoolRunning[0], profile.FirstTime, profile.EndTime, &range);
+    printf("parallelism: %7.2f ns/range query, pool 0 mean %.2f of %u workers, %.1f%% saturated (checksum %llu)\n", double(query) * 1000000000.0 / freq / 100000.0,
+        range.Mean, profile.PoolWorkerCount[0], 100.0 * double(profile.PoolSaturatedTime[0]) / double(span), (unsigned long long) finish_sum);
+    DeleteParallelismProfile(&profile);
+}
+
+/// @summary Measure the cost of critical path analysis of a large task graph.
+/// @param task_count The number of tasks in the graph.
+internal_function void
+BenchmarkCriticalPath
+(
+    uint32_t task_count
+)
+{
+    WIN32_TASK_TABLE    table;
+    WIN32_CRITICAL_PATH cp = {};
+    BuildSyntheticTaskGraph(&table, task_count);
+
+    uint64_t start = PlatformTimestamp();
+    BuildCriticalPath(&cp, &table, 1000, LodBaseShift(1000, table.FinishTime[task_count - 1]));
+    uint64_t build = PlatformTimestamp() - start;
+    double   freq  = double(PlatformTimestampFrequency());
+    printf("critical path: %8u tasks, %7.2f ms (%5.2f ns/task), %7u tasks on path, %6.2fx maximum speedup\n", task_count,
+        double(build) * 1000.0 / freq, double(build) * 1000000000.0 / freq / double(task_count), unsigned(cp.PathRow.size()), cp.MaxSpeedup);
+    DeleteCriticalPath(&cp);
+}
+
+/// @summary Measure the cost of replaying a large task graph on a simulated scheduler with increasing worker counts.
+/// @param task_count The number of tasks in the graph.
+/// @param policy One of WIN32_SCHEDULER_POLICY.
+internal_function void
+BenchmarkScheduleReplay
+(
+    uint32_t task_count,
+    uint32_t     policy
+)
+{
+    char const *names[WIN32_SCHEDULER_POLICY_COUNT] = { "fifo", "lifo", "stealing" };
+    WIN32_TASK_TABLE       table;
+    WIN32_SCHEDULER_REPLAY replay;
+    BuildSyntheticTaskGraph(&table, task_count);
+    for (uint32_t workers = 4; workers <= 64; workers *= 4)
+    {
+        uint64_t start = PlatformTimestamp();
+        ReplaySchedule(&replay, &table, workers, policy, 200);
+        uint64_t ticks = PlatformTimestamp() - start;
+        double   freq  = double(PlatformTimestampFrequency());
+        printf("schedule replay: %8u tasks, %-8s %2u workers, %7.2f ms (%5.2f M tasks/sec), makespan %8.3f ms, utilization %5.3f, %8u steals\n", task_count,
+            names[policy], workers, double(ticks) * 1000.0 / freq, double(task_count) * freq / double(ticks) / 1000000.0,
+            double(replay.Makespan) / 1000000.0, replay.Utilization, unsigned(replay.StealCount));
+    }
+}
+
+/// @summary Measure the cost of ranking entry points by virtual speedup. Each entry point costs one full replay, spread over all processors.
+/// @param task_count The number of tasks in the graph.
+/// @param max_entry_points The number of entry points to rank.
+internal_function void
+BenchmarkVirtualSpeedup
+(
+    uint32_t       task_count,
+    size_t   max_entry_points
+)
+{
+    WIN32_TASK_TABLE             table;
+    WIN32_VIRTUAL_SPEEDUP_REPORT report;
+    BuildSyntheticTaskGraph(&table, task_count);
+    uint64_t start = PlatformTimestamp();
+    RankVirtualSpeedups(&report, &table, 16, WIN32_SCHEDULER_POLICY_WORK_STEALING, 200, 20, max_entry_points, 0);
+    uint64_t ticks = PlatformTimestamp() - start;
+    double   freq  = double(PlatformTimestampFrequency());
+    printf("virtual speedup: %8u tasks, %3u entry points on %2u threads, %8.2f ms, best %llX %+.3f ms (efficiency %.2f)\n", task_count, unsigned(report.EntryCount),
+        PlatformProcessorCount(), double(ticks) * 1000.0 / freq, (unsigned long long) report.Entries[0].EntryPoint,
+        double(report.Entries[0].MakespanChange) / 1000000.0, report.Entries[0].Efficiency);
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+int main(int argc, char **argv)
+{
+    UNUSED(argc);
+    UNUSED(argv);
+
+    BenchmarkTimestampRead(10000000);
+    BenchmarkNativeEmit(1, 1000000, 1, 1, 0);
+    BenchmarkNativeEmit(2, 1000000, 1, 1, 0);
+    BenchmarkNativeEmit(4, 1000000, PlatformProcessorCount() > 8 ? PlatformProcessorCount() : 8, 1, 0);
+    BenchmarkNativeEmit(4, 1000000, 1, 16, 0);
+    BenchmarkNativeEmit(1, 1000000, 1, 1, 1);
+    BenchmarkNativeZone(4000000);
+    BenchmarkNativeAllocations(10000000, 10000, 8);
+    BenchmarkObjectIndex(1024, 1000000);
+    BenchmarkObjectIndex(65536, 1000000);
+    BenchmarkEventDecoder(10000000);
+    BenchmarkStringIntern(4096, 1000000);
+    BenchmarkTaskTable(1000000);
+    BenchmarkSnapshotPublish(10000000, 65536);
+    BenchmarkThreadIntervals(10000000, 10000000);
+    BenchmarkCpuTimeline(256, 40000, 64, 1000000);
+    BenchmarkWakeLatency(1000, 10000);
+    BenchmarkOffCpuReport(1000, 10000);
+    BenchmarkQueueDepth(10000000, 4096);
+    BenchmarkParallelismProfile(50000000);
+    BenchmarkTimelineLod(1000000, 4096);
+    BenchmarkTimelineLod(10000000, 4096);
+    BenchmarkCriticalPath(1000000);
+    BenchmarkCriticalPath(10000000);
+    BenchmarkScheduleReplay(1000000, WIN32_SCHEDULER_POLICY_FIFO);
+    BenchmarkScheduleReplay(1000000, WIN32_SCHEDULER_POLICY_LIFO);
+    BenchmarkScheduleReplay(1000000, WIN32_SCHEDULER_POLICY_WORK_STEALING);
+    BenchmarkVirtualSpeedup(1000000, 8);
+    return 0;
+}
@@ -0,0 +1,226 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implement the reconstruction of per-processor run segments from
+/// the switch columns of every thread. Each switch-in records the logical
+/// processor performing the switch; the thread then occupies that processor
+/// until it is switched out. Segments are regrouped by processor, labeled with
+/// the task the thread was executing, and summarized for drawing a core lane.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*//////////////////
+//   Data Types   //
+//////////////////*/
+/// @summary Define a run segment before it is stored in the columns of a WIN32_CPU_TIMELINE.
+struct CPU_TIMELINE_SEGMENT
+{
+    uint64_t                   Start;        /// The switch-in time, in nanoseconds.
+    uint64_t                   End;          /// The switch-out time, in nanoseconds.
+    uint32_t                   ThreadId;     /// The operating system thread identifier.
+    uint32_t                   ProcessIndex; /// The index of the process in WIN32_PROCESS_LIST::ProcessInfo.
+    uint32_t                   ThreadIndex;  /// The index of the thread in WIN32_PROCESS_INFO::ThreadInfo.
+    uint32_t                   Processor;    /// The zero-based index of the logical processor.
+};
+
+/*//////////////////////////
+//   Internal Functions   //
+//////////////////////////*/
+/// @summary Append the run segments of one thread. Each switch-in ends at the next switch-out; if the switch-out was lost, the next switch-in ends it.
+/// @param segments The list to which segments are appended.
+/// @param thread The thread whose switch columns are read.
+/// @param process_index The index of the process owning the thread.
+/// @param thread_index The index of the thread within the process.
+/// @param thread_id The operating system thread identifier.
+/// @param end_time The time at which a final segment with no switch-out ends, in nanoseconds.
+internal_function void
+GatherCpuSegments
+(
+    std::vector<CPU_TIMELINE_SEGMENT> &segments,
+    WIN32_THREAD_INFO const             *thread,
+    uint32_t                      process_index,
+    uint32_t                       thread_index,
+    uint32_t                          thread_id,
+    uint64_t                           end_time
+)
+{
+    size_t const in_count  = thread->SwitchInTime.size();
+    size_t const out_count = thread->SwitchOutTime.size();
+    size_t       out       = 0;
+    for (size_t i = 0; i < in_count; ++i)
+    {
+        uint64_t const start = thread->SwitchInTime[i];
+        while (out < out_count && thread->SwitchOutTime[out] < start)
+            out++;
+        uint64_t end = out < out_count ? thread->SwitchOutTime[out] : end_time;
+        if (i + 1 < in_count && thread->SwitchInTime[i + 1] < end)
+            end = thread->SwitchInTime[i + 1];
+        if (end > start)
+        {
+            CPU_TIMELINE_SEGMENT seg;
+            seg.Start        = start;
+            seg.End          = end;
+            seg.ThreadId     = thread_id;
+            seg.ProcessIndex = process_index;
+            seg.ThreadIndex  = thread_index;
+            seg.Processor    = thread->SwitchInData[i].Processor;
+            segments.push_back(seg);
+        }
+    }
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Free the memory used by a processor timeline. The timeline is left empty.
+/// @param cpu The processor timeline to delete.
+public_function void
+DeleteCpuTimeline
+(
+    WIN32_CPU_TIMELINE *cpu
+)
+{
+    cpu->ProcessorCount = 0;
+    cpu->SegmentCount   = 0;
+    WIN32_COLUMN<size_t  >().swap(cpu->ProcessorStart);
+    WIN32_COLUMN<uint64_t>().swap(cpu->Start);
+    WIN32_COLUMN<uint64_t>().swap(cpu->End);
+    WIN32_COLUMN<uint32_t>().swap(cpu->ThreadId);
+    WIN32_COLUMN<uint32_t>().swap(cpu->ProcessIndex);
+    WIN32_COLUMN<uint32_t>().swap(cpu->ThreadIndex);
+    WIN32_COLUMN<uint32_t>().swap(cpu->TaskRow);
+    std::vector<WIN32_LOD_PYRAMID>().swap(cpu->ProcessorLod);
+}
+
+/// @summary Reconstruct the run segments of each logical processor from the switch columns of every thread.
+/// Segments on one processor that overlap because of lost events are clipped to the start of the next segment.
+/// @param cpu The processor timeline to build. Any existing contents are replaced.
+/// @param process_list The process list, with thread intervals built by BuildProcessThreadIntervals.
+/// @param task_table The task table, with complete launch and finish columns.
+/// @param base_time The BaseTime of the processor pyramids, typically WIN32_TIMELINE_LOD::FirstTime.
+/// @param base_shift The BaseShift of the processor pyramids, typically WIN32_TIMELINE_LOD::BaseShift.
+public_function void
+BuildCpuTimeline
+(
+    WIN32_CPU_TIMELINE             *cpu,
+    WIN32_PROCESS_LIST const *process_list,
+    WIN32_TASK_TABLE const     *task_table,
+    uint64_t                     base_time,
+    uint32_t                    base_shift
+)
+{
+    std::vector<CPU_TIMELINE_SEGMENT>           segments;
+    std::vector<std::pair<uint64_t, size_t> >   order;
+    std::vector<std::pair<uint32_t, uint32_t> > worker_launch;
+    size_t                                      switch_count = 0;
+    uint32_t                                    max_processor = 0;
+
+    DeleteCpuTimeline(cpu);
+    for (size_t i = 0; i < process_list->ProcessCount; ++i)
+    {
+        WIN32_PROCESS_INFO const &proc = process_list->ProcessInfo[i];
+        for (size_t j = 0; j < proc.ThreadCount; ++j)
+            switch_count += proc.ThreadInfo[j].SwitchInTime.size();
+    }
+    segments.reserve(switch_count);
+    for (size_t i = 0; i < process_list->ProcessCount; ++i)
+    {
+        WIN32_PROCESS_INFO const &proc = process_list->ProcessInfo[i];
+        for (size_t j = 0; j < proc.ThreadCount; ++j)
+        {   // a thread still running when its history ends occupies its processor until then.
+            WIN32_THREAD_INTERVALS const &intervals = proc.ThreadInfo[j].Intervals;
+            size_t   const n   = intervals.IntervalCount;
+            uint64_t const end = n > 0 ? intervals.Start[n - 1] + intervals.Duration[n - 1] : 0;
+            GatherCpuSegments(segments, &proc.ThreadInfo[j], uint32_t(i), uint32_t(j), proc.ThreadId[j], end);
+        }
+    }
+
+    // group the segments by processor with a counting sort, then sort the (much shorter) list of each processor by start time.
+    size_t const count = segments.size();
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (segments[i].Processor > max_processor) max_processor = segments[i].Processor;
+    }
+    cpu->ProcessorCount = count > 0 ? size_t(max_processor) + 1 : 0;
+    cpu->SegmentCount   = count;
+    cpu->ProcessorStart.assign(cpu->ProcessorCount + 1, 0);
+    for (size_t i = 0; i < count; ++i)
+    {
+        cpu->ProcessorStart[segments[i].Processor + 1]++;
+    }
+    for (size_t p = 0; p < cpu->ProcessorCount; ++p)
+    {
+        cpu->ProcessorStart[p + 1] += cpu->ProcessorStart[p];
+    }
+    std::vector<size_t> next(cpu->ProcessorStart.begin(), cpu->ProcessorStart.end());
+    order.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        order[next[segments[i].Processor]++] = std::make_pair(segments[i].Start, i);
+    }
+    for (size_t p = 0; p < cpu->ProcessorCount; ++p)
+    {
+        std::sort(order.begin() + cpu->ProcessorStart[p], order.begin() + cpu->ProcessorStart[p + 1]);
+    }
+
+    BuildWorkerLaunchIndex(task_table, worker_launch);
+
+    cpu->Start.resize(count);
+    cpu->End.resize(count);
+    cpu->ThreadId.resize(count);
+    cpu->ProcessIndex.resize(count);
+    cpu->ThreadIndex.resize(count);
+    cpu->TaskRow.resize(count);
+    for (size_t p = 0; p < cpu->ProcessorCount; ++p)
+    {
+        for (size_t i = cpu->ProcessorStart[p], n = cpu->ProcessorStart[p + 1]; i < n; ++i)
+        {
+            CPU_TIMELINE_SEGMENT const &seg = segments[order[i].second];
+            uint64_t end = seg.End;
+            if (i + 1 < n && order[i + 1].first < end)
+                end = order[i + 1].first;
+            cpu->Start       [i] = seg.Start;
+            cpu->End         [i] = end;
+            cpu->ThreadId    [i] = seg.ThreadId;
+            cpu->ProcessIndex[i] = seg.ProcessIndex;
+            cpu->ThreadIndex [i] = seg.ThreadIndex;
+            cpu->TaskRow     [i] = FindWorkerTask(task_table, worker_launch, seg.ThreadId, seg.Start, end);
+        }
+    }
+
+    // WIN32_OBJECT_INDEX_EMPTY equals WIN32_LOD_NO_LABEL, so TaskRow labels the pyramids directly.
+    cpu->ProcessorLod.resize(cpu->ProcessorCount);
+    for (size_t p = 0; p < cpu->ProcessorCount; ++p)
+    {
+        size_t const first = cpu->ProcessorStart[p];
+        size_t const n     = cpu->ProcessorStart[p + 1] - first;
+        if (n > 0) BuildLodPyramid(&cpu->ProcessorLod[p], &cpu->Start[first], &cpu->End[first], &cpu->TaskRow[first], n, base_time, base_shift);
+        else       BuildLodPyramid(&cpu->ProcessorLod[p], NULL, NULL, NULL, 0, base_time, base_shift);
+    }
+}
+
+/// @summary Find the segment running on every logical processor at a given time, with one binary search per processor.
+/// @param cpu The processor timeline to search.
+/// @param time The time to look up, in nanoseconds.
+/// @param segment An array of ProcessorCount entries. On return, entry p is set to the index of the segment running on processor p, or WIN32_OBJECT_INDEX_EMPTY if it was idle.
+/// @return The number of processors that were running a thread.
+public_function size_t
+FindCpuSegmentsAtTime
+(
+    WIN32_CPU_TIMELINE const *cpu,
+    uint64_t                 time,
+    uint32_t             *segment
+)
+{
+    size_t busy = 0;
+    for (size_t p = 0; p < cpu->ProcessorCount; ++p)
+    {
+        WIN32_COLUMN<uint64_t>::const_iterator first = cpu->Start.begin() + cpu->ProcessorStart[p];
+        WIN32_COLUMN<uint64_t>::const_iterator last  = cpu->Start.begin() + cpu->ProcessorStart[p + 1];
+        size_t const i = size_t(std::upper_bound(first, last, time) - cpu->Start.begin());
+        if (i > cpu->ProcessorStart[p] && time < cpu->End[i - 1])
+        {
+            segment[p] = uint32_t(i - 1);
+            busy++;
+        }
+        else segment[p] = WIN32_OBJECT_INDEX_EMPTY;
+    }
+    return busy;
+}
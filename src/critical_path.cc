@@ -0,0 +1,210 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implement critical path analysis of the task dependency graph.
+/// Edges of the graph always run from a lower task table row to a higher one,
+/// so a forward pass in row order computes the earliest start of every task
+/// and the span, and a backward pass computes the latest start and slack.
+/// No sort or explicit topological ordering is needed.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*//////////////////////////
+//   Internal Functions   //
+//////////////////////////*/
+/// @summary Retrieve the observed execution time of a task. Tasks that were not seen to both launch and finish take no time.
+/// @param table The task table.
+/// @param row The task table row.
+/// @return The execution time of the task, in nanoseconds.
+internal_function inline uint64_t
+CriticalPathDuration
+(
+    WIN32_TASK_TABLE const *table,
+    size_t                    row
+)
+{
+    uint64_t const launch = table->LaunchTime[row];
+    uint64_t const finish = table->FinishTime[row];
+    return (launch != 0 && finish >= launch) ? finish - launch : 0;
+}
+
+/// @summary Compute how far into the execution of its parent a task was defined. A child cannot start before its parent reaches that point.
+/// @param table The task table.
+/// @param parent The task table row of the parent.
+/// @param child The task table row of the child.
+/// @param parent_duration The value returned by CriticalPathDuration for the parent.
+/// @return The offset from the start of the parent, in nanoseconds, clamped to the parent execution time. Zero if either time was not observed.
+internal_function inline uint64_t
+CriticalPathSpawnOffset
+(
+    WIN32_TASK_TABLE const *table,
+    size_t                 parent,
+    size_t                  child,
+    uint64_t      parent_duration
+)
+{
+    uint64_t const launch = table->LaunchTime[parent];
+    uint64_t const define = table->DefineTime[child];
+    if (launch == 0 || define <= launch)
+        return 0;
+    return (define - launch) < parent_duration ? (define - launch) : parent_duration;
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Free the memory used by a critical path analysis. The analysis is left empty.
+/// @param cp The critical path analysis to delete.
+public_function void
+DeleteCriticalPath
+(
+    WIN32_CRITICAL_PATH *cp
+)
+{
+    cp->TaskCount       = 0;
+    cp->TotalWork       = 0;
+    cp->Span            = 0;
+    cp->MaxSpeedup      = 0.0;
+    cp->EntryPointCount = 0;
+    WIN32_COLUMN<uint64_t>().swap(cp->EarliestStart);
+    WIN32_COLUMN<uint64_t>().swap(cp->Slack);
+    WIN32_COLUMN<uint32_t>().swap(cp->CriticalPred);
+    WIN32_COLUMN<uint32_t>().swap(cp->PathRow);
+    WIN32_COLUMN<uint64_t>().swap(cp->EntryPoint);
+    WIN32_COLUMN<uint64_t>().swap(cp->EntryPointTime);
+    DeleteLodPyramid(&cp->PathLod);
+}
+
+/// @summary Compute the critical path, total work, span, maximum speedup and per-task slack of a task dependency graph.
+/// The running time is linear in the number of tasks and edges, plus a sort of the tasks on the critical path.
+/// @param cp The critical path analysis to build. Any existing contents are replaced.
+/// @param table The task table, with the dependency graph built by BuildTaskDependencyGraph.
+/// @param base_time The BaseTime of the pyramid summarizing the critical path, typically WIN32_TIMELINE_LOD::FirstTime.
+/// @param base_shift The BaseShift of the pyramid summarizing the critical path, typically WIN32_TIMELINE_LOD::BaseShift.
+public_function void
+BuildCriticalPath
+(
+    WIN32_CRITICAL_PATH    *cp,
+    WIN32_TASK_TABLE const *table,
+    uint64_t            base_time,
+    uint32_t           base_shift
+)
+{
+    size_t const task_count = table->TaskCount;
+    uint64_t     work       = 0;
+    uint64_t     span       = 0;
+    uint32_t     last_row   = WIN32_OBJECT_INDEX_EMPTY;
+
+    DeleteCriticalPath(cp);
+    cp->TaskCount = task_count;
+    if (task_count == 0 || table->ParentRow.size() != task_count)
+        return;
+    cp->EarliestStart.resize(task_count);
+    cp->Slack.resize(task_count);
+    cp->CriticalPred.resize(task_count);
+
+    // forward pass: every predecessor and parent of a row has a lower row, so its earliest start is already final.
+    for (size_t r = 0; r < task_count; ++r)
+    {
+        uint64_t const duration = CriticalPathDuration(table, r);
+        uint64_t       start    = 0;
+        uint32_t       pred     = WIN32_OBJECT_INDEX_EMPTY;
+        uint32_t const parent   = table->ParentRow[r];
+        if (parent != WIN32_OBJECT_INDEX_EMPTY)
+        {
+            start = cp->EarliestStart[parent] + CriticalPathSpawnOffset(table, parent, r, CriticalPathDuration(table, parent));
+            pred  = parent;
+        }
+        for (uint32_t e = table->DependencyStart[r], end = table->DependencyStart[r + 1]; e < end; ++e)
+        {
+            uint32_t const dep    = table->DependencyRow[e];
+            uint64_t const finish = cp->EarliestStart[dep] + CriticalPathDuration(table, dep);
+            if (finish > start || pred == WIN32_OBJECT_INDEX_EMPTY)
+            {
+                start = finish;
+                pred  = dep;
+            }
+        }
+        cp->EarliestStart[r] = start;
+        cp->CriticalPred [r] = pred;
+        if (start + duration > span || last_row == WIN32_OBJECT_INDEX_EMPTY)
+        {
+            span     = start + duration;
+            last_row = uint32_t(r);
+        }
+        work += duration;
+    }
+    cp->TotalWork  = work;
+    cp->Span       = span;
+    cp->MaxSpeedup = span > 0 ? double(work) / double(span) : 0.0;
+
+    // backward pass: Slack holds the latest finish of each row until the row is visited, then its slack.
+    // every successor and child of a row has a higher row, so its latest start is final by then.
+    std::fill(cp->Slack.begin(), cp->Slack.end(), span);
+    for (size_t r = task_count; r-- > 0; )
+    {
+        uint64_t const duration = CriticalPathDuration(table, r);
+        uint64_t const latest   = cp->Slack[r] - duration;
+        uint32_t const parent   = table->ParentRow[r];
+        cp->Slack[r] = latest - cp->EarliestStart[r];
+        for (uint32_t e = table->DependencyStart[r], end = table->DependencyStart[r + 1]; e < end; ++e)
+        {
+            uint32_t const dep = table->DependencyRow[e];
+            if (latest < cp->Slack[dep]) cp->Slack[dep] = latest;
+        }
+        if (parent != WIN32_OBJECT_INDEX_EMPTY)
+        {   // the parent must reach the spawn point by the latest start of the child.
+            uint64_t const parent_duration = CriticalPathDuration(table, parent);
+            uint64_t const finish = latest - CriticalPathSpawnOffset(table, parent, r, parent_duration) + parent_duration;
+            if (finish < cp->Slack[parent]) cp->Slack[parent] = finish;
+        }
+    }
+
+    // walk the critical predecessors back from the task that finishes last.
+    for (uint32_t r = last_row; r != WIN32_OBJECT_INDEX_EMPTY; r = cp->CriticalPred[r])
+    {
+        cp->PathRow.push_back(r);
+    }
+    std::reverse(cp->PathRow.begin(), cp->PathRow.end());
+
+    // total the time spent on the critical path by each entry point, longest first.
+    std::vector<std::pair<uint64_t, uint64_t> > entry(cp->PathRow.size());
+    std::vector<std::pair<uint64_t, uint64_t> > total;
+    for (size_t i = 0, n = cp->PathRow.size(); i < n; ++i)
+    {
+        entry[i] = std::make_pair(table->EntryPoint[cp->PathRow[i]], CriticalPathDuration(table, cp->PathRow[i]));
+    }
+    std::sort(entry.begin(), entry.end());
+    for (size_t i = 0, n = entry.size(); i < n; ++i)
+    {
+        if (total.empty() || total.back().second != entry[i].first)
+            total.push_back(std::make_pair(uint64_t(0), entry[i].first));
+        total.back().first += entry[i].second;
+    }
+    std::sort(total.rbegin(), total.rend());
+    cp->EntryPointCount = total.size();
+    cp->EntryPoint.resize(total.size());
+    cp->EntryPointTime.resize(total.size());
+    for (size_t i = 0, n = total.size(); i < n; ++i)
+    {
+        cp->EntryPoint    [i] = total[i].second;
+        cp->EntryPointTime[i] = total[i].first;
+    }
+
+    // summarize the observed execution of the critical path so it can be drawn as a timeline row.
+    std::vector<std::pair<uint64_t, uint32_t> > launch;
+    for (size_t i = 0, n = cp->PathRow.size(); i < n; ++i)
+    {
+        uint32_t const r = cp->PathRow[i];
+        if (table->LaunchTime[r] >= base_time && table->LaunchTime[r] != 0 && table->FinishTime[r] >= table->LaunchTime[r])
+            launch.push_back(std::make_pair(table->LaunchTime[r], r));
+    }
+    std::sort(launch.begin(), launch.end());
+    std::vector<uint64_t> span_start(launch.size());
+    std::vector<uint64_t> span_end  (launch.size());
+    std::vector<uint32_t> span_label(launch.size());
+    for (size_t i = 0, n = launch.size(); i < n; ++i)
+    {
+        span_start[i] = launch[i].first;
+        span_end  [i] = table->FinishTime[launch[i].second];
+        span_label[i] = launch[i].second;
+    }
+    BuildLodPyramid(&cp->PathLod, span_start.data(), span_end.data(), span_label.data(), launch.size(), base_time, base_shift);
+}
@@ -1,23 +1,58 @@
 /*/////////////////////////////////////////////////////////////////////////////
 /// @summary Implement the entry point of the profiler DLL. This file includes 
-/// the actual profiler implementation, located in profiler.cc.
+/// the actual profiler implementation, located in profiler.cc, or the native
+/// ring-buffer implementation, located in profiler_native.cc.
 ///////////////////////////////////////////////////////////////////////////80*/
 
 /*////////////////////
 //   Preprocessor   //
 ////////////////////*/
+/// @summary Specify PROFILER_NATIVE_BACKEND as 1 to write events to per-thread buffers and a native trace file.
+/// Specify PROFILER_NATIVE_BACKEND as 0 to forward events to ETW.
+#ifndef PROFILER_NATIVE_BACKEND
+#define PROFILER_NATIVE_BACKEND   0
+#endif
+
+/// @summary Tag used to mark a function as available for public use, but not exported outside of the translation unit.
+#ifndef public_function
+    #define public_function       static
+#endif
+
+/// @summary Tag used to mark a function internal to the translation unit.
+#ifndef internal_function
+    #define internal_function     static
+#endif
+
+/// @summary Tag used to mark a variable as global to the translation unit.
+#ifndef global_variable
+    #define global_variable       static
+#endif
 
 /*////////////////
 //   Includes   //
 ////////////////*/
+#include <atomic>
+#include <vector>
+
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <windows.h>
 
-#include "provider.h"  // generated from the profiler_etw.man instrumentation manifest.
-#include "profiler.h"  // manually written profiler loader interface.
-#include "profiler.cc" // the public functions of the profiler interface that forward data to ETW.
+#if PROFILER_NATIVE_BACKEND
+#include "profiler.h"         // manually written profiler loader interface.
+#include "ptrace.h"          // the .ptrace trace file format.
+#include "platform.cc"        // thread, mutex and timer wrappers.
+#include "ptrace_codec.cc"    // compact event stream encoding.
+#include "profiler_native.cc" // the public functions of the profiler interface that write to per-thread buffers.
+#else
+#include "provider.h"         // generated from the profiler_etw.man instrumentation manifest.
+#include "profiler.h"         // manually written profiler loader interface.
+#include "profiler.cc"        // the public functions of the profiler interface that forward data to ETW.
+#endif
 
 /*//////////////////
 //   Data Types   //
@@ -0,0 +1,281 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implement decoder plans for trace event payloads. The first time
+/// an event schema is seen, the byte offset of each fixed-size property is
+/// computed and cached; every later event with the same schema is decoded
+/// with direct loads from its user data. This file has no dependency on TDH
+/// so that plans can be tested and benchmarked with synthetic payloads.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////////
+//   Preprocessor   //
+////////////////////*/
+/// @summary Define the value passed to InitEventDecoderPlan for a property whose size depends on the payload.
+#ifndef WIN32_EVENT_FIELD_VARIABLE
+#define WIN32_EVENT_FIELD_VARIABLE             0
+#endif
+
+/// @summary Define the minimum number of slots allocated for a non-empty decoder cache. Must be a power of two.
+#ifndef WIN32_EVENT_DECODER_MIN_SLOTS
+#define WIN32_EVENT_DECODER_MIN_SLOTS          64
+#endif
+
+/*//////////////////////////
+//   Internal Functions   //
+//////////////////////////*/
+/// @summary Compute the hash of an event schema key.
+/// @param key The schema key.
+/// @return The 64-bit hash value.
+internal_function inline uint64_t
+EventSchemaKeyHash
+(
+    WIN32_EVENT_SCHEMA_KEY const &key
+)
+{
+    uint64_t w[3];
+    memcpy(w, &key, sizeof(w));
+    return ObjectIndexHash(w[0] ^ ObjectIndexHash(w[1] ^ ObjectIndexHash(w[2])));
+}
+
+/// @summary Determine whether two event schema keys are equal.
+/// @param a The first key.
+/// @param b The second key.
+/// @return true if the keys are equal.
+internal_function inline bool
+EventSchemaKeyEqual
+(
+    WIN32_EVENT_SCHEMA_KEY const &a,
+    WIN32_EVENT_SCHEMA_KEY const &b
+)
+{
+    return memcmp(&a, &b, sizeof(WIN32_EVENT_SCHEMA_KEY)) == 0;
+}
+
+/// @summary Locate the slot for a schema key using linear probing.
+/// @param cache The decoder cache to search. SlotCount must be non-zero.
+/// @param key The key to locate.
+/// @return The zero-based index of the slot holding the key, or of the empty slot where the key would be inserted.
+internal_function size_t
+EventDecoderCacheProbe
+(
+    WIN32_EVENT_DECODER_CACHE const *cache,
+    WIN32_EVENT_SCHEMA_KEY    const   &key
+)
+{
+    size_t const mask = cache->SlotCount - 1;
+    size_t       slot = size_t(EventSchemaKeyHash(key)) & mask;
+    while (cache->SlotPlan[slot] != WIN32_OBJECT_INDEX_EMPTY && !EventSchemaKeyEqual(cache->SlotKey[slot], key))
+    {   // the load factor is kept below 1/2, so an empty slot is always found.
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Compute the layout of an event schema from the sizes of its top-level properties.
+/// @param plan The plan to initialize. The EventInfo field is set to NULL.
+/// @param field_sizes The size of each top-level property in bytes, or WIN32_EVENT_FIELD_VARIABLE.
+/// @param field_count The number of top-level properties.
+public_function void
+InitEventDecoderPlan
+(
+    WIN32_EVENT_DECODER_PLAN *plan,
+    uint32_t const    *field_sizes,
+    uint32_t           field_count
+)
+{
+    uint32_t offset = 0;
+    uint32_t fixed  = 0;
+    memset(plan, 0, sizeof(WIN32_EVENT_DECODER_PLAN));
+    // properties after the first variable-size property have payload-dependent offsets.
+    while (fixed < field_count && fixed < WIN32_EVENT_DECODER_MAX_FIELDS)
+    {
+        uint32_t size = field_sizes[fixed];
+        if (size == WIN32_EVENT_FIELD_VARIABLE || size > 0xFF || offset + size > 0xFFFF)
+            break;
+        plan->FieldOffset[fixed] = uint16_t(offset);
+        plan->FieldSize  [fixed] = uint8_t (size);
+        offset += size;
+        fixed++;
+    }
+    plan->FieldCount  = field_count;
+    plan->FixedCount  = fixed;
+    plan->PayloadSize = offset;
+    plan->EventInfo   = NULL;
+}
+
+/// @summary Determine whether a property can be loaded directly from an event payload using a decoder plan.
+/// @param plan The decoder plan for the event schema.
+/// @param data_size The size of the event user data, in bytes.
+/// @param index The zero-based index of the top-level property.
+/// @return true if the property is at a fixed offset and lies within the payload.
+public_function inline bool
+EventDecoderHasField
+(
+    WIN32_EVENT_DECODER_PLAN const *plan,
+    size_t                     data_size,
+    size_t                         index
+)
+{
+    return (plan != NULL && index < plan->FixedCount && size_t(plan->FieldOffset[index]) + plan->FieldSize[index] <= data_size);
+}
+
+/// @summary Load a 32-bit unsigned integer property from an event payload.
+/// @param plan The decoder plan for the event schema.
+/// @param data The event user data.
+/// @param index The zero-based index of the top-level property. EventDecoderHasField must return true for the property.
+/// @return The property value.
+public_function inline uint32_t
+EventDecoderGetUInt32
+(
+    WIN32_EVENT_DECODER_PLAN const *plan,
+    void const                     *data,
+    size_t                         index
+)
+{
+    uint32_t value;
+    memcpy(&value, (uint8_t const*) data + plan->FieldOffset[index], sizeof(value));
+    return value;
+}
+
+/// @summary Load a pointer-size unsigned integer property from an event payload. The property may be 4 or 8 bytes.
+/// @param plan The decoder plan for the event schema.
+/// @param data The event user data.
+/// @param index The zero-based index of the top-level property. EventDecoderHasField must return true for the property.
+/// @return The property value, zero-extended to 64 bits.
+public_function inline uint64_t
+EventDecoderGetPointer
+(
+    WIN32_EVENT_DECODER_PLAN const *plan,
+    void const                     *data,
+    size_t                         index
+)
+{
+    if (plan->FieldSize[index] == sizeof(uint32_t))
+    {   // the event was produced by a 32-bit process.
+        return EventDecoderGetUInt32(plan, data, index);
+    }
+    uint64_t value;
+    memcpy(&value, (uint8_t const*) data + plan->FieldOffset[index], sizeof(value));
+    return value;
+}
+
+/// @summary Load an 8-bit signed integer property from an event payload.
+/// @param plan The decoder plan for the event schema.
+/// @param data The event user data.
+/// @param index The zero-based index of the top-level property. EventDecoderHasField must return true for the property.
+/// @return The property value.
+public_function inline int8_t
+EventDecoderGetSInt8
+(
+    WIN32_EVENT_DECODER_PLAN const *plan,
+    void const                     *data,
+    size_t                         index
+)
+{
+    return int8_t(((uint8_t const*) data)[plan->FieldOffset[index]]);
+}
+
+/// @summary Initialize an empty decoder cache. No memory is allocated until the first insertion.
+/// @param cache The decoder cache to initialize.
+public_function void
+InitEventDecoderCache
+(
+    WIN32_EVENT_DECODER_CACHE *cache
+)
+{
+    cache->SlotCount = 0;
+    cache->PlanCount = 0;
+    cache->SlotKey.clear();
+    cache->SlotPlan.clear();
+    cache->Plans.clear();
+    cache->LastPlan  = WIN32_OBJECT_INDEX_EMPTY;
+}
+
+/// @summary Free all resources associated with a decoder cache, including the cached schema metadata.
+/// @param cache The decoder cache to delete.
+public_function void
+DeleteEventDecoderCache
+(
+    WIN32_EVENT_DECODER_CACHE *cache
+)
+{
+    for (size_t i = 0; i < cache->PlanCount; ++i)
+    {
+        free(cache->Plans[i].EventInfo);
+    }
+    InitEventDecoderCache(cache);
+}
+
+/// @summary Search a decoder cache for the plan for an event schema.
+/// @param cache The decoder cache to search.
+/// @param key The schema key.
+/// @return The decoder plan, or NULL if the schema has not been seen yet. The pointer is valid until the next insertion.
+public_function WIN32_EVENT_DECODER_PLAN*
+FindEventDecoderPlan
+(
+    WIN32_EVENT_DECODER_CACHE    *cache,
+    WIN32_EVENT_SCHEMA_KEY const   &key
+)
+{
+    if (cache->LastPlan != WIN32_OBJECT_INDEX_EMPTY && EventSchemaKeyEqual(cache->SlotKey[cache->LastPlan], key))
+    {   // LastPlan stores a slot index; events of one schema usually arrive in runs.
+        return &cache->Plans[cache->SlotPlan[cache->LastPlan]];
+    }
+    if (cache->PlanCount == 0)
+    {   // early out - the cache is empty.
+        return NULL;
+    }
+    size_t const slot = EventDecoderCacheProbe(cache, key);
+    if (cache->SlotPlan[slot] == WIN32_OBJECT_INDEX_EMPTY)
+    {   // the schema has not been seen yet.
+        return NULL;
+    }
+    cache->LastPlan = uint32_t(slot);
+    return &cache->Plans[cache->SlotPlan[slot]];
+}
+
+/// @summary Add a plan to a decoder cache. The cache takes ownership of plan->EventInfo, which must be allocated with malloc.
+/// @param cache The decoder cache to update.
+/// @param key The schema key. The key must not already be present in the cache.
+/// @param plan The decoder plan to copy into the cache.
+/// @return A pointer to the cached plan. The pointer is valid until the next insertion.
+public_function WIN32_EVENT_DECODER_PLAN*
+InsertEventDecoderPlan
+(
+    WIN32_EVENT_DECODER_CACHE      *cache,
+    WIN32_EVENT_SCHEMA_KEY const     &key,
+    WIN32_EVENT_DECODER_PLAN const  *plan
+)
+{
+    if ((cache->PlanCount + 1) * 2 > cache->SlotCount)
+    {   // grow the slot table and re-insert all keys. plans are indexed, so they don't move.
+        size_t const new_count = cache->SlotCount == 0 ? WIN32_EVENT_DECODER_MIN_SLOTS : cache->SlotCount * 2;
+        std::vector<WIN32_EVENT_SCHEMA_KEY> old_key;
+        std::vector<uint32_t>               old_plan;
+        WIN32_EVENT_SCHEMA_KEY              zero_key;
+        memset(&zero_key, 0, sizeof(zero_key));
+        old_key.swap(cache->SlotKey);
+        old_plan.swap(cache->SlotPlan);
+        cache->SlotKey.assign(new_count, zero_key);
+        cache->SlotPlan.assign(new_count, WIN32_OBJECT_INDEX_EMPTY);
+        cache->SlotCount = new_count;
+        for (size_t i = 0, n = old_plan.size(); i < n; ++i)
+        {
+            if (old_plan[i] != WIN32_OBJECT_INDEX_EMPTY)
+            {
+                size_t slot = EventDecoderCacheProbe(cache, old_key[i]);
+                cache->SlotKey [slot] = old_key [i];
+                cache->SlotPlan[slot] = old_plan[i];
+            }
+        }
+    }
+    size_t const slot     = EventDecoderCacheProbe(cache, key);
+    cache->SlotKey [slot] = key;
+    cache->SlotPlan[slot] = uint32_t(cache->PlanCount);
+    cache->Plans.push_back(*plan);
+    cache->PlanCount++;
+    cache->LastPlan       = uint32_t(slot);
+    return &cache->Plans.back();
+}
@@ -0,0 +1,152 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implement log-linear latency histograms. Every histogram uses the
+/// same bucket boundaries: values below 2^WIN32_LATENCY_HISTOGRAM_SUB_BITS are
+/// counted exactly, and each larger power of two is divided into that many
+/// equal buckets, bounding the relative error of any percentile. Histograms
+/// built separately, for example per thread, merge by adding bucket counts.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*//////////////////////////
+//   Internal Functions   //
+//////////////////////////*/
+/// @summary Compute the base-2 logarithm of a value, rounded down.
+/// @param value The value. Must be non-zero.
+/// @return The index of the most significant set bit of value.
+internal_function inline uint32_t
+LatencyHistogramLog2
+(
+    uint64_t value
+)
+{
+    uint32_t n = 0;
+    if (value >> 32) { value >>= 32; n += 32; }
+    if (value >> 16) { value >>= 16; n += 16; }
+    if (value >>  8) { value >>=  8; n +=  8; }
+    if (value >>  4) { value >>=  4; n +=  4; }
+    if (value >>  2) { value >>=  2; n +=  2; }
+    if (value >>  1) {               n +=  1; }
+    return n;
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Compute the histogram bucket that counts a value.
+/// @param value The value, in nanoseconds.
+/// @return The zero-based bucket index.
+public_function inline size_t
+LatencyHistogramBucket
+(
+    uint64_t value
+)
+{
+    uint64_t const sub = uint64_t(1) << WIN32_LATENCY_HISTOGRAM_SUB_BITS;
+    if (value < sub)
+        return size_t(value);
+    uint32_t const e = LatencyHistogramLog2(value);
+    return size_t((e - WIN32_LATENCY_HISTOGRAM_SUB_BITS + 1) * sub + ((value >> (e - WIN32_LATENCY_HISTOGRAM_SUB_BITS)) - sub));
+}
+
+/// @summary Compute the smallest value counted by a histogram bucket.
+/// @param bucket The zero-based bucket index.
+/// @return The lower bound of the bucket, in nanoseconds.
+public_function inline uint64_t
+LatencyHistogramBucketLow
+(
+    size_t bucket
+)
+{
+    uint64_t const sub = uint64_t(1) << WIN32_LATENCY_HISTOGRAM_SUB_BITS;
+    if (bucket < sub)
+        return uint64_t(bucket);
+    uint32_t const e = uint32_t(bucket >> WIN32_LATENCY_HISTOGRAM_SUB_BITS) + WIN32_LATENCY_HISTOGRAM_SUB_BITS - 1;
+    return ((bucket & (sub - 1)) + sub) << (e - WIN32_LATENCY_HISTOGRAM_SUB_BITS);
+}
+
+/// @summary Free the memory used by a latency histogram. The histogram is left empty.
+/// @param h The histogram to delete.
+public_function void
+DeleteLatencyHistogram
+(
+    WIN32_LATENCY_HISTOGRAM *h
+)
+{
+    h->Count = 0;
+    h->Total = 0;
+    h->Min   = 0;
+    h->Max   = 0;
+    WIN32_COLUMN<uint64_t>().swap(h->Bucket);
+}
+
+/// @summary Record a value in a latency histogram.
+/// @param h The histogram to update.
+/// @param value The value to record, in nanoseconds.
+public_function void
+LatencyHistogramAdd
+(
+    WIN32_LATENCY_HISTOGRAM *h,
+    uint64_t             value
+)
+{
+    size_t const b = LatencyHistogramBucket(value);
+    if (b >= h->Bucket.size())
+        h->Bucket.resize(b + 1, 0);
+    h->Bucket[b]++;
+    if (h->Count == 0 || value < h->Min) h->Min = value;
+    if (h->Count == 0 || value > h->Max) h->Max = value;
+    h->Count++;
+    h->Total += value;
+}
+
+/// @summary Add the counts of one latency histogram to another.
+/// @param dst The histogram to update.
+/// @param src The histogram whose counts are added.
+public_function void
+MergeLatencyHistogram
+(
+    WIN32_LATENCY_HISTOGRAM       *dst,
+    WIN32_LATENCY_HISTOGRAM const *src
+)
+{
+    if (src->Count == 0)
+        return;
+    if (src->Bucket.size() > dst->Bucket.size())
+        dst->Bucket.resize(src->Bucket.size(), 0);
+    for (size_t i = 0, n = src->Bucket.size(); i < n; ++i)
+    {
+        dst->Bucket[i] += src->Bucket[i];
+    }
+    if (dst->Count == 0 || src->Min < dst->Min) dst->Min = src->Min;
+    if (dst->Count == 0 || src->Max > dst->Max) dst->Max = src->Max;
+    dst->Count += src->Count;
+    dst->Total += src->Total;
+}
+
+/// @summary Estimate a percentile of the values recorded in a latency histogram.
+/// @param h The histogram to query.
+/// @param percentile The percentile to compute, in [0, 100].
+/// @return The largest value counted by the bucket containing the percentile, clamped to the recorded maximum, or 0 if the histogram is empty.
+public_function uint64_t
+LatencyHistogramPercentile
+(
+    WIN32_LATENCY_HISTOGRAM const *h,
+    double                percentile
+)
+{
+    if (h->Count == 0)
+        return 0;
+    uint64_t rank = uint64_t(double(h->Count) * percentile / 100.0 + 0.5);
+    uint64_t seen = 0;
+    if (rank < 1) rank = 1;
+    if (rank > h->Count) rank = h->Count;
+    for (size_t i = 0, n = h->Bucket.size(); i < n; ++i)
+    {
+        seen += h->Bucket[i];
+        if (seen >= rank)
+        {
+            uint64_t const high = LatencyHistogramBucketLow(i + 1) - 1;
+            return high < h->Max ? high : h->Max;
+        }
+    }
+    return h->Max;
+}
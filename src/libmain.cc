@@ -0,0 +1,41 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implement the entry point of the profiler shared library on non-
+/// Windows platforms. This file includes the native ring-buffer profiler 
+/// implementation, located in profiler_native.cc.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////////
+//   Preprocessor   //
+////////////////////*/
+/// @summary Tag used to mark a function as available for public use, but not exported outside of the translation unit.
+#ifndef public_function
+    #define public_function       static
+#endif
+
+/// @summary Tag used to mark a function internal to the translation unit.
+#ifndef internal_function
+    #define internal_function     static
+#endif
+
+/// @summary Tag used to mark a variable as global to the translation unit.
+#ifndef global_variable
+    #define global_variable       static
+#endif
+
+/*////////////////
+//   Includes   //
+////////////////*/
+#include <atomic>
+#include <vector>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "profiler.h"         // manually written profiler loader interface.
+#include "ptrace.h"          // the .ptrace trace file format.
+#include "platform.cc"        // thread, mutex and timer wrappers.
+#include "ptrace_codec.cc"    // compact event stream encoding.
+#include "profiler_native.cc" // the public functions of the profiler interface that write to per-thread buffers.
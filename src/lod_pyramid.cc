@@ -0,0 +1,668 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implement multi-resolution summaries of timeline rows. Each row
+/// (a thread or a worker) is summarized by a pyramid of power-of-two time
+/// buckets. Level 0 buckets are the finest; each bucket at level l+1 covers
+/// two buckets at level l. Every bucket records the fraction of its time the
+/// row was busy, and the label (task) that was busy for the longest. Drawing a
+/// row reads at most a few buckets per pixel, regardless of trace length.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////////
+//   Preprocessor   //
+////////////////////*/
+/// @summary Define the base-2 logarithm of the narrowest level 0 bucket, in nanoseconds.
+#ifndef WIN32_LOD_MIN_SHIFT
+#define WIN32_LOD_MIN_SHIFT                    10
+#endif
+
+/// @summary Define the maximum number of level 0 buckets spanning the whole trace. The level 0 bucket width
+/// is the narrowest power of two that covers the trace in this many buckets, which bounds the memory per row.
+#ifndef WIN32_LOD_MAX_BASE_BUCKETS
+#define WIN32_LOD_MAX_BASE_BUCKETS             65536
+#endif
+
+/// @summary Define the minimum number of buckets sampled per pixel. Buckets straddling a pixel edge blur it by up to one
+/// bucket width, so sampling finer buckets sharpens span edges at the cost of reading more buckets per pixel.
+#ifndef WIN32_LOD_BUCKETS_PER_PIXEL
+#define WIN32_LOD_BUCKETS_PER_PIXEL            2
+#endif
+
+/*//////////////////////////
+//   Internal Functions   //
+//////////////////////////*/
+/// @summary Convert a busy time within a bucket to the fixed-point fraction stored in a pyramid.
+/// @param busy The busy time within the bucket, in nanoseconds.
+/// @param shift The base-2 logarithm of the bucket width, in nanoseconds.
+/// @return The busy fraction, scaled so that 65535 means busy for the entire bucket.
+internal_function inline uint16_t
+LodFraction
+(
+    uint64_t busy,
+    uint32_t shift
+)
+{
+    double const f = double(busy) / double(uint64_t(1) << shift);
+    return f >= 1.0 ? uint16_t(65535) : uint16_t(f * 65535.0 + 0.5);
+}
+
+/// @summary Convert the running intervals of a thread into a list of non-overlapping run spans.
+/// @param thread The thread whose intervals, built by BuildThreadIntervals, are read.
+/// @param span_start The vector to which the start time of each span is appended.
+/// @param span_end The vector to which the end time of each span is appended.
+internal_function void
+GatherThreadRunSpans
+(
+    WIN32_THREAD_INFO const *thread,
+    std::vector<uint64_t> &span_start,
+    std::vector<uint64_t>   &span_end
+)
+{
+    WIN32_THREAD_INTERVALS const &intervals = thread->Intervals;
+    for (size_t i = 0; i < intervals.IntervalCount; ++i)
+    {
+        if (intervals.State[i] != WIN32_THREAD_STATE_RUNNING)
+            continue;
+        uint64_t const start = intervals.Start[i];
+        uint64_t const end   = start + intervals.Duration[i];
+        if (!span_end.empty() && span_end.back() == start)
+        {   // a run too long for one interval was split; rejoin the pieces.
+            span_end.back() = end;
+            continue;
+        }
+        span_start.push_back(start);
+        span_end.push_back(end);
+    }
+}
+
+/// @summary Compute the bucket layout of a pyramid. Each level halves the bucket count, until the buckets from first_bucket to last_bucket are covered by one bucket.
+/// @param level_first The vector set to the index of the first stored bucket of each level.
+/// @param level_start The vector set to the offset of the buckets of each level, plus a final entry equal to the total bucket count.
+/// @param first_bucket The index of the first level 0 bucket to store.
+/// @param last_bucket The index of the last level 0 bucket to store.
+/// @return The number of levels.
+internal_function uint32_t
+LodLevelLayout
+(
+    WIN32_COLUMN<uint64_t> &level_first,
+    WIN32_COLUMN<size_t>   &level_start,
+    uint64_t              first_bucket,
+    uint64_t               last_bucket
+)
+{
+    uint32_t level_count = 1;
+    size_t   total       = 0;
+    while ((first_bucket >> (level_count - 1)) != (last_bucket >> (level_count - 1)))
+        level_count++;
+    level_first.resize(level_count);
+    level_start.resize(level_count + 1);
+    for (uint32_t level = 0; level < level_count; ++level)
+    {
+        level_first[level] = first_bucket >> level;
+        level_start[level] = total;
+        total += size_t((last_bucket >> level) - (first_bucket >> level) + 1);
+    }
+    level_start[level_count] = total;
+    return level_count;
+}
+
+/// @summary Select the coarsest level that still has WIN32_LOD_BUCKETS_PER_PIXEL buckets per pixel.
+/// @param base_shift The base-2 logarithm of the level 0 bucket width, in nanoseconds.
+/// @param level_count The number of levels.
+/// @param pixel_width The width of one pixel, in nanoseconds.
+/// @return The zero-based level.
+internal_function uint32_t
+LodLevelForPixel
+(
+    uint32_t   base_shift,
+    uint32_t  level_count,
+    double    pixel_width
+)
+{
+    uint32_t level = 0;
+    while (level + 1 < level_count && double(uint64_t(1) << (base_shift + level + 1)) * WIN32_LOD_BUCKETS_PER_PIXEL <= pixel_width)
+        level++;
+    return level;
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Choose the level 0 bucket width for a trace so that the whole trace spans at most WIN32_LOD_MAX_BASE_BUCKETS buckets.
+/// @param first_time The timestamp of the first event in the trace, in nanoseconds.
+/// @param last_time The timestamp of the last event in the trace, in nanoseconds.
+/// @return The base-2 logarithm of the level 0 bucket width, in nanoseconds.
+public_function uint32_t
+LodBaseShift
+(
+    uint64_t first_time,
+    uint64_t  last_time
+)
+{
+    uint64_t const span  = last_time > first_time ? last_time - first_time : 0;
+    uint32_t       shift = WIN32_LOD_MIN_SHIFT;
+    while (shift < 62 && (span >> shift) >= WIN32_LOD_MAX_BASE_BUCKETS)
+        shift++;
+    return shift;
+}
+
+/// @summary Release the storage held by a pyramid, leaving it empty.
+/// @param pyr The pyramid to reset.
+public_function void
+DeleteLodPyramid
+(
+    WIN32_LOD_PYRAMID *pyr
+)
+{
+    pyr->BaseTime   = 0;
+    pyr->BaseShift  = 0;
+    pyr->LevelCount = 0;
+    WIN32_COLUMN<uint64_t>().swap(pyr->LevelFirst);
+    WIN32_COLUMN<size_t  >().swap(pyr->LevelStart);
+    WIN32_COLUMN<uint16_t>().swap(pyr->BusyFraction);
+    WIN32_COLUMN<uint16_t>().swap(pyr->DominantFraction);
+    WIN32_COLUMN<uint32_t>().swap(pyr->DominantLabel);
+}
+
+/// @summary Build the pyramid for a single timeline row.
+/// @param pyr The pyramid to build. Any existing contents are replaced.
+/// @param span_start The start time of each span, in nanoseconds, in ascending order.
+/// @param span_end The end time of each span, in nanoseconds. Spans overlapping the previous span are clipped to its end.
+/// @param span_label The label of each span, for example a task table row, or NULL if spans are unlabeled.
+/// @param span_count The number of spans.
+/// @param base_time The time of the start of level 0 bucket 0, in nanoseconds. No span may start before this time.
+/// @param base_shift The base-2 logarithm of the level 0 bucket width, as returned by LodBaseShift.
+public_function void
+BuildLodPyramid
+(
+    WIN32_LOD_PYRAMID *pyr,
+    uint64_t const    *span_start,
+    uint64_t const    *span_end,
+    uint32_t const    *span_label,
+    size_t             span_count,
+    uint64_t           base_time,
+    uint32_t           base_shift
+)
+{
+    DeleteLodPyramid(pyr);
+    pyr->BaseTime  = base_time;
+    pyr->BaseShift = base_shift;
+    if (span_count == 0)
+        return;
+
+    // level 0 covers only the buckets between the first and last span of the row.
+    uint64_t last_end = span_start[0];
+    for (size_t i = 0; i < span_count; ++i)
+    {
+        if (span_end[i] > last_end) last_end = span_end[i];
+    }
+    if (last_end <= span_start[0])
+        return;
+    uint64_t const first_bucket = (span_start[0] - base_time) >> base_shift;
+    uint64_t const last_bucket  = (last_end - 1  - base_time) >> base_shift;
+    size_t   const base_count   = size_t(last_bucket - first_bucket + 1);
+    std::vector<uint64_t> busy(base_count, 0);
+    std::vector<uint64_t> dom (base_count, 0);
+    std::vector<uint32_t> lab (base_count, WIN32_LOD_NO_LABEL);
+
+    // accumulate the busy time of each span into the level 0 buckets it overlaps.
+    uint64_t clip = span_start[0];
+    for (size_t i = 0; i < span_count; ++i)
+    {
+        uint64_t const   s = span_start[i] > clip ? span_start[i] : clip;
+        uint64_t const   e = span_end[i];
+        uint32_t const   l = span_label != NULL ? span_label[i] : WIN32_LOD_NO_LABEL;
+        if (e <= s) continue;
+        clip = e;
+        for (uint64_t b = (s - base_time) >> base_shift, last = (e - 1 - base_time) >> base_shift; b <= last; ++b)
+        {
+            uint64_t const bs = base_time + (b << base_shift);
+            uint64_t const be = bs + (uint64_t(1) << base_shift);
+            uint64_t const ov = (e < be ? e : be) - (s > bs ? s : bs);
+            size_t   const j  = size_t(b - first_bucket);
+            busy[j] += ov;
+            if (lab[j] == l) dom[j] += ov;
+            else if (ov > dom[j]) { dom[j] = ov; lab[j] = l; }
+        }
+    }
+
+    // each level halves the bucket count, until the row is covered by a single bucket.
+    uint32_t const level_count = LodLevelLayout(pyr->LevelFirst, pyr->LevelStart, first_bucket, last_bucket);
+    size_t   const total       = pyr->LevelStart[level_count];
+    pyr->LevelCount = level_count;
+    pyr->BusyFraction.resize(total);
+    pyr->DominantFraction.resize(total);
+    pyr->DominantLabel.resize(total);
+
+    // build each level from the exact times of the level below, then quantize it.
+    for (uint32_t level = 0; level < level_count; ++level)
+    {
+        size_t   const start = pyr->LevelStart[level];
+        size_t   const count = pyr->LevelStart[level + 1] - start;
+        uint32_t const shift = base_shift + level;
+        if (level > 0)
+        {
+            uint64_t const child_first = pyr->LevelFirst[level - 1];
+            size_t   const child_count = pyr->LevelStart[level] - pyr->LevelStart[level - 1];
+            for (size_t j = 0; j < count; ++j)
+            {   // children are 2g and 2g+1; either may fall outside the row.
+                uint64_t const g  = pyr->LevelFirst[level] + j;
+                uint64_t       bt = 0, dt = 0;
+                uint32_t       lt = WIN32_LOD_NO_LABEL;
+                for (uint64_t c = g * 2; c <= g * 2 + 1; ++c)
+                {
+                    if (c < child_first || c - child_first >= child_count) continue;
+                    size_t const k = size_t(c - child_first);
+                    bt += busy[k];
+                    if (lab[k] == lt) dt += dom[k];
+                    else if (dom[k] > dt) { dt = dom[k]; lt = lab[k]; }
+                }
+                // j <= k always holds, so the level can be rebuilt in place.
+                busy[j] = bt; dom[j] = dt; lab[j] = lt;
+            }
+        }
+        for (size_t j = 0; j < count; ++j)
+        {
+            pyr->BusyFraction    [start + j] = LodFraction(busy[j], shift);
+            pyr->DominantFraction[start + j] = LodFraction(dom [j], shift);
+            pyr->DominantLabel   [start + j] = lab[j];
+        }
+    }
+}
+
+/// @summary Select the coarsest pyramid level that still has WIN32_LOD_BUCKETS_PER_PIXEL buckets per pixel.
+/// @param pyr The pyramid to query.
+/// @param pixel_width The width of one pixel, in nanoseconds.
+/// @return The zero-based level. Level 0 is returned if a pixel is narrower than that many level 0 buckets.
+public_function uint32_t
+LodPyramidLevel
+(
+    WIN32_LOD_PYRAMID const *pyr,
+    double           pixel_width
+)
+{
+    return LodLevelForPixel(pyr->BaseShift, pyr->LevelCount, pixel_width);
+}
+
+/// @summary Sample a pyramid for display. Each pixel reads the few buckets of the selected level that it overlaps,
+/// so the cost is proportional to the pixel count and independent of the number of spans in the row.
+/// @param pyr The pyramid to sample.
+/// @param range_lower The time at the left edge of the first pixel, in nanoseconds.
+/// @param range_upper The time at the right edge of the last pixel, in nanoseconds.
+/// @param pixel_count The number of pixels to sample.
+/// @param busy_fraction An array of pixel_count values set to the fraction of each pixel the row was busy, in [0, 1].
+/// @param dominant_label An array of pixel_count values set to the label busy for longest within each pixel, or WIN32_LOD_NO_LABEL. May be NULL.
+/// @return The pyramid level that was sampled.
+public_function uint32_t
+SampleLodPyramid
+(
+    WIN32_LOD_PYRAMID const *pyr,
+    uint64_t         range_lower,
+    uint64_t         range_upper,
+    size_t           pixel_count,
+    float         *busy_fraction,
+    uint32_t     *dominant_label
+)
+{
+    double   const width = pixel_count > 0 && range_upper > range_lower ? double(range_upper - range_lower) / double(pixel_count) : 0.0;
+    uint32_t const level = LodPyramidLevel(pyr, width);
+    for (size_t p = 0; p < pixel_count; ++p)
+    {
+        busy_fraction[p] = 0.0f;
+        if (dominant_label != NULL) dominant_label[p] = WIN32_LOD_NO_LABEL;
+    }
+    if (pyr->LevelCount == 0 || width <= 0.0)
+        return level;
+
+    uint32_t const shift = pyr->BaseShift + level;
+    uint64_t const first = pyr->LevelFirst[level];
+    size_t   const start = pyr->LevelStart[level];
+    uint64_t const count = pyr->LevelStart[level + 1] - start;
+    uint64_t const row_a = pyr->BaseTime + (first << shift);
+    uint64_t const row_b = pyr->BaseTime + ((first + count) << shift);
+    for (size_t p = 0; p < pixel_count; ++p)
+    {
+        uint64_t a = range_lower + uint64_t(width * double(p));
+        uint64_t b = range_lower + uint64_t(width * double(p + 1));
+        if (b <= a) continue;
+        uint64_t const pixel_ns = b - a;
+        if (a < row_a) a = row_a;
+        if (b > row_b) b = row_b;
+        if (b <= a) continue;
+
+        double   busy = 0.0, best = 0.0;
+        uint32_t label = WIN32_LOD_NO_LABEL;
+        for (uint64_t g = (a - pyr->BaseTime) >> shift, last = (b - 1 - pyr->BaseTime) >> shift; g <= last; ++g)
+        {   // weight each bucket by the portion of the pixel it covers.
+            uint64_t const bs = pyr->BaseTime + (g << shift);
+            uint64_t const be = bs + (uint64_t(1) << shift);
+            double   const ov = double((b < be ? b : be) - (a > bs ? a : bs));
+            size_t   const k  = start + size_t(g - first);
+            busy += ov * pyr->BusyFraction[k];
+            if (ov * pyr->DominantFraction[k] > best)
+            {
+                best  = ov * pyr->DominantFraction[k];
+                label = pyr->DominantLabel[k];
+            }
+        }
+        busy_fraction[p] = float(busy / (65535.0 * double(pixel_ns)));
+        if (dominant_label != NULL) dominant_label[p] = label;
+    }
+    return level;
+}
+
+/// @summary Release the storage held by a step function pyramid, leaving it empty.
+/// @param pyr The pyramid to reset.
+public_function void
+DeleteStepPyramid
+(
+    WIN32_STEP_PYRAMID *pyr
+)
+{
+    pyr->BaseTime   = 0;
+    pyr->BaseShift  = 0;
+    pyr->LevelCount = 0;
+    WIN32_COLUMN<uint64_t>().swap(pyr->LevelFirst);
+    WIN32_COLUMN<size_t  >().swap(pyr->LevelStart);
+    WIN32_COLUMN<uint32_t>().swap(pyr->MaxValue);
+    WIN32_COLUMN<float   >().swap(pyr->MeanValue);
+}
+
+/// @summary Build the pyramid for a step function. The function takes step_value[i] from step_time[i] until the next step, and the last value until end_time.
+/// @param pyr The pyramid to build. Any existing contents are replaced.
+/// @param step_time The time of each step, in nanoseconds, in ascending order. Steps before base_time are clipped to it.
+/// @param step_value The value of the function from each step until the next.
+/// @param step_count The number of steps.
+/// @param end_time The time at which the function ends, in nanoseconds.
+/// @param base_time The time of the start of level 0 bucket 0, in nanoseconds.
+/// @param base_shift The base-2 logarithm of the level 0 bucket width, as returned by LodBaseShift.
+public_function void
+BuildStepPyramid
+(
+    WIN32_STEP_PYRAMID *pyr,
+    uint64_t const     *step_time,
+    uint32_t const    *step_value,
+    size_t             step_count,
+    uint64_t             end_time,
+    uint64_t            base_time,
+    uint32_t           base_shift
+)
+{
+    DeleteStepPyramid(pyr);
+    pyr->BaseTime  = base_time;
+    pyr->BaseShift = base_shift;
+    if (step_count == 0)
+        return;
+
+    uint64_t const first_time = step_time[0] > base_time ? step_time[0] : base_time;
+    if (end_time <= first_time)
+        return;
+    uint64_t const first_bucket = (first_time - base_time) >> base_shift;
+    uint64_t const last_bucket  = (end_time - 1 - base_time) >> base_shift;
+    size_t   const base_count   = size_t(last_bucket - first_bucket + 1);
+    std::vector<double>   area(base_count, 0.0);
+    std::vector<uint32_t> peak(base_count, 0);
+
+    // accumulate the area under each step into the level 0 buckets it overlaps. a zero step adds nothing.
+    for (size_t i = 0; i < step_count; ++i)
+    {
+        uint64_t const s = step_time[i] > first_time ? step_time[i] : first_time;
+        uint64_t       e = i + 1 < step_count ? step_time[i + 1] : end_time;
+        uint32_t const v = step_value[i];
+        if (e > end_time) e = end_time;
+        if (e <= s || v == 0) continue;
+        for (uint64_t b = (s - base_time) >> base_shift, last = (e - 1 - base_time) >> base_shift; b <= last; ++b)
+        {
+            uint64_t const bs = base_time + (b << base_shift);
+            uint64_t const be = bs + (uint64_t(1) << base_shift);
+            uint64_t const ov = (e < be ? e : be) - (s > bs ? s : bs);
+            size_t   const j  = size_t(b - first_bucket);
+            area[j] += double(v) * double(ov);
+            if (v > peak[j]) peak[j] = v;
+        }
+    }
+
+    uint32_t const level_count = LodLevelLayout(pyr->LevelFirst, pyr->LevelStart, first_bucket, last_bucket);
+    size_t   const total       = pyr->LevelStart[level_count];
+    pyr->LevelCount = level_count;
+    pyr->MaxValue.resize(total);
+    pyr->MeanValue.resize(total);
+    for (uint32_t level = 0; level < level_count; ++level)
+    {
+        size_t   const start = pyr->LevelStart[level];
+        size_t   const count = pyr->LevelStart[level + 1] - start;
+        uint32_t const shift = base_shift + level;
+        if (level > 0)
+        {
+            uint64_t const child_first = pyr->LevelFirst[level - 1];
+            size_t   const child_count = pyr->LevelStart[level] - pyr->LevelStart[level - 1];
+            for (size_t j = 0; j < count; ++j)
+            {   // children are 2g and 2g+1; either may fall outside the function. j <= k, so the level is rebuilt in place.
+                uint64_t const g  = pyr->LevelFirst[level] + j;
+                double         at = 0.0;
+                uint32_t       pt = 0;
+                for (uint64_t c = g * 2; c <= g * 2 + 1; ++c)
+                {
+                    if (c < child_first || c - child_first >= child_count) continue;
+                    size_t const k = size_t(c - child_first);
+                    at += area[k];
+                    if (peak[k] > pt) pt = peak[k];
+                }
+                area[j] = at; peak[j] = pt;
+            }
+        }
+        for (size_t j = 0; j < count; ++j)
+        {
+            pyr->MaxValue [start + j] = peak[j];
+            pyr->MeanValue[start + j] = float(area[j] / double(uint64_t(1) << shift));
+        }
+    }
+}
+
+/// @summary Sample a step function pyramid for display. Each pixel reads the few buckets of the selected level that it overlaps.
+/// @param pyr The pyramid to sample.
+/// @param range_lower The time at the left edge of the first pixel, in nanoseconds.
+/// @param range_upper The time at the right edge of the last pixel, in nanoseconds.
+/// @param pixel_count The number of pixels to sample.
+/// @param max_value An array of pixel_count values set to the largest value of the function within each pixel. Buckets straddling a pixel edge count toward both pixels.
+/// @param mean_value An array of pixel_count values set to the time-weighted mean of the function over each pixel. May be NULL.
+/// @return The pyramid level that was sampled.
+public_function uint32_t
+SampleStepPyramid
+(
+    WIN32_STEP_PYRAMID const *pyr,
+    uint64_t          range_lower,
+    uint64_t          range_upper,
+    size_t            pixel_count,
+    float              *max_value,
+    float             *mean_value
+)
+{
+    double   const width = pixel_count > 0 && range_upper > range_lower ? double(range_upper - range_lower) / double(pixel_count) : 0.0;
+    uint32_t const level = LodLevelForPixel(pyr->BaseShift, pyr->LevelCount, width);
+    for (size_t p = 0; p < pixel_count; ++p)
+    {
+        max_value[p] = 0.0f;
+        if (mean_value != NULL) mean_value[p] = 0.0f;
+    }
+    if (pyr->LevelCount == 0 || width <= 0.0)
+        return level;
+
+    uint32_t const shift = pyr->BaseShift + level;
+    uint64_t const first = pyr->LevelFirst[level];
+    size_t   const start = pyr->LevelStart[level];
+    uint64_t const count = pyr->LevelStart[level + 1] - start;
+    uint64_t const row_a = pyr->BaseTime + (first << shift);
+    uint64_t const row_b = pyr->BaseTime + ((first + count) << shift);
+    for (size_t p = 0; p < pixel_count; ++p)
+    {
+        uint64_t a = range_lower + uint64_t(width * double(p));
+        uint64_t b = range_lower + uint64_t(width * double(p + 1));
+        if (b <= a) continue;
+        uint64_t const pixel_ns = b - a;
+        if (a < row_a) a = row_a;
+        if (b > row_b) b = row_b;
+        if (b <= a) continue;
+
+        double   area = 0.0;
+        uint32_t peak = 0;
+        for (uint64_t g = (a - pyr->BaseTime) >> shift, last = (b - 1 - pyr->BaseTime) >> shift; g <= last; ++g)
+        {   // weight each bucket mean by the portion of the pixel it covers.
+            uint64_t const bs = pyr->BaseTime + (g << shift);
+            uint64_t const be = bs + (uint64_t(1) << shift);
+            double   const ov = double((b < be ? b : be) - (a > bs ? a : bs));
+            size_t   const k  = start + size_t(g - first);
+            area += ov * pyr->MeanValue[k];
+            if (pyr->MaxValue[k] > peak) peak = pyr->MaxValue[k];
+        }
+        max_value[p] = float(peak);
+        if (mean_value != NULL) mean_value[p] = float(area / double(pixel_ns));
+    }
+    return level;
+}
+
+/// @summary Build the pyramids for every thread and worker in a loaded trace. Thread rows summarize the time each
+/// thread was switched in; worker rows summarize the tasks each worker executed, labeled by task table row.
+/// @param lod The timeline summaries to build. Any existing contents are replaced.
+/// @param process_list The process list, with thread intervals built by BuildProcessThreadIntervals.
+/// @param task_table The task table, with complete launch and finish columns.
+public_function void
+BuildTimelineLod
+(
+    WIN32_TIMELINE_LOD         *lod,
+    WIN32_PROCESS_LIST const   *process_list,
+    WIN32_TASK_TABLE const     *task_table
+)
+{
+    uint64_t first_time = ~uint64_t(0);
+    uint64_t last_time  = 0;
+    std::vector<uint32_t> rows;
+    std::vector<uint64_t> span_start;
+    std::vector<uint64_t> span_end;
+    std::vector<uint32_t> span_label;
+
+    // find the range of times covered by any row, so all rows share bucket boundaries.
+    for (size_t i = 0; i < process_list->ProcessCount; ++i)
+    {
+        WIN32_PROCESS_INFO const &proc = process_list->ProcessInfo[i];
+        for (size_t j = 0; j < proc.ThreadCount; ++j)
+        {
+            WIN32_THREAD_INTERVALS const &intervals = proc.ThreadInfo[j].Intervals;
+            size_t const n = intervals.IntervalCount;
+            if (n > 0 && intervals.Start[0] < first_time) first_time = intervals.Start[0];
+            if (n > 0 && intervals.Start[n - 1] + intervals.Duration[n - 1] > last_time) last_time = intervals.Start[n - 1] + intervals.Duration[n - 1];
+        }
+    }
+    if (!task_table->LaunchSortedTime.empty())
+    {
+        if (task_table->LaunchSortedTime.front() < first_time) first_time = task_table->LaunchSortedTime.front();
+        if (task_table->LaunchSortedTime.back()  > last_time ) last_time  = task_table->LaunchSortedTime.back();
+    }
+    if (!task_table->FinishSortedTime.empty() && task_table->FinishSortedTime.back() > last_time)
+    {
+        last_time = task_table->FinishSortedTime.back();
+    }
+    if (first_time > last_time)
+    {   // there are no spans in the trace.
+        first_time = last_time = 0;
+    }
+
+    lod->FirstTime   = first_time;
+    lod->LastTime    = last_time;
+    lod->BaseShift   = LodBaseShift(first_time, last_time);
+    lod->ThreadCount = 0;
+    lod->ThreadProcess.clear();
+    lod->ThreadIndex.clear();
+    lod->ThreadLod.clear();
+    lod->WorkerCount = 0;
+    lod->WorkerThreadId.clear();
+    lod->WorkerLod.clear();
+
+    for (size_t i = 0; i < process_list->ProcessCount; ++i)
+    {
+        WIN32_PROCESS_INFO const &proc = process_list->ProcessInfo[i];
+        for (size_t j = 0; j < proc.ThreadCount; ++j)
+        {
+            span_start.clear();
+            span_end.clear();
+            GatherThreadRunSpans(&proc.ThreadInfo[j], span_start, span_end);
+            if (span_start.empty())
+                continue;
+            lod->ThreadProcess.push_back(uint32_t(i));
+            lod->ThreadIndex.push_back(uint32_t(j));
+            lod->ThreadLod.push_back(WIN32_LOD_PYRAMID());
+            BuildLodPyramid(&lod->ThreadLod.back(), &span_start[0], &span_end[0], NULL, span_start.size(), first_time, lod->BaseShift);
+            lod->ThreadCount++;
+        }
+    }
+
+    // assign each launched task to a worker slot. workers are few, and runs of tasks on one worker are common.
+    size_t const          launch_count = task_table->LaunchSortedRow.size();
+    std::vector<uint32_t> slot(launch_count);
+    std::vector<uint32_t> slot_count;
+    uint32_t              last_slot = 0;
+    for (size_t i = 0; i < launch_count; ++i)
+    {
+        uint32_t const worker = task_table->WorkerThreadId[task_table->LaunchSortedRow[i]];
+        if (lod->WorkerCount == 0 || lod->WorkerThreadId[last_slot] != worker)
+        {
+            for (last_slot = 0; last_slot < lod->WorkerCount; ++last_slot)
+            {
+                if (lod->WorkerThreadId[last_slot] == worker)
+                    break;
+            }
+            if (last_slot == lod->WorkerCount)
+            {
+                lod->WorkerThreadId.push_back(worker);
+                slot_count.push_back(0);
+                lod->WorkerCount++;
+            }
+        }
+        slot[i] = last_slot;
+        slot_count[last_slot]++;
+    }
+
+    // scatter the rows so each worker's tasks are contiguous, keeping launch order within each worker.
+    std::vector<size_t> slot_start(lod->WorkerCount + 1, 0);
+    for (size_t w = 0; w < lod->WorkerCount; ++w)
+    {
+        slot_start[w + 1] = slot_start[w] + slot_count[w];
+    }
+    rows.resize(launch_count);
+    for (size_t i = 0; i < launch_count; ++i)
+    {
+        rows[slot_start[slot[i]]++] = task_table->LaunchSortedRow[i];
+    }
+    lod->WorkerLod.resize(lod->WorkerCount);
+    for (size_t w = 0, i = 0; w < lod->WorkerCount; ++w)
+    {
+        span_start.clear();
+        span_end.clear();
+        span_label.clear();
+        for (size_t n = i + slot_count[w]; i < n; ++i)
+        {   // a task that never finished is treated as running until the end of the trace.
+            uint32_t const row = rows[i];
+            uint64_t const end = task_table->FinishTime[row] >= task_table->LaunchTime[row] ? task_table->FinishTime[row] : last_time;
+            span_start.push_back(task_table->LaunchTime[row]);
+            span_end.push_back(end);
+            span_label.push_back(row);
+        }
+        BuildLodPyramid(&lod->WorkerLod[w], &span_start[0], &span_end[0], &span_label[0], span_start.size(), first_time, lod->BaseShift);
+    }
+}
+
+/// @summary Release the storage held by the timeline summaries.
+/// @param lod The timeline summaries to delete.
+public_function void
+DeleteTimelineLod
+(
+    WIN32_TIMELINE_LOD *lod
+)
+{
+    lod->ThreadCount = 0;
+    lod->WorkerCount = 0;
+    WIN32_COLUMN<uint32_t>().swap(lod->ThreadProcess);
+    WIN32_COLUMN<uint32_t>().swap(lod->ThreadIndex);
+    std::vector<WIN32_LOD_PYRAMID>().swap(lod->ThreadLod);
+    WIN32_COLUMN<uint32_t>().swap(lod->WorkerThreadId);
+    std::vector<WIN32_LOD_PYRAMID>().swap(lod->WorkerLod);
+}
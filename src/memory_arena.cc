@@ -0,0 +1,127 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implement a chunked memory arena. Memory is handed out by bumping
+/// a pointer through large chunks, so allocation is a few instructions and
+/// needs no per-allocation header. Allocations are never freed individually;
+/// deleting the arena releases every chunk at once.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////////
+//   Preprocessor   //
+////////////////////*/
+/// @summary Define the default size of an arena chunk, in bytes.
+#ifndef WIN32_MEMORY_ARENA_CHUNK_SIZE
+#define WIN32_MEMORY_ARENA_CHUNK_SIZE          (1024 * 1024)
+#endif
+
+/*//////////////////////////
+//   Internal Functions   //
+//////////////////////////*/
+/// @summary Allocate the memory for an arena chunk.
+/// @param size The size of the chunk, in bytes.
+/// @return A pointer to the chunk memory, or NULL.
+internal_function uint8_t*
+MemoryArenaAllocateChunk
+(
+    size_t size
+)
+{
+#if defined(_WIN32)
+    return (uint8_t*) VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#else
+    return (uint8_t*) malloc(size);
+#endif
+}
+
+/// @summary Free the memory for an arena chunk.
+/// @param chunk A pointer returned by MemoryArenaAllocateChunk.
+internal_function void
+MemoryArenaFreeChunk
+(
+    uint8_t *chunk
+)
+{
+#if defined(_WIN32)
+    VirtualFree(chunk, 0, MEM_RELEASE);
+#else
+    free(chunk);
+#endif
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Initialize an empty memory arena. No memory is allocated until the first allocation.
+/// A zero-initialized WIN32_MEMORY_ARENA is also a valid empty arena with the default chunk size.
+/// @param arena The memory arena to initialize.
+/// @param chunk_size The size of each chunk, in bytes, or 0 to use WIN32_MEMORY_ARENA_CHUNK_SIZE.
+public_function void
+InitMemoryArena
+(
+    WIN32_MEMORY_ARENA *arena,
+    size_t         chunk_size
+)
+{
+    arena->Chunks.clear();
+    arena->NextByte      = NULL;
+    arena->LastByte      = NULL;
+    arena->ChunkSize     = chunk_size;
+    arena->BytesUsed     = 0;
+    arena->BytesReserved = 0;
+}
+
+/// @summary Allocate memory from an arena. The memory remains valid until the arena is deleted.
+/// @param arena The memory arena to allocate from.
+/// @param size The number of bytes to allocate.
+/// @param alignment The required alignment of the returned address, in bytes. Must be a power of two.
+/// @return A pointer to the allocated memory, or NULL if a new chunk could not be allocated.
+public_function void*
+MemoryArenaAllocate
+(
+    WIN32_MEMORY_ARENA *arena,
+    size_t               size,
+    size_t          alignment
+)
+{
+    size_t const chunk_size = arena->ChunkSize != 0 ? arena->ChunkSize : WIN32_MEMORY_ARENA_CHUNK_SIZE;
+    if (arena->NextByte != NULL)
+    {   // try to satisfy the request from the current chunk.
+        uintptr_t const addr = (uintptr_t(arena->NextByte) + (alignment - 1)) & ~uintptr_t(alignment - 1);
+        if (addr + size <= uintptr_t(arena->LastByte))
+        {
+            arena->BytesUsed += size_t(addr + size - uintptr_t(arena->NextByte));
+            arena->NextByte   = (uint8_t*)(addr + size);
+            return (void*) addr;
+        }
+    }
+    if (size + alignment > chunk_size / 4)
+    {   // large requests get a dedicated chunk so the remainder of the current chunk isn't wasted.
+        uint8_t *chunk = MemoryArenaAllocateChunk(size + alignment);
+        if (chunk == NULL) return NULL;
+        arena->Chunks.push_back(chunk);
+        arena->BytesReserved += size + alignment;
+        arena->BytesUsed     += size + alignment;
+        return (void*)((uintptr_t(chunk) + (alignment - 1)) & ~uintptr_t(alignment - 1));
+    }
+    uint8_t *chunk = MemoryArenaAllocateChunk(chunk_size);
+    if (chunk == NULL) return NULL;
+    arena->Chunks.push_back(chunk);
+    arena->BytesReserved += chunk_size;
+    arena->NextByte       = chunk;
+    arena->LastByte       = chunk + chunk_size;
+    return MemoryArenaAllocate(arena, size, alignment);
+}
+
+/// @summary Free all memory allocated from an arena. The arena is left empty and can be reused.
+/// @param arena The memory arena to delete.
+public_function void
+DeleteMemoryArena
+(
+    WIN32_MEMORY_ARENA *arena
+)
+{
+    for (size_t i = 0, n = arena->Chunks.size(); i < n; ++i)
+    {
+        MemoryArenaFreeChunk(arena->Chunks[i]);
+    }
+    InitMemoryArena(arena, arena->ChunkSize);
+}
@@ -0,0 +1,276 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implement object lifetime records and the hash indexes used to
+/// locate a process, thread or image that was alive at a given time. Object
+/// identifiers are reused by the operating system, so each key maps to a
+/// chain of records with disjoint lifetimes, searched newest first.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////////
+//   Preprocessor   //
+////////////////////*/
+/// @summary Define the value stored in empty index slots and at the end of object chains.
+#ifndef WIN32_OBJECT_INDEX_EMPTY
+#define WIN32_OBJECT_INDEX_EMPTY               0xFFFFFFFFUL
+#endif
+
+/// @summary Define the minimum number of slots allocated for a non-empty index. Must be a power of two.
+#ifndef WIN32_OBJECT_INDEX_MIN_SLOTS
+#define WIN32_OBJECT_INDEX_MIN_SLOTS           64
+#endif
+
+/*//////////////////////////
+//   Internal Functions   //
+//////////////////////////*/
+/// @summary Mix the bits of a 64-bit key. Used to select the home slot of a key in an object index.
+/// @param x The 64-bit key.
+/// @return The input value, with bits mixed.
+internal_function inline uint64_t
+ObjectIndexHash
+(
+    uint64_t x
+)
+{   // the finalizer from murmurhash3, 64-bit.
+    x ^= x >> 33;
+    x *= 0xFF51AFD7ED558CCDULL;
+    x ^= x >> 33;
+    x *= 0xC4CEB9FE1A85EC53ULL;
+    x ^= x >> 33;
+    return x;
+}
+
+/// @summary Locate the slot for a key using linear probing.
+/// @param index The object index to search. SlotCount must be non-zero.
+/// @param key The key to locate.
+/// @return The zero-based index of the slot holding the key, or of the empty slot where the key would be inserted.
+internal_function inline size_t
+ObjectIndexProbe
+(
+    WIN32_OBJECT_INDEX const &index,
+    uint64_t                    key
+)
+{
+    size_t const mask = index.SlotCount - 1;
+    size_t       slot = size_t(ObjectIndexHash(key)) & mask;
+    while (index.SlotHead[slot] != WIN32_OBJECT_INDEX_EMPTY && index.SlotKey[slot] != key)
+    {   // the load factor is kept below 3/4, so an empty slot is always found.
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+/// @summary Resize the slot table of an object index and re-insert all keys. Object chains are unaffected.
+/// @param index The object index to resize.
+/// @param slot_count The new number of slots. Must be a power of two larger than the number of keys.
+internal_function void
+ObjectIndexResize
+(
+    WIN32_OBJECT_INDEX &index,
+    size_t         slot_count
+)
+{
+    WIN32_COLUMN<uint64_t> old_key;
+    WIN32_COLUMN<uint32_t> old_head;
+    old_key.swap(index.SlotKey);
+    old_head.swap(index.SlotHead);
+    index.SlotKey.assign(slot_count, 0);
+    index.SlotHead.assign(slot_count, WIN32_OBJECT_INDEX_EMPTY);
+    index.SlotCount = slot_count;
+    for (size_t i = 0, n = old_head.size(); i < n; ++i)
+    {
+        if (old_head[i] != WIN32_OBJECT_INDEX_EMPTY)
+        {
+            size_t slot = ObjectIndexProbe(index, old_key[i]);
+            index.SlotKey [slot] = old_key [i];
+            index.SlotHead[slot] = old_head[i];
+        }
+    }
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Initialize an object lifetime record.
+/// @param lifetime The record to initialize.
+/// @param create_time The creation timestamp, in ticks. A value of 0 indicates that the object was created before the trace was started.
+/// @param destroy_time The destruction timetsamp, in ticks. A value of 0 indicates that the object was destroyed after the trace ended.
+public_function inline void
+InitObjectLifetime
+(
+    WIN32_LIFETIME   &lifetime, 
+    uint64_t       create_time=0, 
+    uint64_t      destroy_time=0
+)
+{
+    lifetime.CreateTime  = create_time;
+    lifetime.DestroyTime = destroy_time;
+}
+
+/// @summary Update an object lifetime record with the time at which the object was created.
+/// @param lifetime The record to update.
+/// @param timestamp The object creation timestamp, in ticks.
+public_function inline void
+ObjectCreated
+(
+    WIN32_LIFETIME &lifetime, 
+    LARGE_INTEGER  timestamp
+)
+{
+    lifetime.CreateTime = uint64_t(timestamp.QuadPart);
+}
+
+/// @summary Update an object lifetime record with the time at which the object was destroyed.
+/// @param lifetime The record to update.
+/// @param timestamp The object destruction timestamp, in ticks.
+public_function inline void
+ObjectDestroyed
+(
+    WIN32_LIFETIME &lifetime, 
+    LARGE_INTEGER  timestamp
+)
+{
+    lifetime.DestroyTime = uint64_t(timestamp.QuadPart);
+}
+
+/// @summary Determine whether an object was alive at a given time.
+/// @param lifetime The object lifetime record.
+/// @param timestamp The timestamp, in ticks, indicating the point in time to query.
+/// @return true if the object was alive at the specified point in time.
+public_function inline bool
+ObjectAliveAtTime
+(
+    WIN32_LIFETIME const &lifetime, 
+    uint64_t       const timestamp
+)
+{   // check for timestamp >= CreateTime and <= DestroyTime.
+    // a DestroyTime of 0 indicates that the object was still alive when capture stopped.
+    return (timestamp >= lifetime.CreateTime && (lifetime.DestroyTime == 0 || lifetime.DestroyTime >= timestamp));
+}
+
+/// @summary Determine whether an object was alive at a given time.
+/// @param lifetime The object lifetime record.
+/// @param timestamp The timestamp, in ticks, indicating the point in time to query.
+/// @return true if the object was alive at the specified point in time.
+public_function inline bool
+ObjectAliveAtTime
+(
+    WIN32_LIFETIME const &lifetime, 
+    LARGE_INTEGER        timestamp
+)
+{
+    return ObjectAliveAtTime(lifetime, uint64_t(timestamp.QuadPart));
+}
+
+/// @summary Initialize an empty object index. No memory is allocated until the first insertion.
+/// @param index The object index to initialize.
+public_function void
+InitObjectIndex
+(
+    WIN32_OBJECT_INDEX &index
+)
+{
+    index.SlotCount = 0;
+    index.KeyCount  = 0;
+    index.SlotKey.clear();
+    index.SlotHead.clear();
+    index.ChainNext.clear();
+}
+
+/// @summary Size an object index so that a given number of distinct keys can be inserted without resizing the slot table.
+/// @param index The object index to update.
+/// @param key_count The expected number of distinct keys.
+public_function void
+ReserveObjectIndex
+(
+    WIN32_OBJECT_INDEX &index,
+    size_t          key_count
+)
+{
+    size_t slot_count = index.SlotCount == 0 ? WIN32_OBJECT_INDEX_MIN_SLOTS : index.SlotCount;
+    while (key_count * 4 > slot_count * 3)
+    {   // maintain the same load factor as ObjectIndexInsert.
+        slot_count *= 2;
+    }
+    if (slot_count != index.SlotCount)
+    {
+        ObjectIndexResize(index, slot_count);
+    }
+    index.ChainNext.reserve(key_count);
+}
+
+/// @summary Add an object to an object index. Objects must be inserted in creation order, so the newest object with a key heads its chain.
+/// @param index The object index to update.
+/// @param key The identifier of the object (process ID, thread ID, base address or path hash).
+/// @param object_index The zero-based index of the object in its object list.
+public_function void
+ObjectIndexInsert
+(
+    WIN32_OBJECT_INDEX &index,
+    uint64_t              key,
+    size_t       object_index
+)
+{
+    if ((index.KeyCount + 1) * 4 > index.SlotCount * 3)
+    {   // keep the load factor at or below 3/4 so probe sequences stay short.
+        ObjectIndexResize(index, index.SlotCount == 0 ? WIN32_OBJECT_INDEX_MIN_SLOTS : index.SlotCount * 2);
+    }
+    if (index.ChainNext.size() <= object_index)
+    {   // objects are normally appended, so this grows by one.
+        index.ChainNext.resize(object_index + 1, WIN32_OBJECT_INDEX_EMPTY);
+    }
+    size_t const slot = ObjectIndexProbe(index, key);
+    if (index.SlotHead[slot] == WIN32_OBJECT_INDEX_EMPTY)
+    {   // this is the first object with the key.
+        index.SlotKey[slot] = key;
+        index.KeyCount++;
+    }
+    index.ChainNext[object_index] = index.SlotHead[slot];
+    index.SlotHead [slot]         = uint32_t(object_index);
+}
+
+/// @summary Retrieve the newest object inserted into an object index with a given key, without regard to lifetime.
+/// @param index The object index to search.
+/// @param key The identifier of the object to locate.
+/// @return The zero-based index of the newest object with the key, or WIN32_OBJECT_INDEX_EMPTY. Older objects are found through ChainNext.
+public_function inline uint32_t
+ObjectIndexFirst
+(
+    WIN32_OBJECT_INDEX const &index,
+    uint64_t                    key
+)
+{
+    return index.KeyCount != 0 ? index.SlotHead[ObjectIndexProbe(index, key)] : uint32_t(WIN32_OBJECT_INDEX_EMPTY);
+}
+
+/// @summary Search an object index for an object with a given identifier that was alive at a particular time.
+/// If records with the same key have overlapping lifetimes, for example because a destroy event was lost, the newest record is returned.
+/// @param index The object index to search.
+/// @param lifetime_list The list of object lifetimes corresponding to each object index.
+/// @param search_key The identifier of the object to locate.
+/// @param search_time The query time, in nanoseconds. The object must be alive at this time.
+/// @param object_index If the function returns true, this value is set to the zero-based index of the object in the object list.
+/// @return true if an object with the specified identifier was alive and located at the specified time, or false otherwise.
+public_function bool
+FindObjectInIndex
+(
+    WIN32_OBJECT_INDEX const     &index,
+    WIN32_LIFETIME const *lifetime_list,
+    uint64_t                 search_key,
+    uint64_t                search_time,
+    size_t                &object_index
+)
+{
+    if (index.KeyCount == 0)
+    {   // early out - the object list is empty.
+        return false;
+    }
+    size_t const slot = ObjectIndexProbe(index, search_key);
+    for (uint32_t i = index.SlotHead[slot]; i != WIN32_OBJECT_INDEX_EMPTY; i = index.ChainNext[i])
+    {   // walk the chain from the newest object to the oldest.
+        if (ObjectAliveAtTime(lifetime_list[i], search_time))
+        {
+            object_index = i;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,230 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implement off-CPU analysis. A single pass over the waiting
+/// intervals of each thread, materialized by BuildThreadIntervals, finds every
+/// blocked span, and accumulates it into fixed-size arrays indexed by wait
+/// reason for the thread, the trace, and the entry point of the task that
+/// blocked. Grouping by a small dense key needs no hashing or sorting.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*//////////////////////////
+//   Internal Functions   //
+//////////////////////////*/
+/// @summary Map a WIN32_SWITCH_OUT_DATA::WaitReason to the index used by the arrays of a WIN32_OFF_CPU_REPORT.
+/// @param reason The wait reason.
+/// @return The wait reason clamped to [0, WIN32_WAIT_REASON_COUNT).
+internal_function inline size_t
+OffCpuReasonIndex
+(
+    int8_t reason
+)
+{
+    return (reason >= 0 && reason < WIN32_WAIT_REASON_COUNT) ? size_t(reason) : size_t(WIN32_WAIT_REASON_COUNT - 1);
+}
+
+/// @summary Order threads or entry points by descending blocked time. Keys are (time, position), so ties keep their original order.
+/// @param a The first key to compare.
+/// @param b The second key to compare.
+/// @return true if a should be listed before b.
+internal_function bool
+OffCpuTimeBefore
+(
+    std::pair<uint64_t, size_t> const &a,
+    std::pair<uint64_t, size_t> const &b
+)
+{
+    return (a.first != b.first) ? (a.first > b.first) : (a.second < b.second);
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Retrieve the name of a wait reason, from the KWAIT_REASON enumeration used by the kernel.
+/// @param reason The wait reason.
+/// @return A zero-terminated string naming the wait reason. Unknown reasons are named "Other".
+public_function char const*
+WaitReasonName
+(
+    int reason
+)
+{
+    static char const *names[] =
+    {
+        "Executive"       , "FreePage"        , "PageIn"          , "PoolAllocation"  , "DelayExecution"  ,
+        "Suspended"       , "UserRequest"     , "WrExecutive"     , "WrFreePage"      , "WrPageIn"        ,
+        "WrPoolAllocation", "WrDelayExecution", "WrSuspended"     , "WrUserRequest"   , "WrEventPair"     ,
+        "WrQueue"         , "WrLpcReceive"    , "WrLpcReply"      , "WrVirtualMemory" , "WrPageOut"       ,
+        "WrRendezvous"    , "WrKeyedEvent"    , "WrTerminated"    , "WrProcessInSwap" , "WrCpuRateControl",
+        "WrCalloutStack"  , "WrKernel"        , "WrResource"      , "WrPushLock"      , "WrMutex"         ,
+        "WrQuantumEnd"    , "WrDispatchInt"   , "WrPreempted"     , "WrYieldExecution", "WrFastMutex"     ,
+        "WrGuardedMutex"  , "WrRundown"       , "WrAlertByThreadId", "WrDeferredPreempt"
+    };
+    if (reason >= 0 && reason < int(sizeof(names) / sizeof(names[0])))
+        return names[reason];
+    return "Other";
+}
+
+/// @summary Find the wait reason with the most blocked time in one row of a per-reason array, such as ThreadReasonTime or EntryPointReasonTime.
+/// @param reason_time The WIN32_WAIT_REASON_COUNT blocked times of the row, in nanoseconds.
+/// @return The wait reason with the most blocked time. Ties favor the lower reason.
+public_function size_t
+OffCpuTopReason
+(
+    uint64_t const *reason_time
+)
+{
+    size_t top = 0;
+    for (size_t r = 1; r < WIN32_WAIT_REASON_COUNT; ++r)
+    {
+        if (reason_time[r] > reason_time[top]) top = r;
+    }
+    return top;
+}
+
+/// @summary Free the memory used by an off-CPU report. The report is left empty.
+/// @param report The report to delete.
+public_function void
+DeleteOffCpuReport
+(
+    WIN32_OFF_CPU_REPORT *report
+)
+{
+    report->ThreadCount     = 0;
+    report->EntryPointCount = 0;
+    DeleteLatencyHistogram(&report->All);
+    std::vector<WIN32_LATENCY_HISTOGRAM>().swap(report->ReasonHistogram);
+    WIN32_COLUMN<uint64_t>().swap(report->ReasonUserTime);
+    WIN32_COLUMN<uint32_t>().swap(report->ThreadProcess);
+    WIN32_COLUMN<uint32_t>().swap(report->ThreadIndex);
+    std::vector<WIN32_LATENCY_HISTOGRAM>().swap(report->ThreadHistogram);
+    WIN32_COLUMN<uint64_t>().swap(report->ThreadReasonTime);
+    WIN32_COLUMN<uint64_t>().swap(report->EntryPoint);
+    WIN32_COLUMN<uint64_t>().swap(report->EntryPointTime);
+    WIN32_COLUMN<uint64_t>().swap(report->EntryPointReasonTime);
+    WIN32_COLUMN<uint64_t>().swap(report->TaskBlockedTime);
+}
+
+/// @summary Build the off-CPU report of a trace from the waiting intervals of each thread. A wait too long for one interval is rejoined into a single span.
+/// @param report The report to build. Any existing contents are replaced.
+/// @param process_list The process list, with thread intervals built by BuildProcessThreadIntervals.
+/// @param task_table The task table, with complete launch and finish columns.
+public_function void
+BuildOffCpuReport
+(
+    WIN32_OFF_CPU_REPORT           *report,
+    WIN32_PROCESS_LIST const *process_list,
+    WIN32_TASK_TABLE const     *task_table
+)
+{
+    size_t const                                R = WIN32_WAIT_REASON_COUNT;
+    std::vector<std::pair<uint32_t, uint32_t> > worker_launch;
+    std::vector<uint64_t>                       entry_points(task_table->EntryPoint.begin(), task_table->EntryPoint.end());
+    std::vector<uint32_t>                       row_entry(task_table->TaskCount);
+    std::vector<uint64_t>                       entry_reason;
+    std::vector<std::pair<uint64_t, size_t> >   order;
+    std::vector<uint32_t>                       process;
+    std::vector<uint32_t>                       index;
+    std::vector<WIN32_LATENCY_HISTOGRAM>        hist;
+    std::vector<uint64_t>                       reason_time;
+
+    DeleteOffCpuReport(report);
+    report->ReasonHistogram.resize(R);
+    report->ReasonUserTime.assign(R, 0);
+    report->TaskBlockedTime.assign(task_table->TaskCount, 0);
+    BuildWorkerLaunchIndex(task_table, worker_launch);
+
+    // give each distinct entry point a dense index, so blocked time can be grouped by entry point and reason in a flat array.
+    std::sort(entry_points.begin(), entry_points.end());
+    entry_points.erase(std::unique(entry_points.begin(), entry_points.end()), entry_points.end());
+    for (size_t r = 0; r < task_table->TaskCount; ++r)
+    {
+        row_entry[r] = uint32_t(std::lower_bound(entry_points.begin(), entry_points.end(), task_table->EntryPoint[r]) - entry_points.begin());
+    }
+    entry_reason.assign(entry_points.size() * R, 0);
+
+    for (size_t i = 0; i < process_list->ProcessCount; ++i)
+    {
+        WIN32_PROCESS_INFO const &proc = process_list->ProcessInfo[i];
+        for (size_t j = 0; j < proc.ThreadCount; ++j)
+        {
+            WIN32_THREAD_INTERVALS const &intervals = proc.ThreadInfo[j].Intervals;
+            size_t   const           n = intervals.IntervalCount;
+            size_t   const     reasons = reason_time.size();
+            WIN32_LATENCY_HISTOGRAM  h = {};
+            reason_time.resize(reasons + R, 0);
+            for (size_t k = 0; k < n; ++k)
+            {   // a preempted thread is ready, not waiting, so only waiting intervals are blocked time.
+                if (intervals.State[k] != WIN32_THREAD_STATE_WAITING)
+                    continue;
+                uint64_t const start    = intervals.Start[k];
+                int8_t   const wait     = intervals.WaitReason[k];
+                int8_t   const mode     = intervals.WaitMode[k];
+                uint64_t       duration = intervals.Duration[k];
+                while (k + 1 < n && intervals.State[k + 1] == WIN32_THREAD_STATE_WAITING && intervals.WaitReason[k + 1] == wait && intervals.WaitMode[k + 1] == mode && intervals.Start[k + 1] == start + duration)
+                {   // BuildThreadIntervals splits a wait longer than a uint32_t duration into consecutive intervals.
+                    duration += intervals.Duration[++k];
+                }
+                size_t   const reason   = OffCpuReasonIndex(wait);
+                uint32_t const row      = FindWorkerTask(task_table, worker_launch, proc.ThreadId[j], start, start);
+                LatencyHistogramAdd(&h, duration);
+                LatencyHistogramAdd(&report->ReasonHistogram[reason], duration);
+                reason_time[reasons + reason] += duration;
+                if (mode == WIN32_WAIT_MODE_USER)
+                    report->ReasonUserTime[reason] += duration;
+                if (row != WIN32_OBJECT_INDEX_EMPTY)
+                {
+                    report->TaskBlockedTime[row] += duration;
+                    entry_reason[row_entry[row] * R + reason] += duration;
+                }
+            }
+            if (h.Count == 0)
+            {   // the thread never blocked; drop its row of reason times.
+                reason_time.resize(reasons);
+                continue;
+            }
+            order.push_back(std::make_pair(h.Total, hist.size()));
+            process.push_back(uint32_t(i));
+            index.push_back(uint32_t(j));
+            hist.push_back(WIN32_LATENCY_HISTOGRAM());
+            std::swap(hist.back(), h);
+        }
+    }
+
+    // list threads with the most blocked time first.
+    std::sort(order.begin(), order.end(), OffCpuTimeBefore);
+    report->ThreadCount = order.size();
+    report->ThreadProcess.resize(order.size());
+    report->ThreadIndex.resize(order.size());
+    report->ThreadHistogram.resize(order.size());
+    report->ThreadReasonTime.resize(order.size() * R);
+    for (size_t i = 0, n = order.size(); i < n; ++i)
+    {
+        size_t const k = order[i].second;
+        report->ThreadProcess[i] = process[k];
+        report->ThreadIndex  [i] = index[k];
+        std::swap(report->ThreadHistogram[i], hist[k]);
+        std::copy(reason_time.begin() + k * R, reason_time.begin() + (k + 1) * R, report->ThreadReasonTime.begin() + i * R);
+        MergeLatencyHistogram(&report->All, &report->ThreadHistogram[i]);
+    }
+
+    // list entry points with the most blocked time first, dropping those whose tasks never blocked.
+    order.clear();
+    for (size_t e = 0, n = entry_points.size(); e < n; ++e)
+    {
+        uint64_t total = 0;
+        for (size_t r = 0; r < R; ++r)
+            total += entry_reason[e * R + r];
+        if (total > 0) order.push_back(std::make_pair(total, e));
+    }
+    std::sort(order.begin(), order.end(), OffCpuTimeBefore);
+    report->EntryPointCount = order.size();
+    report->EntryPoint.resize(order.size());
+    report->EntryPointTime.resize(order.size());
+    report->EntryPointReasonTime.resize(order.size() * R);
+    for (size_t i = 0, n = order.size(); i < n; ++i)
+    {
+        size_t const e = order[i].second;
+        report->EntryPoint    [i] = entry_points[e];
+        report->EntryPointTime[i] = order[i].first;
+        std::copy(entry_reason.begin() + e * R, entry_reason.begin() + (e + 1) * R, report->EntryPointReasonTime.begin() + i * R);
+    }
+}
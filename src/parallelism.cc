@@ -0,0 +1,387 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implement the parallelism profile, the number of tasks executing
+/// in each pool over time. The launch and finish columns of the task table are
+/// already sorted by time, so merging them yields every change in the running
+/// count in order. Large traces are swept in parallel: the time range is cut
+/// into partitions, a cheap first pass sums the net change of each partition
+/// so that the count at every partition start is known, and the partitions
+/// are then swept independently, once to size and once to write the output.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////////
+//   Preprocessor   //
+////////////////////*/
+/// @summary Define the number of sweep partitions created per thread. More partitions balance better when the task rate varies over the trace.
+#ifndef PARALLELISM_PARTITIONS_PER_THREAD
+#define PARALLELISM_PARTITIONS_PER_THREAD      4
+#endif
+
+/// @summary Define the minimum number of launch and finish events in a sweep partition. Smaller traces are swept by fewer threads.
+#ifndef PARALLELISM_MIN_PARTITION_SIZE
+#define PARALLELISM_MIN_PARTITION_SIZE         65536
+#endif
+
+/*//////////////////
+//   Data Types   //
+//////////////////*/
+/// @summary Define the data shared by the jobs of a BuildParallelismProfile call. Each sweep job processes one partition; each index job one pool.
+struct PARALLELISM_JOBS
+{
+    WIN32_TASK_TABLE const     *Table;            /// The task table being swept.
+    WIN32_PARALLELISM_PROFILE  *Profile;          /// The profile being built.
+    uint32_t const             *RowPool;          /// The index of the pool of each task table row, or WIN32_OBJECT_INDEX_EMPTY if the row is not counted.
+    size_t                      PoolCount;        /// The number of pools.
+    size_t const               *LaunchCut;        /// PartitionCount+1 offsets into LaunchSortedTime. Partition p holds [LaunchCut[p], LaunchCut[p+1]).
+    size_t const               *FinishCut;        /// PartitionCount+1 offsets into FinishSortedTime. Partition p holds [FinishCut[p], FinishCut[p+1]).
+    int64_t                    *Delta;            /// For partition p and pool k, Delta[p * PoolCount + k] is the net change in the running count.
+    uint32_t const             *StartValue;       /// For partition p and pool k, StartValue[p * PoolCount + k] is the running count at the partition start.
+    size_t                     *StepCount;        /// For partition p and pool k, StepCount[p * PoolCount + k] is the number of steps written by the partition.
+    size_t const               *StepOffset;       /// For partition p and pool k, StepOffset[p * PoolCount + k] is the index of the first step written by the partition.
+};
+
+/*//////////////////////////
+//   Internal Functions   //
+//////////////////////////*/
+/// @summary Determine whether an entry of LaunchSortedRow is the launch recorded for its row and is counted by the profile.
+/// @param jobs The sweep state.
+/// @param i The index of the entry in LaunchSortedTime.
+/// @return The pool of the task, or WIN32_OBJECT_INDEX_EMPTY if the entry is skipped.
+internal_function inline uint32_t
+ParallelismLaunchPool
+(
+    PARALLELISM_JOBS const *jobs,
+    size_t                     i
+)
+{
+    uint32_t const row = jobs->Table->LaunchSortedRow[i];
+    return (jobs->Table->LaunchTime[row] == jobs->Table->LaunchSortedTime[i]) ? jobs->RowPool[row] : WIN32_OBJECT_INDEX_EMPTY;
+}
+
+/// @summary Determine whether an entry of FinishSortedRow is the finish recorded for its row and is counted by the profile.
+/// @param jobs The sweep state.
+/// @param i The index of the entry in FinishSortedTime.
+/// @return The pool of the task, or WIN32_OBJECT_INDEX_EMPTY if the entry is skipped.
+internal_function inline uint32_t
+ParallelismFinishPool
+(
+    PARALLELISM_JOBS const *jobs,
+    size_t                     i
+)
+{
+    uint32_t const row = jobs->Table->FinishSortedRow[i];
+    return (jobs->Table->FinishTime[row] == jobs->Table->FinishSortedTime[i]) ? jobs->RowPool[row] : WIN32_OBJECT_INDEX_EMPTY;
+}
+
+/// @summary Compute the net change in the running count of each pool over one partition. Implements PLATFORM_JOB_FUNC.
+/// @param argp A pointer to the PARALLELISM_JOBS.
+/// @param partition The index of the partition.
+internal_function void
+ParallelismDeltaJob
+(
+    void       *argp,
+    size_t  partition
+)
+{
+    PARALLELISM_JOBS *jobs  = (PARALLELISM_JOBS*) argp;
+    int64_t          *delta = jobs->Delta + partition * jobs->PoolCount;
+    for (size_t i = jobs->LaunchCut[partition], n = jobs->LaunchCut[partition + 1]; i < n; ++i)
+    {
+        uint32_t const k = ParallelismLaunchPool(jobs, i);
+        if (k != WIN32_OBJECT_INDEX_EMPTY) delta[k]++;
+    }
+    for (size_t i = jobs->FinishCut[partition], n = jobs->FinishCut[partition + 1]; i < n; ++i)
+    {
+        uint32_t const k = ParallelismFinishPool(jobs, i);
+        if (k != WIN32_OBJECT_INDEX_EMPTY) delta[k]--;
+    }
+}
+
+/// @summary Sweep the launch and finish events of one partition in time order. All of the changes at one time are applied before a step
+/// is emitted, and a step that leaves the count unchanged is dropped, so each pool lists only the times at which its count actually changed.
+/// @param jobs The sweep state, with StartValue computed.
+/// @param partition The index of the partition.
+/// @param write true to write the steps at StepOffset, or false to count them into StepCount.
+internal_function void
+ParallelismSweep
+(
+    PARALLELISM_JOBS *jobs,
+    size_t       partition,
+    bool             write
+)
+{
+    WIN32_TASK_TABLE const *table   = jobs->Table;
+    size_t   const          K       = jobs->PoolCount;
+    size_t                  li      = jobs->LaunchCut[partition];
+    size_t   const          le      = jobs->LaunchCut[partition + 1];
+    size_t                  fi      = jobs->FinishCut[partition];
+    size_t   const          fe      = jobs->FinishCut[partition + 1];
+    std::vector<uint32_t>   value(jobs->StartValue + partition * K, jobs->StartValue + (partition + 1) * K);
+    std::vector<uint32_t>   emitted(value);
+    std::vector<size_t>     cursor(K, 0);
+    std::vector<uint8_t>    touched(K, 0);
+    std::vector<uint32_t>   touch_list;
+
+    if (write)
+    {
+        cursor.assign(jobs->StepOffset + partition * K, jobs->StepOffset + (partition + 1) * K);
+    }
+    while (li < le || fi < fe)
+    {
+        uint64_t time = (li < le) ? table->LaunchSortedTime[li] : table->FinishSortedTime[fi];
+        if (fi < fe && table->FinishSortedTime[fi] < time)
+            time = table->FinishSortedTime[fi];
+        for ( ; fi < fe && table->FinishSortedTime[fi] == time; ++fi)
+        {
+            uint32_t const k = ParallelismFinishPool(jobs, fi);
+            if (k == WIN32_OBJECT_INDEX_EMPTY) continue;
+            value[k]--;
+            if (!touched[k]) { touched[k] = 1; touch_list.push_back(k); }
+        }
+        for ( ; li < le && table->LaunchSortedTime[li] == time; ++li)
+        {
+            uint32_t const k = ParallelismLaunchPool(jobs, li);
+            if (k == WIN32_OBJECT_INDEX_EMPTY) continue;
+            value[k]++;
+            if (!touched[k]) { touched[k] = 1; touch_list.push_back(k); }
+        }
+        for (size_t i = 0, n = touch_list.size(); i < n; ++i)
+        {
+            uint32_t const k = touch_list[i];
+            touched[k] = 0;
+            if (value[k] == emitted[k])
+                continue;
+            emitted[k] = value[k];
+            if (write)
+            {
+                WIN32_STEP_FUNCTION &f = jobs->Profile->PoolRunning[k];
+                f.Time [cursor[k]] = time;
+                f.Value[cursor[k]] = value[k];
+            }
+            cursor[k]++;
+        }
+        touch_list.clear();
+    }
+    if (!write)
+    {
+        std::copy(cursor.begin(), cursor.end(), jobs->StepCount + partition * K);
+    }
+}
+
+/// @summary Count the steps written by one partition. Implements PLATFORM_JOB_FUNC.
+/// @param argp A pointer to the PARALLELISM_JOBS.
+/// @param partition The index of the partition.
+internal_function void
+ParallelismCountJob
+(
+    void       *argp,
+    size_t  partition
+)
+{
+    ParallelismSweep((PARALLELISM_JOBS*) argp, partition, false);
+}
+
+/// @summary Write the steps of one partition. Implements PLATFORM_JOB_FUNC.
+/// @param argp A pointer to the PARALLELISM_JOBS.
+/// @param partition The index of the partition.
+internal_function void
+ParallelismWriteJob
+(
+    void       *argp,
+    size_t  partition
+)
+{
+    ParallelismSweep((PARALLELISM_JOBS*) argp, partition, true);
+}
+
+/// @summary Index the step function of one pool and measure its time at saturation. Implements PLATFORM_JOB_FUNC.
+/// @param argp A pointer to the PARALLELISM_JOBS.
+/// @param pool The index of the pool.
+internal_function void
+ParallelismIndexJob
+(
+    void  *argp,
+    size_t pool
+)
+{
+    PARALLELISM_JOBS          *jobs    = (PARALLELISM_JOBS*) argp;
+    WIN32_PARALLELISM_PROFILE *profile = jobs->Profile;
+    WIN32_STEP_FUNCTION       &f       = profile->PoolRunning[pool];
+    uint32_t const             workers = profile->PoolWorkerCount[pool];
+    uint64_t                   busy    = 0;
+    BuildStepFunctionIndex(&f);
+    for (size_t i = 0; workers > 0 && i < f.StepCount; ++i)
+    {
+        uint64_t const end = (i + 1 < f.StepCount) ? f.Time[i + 1] : f.EndTime;
+        if (f.Value[i] >= workers && end > f.Time[i]) busy += end - f.Time[i];
+    }
+    profile->PoolSaturatedTime[pool] = busy;
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Free the memory used by a parallelism profile. The profile is left empty.
+/// @param profile The profile to delete.
+public_function void
+DeleteParallelismProfile
+(
+    WIN32_PARALLELISM_PROFILE *profile
+)
+{
+    profile->FirstTime = 0;
+    profile->EndTime   = 0;
+    profile->PoolCount = 0;
+    WIN32_COLUMN<uint32_t>().swap(profile->PoolId);
+    WIN32_COLUMN<uint32_t>().swap(profile->PoolWorkerCount);
+    WIN32_COLUMN<uint64_t>().swap(profile->PoolSaturatedTime);
+    std::vector<WIN32_STEP_FUNCTION>().swap(profile->PoolRunning);
+}
+
+/// @summary Build the number of tasks executing in each pool over time. A task is assigned to the pool of the worker that launched it, and
+/// executes from its launch until its finish. Tasks with no launch, or whose finish was not after their launch, are not counted.
+/// @param profile The profile to build. Any existing contents are replaced.
+/// @param task_table The task table, with complete launch and finish columns.
+/// @param scheduler The task scheduler configuration, used to assign launching workers to pools.
+/// @param thread_count The maximum number of threads to use. Specify 0 to use one thread per processor.
+public_function void
+BuildParallelismProfile
+(
+    WIN32_PARALLELISM_PROFILE      *profile,
+    WIN32_TASK_TABLE const      *task_table,
+    WIN32_SCHEDULER_INFO const   *scheduler,
+    uint32_t                   thread_count
+)
+{
+    size_t   const                              task_count   = task_table->TaskCount;
+    size_t   const                              launch_count = task_table->LaunchSortedTime.size();
+    size_t   const                              finish_count = task_table->FinishSortedTime.size();
+    std::vector<std::pair<uint32_t, uint32_t> > worker_pool(scheduler->WorkerCount);
+    std::vector<uint32_t>                       pools;
+    std::vector<uint32_t>                       row_pool(task_count, WIN32_OBJECT_INDEX_EMPTY);
+    bool                                        no_pool = false;
+
+    DeleteParallelismProfile(profile);
+    for (size_t i = 0; i < scheduler->WorkerCount; ++i)
+    {
+        SortedKeyInsert(pools, scheduler->WorkerPoolId[i]);
+    }
+    for (size_t i = 0; i < scheduler->WorkerCount; ++i)
+    {
+        uint32_t const k = uint32_t(std::lower_bound(pools.begin(), pools.end(), scheduler->WorkerPoolId[i]) - pools.begin());
+        worker_pool[i] = std::make_pair(scheduler->WorkerThreadId[i], k);
+    }
+    std::sort(worker_pool.begin(), worker_pool.end());
+
+    // find the pool of every counted task. tasks launched by unregistered threads share a pool listed after the registered ones.
+    for (size_t r = 0; r < task_count; ++r)
+    {
+        uint64_t const launch = task_table->LaunchTime[r];
+        uint64_t const finish = task_table->FinishTime[r];
+        if (launch == 0 || (finish != 0 && finish <= launch))
+            continue;
+        uint32_t const tid = task_table->WorkerThreadId[r];
+        std::vector<std::pair<uint32_t, uint32_t> >::const_iterator w = std::lower_bound(worker_pool.begin(), worker_pool.end(), std::make_pair(tid, uint32_t(0)));
+        if (w != worker_pool.end() && w->first == tid)
+        {
+            row_pool[r] = w->second;
+        }
+        else
+        {
+            row_pool[r] = uint32_t(pools.size());
+            no_pool     = true;
+        }
+    }
+
+    size_t const K = pools.size() + (no_pool ? 1 : 0);
+    profile->PoolCount = K;
+    profile->PoolId.assign(pools.data(), pools.data() + pools.size());
+    profile->PoolWorkerCount.assign(K, 0);
+    profile->PoolSaturatedTime.assign(K, 0);
+    profile->PoolRunning.resize(K);
+    if (no_pool) profile->PoolId.push_back(uint32_t(WIN32_QUEUE_DEPTH_NO_POOL));
+    for (size_t i = 0; i < scheduler->WorkerCount; ++i)
+    {
+        profile->PoolWorkerCount[worker_pool[i].second]++;
+    }
+    if (launch_count > 0)
+    {
+        profile->FirstTime = task_table->LaunchSortedTime.front();
+        profile->EndTime   = task_table->LaunchSortedTime.back();
+    }
+    if (finish_count > 0 && task_table->FinishSortedTime.back() > profile->EndTime)
+    {
+        profile->EndTime = task_table->FinishSortedTime.back();
+    }
+    if (K == 0)
+        return;
+
+    // cut the time range at quantiles of the launch times. both columns are cut at the first
+    // event at or after each boundary, so events with equal timestamps are never split up.
+    if (thread_count == 0)
+    {
+        thread_count = PlatformProcessorCount();
+    }
+    size_t partition_count = size_t(thread_count) * PARALLELISM_PARTITIONS_PER_THREAD;
+    if (partition_count > (launch_count + finish_count) / PARALLELISM_MIN_PARTITION_SIZE)
+        partition_count = (launch_count + finish_count) / PARALLELISM_MIN_PARTITION_SIZE;
+    if (partition_count == 0 || thread_count <= 1 || launch_count == 0)
+        partition_count = 1;
+
+    std::vector<size_t>   launch_cut(partition_count + 1);
+    std::vector<size_t>   finish_cut(partition_count + 1);
+    std::vector<int64_t>  delta(partition_count * K, 0);
+    std::vector<uint32_t> start_value(partition_count * K, 0);
+    std::vector<size_t>   step_count(partition_count * K, 0);
+    std::vector<size_t>   step_offset(partition_count * K, 0);
+    launch_cut[0] = 0;
+    finish_cut[0] = 0;
+    launch_cut[partition_count] = launch_count;
+    finish_cut[partition_count] = finish_count;
+    for (size_t p = 1; p < partition_count; ++p)
+    {
+        uint64_t const bound = task_table->LaunchSortedTime[(p * launch_count) / partition_count];
+        launch_cut[p] = size_t(std::lower_bound(task_table->LaunchSortedTime.begin(), task_table->LaunchSortedTime.end(), bound) - task_table->LaunchSortedTime.begin());
+        finish_cut[p] = size_t(std::lower_bound(task_table->FinishSortedTime.begin(), task_table->FinishSortedTime.end(), bound) - task_table->FinishSortedTime.begin());
+    }
+
+    PARALLELISM_JOBS jobs;
+    jobs.Table      = task_table;
+    jobs.Profile    = profile;
+    jobs.RowPool    = row_pool.data();
+    jobs.PoolCount  = K;
+    jobs.LaunchCut  = launch_cut.data();
+    jobs.FinishCut  = finish_cut.data();
+    jobs.Delta      = delta.data();
+    jobs.StartValue = start_value.data();
+    jobs.StepCount  = step_count.data();
+    jobs.StepOffset = step_offset.data();
+    PlatformParallelFor(thread_count, partition_count, ParallelismDeltaJob, &jobs);
+
+    // the running count at the start of each partition is the sum of the net changes before it.
+    for (size_t p = 1; p < partition_count; ++p)
+    {
+        for (size_t k = 0; k < K; ++k)
+        {
+            start_value[p * K + k] = uint32_t(int64_t(start_value[(p - 1) * K + k]) + delta[(p - 1) * K + k]);
+        }
+    }
+    PlatformParallelFor(thread_count, partition_count, ParallelismCountJob, &jobs);
+
+    // lay out the steps of each pool in partition order, then write them in place.
+    for (size_t k = 0; k < K; ++k)
+    {
+        WIN32_STEP_FUNCTION &f = profile->PoolRunning[k];
+        size_t               n = 0;
+        for (size_t p = 0; p < partition_count; ++p)
+        {
+            step_offset[p * K + k] = n;
+            n += step_count[p * K + k];
+        }
+        f.StepCount = n;
+        f.EndTime   = profile->EndTime;
+        f.Time.resize(n);
+        f.Value.resize(n);
+    }
+    PlatformParallelFor(thread_count, partition_count, ParallelismWriteJob, &jobs);
+    PlatformParallelFor(thread_count, K, ParallelismIndexJob, &jobs);
+}
@@ -0,0 +1,728 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implement a minimal platform abstraction layer for the portions
+/// of the profiler that must build and run on both Windows and Linux. This
+/// covers threads, mutexes, high-resolution timestamps and identifiers, file
+/// mapping, and a simple fork-join helper for running independent jobs in
+/// parallel.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////////
+//   Preprocessor   //
+////////////////////*/
+/// @summary Tag used to mark a variable as local to a thread. Each thread receives its own zero-initialized copy.
+#ifndef thread_local_variable
+    #if defined(_MSC_VER)
+        #define thread_local_variable          static __declspec(thread)
+    #else
+        #define thread_local_variable          static __thread
+    #endif
+#endif
+
+/// @summary Define the size of a cache line on the target processor, in bytes. Used to pad shared data and avoid false sharing.
+#ifndef PLATFORM_CACHELINE_SIZE
+    #define PLATFORM_CACHELINE_SIZE            64
+#endif
+
+/// @summary Defined to 1 when the target processor has a cycle counter readable from user mode with a single instruction.
+#ifndef PLATFORM_HAS_CYCLE_COUNTER
+    #if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+        #define PLATFORM_HAS_CYCLE_COUNTER     1
+    #else
+        #define PLATFORM_HAS_CYCLE_COUNTER     0
+    #endif
+#endif
+
+/// @summary Defined to 1 when per-thread hardware counters can be opened with perf_event_open and read from user mode with rdpmc.
+#ifndef PLATFORM_HAS_PERF_COUNTERS
+    #if defined(__linux__) && PLATFORM_HAS_CYCLE_COUNTER
+        #define PLATFORM_HAS_PERF_COUNTERS     1
+    #else
+        #define PLATFORM_HAS_PERF_COUNTERS     0
+    #endif
+#endif
+
+/// @summary Define the number of hardware counters in a PLATFORM_COUNTER_GROUP. See PLATFORM_COUNTER.
+#ifndef PLATFORM_COUNTER_GROUP_SIZE
+    #define PLATFORM_COUNTER_GROUP_SIZE        5
+#endif
+
+/*////////////////
+//   Includes   //
+////////////////*/
+#if defined(_WIN32)
+    #include <io.h>
+    #include <process.h>
+    #include <intrin.h>
+#else
+    #include <errno.h>
+    #include <pthread.h>
+    #include <time.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <sys/syscall.h>
+    #include <sys/types.h>
+    #if PLATFORM_HAS_CYCLE_COUNTER
+        #include <cpuid.h>
+        #include <x86intrin.h>
+    #endif
+    #if PLATFORM_HAS_PERF_COUNTERS
+        #include <linux/perf_event.h>
+    #endif
+#endif
+
+/*//////////////////
+//   Data Types   //
+//////////////////*/
+/// @summary Define the signature of the entry point of a thread created with PlatformCreateThread.
+typedef void (*PLATFORM_THREAD_FUNC)(void *argp);
+
+#if defined(_WIN32)
+typedef HANDLE                         PLATFORM_THREAD;     /// The handle returned by _beginthreadex.
+typedef CRITICAL_SECTION               PLATFORM_MUTEX;      /// A non-recursive lock, used only outside of hot paths.
+#else
+typedef pthread_t                      PLATFORM_THREAD;     /// The identifier returned by pthread_create.
+typedef pthread_mutex_t                PLATFORM_MUTEX;      /// A non-recursive lock, used only outside of hot paths.
+#endif
+
+/// @summary Define a read-only or copy-on-write view of an entire file mapped into the process address space.
+struct PLATFORM_FILE_MAPPING
+{
+    uint8_t const                     *Data;                /// The address of the first byte of the file, or NULL if the file is empty.
+    size_t                             Size;                /// The size of the file, in bytes.
+    uint64_t                           ModifiedTime;        /// The last write time of the file, in platform-specific units.
+#if defined(_WIN32)
+    HANDLE                             Mapping;             /// The handle returned by CreateFileMapping.
+#endif
+};
+
+/// @summary Define the hardware counters opened by PlatformOpenCounterGroup. Values are indices into the array filled by PlatformReadCounterGroup.
+enum PLATFORM_COUNTER : uint32_t
+{
+    PLATFORM_COUNTER_CYCLES            = 0,                 /// Core cycles, in user mode.
+    PLATFORM_COUNTER_INSTRUCTIONS      = 1,                 /// Instructions retired, in user mode.
+    PLATFORM_COUNTER_L1D_MISSES        = 2,                 /// Level 1 data cache read misses.
+    PLATFORM_COUNTER_LLC_MISSES        = 3,                 /// Last level cache misses.
+    PLATFORM_COUNTER_BRANCH_MISSES     = 4,                 /// Mispredicted branch instructions.
+};
+
+/// @summary Define a group of hardware counters attached to a single thread. The counters are scheduled onto a processor together, so
+/// ratios between them are consistent, and are read without a system call, but only by the thread they are attached to.
+struct PLATFORM_COUNTER_GROUP
+{
+    uint32_t                           CounterMask;         /// Bit i is set if the counter with PLATFORM_COUNTER value i is open and readable from user mode.
+#if PLATFORM_HAS_PERF_COUNTERS
+    int                                Fd[PLATFORM_COUNTER_GROUP_SIZE];   /// The perf_event_open file descriptor of each counter, or -1. Fd[0] is the group leader.
+    perf_event_mmap_page volatile     *Page[PLATFORM_COUNTER_GROUP_SIZE]; /// The mapped control page of each counter, or NULL.
+#endif
+};
+
+/// @summary Define the signature of a job executed by PlatformParallelFor.
+typedef void (*PLATFORM_JOB_FUNC)(void *argp, size_t job_index);
+
+/// @summary Define the state shared by the threads executing a PlatformParallelFor call.
+struct PLATFORM_PARALLEL_FOR
+{
+    PLATFORM_JOB_FUNC                  JobMain;             /// The user-supplied job function.
+    void                              *JobArgs;             /// The argument passed through to JobMain.
+    size_t                             JobCount;            /// The total number of jobs.
+    std::atomic<size_t>                NextJob;             /// The index of the next job to be claimed.
+};
+
+/// @summary Define the data passed from PlatformCreateThread to the native thread entry point.
+struct PLATFORM_THREAD_START
+{
+    PLATFORM_THREAD_FUNC               ThreadMain;          /// The user-supplied thread entry point.
+    void                              *ThreadArgs;          /// The argument passed through to ThreadMain.
+};
+
+/*//////////////////////////
+//   Internal Functions   //
+//////////////////////////*/
+/// @summary Implement the native entry point for threads created with PlatformCreateThread.
+/// @param argp A PLATFORM_THREAD_START allocated by PlatformCreateThread. The entry point frees it.
+/// @return Zero (unused).
+#if defined(_WIN32)
+internal_function unsigned int __stdcall
+PlatformThreadStart
+(
+    void *argp
+)
+#else
+internal_function void*
+PlatformThreadStart
+(
+    void *argp
+)
+#endif
+{
+    PLATFORM_THREAD_START start = *(PLATFORM_THREAD_START*) argp;
+    free(argp);
+    start.ThreadMain(start.ThreadArgs);
+    return 0;
+}
+
+/// @summary Claim and execute jobs from a PlatformParallelFor call until none remain.
+/// @param argp A pointer to the PLATFORM_PARALLEL_FOR shared by all participating threads.
+internal_function void
+PlatformParallelForThreadMain
+(
+    void *argp
+)
+{
+    PLATFORM_PARALLEL_FOR *work = (PLATFORM_PARALLEL_FOR*) argp;
+    size_t                 job;
+    while ((job = work->NextJob.fetch_add(1, std::memory_order_relaxed)) < work->JobCount)
+    {
+        work->JobMain(work->JobArgs, job);
+    }
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Start a new thread.
+/// @param thread On return, this value is set to the platform handle of the new thread.
+/// @param thread_main The thread entry point.
+/// @param argp Opaque data passed through to the thread entry point.
+/// @return true if the thread was started.
+public_function bool
+PlatformCreateThread
+(
+    PLATFORM_THREAD          *thread,
+    PLATFORM_THREAD_FUNC thread_main,
+    void                       *argp
+)
+{
+    PLATFORM_THREAD_START *start = (PLATFORM_THREAD_START*) malloc(sizeof(PLATFORM_THREAD_START));
+    if (start == NULL)
+    {   // insufficient memory to start the thread.
+        return false;
+    }
+    start->ThreadMain = thread_main;
+    start->ThreadArgs = argp;
+#if defined(_WIN32)
+    if ((*thread = (HANDLE)_beginthreadex(NULL, 0, PlatformThreadStart, start, 0, NULL)) == NULL)
+    {   // the thread could not be started, so it will never free the start data.
+        free(start);
+        return false;
+    }
+#else
+    if (pthread_create(thread, NULL, PlatformThreadStart, start) != 0)
+    {   // the thread could not be started, so it will never free the start data.
+        free(start);
+        return false;
+    }
+#endif
+    return true;
+}
+
+/// @summary Block the calling thread until another thread exits, and release the thread handle.
+/// @param thread The handle of the thread to wait for, returned by PlatformCreateThread.
+public_function void
+PlatformJoinThread
+(
+    PLATFORM_THREAD thread
+)
+{
+#if defined(_WIN32)
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+#else
+    pthread_join(thread, NULL);
+#endif
+}
+
+/// @summary Initialize a mutex object.
+/// @param mutex The mutex to initialize.
+public_function void
+PlatformMutexInit
+(
+    PLATFORM_MUTEX *mutex
+)
+{
+#if defined(_WIN32)
+    InitializeCriticalSection(mutex);
+#else
+    pthread_mutex_init(mutex, NULL);
+#endif
+}
+
+/// @summary Release the resources associated with a mutex object. The mutex must not be held.
+/// @param mutex The mutex to delete.
+public_function void
+PlatformMutexDelete
+(
+    PLATFORM_MUTEX *mutex
+)
+{
+#if defined(_WIN32)
+    DeleteCriticalSection(mutex);
+#else
+    pthread_mutex_destroy(mutex);
+#endif
+}
+
+/// @summary Acquire a mutex, blocking the calling thread until it becomes available.
+/// @param mutex The mutex to acquire.
+public_function inline void
+PlatformMutexLock
+(
+    PLATFORM_MUTEX *mutex
+)
+{
+#if defined(_WIN32)
+    EnterCriticalSection(mutex);
+#else
+    pthread_mutex_lock(mutex);
+#endif
+}
+
+/// @summary Release a mutex previously acquired by the calling thread.
+/// @param mutex The mutex to release.
+public_function inline void
+PlatformMutexUnlock
+(
+    PLATFORM_MUTEX *mutex
+)
+{
+#if defined(_WIN32)
+    LeaveCriticalSection(mutex);
+#else
+    pthread_mutex_unlock(mutex);
+#endif
+}
+
+/// @summary Suspend the calling thread for at least the specified amount of time.
+/// @param milliseconds The minimum number of milliseconds to sleep for.
+public_function void
+PlatformSleep
+(
+    uint32_t milliseconds
+)
+{
+#if defined(_WIN32)
+    Sleep(milliseconds);
+#else
+    struct timespec ts;
+    ts.tv_sec  = time_t(milliseconds / 1000);
+    ts.tv_nsec = long  (milliseconds % 1000) * 1000000L;
+    while (nanosleep(&ts, &ts) != 0)
+    {   // interrupted by a signal; sleep for the remaining time.
+    }
+#endif
+}
+
+/// @summary Retrieve the operating system identifier of the calling thread. This may require a system call.
+/// @return The operating system thread identifier.
+public_function uint32_t
+PlatformThreadId
+(
+    void
+)
+{
+#if defined(_WIN32)
+    return uint32_t(GetCurrentThreadId());
+#else
+    return uint32_t(syscall(SYS_gettid));
+#endif
+}
+
+/// @summary Retrieve the operating system identifier of the calling process.
+/// @return The operating system process identifier.
+public_function uint32_t
+PlatformProcessId
+(
+    void
+)
+{
+#if defined(_WIN32)
+    return uint32_t(GetCurrentProcessId());
+#else
+    return uint32_t(getpid());
+#endif
+}
+
+/// @summary Retrieve the number of ticks-per-second of the timestamp counter returned by PlatformTimestamp.
+/// @return The timestamp counter frequency, in ticks-per-second.
+public_function uint64_t
+PlatformTimestampFrequency
+(
+    void
+)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER freq;
+    QueryPerformanceFrequency(&freq);
+    return uint64_t(freq.QuadPart);
+#else
+    return 1000000000ULL;
+#endif
+}
+
+/// @summary Read the system high-resolution monotonic timer. Neither call requires a kernel transition on current systems.
+/// @return The current timestamp, in ticks. See PlatformTimestampFrequency.
+public_function inline uint64_t
+PlatformTimestamp
+(
+    void
+)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER qpc;
+    QueryPerformanceCounter(&qpc);
+    return uint64_t(qpc.QuadPart);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t(ts.tv_sec) * 1000000000ULL) + uint64_t(ts.tv_nsec);
+#endif
+}
+
+/// @summary Read the system monotonic clock in nanoseconds. This is the reference against which the cycle counter is calibrated.
+/// @return The current value of the monotonic clock, in nanoseconds.
+public_function uint64_t
+PlatformMonotonicNanoseconds
+(
+    void
+)
+{
+#if defined(_WIN32)
+    uint64_t const freq  = PlatformTimestampFrequency();
+    uint64_t const ticks = PlatformTimestamp();
+    return ((ticks / freq) * 1000000000ULL) + (((ticks % freq) * 1000000000ULL) / freq);
+#else
+    return PlatformTimestamp();
+#endif
+}
+
+/// @summary Determine whether the processor cycle counter ticks at a constant rate in all power states and is synchronized across
+/// processors, so that PlatformCycleCounter values can be compared between threads and converted to time by calibration.
+/// @return true if the cycle counter is invariant.
+public_function bool
+PlatformHasInvariantCycleCounter
+(
+    void
+)
+{
+#if PLATFORM_HAS_CYCLE_COUNTER && defined(_MSC_VER)
+    int regs[4];
+    __cpuid(regs, 0x80000000);
+    if (unsigned(regs[0]) < 0x80000007U) return false;
+    __cpuid(regs, 0x80000007);
+    return (regs[3] & (1 << 8)) != 0;
+#elif PLATFORM_HAS_CYCLE_COUNTER
+    unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (__get_cpuid_max(0x80000000U, NULL) < 0x80000007U) return false;
+    __get_cpuid(0x80000007U, &eax, &ebx, &ecx, &edx);
+    return (edx & (1U << 8)) != 0;
+#else
+    return false;
+#endif
+}
+
+/// @summary Read the processor cycle counter. This is several times cheaper than PlatformTimestamp, but its rate is not known in advance;
+/// check PlatformHasInvariantCycleCounter and calibrate against PlatformMonotonicNanoseconds before converting values to time.
+/// @return The current cycle count, or PlatformTimestamp on processors without a user-mode cycle counter.
+public_function inline uint64_t
+PlatformCycleCounter
+(
+    void
+)
+{
+#if PLATFORM_HAS_CYCLE_COUNTER
+    return uint64_t(__rdtsc());
+#else
+    return PlatformTimestamp();
+#endif
+}
+
+/// @summary Attach a group of hardware counters to a thread of the calling process. Counters the processor or kernel can't provide, or
+/// that can't be read from user mode, are left out of the group. The group needs the cycle counter, which leads it.
+/// @param group On return, describes the counters that were opened.
+/// @param thread_id The operating system identifier of the thread to count. Only this thread may call PlatformReadCounterGroup.
+/// @return true if at least the cycle counter was opened.
+public_function bool
+PlatformOpenCounterGroup
+(
+    PLATFORM_COUNTER_GROUP *group,
+    uint32_t            thread_id
+)
+{
+    group->CounterMask = 0;
+#if PLATFORM_HAS_PERF_COUNTERS
+    static uint64_t const config[PLATFORM_COUNTER_GROUP_SIZE][2] =
+    {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES    },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS  },
+        { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES  },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES }
+    };
+    size_t const page_size = size_t(sysconf(_SC_PAGESIZE));
+    for (uint32_t i = 0; i < PLATFORM_COUNTER_GROUP_SIZE; ++i)
+    {
+        group->Fd[i]   = -1;
+        group->Page[i] = NULL;
+    }
+    for (uint32_t i = 0; i < PLATFORM_COUNTER_GROUP_SIZE; ++i)
+    {
+        perf_event_attr attr;
+        void           *page;
+        int             fd;
+        memset(&attr, 0, sizeof(attr));
+        attr.size           = sizeof(attr);
+        attr.type           = uint32_t(config[i][0]);
+        attr.config         = config[i][1];
+        attr.exclude_kernel = 1;
+        attr.exclude_hv     = 1;
+        if ((fd = int(syscall(SYS_perf_event_open, &attr, pid_t(thread_id), -1, group->Fd[0], PERF_FLAG_FD_CLOEXEC))) < 0)
+        {   // the processor doesn't have this counter, there are no hardware counters, or perf_event_paranoid denies access.
+            if (i == 0) return false;
+            continue;
+        }
+        if ((page = mmap(NULL, page_size, PROT_READ, MAP_SHARED, fd, 0)) == MAP_FAILED || ((perf_event_mmap_page*) page)->cap_user_rdpmc == 0)
+        {   // reading the counter would need a system call, which is too expensive for the callers of PlatformReadCounterGroup.
+            if (page != MAP_FAILED) munmap(page, page_size);
+            close(fd);
+            if (i == 0) return false;
+            continue;
+        }
+        group->Fd[i]        = fd;
+        group->Page[i]      = (perf_event_mmap_page volatile*) page;
+        group->CounterMask |= 1U << i;
+    }
+    return true;
+#else
+    (void) thread_id;
+    return false;
+#endif
+}
+
+/// @summary Read the counters of a group attached to the calling thread. This doesn't make a system call.
+/// A counter that is multiplexed off the processor doesn't advance, so values may undercount when more counters are open than the processor has.
+/// @param group The counter group, opened by PlatformOpenCounterGroup for the calling thread.
+/// @param values On return, PLATFORM_COUNTER_GROUP_SIZE counter values indexed by PLATFORM_COUNTER. Counters not in the group are set to 0.
+public_function inline void
+PlatformReadCounterGroup
+(
+    PLATFORM_COUNTER_GROUP const *group,
+    uint64_t                    *values
+)
+{
+#if PLATFORM_HAS_PERF_COUNTERS
+    for (uint32_t i = 0; i < PLATFORM_COUNTER_GROUP_SIZE; ++i)
+    {
+        perf_event_mmap_page volatile *pc = group->Page[i];
+        uint64_t                    count = 0;
+        uint32_t                      seq;
+        if (pc == NULL)
+        {
+            values[i] = 0;
+            continue;
+        }
+        do
+        {   // the kernel rewrites the page under a sequence lock whenever the counter is scheduled in or out.
+            seq = pc->lock;
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+            uint32_t const index = pc->index;
+            count = uint64_t(pc->offset);
+            if (pc->cap_user_rdpmc && index != 0 && pc->pmc_width > 0 && pc->pmc_width < 64)
+            {   // the counter is live on this processor; add its current value, sign-extended from the counter width.
+                uint32_t const shift = 64 - uint32_t(pc->pmc_width);
+                count += uint64_t(int64_t(uint64_t(__rdpmc(int(index - 1))) << shift) >> shift);
+            }
+            std::atomic_signal_fence(std::memory_order_seq_cst);
+        } while (pc->lock != seq);
+        values[i] = count;
+    }
+#else
+    (void) group;
+    for (uint32_t i = 0; i < PLATFORM_COUNTER_GROUP_SIZE; ++i)
+    {
+        values[i] = 0;
+    }
+#endif
+}
+
+/// @summary Release the counters of a group opened by PlatformOpenCounterGroup.
+/// @param group The counter group to close. On return, the group has no counters.
+public_function void
+PlatformCloseCounterGroup
+(
+    PLATFORM_COUNTER_GROUP *group
+)
+{
+#if PLATFORM_HAS_PERF_COUNTERS
+    size_t const page_size = size_t(sysconf(_SC_PAGESIZE));
+    for (uint32_t i = PLATFORM_COUNTER_GROUP_SIZE; i > 0; --i)
+    {   // close the group members before the leader.
+        if ((group->CounterMask & (1U << (i - 1))) == 0)
+            continue;
+        munmap((void*) group->Page[i - 1], page_size);
+        close(group->Fd[i - 1]);
+        group->Page[i - 1] = NULL;
+        group->Fd[i - 1]   = -1;
+    }
+#endif
+    group->CounterMask = 0;
+}
+
+/// @summary Retrieve the number of logical processors available to the process.
+/// @return The number of logical processors, at least 1.
+public_function uint32_t
+PlatformProcessorCount
+(
+    void
+)
+{
+#if defined(_WIN32)
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors > 0 ? uint32_t(info.dwNumberOfProcessors) : 1;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? uint32_t(count) : 1;
+#endif
+}
+
+/// @summary Execute a set of independent jobs on a group of threads and wait for all of them to complete.
+/// The calling thread participates, and jobs are claimed dynamically so that uneven job sizes balance out.
+/// @param thread_count The maximum number of threads to use, including the calling thread. Specify 0 to use one thread per processor.
+/// @param job_count The number of jobs to execute.
+/// @param job_main The function to call for each job. The function is called concurrently from multiple threads.
+/// @param argp Opaque data passed through to the job function.
+public_function void
+PlatformParallelFor
+(
+    uint32_t           thread_count,
+    size_t                job_count,
+    PLATFORM_JOB_FUNC      job_main,
+    void                      *argp
+)
+{
+    if (thread_count == 0)
+    {   // use all available processors.
+        thread_count = PlatformProcessorCount();
+    }
+    if (thread_count > job_count)
+    {   // there's no point starting threads that would never claim a job.
+        thread_count = uint32_t(job_count);
+    }
+    if (thread_count <= 1)
+    {   // run all of the jobs on the calling thread.
+        for (size_t i = 0; i < job_count; ++i)
+        {
+            job_main(argp, i);
+        }
+        return;
+    }
+
+    PLATFORM_PARALLEL_FOR        work;
+    std::vector<PLATFORM_THREAD> threads;
+    work.JobMain  = job_main;
+    work.JobArgs  = argp;
+    work.JobCount = job_count;
+    work.NextJob.store(0, std::memory_order_relaxed);
+    threads.reserve(thread_count - 1);
+    for (uint32_t i = 1; i < thread_count; ++i)
+    {   // if a thread can't be started, the remaining threads pick up its share of the work.
+        PLATFORM_THREAD thread;
+        if (PlatformCreateThread(&thread, PlatformParallelForThreadMain, &work))
+            threads.push_back(thread);
+    }
+    PlatformParallelForThreadMain(&work);
+    for (size_t i = 0, n = threads.size(); i < n; ++i)
+    {
+        PlatformJoinThread(threads[i]);
+    }
+}
+
+/// @summary Map the entire contents of an open file into the process address space for reading.
+/// The mapping remains valid after the file is closed, until it is passed to PlatformUnmapFile.
+/// @param fp The file to map, opened for reading.
+/// @param mapping On return, describes the mapped view of the file.
+/// @param copy_on_write Specify true to allow the view to be modified. Modified pages are private to the process and are
+/// never written back to the file, but each one is charged against the commit limit, so read-only views are preferred.
+/// @return true if the file was mapped. Empty files are reported as mapped with a NULL Data pointer.
+public_function bool
+PlatformMapFile
+(
+    FILE                     *fp,
+    PLATFORM_FILE_MAPPING *mapping,
+    bool             copy_on_write
+)
+{
+    mapping->Data = NULL;
+    mapping->Size = 0;
+    mapping->ModifiedTime = 0;
+#if defined(_WIN32)
+    HANDLE        file = (HANDLE) _get_osfhandle(_fileno(fp));
+    LARGE_INTEGER size;
+    FILETIME      write_time;
+    mapping->Mapping = NULL;
+    if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &size) || !GetFileTime(file, NULL, NULL, &write_time))
+    {   // the file handle is invalid.
+        return false;
+    }
+    mapping->ModifiedTime = (uint64_t(write_time.dwHighDateTime) << 32) | uint64_t(write_time.dwLowDateTime);
+    if (size.QuadPart == 0)
+    {   // empty files cannot be mapped, but there's nothing to read anyway.
+        return true;
+    }
+    if ((mapping->Mapping = CreateFileMapping(file, NULL, copy_on_write ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, NULL)) == NULL)
+    {   // the file mapping object could not be created.
+        return false;
+    }
+    if ((mapping->Data = (uint8_t const*) MapViewOfFile(mapping->Mapping, copy_on_write ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0)) == NULL)
+    {   // insufficient address space to map the view.
+        CloseHandle(mapping->Mapping);
+        mapping->Mapping = NULL;
+        return false;
+    }
+    mapping->Size = size_t(size.QuadPart);
+    return true;
+#else
+    struct stat st;
+    void       *addr;
+    if (fstat(fileno(fp), &st) != 0)
+    {   // the file descriptor is invalid.
+        return false;
+    }
+#if defined(__APPLE__)
+    mapping->ModifiedTime = uint64_t(st.st_mtimespec.tv_sec) * 1000000000ULL + uint64_t(st.st_mtimespec.tv_nsec);
+#else
+    mapping->ModifiedTime = uint64_t(st.st_mtim.tv_sec) * 1000000000ULL + uint64_t(st.st_mtim.tv_nsec);
+#endif
+    if (st.st_size == 0)
+    {   // empty files cannot be mapped, but there's nothing to read anyway.
+        return true;
+    }
+    if ((addr = mmap(NULL, size_t(st.st_size), copy_on_write ? PROT_READ | PROT_WRITE : PROT_READ, MAP_PRIVATE, fileno(fp), 0)) == MAP_FAILED)
+    {   // insufficient address space to map the view.
+        return false;
+    }
+    mapping->Data = (uint8_t const*) addr;
+    mapping->Size = size_t(st.st_size);
+    return true;
+#endif
+}
+
+/// @summary Release a view of a file mapped by PlatformMapFile.
+/// @param mapping The file mapping to release. On return, the Data and Size fields are cleared.
+public_function void
+PlatformUnmapFile
+(
+    PLATFORM_FILE_MAPPING *mapping
+)
+{
+#if defined(_WIN32)
+    if (mapping->Data    != NULL) UnmapViewOfFile(mapping->Data);
+    if (mapping->Mapping != NULL) CloseHandle(mapping->Mapping);
+    mapping->Mapping = NULL;
+#else
+    if (mapping->Data    != NULL) munmap((void*) mapping->Data, mapping->Size);
+#endif
+    mapping->Data = NULL;
+    mapping->Size = 0;
+}
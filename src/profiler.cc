@@ -7,10 +7,28 @@
 /*////////////////////
 //   Preprocessor   //
 ////////////////////*/
+/// @summary Define the maximum number of dependencies written with a DefineTaskEvent. ETW limits an event to 64KB,
+/// including its headers, so longer dependency lists are truncated and the event's dependency count reflects the truncation.
+#ifndef PROFILER_ETW_MAX_DEPENDENCIES
+#define PROFILER_ETW_MAX_DEPENDENCIES          15360
+#endif
+
+/// @summary Define the maximum number of zone sites that can be registered by the process. Must be less than 65536, since site identifiers are 16-bit values.
+#ifndef PROFILER_ETW_MAX_ZONE_SITES
+#define PROFILER_ETW_MAX_ZONE_SITES            4096
+#endif
 
 /*///////////////
 //   Globals   //
 ///////////////*/
+/// @summary Events are written for 1 in ProfilerTaskSampleRate tasks. See TaskSampled.
+global_variable uint32_t ProfilerTaskSampleRate = 1;
+
+/// @summary The number of zone site identifiers handed out by RegisterZoneSite. Sites may register before InitializeProfiler.
+global_variable LONG volatile ProfilerZoneSiteCount = 0;
+
+/// @summary The registered zone sites, indexed by site identifier, so they can be written again when a new session starts.
+global_variable PROFILER_ZONE_SITE const * volatile ProfilerZoneSites[PROFILER_ETW_MAX_ZONE_SITES + 1];
 
 /*////////////////////////
 //   Public Functions   //
@@ -32,6 +50,10 @@ InitializeProfiler
     {   // the application is requesting a newer profiler version than is supported.
         return PROFILER_RESULT_INVALID_VERSION;
     }
+    if (config->ProfilerMinorVersion >= 5 && config->TaskAllocations != 0)
+    {   // the ETW backend has no allocation hooks, and the caller would otherwise get a trace without the allocations it asked for.
+        return PROFILER_RESULT_UNSUPPORTED;
+    }
 
     LARGE_INTEGER       qpc = {};
     uint64_t      frequency = 0;
@@ -40,6 +62,7 @@ InitializeProfiler
     // retrieve the frequency of the system high-resolution timer.
     QueryPerformanceFrequency(&qpc);
     frequency = uint64_t(qpc.QuadPart);
+    ProfilerTaskSampleRate = config->ProfilerMinorVersion >= 2 && config->TaskSampleRate > 1 ? config->TaskSampleRate : 1;
 
     // call the registration functions, which are defined in the generated provider.h file.
     EventRegisterProfiler_Task();
@@ -52,7 +75,17 @@ InitializeProfiler
         config->ApplicationMinorVersion, 
         config->ComputePoolSize, 
         config->GeneralPoolSize, 
-        frequency);
+        frequency,
+        ProfilerTaskSampleRate);
+
+    // sites register once, on first use, so describe the ones registered before this session to its trace.
+    LONG site_count = ProfilerZoneSiteCount;
+    if (site_count > PROFILER_ETW_MAX_ZONE_SITES) site_count = PROFILER_ETW_MAX_ZONE_SITES;
+    for (LONG i = 1; i <= site_count; ++i)
+    {
+        PROFILER_ZONE_SITE const *site = ProfilerZoneSites[i];
+        if (site != NULL) EventWriteRegisterZoneSiteEvent(uint32_t(i), site->Name, site->File, site->Function, site->Line);
+    }
 
     return PROFILER_RESULT_SUCCESS;
 }
@@ -115,19 +148,14 @@ MarkTaskDefinition
     uint32_t const *dependencies
 )
 {
-    uint32_t dep_list[3] = {
-        INVALID_TASK_ID, 
-        INVALID_TASK_ID, 
-        INVALID_TASK_ID
-    };
-    if (dependencies != NULL && dependency_count > 0)
-    {
-        for (size_t i = 0, n  = dependency_count > 3 ? 3 : dependency_count; i < n; ++i)
-        {
-            dep_list[i] = dependencies[i];
-        }
+    if (!TaskSampled(task_id, ProfilerTaskSampleRate))
+        return;
+    uint32_t dep_count = dependencies != NULL ? dependency_count : 0;
+    if (dep_count > PROFILER_ETW_MAX_DEPENDENCIES)
+    {   // the event would exceed the ETW event size limit and be dropped entirely.
+        dep_count = PROFILER_ETW_MAX_DEPENDENCIES;
     }
-    EventWriteDefineTaskEvent(task_id, parent_id, task_main, source_index, dep_list[0], dep_list[1], dep_list[2]);
+    EventWriteDefineTaskEvent(task_id, parent_id, task_main, source_index, dep_count, dependencies);
 }
 
 /// @summary Mark the point in time at which a task becomes ready-to-run.
@@ -140,7 +168,8 @@ MarkTaskReadyToRun
     uint32_t source_index
 )
 {
-    EventWriteTaskReadyToRunEvent(task_id, source_index);
+    if (TaskSampled(task_id, ProfilerTaskSampleRate))
+        EventWriteTaskReadyToRunEvent(task_id, source_index);
 }
 
 /// @summary Mark the point in time at which a worker thread begins executing a task.
@@ -151,7 +180,8 @@ MarkTaskLaunch
     uint32_t task_id
 )
 {
-    EventWriteTaskLaunchEvent(task_id, GetCurrentThreadId());
+    if (TaskSampled(task_id, ProfilerTaskSampleRate))
+        EventWriteTaskLaunchEvent(task_id, GetCurrentThreadId());
 }
 
 /// @summary Mark the point in time at which a worker thread finishes executing a task.
@@ -162,6 +192,49 @@ MarkTaskFinish
     uint32_t task_id
 )
 {
-    EventWriteTaskFinishEvent(task_id, GetCurrentThreadId());
+    if (TaskSampled(task_id, ProfilerTaskSampleRate))
+        EventWriteTaskFinishEvent(task_id, GetCurrentThreadId());
+}
+
+/// @summary Assign an identifier to a zone site. Called once per site by PROFILER_ZONE, from any thread, before or after InitializeProfiler.
+/// @param site The site description, which must have static storage duration.
+/// @return The site identifier, or INVALID_ZONE_SITE if PROFILER_ETW_MAX_ZONE_SITES sites have already been registered.
+uint32_t __cdecl
+RegisterZoneSite
+(
+    PROFILER_ZONE_SITE const *site
+)
+{
+    if (site == NULL)
+        return INVALID_ZONE_SITE;
+    LONG const id = InterlockedIncrement(&ProfilerZoneSiteCount);
+    if (id > PROFILER_ETW_MAX_ZONE_SITES)
+        return INVALID_ZONE_SITE;
+    ProfilerZoneSites[id] = site;
+    EventWriteRegisterZoneSiteEvent(uint32_t(id), site->Name, site->File, site->Function, site->Line);
+    return uint32_t(id);
+}
+
+/// @summary Mark the point in time at which the calling thread enters a zone.
+/// @param site_id The identifier returned by RegisterZoneSite.
+void __cdecl
+MarkZoneBegin
+(
+    uint32_t site_id
+)
+{
+    if (site_id != INVALID_ZONE_SITE)
+        EventWriteZoneBeginEvent(site_id);
 }
 
+/// @summary Mark the point in time at which the calling thread leaves the zone it entered most recently.
+/// @param site_id The identifier passed to the matching MarkZoneBegin.
+void __cdecl
+MarkZoneEnd
+(
+    uint32_t site_id
+)
+{
+    if (site_id != INVALID_ZONE_SITE)
+        EventWriteZoneEndEvent(site_id);
+}
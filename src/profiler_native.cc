@@ -0,0 +1,1692 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implement the public interface to the profiler on top of per-
+/// thread, single-producer ring buffers. Each thread that calls into the
+/// profiler writes fixed-size records into its own buffer without locks or
+/// system calls, and a background thread drains all buffers to a compact
+/// .ptrace file (see ptrace.h). This backend is portable and does not
+/// require ETW.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////////
+//   Preprocessor   //
+////////////////////*/
+/// @summary Define the default number of event records in each per-thread buffer. Must be a power of two.
+#ifndef PROFILER_NATIVE_DEFAULT_BUFFER_SIZE
+#define PROFILER_NATIVE_DEFAULT_BUFFER_SIZE    65536
+#endif
+
+/// @summary Define the maximum number of threads that can write events during a single profiler session.
+#ifndef PROFILER_NATIVE_MAX_THREADS
+#define PROFILER_NATIVE_MAX_THREADS            1024
+#endif
+
+/// @summary Define the number of milliseconds between passes of the background flush thread.
+#ifndef PROFILER_NATIVE_FLUSH_INTERVAL
+#define PROFILER_NATIVE_FLUSH_INTERVAL         10
+#endif
+
+/// @summary Define the number of milliseconds between clock calibration samples when timestamps come from the processor cycle counter.
+#ifndef PROFILER_NATIVE_CLOCK_SYNC_INTERVAL
+#define PROFILER_NATIVE_CLOCK_SYNC_INTERVAL    1000
+#endif
+
+/// @summary Define the number of milliseconds spent at startup measuring the cycle counter frequency recorded in the file header.
+#ifndef PROFILER_NATIVE_CLOCK_ESTIMATE_TIME
+#define PROFILER_NATIVE_CLOCK_ESTIMATE_TIME    2
+#endif
+
+/// @summary Define the maximum number of zone sites that can be registered by the process. Must be less than 65536, since site identifiers are stored in 16 bits.
+#ifndef PROFILER_NATIVE_MAX_ZONE_SITES
+#define PROFILER_NATIVE_MAX_ZONE_SITES         4096
+#endif
+
+/// @summary Define to 1 to replace malloc, calloc, realloc, free, the aligned allocation functions of the C library and the delete operators
+/// with versions that count the allocations and frees of the calling thread, so that PROFILER_CONFIG::TaskAllocations can charge them to
+/// tasks. The replacements call the glibc allocator through its __libc_ entry points, so they are only available with glibc. operator new
+/// is counted through malloc. build-profiler.sh enables the hooks; without them, InitializeProfiler rejects TaskAllocations.
+#ifndef PROFILER_NATIVE_ALLOC_HOOKS
+#define PROFILER_NATIVE_ALLOC_HOOKS            0
+#endif
+
+#if PROFILER_NATIVE_ALLOC_HOOKS && !defined(__GLIBC__)
+    #undef  PROFILER_NATIVE_ALLOC_HOOKS
+    #define PROFILER_NATIVE_ALLOC_HOOKS        0
+#endif
+
+/// @summary Tag used to mark a thread-local variable accessed by the allocation hooks. The initial-exec model resolves the variable with a
+/// fixed offset from the thread pointer rather than a call to __tls_get_addr, which requires the library to be loaded at process startup.
+#ifndef PROFILER_NATIVE_INITIAL_EXEC
+    #if defined(__GNUC__)
+        #define PROFILER_NATIVE_INITIAL_EXEC   __attribute__((tls_model("initial-exec")))
+    #else
+        #define PROFILER_NATIVE_INITIAL_EXEC
+    #endif
+#endif
+
+/// @summary Define the path of the trace file written when the application does not specify one.
+#ifndef PROFILER_NATIVE_DEFAULT_TRACE_PATH
+#define PROFILER_NATIVE_DEFAULT_TRACE_PATH     "profiler.ptrace"
+#endif
+
+/*//////////////////
+//   Data Types   //
+//////////////////*/
+/// @summary Define the record types written to per-thread buffers. Values match the event values in the instrumentation manifest.
+enum PROFILER_RECORD_TYPE : uint16_t
+{
+    PROFILER_RECORD_TYPE_PADDING           = 0,   /// Unused space at the end of the buffer, skipped so that multi-record events are contiguous.
+    PROFILER_RECORD_TYPE_DEFINE_TASK       = 103, /// A DefineTaskEvent. Arg0 is the parent ID, Arg1 the source index and Arg2 the entry point.
+    PROFILER_RECORD_TYPE_TASK_READY_TO_RUN = 104, /// A TaskReadyToRunEvent. Arg0 is the source index.
+    PROFILER_RECORD_TYPE_TASK_LAUNCH       = 105, /// A TaskLaunchEvent. The worker thread is the thread that owns the buffer.
+    PROFILER_RECORD_TYPE_TASK_FINISH       = 106, /// A TaskFinishEvent. The worker thread is the thread that owns the buffer. Data16 is the number of counter and allocation records that follow.
+    PROFILER_RECORD_TYPE_ZONE_BEGIN        = 108, /// A ZoneBeginEvent. Data16 is the site identifier; only Timestamp, EventType and Data16 are written.
+    PROFILER_RECORD_TYPE_ZONE_END          = 109, /// A ZoneEndEvent. Data16 is the site identifier; only Timestamp, EventType and Data16 are written.
+    PROFILER_RECORD_TYPE_DEPENDENCIES      = 200, /// Continuation of the preceding DefineTaskEvent holding part of its encoded dependency list. See PROFILER_DEPENDENCY_RECORD.
+    PROFILER_RECORD_TYPE_TASK_COUNTERS     = 201, /// Continuation of the preceding TaskFinishEvent holding the hardware counter deltas of the task. See PROFILER_COUNTER_RECORD.
+    PROFILER_RECORD_TYPE_TASK_ALLOCS       = 202, /// Continuation of the preceding TaskFinishEvent holding the heap allocations and frees made by the task. See PROFILER_ALLOC_RECORD.
+};
+
+/// @summary Define the fixed-size record written to a per-thread buffer for each event. Records are 32 bytes.
+struct PROFILER_EVENT_RECORD
+{
+    uint64_t                    Timestamp;        /// The timestamp value at which the event occurred, in ticks.
+    uint16_t                    EventType;        /// One of PROFILER_RECORD_TYPE.
+    uint16_t                    Data16;           /// A small event-specific value. For PROFILER_RECORD_TYPE_DEFINE_TASK, the number of dependency records that follow.
+    uint32_t                    TaskId;           /// The task identifier.
+    uint32_t                    Arg0;             /// An event-specific argument.
+    uint32_t                    Arg1;             /// An event-specific argument.
+    uint64_t                    Arg2;             /// An event-specific argument.
+};
+
+/// @summary Define the layout of a PROFILER_RECORD_TYPE_DEPENDENCIES record. The dependency list of a definition is encoded as
+/// the dependency count followed by the zigzag-encoded difference between the task ID and each dependency, all as varints, and
+/// the byte stream is split across as many records as needed. EventType is at the same offset as in PROFILER_EVENT_RECORD.
+struct PROFILER_DEPENDENCY_RECORD
+{
+    uint8_t                     Data0[8];         /// The first bytes of encoded dependency data in the record.
+    uint16_t                    EventType;        /// PROFILER_RECORD_TYPE_DEPENDENCIES.
+    uint16_t                    DataSize;         /// The number of bytes of encoded dependency data in the record.
+    uint8_t                     Data1[20];        /// The remaining bytes of encoded dependency data in the record.
+};
+
+/// @summary Define the layout of a PROFILER_RECORD_TYPE_TASK_COUNTERS record. Each value is the change in a counter between the launch
+/// and the finish of the task. Miss counts are clamped to 32 bits. EventType is at the same offset as in PROFILER_EVENT_RECORD.
+struct PROFILER_COUNTER_RECORD
+{
+    uint64_t                    Cycles;           /// The PLATFORM_COUNTER_CYCLES delta.
+    uint16_t                    EventType;        /// PROFILER_RECORD_TYPE_TASK_COUNTERS.
+    uint16_t                    CounterMask;      /// The PLATFORM_COUNTER_GROUP::CounterMask of the thread. Deltas of counters not in the mask are 0.
+    uint32_t                    L1DMisses;        /// The PLATFORM_COUNTER_L1D_MISSES delta.
+    uint64_t                    Instructions;     /// The PLATFORM_COUNTER_INSTRUCTIONS delta.
+    uint32_t                    LLCMisses;        /// The PLATFORM_COUNTER_LLC_MISSES delta.
+    uint32_t                    BranchMisses;     /// The PLATFORM_COUNTER_BRANCH_MISSES delta.
+};
+
+/// @summary Define the layout of a PROFILER_RECORD_TYPE_TASK_ALLOCS record. EventType is at the same offset as in PROFILER_EVENT_RECORD.
+struct PROFILER_ALLOC_RECORD
+{
+    uint64_t                    AllocBytes;       /// The number of bytes requested by the allocations made between the launch and the finish of the task.
+    uint16_t                    EventType;        /// PROFILER_RECORD_TYPE_TASK_ALLOCS.
+    uint16_t                    Reserved0;        /// Unused. Set to zero.
+    uint32_t                    Reserved1;        /// Unused. Set to zero.
+    uint64_t                    AllocCount;       /// The number of allocations made between the launch and the finish of the task.
+    uint64_t                    FreeBytes;        /// The usable size, in bytes, of the blocks freed between the launch and the finish of the task.
+};
+
+/// @summary Define the running totals of the heap allocations and frees made by a thread, maintained by the allocation hooks.
+struct PROFILER_ALLOC_TOTALS
+{
+    uint64_t                    Count;            /// The number of allocations made by the thread.
+    uint64_t                    Bytes;            /// The number of bytes requested by those allocations.
+    uint64_t                    FreeBytes;        /// The usable size, in bytes, of the blocks freed by the thread.
+};
+
+/// @summary Define the state associated with a single-producer, single-consumer event buffer.
+/// The producer fields, consumer fields and immutable fields are each placed on separate cache lines.
+struct PROFILER_THREAD_BUFFER
+{
+    std::atomic<uint64_t>       WritePos;         /// The number of records ever published by the producer. Written only by the owning thread.
+    uint64_t                    CachedReadPos;    /// The producer's most recently observed value of ReadPos.
+    std::atomic<uint64_t>       DropCount;        /// The number of records dropped because the buffer was full. Written only by the owning thread.
+    uint32_t                    CounterTask;      /// The task launched when CounterStart was read, or INVALID_TASK_ID. Used only by the owning thread.
+    uint64_t                    CounterStart[PLATFORM_COUNTER_GROUP_SIZE]; /// The hardware counters read when CounterTask was launched. Used only by the owning thread.
+    uint32_t                    AllocTask;        /// The task launched when AllocStart was read, or INVALID_TASK_ID. Used only by the owning thread.
+    PROFILER_ALLOC_TOTALS       AllocStart;       /// The allocation totals of the thread when AllocTask was launched. Used only by the owning thread.
+    uint8_t                     Pad0[PLATFORM_CACHELINE_SIZE];
+    std::atomic<uint64_t>       ReadPos;          /// The number of records ever consumed by the flush thread. Written only by the flush thread.
+    uint64_t                    DropsWritten;     /// The value of DropCount most recently reported by the flush thread.
+    uint64_t                    LastTime;         /// The timestamp of the most recent event written by the flush thread.
+    uint8_t                     Pad1[PLATFORM_CACHELINE_SIZE];
+    PROFILER_EVENT_RECORD      *Records;          /// Storage for Capacity records.
+    uint64_t                    Capacity;         /// The maximum number of records in the buffer. Always a power of two.
+    uint64_t                    Mask;             /// The value Capacity-1, used to map a position to a record index.
+    uint32_t                    ThreadId;         /// The operating system identifier of the thread that writes to the buffer.
+    bool                        Bound;            /// true if the buffer has been attached to a running thread.
+    PLATFORM_COUNTER_GROUP      Counters;         /// The hardware counters of the thread. Used only by the owning thread once the buffer is bound.
+    PLATFORM_COUNTER_GROUP      PendingCounters;  /// Counters opened by RegisterWorkerThread after the buffer was bound, adopted by the owning thread when CountersPending is set.
+    std::atomic<uint32_t>       CountersPending;  /// Set to non-zero once PendingCounters is ready, and cleared by the owning thread when it adopts them.
+    bool                        CountersOpened;   /// true once RegisterWorkerThread has opened counters for the thread. Guarded by the state lock.
+};
+
+/// @summary Define the global state of the native profiler backend.
+struct PROFILER_NATIVE_STATE
+{
+    std::atomic<uint32_t>       SessionId;        /// Non-zero while the profiler is running. Changes with each InitializeProfiler call.
+    uint32_t                    NextSessionId;    /// The value used for SessionId on the next call to InitializeProfiler.
+    bool                        LockReady;        /// true once Lock has been initialized.
+    std::atomic<uint32_t>       StopFlush;        /// Set to non-zero to request that the flush thread exit.
+    PLATFORM_MUTEX              Lock;             /// Guards registration data and the buffer list. Never acquired on the hot path.
+    PLATFORM_THREAD             FlushThread;      /// The background thread that drains the per-thread buffers.
+    FILE                       *TraceFile;        /// The output file, written only by the flush thread after initialization.
+    PTRACE_FILE_HEADER          Header;           /// The file header, rewritten at shutdown with the measured clock frequency.
+    bool                        UseCycleCounter;  /// true if event timestamps are read from the invariant processor cycle counter.
+    uint32_t                    TaskSampleRate;   /// Events are recorded for 1 in TaskSampleRate tasks. See TaskSampled.
+    bool                        TaskCounters;     /// true if RegisterWorkerThread opens hardware counters for each worker thread.
+    bool                        TaskAllocations;  /// true if the allocations made by each task are recorded. Requires PROFILER_NATIVE_ALLOC_HOOKS.
+    PTRACE_CLOCK_SYNC           FirstClockSync;   /// The first clock calibration sample of the session.
+    PTRACE_CLOCK_SYNC           LastClockSync;    /// The most recent clock calibration sample of the session.
+    std::vector<PTRACE_CLOCK_SYNC> ClockSync;     /// Clock calibration samples not yet written by the flush thread.
+    uint64_t                    BufferCapacity;   /// The number of records in each per-thread buffer.
+    std::atomic<uint32_t>       BufferCount;      /// The number of valid entries in the Buffers array.
+    PROFILER_THREAD_BUFFER     *Buffers[PROFILER_NATIVE_MAX_THREADS];
+    std::vector<PTRACE_WORKER_INFO> Workers;      /// Worker registrations not yet written by the flush thread.
+    std::vector<PTRACE_SOURCE_INFO> Sources;      /// Task source registrations not yet written by the flush thread.
+    std::vector<char*>          SourceNames;      /// The copied name of each entry in Sources.
+    std::vector<uint8_t>        BlockData;        /// Scratch space used by the flush thread to encode event blocks.
+    std::vector<uint8_t>        DependencyData;   /// Scratch space used by the flush thread to gather the encoded dependencies of a definition.
+    std::vector<uint32_t>       Dependencies;     /// Scratch space used by the flush thread to decode the dependencies of a definition.
+    std::vector<uint8_t>        ZoneData;         /// Scratch space used by the flush thread to encode zone blocks.
+    uint32_t                    ZoneSitesWritten; /// The largest zone site identifier written to the trace file in this session.
+    std::vector<uint8_t>        CounterData;      /// Scratch space used by the flush thread to encode task counter blocks.
+    std::vector<uint8_t>        AllocData;        /// Scratch space used by the flush thread to encode task allocation blocks.
+};
+
+/*///////////////
+//   Globals   //
+///////////////*/
+/// @summary The global state of the native profiler backend. SessionId is zero until InitializeProfiler is called.
+global_variable PROFILER_NATIVE_STATE    ProfilerNative;
+
+/// @summary The number of zone site identifiers handed out by RegisterZoneSite. Kept outside of ProfilerNative, like ProfilerZoneSites,
+/// because sites register on first use, which may be before InitializeProfiler, and keep their identifiers across sessions.
+global_variable std::atomic<uint32_t>    ProfilerZoneSiteCount;
+
+/// @summary The registered zone sites, indexed by site identifier. An entry is NULL until RegisterZoneSite has published it.
+global_variable std::atomic<PROFILER_ZONE_SITE const*> ProfilerZoneSites[PROFILER_NATIVE_MAX_ZONE_SITES + 1];
+
+/// @summary The buffer attached to the calling thread, or NULL.
+thread_local_variable PROFILER_THREAD_BUFFER *ProfilerThreadBuffer = NULL;
+
+/// @summary The PROFILER_NATIVE_STATE::SessionId value at the time ProfilerThreadBuffer was attached.
+thread_local_variable uint32_t ProfilerThreadSession = 0;
+
+/// @summary The allocation totals of the calling thread. Updated by the allocation hooks whether or not the profiler is running.
+thread_local_variable PROFILER_ALLOC_TOTALS ProfilerThreadAllocs PROFILER_NATIVE_INITIAL_EXEC;
+
+/*//////////////////////////
+//   Internal Functions   //
+//////////////////////////*/
+/// @summary Round a value up to the next power of two.
+/// @param n The input value.
+/// @return The smallest power of two greater than or equal to n.
+internal_function uint64_t
+NextPow2GreaterOrEqual
+(
+    uint64_t n
+)
+{
+    uint64_t x = 1;
+    while (x < n) x <<= 1;
+    return x;
+}
+
+/// @summary Read the timestamp of an event. This is the invariant cycle counter when available, as it is several times cheaper to read than the system timer.
+/// @return The current timestamp, in ticks of PROFILER_NATIVE_STATE::Header.ClockFrequency.
+internal_function inline uint64_t
+ProfilerTimestamp
+(
+    void
+)
+{
+    return ProfilerNative.UseCycleCounter ? PlatformCycleCounter() : PlatformTimestamp();
+}
+
+/// @summary Take a clock calibration sample. The reference clock is read between two reads of the cycle counter, and paired with their midpoint.
+/// @param sync On return, the cycle counter and the reference clock at the same instant.
+internal_function void
+SampleClockSync
+(
+    PTRACE_CLOCK_SYNC *sync
+)
+{
+    uint64_t const before = PlatformCycleCounter();
+    sync->ReferenceTime   = PlatformMonotonicNanoseconds();
+    uint64_t const after  = PlatformCycleCounter();
+    sync->Timestamp       = before + ((after - before) / 2);
+}
+
+/// @summary Compute the cycle counter frequency from two calibration samples.
+/// @param first The earlier sample.
+/// @param last The later sample.
+/// @return The number of cycle counter ticks per second, or zero if the samples are too close together.
+internal_function uint64_t
+ClockSyncFrequency
+(
+    PTRACE_CLOCK_SYNC const &first,
+    PTRACE_CLOCK_SYNC const  &last
+)
+{
+    if (last.ReferenceTime <= first.ReferenceTime || last.Timestamp <= first.Timestamp)
+        return 0;
+    return uint64_t((double(last.Timestamp - first.Timestamp) * 1000000000.0) / double(last.ReferenceTime - first.ReferenceTime) + 0.5);
+}
+
+/// @summary Allocate and initialize a new per-thread event buffer.
+/// @param thread_id The operating system identifier of the thread that will write to the buffer.
+/// @param capacity The number of records in the buffer. Must be a power of two.
+/// @return The new buffer, or NULL.
+internal_function PROFILER_THREAD_BUFFER*
+NewThreadBuffer
+(
+    uint32_t thread_id,
+    uint64_t  capacity
+)
+{
+    PROFILER_THREAD_BUFFER *buf = new PROFILER_THREAD_BUFFER();
+    if ((buf->Records = (PROFILER_EVENT_RECORD*) malloc(size_t(capacity) * sizeof(PROFILER_EVENT_RECORD))) == NULL)
+    {   // insufficient memory for the record storage.
+        delete buf;
+        return NULL;
+    }
+    buf->WritePos.store(0, std::memory_order_relaxed);
+    buf->CachedReadPos = 0;
+    buf->DropCount.store(0, std::memory_order_relaxed);
+    buf->ReadPos.store(0, std::memory_order_relaxed);
+    buf->DropsWritten  = 0;
+    buf->LastTime      = 0;
+    buf->Capacity      = capacity;
+    buf->Mask          = capacity - 1;
+    buf->ThreadId      = thread_id;
+    buf->Bound         = false;
+    buf->CounterTask   = INVALID_TASK_ID;
+    buf->Counters.CounterMask = 0;
+    buf->PendingCounters.CounterMask = 0;
+    buf->CountersPending.store(0, std::memory_order_relaxed);
+    buf->CountersOpened = false;
+    buf->AllocTask     = INVALID_TASK_ID;
+    return buf;
+}
+
+/// @summary Free the resources associated with a per-thread event buffer.
+/// @param buf The buffer to delete.
+internal_function void
+DeleteThreadBuffer
+(
+    PROFILER_THREAD_BUFFER *buf
+)
+{
+    if (buf != NULL)
+    {
+        PlatformCloseCounterGroup(&buf->Counters);
+        PlatformCloseCounterGroup(&buf->PendingCounters);
+        free(buf->Records);
+        delete buf;
+    }
+}
+
+/// @summary Search the buffer list for the buffer of a given thread, bound or not, or allocate a new buffer. The caller must hold the state lock.
+/// A thread has at most one buffer per session, so a worker that registers after it has written events keeps the buffer it already uses.
+/// @param state The native profiler state.
+/// @param thread_id The operating system identifier of the thread.
+/// @return The buffer, or NULL if the buffer limit was reached or memory could not be allocated.
+internal_function PROFILER_THREAD_BUFFER*
+FindOrCreateThreadBuffer
+(
+    PROFILER_NATIVE_STATE *state,
+    uint32_t           thread_id
+)
+{
+    uint32_t count = state->BufferCount.load(std::memory_order_relaxed);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (state->Buffers[i]->ThreadId == thread_id)
+            return state->Buffers[i];
+    }
+    if (count == PROFILER_NATIVE_MAX_THREADS)
+    {   // no more buffers can be allocated in this session.
+        return NULL;
+    }
+    PROFILER_THREAD_BUFFER *buf = NewThreadBuffer(thread_id, state->BufferCapacity);
+    if (buf != NULL)
+    {   // publish the buffer to the flush thread.
+        state->Buffers[count] = buf;
+        state->BufferCount.store(count + 1, std::memory_order_release);
+    }
+    return buf;
+}
+
+/// @summary Attach a buffer to the calling thread. This is the slow path, executed once per thread per session.
+/// @return The buffer attached to the calling thread, or NULL if the profiler is not running or no buffer is available.
+internal_function PROFILER_THREAD_BUFFER*
+AttachThreadBuffer
+(
+    void
+)
+{
+    PROFILER_NATIVE_STATE *state = &ProfilerNative;
+    PROFILER_THREAD_BUFFER  *buf = NULL;
+    uint32_t             session = state->SessionId.load(std::memory_order_acquire);
+    if (session != 0)
+    {   // the profiler is running; find the buffer pre-allocated by RegisterWorkerThread, or create one.
+        PlatformMutexLock(&state->Lock);
+        if ((buf = FindOrCreateThreadBuffer(state, PlatformThreadId())) != NULL)
+        {   // the buffer is now owned by this thread until the session ends. if the thread identifier was reused, the
+            // buffer of the exited thread is taken over, which is safe because that thread no longer writes to it.
+            buf->Bound = true;
+        }
+        PlatformMutexUnlock(&state->Lock);
+    }
+    // a failed attach is also remembered so it isn't retried on every event.
+    ProfilerThreadBuffer  = buf;
+    ProfilerThreadSession = session;
+    return buf;
+}
+
+/// @summary Retrieve the buffer attached to the calling thread, attaching one if necessary.
+/// @return The buffer attached to the calling thread, or NULL if the profiler is not running.
+internal_function inline PROFILER_THREAD_BUFFER*
+GetThreadBuffer
+(
+    void
+)
+{
+    if (ProfilerThreadSession == ProfilerNative.SessionId.load(std::memory_order_relaxed))
+        return ProfilerThreadBuffer;
+    return AttachThreadBuffer();
+}
+
+/// @summary Reserve space for one or more contiguous records in the calling thread's buffer. Records are not visible to the flush thread until PublishRecords is called.
+/// @param buf The buffer attached to the calling thread.
+/// @param count The number of records to reserve.
+/// @return A pointer to the first reserved record, or NULL if the buffer is full, in which case the records are counted as dropped.
+internal_function inline PROFILER_EVENT_RECORD*
+ReserveRecords
+(
+    PROFILER_THREAD_BUFFER *buf,
+    uint32_t              count
+)
+{
+    uint64_t const  pos = buf->WritePos.load(std::memory_order_relaxed);
+    uint64_t const  ofs = pos & buf->Mask;
+    uint64_t const skip = (ofs + count) > buf->Capacity ? (buf->Capacity - ofs) : 0;
+    uint64_t const  end = pos + skip + count;
+    if ((end - buf->CachedReadPos) > buf->Capacity)
+    {   // the buffer appears full; refresh the consumer position and check again.
+        buf->CachedReadPos = buf->ReadPos.load(std::memory_order_acquire);
+        if ((end - buf->CachedReadPos) > buf->Capacity)
+        {   // the buffer really is full. never block the producer.
+            buf->DropCount.store(buf->DropCount.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+            return NULL;
+        }
+    }
+    if (skip > 0)
+    {   // multi-record events never wrap; pad out the end of the storage.
+        for (uint64_t i = 0; i < skip; ++i)
+        {
+            buf->Records[ofs + i].EventType = PROFILER_RECORD_TYPE_PADDING;
+        }
+        buf->WritePos.store(pos + skip, std::memory_order_release);
+    }
+    return &buf->Records[(pos + skip) & buf->Mask];
+}
+
+/// @summary Make records previously returned by ReserveRecords visible to the flush thread.
+/// @param buf The buffer attached to the calling thread.
+/// @param count The number of records to publish.
+internal_function inline void
+PublishRecords
+(
+    PROFILER_THREAD_BUFFER *buf,
+    uint32_t              count
+)
+{
+    buf->WritePos.store(buf->WritePos.load(std::memory_order_relaxed) + count, std::memory_order_release);
+}
+
+/// @summary Determine the number of bytes needed to encode a dependency list.
+/// @param task_id The identifier of the task that has the dependencies.
+/// @param dependencies The dependency task identifiers.
+/// @param dependency_count The number of dependencies.
+/// @return The number of bytes of encoded dependency data, including the dependency count.
+internal_function size_t
+DependencyDataSize
+(
+    uint32_t             task_id,
+    uint32_t const *dependencies,
+    uint32_t    dependency_count
+)
+{
+    uint8_t  var[16];
+    size_t size = size_t(PtraceEncodeVarU64(var, dependency_count) - var);
+    for (uint32_t i = 0; i < dependency_count; ++i)
+    {
+        size += size_t(PtraceEncodeVarU64(var, ZigZagEncode32(int32_t(task_id - dependencies[i]))) - var);
+    }
+    return size;
+}
+
+/// @summary Append encoded bytes to a sequence of dependency records, writing each record once it is full.
+/// @param cur The record being filled.
+/// @param dst The next record to write, advanced as records are written.
+/// @param src The bytes to append.
+/// @param count The number of bytes to append.
+internal_function void
+AppendDependencyData
+(
+    PROFILER_DEPENDENCY_RECORD &cur,
+    PROFILER_EVENT_RECORD     *&dst,
+    uint8_t const             *src,
+    size_t                   count
+)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (cur.DataSize < sizeof(cur.Data0)) cur.Data0[cur.DataSize] = src[i];
+        else cur.Data1[cur.DataSize - sizeof(cur.Data0)] = src[i];
+        if (++cur.DataSize == sizeof(cur.Data0) + sizeof(cur.Data1))
+        {   // the record is full; records are plain data, so copy it into place.
+            memcpy(dst++, &cur, sizeof(cur));
+            cur.DataSize = 0;
+        }
+    }
+}
+
+/// @summary Write a single fixed-size record to the calling thread's buffer.
+/// @param type One of PROFILER_RECORD_TYPE.
+/// @param task_id The task identifier.
+/// @param arg0 The first event-specific argument.
+/// @param arg1 The second event-specific argument.
+/// @param arg2 The third event-specific argument.
+internal_function inline void
+WriteRecord
+(
+    uint16_t    type,
+    uint32_t task_id,
+    uint32_t    arg0,
+    uint32_t    arg1,
+    uint64_t    arg2
+)
+{
+    if (!TaskSampled(task_id, ProfilerNative.TaskSampleRate))
+        return;
+    PROFILER_THREAD_BUFFER *buf = GetThreadBuffer();
+    PROFILER_EVENT_RECORD  *rec = NULL;
+    if (buf != NULL && (rec = ReserveRecords(buf, 1)) != NULL)
+    {
+        rec->Timestamp = ProfilerTimestamp();
+        rec->EventType = type;
+        rec->Data16    = 0;
+        rec->TaskId    = task_id;
+        rec->Arg0      = arg0;
+        rec->Arg1      = arg1;
+        rec->Arg2      = arg2;
+        PublishRecords(buf, 1);
+    }
+}
+
+/// @summary Write a zone record to the calling thread's buffer. This is the whole cost of a zone boundary, so it writes only the timestamp and site.
+/// @param type PROFILER_RECORD_TYPE_ZONE_BEGIN or PROFILER_RECORD_TYPE_ZONE_END.
+/// @param site_id The site identifier returned by RegisterZoneSite.
+internal_function inline void
+WriteZoneRecord
+(
+    uint16_t    type,
+    uint32_t site_id
+)
+{
+    if (site_id == INVALID_ZONE_SITE)
+        return;
+    PROFILER_THREAD_BUFFER *buf = GetThreadBuffer();
+    PROFILER_EVENT_RECORD  *rec = NULL;
+    if (buf != NULL && (rec = ReserveRecords(buf, 1)) != NULL)
+    {
+        rec->Timestamp = ProfilerTimestamp();
+        rec->EventType = type;
+        rec->Data16    = uint16_t(site_id);
+        PublishRecords(buf, 1);
+    }
+}
+
+/// @summary Clamp a counter delta to the 32 bits stored for miss counts in a PROFILER_COUNTER_RECORD.
+/// @param value The counter delta.
+/// @return The value, or 0xFFFFFFFF if the value doesn't fit in 32 bits.
+internal_function inline uint32_t
+SaturateCount32
+(
+    uint64_t value
+)
+{
+    return value > 0xFFFFFFFFULL ? 0xFFFFFFFFU : uint32_t(value);
+}
+
+/// @summary Write a block header and its data to the trace file.
+/// @param fp The trace file.
+/// @param type One of PTRACE_BLOCK_TYPE.
+/// @param thread_id The operating system identifier of the thread that produced the data.
+/// @param count The number of items in the block.
+/// @param dropped The number of events dropped by the thread since its previous block.
+/// @param first_time The timestamp of the first item in the block, in ticks.
+/// @param last_time The timestamp of the last item in the block, in ticks.
+/// @param data The block data, or NULL if the caller writes the data_size bytes of data itself.
+/// @param data_size The number of bytes of block data.
+internal_function void
+WriteTraceBlock
+(
+    FILE          *fp,
+    uint32_t      type,
+    uint32_t thread_id,
+    uint32_t     count,
+    uint32_t   dropped,
+    uint64_t first_time,
+    uint64_t  last_time,
+    void const   *data,
+    size_t   data_size
+)
+{
+    PTRACE_BLOCK_HEADER hdr;
+    hdr.Magic        = PTRACE_BLOCK_MAGIC;
+    hdr.BlockType    = type;
+    hdr.ThreadId     = thread_id;
+    hdr.EventCount   = count;
+    hdr.DataSize     = uint32_t(data_size);
+    hdr.DroppedCount = dropped;
+    hdr.FirstTime    = first_time;
+    hdr.LastTime     = last_time;
+    fwrite(&hdr, sizeof(hdr), 1, fp);
+    if (data != NULL && data_size > 0) fwrite(data, 1, data_size, fp);
+}
+
+/// @summary Write any pending worker and task source registrations to the trace file. Called on the flush thread.
+/// @param state The native profiler state.
+internal_function void
+FlushRegistrations
+(
+    PROFILER_NATIVE_STATE *state
+)
+{
+    PlatformMutexLock(&state->Lock);
+    for (size_t i = 0, n = state->Workers.size(); i < n; ++i)
+    {
+        PTRACE_WORKER_INFO const &w = state->Workers[i];
+        WriteTraceBlock(state->TraceFile, PTRACE_BLOCK_TYPE_WORKER, w.ThreadId, 1, 0, w.Timestamp, w.Timestamp, &w, sizeof(w));
+    }
+    for (size_t i = 0, n = state->Sources.size(); i < n; ++i)
+    {
+        PTRACE_SOURCE_INFO const &src = state->Sources[i];
+        WriteTraceBlock(state->TraceFile, PTRACE_BLOCK_TYPE_TASK_SOURCE, src.ThreadId, 1, 0, src.Timestamp, src.Timestamp, NULL, sizeof(src) + src.NameLength);
+        fwrite(&src, sizeof(src), 1, state->TraceFile);
+        fwrite(state->SourceNames[i], 1, src.NameLength, state->TraceFile);
+        free(state->SourceNames[i]);
+    }
+    state->Workers.clear();
+    state->Sources.clear();
+    state->SourceNames.clear();
+    PlatformMutexUnlock(&state->Lock);
+}
+
+/// @summary Write any zone sites registered since the last call to the trace file. Called on the flush thread.
+/// @param state The native profiler state.
+internal_function void
+FlushZoneSites
+(
+    PROFILER_NATIVE_STATE *state
+)
+{
+    uint32_t count = ProfilerZoneSiteCount.load(std::memory_order_acquire);
+    if (count > PROFILER_NATIVE_MAX_ZONE_SITES)
+        count = PROFILER_NATIVE_MAX_ZONE_SITES;
+    while (state->ZoneSitesWritten < count)
+    {
+        uint32_t const                id = state->ZoneSitesWritten + 1;
+        PROFILER_ZONE_SITE const   *site = ProfilerZoneSites[id].load(std::memory_order_acquire);
+        PTRACE_ZONE_SITE_INFO       info;
+        if (site == NULL)
+        {   // the identifier was handed out but not yet published; pick it up on the next pass.
+            break;
+        }
+        info.SiteId         = id;
+        info.Line           = site->Line;
+        info.NameLength     = site->Name     != NULL ? uint32_t(strlen(site->Name    )) : 0;
+        info.FileLength     = site->File     != NULL ? uint32_t(strlen(site->File    )) : 0;
+        info.FunctionLength = site->Function != NULL ? uint32_t(strlen(site->Function)) : 0;
+        info.Reserved       = 0;
+        WriteTraceBlock(state->TraceFile, PTRACE_BLOCK_TYPE_ZONE_SITE, 0, 1, 0, 0, 0, NULL, sizeof(info) + info.NameLength + info.FileLength + info.FunctionLength);
+        fwrite(&info, sizeof(info), 1, state->TraceFile);
+        fwrite(site->Name    , 1, info.NameLength    , state->TraceFile);
+        fwrite(site->File    , 1, info.FileLength    , state->TraceFile);
+        fwrite(site->Function, 1, info.FunctionLength, state->TraceFile);
+        state->ZoneSitesWritten = id;
+    }
+}
+
+/// @summary Decode the dependency list stored in the dependency records following a definition. Called on the flush thread.
+/// @param state The native profiler state. On return, the Dependencies field holds the decoded dependencies.
+/// @param records The first dependency record.
+/// @param record_count The number of dependency records.
+/// @param task_id The identifier of the task that has the dependencies.
+/// @return The number of dependencies decoded.
+internal_function uint32_t
+ReadDependencyRecords
+(
+    PROFILER_NATIVE_STATE       *state,
+    PROFILER_EVENT_RECORD const *records,
+    uint32_t                record_count,
+    uint32_t                     task_id
+)
+{
+    PROFILER_DEPENDENCY_RECORD r;
+    uint64_t                   value = 0;
+    state->DependencyData.clear();
+    state->Dependencies.clear();
+    for (uint32_t i = 0; i < record_count; ++i)
+    {   // gather the encoded bytes into a single contiguous stream.
+        memcpy(&r, &records[i], sizeof(r));
+        size_t const n0 = r.DataSize < sizeof(r.Data0) ? r.DataSize : sizeof(r.Data0);
+        state->DependencyData.insert(state->DependencyData.end(), r.Data0, r.Data0 + n0);
+        state->DependencyData.insert(state->DependencyData.end(), r.Data1, r.Data1 + (r.DataSize - n0));
+    }
+    uint8_t const *src = state->DependencyData.empty() ? NULL : &state->DependencyData[0];
+    uint8_t const *end = src + state->DependencyData.size();
+    if (src == NULL || (src = PtraceDecodeVarU64(src, end, value)) == NULL)
+        return 0;
+    for (uint64_t i = 0, n = value; i < n; ++i)
+    {   // the records were written by this process, so they are well-formed.
+        if ((src = PtraceDecodeVarU64(src, end, value)) == NULL) break;
+        state->Dependencies.push_back(task_id - uint32_t(ZigZagDecode32(uint32_t(value))));
+    }
+    return uint32_t(state->Dependencies.size());
+}
+
+/// @summary Drain all records currently published in a per-thread buffer to the trace file as a single compact event block, followed by a
+/// compact zone block if the thread recorded any zones, and compact task counter and allocation blocks if it recorded any. Called on the flush thread.
+/// @param state The native profiler state.
+/// @param buf The buffer to drain.
+internal_function void
+FlushThreadBuffer
+(
+    PROFILER_NATIVE_STATE *state,
+    PROFILER_THREAD_BUFFER  *buf
+)
+{
+    uint64_t const read_pos  = buf->ReadPos.load(std::memory_order_relaxed);
+    uint64_t const write_pos = buf->WritePos.load(std::memory_order_acquire);
+    uint64_t const drops     = buf->DropCount.load(std::memory_order_relaxed);
+    if (write_pos == read_pos && drops == buf->DropsWritten)
+    {   // nothing has been written since the last flush.
+        return;
+    }
+
+    // every record expands to at most one maximum-size event; each dependency
+    // record holds at most sizeof(PROFILER_DEPENDENCY_RECORD) encoded bytes,
+    // which are re-encoded identically, so they account for the dependencies.
+    size_t const max_size = size_t(write_pos - read_pos) * PTRACE_MAX_EVENT_SIZE;
+    size_t const max_zone_size = size_t(write_pos - read_pos) * PTRACE_MAX_ZONE_EVENT_SIZE;
+    size_t const max_counter_size = state->TaskCounters ? size_t((write_pos - read_pos) / 2) * PTRACE_MAX_TASK_COUNTERS_SIZE : 0;
+    size_t const max_alloc_size = state->TaskAllocations ? size_t((write_pos - read_pos) / 2) * PTRACE_MAX_TASK_ALLOCS_SIZE : 0;
+    if (state->BlockData.size() < max_size)
+        state->BlockData.resize(max_size);
+    if (state->ZoneData.size() < max_zone_size)
+        state->ZoneData.resize(max_zone_size);
+    if (state->CounterData.size() < max_counter_size)
+        state->CounterData.resize(max_counter_size);
+    if (state->AllocData.size() < max_alloc_size)
+        state->AllocData.resize(max_alloc_size);
+
+    PTRACE_CODEC_STATE codec;
+    PTRACE_EVENT          ev;
+    memset(&ev, 0, sizeof(ev));
+    uint8_t  *block_start = state->BlockData.empty() ? NULL : &state->BlockData[0];
+    uint8_t          *dst = block_start;
+    uint64_t   first_time = 0;
+    uint64_t    last_time = buf->LastTime;
+    uint32_t  event_count = 0;
+    PTRACE_CODEC_STATE  zone_codec;
+    PTRACE_ZONE_EVENT         zone;
+    uint8_t    *zone_start = state->ZoneData.empty() ? NULL : &state->ZoneData[0];
+    uint8_t      *zone_dst = zone_start;
+    uint64_t     zone_time = 0;
+    uint32_t    zone_count = 0;
+    PTRACE_CODEC_STATE  counter_codec;
+    PTRACE_TASK_COUNTERS      counters;
+    uint8_t *counter_start = state->CounterData.empty() ? NULL : &state->CounterData[0];
+    uint8_t   *counter_dst = counter_start;
+    uint64_t  counter_time = 0;
+    uint32_t counter_count = 0;
+    PTRACE_CODEC_STATE    alloc_codec;
+    PTRACE_TASK_ALLOCS         allocs;
+    uint8_t   *alloc_start = state->AllocData.empty() ? NULL : &state->AllocData[0];
+    uint8_t     *alloc_dst = alloc_start;
+    uint64_t    alloc_time = 0;
+    uint32_t   alloc_count = 0;
+    PtraceResetCodecState(&zone_codec, 0);
+    PtraceResetCodecState(&counter_codec, 0);
+    PtraceResetCodecState(&alloc_codec, 0);
+    for (uint64_t pos = read_pos; pos != write_pos; ++pos)
+    {
+        PROFILER_EVENT_RECORD const &rec = buf->Records[pos & buf->Mask];
+        uint32_t const         *deps = NULL;
+        switch (rec.EventType)
+        {
+            case PROFILER_RECORD_TYPE_ZONE_BEGIN:
+            case PROFILER_RECORD_TYPE_ZONE_END:
+                {   // zones go to their own block, which readers that predate zones skip.
+                    if (zone_count++ == 0)
+                    {
+                        zone_time = rec.Timestamp;
+                        PtraceResetCodecState(&zone_codec, zone_time);
+                    }
+                    zone.Timestamp = rec.Timestamp;
+                    zone.SiteId    = rec.Data16;
+                    zone.IsEnd     = rec.EventType == PROFILER_RECORD_TYPE_ZONE_END ? 1 : 0;
+                    zone_dst       = PtraceEncodeZoneEvent(zone_dst, &zone_codec, &zone);
+                } continue;
+            case PROFILER_RECORD_TYPE_DEFINE_TASK:
+                {   // the dependency records are always published with the definition, and never wrap.
+                    ev.EventType       = PTRACE_EVENT_TYPE_DEFINE_TASK;
+                    ev.ParentId        = rec.Arg0;
+                    ev.SourceIndex     = rec.Arg1;
+                    ev.EntryPoint      = rec.Arg2;
+                    ev.DependencyCount = 0;
+                    if (rec.Data16 > 0)
+                    {
+                        ev.DependencyCount = ReadDependencyRecords(state, &buf->Records[(pos + 1) & buf->Mask], rec.Data16, rec.TaskId);
+                        deps = state->Dependencies.empty() ? NULL : &state->Dependencies[0];
+                        pos += rec.Data16;
+                    }
+                } break;
+            case PROFILER_RECORD_TYPE_TASK_READY_TO_RUN:
+                {
+                    ev.EventType       = PTRACE_EVENT_TYPE_TASK_READY_TO_RUN;
+                    ev.SourceIndex     = rec.Arg0;
+                    ev.DependencyCount = 0;
+                } break;
+            case PROFILER_RECORD_TYPE_TASK_LAUNCH:
+                {
+                    ev.EventType       = PTRACE_EVENT_TYPE_TASK_LAUNCH;
+                    ev.DependencyCount = 0;
+                } break;
+            case PROFILER_RECORD_TYPE_TASK_FINISH:
+                {
+                    ev.EventType       = PTRACE_EVENT_TYPE_TASK_FINISH;
+                    ev.DependencyCount = 0;
+                    for (uint32_t i = 1; i <= rec.Data16; ++i)
+                    {   // continuation records are always published with the finish, and never wrap. each kind goes to its own block.
+                        PROFILER_EVENT_RECORD const &next = buf->Records[(pos + i) & buf->Mask];
+                        if (next.EventType == PROFILER_RECORD_TYPE_TASK_COUNTERS && counter_start != NULL)
+                        {
+                            PROFILER_COUNTER_RECORD c;
+                            memcpy(&c, &next, sizeof(c));
+                            if (counter_count++ == 0)
+                            {
+                                counter_time = rec.Timestamp;
+                                PtraceResetCodecState(&counter_codec, counter_time);
+                            }
+                            counters.Timestamp   = rec.Timestamp;
+                            counters.TaskId      = rec.TaskId;
+                            counters.CounterMask = c.CounterMask;
+                            counters.Values[PTRACE_COUNTER_CYCLES       ] = c.Cycles;
+                            counters.Values[PTRACE_COUNTER_INSTRUCTIONS ] = c.Instructions;
+                            counters.Values[PTRACE_COUNTER_L1D_MISSES   ] = c.L1DMisses;
+                            counters.Values[PTRACE_COUNTER_LLC_MISSES   ] = c.LLCMisses;
+                            counters.Values[PTRACE_COUNTER_BRANCH_MISSES] = c.BranchMisses;
+                            counter_dst = PtraceEncodeTaskCounters(counter_dst, &counter_codec, &counters);
+                        }
+                        if (next.EventType == PROFILER_RECORD_TYPE_TASK_ALLOCS && alloc_start != NULL)
+                        {
+                            PROFILER_ALLOC_RECORD a;
+                            memcpy(&a, &next, sizeof(a));
+                            if (alloc_count++ == 0)
+                            {
+                                alloc_time = rec.Timestamp;
+                                PtraceResetCodecState(&alloc_codec, alloc_time);
+                            }
+                            allocs.Timestamp  = rec.Timestamp;
+                            allocs.TaskId     = rec.TaskId;
+                            allocs.Reserved   = 0;
+                            allocs.AllocCount = a.AllocCount;
+                            allocs.AllocBytes = a.AllocBytes;
+                            allocs.FreeBytes  = a.FreeBytes;
+                            alloc_dst = PtraceEncodeTaskAllocs(alloc_dst, &alloc_codec, &allocs);
+                        }
+                    }
+                    pos += rec.Data16;
+                } break;
+            default:
+                continue; // padding.
+        }
+        if (event_count == 0)
+        {   // the block header stores the time of the first event; deltas start from there.
+            first_time = rec.Timestamp;
+            PtraceResetCodecState(&codec, first_time);
+        }
+        ev.Timestamp = rec.Timestamp;
+        ev.TaskId    = rec.TaskId;
+        dst          = PtraceEncodeEvent(dst, &codec, &ev, deps);
+        last_time    = codec.PrevTime;
+        event_count++;
+    }
+    buf->ReadPos.store(write_pos, std::memory_order_release);
+
+    if (event_count > 0 || drops != buf->DropsWritten)
+    {   // report records lost since the last flush so the loader knows the stream has gaps.
+        if (event_count == 0) first_time = last_time;
+        WriteTraceBlock(state->TraceFile, PTRACE_BLOCK_TYPE_EVENTS, buf->ThreadId, event_count, uint32_t(drops - buf->DropsWritten), first_time, last_time, block_start, size_t(dst - block_start));
+        buf->DropsWritten = drops;
+        buf->LastTime     = last_time;
+    }
+    if (zone_count > 0)
+    {
+        WriteTraceBlock(state->TraceFile, PTRACE_BLOCK_TYPE_ZONES, buf->ThreadId, zone_count, 0, zone_time, zone_codec.PrevTime, zone_start, size_t(zone_dst - zone_start));
+    }
+    if (counter_count > 0)
+    {
+        WriteTraceBlock(state->TraceFile, PTRACE_BLOCK_TYPE_TASK_COUNTERS, buf->ThreadId, counter_count, 0, counter_time, counter_codec.PrevTime, counter_start, size_t(counter_dst - counter_start));
+    }
+    if (alloc_count > 0)
+    {
+        WriteTraceBlock(state->TraceFile, PTRACE_BLOCK_TYPE_TASK_HEAP, buf->ThreadId, alloc_count, 0, alloc_time, alloc_codec.PrevTime, alloc_start, size_t(alloc_dst - alloc_start));
+    }
+}
+
+/// @summary Drain all per-thread buffers to the trace file. Called on the flush thread.
+/// @param state The native profiler state.
+internal_function void
+FlushAllBuffers
+(
+    PROFILER_NATIVE_STATE *state
+)
+{
+    FlushRegistrations(state);
+    FlushZoneSites(state);
+    uint32_t count = state->BufferCount.load(std::memory_order_acquire);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        FlushThreadBuffer(state, state->Buffers[i]);
+    }
+}
+
+/// @summary Take a clock calibration sample if one is due, and write any pending samples to the trace file. Called on the flush thread.
+/// @param state The native profiler state.
+/// @param shutdown true to take a sample regardless of the interval, and to rewrite the file header with the frequency measured over the session.
+internal_function void
+FlushClockSync
+(
+    PROFILER_NATIVE_STATE *state,
+    bool                shutdown
+)
+{
+    if (!state->UseCycleCounter)
+        return;
+    PTRACE_CLOCK_SYNC sync;
+    SampleClockSync(&sync);
+    if (shutdown || sync.ReferenceTime - state->LastClockSync.ReferenceTime >= uint64_t(PROFILER_NATIVE_CLOCK_SYNC_INTERVAL) * 1000000ULL)
+    {
+        state->ClockSync.push_back(sync);
+        state->LastClockSync = sync;
+    }
+    if (!state->ClockSync.empty())
+    {
+        PTRACE_CLOCK_SYNC const &first = state->ClockSync.front();
+        PTRACE_CLOCK_SYNC const &last  = state->ClockSync.back();
+        WriteTraceBlock(state->TraceFile, PTRACE_BLOCK_TYPE_CLOCK_SYNC, 0, uint32_t(state->ClockSync.size()), 0, first.Timestamp, last.Timestamp, &first, state->ClockSync.size() * sizeof(PTRACE_CLOCK_SYNC));
+        state->ClockSync.clear();
+    }
+    uint64_t freq = 0;
+    if (shutdown && (freq = ClockSyncFrequency(state->FirstClockSync, state->LastClockSync)) != 0)
+    {   // readers that predate calibration blocks use the header frequency, so make it as accurate as possible.
+        state->Header.ClockFrequency = freq;
+        fseek(state->TraceFile, 0, SEEK_SET);
+        fwrite(&state->Header, sizeof(state->Header), 1, state->TraceFile);
+        fseek(state->TraceFile, 0, SEEK_END);
+    }
+}
+
+/// @summary Implement the entry point of the background thread that drains per-thread buffers to the trace file.
+/// @param argp A pointer to the PROFILER_NATIVE_STATE.
+internal_function void
+FlushThreadMain
+(
+    void *argp
+)
+{
+    PROFILER_NATIVE_STATE *state = (PROFILER_NATIVE_STATE*) argp;
+    while (state->StopFlush.load(std::memory_order_acquire) == 0)
+    {
+        PlatformSleep(PROFILER_NATIVE_FLUSH_INTERVAL);
+        FlushAllBuffers(state);
+        FlushClockSync(state, false);
+    }
+    // perform a final pass to pick up anything written before shutdown.
+    FlushAllBuffers(state);
+    FlushClockSync(state, true);
+    fflush(state->TraceFile);
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Initialize the profiler and register basic application properties.
+/// @param config An object describing the application to the profiler.
+/// @return One of PROFILER_RESULT specifying whether the profiler was successfully initialized.
+int32_t __cdecl
+InitializeProfiler
+(
+    PROFILER_CONFIG *config
+)
+{
+    if (config == NULL || config->ApplicationName == NULL)
+    {   // the application must identify itself to the profiler.
+        return PROFILER_RESULT_INVALID_APPINFO;
+    }
+    if (config->ProfilerMajorVersion > PROFILER_VERSION_MAJOR || config->ProfilerMajorVersion == 0)
+    {   // the application is requesting a newer profiler version than is supported.
+        return PROFILER_RESULT_INVALID_VERSION;
+    }
+    if (config->ProfilerMinorVersion >= 5 && config->TaskAllocations != 0 && PROFILER_NATIVE_ALLOC_HOOKS == 0)
+    {   // without the hooks there is nothing to charge, and the caller would otherwise get a trace without the allocations it asked for.
+        return PROFILER_RESULT_UNSUPPORTED;
+    }
+    if (ProfilerNative.SessionId.load(std::memory_order_relaxed) != 0)
+    {   // the profiler is already running.
+        return PROFILER_RESULT_SUCCESS;
+    }
+
+    char const *trace_path = PROFILER_NATIVE_DEFAULT_TRACE_PATH;
+    uint64_t      capacity = PROFILER_NATIVE_DEFAULT_BUFFER_SIZE;
+    uint32_t   sample_rate = 1;
+    bool          counters = false;
+    bool            allocs = false;
+    if (config->ProfilerMinorVersion >= 1)
+    {   // the application was built against a header that has the native backend fields.
+        if (config->TraceFilePath   != NULL) trace_path = config->TraceFilePath;
+        if (config->ThreadBufferSize > 0   ) capacity   = NextPow2GreaterOrEqual(config->ThreadBufferSize);
+    }
+    if (config->ProfilerMinorVersion >= 2 && config->TaskSampleRate > 1)
+    {   // the application was built against a header that has the sampling fields.
+        sample_rate = config->TaskSampleRate;
+    }
+    if (config->ProfilerMinorVersion >= 4 && config->TaskCounters != 0)
+    {   // the application was built against a header that has the counter fields.
+        counters = PLATFORM_HAS_PERF_COUNTERS != 0;
+    }
+    if (config->ProfilerMinorVersion >= 5 && config->TaskAllocations != 0)
+    {   // the application was built against a header that has the allocation fields.
+        allocs = true;
+    }
+
+    PROFILER_NATIVE_STATE *state = &ProfilerNative;
+    if (!state->LockReady)
+    {   // the lock persists across sessions, since late callers may still try to attach.
+        PlatformMutexInit(&state->Lock);
+        state->LockReady = true;
+    }
+    if ((state->TraceFile = fopen(trace_path, "wb")) == NULL)
+    {   // there's nowhere to write the events.
+        return PROFILER_RESULT_OUTPUT_ERROR;
+    }
+    state->StopFlush.store(0, std::memory_order_relaxed);
+    state->BufferCapacity = capacity;
+    state->TaskSampleRate = sample_rate;
+    state->TaskCounters   = counters;
+    state->TaskAllocations = allocs;
+    state->ZoneSitesWritten = 0;
+    state->BufferCount.store(0, std::memory_order_relaxed);
+
+    // use the cycle counter if it can be converted to time. the header frequency is estimated over a short
+    // interval here, calibration samples written by the flush thread refine it, and it's rewritten at shutdown.
+    uint64_t freq = PlatformTimestampFrequency();
+    state->UseCycleCounter = PlatformHasInvariantCycleCounter();
+    state->ClockSync.clear();
+    if (state->UseCycleCounter)
+    {
+        PTRACE_CLOCK_SYNC first;
+        PTRACE_CLOCK_SYNC second;
+        SampleClockSync(&first);
+        do
+        {   // spin rather than sleep, so the estimate isn't delayed by the scheduler.
+            SampleClockSync(&second);
+        } while (second.ReferenceTime - first.ReferenceTime < uint64_t(PROFILER_NATIVE_CLOCK_ESTIMATE_TIME) * 1000000ULL);
+        if ((freq = ClockSyncFrequency(first, second)) != 0)
+        {
+            state->FirstClockSync = first;
+            state->LastClockSync  = second;
+            state->ClockSync.push_back(first);
+            state->ClockSync.push_back(second);
+        }
+        else
+        {   // the counter didn't advance; fall back to the system timer.
+            state->UseCycleCounter = false;
+            freq = PlatformTimestampFrequency();
+        }
+    }
+
+    // emit the process registration information, equivalent to RegisterProfiledProcessEvent.
+    PTRACE_FILE_HEADER &hdr = state->Header;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.Magic           = PTRACE_FILE_MAGIC;
+    hdr.VersionMajor    = PTRACE_VERSION_MAJOR;
+    hdr.VersionMinor    = PTRACE_VERSION_MINOR;
+    hdr.HeaderSize      = uint32_t(sizeof(PTRACE_FILE_HEADER));
+    hdr.ProcessId       = PlatformProcessId();
+    hdr.AppMajorVersion = config->ApplicationMajorVersion;
+    hdr.AppMinorVersion = config->ApplicationMinorVersion;
+    hdr.ComputePoolSize = config->ComputePoolSize;
+    hdr.GeneralPoolSize = config->GeneralPoolSize;
+    hdr.ClockFrequency  = freq;
+    hdr.StartTime       = ProfilerTimestamp();
+    hdr.TaskSampleRate  = sample_rate;
+    strncpy(hdr.AppName, config->ApplicationName, sizeof(hdr.AppName) - 1);
+    fwrite(&hdr, sizeof(hdr), 1, state->TraceFile);
+
+    if (!PlatformCreateThread(&state->FlushThread, FlushThreadMain, state))
+    {   // without the flush thread, buffers would fill and all events would be dropped.
+        fclose(state->TraceFile); state->TraceFile = NULL;
+        return PROFILER_RESULT_OUTPUT_ERROR;
+    }
+    // skip zero, which indicates that the profiler is not running.
+    if (state->NextSessionId == 0) state->NextSessionId = 1;
+    state->SessionId.store(state->NextSessionId++, std::memory_order_release);
+    return PROFILER_RESULT_SUCCESS;
+}
+
+/// @summary Shutdown the profiler prior to application shutdown. Threads must not call into the profiler concurrently with this function.
+void __cdecl
+ShutdownProfiler
+(
+    void
+)
+{
+    PROFILER_NATIVE_STATE *state = &ProfilerNative;
+    if (state->SessionId.load(std::memory_order_relaxed) == 0)
+    {   // the profiler is not running.
+        return;
+    }
+    // stop accepting new buffer attachments, then drain everything that's been written.
+    state->SessionId.store(0, std::memory_order_release);
+    state->StopFlush.store(1, std::memory_order_release);
+    PlatformJoinThread(state->FlushThread);
+    fclose(state->TraceFile); state->TraceFile = NULL;
+
+    PlatformMutexLock(&state->Lock);
+    for (uint32_t i = 0, n = state->BufferCount.load(std::memory_order_relaxed); i < n; ++i)
+    {
+        DeleteThreadBuffer(state->Buffers[i]);
+        state->Buffers[i] = NULL;
+    }
+    state->BufferCount.store(0, std::memory_order_relaxed);
+    PlatformMutexUnlock(&state->Lock);
+}
+
+/// @summary Register information about a worker thread with the profiler. The thread's event buffer is allocated here, and if
+/// PROFILER_CONFIG::TaskCounters was set, its hardware counters are opened. Counters that can't be opened are not recorded.
+/// @param thread_id The operating system identifier of the worker thread.
+/// @param pool The application identifier of the thread pool.
+/// @param pool_index The zero-based index of the worker thread within the pool.
+void __cdecl
+RegisterWorkerThread
+(
+    uint32_t  thread_id,
+    uint32_t       pool,
+    uint32_t pool_index
+)
+{
+    PROFILER_NATIVE_STATE *state = &ProfilerNative;
+    if (state->SessionId.load(std::memory_order_acquire) == 0)
+    {   // the profiler is not running.
+        return;
+    }
+    PTRACE_WORKER_INFO info;
+    info.Timestamp = ProfilerTimestamp();
+    info.ThreadId  = thread_id;
+    info.PoolId    = pool;
+    info.PoolIndex = pool_index;
+    info.Reserved  = 0;
+    PlatformMutexLock(&state->Lock);
+    state->Workers.push_back(info);
+    // pre-allocate the buffer so the worker's first event doesn't pay for the allocation.
+    PROFILER_THREAD_BUFFER *buf = FindOrCreateThreadBuffer(state, thread_id);
+    if (buf != NULL && state->TaskCounters && !buf->CountersOpened)
+    {   // the worker sees counters opened on an unbound buffer once it acquires the lock to attach. a bound buffer is
+        // read by its owner without the lock, so the counters are handed over for the owner to adopt at its next launch.
+        buf->CountersOpened = true;
+        if (!buf->Bound)
+        {
+            PlatformOpenCounterGroup(&buf->Counters, thread_id);
+        }
+        else if (PlatformOpenCounterGroup(&buf->PendingCounters, thread_id))
+        {
+            buf->CountersPending.store(1, std::memory_order_release);
+        }
+    }
+    PlatformMutexUnlock(&state->Lock);
+}
+
+/// @summary Register information about a thread that can produce tasks with the profiler.
+/// @param source_name A NULL-terminated ANSI string identifying the source thread.
+/// @param owning_thread_id The operating system identifier of the task producer thread.
+/// @param source_index The zero-based index of the task source within the scheduler.
+void __cdecl
+RegisterTaskSource
+(
+    char const   *source_name,
+    uint32_t owning_thread_id,
+    uint32_t     source_index
+)
+{
+    PROFILER_NATIVE_STATE *state = &ProfilerNative;
+    if (state->SessionId.load(std::memory_order_acquire) == 0)
+    {   // the profiler is not running.
+        return;
+    }
+    PTRACE_SOURCE_INFO info;
+    size_t const name_len = source_name != NULL ? strlen(source_name) : 0;
+    char          *name   = (char*) malloc(name_len + 1);
+    if (name == NULL)
+    {   // insufficient memory to copy the source name.
+        return;
+    }
+    if (name_len > 0) memcpy(name, source_name, name_len);
+    name[name_len]   = 0;
+    info.Timestamp   = ProfilerTimestamp();
+    info.ThreadId    = owning_thread_id;
+    info.SourceIndex = source_index;
+    info.NameLength  = uint32_t(name_len);
+    info.Reserved    = 0;
+    PlatformMutexLock(&state->Lock);
+    state->Sources.push_back(info);
+    state->SourceNames.push_back(name);
+    PlatformMutexUnlock(&state->Lock);
+}
+
+/// @summary Mark the point in time at which a task is defined.
+/// @param task_id The identifier of the new task.
+/// @param parent_id The identifier of the parent task, or INVALID_TASK_ID.
+/// @param task_main The entry point of the task.
+/// @param source_index The zero-based index of the task source within the scheduler.
+/// @param dependency_count The number of tasks that must complete before the new task can run.
+/// @param dependencies The list of task identifiers that must complete before the new task can run, or NULL.
+void __cdecl
+MarkTaskDefinition
+(
+    uint32_t             task_id,
+    uint32_t           parent_id,
+    void              *task_main,
+    uint32_t        source_index,
+    uint32_t    dependency_count,
+    uint32_t const *dependencies
+)
+{
+    if (!TaskSampled(task_id, ProfilerNative.TaskSampleRate))
+    {   // return before encoding the dependency list, which is the expensive part of a definition.
+        return;
+    }
+    PROFILER_THREAD_BUFFER *buf = GetThreadBuffer();
+    PROFILER_EVENT_RECORD  *rec = NULL;
+    size_t const     rec_data   = sizeof(PROFILER_DEPENDENCY_RECORD::Data0) + sizeof(PROFILER_DEPENDENCY_RECORD::Data1);
+    size_t const     dep_bytes  = dependencies != NULL && dependency_count > 0 ? DependencyDataSize(task_id, dependencies, dependency_count) : 0;
+    size_t const     dep_recs   =(dep_bytes + rec_data - 1) / rec_data;
+    if (buf == NULL)
+        return;
+    if (dep_recs > 0xFFFF)
+    {   // the record count doesn't fit in Data16. drop the event rather than record a truncated dependency list.
+        buf->DropCount.store(buf->DropCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+    if ((rec = ReserveRecords(buf, uint32_t(1 + dep_recs))) != NULL)
+    {   // the definition and its dependency records are published together.
+        rec[0].Timestamp = ProfilerTimestamp();
+        rec[0].EventType = PROFILER_RECORD_TYPE_DEFINE_TASK;
+        rec[0].Data16    = uint16_t(dep_recs);
+        rec[0].TaskId    = task_id;
+        rec[0].Arg0      = parent_id;
+        rec[0].Arg1      = source_index;
+        rec[0].Arg2      = uint64_t(uintptr_t(task_main));
+        if (dep_recs > 0)
+        {   // dependencies are usually defined shortly before the task that depends on them, so the deltas are small.
+            PROFILER_DEPENDENCY_RECORD cur;
+            PROFILER_EVENT_RECORD     *dst = &rec[1];
+            uint8_t                    var[16];
+            memset(&cur, 0, sizeof(cur));
+            cur.EventType = PROFILER_RECORD_TYPE_DEPENDENCIES;
+            AppendDependencyData(cur, dst, var, size_t(PtraceEncodeVarU64(var, dependency_count) - var));
+            for (uint32_t i = 0; i < dependency_count; ++i)
+            {
+                AppendDependencyData(cur, dst, var, size_t(PtraceEncodeVarU64(var, ZigZagEncode32(int32_t(task_id - dependencies[i]))) - var));
+            }
+            if (cur.DataSize > 0) memcpy(dst, &cur, sizeof(cur));
+        }
+        PublishRecords(buf, uint32_t(1 + dep_recs));
+    }
+}
+
+/// @summary Mark the point in time at which a task becomes ready-to-run.
+/// @param task_id The identifier of the task that is now ready-to-run.
+/// @param source_index The zero-based index of the task source within the scheduler that's responsible for the state transition.
+void __cdecl
+MarkTaskReadyToRun
+(
+    uint32_t      task_id,
+    uint32_t source_index
+)
+{
+    WriteRecord(PROFILER_RECORD_TYPE_TASK_READY_TO_RUN, task_id, source_index, 0, 0);
+}
+
+/// @summary Mark the point in time at which a worker thread begins executing a task. If the thread has hardware counters, they are read here,
+/// and if allocations are recorded, the allocation totals of the thread are saved.
+/// @param task_id The identifier of the task that is being launched.
+void __cdecl
+MarkTaskLaunch
+(
+    uint32_t task_id
+)
+{
+    if (!TaskSampled(task_id, ProfilerNative.TaskSampleRate))
+        return;
+    PROFILER_THREAD_BUFFER *buf = GetThreadBuffer();
+    PROFILER_EVENT_RECORD  *rec = NULL;
+    if (buf == NULL)
+        return;
+    if (buf->CountersPending.load(std::memory_order_acquire) != 0)
+    {   // the thread registered as a worker after it attached; take over the counters opened for it.
+        buf->Counters = buf->PendingCounters;
+        buf->PendingCounters.CounterMask = 0;
+        buf->CountersPending.store(0, std::memory_order_relaxed);
+    }
+    if ((rec = ReserveRecords(buf, 1)) != NULL)
+    {   // the worker thread ID is implied by the buffer; the flush thread records it per chunk.
+        rec->Timestamp = ProfilerTimestamp();
+        rec->EventType = PROFILER_RECORD_TYPE_TASK_LAUNCH;
+        rec->Data16    = 0;
+        rec->TaskId    = task_id;
+        rec->Arg0      = 0;
+        rec->Arg1      = 0;
+        rec->Arg2      = 0;
+        PublishRecords(buf, 1);
+    }
+    if (ProfilerNative.TaskAllocations)
+    {
+        buf->AllocStart = ProfilerThreadAllocs;
+        buf->AllocTask  = task_id;
+    }
+    if (buf->Counters.CounterMask != 0)
+    {   // read the counters last, so the cost of writing the record isn't charged to the task.
+        PlatformReadCounterGroup(&buf->Counters, buf->CounterStart);
+        buf->CounterTask = task_id;
+    }
+}
+
+/// @summary Mark the point in time at which a worker thread finishes executing a task. If the thread has hardware counters and read them
+/// when the task was launched, the change in each counter is recorded with the event. If the task made any heap allocations, their
+/// number and size are recorded with the event.
+/// @param task_id The identifier of the task that is being launched.
+void __cdecl
+MarkTaskFinish
+(
+    uint32_t task_id
+)
+{
+    if (!TaskSampled(task_id, ProfilerNative.TaskSampleRate))
+        return;
+    PROFILER_THREAD_BUFFER *buf = GetThreadBuffer();
+    PROFILER_EVENT_RECORD  *rec = NULL;
+    uint64_t                end[PLATFORM_COUNTER_GROUP_SIZE];
+    uint32_t                mask = 0;
+    PROFILER_ALLOC_TOTALS   allocs = { 0, 0, 0 };
+    if (buf == NULL)
+        return;
+    if (buf->CounterTask == task_id)
+    {   // read the counters first, so the cost of writing the record isn't charged to the task. a task launched
+        // inside this one on the same thread took over CounterStart, so this task's counters are lost.
+        PlatformReadCounterGroup(&buf->Counters, end);
+        buf->CounterTask = INVALID_TASK_ID;
+        mask = buf->Counters.CounterMask;
+    }
+    if (buf->AllocTask == task_id)
+    {   // like the counters, allocations made by a task launched inside this one are charged to the inner task only.
+        allocs.Count     = ProfilerThreadAllocs.Count     - buf->AllocStart.Count;
+        allocs.Bytes     = ProfilerThreadAllocs.Bytes     - buf->AllocStart.Bytes;
+        allocs.FreeBytes = ProfilerThreadAllocs.FreeBytes - buf->AllocStart.FreeBytes;
+        buf->AllocTask   = INVALID_TASK_ID;
+    }
+    bool     const alloc = allocs.Count != 0 || allocs.FreeBytes != 0;
+    uint32_t const count = 1 + (mask != 0 ? 1 : 0) + (alloc ? 1 : 0);
+    if ((rec = ReserveRecords(buf, count)) != NULL)
+    {   // the worker thread ID is implied by the buffer; the flush thread records it per chunk.
+        rec[0].Timestamp = ProfilerTimestamp();
+        rec[0].EventType = PROFILER_RECORD_TYPE_TASK_FINISH;
+        rec[0].Data16    = uint16_t(count - 1);
+        rec[0].TaskId    = task_id;
+        rec[0].Arg0      = 0;
+        rec[0].Arg1      = 0;
+        rec[0].Arg2      = 0;
+        if (mask != 0)
+        {   // the counters are published with the finish, like the dependency records of a definition.
+            PROFILER_COUNTER_RECORD c;
+            uint64_t const *start = buf->CounterStart;
+            c.Cycles       = end[PLATFORM_COUNTER_CYCLES] - start[PLATFORM_COUNTER_CYCLES];
+            c.EventType    = PROFILER_RECORD_TYPE_TASK_COUNTERS;
+            c.CounterMask  = uint16_t(mask);
+            c.L1DMisses    = SaturateCount32(end[PLATFORM_COUNTER_L1D_MISSES] - start[PLATFORM_COUNTER_L1D_MISSES]);
+            c.Instructions = end[PLATFORM_COUNTER_INSTRUCTIONS] - start[PLATFORM_COUNTER_INSTRUCTIONS];
+            c.LLCMisses    = SaturateCount32(end[PLATFORM_COUNTER_LLC_MISSES] - start[PLATFORM_COUNTER_LLC_MISSES]);
+            c.BranchMisses = SaturateCount32(end[PLATFORM_COUNTER_BRANCH_MISSES] - start[PLATFORM_COUNTER_BRANCH_MISSES]);
+            memcpy(&rec[1], &c, sizeof(c));
+        }
+        if (alloc)
+        {   // tasks that neither allocated nor freed memory write no record.
+            PROFILER_ALLOC_RECORD a;
+            a.AllocBytes   = allocs.Bytes;
+            a.EventType    = PROFILER_RECORD_TYPE_TASK_ALLOCS;
+            a.Reserved0    = 0;
+            a.Reserved1    = 0;
+            a.AllocCount   = allocs.Count;
+            a.FreeBytes    = allocs.FreeBytes;
+            memcpy(&rec[count - 1], &a, sizeof(a));
+        }
+        PublishRecords(buf, count);
+    }
+}
+
+/// @summary Assign an identifier to a zone site. Called once per site by PROFILER_ZONE, from any thread, before or after InitializeProfiler.
+/// @param site The site description, which must have static storage duration.
+/// @return The site identifier, or INVALID_ZONE_SITE if PROFILER_NATIVE_MAX_ZONE_SITES sites have already been registered.
+uint32_t __cdecl
+RegisterZoneSite
+(
+    PROFILER_ZONE_SITE const *site
+)
+{
+    if (site == NULL)
+        return INVALID_ZONE_SITE;
+    // identifiers are never reused, so a failed registration leaves the count past the limit.
+    uint32_t const id = ProfilerZoneSiteCount.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (id > PROFILER_NATIVE_MAX_ZONE_SITES)
+        return INVALID_ZONE_SITE;
+    ProfilerZoneSites[id].store(site, std::memory_order_release);
+    return id;
+}
+
+/// @summary Mark the point in time at which the calling thread enters a zone.
+/// @param site_id The identifier returned by RegisterZoneSite.
+void __cdecl
+MarkZoneBegin
+(
+    uint32_t site_id
+)
+{
+    WriteZoneRecord(PROFILER_RECORD_TYPE_ZONE_BEGIN, site_id);
+}
+
+/// @summary Mark the point in time at which the calling thread leaves the zone it entered most recently.
+/// @param site_id The identifier passed to the matching MarkZoneBegin.
+void __cdecl
+MarkZoneEnd
+(
+    uint32_t site_id
+)
+{
+    WriteZoneRecord(PROFILER_RECORD_TYPE_ZONE_END, site_id);
+}
+
+#if PROFILER_NATIVE_ALLOC_HOOKS
+/*////////////////////////
+//   Allocation Hooks   //
+////////////////////////*/
+#include <malloc.h>
+#include <new>
+
+/// @summary The glibc allocator entry points called by the replacement allocation functions. These are exported by every glibc release
+/// and, unlike dlsym(RTLD_NEXT), need no initialization, so they are safe to call before the process has finished loading.
+extern "C" void* __libc_malloc  (size_t size);
+extern "C" void* __libc_calloc  (size_t count, size_t size);
+extern "C" void* __libc_realloc (void *address, size_t size);
+extern "C" void* __libc_memalign(size_t alignment, size_t size);
+extern "C" void  __libc_free    (void *address);
+
+/// @summary Count a successful allocation against the calling thread. This is the whole cost of the hooks: two thread-local additions.
+/// Failed requests are not counted, so the totals match the memory the task actually received.
+/// @param size The number of bytes allocated.
+internal_function inline void
+CountAllocation
+(
+    size_t size
+)
+{
+    ProfilerThreadAllocs.Count++;
+    ProfilerThreadAllocs.Bytes += size;
+}
+
+/// @summary Count the release of a block against the calling thread. The size the block was requested with isn't known here, so the
+/// usable size reported by glibc is counted instead; it is at least the requested size, and includes any rounding by the allocator.
+/// @param address The block being released, or NULL.
+internal_function inline void
+CountFree
+(
+    void *address
+)
+{
+    if (address != NULL) ProfilerThreadAllocs.FreeBytes += malloc_usable_size(address);
+}
+
+/// @summary Release a block for the replacement free and delete operators.
+/// @param address The block to release, or NULL.
+internal_function inline void
+ReleaseAllocation
+(
+    void *address
+)
+{
+    CountFree(address);
+    __libc_free(address);
+}
+
+/// @summary Replace the C library malloc. The replacement functions have external linkage, so they take precedence over the glibc
+/// definitions for the whole process, including allocations made by operator new.
+/// @param size The number of bytes to allocate.
+/// @return The allocated memory, or NULL.
+extern "C" void*
+malloc
+(
+    size_t size
+) __THROW
+{
+    void *p = __libc_malloc(size);
+    if (p != NULL) CountAllocation(size);
+    return p;
+}
+
+/// @summary Replace the C library calloc. A request whose total size overflows fails with ENOMEM without reaching glibc.
+/// @param count The number of elements to allocate.
+/// @param size The size of each element, in bytes.
+/// @return The allocated, zero-filled memory, or NULL.
+extern "C" void*
+calloc
+(
+    size_t count,
+    size_t  size
+) __THROW
+{
+    size_t total = 0;
+    void  *p     = NULL;
+    if (__builtin_mul_overflow(count, size, &total))
+    {   // the request cannot be satisfied; report it the way glibc does.
+        errno = ENOMEM;
+        return NULL;
+    }
+    if ((p = __libc_calloc(count, size)) != NULL)
+        CountAllocation(total);
+    return p;
+}
+
+/// @summary Replace the C library realloc. A successful reallocation counts as a free of the old block and an allocation of the new size.
+/// A request for zero bytes frees the block, as it does in glibc, and counts as a free only.
+/// @param address The block to resize, or NULL.
+/// @param size The new size of the block, in bytes.
+/// @return The resized block, or NULL.
+extern "C" void*
+realloc
+(
+    void *address,
+    size_t   size
+) __THROW
+{
+    size_t const old_size = address != NULL ? malloc_usable_size(address) : 0;
+    void        *p        = __libc_realloc(address, size);
+    if (p != NULL || size == 0)
+    {   // the old block was released; a failed request for a non-zero size leaves it alone.
+        ProfilerThreadAllocs.FreeBytes += old_size;
+    }
+    if (p != NULL && size != 0) CountAllocation(size);
+    return p;
+}
+
+/// @summary Replace the C library free.
+/// @param address The block to release, or NULL.
+extern "C" void
+free
+(
+    void *address
+) __THROW
+{
+    ReleaseAllocation(address);
+}
+
+/// @summary Replace the C library memalign.
+/// @param alignment The required alignment, in bytes. Must be a power of two.
+/// @param size The number of bytes to allocate.
+/// @return The allocated memory, or NULL.
+extern "C" void*
+memalign
+(
+    size_t alignment,
+    size_t      size
+) __THROW
+{
+    void *p = __libc_memalign(alignment, size);
+    if (p != NULL) CountAllocation(size);
+    return p;
+}
+
+/// @summary Replace the C11 aligned_alloc.
+/// @param alignment The required alignment, in bytes. Must be a power of two.
+/// @param size The number of bytes to allocate.
+/// @return The allocated memory, or NULL.
+extern "C" void*
+aligned_alloc
+(
+    size_t alignment,
+    size_t      size
+) __THROW
+{
+    void *p = __libc_memalign(alignment, size);
+    if (p != NULL) CountAllocation(size);
+    return p;
+}
+
+/// @summary Replace the POSIX posix_memalign.
+/// @param result On return, the allocated memory.
+/// @param alignment The required alignment, in bytes. Must be a power of two multiple of sizeof(void*).
+/// @param size The number of bytes to allocate.
+/// @return Zero on success, EINVAL if the alignment is invalid, or ENOMEM.
+extern "C" int
+posix_memalign
+(
+    void  **result,
+    size_t alignment,
+    size_t      size
+) __THROW
+{
+    void *p = NULL;
+    if (alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0)
+        return EINVAL;
+    if ((p = __libc_memalign(alignment, size)) == NULL)
+        return ENOMEM;
+    CountAllocation(size);
+    *result = p;
+    return 0;
+}
+
+/// @summary Replace operator delete. The default implementation calls free through the PLT, which a library linked with -Bsymbolic or
+/// a statically linked C++ runtime may bypass; replacing it directly keeps the count independent of how the runtime was linked.
+/// @param address The object to release, or NULL.
+void
+operator delete
+(
+    void *address
+) noexcept
+{
+    ReleaseAllocation(address);
+}
+
+/// @summary Replace operator delete[].
+/// @param address The array to release, or NULL.
+void
+operator delete[]
+(
+    void *address
+) noexcept
+{
+    ReleaseAllocation(address);
+}
+
+/// @summary Replace the nothrow operator delete, called when a constructor throws during a nothrow new-expression.
+/// @param address The object to release, or NULL.
+void
+operator delete
+(
+    void                  *address,
+    std::nothrow_t const&
+) noexcept
+{
+    ReleaseAllocation(address);
+}
+
+/// @summary Replace the nothrow operator delete[].
+/// @param address The array to release, or NULL.
+void
+operator delete[]
+(
+    void                  *address,
+    std::nothrow_t const&
+) noexcept
+{
+    ReleaseAllocation(address);
+}
+
+#if defined(__cpp_sized_deallocation)
+/// @summary Replace the sized operator delete. The size is ignored, so that frees are counted the same way as by free.
+/// @param address The object to release, or NULL.
+void
+operator delete
+(
+    void *address,
+    size_t
+) noexcept
+{
+    ReleaseAllocation(address);
+}
+
+/// @summary Replace the sized operator delete[].
+/// @param address The array to release, or NULL.
+void
+operator delete[]
+(
+    void *address,
+    size_t
+) noexcept
+{
+    ReleaseAllocation(address);
+}
+#endif
+#endif /* PROFILER_NATIVE_ALLOC_HOOKS */
@@ -0,0 +1,488 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implement encoding and decoding of the compact event stream used
+/// in PTRACE_BLOCK_TYPE_EVENTS blocks. Timestamps are delta-encoded varints,
+/// task identifiers are zigzag-encoded deltas from the previous event, and
+/// small source indices are packed into the upper bits of the tag byte.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Map a signed 32-bit value onto an unsigned value such that values near zero have small encodings.
+/// @param x The signed input value.
+/// @return The zigzag-encoded value.
+public_function inline uint32_t
+ZigZagEncode32
+(
+    int32_t x
+)
+{
+    return (uint32_t(x) << 1) ^ uint32_t(x >> 31);
+}
+
+/// @summary Reverse the mapping performed by ZigZagEncode32.
+/// @param x The zigzag-encoded value.
+/// @return The signed value.
+public_function inline int32_t
+ZigZagDecode32
+(
+    uint32_t x
+)
+{
+    return int32_t(x >> 1) ^ -int32_t(x & 1);
+}
+
+/// @summary Map a signed 64-bit value onto an unsigned value such that values near zero have small encodings.
+/// @param x The signed input value.
+/// @return The zigzag-encoded value.
+public_function inline uint64_t
+ZigZagEncode64
+(
+    int64_t x
+)
+{
+    return (uint64_t(x) << 1) ^ uint64_t(x >> 63);
+}
+
+/// @summary Reverse the mapping performed by ZigZagEncode64.
+/// @param x The zigzag-encoded value.
+/// @return The signed value.
+public_function inline int64_t
+ZigZagDecode64
+(
+    uint64_t x
+)
+{
+    return int64_t(x >> 1) ^ -int64_t(x & 1);
+}
+
+/// @summary Compute the length of one timestamp tick as a 32.32 fixed-point number of nanoseconds, for use with ScaleTimestamp.
+/// @param ticks A number of timestamp ticks. Must be non-zero.
+/// @param nanoseconds The number of nanoseconds spanned by ticks. For a counter frequency f, pass (f, 1000000000).
+/// @return The number of nanoseconds per tick, multiplied by 2^32 and rounded down.
+public_function uint64_t
+TimestampScale
+(
+    uint64_t       ticks,
+    uint64_t nanoseconds
+)
+{
+    uint64_t const whole = nanoseconds / ticks;
+    uint64_t       rem   = nanoseconds % ticks;
+    while (ticks > 0xFFFFFFFFULL)
+    {   // keep rem << 32 in range; the fraction loses at most a few of its 32 bits.
+        ticks >>= 1;
+        rem   >>= 1;
+    }
+    return (whole << 32) + ((rem << 32) / ticks);
+}
+
+/// @summary Convert a number of timestamp ticks to nanoseconds with a fixed-point multiply. Unlike (ticks * 1000000000) / frequency,
+/// this needs no division and does not overflow until the result itself exceeds 64 bits.
+/// @param ticks The number of ticks.
+/// @param scale The length of one tick, as returned by TimestampScale.
+/// @return The number of nanoseconds, rounded down.
+public_function inline uint64_t
+ScaleTimestamp
+(
+    uint64_t ticks,
+    uint64_t scale
+)
+{   // (ticks * scale) >> 32 using 64-bit products of the 32-bit halves.
+    uint64_t const t_hi = ticks >> 32;
+    uint64_t const t_lo = ticks & 0xFFFFFFFFULL;
+    uint64_t const s_hi = scale >> 32;
+    uint64_t const s_lo = scale & 0xFFFFFFFFULL;
+    return (t_hi * scale) + (t_lo * s_hi) + ((t_lo * s_lo) >> 32);
+}
+
+/// @summary Write an unsigned integer using a little-endian base-128 variable-length encoding.
+/// @param dst The destination buffer, which must have at least 10 bytes available.
+/// @param value The value to encode.
+/// @return A pointer to the byte following the encoded value.
+public_function inline uint8_t*
+PtraceEncodeVarU64
+(
+    uint8_t   *dst,
+    uint64_t value
+)
+{
+    while (value >= 0x80)
+    {
+        *dst++  = uint8_t(value | 0x80);
+        value >>= 7;
+    }
+    *dst++ = uint8_t(value);
+    return dst;
+}
+
+/// @summary Read an unsigned integer written by PtraceEncodeVarU64.
+/// @param src The start of the encoded value.
+/// @param end The end of the readable buffer.
+/// @param value On return, this value is set to the decoded value.
+/// @return A pointer to the byte following the encoded value, or NULL if the value is truncated or malformed.
+public_function inline uint8_t const*
+PtraceDecodeVarU64
+(
+    uint8_t const   *src,
+    uint8_t const   *end,
+    uint64_t      &value
+)
+{
+    if (src < end && *src < 0x80)
+    {   // fast path for single-byte values, the most common case.
+        value = *src;
+        return src + 1;
+    }
+    uint64_t result = 0;
+    uint32_t  shift = 0;
+    while (src < end && shift < 64)
+    {
+        uint8_t b = *src++;
+        result   |= uint64_t(b & 0x7F) << shift;
+        if ((b & 0x80) == 0)
+        {
+            value = result;
+            return src;
+        }
+        shift += 7;
+    }
+    return NULL;
+}
+
+/// @summary Reset the delta-coding state at the start of a block.
+/// @param state The codec state to reset.
+/// @param first_time The FirstTime value from the block header, in ticks.
+public_function inline void
+PtraceResetCodecState
+(
+    PTRACE_CODEC_STATE *state,
+    uint64_t       first_time
+)
+{
+    state->PrevTime  = first_time;
+    state->PrevEntry = 0;
+    state->PrevTask  = 0;
+}
+
+/// @summary Encode a single event into a compact event stream.
+/// @param dst The destination buffer. At least PTRACE_MAX_EVENT_SIZE + (PTRACE_MAX_DEPENDENCY_SIZE * dependency count) bytes must be available.
+/// @param state The delta-coding state for the block, updated on return.
+/// @param ev The event to encode. The DependencyData field is ignored.
+/// @param dependencies The ev->DependencyCount dependency task identifiers of a PTRACE_EVENT_TYPE_DEFINE_TASK event, or NULL.
+/// @return A pointer to the byte following the encoded event.
+public_function uint8_t*
+PtraceEncodeEvent
+(
+    uint8_t                     *dst,
+    PTRACE_CODEC_STATE        *state,
+    PTRACE_EVENT const           *ev,
+    uint32_t const     *dependencies
+)
+{
+    uint64_t  const ts_delta = ev->Timestamp >= state->PrevTime ? ev->Timestamp - state->PrevTime : 0;
+    uint32_t  const task_zz  = ZigZagEncode32(int32_t(ev->TaskId - state->PrevTask));
+    uint32_t        packed   = 0;
+    bool            src_var  = false;
+    bool            task_var = true;
+
+    // the upper tag bits hold the source index for events that have one, and
+    // small task deltas for launch and finish, which usually follow each other.
+    switch (ev->EventType)
+    {
+        case PTRACE_EVENT_TYPE_DEFINE_TASK:
+        case PTRACE_EVENT_TYPE_TASK_READY_TO_RUN:
+            if (ev->SourceIndex <= PTRACE_TAG_MAX_PACKED_SOURCE) packed = ev->SourceIndex + 1;
+            else src_var = true;
+            break;
+        default:
+            if (task_zz <= PTRACE_TAG_MAX_PACKED_SOURCE) { packed = task_zz + 1; task_var = false; }
+            break;
+    }
+
+    *dst++ = uint8_t(ev->EventType | (packed << PTRACE_TAG_TYPE_BITS));
+    dst    = PtraceEncodeVarU64(dst, ts_delta);
+    if (src_var ) dst = PtraceEncodeVarU64(dst, ev->SourceIndex);
+    if (task_var) dst = PtraceEncodeVarU64(dst, task_zz);
+    if (ev->EventType == PTRACE_EVENT_TYPE_DEFINE_TASK)
+    {   // parent IDs are usually close to the child ID; zero means INVALID_TASK_ID.
+        uint64_t parent = ev->ParentId == INVALID_TASK_ID ? 0 : uint64_t(ZigZagEncode32(int32_t(ev->TaskId - ev->ParentId))) + 1;
+        dst = PtraceEncodeVarU64(dst, parent);
+        dst = PtraceEncodeVarU64(dst, ZigZagEncode64(int64_t(ev->EntryPoint - state->PrevEntry)));
+        dst = PtraceEncodeVarU64(dst, ev->DependencyCount);
+        for (uint32_t i = 0; i < ev->DependencyCount; ++i)
+        {   // dependencies are usually defined shortly before the task that depends on them.
+            dst = PtraceEncodeVarU64(dst, ZigZagEncode32(int32_t(ev->TaskId - dependencies[i])));
+        }
+        state->PrevEntry = ev->EntryPoint;
+    }
+    state->PrevTime = ev->Timestamp >= state->PrevTime ? ev->Timestamp : state->PrevTime;
+    state->PrevTask = ev->TaskId;
+    return dst;
+}
+
+/// @summary Decode a single event from a compact event stream.
+/// @param src The start of the encoded event.
+/// @param end The end of the block data.
+/// @param state The delta-coding state for the block, updated on return.
+/// @param ev On return, the decoded event. For task definitions, DependencyData points into the source buffer.
+/// @return A pointer to the start of the next event, or NULL if the event is malformed.
+public_function uint8_t const*
+PtraceDecodeEvent
+(
+    uint8_t const               *src,
+    uint8_t const               *end,
+    PTRACE_CODEC_STATE        *state,
+    PTRACE_EVENT                 *ev
+)
+{
+    uint64_t value;
+    if (src >= end) return NULL;
+    uint32_t const tag    = *src++;
+    uint32_t const type   = tag & PTRACE_TAG_TYPE_MASK;
+    uint32_t const packed = tag >> PTRACE_TAG_TYPE_BITS;
+    uint32_t       task_zz= 0;
+
+    if ((src = PtraceDecodeVarU64(src, end, value)) == NULL) return NULL;
+    state->PrevTime     += value;
+    ev->Timestamp        = state->PrevTime;
+    ev->EventType        = type;
+    ev->EntryPoint       = 0;
+    ev->ParentId         = INVALID_TASK_ID;
+    ev->SourceIndex      = 0;
+    ev->DependencyCount  = 0;
+    ev->DependencyData   = NULL;
+
+    switch (type)
+    {
+        case PTRACE_EVENT_TYPE_DEFINE_TASK:
+        case PTRACE_EVENT_TYPE_TASK_READY_TO_RUN:
+            {
+                if (packed != 0) ev->SourceIndex = packed - 1;
+                else if ((src = PtraceDecodeVarU64(src, end, value)) == NULL) return NULL;
+                else ev->SourceIndex = uint32_t(value);
+                if ((src = PtraceDecodeVarU64(src, end, value)) == NULL) return NULL;
+                task_zz = uint32_t(value);
+            } break;
+        case PTRACE_EVENT_TYPE_TASK_LAUNCH:
+        case PTRACE_EVENT_TYPE_TASK_FINISH:
+            {
+                if (packed != 0) task_zz = packed - 1;
+                else if ((src = PtraceDecodeVarU64(src, end, value)) == NULL) return NULL;
+                else task_zz = uint32_t(value);
+            } break;
+        default:
+            return NULL;
+    }
+    ev->TaskId      = state->PrevTask + uint32_t(ZigZagDecode32(task_zz));
+    state->PrevTask = ev->TaskId;
+
+    if (type == PTRACE_EVENT_TYPE_DEFINE_TASK)
+    {
+        if ((src = PtraceDecodeVarU64(src, end, value)) == NULL) return NULL;
+        ev->ParentId = value == 0 ? INVALID_TASK_ID : ev->TaskId - uint32_t(ZigZagDecode32(uint32_t(value - 1)));
+        if ((src = PtraceDecodeVarU64(src, end, value)) == NULL) return NULL;
+        ev->EntryPoint   = state->PrevEntry + uint64_t(ZigZagDecode64(value));
+        state->PrevEntry = ev->EntryPoint;
+        if ((src = PtraceDecodeVarU64(src, end, value)) == NULL) return NULL;
+        ev->DependencyCount = uint32_t(value);
+        ev->DependencyData  = src;
+        for (uint32_t i = 0; i < ev->DependencyCount; ++i)
+        {   // skip over the dependency list; PtraceDecodeDependencies decodes it on demand.
+            uint8_t const *next = PtraceDecodeVarU64(src, end, value);
+            if (next == NULL || (next - src) > PTRACE_MAX_DEPENDENCY_SIZE) return NULL;
+            src = next;
+        }
+    }
+    return src;
+}
+
+/// @summary Decode the dependency list of a task definition returned by PtraceDecodeEvent.
+/// @param ev The decoded PTRACE_EVENT_TYPE_DEFINE_TASK event. The source buffer must still be valid.
+/// @param dependencies The destination array, with space for ev->DependencyCount task identifiers.
+public_function void
+PtraceDecodeDependencies
+(
+    PTRACE_EVENT const  *ev,
+    uint32_t  *dependencies
+)
+{
+    uint8_t const *src = ev->DependencyData;
+    for (uint32_t i = 0; i < ev->DependencyCount; ++i)
+    {   // the event was validated by PtraceDecodeEvent, so the bytes are present.
+        uint64_t value = 0;
+        src = PtraceDecodeVarU64(src, src + PTRACE_MAX_DEPENDENCY_SIZE, value);
+        dependencies[i] = ev->TaskId - uint32_t(ZigZagDecode32(uint32_t(value)));
+    }
+}
+
+/// @summary Encode a single zone event into a compact zone event stream, as stored in PTRACE_BLOCK_TYPE_ZONES blocks. The site
+/// identifier and the begin or end flag share a varint, followed by the timestamp delta from the previous zone event.
+/// @param dst The destination buffer. At least PTRACE_MAX_ZONE_EVENT_SIZE bytes must be available.
+/// @param state The delta-coding state for the block, updated on return. Only PrevTime is used.
+/// @param ev The zone event to encode.
+/// @return A pointer to the byte following the encoded event.
+public_function inline uint8_t*
+PtraceEncodeZoneEvent
+(
+    uint8_t                  *dst,
+    PTRACE_CODEC_STATE     *state,
+    PTRACE_ZONE_EVENT const   *ev
+)
+{
+    uint64_t const ts_delta = ev->Timestamp >= state->PrevTime ? ev->Timestamp - state->PrevTime : 0;
+    dst = PtraceEncodeVarU64(dst, (uint64_t(ev->SiteId) << 1) | (ev->IsEnd ? 1U : 0U));
+    dst = PtraceEncodeVarU64(dst, ts_delta);
+    state->PrevTime = ev->Timestamp >= state->PrevTime ? ev->Timestamp : state->PrevTime;
+    return dst;
+}
+
+/// @summary Decode a single zone event from a compact zone event stream.
+/// @param src The start of the encoded event.
+/// @param end The end of the block data.
+/// @param state The delta-coding state for the block, updated on return.
+/// @param ev On return, the decoded zone event.
+/// @return A pointer to the start of the next event, or NULL if the event is malformed.
+public_function inline uint8_t const*
+PtraceDecodeZoneEvent
+(
+    uint8_t const            *src,
+    uint8_t const            *end,
+    PTRACE_CODEC_STATE     *state,
+    PTRACE_ZONE_EVENT         *ev
+)
+{
+    uint64_t site  = 0;
+    uint64_t delta = 0;
+    if ((src = PtraceDecodeVarU64(src, end, site )) == NULL) return NULL;
+    if ((src = PtraceDecodeVarU64(src, end, delta)) == NULL) return NULL;
+    if ((site >> 1) > 0xFFFFFFFFULL) return NULL;
+    state->PrevTime += delta;
+    ev->Timestamp    = state->PrevTime;
+    ev->SiteId       = uint32_t(site >> 1);
+    ev->IsEnd        = uint32_t(site & 1);
+    return src;
+}
+
+/// @summary Encode the hardware counters of a single task into a compact counter stream, as stored in PTRACE_BLOCK_TYPE_TASK_COUNTERS
+/// blocks. The timestamp delta is followed by the zigzag-encoded task identifier delta, the counter mask, and each counter in the mask.
+/// @param dst The destination buffer. At least PTRACE_MAX_TASK_COUNTERS_SIZE bytes must be available.
+/// @param state The delta-coding state for the block, updated on return. Only PrevTime and PrevTask are used.
+/// @param ctr The task counters to encode.
+/// @return A pointer to the byte following the encoded record.
+public_function inline uint8_t*
+PtraceEncodeTaskCounters
+(
+    uint8_t                   *dst,
+    PTRACE_CODEC_STATE      *state,
+    PTRACE_TASK_COUNTERS const *ctr
+)
+{
+    uint32_t const     mask = ctr->CounterMask & ((1U << PTRACE_MAX_COUNTERS) - 1U);
+    uint64_t const ts_delta = ctr->Timestamp >= state->PrevTime ? ctr->Timestamp - state->PrevTime : 0;
+    dst = PtraceEncodeVarU64(dst, ts_delta);
+    dst = PtraceEncodeVarU64(dst, ZigZagEncode32(int32_t(ctr->TaskId - state->PrevTask)));
+    dst = PtraceEncodeVarU64(dst, mask);
+    for (uint32_t i = 0; i < PTRACE_MAX_COUNTERS; ++i)
+    {
+        if (mask & (1U << i)) dst = PtraceEncodeVarU64(dst, ctr->Values[i]);
+    }
+    state->PrevTime = ctr->Timestamp >= state->PrevTime ? ctr->Timestamp : state->PrevTime;
+    state->PrevTask = ctr->TaskId;
+    return dst;
+}
+
+/// @summary Decode the hardware counters of a single task from a compact counter stream.
+/// @param src The start of the encoded record.
+/// @param end The end of the block data.
+/// @param state The delta-coding state for the block, updated on return.
+/// @param ctr On return, the decoded task counters.
+/// @return A pointer to the start of the next record, or NULL if the record is malformed.
+public_function inline uint8_t const*
+PtraceDecodeTaskCounters
+(
+    uint8_t const             *src,
+    uint8_t const             *end,
+    PTRACE_CODEC_STATE      *state,
+    PTRACE_TASK_COUNTERS      *ctr
+)
+{
+    uint64_t delta = 0;
+    uint64_t task  = 0;
+    uint64_t mask  = 0;
+    if ((src = PtraceDecodeVarU64(src, end, delta)) == NULL) return NULL;
+    if ((src = PtraceDecodeVarU64(src, end, task )) == NULL) return NULL;
+    if ((src = PtraceDecodeVarU64(src, end, mask )) == NULL) return NULL;
+    if (task > 0xFFFFFFFFULL || mask >= (1U << PTRACE_MAX_COUNTERS)) return NULL;
+    for (uint32_t i = 0; i < PTRACE_MAX_COUNTERS; ++i)
+    {
+        ctr->Values[i] = 0;
+        if ((mask & (1U << i)) && (src = PtraceDecodeVarU64(src, end, ctr->Values[i])) == NULL) return NULL;
+    }
+    state->PrevTime += delta;
+    state->PrevTask += uint32_t(ZigZagDecode32(uint32_t(task)));
+    ctr->Timestamp   = state->PrevTime;
+    ctr->TaskId      = state->PrevTask;
+    ctr->CounterMask = uint32_t(mask);
+    return src;
+}
+
+/// @summary Encode the heap allocations and frees of a single task into a compact allocation stream, as stored in PTRACE_BLOCK_TYPE_TASK_HEAP
+/// blocks. The timestamp delta is followed by the zigzag-encoded task identifier delta, the allocation count, the allocated bytes and the
+/// freed bytes. PTRACE_BLOCK_TYPE_TASK_ALLOCS blocks, written before minor version 6, have the same layout without the freed bytes.
+/// @param dst The destination buffer. At least PTRACE_MAX_TASK_ALLOCS_SIZE bytes must be available.
+/// @param state The delta-coding state for the block, updated on return. Only PrevTime and PrevTask are used.
+/// @param allocs The task allocations to encode.
+/// @return A pointer to the byte following the encoded record.
+public_function inline uint8_t*
+PtraceEncodeTaskAllocs
+(
+    uint8_t                   *dst,
+    PTRACE_CODEC_STATE      *state,
+    PTRACE_TASK_ALLOCS const *allocs
+)
+{
+    uint64_t const ts_delta = allocs->Timestamp >= state->PrevTime ? allocs->Timestamp - state->PrevTime : 0;
+    dst = PtraceEncodeVarU64(dst, ts_delta);
+    dst = PtraceEncodeVarU64(dst, ZigZagEncode32(int32_t(allocs->TaskId - state->PrevTask)));
+    dst = PtraceEncodeVarU64(dst, allocs->AllocCount);
+    dst = PtraceEncodeVarU64(dst, allocs->AllocBytes);
+    dst = PtraceEncodeVarU64(dst, allocs->FreeBytes);
+    state->PrevTime = allocs->Timestamp >= state->PrevTime ? allocs->Timestamp : state->PrevTime;
+    state->PrevTask = allocs->TaskId;
+    return dst;
+}
+
+/// @summary Decode the heap allocations of a single task from a compact allocation stream.
+/// @param src The start of the encoded record.
+/// @param end The end of the block data.
+/// @param state The delta-coding state for the block, updated on return.
+/// @param block_type PTRACE_BLOCK_TYPE_TASK_HEAP or PTRACE_BLOCK_TYPE_TASK_ALLOCS, the type of the block holding the record.
+/// @param allocs On return, the decoded task allocations.
+/// @return A pointer to the start of the next record, or NULL if the record is malformed.
+public_function inline uint8_t const*
+PtraceDecodeTaskAllocs
+(
+    uint8_t const             *src,
+    uint8_t const             *end,
+    PTRACE_CODEC_STATE      *state,
+    uint32_t             block_type,
+    PTRACE_TASK_ALLOCS     *allocs
+)
+{
+    allocs->FreeBytes = 0;
+    uint64_t delta = 0;
+    uint64_t task  = 0;
+    if ((src = PtraceDecodeVarU64(src, end, delta)) == NULL) return NULL;
+    if ((src = PtraceDecodeVarU64(src, end, task )) == NULL) return NULL;
+    if ((src = PtraceDecodeVarU64(src, end, allocs->AllocCount)) == NULL) return NULL;
+    if ((src = PtraceDecodeVarU64(src, end, allocs->AllocBytes)) == NULL) return NULL;
+    if (block_type == PTRACE_BLOCK_TYPE_TASK_HEAP && (src = PtraceDecodeVarU64(src, end, allocs->FreeBytes)) == NULL) return NULL;
+    if (task > 0xFFFFFFFFULL) return NULL;
+    state->PrevTime += delta;
+    state->PrevTask += uint32_t(ZigZagDecode32(uint32_t(task)));
+    allocs->Timestamp = state->PrevTime;
+    allocs->TaskId    = state->PrevTask;
+    allocs->Reserved  = 0;
+    return src;
+}
@@ -0,0 +1,809 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implement the functions that load a .ptrace file written by the
+/// native profiler backend into a WIN32_PROFILER_EVENTS container. The file
+/// is parsed from memory. A serial pass validates block headers and sizes the
+/// output; event blocks are then decoded in parallel into per-thread column
+/// ranges, and the per-thread streams are merged into a single time-ordered
+/// event log by a parallel k-way merge over disjoint time partitions.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////////
+//   Preprocessor   //
+////////////////////*/
+/// @summary Define the number of merge partitions created per loader thread. More partitions balance better when the event rate varies over the trace.
+#ifndef PTRACE_LOADER_PARTITIONS_PER_THREAD
+#define PTRACE_LOADER_PARTITIONS_PER_THREAD    4
+#endif
+
+/// @summary Define the minimum number of events in a merge partition. Smaller traces are merged by fewer threads.
+#ifndef PTRACE_LOADER_MIN_PARTITION_SIZE
+#define PTRACE_LOADER_MIN_PARTITION_SIZE       65536
+#endif
+
+/// @summary Define the number of timestamps sampled per partition when choosing the partition boundaries.
+#ifndef PTRACE_LOADER_SAMPLES_PER_PARTITION
+#define PTRACE_LOADER_SAMPLES_PER_PARTITION    16
+#endif
+
+/*//////////////////
+//   Data Types   //
+//////////////////*/
+/// @summary Define the per-thread state accumulated while loading a .ptrace file.
+struct PTRACE_LOADER_THREAD
+{
+    uint32_t                    ThreadId;         /// The operating system identifier of the thread.
+    size_t                      EventStart;       /// The index of the thread's first event in the decoded columns.
+    size_t                      EventCount;       /// The number of events in all of the thread's event blocks.
+    std::vector<uint32_t>       BlockList;        /// The index of each of the thread's event blocks, in file order.
+};
+
+/// @summary Define the state associated with a single event block while loading a .ptrace file.
+struct PTRACE_LOADER_BLOCK
+{
+    size_t                      Offset;           /// The byte offset of the block header within the file.
+    uint32_t                    ThreadIndex;      /// The index of the owning thread in the loader thread list.
+    uint32_t                    DecodedCount;     /// The number of events decoded from the block. Less than the header EventCount if the block is corrupt.
+    size_t                      EventStart;       /// The index of the block's first event in the decoded columns.
+    size_t                      DependencyStart;  /// The index of the block's first dependency in the decoded columns.
+    uint64_t                    LastTime;         /// The timestamp of the last decoded event, in nanoseconds.
+    std::vector<task_id_t>      Dependencies;     /// The dependencies of the block's task definitions, in event order.
+};
+
+/// @summary Define a single entry in the heap used to merge per-thread event streams.
+struct PTRACE_MERGE_ENTRY
+{
+    uint64_t                    Timestamp;        /// The timestamp of the next event from the thread, in nanoseconds.
+    uint32_t                    ThreadIndex;      /// The index of the thread in the loader thread list.
+};
+
+/// @summary Define the piecewise-linear mapping from file timestamps to nanoseconds. There is one segment between each pair of consecutive
+/// clock calibration samples; timestamps before the first sample or after the last extrapolate the nearest segment. Files without
+/// calibration samples have a single segment derived from the header clock frequency.
+struct PTRACE_CLOCK_MAP
+{
+    std::vector<uint64_t>       Ticks;            /// The timestamp at which each segment starts, in ticks, in ascending order.
+    std::vector<uint64_t>       Base;             /// The time at the start of each segment, in nanoseconds.
+    std::vector<uint64_t>       Scale;            /// The length of one tick within each segment. See TimestampScale.
+};
+
+/// @summary Define the data shared by the parallel decode and merge jobs of a single LoadPtraceEvents call.
+struct PTRACE_LOADER_CONTEXT
+{
+    uint8_t const              *FileData;         /// The start of the file data.
+    PTRACE_CLOCK_MAP const     *Clock;            /// The mapping from file timestamps to nanoseconds.
+    size_t                      ThreadCount;      /// The number of producer threads in the file.
+    PTRACE_LOADER_THREAD       *Threads;          /// The list of producer threads.
+    PTRACE_LOADER_BLOCK        *Blocks;           /// The list of event blocks, in file order.
+    size_t const               *PartitionCut;     /// For partition p and thread t, PartitionCut[p * ThreadCount + t] is the first decoded event of thread t in partition p.
+    size_t const               *PartitionStart;   /// The index of the first output event of each partition.
+    WIN32_TASK_EVENT_LIST      *Decoded;          /// The decoded events, stored thread-major. Each thread's events are in time order.
+    WIN32_TASK_EVENT_LIST      *Output;           /// The merged, time-ordered output event log.
+};
+
+/*//////////////////////////
+//   Internal Functions   //
+//////////////////////////*/
+/// @summary Order clock calibration samples by timestamp.
+/// @param a The first sample.
+/// @param b The second sample.
+/// @return true if a was taken before b.
+internal_function bool
+PtraceClockSyncBefore
+(
+    PTRACE_CLOCK_SYNC const &a,
+    PTRACE_CLOCK_SYNC const &b
+)
+{
+    return (a.Timestamp != b.Timestamp) ? (a.Timestamp < b.Timestamp) : (a.ReferenceTime < b.ReferenceTime);
+}
+
+/// @summary Build the mapping from file timestamps to nanoseconds. Samples that don't advance both clocks are discarded.
+/// @param map The mapping to build.
+/// @param sync The clock calibration samples read from the file, in any order. Sorted on return.
+/// @param frequency The header clock frequency, in ticks-per-second, used if there are fewer than two usable samples.
+internal_function void
+PtraceBuildClockMap
+(
+    PTRACE_CLOCK_MAP               *map,
+    std::vector<PTRACE_CLOCK_SYNC> &sync,
+    uint64_t                   frequency
+)
+{
+    std::vector<PTRACE_CLOCK_SYNC> keep;
+    std::sort(sync.begin(), sync.end(), PtraceClockSyncBefore);
+    for (size_t i = 0, n = sync.size(); i < n; ++i)
+    {
+        if (keep.empty() || (sync[i].Timestamp > keep.back().Timestamp && sync[i].ReferenceTime > keep.back().ReferenceTime))
+            keep.push_back(sync[i]);
+    }
+    map->Ticks.clear();
+    map->Base.clear();
+    map->Scale.clear();
+    if (keep.size() < 2)
+    {   // no calibration, so the header frequency is exact.
+        map->Ticks.push_back(0);
+        map->Base.push_back(0);
+        map->Scale.push_back(TimestampScale(frequency, 1000000000ULL));
+        return;
+    }
+    for (size_t i = 0, n = keep.size() - 1; i < n; ++i)
+    {
+        map->Ticks.push_back(keep[i].Timestamp);
+        map->Base.push_back(keep[i].ReferenceTime);
+        map->Scale.push_back(TimestampScale(keep[i + 1].Timestamp - keep[i].Timestamp, keep[i + 1].ReferenceTime - keep[i].ReferenceTime));
+    }
+}
+
+/// @summary Convert a file timestamp to nanoseconds. Calls with ascending timestamps, such as the events of one block, walk the segments in order.
+/// @param map The mapping from file timestamps to nanoseconds.
+/// @param ticks The timestamp value, in ticks.
+/// @param segment The segment used by the previous conversion, or zero. Updated on return.
+/// @return The timestamp value, in nanoseconds.
+internal_function inline uint64_t
+PtraceClockToNanoseconds
+(
+    PTRACE_CLOCK_MAP const *map,
+    uint64_t              ticks,
+    size_t             &segment
+)
+{
+    size_t const n = map->Ticks.size();
+    if (ticks < map->Ticks[segment])
+    {   // out of order; search from the start.
+        segment = 0;
+    }
+    while (segment + 1 < n && map->Ticks[segment + 1] <= ticks)
+    {
+        segment++;
+    }
+    if (ticks >= map->Ticks[segment])
+        return map->Base[segment] + ScaleTimestamp(ticks - map->Ticks[segment], map->Scale[segment]);
+    uint64_t const before = ScaleTimestamp(map->Ticks[0] - ticks, map->Scale[0]);
+    return map->Base[0] > before ? map->Base[0] - before : 0;
+}
+
+/// @summary Determine whether one merge heap entry should be ordered before another. Ties go to the lower thread index so merging is stable.
+/// @param a The first entry.
+/// @param b The second entry.
+/// @return true if a should be merged before b.
+internal_function inline bool
+PtraceMergeBefore
+(
+    PTRACE_MERGE_ENTRY const &a,
+    PTRACE_MERGE_ENTRY const &b
+)
+{
+    return (a.Timestamp < b.Timestamp) || (a.Timestamp == b.Timestamp && a.ThreadIndex < b.ThreadIndex);
+}
+
+/// @summary Restore the min-heap property of a merge heap starting at a given index.
+/// @param heap The merge heap.
+/// @param count The number of entries in the heap.
+/// @param index The index of the entry that may be out of place.
+internal_function void
+PtraceMergeSiftDown
+(
+    PTRACE_MERGE_ENTRY *heap,
+    size_t             count,
+    size_t             index
+)
+{
+    for ( ; ; )
+    {
+        size_t l = (index * 2) + 1;
+        size_t r = l + 1;
+        size_t m = index;
+        if (l < count && PtraceMergeBefore(heap[l], heap[m])) m = l;
+        if (r < count && PtraceMergeBefore(heap[r], heap[m])) m = r;
+        if (m == index) break;
+        PTRACE_MERGE_ENTRY t = heap[m]; heap[m] = heap[index]; heap[index] = t;
+        index = m;
+    }
+}
+
+/// @summary Find the loader thread record for a thread, creating it if necessary.
+/// @param threads The list of loader thread records.
+/// @param thread_id The operating system identifier of the thread.
+/// @return The zero-based index of the thread record.
+internal_function size_t
+PtraceFindOrCreateThread
+(
+    std::vector<PTRACE_LOADER_THREAD> &threads,
+    uint32_t                         thread_id
+)
+{   // files contain a handful of threads, so a linear search is fine.
+    for (size_t i = 0, n = threads.size(); i < n; ++i)
+    {
+        if (threads[i].ThreadId == thread_id)
+            return i;
+    }
+    PTRACE_LOADER_THREAD thread;
+    thread.ThreadId        = thread_id;
+    thread.EventStart      = 0;
+    thread.EventCount      = 0;
+    threads.push_back(thread);
+    return threads.size() - 1;
+}
+
+/// @summary Resize every column of a task event list. The dependency offsets get one extra entry.
+/// @param list The task event list to resize.
+/// @param event_count The number of events.
+/// @param dependency_count The total number of dependencies.
+internal_function void
+PtraceResizeEventList
+(
+    WIN32_TASK_EVENT_LIST *list,
+    size_t          event_count,
+    size_t     dependency_count
+)
+{
+    list->EventCount = event_count;
+    list->EventTime.resize(event_count);
+    list->EventType.resize(event_count);
+    list->TaskId.resize(event_count);
+    list->ThreadId.resize(event_count);
+    list->SourceIndex.resize(event_count);
+    list->ParentId.resize(event_count);
+    list->EntryPoint.resize(event_count);
+    list->DependencyStart.resize(event_count + 1);
+    list->Dependencies.resize(dependency_count);
+}
+
+/// @summary Move a range of decoded events towards the start of a task event list. Used to close the gap left by a corrupt block.
+/// @param list The task event list to update.
+/// @param dst The destination index. Must not be greater than src.
+/// @param src The index of the first event to move.
+/// @param count The number of events to move.
+internal_function void
+PtraceMoveEvents
+(
+    WIN32_TASK_EVENT_LIST *list,
+    size_t                  dst,
+    size_t                  src,
+    size_t                count
+)
+{   // std::copy handles overlapping ranges when moving towards the start.
+    std::copy(list->EventTime.begin()       + src, list->EventTime.begin()       + src + count, list->EventTime.begin()       + dst);
+    std::copy(list->EventType.begin()       + src, list->EventType.begin()       + src + count, list->EventType.begin()       + dst);
+    std::copy(list->TaskId.begin()          + src, list->TaskId.begin()          + src + count, list->TaskId.begin()          + dst);
+    std::copy(list->ThreadId.begin()        + src, list->ThreadId.begin()        + src + count, list->ThreadId.begin()        + dst);
+    std::copy(list->SourceIndex.begin()     + src, list->SourceIndex.begin()     + src + count, list->SourceIndex.begin()     + dst);
+    std::copy(list->ParentId.begin()        + src, list->ParentId.begin()        + src + count, list->ParentId.begin()        + dst);
+    std::copy(list->EntryPoint.begin()      + src, list->EntryPoint.begin()      + src + count, list->EntryPoint.begin()      + dst);
+    std::copy(list->DependencyStart.begin() + src, list->DependencyStart.begin() + src + count, list->DependencyStart.begin() + dst);
+}
+
+/// @summary Decode a single event block into its range of the decoded columns. Called concurrently for different blocks.
+/// Dependency offsets are stored relative to the start of the block, and are rebased by PtraceRebaseBlockJob.
+/// @param argp A pointer to the PTRACE_LOADER_CONTEXT.
+/// @param block_index The index of the block to decode.
+internal_function void
+PtraceDecodeBlockJob
+(
+    void        *argp,
+    size_t block_index
+)
+{
+    PTRACE_LOADER_CONTEXT *ctx = (PTRACE_LOADER_CONTEXT*) argp;
+    PTRACE_LOADER_BLOCK   &blk = ctx->Blocks[block_index];
+    WIN32_TASK_EVENT_LIST &dec =*ctx->Decoded;
+    uint32_t const   thread_id = ctx->Threads[blk.ThreadIndex].ThreadId;
+    size_t             segment = 0;
+    PTRACE_BLOCK_HEADER    hdr;
+    PTRACE_CODEC_STATE   codec;
+    PTRACE_EVENT            ev;
+    uint32_t                 i;
+
+    memcpy(&hdr, ctx->FileData + blk.Offset, sizeof(hdr));
+    uint8_t const *src = ctx->FileData + blk.Offset + sizeof(hdr);
+    uint8_t const *end = src + hdr.DataSize;
+    PtraceResetCodecState(&codec, hdr.FirstTime);
+    for (i = 0; i < hdr.EventCount; ++i)
+    {
+        if ((src = PtraceDecodeEvent(src, end, &codec, &ev)) == NULL)
+        {   // the block is corrupt; skip the remainder of it.
+            break;
+        }
+        size_t   const index = blk.EventStart + i;
+        uint64_t const    ns = PtraceClockToNanoseconds(ctx->Clock, ev.Timestamp, segment);
+        dec.EventTime  [index] = ns;
+        dec.EventType  [index] = uint8_t(ev.EventType);
+        dec.TaskId     [index] = ev.TaskId;
+        dec.ThreadId   [index] = thread_id;
+        dec.SourceIndex[index] = ev.SourceIndex;
+        dec.ParentId   [index] = ev.ParentId;
+        dec.EntryPoint [index] = ev.EntryPoint;
+        dec.DependencyStart[index] = uint32_t(blk.Dependencies.size());
+        if (ev.DependencyCount > 0)
+        {
+            size_t base = blk.Dependencies.size();
+            blk.Dependencies.resize(base + ev.DependencyCount);
+            PtraceDecodeDependencies(&ev, &blk.Dependencies[base]);
+        }
+        blk.LastTime = ns;
+    }
+    blk.DecodedCount = i;
+}
+
+/// @summary Convert the block-relative dependency offsets of a decoded block to absolute offsets, and copy its dependencies into the decoded columns.
+/// @param argp A pointer to the PTRACE_LOADER_CONTEXT.
+/// @param block_index The index of the block to update.
+internal_function void
+PtraceRebaseBlockJob
+(
+    void        *argp,
+    size_t block_index
+)
+{
+    PTRACE_LOADER_CONTEXT *ctx = (PTRACE_LOADER_CONTEXT*) argp;
+    PTRACE_LOADER_BLOCK   &blk = ctx->Blocks[block_index];
+    WIN32_TASK_EVENT_LIST &dec =*ctx->Decoded;
+    for (size_t i = 0; i < blk.DecodedCount; ++i)
+    {
+        dec.DependencyStart[blk.EventStart + i] += uint32_t(blk.DependencyStart);
+    }
+    if (!blk.Dependencies.empty())
+    {
+        memcpy(&dec.Dependencies[blk.DependencyStart], &blk.Dependencies[0], blk.Dependencies.size() * sizeof(task_id_t));
+    }
+}
+
+/// @summary Merge the per-thread event ranges of one time partition into the output event log. Called concurrently for different partitions.
+/// Every event with a given timestamp falls into the same partition, so the output is identical to a serial merge.
+/// @param argp A pointer to the PTRACE_LOADER_CONTEXT.
+/// @param partition The index of the partition to merge.
+internal_function void
+PtraceMergePartitionJob
+(
+    void      *argp,
+    size_t partition
+)
+{
+    PTRACE_LOADER_CONTEXT       *ctx = (PTRACE_LOADER_CONTEXT*) argp;
+    WIN32_TASK_EVENT_LIST const &dec =*ctx->Decoded;
+    WIN32_TASK_EVENT_LIST       &out =*ctx->Output;
+    size_t const        thread_count = ctx->ThreadCount;
+    size_t const               *head = ctx->PartitionCut + (partition * thread_count);
+    size_t const               *tail = head + thread_count;
+    std::vector<size_t>       cursor(head, tail);
+    std::vector<PTRACE_MERGE_ENTRY> heap;
+    size_t                 out_index = ctx->PartitionStart[partition];
+    uint32_t               dep_index = 0;
+
+    heap.reserve(thread_count);
+    for (size_t t = 0; t < thread_count; ++t)
+    {   // the output dependency offset is the number of dependencies merged by earlier partitions.
+        dep_index += dec.DependencyStart[head[t]] - dec.DependencyStart[ctx->PartitionCut[t]];
+        if (head[t] < tail[t])
+        {
+            PTRACE_MERGE_ENTRY e = { dec.EventTime[head[t]], uint32_t(t) };
+            heap.push_back(e);
+        }
+    }
+    for (size_t i = heap.size() / 2; i-- > 0; )
+    {
+        PtraceMergeSiftDown(heap.data(), heap.size(), i);
+    }
+    while (!heap.empty())
+    {
+        size_t   const         t = heap[0].ThreadIndex;
+        size_t   const src_index = cursor[t]++;
+        uint32_t const dep_begin = dec.DependencyStart[src_index];
+        uint32_t const dep_end   = dec.DependencyStart[src_index + 1];
+        out.EventTime  [out_index] = dec.EventTime  [src_index];
+        out.EventType  [out_index] = dec.EventType  [src_index];
+        out.TaskId     [out_index] = dec.TaskId     [src_index];
+        out.ThreadId   [out_index] = dec.ThreadId   [src_index];
+        out.SourceIndex[out_index] = dec.SourceIndex[src_index];
+        out.ParentId   [out_index] = dec.ParentId   [src_index];
+        out.EntryPoint [out_index] = dec.EntryPoint [src_index];
+        out.DependencyStart[out_index] = dep_index;
+        for (uint32_t d = dep_begin; d < dep_end; ++d)
+        {
+            out.Dependencies[dep_index++] = dec.Dependencies[d];
+        }
+        out_index++;
+
+        if (cursor[t] < tail[t])
+        {   // replace the head with the thread's next event.
+            heap[0].Timestamp = dec.EventTime[cursor[t]];
+        }
+        else
+        {   // the thread's range is exhausted; remove it from the heap.
+            heap[0] = heap.back();
+            heap.pop_back();
+        }
+        PtraceMergeSiftDown(heap.data(), heap.size(), 0);
+    }
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Determine whether a memory buffer contains a .ptrace file.
+/// @param data The start of the file data.
+/// @param size The number of bytes of file data.
+/// @return true if the buffer starts with a .ptrace file header.
+public_function bool
+IsPtraceFile
+(
+    void const *data,
+    size_t      size
+)
+{
+    uint32_t magic = 0;
+    if (size < sizeof(magic)) return false;
+    memcpy(&magic, data, sizeof(magic));
+    return (magic == PTRACE_FILE_MAGIC);
+}
+
+/// @summary Load the contents of a .ptrace file into a profiler events container. The container must be freshly allocated.
+/// @param rtev The profiler events container to populate.
+/// @param data The start of the file data. The data must remain valid for the duration of the call only.
+/// @param size The number of bytes of file data.
+/// @param thread_count The maximum number of threads used to decode and merge events, including the calling thread. Specify 0 to use one thread per processor.
+/// @return true if the file was loaded, or false if the file is malformed.
+public_function bool
+LoadPtraceEvents
+(
+    WIN32_PROFILER_EVENTS *rtev,
+    uint8_t const         *data,
+    size_t                 size,
+    uint32_t       thread_count
+)
+{
+    // fields added by later minor versions are zero if the file's header doesn't include them.
+    PTRACE_FILE_HEADER   hdr;
+    size_t const min_hdr_size = offsetof(PTRACE_FILE_HEADER, TaskSampleRate);
+    if (size < min_hdr_size) return false;
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(&hdr, data, min_hdr_size);
+    if (hdr.Magic != PTRACE_FILE_MAGIC || hdr.VersionMajor != PTRACE_VERSION_MAJOR || hdr.HeaderSize < min_hdr_size || hdr.HeaderSize > size || hdr.ClockFrequency == 0)
+    {   // not a .ptrace file, or written by an incompatible version of the profiler.
+        return false;
+    }
+    memcpy(&hdr, data, hdr.HeaderSize < sizeof(hdr) ? hdr.HeaderSize : sizeof(hdr));
+    if (thread_count == 0)
+    {   // use all available processors.
+        thread_count = PlatformProcessorCount();
+    }
+
+    std::vector<PTRACE_LOADER_THREAD> threads;
+    std::vector<PTRACE_LOADER_BLOCK>   blocks;
+    WIN32_SCHEDULER_INFO           &sched = rtev->Scheduler;
+    std::vector<PTRACE_CLOCK_SYNC>   sync;
+    std::vector<size_t>       zone_blocks;
+    std::vector<size_t>    counter_blocks;
+    std::vector<size_t>      alloc_blocks;
+    PTRACE_CLOCK_MAP                clock;
+    size_t                        segment = 0;
+    uint64_t                      last_ns = 0;
+    size_t                    total_count = 0;
+    size_t                         offset = hdr.HeaderSize;
+
+    sched.ComputePoolSize = hdr.ComputePoolSize;
+    sched.GeneralPoolSize = hdr.GeneralPoolSize;
+    sched.WorkerCount     = 0;
+    sched.SourceCount     = 0;
+    rtev->DroppedEventCount = 0;
+    rtev->TaskSampleRate    = hdr.TaskSampleRate > 1 ? hdr.TaskSampleRate : 1;
+    InitZoneEventList(&rtev->ZoneEvents);
+    InitTaskCounterList(&rtev->TaskCounters);
+
+    // pass 1: validate block headers, count events and read registrations.
+    while (offset + sizeof(PTRACE_BLOCK_HEADER) <= size)
+    {
+        PTRACE_BLOCK_HEADER blk;
+        memcpy(&blk, data + offset, sizeof(blk));
+        if (blk.Magic != PTRACE_BLOCK_MAGIC || blk.DataSize > size - offset - sizeof(blk))
+        {   // the file is corrupt or was truncated mid-block; keep what was read so far.
+            break;
+        }
+        uint8_t const *block_data = data + offset + sizeof(blk);
+        switch (blk.BlockType)
+        {
+            case PTRACE_BLOCK_TYPE_EVENTS:
+                {   // every event encodes to at least two bytes, which bounds the output size for corrupt headers.
+                    if (blk.EventCount > blk.DataSize / 2) break;
+                    size_t const         t = PtraceFindOrCreateThread(threads, blk.ThreadId);
+                    PTRACE_LOADER_BLOCK  b;
+                    b.Offset          = offset;
+                    b.ThreadIndex     = uint32_t(t);
+                    b.DecodedCount    = 0;
+                    b.EventStart      = 0;
+                    b.DependencyStart = 0;
+                    b.LastTime        = 0;
+                    threads[t].BlockList.push_back(uint32_t(blocks.size()));
+                    threads[t].EventCount   += blk.EventCount;
+                    blocks.push_back(b);
+                    total_count             += blk.EventCount;
+                    rtev->DroppedEventCount += blk.DroppedCount;
+                } break;
+            case PTRACE_BLOCK_TYPE_WORKER:
+                {
+                    for (size_t i = 0, n = blk.DataSize / sizeof(PTRACE_WORKER_INFO); i < n; ++i)
+                    {
+                        PTRACE_WORKER_INFO info;
+                        memcpy(&info, block_data + (i * sizeof(info)), sizeof(info));
+                        sched.WorkerThreadId.push_back(info.ThreadId);
+                        sched.WorkerPoolId.push_back(info.PoolId);
+                        sched.WorkerPoolIndex.push_back(info.PoolIndex);
+                        sched.WorkerCount++;
+                    }
+                } break;
+            case PTRACE_BLOCK_TYPE_TASK_SOURCE:
+                {
+                    PTRACE_SOURCE_INFO info;
+                    if (blk.DataSize < sizeof(info)) break;
+                    memcpy(&info, block_data, sizeof(info));
+                    if (info.NameLength > blk.DataSize - sizeof(info)) break;
+                    sched.SourceIndex.push_back(info.SourceIndex);
+                    sched.SourceThreadId.push_back(info.ThreadId);
+                    sched.SourceName.push_back(std::string((char const*)(block_data + sizeof(info)), info.NameLength));
+                    sched.SourceCount++;
+                } break;
+            case PTRACE_BLOCK_TYPE_CLOCK_SYNC:
+                {
+                    for (size_t i = 0, n = blk.DataSize / sizeof(PTRACE_CLOCK_SYNC); i < n; ++i)
+                    {
+                        PTRACE_CLOCK_SYNC info;
+                        memcpy(&info, block_data + (i * sizeof(info)), sizeof(info));
+                        sync.push_back(info);
+                    }
+                } break;
+            case PTRACE_BLOCK_TYPE_ZONE_SITE:
+                {
+                    PTRACE_ZONE_SITE_INFO info;
+                    if (blk.DataSize < sizeof(info)) break;
+                    memcpy(&info, block_data, sizeof(info));
+                    char const *name = (char const*)(block_data + sizeof(info));
+                    size_t const len = size_t(info.NameLength) + size_t(info.FileLength) + size_t(info.FunctionLength);
+                    if (info.SiteId == 0 || info.SiteId > 0xFFFF || len > blk.DataSize - sizeof(info)) break;
+                    SetZoneSite(&rtev->ZoneEvents, info.SiteId,
+                        std::string(name, info.NameLength),
+                        std::string(name + info.NameLength, info.FileLength),
+                        std::string(name + info.NameLength + info.FileLength, info.FunctionLength),
+                        info.Line);
+                } break;
+            case PTRACE_BLOCK_TYPE_ZONES:
+                {   // decoded once the clock map is known. zone events encode to at least two bytes.
+                    if (blk.EventCount > blk.DataSize / 2) break;
+                    zone_blocks.push_back(offset);
+                } break;
+            case PTRACE_BLOCK_TYPE_TASK_COUNTERS:
+                {   // decoded once the clock map is known. counter records encode to at least three bytes.
+                    if (blk.EventCount > blk.DataSize / 3) break;
+                    counter_blocks.push_back(offset);
+                } break;
+            case PTRACE_BLOCK_TYPE_TASK_ALLOCS:
+            case PTRACE_BLOCK_TYPE_TASK_HEAP:
+                {   // decoded once the task table is built. allocation records encode to at least four bytes.
+                    if (blk.EventCount > blk.DataSize / 4) break;
+                    alloc_blocks.push_back(offset);
+                } break;
+            default:
+                break; // skip block types added by later minor versions.
+        }
+        offset += sizeof(blk) + blk.DataSize;
+    }
+
+    // convert timestamps using the calibration samples if there are any.
+    PtraceBuildClockMap(&clock, sync, hdr.ClockFrequency);
+    uint64_t const start_ns = PtraceClockToNanoseconds(&clock, hdr.StartTime, segment);
+    last_ns = start_ns;
+
+    // zone blocks are decoded serially in file order, which keeps the events of each thread in order.
+    for (size_t i = 0, n = zone_blocks.size(); i < n; ++i)
+    {
+        PTRACE_BLOCK_HEADER blk;
+        PTRACE_CODEC_STATE  codec;
+        PTRACE_ZONE_EVENT    zone;
+        memcpy(&blk, data + zone_blocks[i], sizeof(blk));
+        uint8_t const *src = data + zone_blocks[i] + sizeof(blk);
+        uint8_t const *end = src + blk.DataSize;
+        PtraceResetCodecState(&codec, blk.FirstTime);
+        for (uint32_t j = 0; j < blk.EventCount; ++j)
+        {
+            if ((src = PtraceDecodeZoneEvent(src, end, &codec, &zone)) == NULL)
+            {   // the block is corrupt; skip the remainder of it.
+                break;
+            }
+            uint8_t const type = zone.IsEnd ? WIN32_ZONE_EVENT_END : WIN32_ZONE_EVENT_BEGIN;
+            AppendZoneEvent(&rtev->ZoneEvents, type, PtraceClockToNanoseconds(&clock, zone.Timestamp, segment), blk.ThreadId, zone.SiteId);
+        }
+    }
+    for (size_t i = 0, n = counter_blocks.size(); i < n; ++i)
+    {
+        PTRACE_BLOCK_HEADER  blk;
+        PTRACE_CODEC_STATE   codec;
+        PTRACE_TASK_COUNTERS ctr;
+        memcpy(&blk, data + counter_blocks[i], sizeof(blk));
+        uint8_t const *src = data + counter_blocks[i] + sizeof(blk);
+        uint8_t const *end = src + blk.DataSize;
+        PtraceResetCodecState(&codec, blk.FirstTime);
+        for (uint32_t j = 0; j < blk.EventCount; ++j)
+        {
+            if ((src = PtraceDecodeTaskCounters(src, end, &codec, &ctr)) == NULL)
+            {   // the block is corrupt; skip the remainder of it.
+                break;
+            }
+            AppendTaskCounters(&rtev->TaskCounters, PtraceClockToNanoseconds(&clock, ctr.Timestamp, segment), ctr.TaskId, blk.ThreadId, ctr.CounterMask, ctr.Values);
+        }
+    }
+
+    // lay the decoded columns out thread-major, with each thread's blocks in
+    // file order, so that every thread's events form a contiguous sorted range.
+    size_t const nt = threads.size();
+    size_t event_start = 0;
+    for (size_t t = 0; t < nt; ++t)
+    {
+        PTRACE_LOADER_THREAD &thread = threads[t];
+        thread.EventStart = event_start;
+        for (size_t i = 0, n = thread.BlockList.size(); i < n; ++i)
+        {
+            PTRACE_BLOCK_HEADER  blk;
+            PTRACE_LOADER_BLOCK &b = blocks[thread.BlockList[i]];
+            memcpy(&blk, data + b.Offset, sizeof(blk));
+            b.EventStart = event_start;
+            event_start += blk.EventCount;
+        }
+    }
+
+    // pass 2: decode all event blocks in parallel. blocks are independent
+    // because the codec state is reset at the start of each one.
+    WIN32_TASK_EVENT_LIST  decoded;
+    PTRACE_LOADER_CONTEXT  ctx;
+    PtraceResizeEventList(&decoded, total_count, 0);
+    ctx.FileData       = data;
+    ctx.Clock          =&clock;
+    ctx.ThreadCount    = nt;
+    ctx.Threads        = threads.empty() ? NULL : &threads[0];
+    ctx.Blocks         = blocks.empty()  ? NULL : &blocks[0];
+    ctx.PartitionCut   = NULL;
+    ctx.PartitionStart = NULL;
+    ctx.Decoded        =&decoded;
+    ctx.Output         =&rtev->TaskEvents;
+    PlatformParallelFor(thread_count, blocks.size(), PtraceDecodeBlockJob, &ctx);
+
+    // close any gaps left by corrupt blocks, and assign each block its
+    // range of the dependency column. this is a short walk over the blocks.
+    size_t dec_count = 0;
+    size_t dep_count = 0;
+    for (size_t t = 0; t < nt; ++t)
+    {
+        PTRACE_LOADER_THREAD &thread = threads[t];
+        thread.EventStart = dec_count;
+        for (size_t i = 0, n = thread.BlockList.size(); i < n; ++i)
+        {
+            PTRACE_LOADER_BLOCK &b = blocks[thread.BlockList[i]];
+            if (b.EventStart != dec_count)
+            {
+                PtraceMoveEvents(&decoded, dec_count, b.EventStart, b.DecodedCount);
+                b.EventStart = dec_count;
+            }
+            if (b.DecodedCount > 0 && b.LastTime > last_ns)
+            {
+                last_ns = b.LastTime;
+            }
+            b.DependencyStart = dep_count;
+            dec_count += b.DecodedCount;
+            dep_count += b.Dependencies.size();
+        }
+        thread.EventCount = dec_count - thread.EventStart;
+    }
+    PtraceResizeEventList(&decoded, dec_count, dep_count);
+    decoded.DependencyStart[dec_count] = uint32_t(dep_count);
+    PlatformParallelFor(thread_count, blocks.size(), PtraceRebaseBlockJob, &ctx);
+    blocks.clear();
+
+    // choose partition boundaries from a sorted sample of event timestamps.
+    // every thread's range is cut at its first event at or after each
+    // boundary, so events with equal timestamps are never split up.
+    size_t partition_count = size_t(thread_count) * PTRACE_LOADER_PARTITIONS_PER_THREAD;
+    if (partition_count > dec_count / PTRACE_LOADER_MIN_PARTITION_SIZE)
+        partition_count = dec_count / PTRACE_LOADER_MIN_PARTITION_SIZE;
+    if (partition_count == 0 || thread_count <= 1)
+        partition_count = 1;
+
+    std::vector<uint64_t> sample;
+    std::vector<size_t>   cut((partition_count + 1) * nt);
+    std::vector<size_t>   partition_start(partition_count);
+    if (partition_count > 1)
+    {
+        size_t const stride = (dec_count / (partition_count * PTRACE_LOADER_SAMPLES_PER_PARTITION)) + 1;
+        sample.reserve((dec_count / stride) + nt);
+        for (size_t t = 0; t < nt; ++t)
+        {
+            for (size_t i = 0; i < threads[t].EventCount; i += stride)
+            {
+                sample.push_back(decoded.EventTime[threads[t].EventStart + i]);
+            }
+        }
+        std::sort(sample.begin(), sample.end());
+    }
+    for (size_t t = 0; t < nt; ++t)
+    {
+        uint64_t const *begin = decoded.EventTime.data() + threads[t].EventStart;
+        uint64_t const *end   = begin + threads[t].EventCount;
+        cut[t] = threads[t].EventStart;
+        cut[(partition_count * nt) + t] = threads[t].EventStart + threads[t].EventCount;
+        for (size_t p = 1; p < partition_count; ++p)
+        {
+            uint64_t const bound = sample[(p * sample.size()) / partition_count];
+            cut[(p * nt) + t] = size_t(std::lower_bound(begin, end, bound) - decoded.EventTime.data());
+        }
+    }
+    for (size_t p = 0; p < partition_count; ++p)
+    {
+        size_t start = 0;
+        for (size_t t = 0; t < nt; ++t)
+        {
+            start += cut[(p * nt) + t] - cut[t];
+        }
+        partition_start[p] = start;
+    }
+
+    // merge the per-thread streams into the time-ordered output log.
+    PtraceResizeEventList(&rtev->TaskEvents, dec_count, dep_count);
+    rtev->TaskEvents.DependencyStart[dec_count] = uint32_t(dep_count);
+    ctx.PartitionCut   = cut.data();
+    ctx.PartitionStart = partition_start.data();
+    PlatformParallelFor(thread_count, partition_count, PtraceMergePartitionJob, &ctx);
+    BuildTaskTable(&rtev->TaskTable, &rtev->TaskEvents);
+    for (size_t i = 0, n = alloc_blocks.size(); i < n; ++i)
+    {   // charge each task's allocations to its row.
+        PTRACE_BLOCK_HEADER blk;
+        PTRACE_CODEC_STATE  codec;
+        PTRACE_TASK_ALLOCS  allocs;
+        memcpy(&blk, data + alloc_blocks[i], sizeof(blk));
+        uint8_t const *src = data + alloc_blocks[i] + sizeof(blk);
+        uint8_t const *end = src + blk.DataSize;
+        PtraceResetCodecState(&codec, blk.FirstTime);
+        for (uint32_t j = 0; j < blk.EventCount; ++j)
+        {
+            if ((src = PtraceDecodeTaskAllocs(src, end, &codec, blk.BlockType, &allocs)) == NULL)
+            {   // the block is corrupt; skip the remainder of it.
+                break;
+            }
+            TaskTableAddAllocations(&rtev->TaskTable, PtraceClockToNanoseconds(&clock, allocs.Timestamp, segment), allocs.TaskId, allocs.AllocCount, allocs.AllocBytes, allocs.FreeBytes);
+        }
+    }
+
+    // the native backend traces a single process, so build a one-entry process list.
+    WIN32_PROCESS_LIST &plist = rtev->ProcessList;
+    WIN32_PROCESS_INFO  pinfo;
+    WIN32_LIFETIME      plife;
+    InitObjectLifetime(plife, start_ns, last_ns);
+    pinfo.ProcessId   = hdr.ProcessId;
+    pinfo.Reserved    = 0;
+    pinfo.Executable  = NULL;
+    pinfo.ThreadCount = nt;
+    pinfo.ImageCount  = 0;
+    InitObjectIndex(pinfo.ThreadIndex);
+    InitObjectIndex(pinfo.ImageAddressIndex);
+    InitObjectIndex(pinfo.ImagePathIndex);
+    for (size_t t = 0; t < nt; ++t)
+    {
+        PTRACE_LOADER_THREAD const &thread = threads[t];
+        WIN32_THREAD_INFO           tinfo  = {};
+        WIN32_LIFETIME              tlife;
+        if (thread.EventCount == 0) InitObjectLifetime(tlife, plife.CreateTime, last_ns);
+        else InitObjectLifetime(tlife, decoded.EventTime[thread.EventStart], decoded.EventTime[thread.EventStart + thread.EventCount - 1]);
+        tinfo.ThreadId = thread.ThreadId;
+        ObjectIndexInsert(pinfo.ThreadIndex, thread.ThreadId, t);
+        pinfo.ThreadId.push_back(thread.ThreadId);
+        pinfo.ThreadLifetime.push_back(tlife);
+        pinfo.ThreadInfo.push_back(tinfo);
+    }
+    plist.ProcessId.push_back(hdr.ProcessId);
+    plist.ProcessNameId.push_back(WIN32_STRING_ID_NONE);
+    plist.ProcessLifetime.push_back(plife);
+    plist.ProcessInfo.push_back(pinfo);
+    plist.ProcessCount = 1;
+    InitObjectIndex(plist.ProcessIndex);
+    ObjectIndexInsert(plist.ProcessIndex, hdr.ProcessId, 0);
+
+    rtev->ClockFrequency.QuadPart = int64_t(hdr.ClockFrequency);
+    rtev->ClockScale              = TimestampScale(hdr.ClockFrequency, 1000000000ULL);
+    return true;
+}
@@ -0,0 +1,291 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implement the reconstruction of the ready-task backlog. A task is
+/// queued from its ready-to-run transition until a worker launches it. The
+/// ready and launch columns of the task table are already sorted by time, so
+/// a single merge of the two yields every change in depth in order; each
+/// change is applied to the total, to the series of the task source that made
+/// the task ready, and to the series of the pool whose worker launched it.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*//////////////////////////
+//   Internal Functions   //
+//////////////////////////*/
+/// @summary Record a change in the depth of one series. A change at the same time as the previous step replaces it, and a step that
+/// leaves the depth unchanged is dropped, so each series lists only the times at which its depth actually changed.
+/// @param qd The queue depth analysis being built. StepTime and StepDepth must have room for the step.
+/// @param cursor The index at which the next step of the series is written. Updated on return.
+/// @param series The index of the series.
+/// @param depth The depth of the series before the change. Updated on return.
+/// @param delta +1 if a task was queued, or -1 if a task was launched.
+/// @param time The time of the change, in nanoseconds.
+internal_function void
+QueueDepthStep
+(
+    WIN32_QUEUE_DEPTH *qd,
+    size_t        &cursor,
+    size_t         series,
+    uint32_t       &depth,
+    int             delta,
+    uint64_t         time
+)
+{
+    size_t const first = qd->SeriesStart[series];
+    depth = uint32_t(int64_t(depth) + delta);
+    if (cursor > first && qd->StepTime[cursor - 1] == time)
+    {   // the previous step lasted no time at all.
+        cursor--;
+    }
+    if (cursor > first && qd->StepDepth[cursor - 1] == depth)
+        return;
+    qd->StepTime [cursor] = time;
+    qd->StepDepth[cursor] = depth;
+    cursor++;
+    if (depth > qd->SeriesMaxDepth[series])
+    {
+        qd->SeriesMaxDepth[series] = depth;
+        qd->SeriesMaxTime [series] = time;
+    }
+}
+
+/// @summary Add a key to a sorted list of distinct keys. The lists are short, such as the task sources or pools of a trace, and most keys are already present.
+/// @param keys The sorted list of distinct keys.
+/// @param key The key to add.
+internal_function inline void
+SortedKeyInsert
+(
+    std::vector<uint32_t> &keys,
+    uint32_t                key
+)
+{
+    std::vector<uint32_t>::iterator k = std::lower_bound(keys.begin(), keys.end(), key);
+    if (k == keys.end() || *k != key) keys.insert(k, key);
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Free the memory used by a queue depth analysis. The analysis is left empty.
+/// @param qd The analysis to delete.
+public_function void
+DeleteQueueDepth
+(
+    WIN32_QUEUE_DEPTH *qd
+)
+{
+    qd->EndTime      = 0;
+    qd->TaskCount    = 0;
+    qd->PendingCount = 0;
+    qd->SeriesCount  = 0;
+    WIN32_COLUMN<uint32_t>().swap(qd->SeriesKind);
+    WIN32_COLUMN<uint32_t>().swap(qd->SeriesKey);
+    WIN32_COLUMN<size_t  >().swap(qd->SeriesStart);
+    WIN32_COLUMN<uint64_t>().swap(qd->StepTime);
+    WIN32_COLUMN<uint32_t>().swap(qd->StepDepth);
+    WIN32_COLUMN<uint32_t>().swap(qd->SeriesMaxDepth);
+    WIN32_COLUMN<uint64_t>().swap(qd->SeriesMaxTime);
+    std::vector<WIN32_LATENCY_HISTOGRAM>().swap(qd->SeriesDelay);
+    std::vector<WIN32_STEP_PYRAMID>().swap(qd->SeriesLod);
+}
+
+/// @summary Reconstruct the backlog of ready tasks over time, for the whole trace, for each task source and for each pool.
+/// Tasks whose launch was recorded before their ready-to-run transition are ignored. At equal times, launches are applied before
+/// ready-to-run transitions, so a worker picking up one task as another is queued does not raise the depth.
+/// @param qd The analysis to build. Any existing contents are replaced.
+/// @param task_table The task table, with complete ready and launch columns.
+/// @param scheduler The task scheduler configuration, used to assign launching workers to pools.
+/// @param base_time The BaseTime of the series pyramids, typically WIN32_TIMELINE_LOD::FirstTime. Earlier steps are clipped in the pyramids only.
+/// @param base_shift The BaseShift of the series pyramids, typically WIN32_TIMELINE_LOD::BaseShift.
+public_function void
+BuildQueueDepth
+(
+    WIN32_QUEUE_DEPTH              *qd,
+    WIN32_TASK_TABLE const *task_table,
+    WIN32_SCHEDULER_INFO const *scheduler,
+    uint64_t                  base_time,
+    uint32_t                 base_shift
+)
+{
+    size_t const                                task_count = task_table->TaskCount;
+    std::vector<std::pair<uint32_t, uint32_t> > worker_pool(scheduler->WorkerCount);
+    std::vector<uint32_t>                       sources;
+    std::vector<uint32_t>                       pools;
+    std::vector<uint32_t>                       row_source(task_count, WIN32_OBJECT_INDEX_EMPTY);
+    std::vector<uint32_t>                       row_pool(task_count, WIN32_OBJECT_INDEX_EMPTY);
+    std::vector<uint8_t>                        row_state(task_count, 0);
+    std::vector<size_t>                         cursor;
+    std::vector<uint32_t>                       depth;
+
+    DeleteQueueDepth(qd);
+    for (size_t i = 0; i < scheduler->WorkerCount; ++i)
+    {
+        worker_pool[i] = std::make_pair(scheduler->WorkerThreadId[i], scheduler->WorkerPoolId[i]);
+    }
+    std::sort(worker_pool.begin(), worker_pool.end());
+
+    // find the source and pool of every task that was observed becoming ready.
+    for (size_t r = 0; r < task_count; ++r)
+    {
+        uint64_t const ready  = task_table->ReadyTime [r];
+        uint64_t const launch = task_table->LaunchTime[r];
+        if (ready == 0 || (launch != 0 && launch < ready))
+            continue;
+        uint32_t pool = uint32_t(WIN32_QUEUE_DEPTH_NO_POOL);
+        if (launch != 0)
+        {
+            uint32_t const tid = task_table->WorkerThreadId[r];
+            std::vector<std::pair<uint32_t, uint32_t> >::const_iterator w = std::lower_bound(worker_pool.begin(), worker_pool.end(), std::make_pair(tid, uint32_t(0)));
+            if (w != worker_pool.end() && w->first == tid) pool = w->second;
+        }
+        else qd->PendingCount++;
+        row_source[r] = task_table->SourceIndex[r];
+        row_pool  [r] = pool;
+        SortedKeyInsert(sources, row_source[r]);
+        SortedKeyInsert(pools  , pool);
+        qd->TaskCount++;
+    }
+
+    // series 0 is the total, followed by the sources and then the pools. replace keys with series indices.
+    qd->SeriesCount = 1 + sources.size() + pools.size();
+    qd->SeriesKind.resize(qd->SeriesCount);
+    qd->SeriesKey.resize(qd->SeriesCount);
+    qd->SeriesKind[0] = WIN32_QUEUE_SERIES_TOTAL;
+    qd->SeriesKey [0] = 0;
+    for (size_t i = 0; i < sources.size(); ++i)
+    {
+        qd->SeriesKind[1 + i] = WIN32_QUEUE_SERIES_SOURCE;
+        qd->SeriesKey [1 + i] = sources[i];
+    }
+    for (size_t i = 0; i < pools.size(); ++i)
+    {
+        qd->SeriesKind[1 + sources.size() + i] = WIN32_QUEUE_SERIES_POOL;
+        qd->SeriesKey [1 + sources.size() + i] = pools[i];
+    }
+
+    // each queued task adds at most two steps to each of its three series; reserve that many and compact afterwards.
+    qd->SeriesStart.assign(qd->SeriesCount + 1, 0);
+    qd->SeriesDelay.resize(qd->SeriesCount);
+    for (size_t r = 0; r < task_count; ++r)
+    {
+        if (row_source[r] == WIN32_OBJECT_INDEX_EMPTY)
+            continue;
+        size_t   const s     = 1 + size_t(std::lower_bound(sources.begin(), sources.end(), row_source[r]) - sources.begin());
+        size_t   const p     = 1 + sources.size() + size_t(std::lower_bound(pools.begin(), pools.end(), row_pool[r]) - pools.begin());
+        uint64_t const ready = task_table->ReadyTime [r];
+        uint64_t const start = task_table->LaunchTime[r];
+        size_t   const n     = (start == 0) ? 1 : 2;
+        if (start != 0)
+        {   // every task has one source, so the total is merged from the sources afterwards.
+            LatencyHistogramAdd(&qd->SeriesDelay[s], start - ready);
+            LatencyHistogramAdd(&qd->SeriesDelay[p], start - ready);
+        }
+        if (start == ready)
+        {   // a task launched as soon as it was ready was never queued.
+            row_source[r] = WIN32_OBJECT_INDEX_EMPTY;
+            continue;
+        }
+        row_source[r] = uint32_t(s);
+        row_pool  [r] = uint32_t(p);
+        qd->SeriesStart[1]     += n;
+        qd->SeriesStart[s + 1] += n;
+        qd->SeriesStart[p + 1] += n;
+    }
+    for (size_t i = 0; i < sources.size(); ++i)
+    {
+        MergeLatencyHistogram(&qd->SeriesDelay[0], &qd->SeriesDelay[1 + i]);
+    }
+    for (size_t i = 0; i < qd->SeriesCount; ++i)
+    {
+        qd->SeriesStart[i + 1] += qd->SeriesStart[i];
+    }
+    qd->StepTime.resize(qd->SeriesStart[qd->SeriesCount]);
+    qd->StepDepth.resize(qd->SeriesStart[qd->SeriesCount]);
+    qd->SeriesMaxDepth.assign(qd->SeriesCount, 0);
+    qd->SeriesMaxTime.assign(qd->SeriesCount, 0);
+    cursor.assign(qd->SeriesStart.begin(), qd->SeriesStart.end() - 1);
+    depth.assign(qd->SeriesCount, 0);
+
+    // merge the time-sorted ready and launch columns. a row may have several ready events; only its last counts.
+    WIN32_COLUMN<uint64_t> const &ready_time  = task_table->ReadySortedTime;
+    WIN32_COLUMN<uint32_t> const &ready_row   = task_table->ReadySortedRow;
+    WIN32_COLUMN<uint64_t> const &launch_time = task_table->LaunchSortedTime;
+    WIN32_COLUMN<uint32_t> const &launch_row  = task_table->LaunchSortedRow;
+    size_t const ready_count  = ready_time.size();
+    size_t const launch_count = launch_time.size();
+    size_t       ri = 0;
+    size_t       li = 0;
+    while (ri < ready_count || li < launch_count)
+    {
+        uint32_t row;
+        uint64_t time;
+        int      delta;
+        if (li < launch_count && (ri == ready_count || launch_time[li] <= ready_time[ri]))
+        {
+            row   = launch_row [li];
+            time  = launch_time[li++];
+            if (row_source[row] == WIN32_OBJECT_INDEX_EMPTY || row_state[row] != 1 || time != task_table->LaunchTime[row])
+                continue;
+            delta = -1;
+            row_state[row] = 2;
+        }
+        else
+        {
+            row   = ready_row [ri];
+            time  = ready_time[ri++];
+            if (row_source[row] == WIN32_OBJECT_INDEX_EMPTY || row_state[row] != 0 || time != task_table->ReadyTime[row])
+                continue;
+            delta = +1;
+            row_state[row] = 1;
+        }
+        QueueDepthStep(qd, cursor[0], 0, depth[0], delta, time);
+        QueueDepthStep(qd, cursor[row_source[row]], row_source[row], depth[row_source[row]], delta, time);
+        QueueDepthStep(qd, cursor[row_pool  [row]], row_pool  [row], depth[row_pool  [row]], delta, time);
+    }
+
+    // move each series down over the unused space reserved for the series before it.
+    size_t out = 0;
+    for (size_t i = 0; i < qd->SeriesCount; ++i)
+    {
+        size_t const first = qd->SeriesStart[i];
+        size_t const last  = cursor[i];
+        qd->SeriesStart[i] = out;
+        for (size_t j = first; j < last; ++j, ++out)
+        {
+            qd->StepTime [out] = qd->StepTime [j];
+            qd->StepDepth[out] = qd->StepDepth[j];
+        }
+    }
+    qd->SeriesStart[qd->SeriesCount] = out;
+    qd->StepTime.resize(out);
+    qd->StepDepth.resize(out);
+
+    if (!task_table->ReadySortedTime.empty()  && task_table->ReadySortedTime.back()  > qd->EndTime) qd->EndTime = task_table->ReadySortedTime.back();
+    if (!task_table->LaunchSortedTime.empty() && task_table->LaunchSortedTime.back() > qd->EndTime) qd->EndTime = task_table->LaunchSortedTime.back();
+    if (!task_table->FinishSortedTime.empty() && task_table->FinishSortedTime.back() > qd->EndTime) qd->EndTime = task_table->FinishSortedTime.back();
+    qd->SeriesLod.resize(qd->SeriesCount);
+    for (size_t i = 0; i < qd->SeriesCount; ++i)
+    {
+        size_t const first = qd->SeriesStart[i];
+        size_t const n     = qd->SeriesStart[i + 1] - first;
+        if (n > 0) BuildStepPyramid(&qd->SeriesLod[i], &qd->StepTime[first], &qd->StepDepth[first], n, qd->EndTime, base_time, base_shift);
+        else       BuildStepPyramid(&qd->SeriesLod[i], NULL, NULL, 0, qd->EndTime, base_time, base_shift);
+    }
+}
+
+/// @summary Find the depth of one series at a given time.
+/// @param qd The queue depth analysis to search.
+/// @param series The index of the series.
+/// @param time The time to look up, in nanoseconds.
+/// @return The number of tasks queued in the series at that time.
+public_function uint32_t
+QueueDepthAtTime
+(
+    WIN32_QUEUE_DEPTH const *qd,
+    size_t               series,
+    uint64_t               time
+)
+{
+    WIN32_COLUMN<uint64_t>::const_iterator first = qd->StepTime.begin() + qd->SeriesStart[series];
+    WIN32_COLUMN<uint64_t>::const_iterator last  = qd->StepTime.begin() + qd->SeriesStart[series + 1];
+    size_t const i = size_t(std::upper_bound(first, last, time) - qd->StepTime.begin());
+    return (i > qd->SeriesStart[series]) ? qd->StepDepth[i - 1] : 0;
+}
@@ -0,0 +1,536 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implement a discrete-event replay of the task dependency graph on
+/// a simulated scheduler. A task becomes ready once its dependencies have
+/// finished and it has been defined: either its parent has run up to the
+/// point where it defined the task, or, for tasks submitted from outside the
+/// graph, the observed definition time has been reached. Ready tasks are
+/// handed to idle workers according to the scheduling policy, and run for
+/// their observed execution time.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////////
+//   Preprocessor   //
+////////////////////*/
+/// @summary Define the maximum number of workers that can be simulated.
+#ifndef WIN32_SCHEDULER_REPLAY_MAX_WORKERS
+#define WIN32_SCHEDULER_REPLAY_MAX_WORKERS     4096
+#endif
+
+/// @summary Define the worker value of a task submitted from outside the task graph.
+#ifndef WIN32_SCHEDULER_REPLAY_EXTERNAL
+#define WIN32_SCHEDULER_REPLAY_EXTERNAL        0xFFFFFFFFUL
+#endif
+
+/*//////////////////
+//   Data Types   //
+//////////////////*/
+/// @summary Define the kinds of events processed by the scheduler replay.
+enum SCHEDULER_REPLAY_EVENT_KIND : uint32_t
+{
+    SCHEDULER_REPLAY_EVENT_FINISH        = 0,               /// A task finished executing on a worker.
+    SCHEDULER_REPLAY_EVENT_SPAWN         = 1,               /// A running parent task reached the point at which it defined a child task.
+};
+
+/// @summary Define a single pending event in the scheduler replay event queue.
+struct SCHEDULER_REPLAY_EVENT
+{
+    uint64_t                    Time;             /// The simulated time of the event, in nanoseconds.
+    uint32_t                    Row;              /// The task table row that finished, or the child task table row that was defined.
+    uint32_t                    Worker;           /// The worker that executed the finished task, or the parent task.
+    uint32_t                    Kind;             /// One of SCHEDULER_REPLAY_EVENT_KIND.
+};
+
+/// @summary Define the parts of the replay input that depend only on the task table, so they can be shared by many replays.
+struct SCHEDULER_REPLAY_GRAPH
+{
+    uint64_t                    BaseTime;         /// The earliest observed task definition or launch, in nanoseconds. Replay time zero.
+    uint64_t                    LastSeen;         /// The latest observed task finish, in nanoseconds.
+    std::vector<uint32_t>       ChildStart;       /// TaskCount+1 offsets into ChildRow. The children of row i are [ChildStart[i], ChildStart[i+1]).
+    std::vector<uint32_t>       ChildRow;         /// The row of each child task, grouped by parent row in ascending order.
+    std::vector<std::pair<uint64_t, uint32_t> > External; /// The replay time and row of each task submitted from outside the graph, in ascending time order.
+};
+
+/// @summary Define the data shared by the jobs of a RankVirtualSpeedups call. Each job replays the graph with one entry point sped up.
+struct VIRTUAL_SPEEDUP_JOBS
+{
+    WIN32_TASK_TABLE const     *Table;            /// The task table being replayed.
+    SCHEDULER_REPLAY_GRAPH const *Graph;          /// The prepared replay input.
+    WIN32_VIRTUAL_SPEEDUP_REPORT *Report;         /// The report whose Entries are filled in, one per job.
+};
+
+/// @summary Define the state of a single scheduler replay.
+struct SCHEDULER_REPLAY_STATE
+{
+    uint32_t                    Policy;           /// One of WIN32_SCHEDULER_POLICY.
+    uint32_t                    WorkerCount;      /// The number of simulated workers.
+    size_t                      ReadyCount;       /// The number of tasks waiting for a worker.
+    std::deque<uint32_t>        Shared;           /// The ready tasks shared by all workers, or submitted from outside the graph when work stealing.
+    std::vector<std::deque<uint32_t> > Local;     /// The ready tasks made ready by each worker, used when work stealing.
+};
+
+/*//////////////////////////
+//   Internal Functions   //
+//////////////////////////*/
+/// @summary Determine whether one replay event should be processed after another. Used as the comparison for a min-heap.
+/// Ties are broken by kind and row so that replays are deterministic.
+/// @param a The first event.
+/// @param b The second event.
+/// @return true if a should be processed after b.
+internal_function inline bool
+ScheduleReplayAfter
+(
+    SCHEDULER_REPLAY_EVENT const &a,
+    SCHEDULER_REPLAY_EVENT const &b
+)
+{
+    if (a.Time != b.Time) return a.Time > b.Time;
+    if (a.Kind != b.Kind) return a.Kind > b.Kind;
+    return a.Row > b.Row;
+}
+
+/// @summary Add a task to the ready queues.
+/// @param state The replay state.
+/// @param row The task table row of the task that became ready.
+/// @param worker The worker whose task made the task ready, or WIN32_SCHEDULER_REPLAY_EXTERNAL.
+internal_function inline void
+ScheduleReplayMakeReady
+(
+    SCHEDULER_REPLAY_STATE *state,
+    uint32_t                  row,
+    uint32_t               worker
+)
+{
+    if (state->Policy == WIN32_SCHEDULER_POLICY_WORK_STEALING && worker != WIN32_SCHEDULER_REPLAY_EXTERNAL)
+        state->Local[worker].push_back(row);
+    else
+        state->Shared.push_back(row);
+    state->ReadyCount++;
+}
+
+/// @summary Remove the next task to run on an idle worker from the ready queues. The caller ensures that ReadyCount is non-zero.
+/// @param state The replay state.
+/// @param worker The idle worker.
+/// @param stolen On return, set to true if the task was taken from another worker.
+/// @return The task table row of the task to run.
+internal_function uint32_t
+ScheduleReplayTake
+(
+    SCHEDULER_REPLAY_STATE *state,
+    uint32_t               worker,
+    bool                  &stolen
+)
+{
+    uint32_t row = 0;
+    stolen = false;
+    state->ReadyCount--;
+    if (state->Policy == WIN32_SCHEDULER_POLICY_LIFO)
+    {
+        row = state->Shared.back();
+        state->Shared.pop_back();
+        return row;
+    }
+    if (state->Policy == WIN32_SCHEDULER_POLICY_FIFO)
+    {
+        row = state->Shared.front();
+        state->Shared.pop_front();
+        return row;
+    }
+    if (!state->Local[worker].empty())
+    {   // the newest task made ready by this worker is the most likely to share its data.
+        row = state->Local[worker].back();
+        state->Local[worker].pop_back();
+        return row;
+    }
+    if (!state->Shared.empty())
+    {   // tasks submitted from outside the graph are taken in submission order.
+        row = state->Shared.front();
+        state->Shared.pop_front();
+        return row;
+    }
+    for (uint32_t i = 1; i < state->WorkerCount; ++i)
+    {   // steal the oldest task of the next worker that has one.
+        uint32_t const victim = (worker + i) % state->WorkerCount;
+        if (!state->Local[victim].empty())
+        {
+            row = state->Local[victim].front();
+            state->Local[victim].pop_front();
+            break;
+        }
+    }
+    stolen = true;
+    return row;
+}
+
+/// @summary Retrieve the execution time of a task in a replay, reduced if the task has the entry point being sped up.
+/// @param table The task table.
+/// @param row The task table row.
+/// @param entry_point The entry point whose tasks are sped up.
+/// @param percent The percentage by which the execution time of those tasks is reduced, or 0.
+/// @return The execution time of the task in the replay, in nanoseconds.
+internal_function inline uint64_t
+ScheduleReplayDuration
+(
+    WIN32_TASK_TABLE const *table,
+    size_t                    row,
+    uint64_t          entry_point,
+    uint32_t              percent
+)
+{
+    uint64_t const duration = CriticalPathDuration(table, row);
+    if (percent == 0 || table->EntryPoint[row] != entry_point)
+        return duration;
+    return duration - (duration * percent) / 100;
+}
+
+/// @summary Compute the parts of the replay input that depend only on the task table.
+/// @param graph The replay input to build.
+/// @param table The task table, with the dependency graph built by BuildTaskDependencyGraph.
+internal_function void
+ScheduleReplayPrepare
+(
+    SCHEDULER_REPLAY_GRAPH *graph,
+    WIN32_TASK_TABLE const *table
+)
+{
+    size_t const task_count = table->TaskCount;
+    graph->BaseTime = ~uint64_t(0);
+    graph->LastSeen = 0;
+    graph->ChildStart.assign(task_count + 1, 0);
+    graph->External.clear();
+    for (size_t r = 0; r < task_count; ++r)
+    {
+        uint64_t const seen = table->DefineTime[r] != 0 ? table->DefineTime[r] : table->LaunchTime[r];
+        if (seen != 0 && seen < graph->BaseTime) graph->BaseTime = seen;
+        if (table->FinishTime[r] > graph->LastSeen) graph->LastSeen = table->FinishTime[r];
+        if (table->ParentRow[r] != WIN32_OBJECT_INDEX_EMPTY)
+            graph->ChildStart[table->ParentRow[r] + 1]++;
+    }
+    if (graph->BaseTime == ~uint64_t(0))
+        graph->BaseTime = 0;
+    for (size_t r = 0; r < task_count; ++r)
+    {
+        graph->ChildStart[r + 1] += graph->ChildStart[r];
+    }
+    graph->ChildRow.resize(graph->ChildStart[task_count]);
+    std::vector<uint32_t> next(graph->ChildStart.begin(), graph->ChildStart.end() - 1);
+    for (size_t r = 0; r < task_count; ++r)
+    {   // group the children of each parent, in ascending row order.
+        uint32_t const parent = table->ParentRow[r];
+        if (parent != WIN32_OBJECT_INDEX_EMPTY)
+        {
+            graph->ChildRow[next[parent]++] = uint32_t(r);
+        }
+        else
+        {   // submitted from outside the graph at the observed time. tasks whose definition was lost are submitted when first seen.
+            uint64_t const seen = table->DefineTime[r] != 0 ? table->DefineTime[r] : table->LaunchTime[r];
+            graph->External.push_back(std::make_pair(seen > graph->BaseTime ? seen - graph->BaseTime : 0, uint32_t(r)));
+        }
+    }
+    std::sort(graph->External.begin(), graph->External.end());
+}
+
+/// @summary Run a single replay of a prepared task graph. The prepared input is not modified, so replays can run concurrently.
+/// @param result On return, the replay parameters and the predicted outcome.
+/// @param graph The replay input returned by ScheduleReplayPrepare.
+/// @param table The task table, with the dependency graph built by BuildTaskDependencyGraph.
+/// @param worker_count The number of simulated workers, clamped to [1, WIN32_SCHEDULER_REPLAY_MAX_WORKERS].
+/// @param policy One of WIN32_SCHEDULER_POLICY.
+/// @param steal_cost The time added to the start of a task taken from another worker, in nanoseconds.
+/// @param entry_point The entry point whose tasks are sped up.
+/// @param percent The percentage by which the execution time of those tasks is reduced, clamped to 100, or 0.
+internal_function void
+ScheduleReplayRun
+(
+    WIN32_SCHEDULER_REPLAY      *result,
+    SCHEDULER_REPLAY_GRAPH const *graph,
+    WIN32_TASK_TABLE const       *table,
+    uint32_t               worker_count,
+    uint32_t                     policy,
+    uint64_t                 steal_cost,
+    uint64_t                entry_point,
+    uint32_t                    percent
+)
+{
+    size_t const task_count = table->TaskCount;
+    if (worker_count < 1) worker_count = 1;
+    if (worker_count > WIN32_SCHEDULER_REPLAY_MAX_WORKERS) worker_count = WIN32_SCHEDULER_REPLAY_MAX_WORKERS;
+    if (policy >= WIN32_SCHEDULER_POLICY_COUNT) policy = WIN32_SCHEDULER_POLICY_FIFO;
+    if (percent > 100) percent = 100;
+    memset(result, 0, sizeof(WIN32_SCHEDULER_REPLAY));
+    result->WorkerCount       = worker_count;
+    result->Policy            = policy;
+    result->StealCost         = steal_cost;
+    result->SpeedupEntryPoint = entry_point;
+    result->SpeedupPercent    = percent;
+    result->ObservedMakespan  = graph->LastSeen > graph->BaseTime ? graph->LastSeen - graph->BaseTime : 0;
+    if (task_count == 0)
+        return;
+
+    // each task waits for its dependencies, plus one definition by its parent or from outside the graph.
+    std::vector<uint32_t> pending(task_count);
+    for (size_t r = 0; r < task_count; ++r)
+    {
+        pending[r] = table->DependencyStart[r + 1] - table->DependencyStart[r] + 1;
+    }
+
+    SCHEDULER_REPLAY_STATE                            state;
+    std::vector<SCHEDULER_REPLAY_EVENT>               heap;
+    std::vector<uint32_t>                             idle;
+    std::vector<std::pair<uint64_t, uint32_t> > const &external = graph->External;
+    size_t                                            ext_index = 0;
+    uint64_t                                          now       = 0;
+    state.Policy      = policy;
+    state.WorkerCount = worker_count;
+    state.ReadyCount  = 0;
+    if (policy == WIN32_SCHEDULER_POLICY_WORK_STEALING)
+        state.Local.resize(worker_count);
+    for (uint32_t w = worker_count; w-- > 0; )
+    {   // worker 0 is taken first.
+        idle.push_back(w);
+    }
+    while (!heap.empty() || ext_index < external.size())
+    {
+        now = heap.empty() ? external[ext_index].first : heap[0].Time;
+        if (ext_index < external.size() && external[ext_index].first < now)
+            now = external[ext_index].first;
+        while (ext_index < external.size() && external[ext_index].first == now)
+        {
+            uint32_t const row = external[ext_index++].second;
+            if (--pending[row] == 0) ScheduleReplayMakeReady(&state, row, WIN32_SCHEDULER_REPLAY_EXTERNAL);
+        }
+        while (!heap.empty() && heap[0].Time == now)
+        {
+            SCHEDULER_REPLAY_EVENT const ev = heap[0];
+            std::pop_heap(heap.begin(), heap.end(), ScheduleReplayAfter);
+            heap.pop_back();
+            if (ev.Kind == SCHEDULER_REPLAY_EVENT_FINISH)
+            {   // the worker becomes idle, and may have made successors ready.
+                for (uint32_t e = table->SuccessorStart[ev.Row], end = table->SuccessorStart[ev.Row + 1]; e < end; ++e)
+                {
+                    uint32_t const succ = table->SuccessorRow[e];
+                    if (--pending[succ] == 0) ScheduleReplayMakeReady(&state, succ, ev.Worker);
+                }
+                idle.push_back(ev.Worker);
+                result->Makespan = now;
+                result->TaskCount++;
+            }
+            else if (--pending[ev.Row] == 0)
+            {   // the parent defined the task, and its dependencies have finished.
+                ScheduleReplayMakeReady(&state, ev.Row, ev.Worker);
+            }
+        }
+        if (state.ReadyCount > result->MaxReadyCount)
+            result->MaxReadyCount = state.ReadyCount;
+        while (state.ReadyCount > 0 && !idle.empty())
+        {   // the most recently idled worker is dispatched first, so it runs the tasks it just made ready.
+            uint32_t const worker   = idle.back();
+            bool           stolen   = false;
+            idle.pop_back();
+            uint32_t const row      = ScheduleReplayTake(&state, worker, stolen);
+            uint64_t const start    = stolen ? now + steal_cost : now;
+            uint64_t const observed = CriticalPathDuration(table, row);
+            uint64_t const duration = ScheduleReplayDuration(table, row, entry_point, percent);
+            SCHEDULER_REPLAY_EVENT finish = { start + duration, row, worker, SCHEDULER_REPLAY_EVENT_FINISH };
+            heap.push_back(finish);
+            std::push_heap(heap.begin(), heap.end(), ScheduleReplayAfter);
+            for (uint32_t c = graph->ChildStart[row], end = graph->ChildStart[row + 1]; c < end; ++c)
+            {   // a sped-up parent reaches each spawn point proportionally sooner.
+                uint32_t const child  = graph->ChildRow[c];
+                uint64_t       offset = CriticalPathSpawnOffset(table, row, child, observed);
+                if (duration != observed) offset = observed > 0 ? uint64_t(double(offset) * double(duration) / double(observed)) : 0;
+                SCHEDULER_REPLAY_EVENT spawn = { start + offset, child, worker, SCHEDULER_REPLAY_EVENT_SPAWN };
+                heap.push_back(spawn);
+                std::push_heap(heap.begin(), heap.end(), ScheduleReplayAfter);
+            }
+            if (stolen) result->StealCount++;
+            result->BusyTime += duration;
+        }
+    }
+    result->Utilization = result->Makespan > 0 ? double(result->BusyTime) / (double(result->Makespan) * double(worker_count)) : 0.0;
+}
+
+/// @summary Implement a single job of a RankVirtualSpeedups call.
+/// @param argp The VIRTUAL_SPEEDUP_JOBS shared by all jobs.
+/// @param job_index The index of the entry in the report to replay.
+internal_function void
+VirtualSpeedupJob
+(
+    void       *argp,
+    size_t  job_index
+)
+{
+    VIRTUAL_SPEEDUP_JOBS         *jobs   = (VIRTUAL_SPEEDUP_JOBS*) argp;
+    WIN32_VIRTUAL_SPEEDUP_REPORT *report = jobs->Report;
+    WIN32_VIRTUAL_SPEEDUP        &entry  = report->Entries[job_index];
+    WIN32_SCHEDULER_REPLAY        replay;
+    ScheduleReplayRun(&replay, jobs->Graph, jobs->Table, report->WorkerCount, report->Policy, report->StealCost, entry.EntryPoint, report->SpeedupPercent);
+    uint64_t const removed = (entry.TaskTime * report->SpeedupPercent) / 100;
+    entry.Makespan       = replay.Makespan;
+    entry.MakespanChange = int64_t(replay.Makespan) - int64_t(report->BaselineMakespan);
+    entry.Efficiency     = removed > 0 ? -double(entry.MakespanChange) / double(removed) : 0.0;
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Replay the task dependency graph on a simulated scheduler with the tasks of one entry point sped up, and predict the makespan and utilization.
+/// The running time is O((T + E) log T) for T tasks and E dependencies, independent of the simulated duration.
+/// @param result On return, the replay parameters and the predicted outcome.
+/// @param table The task table, with the dependency graph built by BuildTaskDependencyGraph.
+/// @param worker_count The number of simulated workers, clamped to [1, WIN32_SCHEDULER_REPLAY_MAX_WORKERS].
+/// @param policy One of WIN32_SCHEDULER_POLICY.
+/// @param steal_cost The time added to the start of a task taken from another worker, in nanoseconds.
+/// @param entry_point The entry point whose tasks are sped up.
+/// @param percent The percentage by which the execution time of those tasks is reduced, or 0 to replay the observed execution times.
+public_function void
+ReplayScheduleWhatIf
+(
+    WIN32_SCHEDULER_REPLAY *result,
+    WIN32_TASK_TABLE const  *table,
+    uint32_t          worker_count,
+    uint32_t                policy,
+    uint64_t            steal_cost,
+    uint64_t           entry_point,
+    uint32_t               percent
+)
+{
+    SCHEDULER_REPLAY_GRAPH graph;
+    if (table->ParentRow.size() != table->TaskCount)
+    {   // the dependency graph hasn't been built.
+        memset(result, 0, sizeof(WIN32_SCHEDULER_REPLAY));
+        return;
+    }
+    ScheduleReplayPrepare(&graph, table);
+    ScheduleReplayRun(result, &graph, table, worker_count, policy, steal_cost, entry_point, percent);
+}
+
+/// @summary Replay the task dependency graph on a simulated scheduler and predict the makespan and utilization.
+/// @param result On return, the replay parameters and the predicted outcome.
+/// @param table The task table, with the dependency graph built by BuildTaskDependencyGraph.
+/// @param worker_count The number of simulated workers, clamped to [1, WIN32_SCHEDULER_REPLAY_MAX_WORKERS].
+/// @param policy One of WIN32_SCHEDULER_POLICY.
+/// @param steal_cost The time added to the start of a task taken from another worker, in nanoseconds.
+public_function void
+ReplaySchedule
+(
+    WIN32_SCHEDULER_REPLAY *result,
+    WIN32_TASK_TABLE const  *table,
+    uint32_t          worker_count,
+    uint32_t                policy,
+    uint64_t            steal_cost
+)
+{
+    ReplayScheduleWhatIf(result, table, worker_count, policy, steal_cost, 0, 0);
+}
+
+/// @summary Rank task entry points by how much speeding up their tasks would shorten the makespan. Each entry point is replayed
+/// separately with the execution time of its tasks reduced, so the ranking reflects the schedule rather than total execution time:
+/// speeding up tasks that never delay their successors changes nothing. Replays of different entry points run in parallel.
+/// @param report The report to build. Any existing contents are replaced.
+/// @param table The task table, with the dependency graph built by BuildTaskDependencyGraph.
+/// @param worker_count The number of simulated workers.
+/// @param policy One of WIN32_SCHEDULER_POLICY.
+/// @param steal_cost The time added to the start of a task taken from another worker, in nanoseconds.
+/// @param percent The percentage by which the execution time of each entry point is reduced, clamped to 100.
+/// @param max_entry_points The maximum number of entry points to replay, chosen by total execution time, or 0 to replay every entry point.
+/// @param thread_count The maximum number of threads to use, including the calling thread, or 0 to use one thread per processor.
+public_function void
+RankVirtualSpeedups
+(
+    WIN32_VIRTUAL_SPEEDUP_REPORT *report,
+    WIN32_TASK_TABLE const        *table,
+    uint32_t                worker_count,
+    uint32_t                      policy,
+    uint64_t                  steal_cost,
+    uint32_t                     percent,
+    size_t              max_entry_points,
+    uint32_t                thread_count
+)
+{
+    SCHEDULER_REPLAY_GRAPH graph;
+    WIN32_SCHEDULER_REPLAY baseline;
+    VIRTUAL_SPEEDUP_JOBS   jobs;
+    size_t const           task_count = table->TaskCount;
+
+    report->Entries.clear();
+    report->EntryCount = 0;
+    if (table->ParentRow.size() != task_count)
+    {   // the dependency graph hasn't been built.
+        report->WorkerCount      = worker_count;
+        report->Policy           = policy;
+        report->StealCost        = steal_cost;
+        report->SpeedupPercent   = percent;
+        report->BaselineMakespan = 0;
+        return;
+    }
+    ScheduleReplayPrepare(&graph, table);
+    ScheduleReplayRun(&baseline, &graph, table, worker_count, policy, steal_cost, 0, 0);
+    report->WorkerCount      = baseline.WorkerCount;
+    report->Policy           = baseline.Policy;
+    report->StealCost        = steal_cost;
+    report->SpeedupPercent   = percent > 100 ? 100 : percent;
+    report->BaselineMakespan = baseline.Makespan;
+
+    // total the execution time of each entry point, and keep those that take the most time.
+    std::vector<std::pair<uint64_t, uint64_t> > rows(task_count);
+    for (size_t r = 0; r < task_count; ++r)
+    {
+        rows[r] = std::make_pair(table->EntryPoint[r], CriticalPathDuration(table, r));
+    }
+    std::sort(rows.begin(), rows.end());
+    for (size_t i = 0; i < task_count; ++i)
+    {
+        if (rows[i].second == 0)
+            continue;
+        if (report->Entries.empty() || report->Entries.back().EntryPoint != rows[i].first)
+        {
+            WIN32_VIRTUAL_SPEEDUP entry = {};
+            entry.EntryPoint = rows[i].first;
+            report->Entries.push_back(entry);
+        }
+        report->Entries.back().TaskCount++;
+        report->Entries.back().TaskTime += rows[i].second;
+    }
+    std::vector<std::pair<uint64_t, uint64_t> >().swap(rows);
+    if (max_entry_points > 0 && report->Entries.size() > max_entry_points)
+    {
+        std::vector<std::pair<uint64_t, size_t> > order(report->Entries.size());
+        std::vector<size_t>                       index(max_entry_points);
+        std::vector<WIN32_VIRTUAL_SPEEDUP>        keep(max_entry_points);
+        for (size_t i = 0, n = order.size(); i < n; ++i)
+        {
+            order[i] = std::make_pair(report->Entries[i].TaskTime, i);
+        }
+        std::sort(order.rbegin(), order.rend());
+        for (size_t i = 0; i < max_entry_points; ++i)
+        {
+            index[i] = order[i].second;
+        }
+        std::sort(index.begin(), index.end());
+        for (size_t i = 0; i < max_entry_points; ++i)
+        {   // keep the survivors in entry point order.
+            keep[i] = report->Entries[index[i]];
+        }
+        report->Entries.swap(keep);
+    }
+
+    jobs.Table  = table;
+    jobs.Graph  = &graph;
+    jobs.Report = report;
+    PlatformParallelFor(thread_count, report->Entries.size(), VirtualSpeedupJob, &jobs);
+
+    // rank by makespan reduction. ties keep the order of entry point address.
+    std::vector<std::pair<int64_t, size_t> > rank(report->Entries.size());
+    std::vector<WIN32_VIRTUAL_SPEEDUP>       ranked(report->Entries.size());
+    for (size_t i = 0, n = rank.size(); i < n; ++i)
+    {
+        rank[i] = std::make_pair(report->Entries[i].MakespanChange, i);
+    }
+    std::sort(rank.begin(), rank.end());
+    for (size_t i = 0, n = rank.size(); i < n; ++i)
+    {
+        ranked[i] = report->Entries[rank[i].second];
+    }
+    report->Entries.swap(ranked);
+    report->EntryCount = report->Entries.size();
+}
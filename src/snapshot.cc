@@ -0,0 +1,424 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implement publication of immutable snapshots of a trace that is
+/// still being loaded. The loading thread appends task events and thread
+/// scheduling events to fixed-size chunks that never move, and at a fixed
+/// interval publishes a snapshot that records how many events are visible. Publishing is a single atomic pointer
+/// exchange. Readers announce the snapshot they hold in a hazard slot, so the
+/// loading thread can free replaced snapshots without blocking either side.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*//////////////////////////
+//   Internal Functions   //
+//////////////////////////*/
+/// @summary Free snapshots that have been replaced and are not held by any reader. Called only by the loading thread.
+/// @param pub The snapshot publisher.
+internal_function void
+ReclaimProfilerSnapshots
+(
+    WIN32_SNAPSHOT_PUBLISHER *pub
+)
+{
+    WIN32_PROFILER_SNAPSHOT *held[WIN32_SNAPSHOT_MAX_READERS];
+    size_t                   keep = 0;
+    for (size_t i = 0; i < WIN32_SNAPSHOT_MAX_READERS; ++i)
+    {
+        held[i] = pub->Hazard[i].load(std::memory_order_seq_cst);
+    }
+    for (size_t i = 0, n = pub->Retired.size(); i < n; ++i)
+    {
+        WIN32_PROFILER_SNAPSHOT *s = pub->Retired[i];
+        bool                  busy = false;
+        for (size_t j = 0; j < WIN32_SNAPSHOT_MAX_READERS; ++j)
+        {
+            if (held[j] == s) busy = true;
+        }
+        if (busy) pub->Retired[keep++] = s;
+        else free(s);
+    }
+    pub->Retired.resize(keep);
+}
+
+/// @summary Retrieve the timestamp of the last event in a chunk list.
+/// @param chunk The last chunk in the list, which holds the event.
+/// @param count The total number of events in the list. Must be greater than zero.
+/// @return The event timestamp, in nanoseconds.
+template <typename CHUNK>
+internal_function inline uint64_t
+SnapshotLastChunkTime
+(
+    CHUNK const *chunk,
+    size_t       count
+)
+{
+    return chunk->EventTime[(count - 1) & (WIN32_SNAPSHOT_CHUNK_SIZE - 1)];
+}
+
+/// @summary Find the range of events in a chunk list that occurred within a given time range.
+/// @param chunks The chunks holding the events, in time order.
+/// @param event_count The number of events visible through chunks.
+/// @param range_lower The start of the search interval, in nanoseconds.
+/// @param range_upper The end of the search interval, in nanoseconds.
+/// @param index_lower On return, this value is set to the zero-based index of the oldest event in the time range.
+/// @param index_upper On return, this value is set to the zero-based index of the newest event in the time range.
+/// @param output_count On return, this value is set to the number of events in the time range.
+/// @return true if at least one event occurred within the time range.
+template <typename CHUNK>
+internal_function bool
+FindChunkEventsInTimeRange
+(
+    CHUNK * const *chunks,
+    size_t    event_count,
+    uint64_t  range_lower,
+    uint64_t  range_upper,
+    size_t   &index_lower,
+    size_t   &index_upper,
+    size_t  &output_count
+)
+{
+    size_t lo = 0, hi = event_count;
+    index_lower = index_upper = output_count = 0;
+    while (lo < hi)
+    {   // find the first event at or after range_lower.
+        size_t mid = lo + ((hi - lo) >> 1);
+        if (chunks[mid >> WIN32_SNAPSHOT_CHUNK_SHIFT]->EventTime[mid & (WIN32_SNAPSHOT_CHUNK_SIZE - 1)] < range_lower) lo = mid + 1;
+        else hi = mid;
+    }
+    size_t first = lo;
+    hi = event_count;
+    while (lo < hi)
+    {   // find the first event after range_upper.
+        size_t mid = lo + ((hi - lo) >> 1);
+        if (chunks[mid >> WIN32_SNAPSHOT_CHUNK_SHIFT]->EventTime[mid & (WIN32_SNAPSHOT_CHUNK_SIZE - 1)] <= range_upper) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo == first || range_upper < range_lower)
+    {   // no events fall within the time range.
+        return false;
+    }
+    index_lower  = first;
+    index_upper  = lo - 1;
+    output_count = lo - first;
+    return true;
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Initialize a snapshot publisher. No snapshot is visible until the first call to PublishProfilerSnapshot.
+/// @param pub The snapshot publisher to initialize.
+/// @param publish_interval The minimum time between periodic snapshots, in the units passed to ProfilerSnapshotDue.
+public_function void
+InitSnapshotPublisher
+(
+    WIN32_SNAPSHOT_PUBLISHER *pub,
+    uint64_t     publish_interval
+)
+{
+    pub->Current.store(NULL, std::memory_order_relaxed);
+    for (size_t i = 0; i < WIN32_SNAPSHOT_MAX_READERS; ++i)
+    {
+        pub->Hazard[i].store(NULL, std::memory_order_relaxed);
+    }
+    pub->Retired.clear();
+    pub->Chunks.clear();
+    pub->SchedChunks.clear();
+    pub->EventCount      = 0;
+    pub->SchedEventCount = 0;
+    pub->NextEpoch       = 1;
+    pub->LastPublishTime = 0;
+    pub->PublishInterval = publish_interval;
+    pub->PollCounter     = 0;
+}
+
+/// @summary Free all snapshots and chunks owned by a publisher. No reader may hold a snapshot.
+/// @param pub The snapshot publisher to delete.
+public_function void
+DeleteSnapshotPublisher
+(
+    WIN32_SNAPSHOT_PUBLISHER *pub
+)
+{
+    free(pub->Current.exchange(NULL));
+    for (size_t i = 0, n = pub->Retired.size(); i < n; ++i)
+    {
+        free(pub->Retired[i]);
+    }
+    for (size_t i = 0, n = pub->Chunks.size(); i < n; ++i)
+    {
+        free(pub->Chunks[i]);
+    }
+    for (size_t i = 0, n = pub->SchedChunks.size(); i < n; ++i)
+    {
+        free(pub->SchedChunks[i]);
+    }
+    pub->Retired.clear();
+    pub->Chunks.clear();
+    pub->SchedChunks.clear();
+    pub->EventCount      = 0;
+    pub->SchedEventCount = 0;
+}
+
+/// @summary Append a task event to the publisher's chunks. Called only by the loading thread, in time order.
+/// The event becomes visible to readers with the next published snapshot.
+/// @param pub The snapshot publisher.
+/// @param type One of WIN32_TASK_EVENT_TYPE.
+/// @param time The time at which the event occurred, in nanoseconds.
+/// @param task_id The identifier of the task.
+/// @param thread_id The operating system identifier of the thread that produced the event.
+/// @return true if the event was appended, or false if memory for a new chunk could not be allocated.
+public_function bool
+SnapshotAppendTaskEvent
+(
+    WIN32_SNAPSHOT_PUBLISHER *pub,
+    uint8_t                  type,
+    uint64_t                 time,
+    task_id_t             task_id,
+    uint32_t            thread_id
+)
+{
+    size_t const index = pub->EventCount & (WIN32_SNAPSHOT_CHUNK_SIZE - 1);
+    if (index == 0 && (pub->EventCount >> WIN32_SNAPSHOT_CHUNK_SHIFT) == pub->Chunks.size())
+    {   // the last chunk is full, or there are no chunks yet.
+        WIN32_TASK_EVENT_CHUNK *chunk = (WIN32_TASK_EVENT_CHUNK*) malloc(sizeof(WIN32_TASK_EVENT_CHUNK));
+        if (chunk == NULL) return false;
+        pub->Chunks.push_back(chunk);
+    }
+    WIN32_TASK_EVENT_CHUNK *chunk = pub->Chunks.back();
+    chunk->EventTime[index] = time;
+    chunk->TaskId   [index] = task_id;
+    chunk->ThreadId [index] = thread_id;
+    chunk->EventType[index] = type;
+    pub->EventCount++;
+    return true;
+}
+
+/// @summary Append a thread scheduling event to the publisher's chunks. Called only by the loading thread, in time order, for each event that
+/// is also appended to the ready or switch columns of a WIN32_THREAD_INFO. The event becomes visible to readers with the next published snapshot.
+/// @param pub The snapshot publisher.
+/// @param type One of WIN32_SCHED_EVENT_TYPE.
+/// @param time The time at which the event occurred, in nanoseconds.
+/// @param process_id The operating system identifier of the process owning the thread.
+/// @param thread_id The operating system identifier of the thread that was readied or switched.
+/// @param processor The zero-based index of the logical processor that logged the event.
+/// @return true if the event was appended, or false if memory for a new chunk could not be allocated.
+public_function bool
+SnapshotAppendSchedEvent
+(
+    WIN32_SNAPSHOT_PUBLISHER *pub,
+    uint8_t                  type,
+    uint64_t                 time,
+    uint32_t           process_id,
+    uint32_t            thread_id,
+    uint16_t            processor
+)
+{
+    size_t const index = pub->SchedEventCount & (WIN32_SNAPSHOT_CHUNK_SIZE - 1);
+    if (index == 0 && (pub->SchedEventCount >> WIN32_SNAPSHOT_CHUNK_SHIFT) == pub->SchedChunks.size())
+    {   // the last chunk is full, or there are no chunks yet.
+        WIN32_SCHED_EVENT_CHUNK *chunk = (WIN32_SCHED_EVENT_CHUNK*) malloc(sizeof(WIN32_SCHED_EVENT_CHUNK));
+        if (chunk == NULL) return false;
+        pub->SchedChunks.push_back(chunk);
+    }
+    WIN32_SCHED_EVENT_CHUNK *chunk = pub->SchedChunks.back();
+    chunk->EventTime[index] = time;
+    chunk->ProcessId[index] = process_id;
+    chunk->ThreadId [index] = thread_id;
+    chunk->Processor[index] = processor;
+    chunk->EventType[index] = type;
+    pub->SchedEventCount++;
+    return true;
+}
+
+/// @summary Determine whether a periodic snapshot should be published. Only the current time is compared, so this is cheap enough to call per event.
+/// @param pub The snapshot publisher.
+/// @param now The current time, in the units of the publish interval.
+/// @return true if at least the publish interval has elapsed since the last snapshot.
+public_function inline bool
+ProfilerSnapshotDue
+(
+    WIN32_SNAPSHOT_PUBLISHER *pub,
+    uint64_t                  now
+)
+{
+    return (now - pub->LastPublishTime) >= pub->PublishInterval;
+}
+
+/// @summary Publish a snapshot of all task and scheduling events appended so far. Called only by the loading thread.
+/// @param pub The snapshot publisher.
+/// @param now The current time, in the units of the publish interval.
+/// @param progress The estimated fraction of the trace that has been loaded, in [0, 1].
+/// @param process_count The number of processes observed so far.
+/// @param thread_count The number of threads observed so far.
+/// @param task_count The number of task table rows created so far.
+/// @param complete Specify true if loading has finished and no further snapshots will be published.
+/// @return The epoch of the published snapshot, or 0 if memory could not be allocated.
+public_function uint64_t
+PublishProfilerSnapshot
+(
+    WIN32_SNAPSHOT_PUBLISHER *pub,
+    uint64_t                  now,
+    float                progress,
+    size_t          process_count,
+    size_t           thread_count,
+    size_t             task_count,
+    bool                 complete
+)
+{
+    size_t const             chunk_count = pub->Chunks.size();
+    size_t const             sched_count = pub->SchedChunks.size();
+    size_t const             bytes       = sizeof(WIN32_PROFILER_SNAPSHOT) + chunk_count * sizeof(WIN32_TASK_EVENT_CHUNK*) + sched_count * sizeof(WIN32_SCHED_EVENT_CHUNK*);
+    WIN32_PROFILER_SNAPSHOT *s           = (WIN32_PROFILER_SNAPSHOT*) malloc(bytes);
+    if (s == NULL) return 0;
+    // the snapshot and its chunk lists are a single allocation, so a snapshot can be freed with a single call.
+    s->Epoch        = pub->NextEpoch++;
+    s->EventCount   = pub->EventCount;
+    s->ChunkCount   = chunk_count;
+    s->Chunks       = (WIN32_TASK_EVENT_CHUNK**)(s + 1);
+    if (chunk_count > 0) memcpy(s->Chunks, &pub->Chunks[0], chunk_count * sizeof(WIN32_TASK_EVENT_CHUNK*));
+    s->SchedEventCount = pub->SchedEventCount;
+    s->SchedChunkCount = sched_count;
+    s->SchedChunks     = (WIN32_SCHED_EVENT_CHUNK**)(s->Chunks + chunk_count);
+    if (sched_count > 0) memcpy(s->SchedChunks, &pub->SchedChunks[0], sched_count * sizeof(WIN32_SCHED_EVENT_CHUNK*));
+    s->FirstTime    = 0;
+    s->LastTime     = 0;
+    if (pub->EventCount > 0)
+    {
+        s->FirstTime = pub->Chunks[0]->EventTime[0];
+        s->LastTime  = SnapshotLastChunkTime(pub->Chunks.back(), pub->EventCount);
+    }
+    if (pub->SchedEventCount > 0)
+    {   // the view spans both event streams.
+        uint64_t const first = pub->SchedChunks[0]->EventTime[0];
+        uint64_t const last  = SnapshotLastChunkTime(pub->SchedChunks.back(), pub->SchedEventCount);
+        if (pub->EventCount == 0 || first < s->FirstTime) s->FirstTime = first;
+        if (pub->EventCount == 0 || last  > s->LastTime ) s->LastTime  = last;
+    }
+    s->ProcessCount = process_count;
+    s->ThreadCount  = thread_count;
+    s->TaskCount    = task_count;
+    s->Progress     = complete ? 1.0f : (progress < 0.0f ? 0.0f : (progress > 1.0f ? 1.0f : progress));
+    s->Complete     = complete;
+
+    // the exchange releases the chunk contents written before it to readers that acquire the new snapshot.
+    WIN32_PROFILER_SNAPSHOT *old = pub->Current.exchange(s, std::memory_order_seq_cst);
+    if (old != NULL) pub->Retired.push_back(old);
+    ReclaimProfilerSnapshots(pub);
+    pub->LastPublishTime = now;
+    pub->PollCounter     = 0;
+    return s->Epoch;
+}
+
+/// @summary Acquire the most recently published snapshot. The snapshot remains valid until ReleaseProfilerSnapshot is called for the same reader slot.
+/// @param pub The snapshot publisher.
+/// @param reader The zero-based reader slot, less than WIN32_SNAPSHOT_MAX_READERS. Each reading thread must use a different slot.
+/// @return The snapshot, or NULL if no snapshot has been published yet.
+public_function WIN32_PROFILER_SNAPSHOT const*
+AcquireProfilerSnapshot
+(
+    WIN32_SNAPSHOT_PUBLISHER *pub,
+    size_t                 reader
+)
+{
+    for ( ; ; )
+    {   // announce the snapshot before using it; if it was replaced in the meantime, it may already be freed.
+        WIN32_PROFILER_SNAPSHOT *s = pub->Current.load(std::memory_order_seq_cst);
+        pub->Hazard[reader].store(s, std::memory_order_seq_cst);
+        if (pub->Current.load(std::memory_order_seq_cst) == s)
+            return s;
+    }
+}
+
+/// @summary Release the snapshot held by a reader slot.
+/// @param pub The snapshot publisher.
+/// @param reader The zero-based reader slot passed to AcquireProfilerSnapshot.
+public_function void
+ReleaseProfilerSnapshot
+(
+    WIN32_SNAPSHOT_PUBLISHER *pub,
+    size_t                 reader
+)
+{
+    pub->Hazard[reader].store(NULL, std::memory_order_release);
+}
+
+/// @summary Retrieve the timestamp of an event visible through a snapshot.
+/// @param s The snapshot.
+/// @param index The zero-based index of the event, less than s->EventCount.
+/// @return The event timestamp, in nanoseconds.
+public_function inline uint64_t
+SnapshotEventTime
+(
+    WIN32_PROFILER_SNAPSHOT const *s,
+    size_t                     index
+)
+{
+    return s->Chunks[index >> WIN32_SNAPSHOT_CHUNK_SHIFT]->EventTime[index & (WIN32_SNAPSHOT_CHUNK_SIZE - 1)];
+}
+
+/// @summary Find the range of events visible through a snapshot that occurred within a given time range.
+/// @param s The snapshot to search.
+/// @param range_lower The start of the search interval, in nanoseconds.
+/// @param range_upper The end of the search interval, in nanoseconds.
+/// @param index_lower On return, this value is set to the zero-based index of the oldest event in the time range.
+/// @param index_upper On return, this value is set to the zero-based index of the newest event in the time range.
+/// @param output_count On return, this value is set to the number of events in the time range.
+/// @return true if at least one event occurred within the time range.
+public_function bool
+FindSnapshotEventsInTimeRange
+(
+    WIN32_PROFILER_SNAPSHOT const *s,
+    uint64_t             range_lower,
+    uint64_t             range_upper,
+    size_t              &index_lower,
+    size_t              &index_upper,
+    size_t             &output_count
+)
+{
+    if (s == NULL)
+    {
+        index_lower = index_upper = output_count = 0;
+        return false;
+    }
+    return FindChunkEventsInTimeRange(s->Chunks, s->EventCount, range_lower, range_upper, index_lower, index_upper, output_count);
+}
+
+/// @summary Retrieve the timestamp of a scheduling event visible through a snapshot.
+/// @param s The snapshot.
+/// @param index The zero-based index of the event, less than s->SchedEventCount.
+/// @return The event timestamp, in nanoseconds.
+public_function inline uint64_t
+SnapshotSchedEventTime
+(
+    WIN32_PROFILER_SNAPSHOT const *s,
+    size_t                     index
+)
+{
+    return s->SchedChunks[index >> WIN32_SNAPSHOT_CHUNK_SHIFT]->EventTime[index & (WIN32_SNAPSHOT_CHUNK_SIZE - 1)];
+}
+
+/// @summary Find the range of scheduling events visible through a snapshot that occurred within a given time range.
+/// @param s The snapshot to search.
+/// @param range_lower The start of the search interval, in nanoseconds.
+/// @param range_upper The end of the search interval, in nanoseconds.
+/// @param index_lower On return, this value is set to the zero-based index of the oldest event in the time range.
+/// @param index_upper On return, this value is set to the zero-based index of the newest event in the time range.
+/// @param output_count On return, this value is set to the number of events in the time range.
+/// @return true if at least one event occurred within the time range.
+public_function bool
+FindSnapshotSchedEventsInTimeRange
+(
+    WIN32_PROFILER_SNAPSHOT const *s,
+    uint64_t             range_lower,
+    uint64_t             range_upper,
+    size_t              &index_lower,
+    size_t              &index_upper,
+    size_t             &output_count
+)
+{
+    if (s == NULL)
+    {
+        index_lower = index_upper = output_count = 0;
+        return false;
+    }
+    return FindChunkEventsInTimeRange(s->SchedChunks, s->SchedEventCount, range_lower, range_upper, index_lower, index_upper, output_count);
+}
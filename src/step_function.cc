@@ -0,0 +1,204 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implement range queries over step functions of time, such as the
+/// number of tasks executing in a pool. A running integral answers the mean
+/// over any range with two binary searches, and a small hierarchy of block
+/// minimum and maximum values answers the extremes with a logarithmic number
+/// of reads, so queries stay cheap on functions with hundreds of millions of
+/// steps.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*//////////////////////////
+//   Internal Functions   //
+//////////////////////////*/
+/// @summary Find the step in effect at a given time.
+/// @param f The step function to search.
+/// @param time The time to look up, in nanoseconds. Must not be before Time[0].
+/// @return The index of the last step starting at or before time.
+internal_function inline size_t
+StepFunctionIndex
+(
+    WIN32_STEP_FUNCTION const *f,
+    uint64_t                time
+)
+{
+    return size_t(std::upper_bound(f->Time.begin(), f->Time.end(), time) - f->Time.begin()) - 1;
+}
+
+/// @summary Update a range query result with the values of a run of steps.
+/// @param range The range query result to update.
+/// @param value The values of the steps.
+/// @param first The index of the first step to read.
+/// @param last The index of the last step to read.
+internal_function inline void
+StepFunctionScan
+(
+    WIN32_STEP_RANGE *range,
+    uint32_t const   *value,
+    size_t            first,
+    size_t             last
+)
+{
+    for (size_t i = first; i <= last; ++i)
+    {
+        if (value[i] < range->Min) range->Min = value[i];
+        if (value[i] > range->Max) range->Max = value[i];
+    }
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Free the memory used by a step function. The function is left empty.
+/// @param f The step function to delete.
+public_function void
+DeleteStepFunction
+(
+    WIN32_STEP_FUNCTION *f
+)
+{
+    f->StepCount  = 0;
+    f->EndTime    = 0;
+    f->LevelCount = 0;
+    WIN32_COLUMN<uint64_t>().swap(f->Time);
+    WIN32_COLUMN<uint32_t>().swap(f->Value);
+    WIN32_COLUMN<uint64_t>().swap(f->Area);
+    WIN32_COLUMN<size_t  >().swap(f->LevelStart);
+    WIN32_COLUMN<uint32_t>().swap(f->LevelMin);
+    WIN32_COLUMN<uint32_t>().swap(f->LevelMax);
+}
+
+/// @summary Build the running integral and the range index of a step function whose Time, Value, StepCount and EndTime are set.
+/// @param f The step function to index. Any existing index is replaced.
+public_function void
+BuildStepFunctionIndex
+(
+    WIN32_STEP_FUNCTION *f
+)
+{
+    size_t const n = f->StepCount;
+    f->Area.resize(n);
+    f->LevelCount = 0;
+    f->LevelStart.clear();
+    f->LevelMin.clear();
+    f->LevelMax.clear();
+    if (n == 0)
+        return;
+
+    uint64_t area = 0;
+    for (size_t i = 0; i < n; ++i)
+    {
+        f->Area[i] = area;
+        uint64_t const end = i + 1 < n ? f->Time[i + 1] : (f->EndTime > f->Time[i] ? f->EndTime : f->Time[i]);
+        area += uint64_t(f->Value[i]) * (end - f->Time[i]);
+    }
+
+    // level 0 summarizes blocks of steps; each level above halves the entry count.
+    size_t count = (n + WIN32_STEP_FUNCTION_BLOCK_SIZE - 1) / WIN32_STEP_FUNCTION_BLOCK_SIZE;
+    size_t total = 0;
+    f->LevelStart.push_back(0);
+    for (;;)
+    {
+        total += count;
+        f->LevelStart.push_back(total);
+        f->LevelCount++;
+        if (count == 1) break;
+        count = (count + 1) / 2;
+    }
+    f->LevelMin.resize(total);
+    f->LevelMax.resize(total);
+    for (size_t b = 0, nb = f->LevelStart[1]; b < nb; ++b)
+    {
+        size_t const first = b * WIN32_STEP_FUNCTION_BLOCK_SIZE;
+        size_t const last  = (first + WIN32_STEP_FUNCTION_BLOCK_SIZE < n ? first + WIN32_STEP_FUNCTION_BLOCK_SIZE : n) - 1;
+        WIN32_STEP_RANGE r = { 0xFFFFFFFFU, 0, 0.0 };
+        StepFunctionScan(&r, &f->Value[0], first, last);
+        f->LevelMin[b] = r.Min;
+        f->LevelMax[b] = r.Max;
+    }
+    for (uint32_t level = 1; level < f->LevelCount; ++level)
+    {
+        size_t const child = f->LevelStart[level - 1];
+        size_t const child_count = f->LevelStart[level] - child;
+        for (size_t k = 0, nk = f->LevelStart[level + 1] - f->LevelStart[level]; k < nk; ++k)
+        {   // the last entry of a level may have a single child.
+            size_t const a = child + k * 2;
+            size_t const b = (k * 2 + 1 < child_count) ? a + 1 : a;
+            f->LevelMin[f->LevelStart[level] + k] = f->LevelMin[a] < f->LevelMin[b] ? f->LevelMin[a] : f->LevelMin[b];
+            f->LevelMax[f->LevelStart[level] + k] = f->LevelMax[a] > f->LevelMax[b] ? f->LevelMax[a] : f->LevelMax[b];
+        }
+    }
+}
+
+/// @summary Retrieve the value of a step function at a given time.
+/// @param f The step function.
+/// @param time The time to look up, in nanoseconds.
+/// @return The value in effect at time, or zero before the first step and at or after EndTime.
+public_function uint32_t
+StepFunctionValueAt
+(
+    WIN32_STEP_FUNCTION const *f,
+    uint64_t                time
+)
+{
+    if (f->StepCount == 0 || time < f->Time[0] || time >= f->EndTime)
+        return 0;
+    return f->Value[StepFunctionIndex(f, time)];
+}
+
+/// @summary Compute the minimum, maximum and time-weighted mean of a step function over a time range. The function is zero outside of [Time[0], EndTime).
+/// @param f The step function.
+/// @param range_lower The start of the range, in nanoseconds.
+/// @param range_upper The end of the range, in nanoseconds. Must be greater than range_lower.
+/// @param range On return, set to the minimum, maximum and mean value over [range_lower, range_upper).
+public_function void
+StepFunctionRange
+(
+    WIN32_STEP_FUNCTION const *f,
+    uint64_t         range_lower,
+    uint64_t         range_upper,
+    WIN32_STEP_RANGE      *range
+)
+{
+    range->Min  = 0;
+    range->Max  = 0;
+    range->Mean = 0.0;
+    if (range_upper <= range_lower || f->StepCount == 0 || range_upper <= f->Time[0] || range_lower >= f->EndTime)
+        return;
+
+    // clip the range to where the function is defined; the integral comes from the same two steps that bound the scan.
+    uint64_t const lower = range_lower > f->Time[0] ? range_lower : f->Time[0];
+    uint64_t const upper = range_upper < f->EndTime ? range_upper : f->EndTime;
+    size_t   const i     = StepFunctionIndex(f, lower);
+    size_t   const j     = StepFunctionIndex(f, upper - 1);
+    uint64_t const area  = (f->Area[j] + uint64_t(f->Value[j]) * (upper - f->Time[j])) - (f->Area[i] + uint64_t(f->Value[i]) * (lower - f->Time[i]));
+    range->Mean = double(area) / double(range_upper - range_lower);
+    if (lower == range_lower && upper == range_upper)
+    {   // the whole range falls where the function is defined.
+        range->Min = 0xFFFFFFFFU;
+    }
+    size_t       lo = i / WIN32_STEP_FUNCTION_BLOCK_SIZE + 1;
+    size_t       hi = j / WIN32_STEP_FUNCTION_BLOCK_SIZE;
+    if (lo >= hi)
+    {   // the range spans at most two blocks.
+        StepFunctionScan(range, &f->Value[0], i, j);
+        return;
+    }
+    StepFunctionScan(range, &f->Value[0], i, lo * WIN32_STEP_FUNCTION_BLOCK_SIZE - 1);
+    StepFunctionScan(range, &f->Value[0], hi * WIN32_STEP_FUNCTION_BLOCK_SIZE, j);
+    for (uint32_t level = 0; lo < hi; ++level, lo >>= 1, hi >>= 1)
+    {   // take the unpaired entries at either end of the range, then move up to their parents.
+        size_t const base = f->LevelStart[level];
+        if (lo & 1)
+        {
+            if (f->LevelMin[base + lo] < range->Min) range->Min = f->LevelMin[base + lo];
+            if (f->LevelMax[base + lo] > range->Max) range->Max = f->LevelMax[base + lo];
+            lo++;
+        }
+        if (hi & 1)
+        {
+            hi--;
+            if (f->LevelMin[base + hi] < range->Min) range->Min = f->LevelMin[base + hi];
+            if (f->LevelMax[base + hi] > range->Max) range->Max = f->LevelMax[base + hi];
+        }
+    }
+}
@@ -0,0 +1,204 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implement the string intern table. Each distinct string is stored
+/// once in a memory arena and assigned a dense identifier, so equal strings
+/// can be compared and indexed by identifier. Strings are located through an
+/// open-addressed table keyed by a 64-bit hash of their contents.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////////
+//   Preprocessor   //
+////////////////////*/
+/// @summary Define the minimum number of slots allocated for a non-empty string table. Must be a power of two.
+#ifndef WIN32_STRING_TABLE_MIN_SLOTS
+#define WIN32_STRING_TABLE_MIN_SLOTS           256
+#endif
+
+/*//////////////////////////
+//   Internal Functions   //
+//////////////////////////*/
+/// @summary Locate the slot for a string using linear probing.
+/// @param table The string table to search. SlotCount must be non-zero.
+/// @param str The string to locate.
+/// @param len The length of the string, in characters.
+/// @param hash The value returned by HashStringBytes for the string.
+/// @return The zero-based index of the slot holding the string, or of the empty slot where the string would be inserted.
+internal_function size_t
+StringTableProbe
+(
+    WIN32_STRING_TABLE const *table,
+    WCHAR const                *str,
+    size_t                      len,
+    uint64_t                   hash
+)
+{
+    size_t const mask = table->SlotCount - 1;
+    size_t       slot = size_t(hash) & mask;
+    for ( ; ; )
+    {   // the load factor is kept below 1/2, so an empty slot is always found.
+        string_id_t const id = table->SlotId[slot];
+        if (id == WIN32_STRING_ID_NONE)
+            return slot;
+        if (table->SlotHash[slot] == hash && table->Length[id] == len && memcmp(table->String[id], str, len * sizeof(WCHAR)) == 0)
+            return slot;
+        slot = (slot + 1) & mask;
+    }
+}
+
+/// @summary Double the number of slots in a string table and re-insert all strings. The stored hashes are reused.
+/// @param table The string table to grow.
+internal_function void
+StringTableGrow
+(
+    WIN32_STRING_TABLE *table
+)
+{
+    size_t const new_count = table->SlotCount == 0 ? WIN32_STRING_TABLE_MIN_SLOTS : table->SlotCount * 2;
+    size_t const      mask = new_count - 1;
+    table->SlotHash.assign(new_count, 0);
+    table->SlotId.assign(new_count, WIN32_STRING_ID_NONE);
+    table->SlotCount = new_count;
+    for (size_t id = 1; id < table->StringCount; ++id)
+    {   // every stored string is distinct, so only an empty slot is needed.
+        size_t slot = size_t(table->Hash[id]) & mask;
+        while (table->SlotId[slot] != WIN32_STRING_ID_NONE)
+            slot = (slot + 1) & mask;
+        table->SlotHash[slot] = table->Hash[id];
+        table->SlotId  [slot] = string_id_t(id);
+    }
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Compute a 64-bit hash of a block of memory, using MurmurHash64A. Similar inputs, such as
+/// file paths that differ in a single character, produce unrelated hash values.
+/// @param data The data to hash.
+/// @param size The number of bytes of data.
+/// @return The 64-bit hash value.
+public_function uint64_t
+HashStringBytes
+(
+    void const *data,
+    size_t      size
+)
+{
+    uint64_t const      m = 0xC6A4A7935BD1E995ULL;
+    uint8_t  const     *p = (uint8_t const*) data;
+    uint64_t            h = 0x9E3779B97F4A7C15ULL ^ (uint64_t(size) * m);
+    size_t   const nwords = size / sizeof(uint64_t);
+    for (size_t i = 0; i < nwords; ++i, p += sizeof(uint64_t))
+    {
+        uint64_t k;
+        memcpy(&k, p, sizeof(k));
+        k *= m; k ^= k >> 47; k *= m;
+        h ^= k; h *= m;
+    }
+    size_t const tail = size & (sizeof(uint64_t) - 1);
+    if (tail > 0)
+    {
+        uint64_t k = 0;
+        memcpy(&k, p, tail);
+        h ^= k; h *= m;
+    }
+    h ^= h >> 47; h *= m; h ^= h >> 47;
+    return h;
+}
+
+/// @summary Initialize an empty string table. A zero-initialized WIN32_STRING_TABLE is also a valid empty table.
+/// @param table The string table to initialize.
+public_function void
+InitStringTable
+(
+    WIN32_STRING_TABLE *table
+)
+{
+    table->SlotCount   = 0;
+    table->StringCount = 0;
+    table->SlotHash.clear();
+    table->SlotId.clear();
+    table->String.clear();
+    table->Length.clear();
+    table->Hash.clear();
+}
+
+/// @summary Search a string table for a string without inserting it.
+/// @param table The string table to search.
+/// @param str The string to locate. May be NULL.
+/// @param len The length of the string, in characters.
+/// @return The identifier of the string, or WIN32_STRING_ID_NONE if str is NULL or the string has not been interned.
+public_function string_id_t
+FindInternedString
+(
+    WIN32_STRING_TABLE const *table,
+    WCHAR const                *str,
+    size_t                      len
+)
+{
+    if (str == NULL || table->SlotCount == 0)
+        return WIN32_STRING_ID_NONE;
+    uint64_t const hash = HashStringBytes(str, len * sizeof(WCHAR));
+    return table->SlotId[StringTableProbe(table, str, len, hash)];
+}
+
+/// @summary Intern a string. If the string is already present, its existing identifier is returned and no memory is allocated;
+/// otherwise a zero-terminated copy is made in the arena.
+/// @param table The string table to update.
+/// @param arena The memory arena that owns the string data.
+/// @param str The string to intern. The string need not be zero-terminated. May be NULL.
+/// @param len The length of the string, in characters.
+/// @return The identifier of the string, or WIN32_STRING_ID_NONE if str is NULL or memory could not be allocated.
+public_function string_id_t
+InternWideString
+(
+    WIN32_STRING_TABLE *table,
+    WIN32_MEMORY_ARENA *arena,
+    WCHAR const          *str,
+    size_t                len
+)
+{
+    if (str == NULL || len > 0xFFFFFFFEUL)
+        return WIN32_STRING_ID_NONE;
+    if (table->StringCount == 0)
+    {   // reserve identifier zero so that it can mean 'no string'.
+        table->String.push_back(NULL);
+        table->Length.push_back(0);
+        table->Hash.push_back(0);
+        table->StringCount = 1;
+    }
+    if (table->StringCount * 2 > table->SlotCount)
+    {   // keep the load factor below 1/2.
+        StringTableGrow(table);
+    }
+    uint64_t const hash = HashStringBytes(str, len * sizeof(WCHAR));
+    size_t   const slot = StringTableProbe(table, str, len, hash);
+    if (table->SlotId[slot] != WIN32_STRING_ID_NONE)
+    {   // the string was interned previously.
+        return table->SlotId[slot];
+    }
+    WCHAR *copy = (WCHAR*) MemoryArenaAllocate(arena, (len + 1) * sizeof(WCHAR), sizeof(WCHAR));
+    if (copy == NULL)
+        return WIN32_STRING_ID_NONE;
+    memcpy(copy, str, len * sizeof(WCHAR));
+    copy[len] = 0;
+    string_id_t const id  = string_id_t(table->StringCount++);
+    table->SlotHash[slot] = hash;
+    table->SlotId  [slot] = id;
+    table->String.push_back(copy);
+    table->Length.push_back(uint32_t(len));
+    table->Hash.push_back(hash);
+    return id;
+}
+
+/// @summary Retrieve the contents of an interned string.
+/// @param table The string table.
+/// @param id The string identifier returned by InternWideString.
+/// @return The zero-terminated string, or NULL for WIN32_STRING_ID_NONE or an invalid identifier.
+public_function inline WCHAR const*
+InternedString
+(
+    WIN32_STRING_TABLE const *table,
+    string_id_t                  id
+)
+{
+    return (id != WIN32_STRING_ID_NONE && id < table->StringCount) ? table->String[id] : NULL;
+}
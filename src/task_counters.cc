@@ -0,0 +1,287 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implement the per-task hardware counter and heap allocation
+/// reports. Each counter sample recorded at a TaskFinish event is matched to
+/// its task table row, and the counters of all tasks with the same entry
+/// point are summed, so that the instructions per cycle and miss rates of a
+/// slow task can be compared against the other tasks running the same code.
+/// Allocations are summed by entry point in the same way.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Initialize an empty task counter list.
+/// @param list The task counter list to initialize.
+public_function void
+InitTaskCounterList
+(
+    WIN32_TASK_COUNTER_LIST *list
+)
+{
+    list->SampleCount = 0;
+    list->FinishTime.clear();
+    list->TaskId.clear();
+    list->ThreadId.clear();
+    list->CounterMask.clear();
+    list->Value.clear();
+}
+
+/// @summary Append a sample to a task counter list.
+/// @param list The task counter list to update.
+/// @param time The time at which the task finished, in nanoseconds.
+/// @param task_id The identifier of the task.
+/// @param thread_id The operating system identifier of the worker thread that executed the task.
+/// @param mask Bit i is set if values[i] was recorded.
+/// @param values WIN32_TASK_COUNTER_COUNT counter deltas, indexed by WIN32_TASK_COUNTER.
+public_function void
+AppendTaskCounters
+(
+    WIN32_TASK_COUNTER_LIST *list,
+    uint64_t                 time,
+    task_id_t             task_id,
+    uint32_t            thread_id,
+    uint32_t                 mask,
+    uint64_t const        *values
+)
+{
+    list->FinishTime.push_back(time);
+    list->TaskId.push_back(task_id);
+    list->ThreadId.push_back(thread_id);
+    list->CounterMask.push_back(mask & ((1U << WIN32_TASK_COUNTER_COUNT) - 1U));
+    for (size_t i = 0; i < WIN32_TASK_COUNTER_COUNT; ++i)
+    {
+        list->Value.push_back((mask & (1U << i)) ? values[i] : 0);
+    }
+    list->SampleCount++;
+}
+
+/// @summary Retrieve the display name of a task counter.
+/// @param counter One of WIN32_TASK_COUNTER.
+/// @return A zero-terminated string naming the counter.
+public_function char const*
+TaskCounterName
+(
+    uint32_t counter
+)
+{
+    static char const *names[WIN32_TASK_COUNTER_COUNT] =
+    {
+        "Cycles", "Instructions", "L1D misses", "LLC misses", "Branch misses"
+    };
+    return counter < WIN32_TASK_COUNTER_COUNT ? names[counter] : "Unknown";
+}
+
+/// @summary Compute the ratio of two counters of a task or entry point, such as instructions per cycle or misses per thousand instructions.
+/// @param values WIN32_TASK_COUNTER_COUNT counter values, indexed by WIN32_TASK_COUNTER.
+/// @param mask The counters present in values.
+/// @param numerator The counter to divide, one of WIN32_TASK_COUNTER.
+/// @param denominator The counter to divide by, one of WIN32_TASK_COUNTER.
+/// @param scale The value the ratio is multiplied by; 1 for instructions per cycle, or 1000 for misses per thousand instructions.
+/// @param ratio If the function returns true, this value is set to the scaled ratio.
+/// @return true if both counters are present and the denominator is non-zero.
+public_function bool
+TaskCounterRatio
+(
+    uint64_t const *values,
+    uint32_t          mask,
+    uint32_t     numerator,
+    uint32_t   denominator,
+    double           scale,
+    double          &ratio
+)
+{
+    if ((mask & (1U << numerator)) == 0 || (mask & (1U << denominator)) == 0 || values[denominator] == 0)
+        return false;
+    ratio = (double(values[numerator]) * scale) / double(values[denominator]);
+    return true;
+}
+
+/// @summary Free the memory used by a task counter report. The report is left empty.
+/// @param report The report to delete.
+public_function void
+DeleteTaskCounterReport
+(
+    WIN32_TASK_COUNTER_REPORT *report
+)
+{
+    report->TaskCount       = 0;
+    report->UnmatchedCount  = 0;
+    report->EntryPointCount = 0;
+    WIN32_COLUMN<uint32_t>().swap(report->TaskCounterMask);
+    WIN32_COLUMN<uint64_t>().swap(report->TaskValue);
+    WIN32_COLUMN<uint64_t>().swap(report->EntryPoint);
+    WIN32_COLUMN<uint64_t>().swap(report->EntryPointTasks);
+    WIN32_COLUMN<uint32_t>().swap(report->EntryPointMask);
+    WIN32_COLUMN<uint64_t>().swap(report->EntryPointValue);
+}
+
+/// @summary Build the task counter report of a trace. Each sample is attached to the task with the same identifier that was defined most
+/// recently before the sample, which handles reused task identifiers.
+/// @param report The report to build. Any existing contents are replaced.
+/// @param counters The task counter samples.
+/// @param task_table The task table.
+public_function void
+BuildTaskCounterReport
+(
+    WIN32_TASK_COUNTER_REPORT       *report,
+    WIN32_TASK_COUNTER_LIST const *counters,
+    WIN32_TASK_TABLE const      *task_table
+)
+{
+    size_t const                              C = WIN32_TASK_COUNTER_COUNT;
+    std::vector<uint64_t>                     entry_points;
+    std::vector<uint64_t>                     entry_tasks;
+    std::vector<uint32_t>                     entry_mask;
+    std::vector<uint64_t>                     entry_value;
+    std::vector<std::pair<uint64_t, size_t> > order;
+
+    DeleteTaskCounterReport(report);
+    if (counters->SampleCount == 0)
+        return;
+    report->TaskCounterMask.assign(task_table->TaskCount, 0);
+    report->TaskValue.assign(task_table->TaskCount * C, 0);
+    for (size_t i = 0; i < counters->SampleCount; ++i)
+    {
+        size_t row;
+        if (!FindTaskByIdAndTime(task_table, counters->TaskId[i], counters->FinishTime[i], row) || report->TaskCounterMask[row] != 0 || counters->CounterMask[i] == 0)
+        {   // the definition wasn't recorded, or events were dropped and the sample belongs to an earlier use of the identifier.
+            report->UnmatchedCount++;
+            continue;
+        }
+        report->TaskCounterMask[row] = counters->CounterMask[i];
+        std::copy(counters->Value.begin() + i * C, counters->Value.begin() + (i + 1) * C, report->TaskValue.begin() + row * C);
+        report->TaskCount++;
+        entry_points.push_back(task_table->EntryPoint[row]);
+    }
+
+    // give each entry point with counters a dense index, so its tasks can be summed in a flat array.
+    std::sort(entry_points.begin(), entry_points.end());
+    entry_points.erase(std::unique(entry_points.begin(), entry_points.end()), entry_points.end());
+    entry_tasks.assign(entry_points.size(), 0);
+    entry_mask.assign(entry_points.size(), (1U << C) - 1U);
+    entry_value.assign(entry_points.size() * C, 0);
+    for (size_t r = 0; r < task_table->TaskCount; ++r)
+    {
+        if (report->TaskCounterMask[r] == 0)
+            continue;
+        size_t const e = size_t(std::lower_bound(entry_points.begin(), entry_points.end(), task_table->EntryPoint[r]) - entry_points.begin());
+        entry_tasks[e]++;
+        entry_mask [e] &= report->TaskCounterMask[r];
+        for (size_t c = 0; c < C; ++c)
+            entry_value[e * C + c] += report->TaskValue[r * C + c];
+    }
+
+    // list entry points with the most cycles first. a counter missing from any task is dropped from the entry point's totals.
+    for (size_t e = 0, n = entry_points.size(); e < n; ++e)
+    {
+        for (size_t c = 0; c < C; ++c)
+        {
+            if ((entry_mask[e] & (1U << c)) == 0) entry_value[e * C + c] = 0;
+        }
+        order.push_back(std::make_pair(entry_value[e * C + WIN32_TASK_COUNTER_CYCLES], e));
+    }
+    std::sort(order.begin(), order.end(), OffCpuTimeBefore);
+    report->EntryPointCount = order.size();
+    report->EntryPoint.resize(order.size());
+    report->EntryPointTasks.resize(order.size());
+    report->EntryPointMask.resize(order.size());
+    report->EntryPointValue.resize(order.size() * C);
+    for (size_t i = 0, n = order.size(); i < n; ++i)
+    {
+        size_t const e = order[i].second;
+        report->EntryPoint     [i] = entry_points[e];
+        report->EntryPointTasks[i] = entry_tasks[e];
+        report->EntryPointMask [i] = entry_mask[e];
+        std::copy(entry_value.begin() + e * C, entry_value.begin() + (e + 1) * C, report->EntryPointValue.begin() + i * C);
+    }
+}
+
+/// @summary Free the memory used by a task allocation report. The report is left empty.
+/// @param report The report to delete.
+public_function void
+DeleteTaskAllocReport
+(
+    WIN32_TASK_ALLOC_REPORT *report
+)
+{
+    report->TaskCount       = 0;
+    report->AllocCount      = 0;
+    report->AllocBytes      = 0;
+    report->FreeBytes       = 0;
+    report->EntryPointCount = 0;
+    WIN32_COLUMN<uint64_t>().swap(report->EntryPoint);
+    WIN32_COLUMN<uint64_t>().swap(report->EntryPointTasks);
+    WIN32_COLUMN<uint64_t>().swap(report->EntryPointAllocs);
+    WIN32_COLUMN<uint64_t>().swap(report->EntryPointBytes);
+    WIN32_COLUMN<uint64_t>().swap(report->EntryPointFreeBytes);
+}
+
+/// @summary Build the task allocation report of a trace from the AllocCount, AllocBytes and FreeBytes columns of its task table.
+/// @param report The report to build. Any existing contents are replaced.
+/// @param task_table The task table.
+public_function void
+BuildTaskAllocReport
+(
+    WIN32_TASK_ALLOC_REPORT     *report,
+    WIN32_TASK_TABLE const  *task_table
+)
+{
+    std::vector<uint64_t>                     entry_points;
+    std::vector<uint64_t>                     entry_tasks;
+    std::vector<uint64_t>                     entry_allocs;
+    std::vector<uint64_t>                     entry_bytes;
+    std::vector<uint64_t>                     entry_frees;
+    std::vector<std::pair<uint64_t, size_t> > order;
+
+    DeleteTaskAllocReport(report);
+    for (size_t r = 0; r < task_table->TaskCount; ++r)
+    {
+        if (task_table->AllocCount[r] == 0 && task_table->FreeBytes[r] == 0)
+            continue;
+        report->TaskCount++;
+        report->AllocCount += task_table->AllocCount[r];
+        report->AllocBytes += task_table->AllocBytes[r];
+        report->FreeBytes  += task_table->FreeBytes [r];
+        entry_points.push_back(task_table->EntryPoint[r]);
+    }
+
+    // give each entry point with allocations or frees a dense index, so its tasks can be summed in a flat array.
+    std::sort(entry_points.begin(), entry_points.end());
+    entry_points.erase(std::unique(entry_points.begin(), entry_points.end()), entry_points.end());
+    entry_tasks.assign(entry_points.size(), 0);
+    entry_allocs.assign(entry_points.size(), 0);
+    entry_bytes.assign(entry_points.size(), 0);
+    entry_frees.assign(entry_points.size(), 0);
+    for (size_t r = 0; r < task_table->TaskCount; ++r)
+    {
+        if (task_table->AllocCount[r] == 0 && task_table->FreeBytes[r] == 0)
+            continue;
+        size_t const e = size_t(std::lower_bound(entry_points.begin(), entry_points.end(), task_table->EntryPoint[r]) - entry_points.begin());
+        entry_tasks [e]++;
+        entry_allocs[e] += task_table->AllocCount[r];
+        entry_bytes [e] += task_table->AllocBytes[r];
+        entry_frees [e] += task_table->FreeBytes [r];
+    }
+
+    // list entry points with the most allocations first, since the per-call cost of the allocator dominates the cost of churn.
+    for (size_t e = 0, n = entry_points.size(); e < n; ++e)
+    {
+        order.push_back(std::make_pair(entry_allocs[e], e));
+    }
+    std::sort(order.begin(), order.end(), OffCpuTimeBefore);
+    report->EntryPointCount = order.size();
+    report->EntryPoint.resize(order.size());
+    report->EntryPointTasks.resize(order.size());
+    report->EntryPointAllocs.resize(order.size());
+    report->EntryPointBytes.resize(order.size());
+    report->EntryPointFreeBytes.resize(order.size());
+    for (size_t i = 0, n = order.size(); i < n; ++i)
+    {
+        size_t const e = order[i].second;
+        report->EntryPoint         [i] = entry_points[e];
+        report->EntryPointTasks    [i] = entry_tasks[e];
+        report->EntryPointAllocs   [i] = entry_allocs[e];
+        report->EntryPointBytes    [i] = entry_bytes[e];
+        report->EntryPointFreeBytes[i] = entry_frees[e];
+    }
+}
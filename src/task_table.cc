@@ -0,0 +1,489 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implement the construction of the columnar task table from the
+/// time-ordered task event log. The table is built in a single pass with no
+/// per-row allocation; because events arrive in time order, the sorted time
+/// columns are produced by appending and never need to be sorted.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*//////////////////////////
+//   Internal Functions   //
+//////////////////////////*/
+/// @summary Append a new row to the task table. All time columns are set to 0.
+/// @param table The task table to update.
+/// @param task_id The task identifier.
+/// @return The zero-based index of the new row.
+internal_function size_t
+NewTaskRow
+(
+    WIN32_TASK_TABLE *table,
+    task_id_t       task_id
+)
+{
+    size_t const row = table->TaskCount++;
+    table->TaskId.push_back(task_id);
+    table->ParentId.push_back(INVALID_TASK_ID);
+    table->EntryPoint.push_back(0);
+    table->SourceIndex.push_back(0);
+    table->WorkerThreadId.push_back(0);
+    table->DefineTime.push_back(0);
+    table->ReadyTime.push_back(0);
+    table->LaunchTime.push_back(0);
+    table->FinishTime.push_back(0);
+    table->AllocCount.push_back(0);
+    table->AllocBytes.push_back(0);
+    table->FreeBytes.push_back(0);
+    ObjectIndexInsert(table->TaskIndex, task_id, row);
+    return row;
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Initialize an empty task event list.
+/// @param list The task event list to initialize.
+public_function void
+InitTaskEventList
+(
+    WIN32_TASK_EVENT_LIST *list
+)
+{
+    list->EventCount = 0;
+    list->EventTime.clear();
+    list->EventType.clear();
+    list->TaskId.clear();
+    list->ThreadId.clear();
+    list->SourceIndex.clear();
+    list->ParentId.clear();
+    list->EntryPoint.clear();
+    list->DependencyStart.assign(1, 0);
+    list->Dependencies.clear();
+}
+
+/// @summary Append an event to the end of a task event list. Events must be appended in time order.
+/// @param list The task event list to update.
+/// @param type One of WIN32_TASK_EVENT_TYPE.
+/// @param time The time at which the event occurred, in nanoseconds.
+/// @param task_id The identifier of the task.
+/// @param thread_id The operating system identifier of the thread that produced the event.
+/// @param source_index The task source index for definition and ready-to-run events, or 0.
+/// @param parent_id The parent task identifier for definition events, or INVALID_TASK_ID.
+/// @param entry_point The task entry point address for definition events, or 0.
+/// @param dependencies The dependency list for definition events, or NULL.
+/// @param dependency_count The number of dependencies.
+public_function void
+AppendTaskEvent
+(
+    WIN32_TASK_EVENT_LIST *list,
+    uint8_t                type,
+    uint64_t               time,
+    task_id_t           task_id,
+    uint32_t          thread_id,
+    uint32_t       source_index,
+    task_id_t         parent_id,
+    uint64_t        entry_point,
+    task_id_t const*dependencies,
+    size_t     dependency_count
+)
+{
+    list->EventTime.push_back(time);
+    list->EventType.push_back(type);
+    list->TaskId.push_back(task_id);
+    list->ThreadId.push_back(thread_id);
+    list->SourceIndex.push_back(source_index);
+    list->ParentId.push_back(parent_id);
+    list->EntryPoint.push_back(entry_point);
+    for (size_t i = 0; i < dependency_count; ++i)
+    {
+        list->Dependencies.push_back(dependencies[i]);
+    }
+    list->DependencyStart.push_back(uint32_t(list->Dependencies.size()));
+    list->EventCount++;
+}
+
+/// @summary Initialize an empty task table.
+/// @param table The task table to initialize.
+public_function void
+InitTaskTable
+(
+    WIN32_TASK_TABLE *table
+)
+{
+    table->TaskCount = 0;
+    table->TaskId.clear();
+    table->ParentId.clear();
+    table->EntryPoint.clear();
+    table->SourceIndex.clear();
+    table->WorkerThreadId.clear();
+    table->DefineTime.clear();
+    table->ReadyTime.clear();
+    table->LaunchTime.clear();
+    table->FinishTime.clear();
+    table->AllocCount.clear();
+    table->AllocBytes.clear();
+    table->FreeBytes.clear();
+    table->DefineSortedTime.clear();
+    table->DefineSortedRow.clear();
+    table->ReadySortedTime.clear();
+    table->ReadySortedRow.clear();
+    table->LaunchSortedTime.clear();
+    table->LaunchSortedRow.clear();
+    table->FinishSortedTime.clear();
+    table->FinishSortedRow.clear();
+    InitObjectIndex(table->TaskIndex);
+    table->DependencyStart.assign(1, 0);
+    table->DependencyRow.clear();
+    table->SuccessorStart.assign(1, 0);
+    table->SuccessorRow.clear();
+    table->ParentRow.clear();
+    table->UnresolvedCount = 0;
+}
+
+/// @summary Reserve capacity in each column of a task table so that rows can be added without reallocation.
+/// @param table The task table to update.
+/// @param task_count The expected number of tasks.
+public_function void
+ReserveTaskTable
+(
+    WIN32_TASK_TABLE *table,
+    size_t       task_count
+)
+{
+    table->TaskId.reserve(task_count);
+    table->ParentId.reserve(task_count);
+    table->EntryPoint.reserve(task_count);
+    table->SourceIndex.reserve(task_count);
+    table->WorkerThreadId.reserve(task_count);
+    table->DefineTime.reserve(task_count);
+    table->ReadyTime.reserve(task_count);
+    table->LaunchTime.reserve(task_count);
+    table->FinishTime.reserve(task_count);
+    table->AllocCount.reserve(task_count);
+    table->AllocBytes.reserve(task_count);
+    table->FreeBytes.reserve(task_count);
+    table->DefineSortedTime.reserve(task_count);
+    table->DefineSortedRow.reserve(task_count);
+    table->ReadySortedTime.reserve(task_count);
+    table->ReadySortedRow.reserve(task_count);
+    table->LaunchSortedTime.reserve(task_count);
+    table->LaunchSortedRow.reserve(task_count);
+    table->FinishSortedTime.reserve(task_count);
+    table->FinishSortedRow.reserve(task_count);
+    ReserveObjectIndex(table->TaskIndex, task_count);
+}
+
+/// @summary Locate the most recently defined row for a task identifier.
+/// @param table The task table to search.
+/// @param task_id The task identifier to locate.
+/// @param row If the function returns true, this value is set to the zero-based row index.
+/// @return true if a row with the specified task identifier exists.
+public_function inline bool
+FindTaskById
+(
+    WIN32_TASK_TABLE const *table,
+    task_id_t             task_id,
+    size_t                   &row
+)
+{
+    uint32_t const first = ObjectIndexFirst(table->TaskIndex, task_id);
+    if (first == WIN32_OBJECT_INDEX_EMPTY)
+    {   // no task with this identifier was observed.
+        return false;
+    }
+    row = first;
+    return true;
+}
+
+/// @summary Locate the row for a task identifier that had been defined at a given time. Used when the scheduler reuses task identifiers.
+/// @param table The task table to search.
+/// @param task_id The task identifier to locate.
+/// @param time The query time, in nanoseconds.
+/// @param row If the function returns true, this value is set to the zero-based row index.
+/// @return true if a matching row exists.
+public_function bool
+FindTaskByIdAndTime
+(
+    WIN32_TASK_TABLE const *table,
+    task_id_t             task_id,
+    uint64_t                 time,
+    size_t                   &row
+)
+{
+    size_t i;
+    if (!FindTaskById(table, task_id, i))
+    {   // no task with this identifier was observed.
+        return false;
+    }
+    for (uint32_t r = uint32_t(i); r != WIN32_OBJECT_INDEX_EMPTY; r = table->TaskIndex.ChainNext[r])
+    {   // walk from the newest definition to the oldest. rows with an unobserved definition match any time.
+        if (table->DefineTime[r] <= time)
+        {
+            row = r;
+            return true;
+        }
+    }
+    return false;
+}
+
+/// @summary Update a task table with a single task event. Events must be supplied in time order.
+/// @param table The task table to update.
+/// @param type One of WIN32_TASK_EVENT_TYPE.
+/// @param time The time at which the event occurred, in nanoseconds.
+/// @param task_id The identifier of the task.
+/// @param thread_id The operating system identifier of the thread that produced the event. For launch events, this is the worker thread.
+/// @param source_index The task source index for definition and ready-to-run events.
+/// @param parent_id The parent task identifier for definition events.
+/// @param entry_point The task entry point address for definition events.
+/// @return The zero-based index of the row that was updated.
+public_function size_t
+TaskTableAddEvent
+(
+    WIN32_TASK_TABLE *table,
+    uint8_t            type,
+    uint64_t           time,
+    task_id_t       task_id,
+    uint32_t      thread_id,
+    uint32_t   source_index,
+    task_id_t     parent_id,
+    uint64_t    entry_point
+)
+{
+    size_t row = 0;
+    if (type == WIN32_TASK_EVENT_DEFINE_TASK)
+    {   // every definition starts a new row, since the identifier may have been used before.
+        row = NewTaskRow(table, task_id);
+        table->ParentId   [row] = parent_id;
+        table->EntryPoint [row] = entry_point;
+        table->SourceIndex[row] = source_index;
+        table->DefineTime [row] = time;
+        table->DefineSortedTime.push_back(time);
+        table->DefineSortedRow.push_back(uint32_t(row));
+        return row;
+    }
+    if (!FindTaskById(table, task_id, row) || (type != WIN32_TASK_EVENT_FINISH && table->FinishTime[row] != 0))
+    {   // the definition was lost, or the identifier was reused without one; start a row with an unknown definition.
+        row = NewTaskRow(table, task_id);
+        table->SourceIndex[row] = source_index;
+    }
+    switch (type)
+    {
+        case WIN32_TASK_EVENT_READY_TO_RUN:
+            {
+                table->SourceIndex[row] = source_index;
+                table->ReadyTime  [row] = time;
+                table->ReadySortedTime.push_back(time);
+                table->ReadySortedRow.push_back(uint32_t(row));
+            } break;
+        case WIN32_TASK_EVENT_LAUNCH:
+            {
+                table->WorkerThreadId[row] = thread_id;
+                table->LaunchTime    [row] = time;
+                table->LaunchSortedTime.push_back(time);
+                table->LaunchSortedRow.push_back(uint32_t(row));
+            } break;
+        case WIN32_TASK_EVENT_FINISH:
+            {
+                if (table->WorkerThreadId[row] == 0) table->WorkerThreadId[row] = thread_id;
+                table->FinishTime[row] = time;
+                table->FinishSortedTime.push_back(time);
+                table->FinishSortedRow.push_back(uint32_t(row));
+            } break;
+        default:
+            break;
+    }
+    return row;
+}
+
+/// @summary Charge heap allocations and frees to the row of the task that made them. The row is the task with the same identifier that was defined
+/// most recently before the task finished, which handles reused task identifiers.
+/// @param table The task table to update.
+/// @param time The time at which the task finished, in nanoseconds.
+/// @param task_id The identifier of the task.
+/// @param alloc_count The number of allocations made by the task.
+/// @param alloc_bytes The number of bytes requested by those allocations.
+/// @param free_bytes The usable size, in bytes, of the blocks freed by the task.
+/// @return true if the row was found, or false if the allocations were discarded.
+public_function bool
+TaskTableAddAllocations
+(
+    WIN32_TASK_TABLE *table,
+    uint64_t           time,
+    task_id_t       task_id,
+    uint64_t    alloc_count,
+    uint64_t    alloc_bytes,
+    uint64_t     free_bytes
+)
+{
+    size_t row;
+    if (!FindTaskByIdAndTime(table, task_id, time, row))
+    {   // the task's events were lost.
+        return false;
+    }
+    table->AllocCount[row] += alloc_count;
+    table->AllocBytes[row] += alloc_bytes;
+    table->FreeBytes [row] += free_bytes;
+    return true;
+}
+
+/// @summary Build a task table from a time-ordered task event log in a single pass.
+/// @param table The task table to populate. Any existing contents are discarded.
+/// @param events The time-ordered task event log.
+public_function void
+BuildTaskTable
+(
+    WIN32_TASK_TABLE                *table,
+    WIN32_TASK_EVENT_LIST const    *events
+)
+{
+    size_t define_count = 0;
+    InitTaskTable(table);
+    for (size_t i = 0, n = events->EventCount; i < n; ++i)
+    {   // size the columns up front; most tasks have a definition event.
+        if (events->EventType[i] == WIN32_TASK_EVENT_DEFINE_TASK)
+            define_count++;
+    }
+    ReserveTaskTable(table, define_count);
+    for (size_t i = 0, n = events->EventCount; i < n; ++i)
+    {
+        TaskTableAddEvent(table, events->EventType[i], events->EventTime[i], events->TaskId[i], events->ThreadId[i], events->SourceIndex[i], events->ParentId[i], events->EntryPoint[i]);
+    }
+}
+
+/// @summary Build the successor lists of a task table by transposing its predecessor lists with a counting sort, which keeps
+/// the successors of each row in ascending row order.
+/// @param table The task table to update. The DependencyStart and DependencyRow columns must be complete.
+public_function void
+BuildTaskSuccessors
+(
+    WIN32_TASK_TABLE *table
+)
+{
+    size_t const task_count = table->TaskCount;
+    size_t const edge_count = table->DependencyRow.size();
+    table->SuccessorStart.assign(task_count + 1, 0);
+    table->SuccessorRow.resize(edge_count);
+    for (size_t e = 0; e < edge_count; ++e)
+    {
+        table->SuccessorStart[table->DependencyRow[e] + 1]++;
+    }
+    for (size_t r = 0; r < task_count; ++r)
+    {
+        table->SuccessorStart[r + 1] += table->SuccessorStart[r];
+    }
+    std::vector<uint32_t> next(table->SuccessorStart.begin(), table->SuccessorStart.end() - 1);
+    for (size_t r = 0; r < task_count; ++r)
+    {
+        for (uint32_t e = table->DependencyStart[r], end = table->DependencyStart[r + 1]; e < end; ++e)
+        {
+            table->SuccessorRow[next[table->DependencyRow[e]]++] = uint32_t(r);
+        }
+    }
+}
+
+/// @summary Build the dependency graph of a task table in compressed sparse row form, with edges in both directions.
+/// Each dependency, and each parent, is resolved to the newest row for its identifier that was created before the dependent row.
+/// Every edge therefore points from a lower row to a higher one, so ascending row order is a topological order.
+/// @param table The task table to update. The table must have been built from events.
+/// @param events The time-ordered task event log from which the table was built.
+public_function void
+BuildTaskDependencyGraph
+(
+    WIN32_TASK_TABLE              *table,
+    WIN32_TASK_EVENT_LIST const  *events
+)
+{
+    size_t const task_count = table->TaskCount;
+    size_t       define     = 0;
+    table->DependencyStart.assign(task_count + 1, 0);
+    table->DependencyRow.clear();
+    table->DependencyRow.reserve(events->Dependencies.size());
+    table->ParentRow.assign(task_count, WIN32_OBJECT_INDEX_EMPTY);
+    table->UnresolvedCount = 0;
+    for (size_t i = 0, n = events->EventCount; i < n; ++i)
+    {   // definitions create rows in ascending order, so the k-th definition event belongs to DefineSortedRow[k].
+        if (events->EventType[i] != WIN32_TASK_EVENT_DEFINE_TASK)
+            continue;
+        uint32_t const row = table->DefineSortedRow[define++];
+        for (uint32_t j = events->DependencyStart[i], e = events->DependencyStart[i + 1]; j < e; ++j)
+        {
+            uint32_t dep = ObjectIndexFirst(table->TaskIndex, events->Dependencies[j]);
+            while (dep != WIN32_OBJECT_INDEX_EMPTY && dep >= row)
+                dep = table->TaskIndex.ChainNext[dep];
+            if (dep != WIN32_OBJECT_INDEX_EMPTY) table->DependencyRow.push_back(dep);
+            else table->UnresolvedCount++;
+        }
+        table->DependencyStart[row + 1] = uint32_t(table->DependencyRow.size());
+        if (table->ParentId[row] != INVALID_TASK_ID)
+        {   // a parent that was never observed is left unresolved without counting it.
+            uint32_t parent = ObjectIndexFirst(table->TaskIndex, table->ParentId[row]);
+            while (parent != WIN32_OBJECT_INDEX_EMPTY && parent >= row)
+                parent = table->TaskIndex.ChainNext[parent];
+            table->ParentRow[row] = parent;
+        }
+    }
+    for (size_t r = 0; r < task_count; ++r)
+    {   // rows without a definition have no dependencies; carry the offset forward.
+        if (table->DependencyStart[r + 1] < table->DependencyStart[r])
+            table->DependencyStart[r + 1] = table->DependencyStart[r];
+    }
+
+    BuildTaskSuccessors(table);
+}
+
+/// @summary Group the launched tasks of a task table by the worker thread that executed them, keeping launch order within each worker.
+/// @param table The task table, with complete launch columns.
+/// @param worker_launch On return, pairs of (worker thread identifier, index in LaunchSortedRow), in ascending order.
+public_function void
+BuildWorkerLaunchIndex
+(
+    WIN32_TASK_TABLE const                        *table,
+    std::vector<std::pair<uint32_t, uint32_t> > &worker_launch
+)
+{
+    worker_launch.resize(table->LaunchSortedRow.size());
+    for (size_t i = 0, n = worker_launch.size(); i < n; ++i)
+    {
+        worker_launch[i] = std::make_pair(table->WorkerThreadId[table->LaunchSortedRow[i]], uint32_t(i));
+    }
+    std::sort(worker_launch.begin(), worker_launch.end());
+}
+
+/// @summary Find the task a worker thread was executing over a time range.
+/// @param table The task table.
+/// @param worker_launch The index built by BuildWorkerLaunchIndex.
+/// @param thread_id The operating system identifier of the worker thread.
+/// @param start The start of the time range, in nanoseconds.
+/// @param end The end of the time range, in nanoseconds. Specify start to find only the task executing at time start.
+/// @return The row of the task executing at start, else the first task launched before end, else WIN32_OBJECT_INDEX_EMPTY.
+public_function uint32_t
+FindWorkerTask
+(
+    WIN32_TASK_TABLE const                              *table,
+    std::vector<std::pair<uint32_t, uint32_t> > const &worker_launch,
+    uint32_t                                         thread_id,
+    uint64_t                                             start,
+    uint64_t                                               end
+)
+{
+    size_t lo = size_t(std::lower_bound(worker_launch.begin(), worker_launch.end(), std::make_pair(thread_id, uint32_t(0))) - worker_launch.begin());
+    size_t hi = size_t(std::upper_bound(worker_launch.begin(), worker_launch.end(), std::make_pair(thread_id, uint32_t(WIN32_OBJECT_INDEX_EMPTY))) - worker_launch.begin());
+    size_t const first = lo;
+    size_t const last  = hi;
+    while (lo < hi)
+    {   // find the first task of this worker launched after start.
+        size_t const mid = lo + (hi - lo) / 2;
+        if (table->LaunchSortedTime[worker_launch[mid].second] <= start)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo > first)
+    {   // a task that never finished runs until the end of the trace.
+        uint32_t const row    = table->LaunchSortedRow[worker_launch[lo - 1].second];
+        uint64_t const finish = table->FinishTime[row];
+        if (finish == 0 || finish > start)
+            return row;
+    }
+    if (lo < last && table->LaunchSortedTime[worker_launch[lo].second] < end)
+        return table->LaunchSortedRow[worker_launch[lo].second];
+    return WIN32_OBJECT_INDEX_EMPTY;
+}
@@ -1,11 +1,59 @@
 #include <assert.h>
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <string>
+#include <vector>
+
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
+#include <wchar.h>
 
-#define UNUSED(x)            (x)
+#define UNUSED(x)            (void)(x)
 #define public_function      static
 #define internal_function    static
+#define global_variable      static
+
+#ifndef ENABLE_PROFILER
+#define ENABLE_PROFILER      1
+#endif
+
+// use small merge partitions, so that the short traces built by the loader tests are split into several partitions.
+#define PTRACE_LOADER_MIN_PARTITION_SIZE 64
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+#include "profiler.h"
+#include "ptrace.h"
+#include "platform.cc"
+#include "visualizer_types.h"
+#include "ptrace_codec.cc"
+#include "memory_arena.cc"
+#include "string_table.cc"
+#include "object_index.cc"
+#include "thread_intervals.cc"
+#include "event_decoder.cc"
+#include "task_table.cc"
+#include "lod_pyramid.cc"
+#include "cpu_timeline.cc"
+#include "latency_histogram.cc"
+#include "wake_latency.cc"
+#include "off_cpu.cc"
+#include "queue_depth.cc"
+#include "step_function.cc"
+#include "parallelism.cc"
+#include "zone_tree.cc"
+#include "task_counters.cc"
+#include "critical_path.cc"
+#include "schedule_replay.cc"
+#include "analysis_cache.cc"
+#include "snapshot.cc"
+#include "ptrace_loader.cc"
+#include "profiler_native.cc"
 
 public_function intptr_t
 Rmost
@@ -125,6 +173,1658 @@ FindEventsInTimeRange
     return true;
 }
 
+/// @summary Encode a short sequence of task events and verify that decoding reproduces them exactly.
+internal_function void
+TestPtraceCodecRoundTrip
+(
+    void
+)
+{
+    uint32_t const deps[3] = { 99, 100, 0x7FFFFFFF };
+    PTRACE_EVENT   events[6];
+    memset(events, 0, sizeof(events));
+    events[0].EventType = PTRACE_EVENT_TYPE_DEFINE_TASK;       events[0].Timestamp = 1000; events[0].TaskId = 101; events[0].ParentId = 100; events[0].SourceIndex = 2; events[0].EntryPoint = 0x7FF612340000ULL; events[0].DependencyCount = 3;
+    events[1].EventType = PTRACE_EVENT_TYPE_DEFINE_TASK;       events[1].Timestamp = 1000; events[1].TaskId = 102; events[1].ParentId = INVALID_TASK_ID; events[1].SourceIndex = 300; events[1].EntryPoint = 0x7FF612330000ULL;
+    events[2].EventType = PTRACE_EVENT_TYPE_TASK_READY_TO_RUN; events[2].Timestamp = 1010; events[2].TaskId = 101; events[2].SourceIndex = 2;
+    events[3].EventType = PTRACE_EVENT_TYPE_TASK_LAUNCH;       events[3].Timestamp = 1500; events[3].TaskId = 101;
+    events[4].EventType = PTRACE_EVENT_TYPE_TASK_FINISH;       events[4].Timestamp = 90000000000ULL; events[4].TaskId = 101;
+    events[5].EventType = PTRACE_EVENT_TYPE_TASK_LAUNCH;       events[5].Timestamp = 90000000001ULL; events[5].TaskId = 0x80000000;
+
+    uint8_t            buffer[6 * (PTRACE_MAX_EVENT_SIZE + 3 * PTRACE_MAX_DEPENDENCY_SIZE)];
+    uint8_t           *dst = buffer;
+    PTRACE_CODEC_STATE state;
+    PtraceResetCodecState(&state, 1000);
+    for (size_t i = 0; i < 6; ++i)
+    {
+        dst = PtraceEncodeEvent(dst, &state, &events[i], deps);
+    }
+
+    uint8_t const     *src = buffer;
+    PtraceResetCodecState(&state, 1000);
+    for (size_t i = 0; i < 6; ++i)
+    {
+        PTRACE_EVENT ev;
+        uint32_t     dl[3];
+        src = PtraceDecodeEvent(src, dst, &state, &ev);
+        assert(src != NULL);
+        assert(ev.EventType == events[i].EventType);
+        assert(ev.Timestamp == events[i].Timestamp);
+        assert(ev.TaskId    == events[i].TaskId);
+        if (ev.EventType == PTRACE_EVENT_TYPE_DEFINE_TASK || ev.EventType == PTRACE_EVENT_TYPE_TASK_READY_TO_RUN)
+            assert(ev.SourceIndex == events[i].SourceIndex);
+        if (ev.EventType == PTRACE_EVENT_TYPE_DEFINE_TASK)
+        {
+            assert(ev.ParentId        == events[i].ParentId);
+            assert(ev.EntryPoint      == events[i].EntryPoint);
+            assert(ev.DependencyCount == events[i].DependencyCount);
+            PtraceDecodeDependencies(&ev, dl);
+            for (uint32_t j = 0; j < ev.DependencyCount; ++j)
+                assert(dl[j] == deps[j]);
+        }
+    }
+    assert(src == dst);
+    // truncated input must be rejected rather than read past the end.
+    PtraceResetCodecState(&state, 1000);
+    PTRACE_EVENT ev;
+    assert(PtraceDecodeEvent(buffer, buffer + 3, &state, &ev) == NULL);
+    printf("ptrace codec round-trip: %u bytes for 6 events.\n", unsigned(dst - buffer));
+}
+
+/// @summary Verify that task sampling selects about 1 in N tasks, evenly across groups of sequential task IDs, and all tasks when disabled.
+internal_function void
+TestTaskSampling
+(
+    void
+)
+{
+    uint32_t const rate     = 16;
+    uint32_t const count    = 1 << 20;
+    uint32_t       group[7] = { 0, 0, 0, 0, 0, 0, 0 };
+    uint32_t       selected = 0;
+    for (uint32_t id = 0; id < count; ++id)
+    {   // the decision for a task never changes, so every transition of a task is kept or dropped together.
+        assert(TaskSampled(id, 0) && TaskSampled(id, 1));
+        assert(TaskSampled(id, rate) == TaskSampled(id, rate));
+        if (TaskSampled(id, rate))
+        {   // tasks are often allocated round-robin over entry points, so check that no group is over- or under-sampled.
+            group[id % 7]++;
+            selected++;
+        }
+    }
+    assert(selected > (count / rate) * 98 / 100 && selected < (count / rate) * 102 / 100);
+    for (size_t i = 0; i < 7; ++i)
+    {
+        assert(group[i] > (count / rate / 7) * 95 / 100 && group[i] < (count / rate / 7) * 105 / 100);
+    }
+    printf("task sampling: %u of %u tasks at 1 in %u.\n", selected, count, rate);
+}
+
+/// @summary Verify that fixed-point timestamp conversion matches exact division, including for tick counts where 1000000000 * ticks overflows.
+internal_function void
+TestTimestampScale
+(
+    void
+)
+{
+    uint64_t const freq [4] = { 1000000000ULL, 10000000ULL, 3579545ULL, 2994374000ULL };
+    uint64_t const ticks[4] = { 0, 123456789ULL, 1ULL << 50, 9000000000000000000ULL };
+    for (size_t i = 0; i < 4; ++i)
+    {
+        uint64_t const scale = TimestampScale(freq[i], 1000000000ULL);
+        for (size_t j = 0; j < 4; ++j)
+        {   // exact integer ratios convert exactly; otherwise the result is low by at most about one part in 2^31.
+            uint64_t const t     = ticks[j] / (freq[i] < 1000000000ULL ? 1000000000ULL / freq[i] + 1 : 1);
+            uint64_t const exact = ((t / freq[i]) * 1000000000ULL) + (((t % freq[i]) * 1000000000ULL) / freq[i]);
+            uint64_t const ns    = ScaleTimestamp(t, scale);
+            assert(ns <= exact && exact - ns <= (t >> 31) + 1);
+            if (1000000000ULL % freq[i] == 0) assert(ns == exact);
+        }
+    }
+    // calibration segments pass in a tick count and the nanoseconds it spans; a one-second segment converts to within a nanosecond or two.
+    uint64_t const ns = ScaleTimestamp(3000000000ULL, TimestampScale(3000000000ULL, 1000000123ULL));
+    assert(ns <= 1000000123ULL && 1000000123ULL - ns <= 2);
+    printf("timestamp scale: %llu ns for 2^50 ticks at 10 MHz.\n", (unsigned long long) ScaleTimestamp(1ULL << 50, TimestampScale(10000000ULL, 1000000000ULL)));
+}
+
+/// @summary Verify the clock map built from calibration samples, and the conversion of file timestamps through its segments, with exact ratios.
+internal_function void
+TestClockMap
+(
+    void
+)
+{
+    PTRACE_CLOCK_MAP               map;
+    std::vector<PTRACE_CLOCK_SYNC> sync;
+    size_t                         seg = 0;
+    size_t                         segments = 0;
+
+    // the samples arrive out of order. one repeats a timestamp and one moves the reference clock backwards, and both are dropped.
+    PTRACE_CLOCK_SYNC const samples[6] = { { 3000, 12500 }, { 1000, 10000 }, { 2500, 11000 }, { 5000, 13500 }, { 2000, 12500 }, { 2000, 12000 } };
+    sync.assign(samples, samples + 6);
+    PtraceBuildClockMap(&map, sync, 1000000000ULL);
+    assert(map.Ticks.size() == 3 && map.Ticks[0] == 1000 && map.Ticks[1] == 2000 && map.Ticks[2] == 3000);
+    assert(map.Base [0] == 10000 && map.Base[1] == 12000 && map.Base[2] == 12500);
+    assert(map.Scale[0] == (2ULL << 32) && map.Scale[1] == (1ULL << 31) && map.Scale[2] == (1ULL << 31));
+    segments = map.Ticks.size();
+    assert(PtraceClockToNanoseconds(&map, 1500, seg) == 11000 && seg == 0);
+    assert(PtraceClockToNanoseconds(&map, 2000, seg) == 12000 && seg == 1);
+    assert(PtraceClockToNanoseconds(&map, 2600, seg) == 12300 && seg == 1);
+    assert(PtraceClockToNanoseconds(&map, 4000, seg) == 13000 && seg == 2);
+    assert(PtraceClockToNanoseconds(&map, 9000, seg) == 15500 && seg == 2); // the last segment extrapolates.
+    assert(PtraceClockToNanoseconds(&map, 1200, seg) == 10400 && seg == 0); // out of order, so the walk restarts.
+    assert(PtraceClockToNanoseconds(&map,  400, seg) ==  8800 && seg == 0); // the first segment extrapolates backwards.
+
+    // a timestamp far enough before the first sample clamps to zero rather than wrapping.
+    PTRACE_CLOCK_SYNC const early[2] = { { 1000, 500 }, { 2000, 2500 } };
+    sync.assign(early, early + 2);
+    PtraceBuildClockMap(&map, sync, 1000000000ULL);
+    assert(map.Ticks.size() == 1 && map.Scale[0] == (2ULL << 32));
+    assert(PtraceClockToNanoseconds(&map, 800, seg) == 100 && PtraceClockToNanoseconds(&map, 100, seg) == 0);
+
+    // with fewer than two usable samples, the header frequency is used from zero.
+    PTRACE_CLOCK_SYNC const single[2] = { { 100, 60 }, { 100, 50 } };
+    sync.assign(single, single + 2);
+    PtraceBuildClockMap(&map, sync, 4000000ULL);
+    assert(map.Ticks.size() == 1 && map.Ticks[0] == 0 && map.Base[0] == 0 && map.Scale[0] == (250ULL << 32));
+    assert(PtraceClockToNanoseconds(&map, 3, seg) == 750 && seg == 0);
+    sync.clear();
+    PtraceBuildClockMap(&map, sync, 4000000ULL);
+    assert(map.Ticks.size() == 1 && PtraceClockToNanoseconds(&map, 4000000ULL, seg) == 1000000000ULL);
+    printf("clock map: %u segments from %u samples.\n", unsigned(segments), 6U);
+}
+
+/// @summary Start an in-memory .ptrace file. The clock frequency is 1GHz, so file timestamps load as nanoseconds unchanged.
+/// @param file The file data. Any existing contents are replaced.
+/// @param header_size The HeaderSize of the file. Specify offsetof(PTRACE_FILE_HEADER, TaskSampleRate) for a file written before minor version 2.
+/// @param sample_rate The TaskSampleRate of the file. Not written if header_size doesn't include it.
+internal_function void
+InitTestPtraceFile
+(
+    std::vector<uint8_t> &file,
+    uint32_t       header_size,
+    uint32_t       sample_rate
+)
+{
+    PTRACE_FILE_HEADER hdr;
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.Magic          = PTRACE_FILE_MAGIC;
+    hdr.VersionMajor   = PTRACE_VERSION_MAJOR;
+    hdr.VersionMinor   = header_size < sizeof(hdr) ? 1 : PTRACE_VERSION_MINOR;
+    hdr.HeaderSize     = header_size;
+    hdr.ProcessId      = 42;
+    hdr.ClockFrequency = 1000000000ULL;
+    hdr.TaskSampleRate = sample_rate;
+    file.assign((uint8_t const*) &hdr, (uint8_t const*) &hdr + header_size);
+}
+
+/// @summary Append a block to an in-memory .ptrace file.
+/// @param file The file data.
+/// @param block_type One of PTRACE_BLOCK_TYPE, or an unknown value.
+/// @param thread_id The operating system identifier of the thread that produced the data.
+/// @param count The number of items in the block.
+/// @param first_time The timestamp of the first item in the block.
+/// @param last_time The timestamp of the last item in the block.
+/// @param data The block data.
+/// @param size The number of bytes of block data.
+internal_function void
+AppendTestPtraceBlock
+(
+    std::vector<uint8_t> &file,
+    uint32_t        block_type,
+    uint32_t         thread_id,
+    uint32_t             count,
+    uint64_t        first_time,
+    uint64_t         last_time,
+    void const           *data,
+    size_t                size
+)
+{
+    PTRACE_BLOCK_HEADER blk;
+    blk.Magic        = PTRACE_BLOCK_MAGIC;
+    blk.BlockType    = block_type;
+    blk.ThreadId     = thread_id;
+    blk.EventCount   = count;
+    blk.DataSize     = uint32_t(size);
+    blk.DroppedCount = 0;
+    blk.FirstTime    = first_time;
+    blk.LastTime     = last_time;
+    file.insert(file.end(), (uint8_t const*) &blk, (uint8_t const*) &blk + sizeof(blk));
+    if (size > 0) file.insert(file.end(), (uint8_t const*) data, (uint8_t const*) data + size);
+}
+
+/// @summary Encode a run of task events and append them to an in-memory .ptrace file as a single event block.
+/// @param file The file data.
+/// @param thread_id The operating system identifier of the thread that produced the events.
+/// @param events The events to encode, in time order.
+/// @param count The number of events.
+/// @param dependencies The dependencies of all of the task definitions in events, in event order.
+internal_function void
+AppendTestPtraceEvents
+(
+    std::vector<uint8_t> &file,
+    uint32_t         thread_id,
+    PTRACE_EVENT const *events,
+    size_t               count,
+    uint32_t const *dependencies
+)
+{
+    std::vector<uint8_t> data(count * (PTRACE_MAX_EVENT_SIZE + 2 * PTRACE_MAX_DEPENDENCY_SIZE));
+    PTRACE_CODEC_STATE   codec;
+    uint8_t             *dst = &data[0];
+    PtraceResetCodecState(&codec, events[0].Timestamp);
+    for (size_t i = 0; i < count; ++i)
+    {
+        dst = PtraceEncodeEvent(dst, &codec, &events[i], dependencies);
+        dependencies += events[i].DependencyCount;
+    }
+    AppendTestPtraceBlock(file, PTRACE_BLOCK_TYPE_EVENTS, thread_id, uint32_t(count), events[0].Timestamp, events[count - 1].Timestamp, &data[0], size_t(dst - &data[0]));
+}
+
+/// @summary Load an in-memory .ptrace file with a single loader thread.
+/// @param file The file data.
+/// @param size The number of bytes of file data to load.
+/// @param sample_rate On return, the task sample rate of the file.
+/// @param thread_count On return, the number of threads that produced events.
+/// @return The number of task events loaded, or SIZE_MAX if the file was rejected.
+internal_function size_t
+LoadTestPtraceFile
+(
+    std::vector<uint8_t> const &file,
+    size_t                      size,
+    uint32_t            &sample_rate,
+    size_t             &thread_count
+)
+{
+    WIN32_PROFILER_EVENTS *rtev = new WIN32_PROFILER_EVENTS();
+    size_t                count = SIZE_MAX;
+    if (LoadPtraceEvents(rtev, &file[0], size, 1))
+    {
+        count        = rtev->TaskEvents.EventCount;
+        sample_rate  = rtev->TaskSampleRate;
+        thread_count = rtev->ProcessList.ProcessInfo[0].ThreadCount;
+        for (size_t i = 1; i < count; ++i) assert(rtev->TaskEvents.EventTime[i - 1] <= rtev->TaskEvents.EventTime[i]);
+    }
+    delete rtev;
+    return count;
+}
+
+/// @summary Verify that loading a multi-thread .ptrace file with one thread and with several threads produces identical, time-ordered
+/// columns and dependency lists. Every thread has events at the same timestamps, and pairs of events within a thread share a timestamp.
+/// Also verify header parsing, including the short header of files before minor version 2, and that the block walk skips unknown and
+/// invalid blocks and keeps the blocks before a truncated block or a bad block magic.
+internal_function void
+TestPtraceLoader
+(
+    void
+)
+{
+    size_t const          thread_count = 4;
+    size_t const          block_count  = 3;
+    size_t const          block_size   = 100;
+    size_t const          event_count  = block_count * block_size;
+    std::vector<PTRACE_EVENT> events[thread_count];
+    std::vector<uint32_t>     deps  [thread_count];
+    std::vector<size_t>       first [thread_count];
+    std::vector<uint8_t>      file;
+    size_t                    dep_total = 0;
+
+    for (size_t t = 0; t < thread_count; ++t)
+    {   // each task is defined, made ready, launched and finished in turn, and depends on up to two of the tasks before it.
+        for (size_t k = 0; k < event_count; ++k)
+        {
+            PTRACE_EVENT ev;
+            uint32_t const n = uint32_t(k / 4);
+            memset(&ev, 0, sizeof(ev));
+            ev.Timestamp = 1000 + (k / 2) * 10;
+            ev.EventType = uint32_t(k % 4);
+            ev.TaskId    = uint32_t((t + 1) * 1000) + n;
+            first[t].push_back(deps[t].size());
+            if (ev.EventType == PTRACE_EVENT_TYPE_DEFINE_TASK)
+            {
+                ev.ParentId        = n > 0 ? ev.TaskId - 1 : INVALID_TASK_ID;
+                ev.SourceIndex     = uint32_t(t);
+                ev.EntryPoint      = 0x1000 + (n % 3) * 0x10;
+                ev.DependencyCount = (n % 3) < n ? (n % 3) : n;
+                for (uint32_t j = 0; j < ev.DependencyCount; ++j) deps[t].push_back(ev.TaskId - 1 - j);
+            }
+            if (ev.EventType == PTRACE_EVENT_TYPE_TASK_READY_TO_RUN)
+                ev.SourceIndex = uint32_t(t);
+            events[t].push_back(ev);
+        }
+        dep_total += deps[t].size();
+    }
+    InitTestPtraceFile(file, sizeof(PTRACE_FILE_HEADER), 1);
+    for (size_t b = 0; b < block_count; ++b)
+    {   // blocks of different threads are interleaved, as they are written by the flush thread.
+        for (size_t t = 0; t < thread_count; ++t)
+        {
+            size_t const k = b * block_size;
+            AppendTestPtraceEvents(file, uint32_t(100 + t), &events[t][k], block_size, deps[t].data() + first[t][k]);
+        }
+    }
+
+    // with four loader threads the short partitions give sixteen merge partitions.
+    WIN32_PROFILER_EVENTS *serial   = new WIN32_PROFILER_EVENTS();
+    WIN32_PROFILER_EVENTS *parallel = new WIN32_PROFILER_EVENTS();
+    assert(IsPtraceFile(&file[0], file.size()));
+    assert(LoadPtraceEvents(serial  , &file[0], file.size(), 1));
+    assert(LoadPtraceEvents(parallel, &file[0], file.size(), 4));
+    WIN32_TASK_EVENT_LIST const &a = serial->TaskEvents;
+    WIN32_TASK_EVENT_LIST const &b = parallel->TaskEvents;
+    assert(a.EventCount == thread_count * event_count && b.EventCount == a.EventCount);
+    assert(a.DependencyStart[a.EventCount] == dep_total && a.Dependencies.size() == dep_total);
+    assert(a.EventTime   == b.EventTime   && a.EventType  == b.EventType  && a.TaskId     == b.TaskId);
+    assert(a.ThreadId    == b.ThreadId    && a.SourceIndex == b.SourceIndex && a.ParentId == b.ParentId && a.EntryPoint == b.EntryPoint);
+    assert(a.DependencyStart == b.DependencyStart && a.Dependencies == b.Dependencies);
+    for (size_t i = 1; i < a.EventCount; ++i)
+    {   // equal timestamps keep the order of the threads in the file, then the order within each thread.
+        assert(a.EventTime[i - 1] <= a.EventTime[i]);
+        assert(a.EventTime[i - 1] <  a.EventTime[i] || a.ThreadId[i - 1] <= a.ThreadId[i]);
+    }
+    for (size_t i = 0; i < a.EventCount; ++i)
+    {   // every definition keeps its own dependencies.
+        if (a.EventType[i] != PTRACE_EVENT_TYPE_DEFINE_TASK)
+            continue;
+        for (uint32_t d = a.DependencyStart[i], j = 0; d < a.DependencyStart[i + 1]; ++d, ++j)
+            assert(a.Dependencies[d] == a.TaskId[i] - 1 - j);
+    }
+    assert(serial->TaskTable.TaskCount == thread_count * event_count / 4 && parallel->TaskTable.TaskCount == serial->TaskTable.TaskCount);
+    delete parallel;
+    delete serial;
+
+    // thread 100 has three blocks. the second claims two more events than it holds, so its decoded events are moved up to close the gap.
+    // an unknown block type is skipped, and so is an event block whose count can't fit in its data.
+    std::vector<uint8_t> fmt;
+    PTRACE_BLOCK_HEADER  blk;
+    uint32_t const       unknown[4] = { 1, 2, 3, 4 };
+    uint32_t             rate = 0;
+    size_t               threads = 0;
+    size_t               count_ofs = 0;
+    size_t               short_ofs = 0;
+    size_t               tail_ofs = 0;
+    InitTestPtraceFile(fmt, sizeof(PTRACE_FILE_HEADER), 8);
+    AppendTestPtraceEvents(fmt, 100, &events[0][0], 4, deps[0].data() + first[0][0]);
+    AppendTestPtraceBlock (fmt, 99, 100, 1, 0, 0, unknown, sizeof(unknown));
+    count_ofs = fmt.size();
+    AppendTestPtraceEvents(fmt, 102, &events[2][0], 4, deps[2].data() + first[2][0]);
+    memcpy(&blk, &fmt[count_ofs], sizeof(blk));
+    blk.EventCount = (blk.DataSize / 2) + 1;
+    memcpy(&fmt[count_ofs], &blk, sizeof(blk));
+    AppendTestPtraceEvents(fmt, 101, &events[1][0], 4, deps[1].data() + first[1][0]);
+    short_ofs = fmt.size();
+    AppendTestPtraceEvents(fmt, 100, &events[0][4], 4, deps[0].data() + first[0][4]);
+    memcpy(&blk, &fmt[short_ofs], sizeof(blk));
+    assert(blk.DataSize >= 12);
+    blk.EventCount = 6;
+    memcpy(&fmt[short_ofs], &blk, sizeof(blk));
+    AppendTestPtraceEvents(fmt, 100, &events[0][8], 4, deps[0].data() + first[0][8]);
+    tail_ofs = fmt.size();
+    AppendTestPtraceEvents(fmt, 101, &events[1][4], 4, deps[1].data() + first[1][4]);
+    assert(LoadTestPtraceFile(fmt, fmt.size(), rate, threads) == 20 && rate == 8 && threads == 2);
+
+    // a block cut short by the end of the file, or with a bad magic, ends the walk; everything before it is kept.
+    assert(LoadTestPtraceFile(fmt, fmt.size() - 3, rate, threads) == 16 && threads == 2);
+    assert(LoadTestPtraceFile(fmt, tail_ofs + sizeof(blk) - 1, rate, threads) == 16);
+    fmt[short_ofs] ^= 0xFF;
+    assert(LoadTestPtraceFile(fmt, fmt.size(), rate, threads) == 8 && threads == 2);
+    fmt[short_ofs] ^= 0xFF;
+
+    // the header is rejected if any of the required fields are invalid, or if it doesn't fit in the file.
+    for (size_t c = 0; c < 5; ++c)
+    {
+        std::vector<uint8_t> bad(fmt);
+        PTRACE_FILE_HEADER   hdr;
+        memcpy(&hdr, &bad[0], sizeof(hdr));
+        if (c == 0) hdr.Magic ^= 1;
+        if (c == 1) hdr.VersionMajor++;
+        if (c == 2) hdr.HeaderSize = uint32_t(offsetof(PTRACE_FILE_HEADER, TaskSampleRate) - 4);
+        if (c == 3) hdr.HeaderSize = uint32_t(bad.size() + 1);
+        if (c == 4) hdr.ClockFrequency = 0;
+        memcpy(&bad[0], &hdr, sizeof(hdr));
+        assert(LoadTestPtraceFile(bad, bad.size(), rate, threads) == SIZE_MAX);
+    }
+    assert(LoadTestPtraceFile(fmt, offsetof(PTRACE_FILE_HEADER, TaskSampleRate) - 1, rate, threads) == SIZE_MAX);
+
+    // a header written before minor version 2 ends before TaskSampleRate, and the first block follows it directly.
+    std::vector<uint8_t> old;
+    InitTestPtraceFile(old, uint32_t(offsetof(PTRACE_FILE_HEADER, TaskSampleRate)), 8);
+    AppendTestPtraceEvents(old, 100, &events[0][0], 4, deps[0].data() + first[0][0]);
+    memcpy(&blk, &old[offsetof(PTRACE_FILE_HEADER, TaskSampleRate)], sizeof(blk));
+    assert(blk.Magic == PTRACE_BLOCK_MAGIC);
+    assert(LoadTestPtraceFile(old, old.size(), rate, threads) == 4 && rate == 1 && threads == 1);
+    assert( IsPtraceFile(&old[0], old.size()) && !IsPtraceFile(&old[0], 3));
+    old[0] ^= 1;
+    assert(!IsPtraceFile(&old[0], old.size()));
+    printf("ptrace loader: %u events, %u dependencies, 1 and 4 loader threads agree.\n", unsigned(thread_count * event_count), unsigned(dep_total));
+}
+
+/// @summary Verify that an object index finds the record alive at the query time when identifiers are reused.
+internal_function void
+TestObjectIndexReuse
+(
+    void
+)
+{
+    std::vector<uint32_t>       keys;
+    std::vector<WIN32_LIFETIME> lifetimes;
+    WIN32_OBJECT_INDEX          index;
+    size_t                      found = 0;
+    InitObjectIndex(index);
+    for (uint32_t i = 0; i < 1000; ++i)
+    {   // thread IDs 0..99 are each reused ten times with disjoint lifetimes; the last use is still alive.
+        WIN32_LIFETIME life;
+        uint64_t       base = uint64_t(i / 100) * 1000;
+        InitObjectLifetime(life, base + 1, i >= 900 ? 0 : base + 999);
+        keys.push_back(i % 100);
+        lifetimes.push_back(life);
+        ObjectIndexInsert(index, keys.back(), i);
+    }
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        uint64_t time = (uint64_t(i / 100) * 1000) + 500;
+        assert(FindObjectInIndex(index, lifetimes.data(), i % 100, time, found));
+        assert(found == i);
+    }
+    assert(!FindObjectInIndex(index, lifetimes.data(), 5, 1000, found)); // between lifetimes.
+    assert(!FindObjectInIndex(index, lifetimes.data(), 100, 500, found)); // unknown key.
+    assert( FindObjectInIndex(index, lifetimes.data(), 7, 99999, found) && found == 907);
+    printf("object index: %u keys in %u slots.\n", unsigned(index.KeyCount), unsigned(index.SlotCount));
+}
+
+/// @summary Verify decoder plan offsets for a synthetic CSwitch payload and a schema with a variable-size property.
+internal_function void
+TestEventDecoderPlan
+(
+    void
+)
+{   // NewThreadId, OldThreadId, 8 single-byte fields, NewThreadWaitTime, Reserved.
+    uint32_t const cswitch[12] = { 4, 4, 1, 1, 1, 1, 1, 1, 1, 1, 4, 4 };
+    uint32_t const  string[ 3] = { 4, WIN32_EVENT_FIELD_VARIABLE, 4 };
+    uint8_t        payload[24];
+    uint32_t       value;
+    for (size_t i = 0; i < sizeof(payload); ++i) payload[i] = uint8_t(0x80 + i);
+    value = 1234; memcpy(&payload[ 0], &value, 4);
+    value = 5678; memcpy(&payload[ 4], &value, 4);
+    value = 9999; memcpy(&payload[16], &value, 4);
+
+    WIN32_EVENT_DECODER_CACHE cache;
+    WIN32_EVENT_DECODER_PLAN  plan;
+    WIN32_EVENT_SCHEMA_KEY    key_a, key_b;
+    memset(&key_a, 0, sizeof(key_a)); key_a.Opcode = 36; key_a.Version = 2; key_a.PointerSize = 8;
+    memset(&key_b, 0, sizeof(key_b)); key_b.Opcode = 50; key_b.Version = 2; key_b.PointerSize = 8;
+    InitEventDecoderCache(&cache);
+    assert(FindEventDecoderPlan(&cache, key_a) == NULL);
+    InitEventDecoderPlan(&plan, cswitch, 12);
+    InsertEventDecoderPlan(&cache, key_a, &plan);
+    InitEventDecoderPlan(&plan, string, 3);
+    InsertEventDecoderPlan(&cache, key_b, &plan);
+
+    WIN32_EVENT_DECODER_PLAN const *p = FindEventDecoderPlan(&cache, key_a);
+    assert(p != NULL && p->FixedCount == 12 && p->PayloadSize == 24);
+    assert(EventDecoderGetUInt32(p, payload,  0) == 1234);
+    assert(EventDecoderGetUInt32(p, payload,  1) == 5678);
+    assert(EventDecoderGetSInt8 (p, payload,  9) == int8_t(0x80 + 15));
+    assert(EventDecoderGetUInt32(p, payload, 10) == 9999);
+    assert(!EventDecoderHasField(p, 20, 11)); // truncated payload.
+    p = FindEventDecoderPlan(&cache, key_b);
+    assert(p != NULL && p->FieldCount == 3 && p->FixedCount == 1);
+    assert( EventDecoderHasField(p, 24, 0));
+    assert(!EventDecoderHasField(p, 24, 2)); // follows a string, so it needs the slow path.
+    DeleteEventDecoderCache(&cache);
+    printf("event decoder: plans verified.\n");
+}
+
+/// @summary Verify task table construction, including a reused task identifier and a task whose definition was lost.
+internal_function void
+TestTaskTable
+(
+    void
+)
+{
+    WIN32_TASK_EVENT_LIST events;
+    WIN32_TASK_TABLE      table;
+    task_id_t             deps[2] = { 1, 2 };
+    size_t                row = 0;
+    size_t                lower = 0, upper = 0, count = 0;
+    InitTaskEventList(&events);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_DEFINE_TASK , 10, 1, 100, 0, INVALID_TASK_ID, 0x1000, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_DEFINE_TASK , 20, 2, 100, 0, 1, 0x2000, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_DEFINE_TASK , 30, 3, 100, 1, 1, 0x3000, deps, 2);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_READY_TO_RUN, 40, 1, 100, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_LAUNCH      , 50, 1, 200, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_FINISH      , 60, 1, 200, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_DEFINE_TASK , 70, 1, 100, 2, INVALID_TASK_ID, 0x4000, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_LAUNCH      , 80, 9, 300, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_LAUNCH      , 90, 1, 300, 0, INVALID_TASK_ID, 0, NULL, 0);
+    assert(events.EventCount == 9 && events.DependencyStart[3] == 2);
+    BuildTaskTable(&table, &events);
+    assert(table.TaskCount == 5);
+    assert(FindTaskById(&table, 1, row) && row == 3 && table.LaunchTime[row] == 90);
+    assert(FindTaskByIdAndTime(&table, 1, 65, row) && row == 0);
+    assert(table.ReadyTime[0] == 40 && table.FinishTime[0] == 60 && table.WorkerThreadId[0] == 200);
+    assert(table.ParentId[2] == 1 && table.EntryPoint[2] == 0x3000 && table.SourceIndex[2] == 1);
+    assert(FindTaskById(&table, 9, row) && row == 4 && table.DefineTime[row] == 0); // definition lost.
+    assert(!FindTaskById(&table, 7, row));
+    assert(FindEventsInTimeRange(table.LaunchSortedTime.data(), table.LaunchSortedTime.size(), 75, 95, lower, upper, count));
+    assert(count == 2 && table.LaunchSortedRow[lower] == 4 && table.LaunchSortedRow[upper] == 3);
+    printf("task table: %u rows from %u events.\n", unsigned(table.TaskCount), unsigned(events.EventCount));
+}
+
+/// @summary Verify the task dependency graph for a join task with hundreds of dependencies, a reused task identifier and a dependency that was never defined.
+internal_function void
+TestTaskDependencyGraph
+(
+    void
+)
+{
+    WIN32_TASK_EVENT_LIST  events;
+    WIN32_TASK_TABLE       table;
+    std::vector<task_id_t> deps;
+    task_id_t              reuse = 5;
+    InitTaskEventList(&events);
+    for (task_id_t i = 1; i <= 300; ++i)
+    {   // rows 0..299.
+        AppendTaskEvent(&events, WIN32_TASK_EVENT_DEFINE_TASK, 10 + i, i, 100, 0, INVALID_TASK_ID, 0x1000, NULL, 0);
+        deps.push_back(i);
+    }
+    deps.push_back(777);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_DEFINE_TASK, 400, 1000, 100, 0, INVALID_TASK_ID, 0x2000, deps.data(), deps.size());
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_DEFINE_TASK, 410, reuse, 100, 0, INVALID_TASK_ID, 0x3000, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_DEFINE_TASK, 420, 2000, 100, 0, INVALID_TASK_ID, 0x4000, &reuse, 1);
+    BuildTaskTable(&table, &events);
+    BuildTaskDependencyGraph(&table, &events);
+    assert(table.TaskCount == 303 && table.UnresolvedCount == 1);
+    assert(table.DependencyStart[300] == 0 && table.DependencyStart[301] == 300 && table.DependencyStart[303] == 301);
+    assert(table.DependencyRow[0] == 0 && table.DependencyRow[299] == 299);
+    assert(table.DependencyRow[300] == 301); // the newest definition of the reused identifier.
+    assert(table.SuccessorStart[5] - table.SuccessorStart[4] == 1 && table.SuccessorRow[table.SuccessorStart[4]] == 300);
+    assert(table.SuccessorStart[302] - table.SuccessorStart[301] == 1 && table.SuccessorRow[table.SuccessorStart[301]] == 302);
+    assert(table.SuccessorStart[303] == 301);
+    printf("task dependency graph: %u edges, %u unresolved.\n", unsigned(table.DependencyRow.size()), unsigned(table.UnresolvedCount));
+}
+
+/// @summary Verify the span, work, slack and critical path of a small graph with a spawned child and a join task.
+internal_function void
+TestCriticalPath
+(
+    void
+)
+{
+    WIN32_TASK_EVENT_LIST events;
+    WIN32_TASK_TABLE      table;
+    WIN32_CRITICAL_PATH   cp = {};
+    task_id_t             deps[2] = { 1, 2 };
+    InitTaskEventList(&events);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_DEFINE_TASK, 100, 1, 100, 0, INVALID_TASK_ID, 0x1000, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_DEFINE_TASK, 105, 3, 100, 0, INVALID_TASK_ID, 0x3000, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_LAUNCH     , 110, 1, 200, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_DEFINE_TASK, 120, 2, 200, 0, 1, 0x2000, NULL, 0); // spawned 10ns into task 1.
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_LAUNCH     , 130, 2, 300, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_FINISH     , 160, 2, 300, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_FINISH     , 210, 1, 200, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_DEFINE_TASK, 220, 4, 200, 0, INVALID_TASK_ID, 0x4000, deps, 2);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_LAUNCH     , 230, 4, 200, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_FINISH     , 280, 4, 200, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_LAUNCH     , 300, 3, 300, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_FINISH     , 320, 3, 300, 0, INVALID_TASK_ID, 0, NULL, 0);
+    BuildTaskTable(&table, &events);
+    BuildTaskDependencyGraph(&table, &events);
+    assert(table.ParentRow[2] == 0 && table.ParentRow[0] == WIN32_OBJECT_INDEX_EMPTY);
+    BuildCriticalPath(&cp, &table, 110, LodBaseShift(110, 320));
+    assert(cp.TotalWork == 200 && cp.Span == 150);
+    assert(cp.EarliestStart[2] == 10 && cp.EarliestStart[3] == 100);
+    assert(cp.Slack[0] == 0 && cp.Slack[1] == 130 && cp.Slack[2] == 60 && cp.Slack[3] == 0);
+    assert(cp.PathRow.size() == 2 && cp.PathRow[0] == 0 && cp.PathRow[1] == 3);
+    assert(cp.EntryPointCount == 2 && cp.EntryPoint[0] == 0x1000 && cp.EntryPointTime[0] == 100);
+    assert(cp.PathLod.LevelCount > 0);
+    printf("critical path: %u of %u tasks, %.2fx maximum speedup.\n", unsigned(cp.PathRow.size()), unsigned(cp.TaskCount), cp.MaxSpeedup);
+    DeleteCriticalPath(&cp);
+}
+
+/// @summary Verify the predicted makespan of a small graph replayed with each scheduling policy.
+internal_function void
+TestScheduleReplay
+(
+    void
+)
+{
+    WIN32_TASK_EVENT_LIST  events;
+    WIN32_TASK_TABLE       table;
+    WIN32_SCHEDULER_REPLAY replay;
+    task_id_t              deps[2] = { 1, 2 };
+    InitTaskEventList(&events);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_DEFINE_TASK, 100, 1, 100, 0, INVALID_TASK_ID, 0x1000, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_DEFINE_TASK, 105, 3, 100, 0, INVALID_TASK_ID, 0x3000, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_LAUNCH     , 110, 1, 200, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_DEFINE_TASK, 120, 2, 200, 0, 1, 0x2000, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_LAUNCH     , 130, 2, 300, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_FINISH     , 160, 2, 300, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_FINISH     , 210, 1, 200, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_DEFINE_TASK, 220, 4, 200, 0, INVALID_TASK_ID, 0x4000, deps, 2);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_LAUNCH     , 230, 4, 200, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_FINISH     , 280, 4, 200, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_LAUNCH     , 300, 3, 300, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_FINISH     , 320, 3, 300, 0, INVALID_TASK_ID, 0, NULL, 0);
+    BuildTaskTable(&table, &events);
+    BuildTaskDependencyGraph(&table, &events);
+    for (uint32_t policy = 0; policy < WIN32_SCHEDULER_POLICY_COUNT; ++policy)
+    {   // a single worker is never idle once the first task is submitted.
+        ReplaySchedule(&replay, &table, 1, policy, 0);
+        assert(replay.TaskCount == 4 && replay.Makespan == 200 && replay.BusyTime == 200 && replay.ObservedMakespan == 220);
+    }
+    ReplaySchedule(&replay, &table, 2, WIN32_SCHEDULER_POLICY_FIFO, 0);
+    assert(replay.Makespan == 170 && replay.StealCount == 0); // task 4 is submitted at 120, after its dependencies finish.
+    ReplaySchedule(&replay, &table, 2, WIN32_SCHEDULER_POLICY_WORK_STEALING, 5);
+    assert(replay.Makespan == 170 && replay.StealCount == 1); // the child of task 1 is stolen at 25 and finishes at 60.
+
+    // task 1 takes the most time, but only task 4 delays the end of the schedule.
+    WIN32_VIRTUAL_SPEEDUP_REPORT report;
+    RankVirtualSpeedups(&report, &table, 2, WIN32_SCHEDULER_POLICY_FIFO, 0, 50, 0, 2);
+    assert(report.BaselineMakespan == 170 && report.EntryCount == 4);
+    assert(report.Entries[0].EntryPoint == 0x4000 && report.Entries[0].MakespanChange == -25 && report.Entries[0].Efficiency == 1.0);
+    assert(report.Entries[1].EntryPoint == 0x1000 && report.Entries[1].MakespanChange == 0 && report.Entries[1].TaskTime == 100);
+    RankVirtualSpeedups(&report, &table, 2, WIN32_SCHEDULER_POLICY_FIFO, 0, 50, 2, 2);
+    assert(report.EntryCount == 2 && report.Entries[0].EntryPoint == 0x4000 && report.Entries[1].EntryPoint == 0x1000);
+    printf("schedule replay: %u tasks, %.3f utilization on %u workers.\n", unsigned(replay.TaskCount), replay.Utilization, replay.WorkerCount);
+}
+
+/// @summary Verify that identical strings are stored once, and that similar DLL paths neither collide nor share an identifier.
+internal_function void
+TestStringTable
+(
+    void
+)
+{
+    WIN32_MEMORY_ARENA arena;
+    WIN32_STRING_TABLE table;
+    std::vector<uint64_t> hashes;
+    WCHAR              path[64];
+    InitMemoryArena(&arena, 4096);
+    InitStringTable(&table);
+    assert(InternWideString(&table, &arena, NULL, 0) == WIN32_STRING_ID_NONE);
+    for (int i = 0; i < 2000; ++i)
+    {   // paths differing in a single digit collided often under the old rotate-and-add hash.
+        swprintf(path, 64, L"C:\\Windows\\System32\\api-ms-win-core-%04d.dll", i);
+        assert(InternWideString(&table, &arena, path, wcslen(path)) == string_id_t(i + 1));
+        hashes.push_back(table.Hash[i + 1]);
+    }
+    swprintf(path, 64, L"C:\\Windows\\System32\\api-ms-win-core-%04d.dll", 1234);
+    size_t const used = arena.BytesUsed;
+    assert(InternWideString(&table, &arena, path, wcslen(path)) == 1235 && arena.BytesUsed == used);
+    assert(FindInternedString(&table, path, wcslen(path)) == 1235);
+    assert(FindInternedString(&table, L"missing.dll", 11) == WIN32_STRING_ID_NONE);
+    assert(wcscmp(InternedString(&table, 1235), path) == 0 && table.StringCount == 2001);
+    std::sort(hashes.begin(), hashes.end());
+    assert(std::unique(hashes.begin(), hashes.end()) == hashes.end());
+    printf("string table: %u strings in %u bytes over %u arena chunks.\n", unsigned(table.StringCount - 1), unsigned(arena.BytesUsed), unsigned(arena.Chunks.size()));
+    DeleteMemoryArena(&arena);
+    assert(arena.Chunks.empty() && arena.BytesReserved == 0);
+}
+
+/// @summary Verify that an analysis cache round-trips the loaded columns and analyses as views of the mapped cache file, and is
+/// rejected when the trace file changes.
+internal_function void
+TestAnalysisCacheRoundTrip
+(
+    void
+)
+{
+    WIN32_PROFILER_EVENTS *src = new WIN32_PROFILER_EVENTS();
+    WIN32_PROFILER_EVENTS *dst = new WIN32_PROFILER_EVENTS();
+    WIN32_PROFILER_EVENTS *bad = new WIN32_PROFILER_EVENTS();
+    WCHAR                  exe[] = L"app.exe";
+    uint8_t                trace[100];
+    std::vector<uint8_t>   data;
+    PLATFORM_FILE_MAPPING  map;
+    FILE                  *fp = tmpfile();
+    size_t                 row = 0;
+    long                   size = 0;
+    memset(trace, 0xAB, sizeof(trace));
+    src->PointerSize = 8; src->TimerResolution = 1; src->ClockFrequency.QuadPart = 1000000000; src->DroppedEventCount = 3; src->TaskSampleRate = 4;
+    src->ProcessList.ProcessCount = 1;
+    src->ProcessList.ProcessId.push_back(42);
+    src->ProcessList.ProcessNameId.push_back(InternWideString(&src->Strings, &src->Arena, exe, wcslen(exe)));
+    src->ProcessList.ProcessLifetime.push_back(WIN32_LIFETIME{ 0, ~uint64_t(0) });
+    src->ProcessList.ProcessInfo.resize(1);
+    InitObjectIndex(src->ProcessList.ProcessIndex);
+    ObjectIndexInsert(src->ProcessList.ProcessIndex, 42, 0);
+    WIN32_PROCESS_INFO &pinfo = src->ProcessList.ProcessInfo[0];
+    pinfo.ProcessId   = 42;
+    pinfo.Executable  = InternedString(&src->Strings, src->ProcessList.ProcessNameId[0]);
+    pinfo.ThreadCount = 1;
+    pinfo.ThreadId.push_back(7);
+    pinfo.ThreadLifetime.push_back(WIN32_LIFETIME{ 5, 95 });
+    pinfo.ThreadInfo.resize(1);
+    pinfo.ThreadInfo[0].ThreadId = 7;
+    pinfo.ThreadInfo[0].EntryPointName = NULL;
+    pinfo.ThreadInfo[0].ReadyCount = 2;
+    pinfo.ThreadInfo[0].ReadyTimes.push_back(10);
+    pinfo.ThreadInfo[0].ReadyTimes.push_back(30);
+    pinfo.ImageCount  = 0;
+    InitObjectIndex(pinfo.ThreadIndex);
+    InitObjectIndex(pinfo.ImageAddressIndex);
+    InitObjectIndex(pinfo.ImagePathIndex);
+    ObjectIndexInsert(pinfo.ThreadIndex, 7, 0);
+    InitTaskEventList(&src->TaskEvents);
+    AppendTaskEvent(&src->TaskEvents, WIN32_TASK_EVENT_DEFINE_TASK, 10, 1, 7, 0, INVALID_TASK_ID, 0x1000, NULL, 0);
+    AppendTaskEvent(&src->TaskEvents, WIN32_TASK_EVENT_LAUNCH     , 20, 1, 7, 0, INVALID_TASK_ID, 0, NULL, 0);
+    BuildTaskTable(&src->TaskTable, &src->TaskEvents);
+    TaskTableAddAllocations(&src->TaskTable, 40, 1, 3, 96, 112);
+    src->Scheduler.ComputePoolSize = 4; src->Scheduler.GeneralPoolSize = 2; src->Scheduler.WorkerCount = 0;
+    src->Scheduler.SourceCount = 1;
+    src->Scheduler.SourceIndex.push_back(0);
+    src->Scheduler.SourceThreadId.push_back(7);
+    src->Scheduler.SourceName.push_back("main");
+    InitZoneEventList(&src->ZoneEvents);
+    SetZoneSite(&src->ZoneEvents, 2, "parse", "load.cc", "Load", 17);
+    AppendZoneEvent(&src->ZoneEvents, WIN32_ZONE_EVENT_BEGIN, 21, 7, 2);
+    AppendZoneEvent(&src->ZoneEvents, WIN32_ZONE_EVENT_END  , 29, 7, 2);
+    uint64_t const counter_values[WIN32_TASK_COUNTER_COUNT] = { 900, 1800, 0, 4, 0 };
+    InitTaskCounterList(&src->TaskCounters);
+    AppendTaskCounters(&src->TaskCounters, 40, 1, 7, 0x0B, counter_values);
+
+    BuildProfilerAnalyses(src);
+
+    assert(fp != NULL && WriteAnalysisCache(src, fp, sizeof(trace), 1234, AnalysisCacheSourceHash(trace, sizeof(trace))));
+    fseek(fp, 0, SEEK_END); size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    data.resize(size_t(size));
+    assert(fread(&data[0], 1, data.size(), fp) == data.size());
+    assert(PlatformMapFile(fp, &map, true) && map.Size == data.size());
+    fclose(fp);
+
+    assert(LoadAnalysisCache(dst, map.Data, map.Size, sizeof(trace), 1234, AnalysisCacheSourceHash(trace, sizeof(trace))));
+    assert(dst->TaskEvents.EventTime.data() >= (uint64_t const*) map.Data && dst->TaskEvents.EventTime.data() < (uint64_t const*)(map.Data + map.Size));
+    assert(InternedString(&dst->Strings, dst->ProcessList.ProcessNameId[0]) >= (WCHAR const*) map.Data && InternedString(&dst->Strings, dst->ProcessList.ProcessNameId[0]) < (WCHAR const*)(map.Data + map.Size));
+    assert(dst->DroppedEventCount == 3 && dst->ClockFrequency.QuadPart == 1000000000 && dst->TaskSampleRate == 4);
+    assert(dst->ProcessList.ProcessCount == 1 && wcscmp(dst->ProcessList.ProcessInfo[0].Executable, exe) == 0);
+    assert(dst->ProcessList.ProcessNameId[0] == src->ProcessList.ProcessNameId[0]);
+    assert(dst->ProcessList.ProcessInfo[0].ThreadInfo[0].ReadyTimes[1] == 30);
+    assert(dst->ProcessList.ProcessInfo[0].ThreadInfo[0].EntryPointName == NULL);
+    assert(ObjectIndexFirst(dst->ProcessList.ProcessInfo[0].ThreadIndex, 7) == 0);
+    assert(FindTaskById(&dst->TaskTable, 1, row) && dst->TaskTable.LaunchTime[row] == 20);
+    assert(dst->TaskTable.AllocCount[row] == 3 && dst->TaskTable.AllocBytes[row] == 96 && dst->TaskTable.FreeBytes[row] == 112);
+    assert(dst->Scheduler.SourceName[0] == "main");
+    assert(dst->ZoneEvents.EventCount == 2 && dst->ZoneEvents.EventTime[1] == 29 && dst->ZoneEvents.SiteCount == 3);
+    assert(dst->ZoneEvents.SiteName[2] == "parse" && dst->ZoneEvents.SiteFunction[2] == "Load" && dst->ZoneEvents.SiteLine[2] == 17 && dst->ZoneEvents.SiteName[0].empty());
+    assert(dst->TaskCounters.SampleCount == 1 && dst->TaskCounters.CounterMask[0] == 0x0B && dst->TaskCounters.Value[WIN32_TASK_COUNTER_LLC_MISSES] == 4);
+    assert(dst->TaskTable.DependencyStart == src->TaskTable.DependencyStart && dst->TaskTable.ParentRow == src->TaskTable.ParentRow);
+    assert(dst->ProcessList.ProcessInfo[0].ThreadInfo[0].Intervals.Start == src->ProcessList.ProcessInfo[0].ThreadInfo[0].Intervals.Start);
+    assert(dst->CriticalPath.Span == src->CriticalPath.Span && dst->CriticalPath.EarliestStart == src->CriticalPath.EarliestStart);
+    assert(dst->TimelineLod.FirstTime == src->TimelineLod.FirstTime && dst->TimelineLod.ThreadCount == src->TimelineLod.ThreadCount);
+    assert(dst->AllocReport.AllocBytes == src->AllocReport.AllocBytes && dst->CounterReport.TaskValue == src->CounterReport.TaskValue);
+    dst->TaskTable.LaunchTime[row] = 25; // views of a copy-on-write mapping can be modified in place.
+    assert(!LoadAnalysisCache(bad, &data[0], data.size() - 1, sizeof(trace), 1234, AnalysisCacheSourceHash(trace, sizeof(trace))));
+    assert(!LoadAnalysisCache(bad, &data[0], data.size(), sizeof(trace), 1235, AnalysisCacheSourceHash(trace, sizeof(trace))));
+    trace[50] ^= 1; // the sampled hash covers every page of a small file.
+    assert(!LoadAnalysisCache(bad, &data[0], data.size(), sizeof(trace), 1234, AnalysisCacheSourceHash(trace, sizeof(trace))));
+    printf("analysis cache: %u bytes round-tripped.\n", unsigned(data.size()));
+    DeleteMemoryArena(&bad->Arena);
+    DeleteMemoryArena(&dst->Arena);
+    DeleteMemoryArena(&src->Arena);
+    delete bad;
+    delete dst;
+    delete src;
+    PlatformUnmapFile(&map);
+}
+
+/// @summary Verify that snapshots expose only the published prefix of both event streams, and that a held snapshot survives later publications.
+internal_function void
+TestProfilerSnapshot
+(
+    void
+)
+{
+    WIN32_SNAPSHOT_PUBLISHER     *pub = new WIN32_SNAPSHOT_PUBLISHER();
+    WIN32_PROFILER_SNAPSHOT const *s0 = NULL;
+    WIN32_PROFILER_SNAPSHOT const *s1 = NULL;
+    size_t const                    n = WIN32_SNAPSHOT_CHUNK_SIZE * 2 + 10;
+    size_t                      lower = 0, upper = 0, count = 0;
+    InitSnapshotPublisher(pub, 100);
+    assert(AcquireProfilerSnapshot(pub, 0) == NULL);
+    for (size_t i = 0; i < WIN32_SNAPSHOT_CHUNK_SIZE; ++i)
+    {
+        SnapshotAppendTaskEvent(pub, WIN32_TASK_EVENT_LAUNCH, uint64_t(i) * 10, task_id_t(i), 1);
+    }
+    assert(!ProfilerSnapshotDue(pub, 50) && ProfilerSnapshotDue(pub, 100));
+    PublishProfilerSnapshot(pub, 100, 0.25f, 1, 2, 3, false);
+    s0 = AcquireProfilerSnapshot(pub, 0);
+    for (size_t i = WIN32_SNAPSHOT_CHUNK_SIZE; i < n; ++i)
+    {   // the reader keeps seeing the first chunk only, even though its memory is shared with later snapshots.
+        SnapshotAppendTaskEvent(pub, WIN32_TASK_EVENT_FINISH, uint64_t(i) * 10, task_id_t(i), 1);
+    }
+    PublishProfilerSnapshot(pub, 200, 0.5f, 1, 2, 3, false);
+    assert(s0->Epoch == 1 && s0->EventCount == WIN32_SNAPSHOT_CHUNK_SIZE && s0->ChunkCount == 1);
+    assert(pub->Retired.size() == 1); // still held by reader 0.
+    assert(FindSnapshotEventsInTimeRange(s0, 0, uint64_t(n) * 10, lower, upper, count) && count == WIN32_SNAPSHOT_CHUNK_SIZE);
+    ReleaseProfilerSnapshot(pub, 0);
+
+    s1 = AcquireProfilerSnapshot(pub, 1);
+    assert(s1->Epoch == 2 && s1->EventCount == n && s1->ChunkCount == 3 && !s1->Complete);
+    assert(s1->FirstTime == 0 && s1->LastTime == uint64_t(n - 1) * 10);
+    assert(FindSnapshotEventsInTimeRange(s1, uint64_t(WIN32_SNAPSHOT_CHUNK_SIZE) * 10 - 5, uint64_t(WIN32_SNAPSHOT_CHUNK_SIZE) * 20 + 5, lower, upper, count));
+    assert(lower == WIN32_SNAPSHOT_CHUNK_SIZE && upper == WIN32_SNAPSHOT_CHUNK_SIZE * 2 && count == WIN32_SNAPSHOT_CHUNK_SIZE + 1);
+    assert(SnapshotEventTime(s1, upper) == uint64_t(upper) * 10);
+    assert(!FindSnapshotEventsInTimeRange(s1, uint64_t(n) * 10, uint64_t(n) * 20, lower, upper, count));
+    assert(s1->SchedEventCount == 0 && !FindSnapshotSchedEventsInTimeRange(s1, 0, uint64_t(n) * 10, lower, upper, count));
+    ReleaseProfilerSnapshot(pub, 1);
+
+    // scheduling events are published alongside, and widen the time span of the snapshot.
+    for (size_t i = 0; i < WIN32_SNAPSHOT_CHUNK_SIZE + 2; ++i)
+    {
+        SnapshotAppendSchedEvent(pub, uint8_t(i % 3), uint64_t(i) * 30 + 5, 4, uint32_t(i & 7), uint16_t(i & 3));
+    }
+    PublishProfilerSnapshot(pub, 250, 0.75f, 1, 2, 3, false);
+    s1 = AcquireProfilerSnapshot(pub, 1);
+    assert(s1->EventCount == n && s1->SchedEventCount == WIN32_SNAPSHOT_CHUNK_SIZE + 2 && s1->SchedChunkCount == 2);
+    assert(s1->FirstTime == 0 && s1->LastTime == uint64_t(WIN32_SNAPSHOT_CHUNK_SIZE + 1) * 30 + 5);
+    assert(FindSnapshotSchedEventsInTimeRange(s1, uint64_t(WIN32_SNAPSHOT_CHUNK_SIZE) * 30, uint64_t(WIN32_SNAPSHOT_CHUNK_SIZE) * 30 + 40, lower, upper, count));
+    assert(lower == WIN32_SNAPSHOT_CHUNK_SIZE && upper == WIN32_SNAPSHOT_CHUNK_SIZE + 1 && count == 2 && SnapshotSchedEventTime(s1, lower) == uint64_t(lower) * 30 + 5);
+    assert(s1->SchedChunks[1]->ThreadId[1] == ((WIN32_SNAPSHOT_CHUNK_SIZE + 1) & 7) && s1->SchedChunks[1]->Processor[1] == ((WIN32_SNAPSHOT_CHUNK_SIZE + 1) & 3));
+    ReleaseProfilerSnapshot(pub, 1);
+    PublishProfilerSnapshot(pub, 300, 0.5f, 1, 2, 3, true);
+    assert(pub->Retired.empty() && pub->Current.load()->Complete && pub->Current.load()->Progress == 1.0f);
+    printf("snapshot: %u events in %u chunks over %u epochs.\n", unsigned(n), unsigned(pub->Chunks.size()), unsigned(pub->Current.load()->Epoch));
+    DeleteSnapshotPublisher(pub);
+    delete pub;
+}
+
+/// @summary Verify that the scheduling columns of a thread merge into the expected intervals, that long intervals are split, and that lookups agree with a linear search.
+internal_function void
+TestThreadIntervals
+(
+    void
+)
+{
+    WIN32_THREAD_INFO     thread;
+    WIN32_SWITCH_OUT_DATA wait;
+    WIN32_SWITCH_OUT_DATA preempt;
+    size_t                index = 0;
+
+    wait.Processor    = 0; wait.State    = 5; wait.WaitReason    = 6; wait.WaitMode    = 0; wait.Priority    = 8;
+    preempt.Processor = 0; preempt.State = 1; preempt.WaitReason = 0; preempt.WaitMode = 0; preempt.Priority = 8;
+
+    // run, block, get readied, run, get preempted (and readied at the same instant), run until the end.
+    thread.ReadyTimes    = { 300, 400 };
+    thread.SwitchInTime  = { 100, 320, 410 };
+    thread.SwitchOutTime = { 150, 400 };
+    thread.SwitchOutData = { wait, preempt };
+    BuildThreadIntervals(&thread, 500);
+    WIN32_THREAD_INTERVALS const &iv = thread.Intervals;
+    assert(iv.IntervalCount == 6 && iv.IndexStart.size() == 1 && iv.IndexStart[0] == 100);
+    assert(iv.State[0] == WIN32_THREAD_STATE_RUNNING && iv.Start[0] == 100 && iv.Duration[0] ==  50);
+    assert(iv.State[1] == WIN32_THREAD_STATE_WAITING && iv.Start[1] == 150 && iv.Duration[1] == 150 && iv.WaitReason[1] == 6);
+    assert(iv.State[2] == WIN32_THREAD_STATE_READY   && iv.Start[2] == 300 && iv.Duration[2] ==  20 && iv.WaitReason[2] == 6);
+    assert(iv.State[3] == WIN32_THREAD_STATE_RUNNING && iv.Start[3] == 320 && iv.Duration[3] ==  80);
+    assert(iv.State[4] == WIN32_THREAD_STATE_READY   && iv.Start[4] == 400 && iv.Duration[4] ==  10 && iv.WaitReason[4] == WIN32_WAIT_REASON_NONE);
+    assert(iv.State[5] == WIN32_THREAD_STATE_RUNNING && iv.Start[5] == 410 && iv.Duration[5] ==  90);
+    assert(!FindThreadInterval(&iv, 99, index) && !FindThreadInterval(&iv, 500, index));
+    assert( FindThreadInterval(&iv, 150, index) && index == 1 && FindThreadInterval(&iv, 409, index) && index == 4);
+
+    // a wait longer than a 32-bit duration is split into consecutive pieces.
+    uint64_t const long_wait = 10000000000ULL;
+    thread.ReadyTimes.clear();
+    thread.SwitchInTime  = { 1000, 2000 + long_wait };
+    thread.SwitchOutTime = { 2000 };
+    thread.SwitchOutData = { wait };
+    BuildThreadIntervals(&thread, 2100 + long_wait);
+    assert(iv.IntervalCount == 5 && iv.State[1] == WIN32_THREAD_STATE_WAITING && iv.State[3] == WIN32_THREAD_STATE_WAITING);
+    assert(iv.Duration[1] == 0xFFFFFFFFU && iv.Duration[2] == 0xFFFFFFFFU && iv.Start[3] + iv.Duration[3] == 2000 + long_wait);
+    assert(FindThreadInterval(&iv, 2000 + long_wait - 1, index) && index == 3);
+
+    // enough intervals to need several index blocks; every lookup must agree with a linear search.
+    thread.SwitchInTime.clear();
+    thread.SwitchOutTime.clear();
+    thread.SwitchOutData.clear();
+    for (uint64_t k = 1; k <= 100; ++k)
+    {
+        thread.SwitchInTime.push_back(k * 1000);
+        thread.SwitchOutTime.push_back(k * 1000 + 600);
+        thread.SwitchOutData.push_back(wait);
+    }
+    BuildThreadIntervals(&thread, 101000);
+    assert(iv.IntervalCount == 200 && iv.IndexStart.size() == 4 && iv.IndexStart[1] == iv.Start[WIN32_THREAD_INTERVAL_INDEX_STRIDE]);
+    for (uint64_t t = 0; t < 102000; t += 50)
+    {
+        size_t expect = iv.IntervalCount;
+        for (size_t i = 0; i < iv.IntervalCount; ++i)
+        {
+            if (t >= iv.Start[i] && t < iv.Start[i] + iv.Duration[i]) expect = i;
+        }
+        bool const found = FindThreadInterval(&iv, t, index);
+        assert(found == (expect != iv.IntervalCount) && (!found || index == expect));
+    }
+    printf("thread intervals: %u intervals in %u index blocks.\n", unsigned(iv.IntervalCount), unsigned(iv.IndexStart.size()));
+    DeleteThreadIntervals(&thread.Intervals);
+}
+
+/// @summary Verify that switch-in events are regrouped by processor, that overlapping segments are clipped, that segments are labeled with the
+/// task their thread was executing, and that the per-core lookup finds the segment running on each core.
+internal_function void
+TestCpuTimeline
+(
+    void
+)
+{
+    WIN32_PROCESS_LIST    procs;
+    WIN32_TASK_EVENT_LIST events;
+    WIN32_TASK_TABLE      table;
+    WIN32_CPU_TIMELINE    cpu;
+    WIN32_SWITCH_IN_DATA  in0 = { 0, 0, 8 };
+    WIN32_SWITCH_IN_DATA  in1 = { 0, 1, 8 };
+    WIN32_SWITCH_OUT_DATA out = { 0, 5, 6, 0, 8 };
+    uint32_t              seg[2];
+
+    // thread 10 runs on core 0 and then core 1; thread 20 runs on core 1, overlapping thread 10 because of a lost event, then on core 0.
+    procs.ProcessCount = 1;
+    procs.ProcessInfo.resize(1);
+    WIN32_PROCESS_INFO &proc = procs.ProcessInfo[0];
+    proc.ProcessId   = 4;
+    proc.ThreadCount = 2;
+    proc.ThreadId    = { 10, 20 };
+    proc.ThreadInfo.resize(2);
+    proc.ThreadLifetime.resize(2);
+    proc.ThreadLifetime[0].DestroyTime = 0;
+    proc.ThreadLifetime[1].DestroyTime = 0;
+    proc.ThreadInfo[0].SwitchInTime  = { 100, 300 };
+    proc.ThreadInfo[0].SwitchInData  = { in0, in1 };
+    proc.ThreadInfo[0].SwitchOutTime = { 200, 400 };
+    proc.ThreadInfo[0].SwitchOutData = { out, out };
+    proc.ThreadInfo[1].SwitchInTime  = { 150, 320 };
+    proc.ThreadInfo[1].SwitchInData  = { in1, in0 };
+    proc.ThreadInfo[1].SwitchOutTime = { 310, 350 };
+    proc.ThreadInfo[1].SwitchOutData = { out, out };
+    InitTaskEventList(&events);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_LAUNCH, 120, 1, 10, 0, INVALID_TASK_ID, 0x1000, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_LAUNCH, 140, 2, 20, 0, INVALID_TASK_ID, 0x2000, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_FINISH, 180, 1, 10, 0, INVALID_TASK_ID, 0x1000, NULL, 0);
+    BuildTaskTable(&table, &events);
+    BuildProcessThreadIntervals(&procs);
+    BuildCpuTimeline(&cpu, &procs, &table, 100, WIN32_LOD_MIN_SHIFT);
+
+    // core 0: [100, 200) thread 10 running task 1, launched within the segment; [320, 350) thread 20, still running task 2.
+    // core 1: [150, 300) thread 20 running task 2, clipped from 310; [300, 400) thread 10 after task 1 finished.
+    assert(cpu.ProcessorCount == 2 && cpu.SegmentCount == 4 && cpu.ProcessorStart[1] == 2 && cpu.ProcessorStart[2] == 4);
+    assert(cpu.Start[0] == 100 && cpu.End[0] == 200 && cpu.ThreadId[0] == 10 && cpu.TaskRow[0] == 0);
+    assert(cpu.Start[1] == 320 && cpu.End[1] == 350 && cpu.ThreadId[1] == 20 && cpu.TaskRow[1] == 1 && cpu.ThreadIndex[1] == 1);
+    assert(cpu.Start[2] == 150 && cpu.End[2] == 300 && cpu.ThreadId[2] == 20 && cpu.TaskRow[2] == 1);
+    assert(cpu.Start[3] == 300 && cpu.End[3] == 400 && cpu.ThreadId[3] == 10 && cpu.TaskRow[3] == WIN32_OBJECT_INDEX_EMPTY);
+    assert(FindCpuSegmentsAtTime(&cpu, 175, seg) == 2 && seg[0] == 0 && seg[1] == 2);
+    assert(FindCpuSegmentsAtTime(&cpu, 250, seg) == 1 && seg[0] == WIN32_OBJECT_INDEX_EMPTY && seg[1] == 2);
+    assert(FindCpuSegmentsAtTime(&cpu, 300, seg) == 1 && seg[1] == 3);
+    assert(FindCpuSegmentsAtTime(&cpu, 400, seg) == 0 && FindCpuSegmentsAtTime(&cpu, 99, seg) == 0);
+    assert(cpu.ProcessorLod.size() == 2 && cpu.ProcessorLod[0].LevelCount > 0);
+    printf("cpu timeline: %u segments on %u cores.\n", unsigned(cpu.SegmentCount), unsigned(cpu.ProcessorCount));
+    DeleteCpuTimeline(&cpu);
+}
+
+/// @summary Verify the log-linear bucket boundaries, percentiles and merging of latency histograms, and the pairing of ready events with switch-ins.
+internal_function void
+TestWakeLatency
+(
+    void
+)
+{
+    WIN32_LATENCY_HISTOGRAM odd  = {};
+    WIN32_LATENCY_HISTOGRAM even = {};
+    WIN32_LATENCY_HISTOGRAM all  = {};
+    WIN32_PROCESS_LIST      procs;
+    WIN32_SCHEDULER_INFO    sched;
+    WIN32_WAKE_LATENCY      wl;
+    WIN32_SWITCH_IN_DATA    in  = { 0, 0, 8 };
+    WIN32_SWITCH_OUT_DATA   out = { 0, 5, 6, 0, 8 };
+
+    // small values are exact; larger values land in a bucket no wider than 1/32 of the value.
+    assert(LatencyHistogramBucket(31) == 31 && LatencyHistogramBucket(32) == 32 && LatencyHistogramBucket(64) == 64 && LatencyHistogramBucket(65) == 64);
+    assert(LatencyHistogramBucketLow(64) == 64 && LatencyHistogramBucketLow(65) == 66);
+    for (uint64_t v = 1; v < (uint64_t(1) << 40); v = v * 3 + 1)
+    {
+        size_t   const b  = LatencyHistogramBucket(v);
+        uint64_t const lo = LatencyHistogramBucketLow(b);
+        uint64_t const hi = LatencyHistogramBucketLow(b + 1);
+        assert(lo <= v && v < hi && (hi - lo) * 32 <= (v > 32 ? v : 32));
+    }
+    for (uint64_t v = 1; v <= 100000; ++v)
+    {
+        LatencyHistogramAdd((v & 1) ? &odd : &even, v);
+        LatencyHistogramAdd(&all, v);
+    }
+    MergeLatencyHistogram(&odd, &even);
+    assert(odd.Count == all.Count && odd.Total == all.Total && odd.Min == 1 && odd.Max == 100000 && odd.Bucket == all.Bucket);
+    uint64_t const p50 = LatencyHistogramPercentile(&odd, 50.0);
+    uint64_t const p99 = LatencyHistogramPercentile(&odd, 99.0);
+    assert(p50 >= 50000 && p50 <= 50000 + 50000 / 32 && p99 >= 99000 && p99 <= 100000 && LatencyHistogramPercentile(&odd, 100.0) == 100000);
+
+    // thread 10 is a worker in pool 1: woken after 50 ns; woken twice while waiting and run after 100 ns; readied while running, which
+    // is not a wakeup; then readied at the instant it blocks, run 1.5 ms later, and blocked again. thread 20 is not a worker, and is woken
+    // once after 7 ns and once with no latency at all.
+    procs.ProcessCount = 1;
+    procs.ProcessInfo.resize(1);
+    WIN32_PROCESS_INFO &proc = procs.ProcessInfo[0];
+    proc.ProcessId   = 4;
+    proc.ThreadCount = 2;
+    proc.ThreadId    = { 10, 20 };
+    proc.ThreadInfo.resize(2);
+    proc.ThreadLifetime.resize(2);
+    proc.ThreadLifetime[0].DestroyTime = 0;
+    proc.ThreadLifetime[1].DestroyTime = 0;
+    proc.ThreadInfo[0].ReadyTimes    = { 100, 300, 310, 420, 500 };
+    proc.ThreadInfo[0].SwitchInTime  = { 150, 400, 1500500 };
+    proc.ThreadInfo[0].SwitchInData  = { in, in, in };
+    proc.ThreadInfo[0].SwitchOutTime = { 200, 500, 1500600 };
+    proc.ThreadInfo[0].SwitchOutData = { out, out, out };
+    proc.ThreadInfo[1].ReadyTimes    = { 10, 40 };
+    proc.ThreadInfo[1].SwitchInTime  = { 17, 40 };
+    proc.ThreadInfo[1].SwitchInData  = { in, in };
+    proc.ThreadInfo[1].SwitchOutTime = { 30 };
+    proc.ThreadInfo[1].SwitchOutData = { out };
+    sched.WorkerCount    = 1;
+    sched.WorkerThreadId = { 10 };
+    sched.WorkerPoolId   = { 1 };
+    sched.WorkerPoolIndex= { 0 };
+    BuildProcessThreadIntervals(&procs);
+    BuildWakeLatency(&wl, &procs, &sched, 1000000);
+    assert(wl.All.Count == 5 && wl.All.Min == 0 && wl.All.Max == 1500000 && wl.All.Total == 50 + 100 + 1500000 + 7);
+    assert(wl.PoolCount == 2 && wl.PoolId[0] == 1 && wl.PoolId[1] == WIN32_WAKE_LATENCY_NO_POOL && wl.PoolHistogram[0].Count == 3 && wl.PoolHistogram[1].Count == 2);
+    assert(wl.ThreadCount == 2 && wl.ThreadIndex[0] == 0 && wl.ThreadPoolId[0] == 1 && wl.ThreadIndex[1] == 1 && wl.ThreadHistogram[1].Max == 7);
+    assert(wl.SlowCount == 1 && wl.SlowLatency[0] == 1500000 && wl.SlowReadyTime[0] == 500 && wl.SlowThread[0] == 0);
+    BuildWakeLatency(&wl, &procs, &sched, 60);
+    assert(wl.SlowCount == 2 && wl.SlowLatency[1] == 100 && wl.SlowReadyTime[1] == 300);
+    printf("wake latency: %u wakeups, p99 %.1f us, %u slow.\n", unsigned(wl.All.Count), double(LatencyHistogramPercentile(&wl.All, 99.0)) / 1000.0, unsigned(wl.SlowCount));
+    DeleteWakeLatency(&wl);
+}
+
+/// @summary Verify that blocked intervals end at the next ready event or switch-in, that preemptions are not counted, that a wait split across
+/// several intervals counts once, and that blocked time is grouped by wait reason for the thread and for the entry point of the running task.
+internal_function void
+TestOffCpuReport
+(
+    void
+)
+{
+    WIN32_PROCESS_LIST    procs;
+    WIN32_TASK_EVENT_LIST events;
+    WIN32_TASK_TABLE      table;
+    WIN32_OFF_CPU_REPORT  oc;
+    WIN32_SWITCH_IN_DATA  in       = { 0, 0, 8 };
+    WIN32_SWITCH_OUT_DATA user     = { 0, 5,  6, 1, 8 };
+    WIN32_SWITCH_OUT_DATA preempt  = { 0, 1,  0, 0, 8 };
+    WIN32_SWITCH_OUT_DATA page_in  = { 0, 5,  9, 0, 8 };
+    WIN32_SWITCH_OUT_DATA alert    = { 0, 5, 37, 1, 8 };
+    WIN32_SWITCH_OUT_DATA queue    = { 0, 5, 15, 0, 8 };
+
+    // thread 10 runs task 1 in [100, 1000): it blocks on a user request for 100 ns, is preempted, takes a 50 ns page fault, is readied at
+    // the instant it blocks, and finally blocks on a queue from 1400 until it exits at 2000. thread 20 never blocks.
+    procs.ProcessCount = 1;
+    procs.ProcessInfo.resize(1);
+    WIN32_PROCESS_INFO &proc = procs.ProcessInfo[0];
+    proc.ProcessId   = 4;
+    proc.ThreadCount = 2;
+    proc.ThreadId    = { 10, 20 };
+    proc.ThreadInfo.resize(2);
+    proc.ThreadLifetime.resize(2);
+    proc.ThreadLifetime[0].DestroyTime = 2000;
+    proc.ThreadLifetime[1].DestroyTime = 0;
+    proc.ThreadInfo[0].ReadyTimes    = { 300, 1200 };
+    proc.ThreadInfo[0].SwitchInTime  = { 50, 350, 450, 650, 1300 };
+    proc.ThreadInfo[0].SwitchInData  = { in, in, in, in, in };
+    proc.ThreadInfo[0].SwitchOutTime = { 200, 400, 600, 1200, 1400 };
+    proc.ThreadInfo[0].SwitchOutData = { user, preempt, page_in, alert, queue };
+    proc.ThreadInfo[1].SwitchInTime  = { 100 };
+    proc.ThreadInfo[1].SwitchInData  = { in };
+    InitTaskEventList(&events);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_DEFINE_TASK, 90, 1, 10, 0, INVALID_TASK_ID, 0x1000, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_LAUNCH,     100, 1, 10, 0, INVALID_TASK_ID, 0x1000, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_FINISH,    1000, 1, 10, 0, INVALID_TASK_ID, 0x1000, NULL, 0);
+    BuildTaskTable(&table, &events);
+    BuildProcessThreadIntervals(&procs);
+    BuildOffCpuReport(&oc, &procs, &table);
+
+    assert(oc.All.Count == 3 && oc.All.Total == 100 + 50 + 600);
+    assert(oc.ReasonHistogram[6].Total == 100 && oc.ReasonUserTime[6] == 100 && oc.ReasonHistogram[9].Total == 50 && oc.ReasonUserTime[9] == 0);
+    assert(oc.ReasonHistogram[15].Total == 600 && oc.ReasonHistogram[37].Count == 0 && oc.ReasonHistogram[1].Count == 0);
+    assert(oc.ThreadCount == 1 && oc.ThreadIndex[0] == 0 && oc.ThreadHistogram[0].Max == 600 && oc.ThreadReasonTime[15] == 600);
+    assert(OffCpuTopReason(&oc.ThreadReasonTime[0]) == 15 && strcmp(WaitReasonName(15), "WrQueue") == 0 && strcmp(WaitReasonName(99), "Other") == 0);
+    assert(oc.TaskBlockedTime[0] == 150 && oc.EntryPointCount == 1 && oc.EntryPoint[0] == 0x1000 && oc.EntryPointTime[0] == 150);
+    assert(oc.EntryPointReasonTime[6] == 100 && oc.EntryPointReasonTime[9] == 50 && OffCpuTopReason(&oc.EntryPointReasonTime[0]) == 6);
+    printf("off-cpu: %u blocked intervals, %.3f us blocked.\n", unsigned(oc.All.Count), double(oc.All.Total) / 1000.0);
+
+    // a wait longer than one interval can hold is still a single blocked span.
+    uint64_t const long_wait = 10000000000ULL;
+    proc.ThreadCount = 1;
+    proc.ThreadId    = { 10 };
+    proc.ThreadInfo.resize(1);
+    proc.ThreadLifetime.resize(1);
+    proc.ThreadLifetime[0].DestroyTime = 0;
+    proc.ThreadInfo[0].ReadyTimes    = { 2000 + long_wait };
+    proc.ThreadInfo[0].SwitchInTime  = { 1000, 2100 + long_wait };
+    proc.ThreadInfo[0].SwitchInData  = { in, in };
+    proc.ThreadInfo[0].SwitchOutTime = { 2000 };
+    proc.ThreadInfo[0].SwitchOutData = { user };
+    BuildProcessThreadIntervals(&procs);
+    BuildOffCpuReport(&oc, &procs, &table);
+    assert(procs.ProcessInfo[0].ThreadInfo[0].Intervals.IntervalCount == 5 && procs.ProcessInfo[0].ThreadInfo[0].Intervals.WaitMode[1] == 1);
+    assert(oc.All.Count == 1 && oc.All.Total == long_wait && oc.ReasonUserTime[6] == long_wait && oc.TaskBlockedTime[0] == 0);
+    DeleteOffCpuReport(&oc);
+}
+
+/// @summary Verify that the ready backlog of each series changes only when its depth does, that launches are applied before ready events
+/// at the same time, that tasks launched as soon as they are ready are never queued, and that step pyramids keep the peak and the mean.
+internal_function void
+TestQueueDepth
+(
+    void
+)
+{
+    uint64_t const        step_time [3] = { 0, 1024, 2048 };
+    uint32_t const        step_value[3] = { 2, 4, 0 };
+    float                 peak[2];
+    float                 mean[2];
+    WIN32_STEP_PYRAMID    pyr;
+    WIN32_TASK_EVENT_LIST events;
+    WIN32_TASK_TABLE      table;
+    WIN32_SCHEDULER_INFO  sched;
+    WIN32_QUEUE_DEPTH     qd;
+
+    BuildStepPyramid(&pyr, step_time, step_value, 3, 4096, 0, 10);
+    assert(pyr.LevelCount == 3 && pyr.MaxValue[1] == 4 && pyr.MeanValue[1] == 4.0f && pyr.MaxValue[4] == 4 && pyr.MeanValue[4] == 3.0f && pyr.MeanValue[6] == 1.5f);
+    assert(SampleStepPyramid(&pyr, 0, 4096, 2, peak, mean) == 0 && peak[0] == 4.0f && mean[0] == 3.0f && peak[1] == 0.0f);
+    assert(SampleStepPyramid(&pyr, 0, 4096, 1, peak, mean) == 1 && peak[0] == 4.0f && mean[0] == 1.5f);
+    DeleteStepPyramid(&pyr);
+
+    // task 1 (source 0) and task 2 (source 1) queue at 100 and 200 and are launched together at 300 by workers of pools 0 and 1, as task 3
+    // (source 0) is queued; it is never launched. task 4 (source 1) is launched as soon as it is ready.
+    sched.WorkerCount    = 2;
+    sched.WorkerThreadId = { 10, 11 };
+    sched.WorkerPoolId   = { 0, 1 };
+    InitTaskEventList(&events);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_DEFINE_TASK,   50, 1,  1, 0, INVALID_TASK_ID, 0x1000, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_DEFINE_TASK,   60, 2,  2, 1, INVALID_TASK_ID, 0x1000, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_READY_TO_RUN, 100, 1,  1, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_READY_TO_RUN, 200, 2,  2, 1, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_DEFINE_TASK,  250, 3,  1, 0, INVALID_TASK_ID, 0x1000, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_DEFINE_TASK,  260, 4,  2, 1, INVALID_TASK_ID, 0x1000, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_LAUNCH,       300, 1, 10, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_LAUNCH,       300, 2, 11, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_READY_TO_RUN, 300, 3,  1, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_READY_TO_RUN, 350, 4,  2, 1, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_LAUNCH,       350, 4, 10, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_FINISH,       400, 1, 10, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_FINISH,       500, 2, 11, 0, INVALID_TASK_ID, 0, NULL, 0);
+    BuildTaskTable(&table, &events);
+    BuildQueueDepth(&qd, &table, &sched, 0, 10);
+
+    // series are the total, sources 0 and 1, pools 0 and 1, and the tasks with no pool.
+    assert(qd.TaskCount == 4 && qd.PendingCount == 1 && qd.EndTime == 500 && qd.SeriesCount == 6);
+    assert(qd.SeriesKind[1] == WIN32_QUEUE_SERIES_SOURCE && qd.SeriesKey[2] == 1 && qd.SeriesKind[3] == WIN32_QUEUE_SERIES_POOL && qd.SeriesKey[5] == WIN32_QUEUE_DEPTH_NO_POOL);
+    assert(qd.SeriesStart[1] == 3 && qd.StepTime[2] == 300 && qd.StepDepth[2] == 1 && qd.SeriesMaxDepth[0] == 2 && qd.SeriesMaxTime[0] == 200);
+    assert(qd.SeriesStart[2] - qd.SeriesStart[1] == 1 && qd.SeriesStart[3] - qd.SeriesStart[2] == 2 && qd.SeriesStart[6] - qd.SeriesStart[5] == 1);
+    assert(QueueDepthAtTime(&qd, 0, 50) == 0 && QueueDepthAtTime(&qd, 0, 250) == 2 && QueueDepthAtTime(&qd, 0, 450) == 1 && QueueDepthAtTime(&qd, 4, 250) == 1);
+    assert(qd.SeriesDelay[0].Count == 3 && qd.SeriesDelay[0].Max == 200 && qd.SeriesDelay[0].Min == 0 && qd.SeriesDelay[2].Total == 100 && qd.SeriesDelay[5].Count == 0);
+    assert(qd.SeriesLod[0].LevelCount == 1 && qd.SeriesLod[0].MaxValue[0] == 2);
+    printf("queue depth: %u series, peak %u tasks queued.\n", unsigned(qd.SeriesCount), qd.SeriesMaxDepth[0]);
+    DeleteQueueDepth(&qd);
+}
+
+/// @summary Verify the running task counts of each pool, range queries against them, and that a partitioned sweep matches a serial one.
+internal_function void
+TestParallelismProfile
+(
+    void
+)
+{
+    WIN32_TASK_EVENT_LIST     events;
+    WIN32_TASK_TABLE          table;
+    WIN32_SCHEDULER_INFO      sched;
+    WIN32_PARALLELISM_PROFILE profile;
+    WIN32_PARALLELISM_PROFILE serial;
+    WIN32_STEP_RANGE          range;
+
+    // pool 0 has workers 10 and 11, which run tasks 1-3; task 3 starts as task 1 finishes. worker 12 of pool 1 launches
+    // task 4, which never finishes, and thread 99 is not a registered worker.
+    sched.WorkerCount    = 3;
+    sched.WorkerThreadId = { 10, 11, 12 };
+    sched.WorkerPoolId   = { 0, 0, 1 };
+    InitTaskEventList(&events);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_LAUNCH, 100, 1, 10, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_LAUNCH, 200, 2, 11, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_LAUNCH, 250, 4, 12, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_FINISH, 300, 1, 10, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_LAUNCH, 300, 3, 10, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_FINISH, 400, 2, 11, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_LAUNCH, 500, 5, 99, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_FINISH, 550, 5, 99, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_FINISH, 600, 3, 10, 0, INVALID_TASK_ID, 0, NULL, 0);
+    BuildTaskTable(&table, &events);
+    BuildParallelismProfile(&profile, &table, &sched, 1);
+    assert(profile.PoolCount == 3 && profile.PoolId[1] == 1 && profile.PoolId[2] == WIN32_QUEUE_DEPTH_NO_POOL && profile.FirstTime == 100 && profile.EndTime == 600);
+    assert(profile.PoolWorkerCount[0] == 2 && profile.PoolWorkerCount[2] == 0 && profile.PoolSaturatedTime[0] == 200 && profile.PoolSaturatedTime[1] == 350);
+
+    WIN32_STEP_FUNCTION const &pool0 = profile.PoolRunning[0];
+    assert(pool0.StepCount == 4 && pool0.Time[2] == 400 && pool0.Value[1] == 2 && pool0.Value[3] == 0 && profile.PoolRunning[2].StepCount == 2);
+    assert(StepFunctionValueAt(&pool0, 50) == 0 && StepFunctionValueAt(&pool0, 300) == 2 && StepFunctionValueAt(&profile.PoolRunning[1], 599) == 1);
+    StepFunctionRange(&pool0, 0, 600, &range);
+    assert(range.Min == 0 && range.Max == 2 && range.Mean == 700.0 / 600.0);
+    StepFunctionRange(&pool0, 150, 450, &range);
+    assert(range.Min == 1 && range.Max == 2 && range.Mean == 500.0 / 300.0);
+    DeleteParallelismProfile(&profile);
+
+    // enough tasks to split the sweep into partitions, with bursts of launches sharing a timestamp, compared against a brute-force
+    // scan for the range queries and against a serial sweep for the steps.
+    uint32_t const task_count = 100000;
+    table.TaskCount = task_count;
+    table.LaunchTime.assign(task_count, 0);
+    table.FinishTime.assign(task_count, 0);
+    table.WorkerThreadId.assign(task_count, 0);
+    table.LaunchSortedTime.clear(); table.LaunchSortedRow.clear();
+    table.FinishSortedTime.clear(); table.FinishSortedRow.clear();
+    std::vector<std::pair<uint64_t, uint32_t> > finish;
+    for (uint32_t r = 0; r < task_count; ++r)
+    {
+        table.LaunchTime[r]     = 1000 + (r / 3) * 10;
+        table.FinishTime[r]     = (r % 97 == 0) ? 0 : table.LaunchTime[r] + 5 + (r * 7919) % 400;
+        table.WorkerThreadId[r] = 10 + r % 4;
+        table.LaunchSortedTime.push_back(table.LaunchTime[r]);
+        table.LaunchSortedRow.push_back(r);
+        if (table.FinishTime[r] != 0) finish.push_back(std::make_pair(table.FinishTime[r], r));
+    }
+    std::sort(finish.begin(), finish.end());
+    for (size_t i = 0; i < finish.size(); ++i)
+    {
+        table.FinishSortedTime.push_back(finish[i].first);
+        table.FinishSortedRow.push_back(finish[i].second);
+    }
+    BuildParallelismProfile(&profile, &table, &sched, 4);
+    BuildParallelismProfile(&serial , &table, &sched, 1);
+    assert(profile.PoolCount == 3 && serial.PoolCount == 3);
+    for (size_t k = 0; k < profile.PoolCount; ++k)
+    {
+        assert(profile.PoolRunning[k].Time  == serial.PoolRunning[k].Time);
+        assert(profile.PoolRunning[k].Value == serial.PoolRunning[k].Value);
+        assert(profile.PoolSaturatedTime[k] == serial.PoolSaturatedTime[k]);
+    }
+    WIN32_STEP_FUNCTION const &f = profile.PoolRunning[0];
+    for (uint64_t i = 0; i < 64; ++i)
+    {
+        uint64_t const lower = 900 + (i * 104729) % 330000;
+        uint64_t const upper = lower + 1 + (i * i * 7727) % 40000;
+        uint32_t       lo    = 0xFFFFFFFFU;
+        uint32_t       hi    = 0;
+        for (size_t s = 0; s <= f.StepCount; ++s)
+        {   // each step, plus the zero before the first step and after the end, that overlaps [lower, upper).
+            uint64_t const start = (s == 0) ? 0 : f.Time[s - 1];
+            uint64_t const end   = (s == f.StepCount) ? f.EndTime : f.Time[s];
+            uint32_t const value = (s == 0) ? 0 : f.Value[s - 1];
+            if (start < upper && end > lower && end > start) { if (value < lo) lo = value; if (value > hi) hi = value; }
+        }
+        if (upper > f.EndTime) lo = 0;
+        StepFunctionRange(&f, lower, upper, &range);
+        assert(range.Min == lo && range.Max == hi);
+    }
+    printf("parallelism: %u pools, %u steps in pool 0, %llu ns saturated.\n", unsigned(profile.PoolCount), unsigned(f.StepCount), (unsigned long long) profile.PoolSaturatedTime[0]);
+    DeleteParallelismProfile(&serial);
+    DeleteParallelismProfile(&profile);
+}
+
+/// @summary Verify the zone event codec, and that zones nest by thread, attach to the enclosing task and recover from lost events.
+internal_function void
+TestZoneTree
+(
+    void
+)
+{
+    PTRACE_CODEC_STATE    codec;
+    PTRACE_ZONE_EVENT     zin[3] = { { 1000, 1, 0 }, { 1004, 70000, 0 }, { 1000000, 70000, 1 } };
+    PTRACE_ZONE_EVENT     zout;
+    uint8_t               buf[3 * PTRACE_MAX_ZONE_EVENT_SIZE];
+    uint8_t              *dst = buf;
+    uint8_t const        *src = buf;
+    WIN32_TASK_EVENT_LIST events;
+    WIN32_TASK_TABLE      table;
+    WIN32_ZONE_EVENT_LIST zones;
+    WIN32_ZONE_TREE       tree;
+
+    PtraceResetCodecState(&codec, 1000);
+    for (size_t i = 0; i < 3; ++i) dst = PtraceEncodeZoneEvent(dst, &codec, &zin[i]);
+    PtraceResetCodecState(&codec, 1000);
+    for (size_t i = 0; i < 3; ++i)
+    {
+        assert((src = PtraceDecodeZoneEvent(src, dst, &codec, &zout)) != NULL);
+        assert(zout.Timestamp == zin[i].Timestamp && zout.SiteId == zin[i].SiteId && zout.IsEnd == zin[i].IsEnd);
+    }
+    assert(src == dst && PtraceDecodeZoneEvent(src, dst, &codec, &zout) == NULL);
+
+    // thread 10 runs task 1 over [100, 500): zone 1 encloses two zones of site 2, then an end with no begin arrives. zone 1 opens
+    // again after the task, and the end of the site 2 zone inside it is lost. thread 20 runs no task; its events are interleaved.
+    InitTaskEventList(&events);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_LAUNCH, 100, 1, 10, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_FINISH, 500, 1, 10, 0, INVALID_TASK_ID, 0, NULL, 0);
+    BuildTaskTable(&table, &events);
+    InitZoneEventList(&zones);
+    SetZoneSite(&zones, 1, "update", "sim.cc", "Update", 10);
+    SetZoneSite(&zones, 2, "solve" , "sim.cc", "Solve" , 42);
+    AppendZoneEvent(&zones, WIN32_ZONE_EVENT_BEGIN,  50, 20, 2);
+    AppendZoneEvent(&zones, WIN32_ZONE_EVENT_BEGIN, 150, 10, 1);
+    AppendZoneEvent(&zones, WIN32_ZONE_EVENT_BEGIN, 200, 10, 2);
+    AppendZoneEvent(&zones, WIN32_ZONE_EVENT_END  , 250, 10, 2);
+    AppendZoneEvent(&zones, WIN32_ZONE_EVENT_END  ,  80, 20, 2);
+    AppendZoneEvent(&zones, WIN32_ZONE_EVENT_BEGIN, 300, 10, 2);
+    AppendZoneEvent(&zones, WIN32_ZONE_EVENT_END  , 350, 10, 2);
+    AppendZoneEvent(&zones, WIN32_ZONE_EVENT_END  , 400, 10, 1);
+    AppendZoneEvent(&zones, WIN32_ZONE_EVENT_END  , 450, 10, 3);
+    AppendZoneEvent(&zones, WIN32_ZONE_EVENT_BEGIN, 520, 10, 1);
+    AppendZoneEvent(&zones, WIN32_ZONE_EVENT_BEGIN, 530, 10, 2);
+    AppendZoneEvent(&zones, WIN32_ZONE_EVENT_END  , 600, 10, 1);
+    BuildZoneTree(&tree, &zones, &table);
+    assert(tree.ZoneCount == 6 && tree.UnmatchedCount == 2);
+    assert(tree.SiteId[0] == 1 && tree.BeginTime[0] == 150 && tree.EndTime[0] == 400 && tree.ParentZone[0] == WIN32_OBJECT_INDEX_EMPTY && tree.TaskRow[0] == 0);
+    assert(tree.SiteId[2] == 2 && tree.ParentZone[2] == 0 && tree.Depth[2] == 1 && tree.TaskRow[2] == 0);
+    assert(tree.BeginTime[3] == 520 && tree.TaskRow[3] == WIN32_OBJECT_INDEX_EMPTY && tree.ParentZone[4] == 3 && tree.EndTime[4] == 600);
+    assert(tree.ThreadId[5] == 20 && tree.Depth[5] == 0 && tree.EndTime[5] == 80 && tree.TaskRow[5] == WIN32_OBJECT_INDEX_EMPTY);
+    assert(tree.SiteZoneCount.size() == 4 && tree.SiteZoneCount[1] == 2 && tree.SiteZoneCount[2] == 4 && tree.SiteZoneCount[3] == 0);
+    assert(tree.SiteInclusiveTime[1] == 330 && tree.SiteSelfTime[1] == 160 && tree.SiteInclusiveTime[2] == 200 && tree.SiteSelfTime[2] == 200);
+    printf("zone tree: %u zones, %u unmatched.\n", unsigned(tree.ZoneCount), unsigned(tree.UnmatchedCount));
+    DeleteZoneTree(&tree);
+}
+
+/// @summary Verify the task counter codec, and that counter samples attach to the right task row and sum by entry point.
+internal_function void
+TestTaskCounters
+(
+    void
+)
+{
+    PTRACE_CODEC_STATE        codec;
+    PTRACE_TASK_COUNTERS      cin[2] = { { 5000, 9, 0x1F, { 1ULL << 40, 3, 0, 7, 1 } }, { 5100, 4, 0x03, { 20, 30, 0, 0, 0 } } };
+    PTRACE_TASK_COUNTERS      cout;
+    uint8_t                   buf[2 * PTRACE_MAX_TASK_COUNTERS_SIZE];
+    uint8_t                  *dst = buf;
+    uint8_t const            *src = buf;
+    WIN32_TASK_EVENT_LIST     events;
+    WIN32_TASK_TABLE          table;
+    WIN32_TASK_COUNTER_LIST   counters;
+    WIN32_TASK_COUNTER_REPORT report;
+    size_t                    row = 0;
+    double                    ratio = 0.0;
+
+    PtraceResetCodecState(&codec, 5000);
+    for (size_t i = 0; i < 2; ++i) dst = PtraceEncodeTaskCounters(dst, &codec, &cin[i]);
+    PtraceResetCodecState(&codec, 5000);
+    for (size_t i = 0; i < 2; ++i)
+    {
+        assert((src = PtraceDecodeTaskCounters(src, dst, &codec, &cout)) != NULL);
+        assert(cout.Timestamp == cin[i].Timestamp && cout.TaskId == cin[i].TaskId && cout.CounterMask == cin[i].CounterMask);
+        assert(memcmp(cout.Values, cin[i].Values, sizeof(cout.Values)) == 0);
+    }
+    assert(src == dst && PtraceDecodeTaskCounters(buf, dst - 1, &codec, &cout) != NULL && PtraceDecodeTaskCounters(src, dst, &codec, &cout) == NULL);
+
+    // tasks 1 and 2 share an entry point, but task 2 only recorded cycles and instructions. task 1 is then reused for the entry
+    // point of task 3, and a sample for an undefined task is ignored.
+    uint64_t const v1[5] = { 1000, 2000, 10,  2, 5 };
+    uint64_t const v2[5] = {  500,  250,  0,  0, 0 };
+    uint64_t const v3[5] = { 4000, 1000, 200, 50, 1 };
+    uint64_t const v4[5] = {  100,  100,  1,  2, 0 };
+    InitTaskEventList(&events);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_DEFINE_TASK,  10, 1, 1, 0, INVALID_TASK_ID, 0x1000, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_DEFINE_TASK,  15, 2, 1, 0, INVALID_TASK_ID, 0x1000, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_DEFINE_TASK,  20, 3, 1, 0, INVALID_TASK_ID, 0x2000, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_LAUNCH     ,  20, 1, 10, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_LAUNCH     ,  30, 3, 11, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_FINISH     ,  90, 3, 11, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_FINISH     , 100, 1, 10, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_LAUNCH     , 110, 2, 10, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_FINISH     , 200, 2, 10, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_DEFINE_TASK, 300, 1, 1, 0, INVALID_TASK_ID, 0x2000, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_LAUNCH     , 310, 1, 10, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_FINISH     , 400, 1, 10, 0, INVALID_TASK_ID, 0, NULL, 0);
+    BuildTaskTable(&table, &events);
+    InitTaskCounterList(&counters);
+    AppendTaskCounters(&counters, 400, 1, 10, 0x1F, v4);
+    AppendTaskCounters(&counters, 100, 1, 10, 0x1F, v1);
+    AppendTaskCounters(&counters,  50, 9, 10, 0x1F, v1);
+    AppendTaskCounters(&counters, 200, 2, 10, 0x03, v2);
+    AppendTaskCounters(&counters,  90, 3, 11, 0x1F, v3);
+    BuildTaskCounterReport(&report, &counters, &table);
+    assert(report.TaskCount == 4 && report.UnmatchedCount == 1 && report.EntryPointCount == 2);
+    assert(FindTaskByIdAndTime(&table, 1, 100, row) && report.TaskValue[row * WIN32_TASK_COUNTER_COUNT + WIN32_TASK_COUNTER_CYCLES] == 1000);
+    assert(FindTaskByIdAndTime(&table, 1, 400, row) && report.TaskValue[row * WIN32_TASK_COUNTER_COUNT + WIN32_TASK_COUNTER_CYCLES] == 100);
+    assert(FindTaskById(&table, 3, row) && TaskCounterRatio(&report.TaskValue[row * WIN32_TASK_COUNTER_COUNT], report.TaskCounterMask[row], WIN32_TASK_COUNTER_LLC_MISSES, WIN32_TASK_COUNTER_INSTRUCTIONS, 1000.0, ratio) && ratio == 50.0);
+    assert(report.EntryPoint[0] == 0x2000 && report.EntryPointTasks[0] == 2 && report.EntryPointMask[0] == 0x1F);
+    assert(report.EntryPointValue[WIN32_TASK_COUNTER_CYCLES] == 4100 && report.EntryPointValue[WIN32_TASK_COUNTER_LLC_MISSES] == 52);
+    assert(report.EntryPoint[1] == 0x1000 && report.EntryPointTasks[1] == 2 && report.EntryPointMask[1] == 0x03);
+    assert(TaskCounterRatio(&report.EntryPointValue[WIN32_TASK_COUNTER_COUNT], report.EntryPointMask[1], WIN32_TASK_COUNTER_INSTRUCTIONS, WIN32_TASK_COUNTER_CYCLES, 1.0, ratio) && ratio == 1.5);
+    assert(!TaskCounterRatio(&report.EntryPointValue[WIN32_TASK_COUNTER_COUNT], report.EntryPointMask[1], WIN32_TASK_COUNTER_L1D_MISSES, WIN32_TASK_COUNTER_INSTRUCTIONS, 1000.0, ratio));
+    printf("task counters: %u tasks, %u entry points, %u unmatched.\n", unsigned(report.TaskCount), unsigned(report.EntryPointCount), unsigned(report.UnmatchedCount));
+    DeleteTaskCounterReport(&report);
+}
+
+/// @summary Attach a new buffer to the calling thread as if a native profiler session were running, without opening a trace file or starting the flush thread.
+/// @param capacity The number of records in the buffer. Must be a power of two.
+/// @return The attached buffer.
+internal_function PROFILER_THREAD_BUFFER*
+AttachTestThreadBuffer
+(
+    uint64_t capacity
+)
+{
+    PROFILER_THREAD_BUFFER *buf = NewThreadBuffer(PlatformThreadId(), capacity);
+    assert(buf != NULL);
+    buf->Bound = true;
+    ProfilerNative.SessionId.store(1, std::memory_order_relaxed);
+    ProfilerNative.TaskSampleRate  = 1;
+    ProfilerNative.TaskAllocations = false;
+    ProfilerThreadBuffer  = buf;
+    ProfilerThreadSession = 1;
+    return buf;
+}
+
+/// @summary Delete the buffer attached by AttachTestThreadBuffer and end the session.
+internal_function void
+DetachTestThreadBuffer
+(
+    void
+)
+{
+    DeleteThreadBuffer(ProfilerThreadBuffer);
+    ProfilerNative.SessionId.store(0, std::memory_order_relaxed);
+    ProfilerNative.TaskAllocations = false;
+    ProfilerThreadBuffer  = NULL;
+    ProfilerThreadSession = 0;
+}
+
+/// @summary Verify the single-thread behavior of a native backend ring buffer: a multi-record reservation that would wrap pads out the end of
+/// the storage, a reservation that doesn't fit is counted as dropped, and a definition whose dependency records don't fit in Data16 is dropped.
+internal_function void
+TestThreadBuffer
+(
+    void
+)
+{
+    PROFILER_THREAD_BUFFER *buf = NewThreadBuffer(1, 8);
+    PROFILER_EVENT_RECORD  *rec = NULL;
+    assert(buf != NULL);
+    assert(ReserveRecords(buf, 3) == &buf->Records[0]); PublishRecords(buf, 3);
+    assert(ReserveRecords(buf, 3) == &buf->Records[3]); PublishRecords(buf, 3);
+    assert(ReserveRecords(buf, 3) == NULL && buf->DropCount.load() == 3 && buf->WritePos.load() == 6);
+
+    // once the flush thread has consumed the records, the next three start at the beginning, after two padding records.
+    buf->ReadPos.store(6);
+    assert((rec = ReserveRecords(buf, 3)) == &buf->Records[0]);
+    assert(buf->WritePos.load() == 8 && buf->Records[6].EventType == PROFILER_RECORD_TYPE_PADDING && buf->Records[7].EventType == PROFILER_RECORD_TYPE_PADDING);
+    PublishRecords(buf, 3);
+    assert(buf->WritePos.load() == 11);
+
+    // five records are unread. four more don't fit, three exactly fill the buffer, and then nothing fits.
+    assert(ReserveRecords(buf, 4) == NULL && buf->DropCount.load() == 7 && buf->WritePos.load() == 11);
+    assert(ReserveRecords(buf, 3) == &buf->Records[3]); PublishRecords(buf, 3);
+    assert(ReserveRecords(buf, 1) == NULL && buf->DropCount.load() == 8 && buf->WritePos.load() == 14);
+    DeleteThreadBuffer(buf);
+
+    // every dependency of task 0x80000000 on task 0 encodes to five bytes, so 400000 of them need more than 0xFFFF records.
+    std::vector<uint32_t> deps(400000, 0);
+    buf = AttachTestThreadBuffer(16);
+    MarkTaskDefinition(0x80000000U, INVALID_TASK_ID, NULL, 0, uint32_t(deps.size()), &deps[0]);
+    assert(buf->DropCount.load() == 1 && buf->WritePos.load() == 0);
+    MarkTaskDefinition(0x80000000U, INVALID_TASK_ID, NULL, 0, 3, &deps[0]);
+    assert(buf->DropCount.load() == 1 && buf->WritePos.load() == 2);
+    assert(buf->Records[0].EventType == PROFILER_RECORD_TYPE_DEFINE_TASK && buf->Records[0].Data16 == 1 && buf->Records[1].EventType == PROFILER_RECORD_TYPE_DEPENDENCIES);
+    DetachTestThreadBuffer();
+    printf("thread buffer: padding, drops and oversized definitions verified.\n");
+}
+
+/// @summary Verify that the native backend charges allocations and frees to the innermost running task and writes no record for a task that
+/// made neither, that the allocation codec round-trips in both block layouts, and that tasks without allocations or frees are left out of the report.
+internal_function void
+TestTaskAllocations
+(
+    void
+)
+{
+    PROFILER_THREAD_BUFFER *tbuf = AttachTestThreadBuffer(16);
+    PROFILER_EVENT_RECORD  *rec  = tbuf->Records;
+    PROFILER_ALLOC_RECORD   alloc;
+    PTRACE_CODEC_STATE      codec;
+    PTRACE_TASK_ALLOCS      ain[2] = { { 7000, 12, 0, 3, 1ULL << 33, 48 }, { 7050, 5, 0, 1, 24, 0 } };
+    PTRACE_TASK_ALLOCS      aout;
+    uint8_t                 buf[2 * PTRACE_MAX_TASK_ALLOCS_SIZE];
+    uint8_t                *dst = buf;
+    uint8_t const          *src = buf;
+    WIN32_TASK_EVENT_LIST   events;
+    WIN32_TASK_TABLE        table;
+    WIN32_TASK_ALLOC_REPORT report;
+    size_t                  row = 0;
+
+    // task 1 allocates and frees, and task 2 does neither. task 4 runs inside task 3, which loses the allocation it made before task 4 was
+    // launched. task 5 only frees. the hooks aren't compiled into the tests, so the thread totals are advanced by hand.
+    ProfilerNative.TaskAllocations = true;
+    MarkTaskLaunch(1); ProfilerThreadAllocs.Count += 3; ProfilerThreadAllocs.Bytes += 96; ProfilerThreadAllocs.FreeBytes += 32; MarkTaskFinish(1);
+    MarkTaskLaunch(2); MarkTaskFinish(2);
+    MarkTaskLaunch(3); ProfilerThreadAllocs.Count += 1; ProfilerThreadAllocs.Bytes += 8;
+    MarkTaskLaunch(4); ProfilerThreadAllocs.Count += 2; ProfilerThreadAllocs.Bytes += 64; MarkTaskFinish(4);
+    MarkTaskFinish(3);
+    MarkTaskLaunch(5); ProfilerThreadAllocs.FreeBytes += 48; MarkTaskFinish(5);
+    assert(tbuf->WritePos.load() == 13 && tbuf->DropCount.load() == 0);
+    assert(rec[1].EventType == PROFILER_RECORD_TYPE_TASK_FINISH && rec[1].TaskId == 1 && rec[1].Data16 == 1);
+    memcpy(&alloc, &rec[2], sizeof(alloc));
+    assert(alloc.EventType == PROFILER_RECORD_TYPE_TASK_ALLOCS && alloc.AllocCount == 3 && alloc.AllocBytes == 96 && alloc.FreeBytes == 32);
+    assert(rec[4].EventType == PROFILER_RECORD_TYPE_TASK_FINISH && rec[4].TaskId == 2 && rec[4].Data16 == 0);
+    assert(rec[5].EventType == PROFILER_RECORD_TYPE_TASK_LAUNCH && rec[5].TaskId == 3);
+    assert(rec[7].EventType == PROFILER_RECORD_TYPE_TASK_FINISH && rec[7].TaskId == 4 && rec[7].Data16 == 1);
+    memcpy(&alloc, &rec[8], sizeof(alloc));
+    assert(alloc.EventType == PROFILER_RECORD_TYPE_TASK_ALLOCS && alloc.AllocCount == 2 && alloc.AllocBytes == 64 && alloc.FreeBytes == 0);
+    assert(rec[9].EventType == PROFILER_RECORD_TYPE_TASK_FINISH && rec[9].TaskId == 3 && rec[9].Data16 == 0);
+    assert(rec[11].EventType == PROFILER_RECORD_TYPE_TASK_FINISH && rec[11].TaskId == 5 && rec[11].Data16 == 1);
+    memcpy(&alloc, &rec[12], sizeof(alloc));
+    assert(alloc.EventType == PROFILER_RECORD_TYPE_TASK_ALLOCS && alloc.AllocCount == 0 && alloc.FreeBytes == 48);
+    DetachTestThreadBuffer();
+
+    PtraceResetCodecState(&codec, 7000);
+    for (size_t i = 0; i < 2; ++i) dst = PtraceEncodeTaskAllocs(dst, &codec, &ain[i]);
+    PtraceResetCodecState(&codec, 7000);
+    for (size_t i = 0; i < 2; ++i)
+    {
+        assert((src = PtraceDecodeTaskAllocs(src, dst, &codec, PTRACE_BLOCK_TYPE_TASK_HEAP, &aout)) != NULL);
+        assert(aout.Timestamp == ain[i].Timestamp && aout.TaskId == ain[i].TaskId && aout.AllocCount == ain[i].AllocCount && aout.AllocBytes == ain[i].AllocBytes);
+        assert(aout.FreeBytes == ain[i].FreeBytes);
+    }
+    assert(src == dst && PtraceDecodeTaskAllocs(src, dst, &codec, PTRACE_BLOCK_TYPE_TASK_HEAP, &aout) == NULL);
+
+    // minor version 5 files have no freed bytes.
+    dst = buf;
+    dst = PtraceEncodeVarU64(dst, 10);
+    dst = PtraceEncodeVarU64(dst, ZigZagEncode32(3));
+    dst = PtraceEncodeVarU64(dst, 2);
+    dst = PtraceEncodeVarU64(dst, 40);
+    PtraceResetCodecState(&codec, 7000);
+    assert((src = PtraceDecodeTaskAllocs(buf, dst, &codec, PTRACE_BLOCK_TYPE_TASK_ALLOCS, &aout)) == dst);
+    assert(aout.Timestamp == 7010 && aout.TaskId == 3 && aout.AllocCount == 2 && aout.AllocBytes == 40 && aout.FreeBytes == 0);
+
+    // tasks 1 and 2 share an entry point, but only task 1 made allocations. task 4 only freed memory, and still counts toward the report.
+    // allocations for an undefined task are discarded.
+    InitTaskEventList(&events);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_DEFINE_TASK, 10, 1, 1, 0, INVALID_TASK_ID, 0x1000, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_DEFINE_TASK, 10, 2, 1, 0, INVALID_TASK_ID, 0x1000, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_DEFINE_TASK, 10, 3, 1, 0, INVALID_TASK_ID, 0x2000, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_DEFINE_TASK, 10, 4, 1, 0, INVALID_TASK_ID, 0x2000, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_LAUNCH     , 20, 1, 10, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_FINISH     , 30, 1, 10, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_LAUNCH     , 40, 2, 10, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_FINISH     , 50, 2, 10, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_LAUNCH     , 60, 3, 10, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_FINISH     , 90, 3, 10, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_LAUNCH     , 95, 4, 10, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_FINISH     , 99, 4, 10, 0, INVALID_TASK_ID, 0, NULL, 0);
+    BuildTaskTable(&table, &events);
+    assert( TaskTableAddAllocations(&table, 30, 1, 3, 96, 0));
+    assert( TaskTableAddAllocations(&table, 90, 3, 5, 4000, 4096));
+    assert( TaskTableAddAllocations(&table, 99, 4, 0, 0, 256));
+    assert(!TaskTableAddAllocations(&table, 50, 9, 1, 8, 8));
+    assert(FindTaskById(&table, 2, row) && table.AllocCount[row] == 0 && table.AllocBytes[row] == 0 && table.FreeBytes[row] == 0);
+    BuildTaskAllocReport(&report, &table);
+    assert(report.TaskCount == 3 && report.AllocCount == 8 && report.AllocBytes == 4096 && report.FreeBytes == 4352 && report.EntryPointCount == 2);
+    assert(report.EntryPoint[0] == 0x2000 && report.EntryPointTasks[0] == 2 && report.EntryPointAllocs[0] == 5 && report.EntryPointBytes[0] == 4000);
+    assert(report.EntryPointFreeBytes[0] == 4352 && report.EntryPointFreeBytes[1] == 0);
+    assert(report.EntryPoint[1] == 0x1000 && report.EntryPointTasks[1] == 1 && report.EntryPointAllocs[1] == 3 && report.EntryPointBytes[1] == 96);
+    printf("task allocations: %u tasks, %u entry points, %llu allocations.\n", unsigned(report.TaskCount), unsigned(report.EntryPointCount), (unsigned long long) report.AllocCount);
+    DeleteTaskAllocReport(&report);
+}
+
+/// @summary Verify that pyramid levels summarize busy time and the dominant label exactly, and that sampling picks the level matching the pixel width.
+internal_function void
+TestLodPyramid
+(
+    void
+)
+{
+    uint64_t const     start[3] = { 0, 1024, 4096 };
+    uint64_t const       end[3] = { 512, 3072, 4096 + 256 };
+    uint32_t const     label[3] = { 7, 8, 9 };
+    float              busy [4];
+    uint32_t           dom  [4];
+    WIN32_LOD_PYRAMID  pyr;
+    WIN32_PROCESS_LIST procs;
+    WIN32_TASK_TABLE   table;
+    WIN32_TIMELINE_LOD lod;
+    WIN32_TASK_EVENT_LIST events;
+    BuildLodPyramid(&pyr, start, end, label, 3, 0, 10);
+    assert(pyr.LevelCount == 4 && pyr.LevelStart[1] == 5 && pyr.LevelStart[4] == 11);
+    assert(pyr.BusyFraction[0] == 32768 && pyr.DominantLabel[0] == 7 && pyr.BusyFraction[1] == 65535 && pyr.BusyFraction[3] == 0);
+    assert(pyr.BusyFraction[5] == 49151 && pyr.DominantLabel[5] == 8 && pyr.DominantFraction[5] == 32768);
+    assert(pyr.DominantLabel[10] == 8 && pyr.BusyFraction[10] == uint16_t(2816.0 / 8192.0 * 65535.0 + 0.5));
+    assert(SampleLodPyramid(&pyr, 0, 8192, 4, busy, dom) == 0);
+    assert(busy[0] > 0.749f && busy[0] < 0.751f && dom[0] == 8 && busy[1] > 0.499f && busy[1] < 0.501f && dom[2] == 9 && busy[3] == 0.0f && dom[3] == WIN32_LOD_NO_LABEL);
+    assert(SampleLodPyramid(&pyr, 0, 8192, 1, busy, dom) == 2 && dom[0] == 8);
+    assert(SampleLodPyramid(&pyr, 0, 1024, 2, busy, NULL) == 0 && busy[0] == busy[1]);
+
+    // one thread switched in twice, and two workers that each ran one task.
+    procs.ProcessCount = 1;
+    procs.ProcessInfo.resize(1);
+    procs.ProcessInfo[0].ThreadCount = 1;
+    procs.ProcessInfo[0].ThreadInfo.resize(1);
+    procs.ProcessInfo[0].ThreadInfo[0].SwitchInTime  = { 100000, 300000 };
+    procs.ProcessInfo[0].ThreadInfo[0].SwitchOutTime = { 200000, 400000 };
+    procs.ProcessInfo[0].ThreadInfo[0].SwitchOutData.resize(2);
+    procs.ProcessInfo[0].ThreadInfo[0].SwitchOutData[0].State = 5;
+    procs.ProcessInfo[0].ThreadInfo[0].SwitchOutData[1].State = 5;
+    procs.ProcessInfo[0].ThreadLifetime.resize(1);
+    procs.ProcessInfo[0].ThreadLifetime[0].DestroyTime = 0;
+    InitTaskEventList(&events);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_LAUNCH, 150000, 1, 200, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_LAUNCH, 160000, 2, 300, 0, INVALID_TASK_ID, 0, NULL, 0);
+    AppendTaskEvent(&events, WIN32_TASK_EVENT_FINISH, 170000, 1, 200, 0, INVALID_TASK_ID, 0, NULL, 0);
+    BuildTaskTable(&table, &events);
+    BuildProcessThreadIntervals(&procs);
+    BuildTimelineLod(&lod, &procs, &table);
+    assert(lod.FirstTime == 100000 && lod.LastTime == 400000 && lod.BaseShift == WIN32_LOD_MIN_SHIFT);
+    assert(lod.ThreadCount == 1 && lod.WorkerCount == 2 && lod.WorkerThreadId[0] == 200 && lod.WorkerThreadId[1] == 300);
+    SampleLodPyramid(&lod.ThreadLod[0], 100000, 400000, 3, busy, NULL);
+    assert(busy[0] > 0.9f && busy[1] < 0.1f && busy[2] > 0.9f); // span edges are blurred by up to one bucket.
+    SampleLodPyramid(&lod.WorkerLod[1], 100000, 400000, 3, busy, dom); // never finished, so busy until the end.
+    assert(busy[0] > 0.3f && busy[0] < 0.5f && busy[2] > 0.9f && dom[2] == 1);
+    printf("lod pyramid: %u levels, %u thread rows, %u worker rows.\n", unsigned(pyr.LevelCount), unsigned(lod.ThreadCount), unsigned(lod.WorkerCount));
+    DeleteTimelineLod(&lod);
+}
+
 int main(int argc, char **argv)
 {
     UNUSED(argc);
@@ -146,9 +1846,35 @@ int main(int argc, char **argv)
     // 20, 30 returns an invalid result!
     if (FindEventsInTimeRange(sample_times, 20, 9, 16, index_lower, index_upper, output_count))
     {
-        printf("Found %Iu items from [%Iu...%Iu].\n", output_count, index_lower, index_upper);
+        printf("Found %u items from [%u...%u].\n", unsigned(output_count), unsigned(index_lower), unsigned(index_upper));
     }
 
+    TestPtraceCodecRoundTrip();
+    TestTimestampScale();
+    TestClockMap();
+    TestPtraceLoader();
+    TestTaskSampling();
+    TestObjectIndexReuse();
+    TestEventDecoderPlan();
+    TestTaskTable();
+    TestTaskDependencyGraph();
+    TestCriticalPath();
+    TestScheduleReplay();
+    TestStringTable();
+    TestAnalysisCacheRoundTrip();
+    TestProfilerSnapshot();
+    TestThreadIntervals();
+    TestCpuTimeline();
+    TestWakeLatency();
+    TestOffCpuReport();
+    TestQueueDepth();
+    TestParallelismProfile();
+    TestZoneTree();
+    TestTaskCounters();
+    TestThreadBuffer();
+    TestTaskAllocations();
+    TestLodPyramid();
+
     return 0;
 }
 
@@ -0,0 +1,249 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implement the materialization of per-thread scheduling history.
+/// The ready, switch-in and switch-out columns recorded for each thread are
+/// merged once, after loading completes, into a sorted list of running, ready
+/// and waiting intervals. Queries by time then cost a binary search over a
+/// sparse index followed by a short linear scan, instead of a walk over three
+/// independent event streams.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////////
+//   Preprocessor   //
+////////////////////*/
+/// @summary Define the values of WIN32_SWITCH_OUT_DATA::State, which match the KTHREAD_STATE enumeration used by the kernel.
+#ifndef WIN32_KTHREAD_STATE_READY
+#define WIN32_KTHREAD_STATE_READY              1
+#endif
+#ifndef WIN32_KTHREAD_STATE_DEFERRED_READY
+#define WIN32_KTHREAD_STATE_DEFERRED_READY     7
+#endif
+
+/// @summary Define the state of a thread whose scheduling history has not started yet.
+#ifndef WIN32_THREAD_STATE_UNKNOWN
+#define WIN32_THREAD_STATE_UNKNOWN             0xFF
+#endif
+
+/*//////////////////////////
+//   Internal Functions   //
+//////////////////////////*/
+/// @summary Append an interval to a thread history, merging it with the previous interval where possible and splitting it where the duration would not fit.
+/// @param intervals The thread history to update.
+/// @param start The start time of the interval, in nanoseconds.
+/// @param end The end time of the interval, in nanoseconds. Empty intervals are dropped.
+/// @param state One of WIN32_THREAD_STATE.
+/// @param wait_reason The wait reason of a waiting interval, or WIN32_WAIT_REASON_NONE.
+/// @param wait_mode The wait mode of a waiting interval, or zero.
+internal_function void
+AppendThreadInterval
+(
+    WIN32_THREAD_INTERVALS *intervals,
+    uint64_t                    start,
+    uint64_t                      end,
+    uint8_t                     state,
+    int8_t                wait_reason,
+    int8_t                  wait_mode
+)
+{
+    size_t const n = intervals->IntervalCount;
+    if (end <= start)
+        return;
+    if (n > 0 && intervals->State[n - 1] == state && intervals->WaitReason[n - 1] == wait_reason && intervals->WaitMode[n - 1] == wait_mode && intervals->Start[n - 1] + intervals->Duration[n - 1] == start)
+    {   // a dropped empty interval separated two intervals with the same state; extend the earlier one as far as it will go.
+        uint64_t const room = 0xFFFFFFFFULL - intervals->Duration[n - 1];
+        uint64_t const grow = (end - start) < room ? (end - start) : room;
+        intervals->Duration[n - 1] += uint32_t(grow);
+        start += grow;
+    }
+    while (start < end)
+    {
+        uint64_t const length = (end - start) < 0xFFFFFFFFULL ? (end - start) : 0xFFFFFFFFULL;
+        if ((intervals->IntervalCount & (WIN32_THREAD_INTERVAL_INDEX_STRIDE - 1)) == 0)
+            intervals->IndexStart.push_back(start);
+        intervals->Start.push_back(start);
+        intervals->Duration.push_back(uint32_t(length));
+        intervals->State.push_back(state);
+        intervals->WaitReason.push_back(wait_reason);
+        intervals->WaitMode.push_back(wait_mode);
+        intervals->IntervalCount++;
+        start += length;
+    }
+}
+
+/// @summary Find the time of the last scheduling event of any thread in a process list.
+/// @param process_list The process list to search.
+/// @return The latest ready, switch-in or switch-out timestamp, in nanoseconds, or zero if there are none.
+internal_function uint64_t
+LatestSchedulingTime
+(
+    WIN32_PROCESS_LIST const *process_list
+)
+{
+    uint64_t latest = 0;
+    for (size_t i = 0; i < process_list->ProcessCount; ++i)
+    {
+        WIN32_PROCESS_INFO const &proc = process_list->ProcessInfo[i];
+        for (size_t j = 0; j < proc.ThreadCount; ++j)
+        {
+            WIN32_THREAD_INFO const &thread = proc.ThreadInfo[j];
+            if (!thread.ReadyTimes.empty()    && thread.ReadyTimes.back()    > latest) latest = thread.ReadyTimes.back();
+            if (!thread.SwitchInTime.empty()  && thread.SwitchInTime.back()  > latest) latest = thread.SwitchInTime.back();
+            if (!thread.SwitchOutTime.empty() && thread.SwitchOutTime.back() > latest) latest = thread.SwitchOutTime.back();
+        }
+    }
+    return latest;
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Free the memory used by a thread history. The history is left empty.
+/// @param intervals The thread history to delete.
+public_function void
+DeleteThreadIntervals
+(
+    WIN32_THREAD_INTERVALS *intervals
+)
+{
+    intervals->IntervalCount = 0;
+    WIN32_COLUMN<uint64_t>().swap(intervals->Start);
+    WIN32_COLUMN<uint32_t>().swap(intervals->Duration);
+    WIN32_COLUMN<uint8_t >().swap(intervals->State);
+    WIN32_COLUMN<int8_t  >().swap(intervals->WaitReason);
+    WIN32_COLUMN<int8_t  >().swap(intervals->WaitMode);
+    WIN32_COLUMN<uint64_t>().swap(intervals->IndexStart);
+}
+
+/// @summary Merge the ready, switch-in and switch-out columns of a thread into a list of running, ready and waiting intervals.
+/// A switch-out leaves the thread ready if it was preempted, and waiting otherwise. A ready event ends a wait, and the ready interval it starts
+/// keeps the reason of that wait, so wakeups can be told apart from preemptions. A switch-in starts a run.
+/// Events with equal timestamps are applied in the order switch-out, ready, switch-in, so a thread readied and run at once is not left waiting.
+/// @param thread The thread whose history is built. Any existing history is replaced.
+/// @param end_time The time at which the last interval ends, in nanoseconds, typically the thread exit or the end of the trace.
+public_function void
+BuildThreadIntervals
+(
+    WIN32_THREAD_INFO *thread,
+    uint64_t         end_time
+)
+{
+    WIN32_THREAD_INTERVALS *intervals = &thread->Intervals;
+    size_t const  ready_count = thread->ReadyTimes.size();
+    size_t const     in_count = thread->SwitchInTime.size();
+    size_t const    out_count = thread->SwitchOutTime.size();
+    size_t                 ri = 0;
+    size_t                 ii = 0;
+    size_t                 oi = 0;
+    uint64_t        cur_start = 0;
+    uint8_t         cur_state = WIN32_THREAD_STATE_UNKNOWN;
+    int8_t         cur_reason = WIN32_WAIT_REASON_NONE;
+    int8_t           cur_mode = 0;
+
+    DeleteThreadIntervals(intervals);
+    intervals->Start.reserve(in_count + out_count);
+    intervals->Duration.reserve(in_count + out_count);
+    intervals->State.reserve(in_count + out_count);
+    intervals->WaitReason.reserve(in_count + out_count);
+    intervals->WaitMode.reserve(in_count + out_count);
+
+    while (ri < ready_count || ii < in_count || oi < out_count)
+    {
+        uint64_t const t_ready = ri < ready_count ? thread->ReadyTimes   [ri] : ~uint64_t(0);
+        uint64_t const t_in    = ii < in_count    ? thread->SwitchInTime [ii] : ~uint64_t(0);
+        uint64_t const t_out   = oi < out_count   ? thread->SwitchOutTime[oi] : ~uint64_t(0);
+        uint64_t       time;
+        uint8_t        state;
+        int8_t         reason  = WIN32_WAIT_REASON_NONE;
+        int8_t         mode    = 0;
+        if (oi < out_count && t_out <= t_ready && t_out <= t_in)
+        {   // a preempted thread stays runnable; any other switch-out blocks it.
+            WIN32_SWITCH_OUT_DATA const &data = thread->SwitchOutData[oi++];
+            time = t_out;
+            if (data.State == WIN32_KTHREAD_STATE_READY || data.State == WIN32_KTHREAD_STATE_DEFERRED_READY)
+            {
+                state  = WIN32_THREAD_STATE_READY;
+            }
+            else
+            {
+                state  = WIN32_THREAD_STATE_WAITING;
+                reason = data.WaitReason;
+                mode   = data.WaitMode;
+            }
+        }
+        else if (ri < ready_count && t_ready <= t_in)
+        {   // readying a thread that is already runnable or running changes nothing.
+            time = t_ready; ri++;
+            if (cur_state != WIN32_THREAD_STATE_WAITING && cur_state != WIN32_THREAD_STATE_UNKNOWN)
+                continue;
+            state  = WIN32_THREAD_STATE_READY;
+            reason = cur_state == WIN32_THREAD_STATE_WAITING ? cur_reason : int8_t(WIN32_WAIT_REASON_UNKNOWN);
+        }
+        else
+        {
+            time  = t_in; ii++;
+            state = WIN32_THREAD_STATE_RUNNING;
+        }
+        if (cur_state == state && cur_reason == reason && cur_mode == mode)
+            continue;
+        if (cur_state != WIN32_THREAD_STATE_UNKNOWN)
+            AppendThreadInterval(intervals, cur_start, time, cur_state, cur_reason, cur_mode);
+        cur_start  = time;
+        cur_state  = state;
+        cur_reason = reason;
+        cur_mode   = mode;
+    }
+    if (cur_state != WIN32_THREAD_STATE_UNKNOWN)
+    {   // the thread stays in its final state until it exits or the trace ends.
+        AppendThreadInterval(intervals, cur_start, end_time, cur_state, cur_reason, cur_mode);
+    }
+}
+
+/// @summary Build the scheduling history of every thread in a process list. Each history ends when its thread exits, or at the last scheduling event in the trace.
+/// @param process_list The process list whose threads are updated.
+public_function void
+BuildProcessThreadIntervals
+(
+    WIN32_PROCESS_LIST *process_list
+)
+{
+    uint64_t const latest = LatestSchedulingTime(process_list);
+    for (size_t i = 0; i < process_list->ProcessCount; ++i)
+    {
+        WIN32_PROCESS_INFO &proc = process_list->ProcessInfo[i];
+        for (size_t j = 0; j < proc.ThreadCount; ++j)
+        {
+            uint64_t const destroy = proc.ThreadLifetime[j].DestroyTime;
+            BuildThreadIntervals(&proc.ThreadInfo[j], destroy != 0 ? destroy : latest);
+        }
+    }
+}
+
+/// @summary Find the interval of a thread history containing a given time.
+/// A binary search over the sparse index selects a block of at most WIN32_THREAD_INTERVAL_INDEX_STRIDE intervals, and a branch-free count
+/// of the block start times not after the query selects the interval. The count has no early exit, so the compiler can vectorize it.
+/// @param intervals The thread history to search.
+/// @param time The time to look up, in nanoseconds.
+/// @param index On return, set to the zero-based index of the interval containing time.
+/// @return true if an interval contains time, or false if time falls before, after or in a gap of the history.
+public_function bool
+FindThreadInterval
+(
+    WIN32_THREAD_INTERVALS const *intervals,
+    uint64_t                           time,
+    size_t                           &index
+)
+{
+    if (intervals->IntervalCount == 0 || time < intervals->Start[0])
+        return false;
+
+    size_t const    block = size_t(std::upper_bound(intervals->IndexStart.begin(), intervals->IndexStart.end(), time) - intervals->IndexStart.begin()) - 1;
+    size_t const    first = block * WIN32_THREAD_INTERVAL_INDEX_STRIDE;
+    size_t const    last  = (first + WIN32_THREAD_INTERVAL_INDEX_STRIDE) < intervals->IntervalCount ? (first + WIN32_THREAD_INTERVAL_INDEX_STRIDE) : intervals->IntervalCount;
+    uint64_t const *start = &intervals->Start[0];
+    size_t          count = 0;
+    for (size_t i = first; i < last; ++i)
+    {
+        count += start[i] <= time ? 1 : 0;
+    }
+    index = first + count - 1;
+    return (time - start[index]) < intervals->Duration[index];
+}
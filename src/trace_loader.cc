@@ -3,6 +3,19 @@
 /// parsing the various types of events recognized by the profiler.
 ///////////////////////////////////////////////////////////////////////////80*/
 
+/*////////////////////
+//   Preprocessor   //
+////////////////////*/
+/// @summary Define the interval at which snapshots of a loading trace are published to the user interface, in milliseconds.
+#ifndef WIN32_SNAPSHOT_INTERVAL_MS
+#define WIN32_SNAPSHOT_INTERVAL_MS             100
+#endif
+
+/// @summary Define the number of events consumed between checks of the snapshot interval, which limits how often the clock is read.
+#ifndef WIN32_SNAPSHOT_POLL_EVENTS
+#define WIN32_SNAPSHOT_POLL_EVENTS             1024
+#endif
+
 /*//////////////////
 //   Data Types   //
 //////////////////*/
@@ -14,127 +27,17 @@
 /*////////////////////////
 //   Public Functions   //
 ////////////////////////*/
-/// @summary Mix the bits of a 32-bit unsigned integer. Used for hash generation.
-/// @param x The 32-bit unsigned integer to mix.
-/// @return The input value, with bits mixed.
-public_function inline uint32_t 
-BitMixU32
-(
-    uint32_t x
-)
-{   // the finalizer from murmurhash3, 32-bit.
-    x ^= x >> 16;
-    x *= 0x85EBCA6B;
-    x ^= x >> 13;
-    x *= 0xC2B2AE35;
-    x ^= x >> 16;
-    return x;
-}
-
-/// @summary Compute a hash value for a zero-terminated wide character string.
-/// @param stringbuf A zero-terminated wide character string.
-/// @return The 32-bit hash of the string.
-public_function uint32_t
-HashWideString
-(
-    WCHAR *stringbuf
-)
-{
-    uint32_t hash  = 0;
-    if (stringbuf != NULL)
-    {
-        while (*stringbuf)
-        {
-            hash = _rotl(*stringbuf++, 7) + hash;
-        }
-    }
-    return BitMixU32(hash);
-}
-
-/// @summary Initialize an object lifetime record.
-/// @param lifetime The record to initialize.
-/// @param create_time The creation timestamp, in ticks. A value of 0 indicates that the object was created before the trace was started.
-/// @param destroy_time The destruction timetsamp, in ticks. A value of 0 indicates that the object was destroyed after the trace ended.
-public_function inline void
-InitObjectLifetime
-(
-    WIN32_LIFETIME   &lifetime, 
-    uint64_t       create_time=0, 
-    uint64_t      destroy_time=0
-)
-{
-    lifetime.CreateTime  = create_time;
-    lifetime.DestroyTime = destroy_time;
-}
-
-/// @summary Update an object lifetime record with the time at which the object was created.
-/// @param lifetime The record to update.
-/// @param timestamp The object creation timestamp, in ticks.
-public_function inline void
-ObjectCreated
-(
-    WIN32_LIFETIME &lifetime, 
-    LARGE_INTEGER  timestamp
-)
-{
-    lifetime.CreateTime = uint64_t(timestamp.QuadPart);
-}
-
-/// @summary Update an object lifetime record with the time at which the object was destroyed.
-/// @param lifetime The record to update.
-/// @param timestamp The object destruction timestamp, in ticks.
-public_function inline void
-ObjectDestroyed
-(
-    WIN32_LIFETIME &lifetime, 
-    LARGE_INTEGER  timestamp
-)
-{
-    lifetime.DestroyTime = uint64_t(timestamp.QuadPart);
-}
-
-/// @summary Determine whether an object was alive at a given time.
-/// @param lifetime The object lifetime record.
-/// @param timestamp The timestamp, in ticks, indicating the point in time to query.
-/// @return true if the object was alive at the specified point in time.
-public_function inline bool
-ObjectAliveAtTime
-(
-    WIN32_LIFETIME const &lifetime, 
-    uint64_t       const timestamp
-)
-{   // check for timestamp >= CreateTime and <= DestroyTime.
-    // a DestroyTime of 0 indicates that the object was still alive when capture stopped.
-    return (timestamp >= lifetime.CreateTime && (lifetime.DestroyTime == 0 || lifetime.DestroyTime >= timestamp));
-}
-
-/// @summary Determine whether an object was alive at a given time.
-/// @param lifetime The object lifetime record.
-/// @param timestamp The timestamp, in ticks, indicating the point in time to query.
-/// @return true if the object was alive at the specified point in time.
-public_function inline bool
-ObjectAliveAtTime
-(
-    WIN32_LIFETIME const &lifetime, 
-    LARGE_INTEGER        timestamp
-)
-{
-    return ObjectAliveAtTime(lifetime, uint64_t(timestamp.QuadPart));
-}
-
-/// @summary Convert an event timestamp from ticks to nanoseconds.
+/// @summary Convert an event timestamp from ticks to nanoseconds with a fixed-point multiply, which doesn't overflow on long captures.
 /// @param ev The event record.
-/// @param frequency The high-resolution timer frequency of the system that produced the trace, in ticks-per-second.
+/// @param clock_scale The length of one timer tick on the system that produced the trace. See WIN32_PROFILER_EVENTS::ClockScale.
 public_function inline uint64_t
 EventTimeToNanoseconds
 (
-    EVENT_RECORD        *ev, 
-    LARGE_INTEGER frequency
+    EVENT_RECORD   *ev, 
+    uint64_t clock_scale
 )
 {
-    uint64_t  timestamp = uint64_t(ev->EventHeader.TimeStamp.QuadPart);
-    uint64_t clock_freq = uint64_t(frequency.QuadPart);
-    return (1000000000ULL * timestamp) / clock_freq;
+    return ScaleTimestamp(uint64_t(ev->EventHeader.TimeStamp.QuadPart), clock_scale);
 }
 
 /// @summary Find the range of events that started or stopped within a given time range.
@@ -228,72 +131,6 @@ FindEventsInTimeRange
     return true;
 }
 
-/// @summary Search an object list (process, thread, etc.) for an object with a given identifier that was alive at a particular time.
-/// @param key_list The list of object identifiers to search. The list may contain duplicates.
-/// @param lifetime_list The list of object lifetimes corresponding to each identifier.
-/// @param object_count The number of values in the key and lifetime lists.
-/// @param search_key The identifier of the object to locate.
-/// @param search_time The query time, in nanoseconds. The object must be alive at this time.
-/// @param object_index If the function returns true, this value is set to the zero-based index of the object in the object list.
-/// @return true if an object with the specified identifier was alive and located at the specified time, or false otherwise.
-public_function bool
-FindObjectByU32AndTime
-(
-    uint32_t       const      *key_list,
-    WIN32_LIFETIME const *lifetime_list, 
-    size_t         const   object_count,
-    uint32_t                 search_key, 
-    uint64_t                search_time, 
-    size_t                &object_index
-)
-{
-    for (size_t i = 0; i < object_count; ++i)
-    {
-        if (key_list[i] == search_key)
-        {   // found a key match, check lifetime.
-            if (ObjectAliveAtTime(lifetime_list[i], search_time))
-            {   // the object was also alive, so we have a match.
-                object_index = i;
-                return true;
-            }
-        }
-    }
-    return false;
-}
-
-/// @summary Search an object list (process, thread, etc.) for an object with a given identifier that was alive at a particular time.
-/// @param key_list The list of object identifiers to search. The list may contain duplicates.
-/// @param lifetime_list The list of object lifetimes corresponding to each identifier.
-/// @param object_count The number of values in the key and lifetime lists.
-/// @param search_key The identifier of the object to locate.
-/// @param search_time The query time, in nanoseconds. The object must be alive at this time.
-/// @param object_index If the function returns true, this value is set to the zero-based index of the object in the object list.
-/// @return true if an object with the specified identifier was alive and located at the specified time, or false otherwise.
-public_function bool
-FindObjectByU64AndTime
-(
-    uint64_t       const      *key_list,
-    WIN32_LIFETIME const *lifetime_list, 
-    size_t         const   object_count,
-    uint64_t                 search_key, 
-    uint64_t                search_time, 
-    size_t                &object_index
-)
-{
-    for (size_t i = 0; i < object_count; ++i)
-    {
-        if (key_list[i] == search_key)
-        {   // found a key match, check lifetime.
-            if (ObjectAliveAtTime(lifetime_list[i], search_time))
-            {   // the object was also alive, so we have a match.
-                object_index = i;
-                return true;
-            }
-        }
-    }
-    return false;
-}
-
 /// @summary Search the process list of a profiler events list for a system process identifier.
 /// @param rtev The runtime profiler events record.
 /// @param pid The process identifier to search for.
@@ -309,29 +146,8 @@ FindProcessByPid
     size_t               &index
 )
 {
-    uint32_t       const       *key_list = &rtev->ProcessList.ProcessId[0];
-    WIN32_LIFETIME const  *lifetime_list = &rtev->ProcessList.ProcessLifetime[0];
-    return FindObjectByU32AndTime(key_list, lifetime_list, rtev->ProcessList.ProcessCount, pid, time, index);
-}
-
-/// @summary Search the process list of a profiler events list for a process identified by path.
-/// @param rtev The runtime profiler events record.
-/// @param hash The 32-bit hash value of the process name.
-/// @param time The nanosecond timestamp at which the event occurred.
-/// @param index If the function returns true, this value is set to the zero-based index of the process record in the process list.
-/// @return true if a process with the specified process ID was alive and located at the specified time, or false if no record exists.
-public_function inline bool
-FindProcessByName
-(
-    WIN32_PROFILER_EVENTS *rtev, 
-    uint32_t               hash, 
-    uint64_t               time, 
-    size_t               &index
-)
-{
-    uint32_t       const       *key_list = &rtev->ProcessList.ProcessHash[0];
-    WIN32_LIFETIME const  *lifetime_list = &rtev->ProcessList.ProcessLifetime[0];
-    return FindObjectByU32AndTime(key_list, lifetime_list, rtev->ProcessList.ProcessCount, hash, time, index);
+    WIN32_LIFETIME const  *lifetime_list = rtev->ProcessList.ProcessLifetime.data();
+    return FindObjectInIndex(rtev->ProcessList.ProcessIndex, lifetime_list, pid, time, index);
 }
 
 /// @summary Find a process record for the process with the specified identifier. Create a new record if no existing record is found. 
@@ -361,10 +177,14 @@ FindOrCreateProcess
         process_info.Executable   = NULL;
         process_info.ThreadCount  = 0;
         process_info.ImageCount   = 0;
+        InitObjectIndex(process_info.ThreadIndex);
+        InitObjectIndex(process_info.ImageAddressIndex);
+        InitObjectIndex(process_info.ImagePathIndex);
         InitObjectLifetime(lifetime, time);
         process_index = rtev->ProcessList.ProcessCount++;
+        ObjectIndexInsert(rtev->ProcessList.ProcessIndex, pid, process_index);
         rtev->ProcessList.ProcessId.push_back(pid);
-        rtev->ProcessList.ProcessHash.push_back(0);
+        rtev->ProcessList.ProcessNameId.push_back(WIN32_STRING_ID_NONE);
         rtev->ProcessList.ProcessLifetime.push_back(lifetime);
         rtev->ProcessList.ProcessInfo.push_back(process_info);
         return process_index;
@@ -386,9 +206,8 @@ FindThreadByTid
     size_t               &index
 )
 {
-    uint32_t       const      *key_list = &process->ThreadId[0];
-    WIN32_LIFETIME const *lifetime_list = &process->ThreadLifetime[0];
-    return FindObjectByU32AndTime(key_list, lifetime_list, process->ThreadCount, tid, time, index);
+    WIN32_LIFETIME const *lifetime_list = process->ThreadLifetime.data();
+    return FindObjectInIndex(process->ThreadIndex, lifetime_list, tid, time, index);
 }
 
 /// @summary Find a record for the thread with the specified ID. Create a new record if no existing record is found. 
@@ -423,6 +242,7 @@ FindOrCreateThread
         thread_info.SwitchOutCount  = 0;
         InitObjectLifetime(lifetime, time);
         thread_index = process->ThreadCount++;
+        ObjectIndexInsert(process->ThreadIndex, tid, thread_index);
         process->ThreadId.push_back(tid);
         process->ThreadLifetime.push_back(lifetime);
         process->ThreadInfo.push_back(thread_info);
@@ -432,7 +252,7 @@ FindOrCreateThread
 
 /// @summary Search the image list of a process for an executable image path.
 /// @param process The process record to search.
-/// @param hash The 32-bit hash value of the executable image path.
+/// @param path_id The interned path of the executable image.
 /// @param time The nanosecond timestamp at which the event occurred.
 /// @param index If the function returns true, this value is set to the zero-based index of the image record in the process image list.
 /// @return true if an image with the specified path was alive and located at the specified time, or false if no record exists.
@@ -440,14 +260,13 @@ public_function bool
 FindImageByName
 (
     WIN32_PROCESS_INFO *process, 
-    uint32_t               hash,
+    string_id_t         path_id,
     uint64_t               time, 
     size_t               &index
 )
 {
-    uint32_t       const      *key_list  = &process->ImagePathHash[0];
-    WIN32_LIFETIME const *lifetime_list  = &process->ImageLifetime[0];
-    return FindObjectByU32AndTime(key_list, lifetime_list, process->ImageCount, hash, time, index);
+    WIN32_LIFETIME const *lifetime_list  = process->ImageLifetime.data();
+    return FindObjectInIndex(process->ImagePathIndex, lifetime_list, path_id, time, index);
 }
 
 /// @summary Search the image list of a process for an executable image given the base load address.
@@ -465,29 +284,29 @@ FindImageByBaseAddress
     size_t               &index
 )
 {
-    uint64_t       const      *key_list = &process->ImageBaseAddress[0];
-    WIN32_LIFETIME const *lifetime_list = &process->ImageLifetime[0];
-    return FindObjectByU64AndTime(key_list, lifetime_list, process->ImageCount, addr, time, index);
+    WIN32_LIFETIME const *lifetime_list = process->ImageLifetime.data();
+    return FindObjectInIndex(process->ImageAddressIndex, lifetime_list, addr, time, index);
 }
 
 /// @summary Find an executable image record for the image with the specified attributes. Create a new record if no existing record is found. 
 /// @param process The process record to search.
-/// @param path The zero-terminated path of the executable image.
+/// @param strings The string table holding the interned image path.
+/// @param path_id The interned path of the executable image.
 /// @param addr The base load address of the executable image in the process address space.
 /// @param time The nanosecond timestamp at which the event occurred.
 /// @return The zero-based index of the image record within the process image list.
 public_function size_t
 FindOrCreateImage
 (
-    WIN32_PROCESS_INFO *process, 
-    WCHAR                 *path,
-    uint64_t               addr, 
-    uint64_t               time
+    WIN32_PROCESS_INFO       *process, 
+    WIN32_STRING_TABLE const *strings,
+    string_id_t               path_id,
+    uint64_t                     addr, 
+    uint64_t                     time
 )
 {
     size_t   image_index;
-    uint32_t const  image_hash = HashWideString(path);
-    if (FindImageByName(process, image_hash, time, image_index))
+    if (FindImageByName(process, path_id, time, image_index))
     {   // return the index of the existing record.
         return image_index;
     }
@@ -495,11 +314,13 @@ FindOrCreateImage
     {   // insert a new, empty record in the process image list.
         WIN32_LIFETIME     lifetime;
         WIN32_IMAGE_INFO image_info;
-        image_info.ImagePath = path;
+        image_info.ImagePath = InternedString(strings, path_id);
         InitObjectLifetime(lifetime, time);
         image_index = process->ImageCount++;
+        ObjectIndexInsert(process->ImageAddressIndex, addr, image_index);
+        ObjectIndexInsert(process->ImagePathIndex, path_id, image_index);
         process->ImageBaseAddress.push_back(addr);
-        process->ImagePathHash.push_back(image_hash);
+        process->ImagePathId.push_back(path_id);
         process->ImageLifetime.push_back(lifetime);
         process->ImageInfo.push_back(image_info);
         return image_index;
@@ -575,62 +396,293 @@ TraceEventGetSInt8
     return value;
 }
 
-/// @summary Retrieve an ANSI string property value from an event record.
+/// @summary Read a variable-length property value from an event record into the scratch buffer of a profiler events container.
+/// @param rtev The profiler events container whose PropertyBuffer receives the data.
 /// @param ev The EVENT_RECORD passed to TaskProfilerRecordEvent.
 /// @param info_buf The TRACE_EVENT_INFO containing event metadata.
 /// @param index The zero-based index of the property to retrieve.
-/// @return The NULL-terminated string buffer, or NULL. Free the returned buffer with the standard C library free function.
-public_function char*
-TraceEventGetAnsiStr
+/// @return The size of the property value in bytes, or 0 if the property could not be read. The data is valid until the next call.
+internal_function size_t
+TraceEventReadProperty
 (
-    EVENT_RECORD           *ev, 
-    TRACE_EVENT_INFO *info_buf, 
-    size_t               index
+    WIN32_PROFILER_EVENTS *rtev, 
+    EVENT_RECORD             *ev, 
+    TRACE_EVENT_INFO   *info_buf, 
+    size_t                 index
 )
 {
     PROPERTY_DATA_DESCRIPTOR dd;
     ULONG prop_size =  0;
-    char    *buffer =  NULL;
     dd.PropertyName = (ULONGLONG)((uint8_t*) info_buf + info_buf->EventPropertyInfoArray[index].NameOffset);
     dd.ArrayIndex   =  ULONG_MAX;
     dd.Reserved     =  0;
-    if (TdhGetPropertySize(ev, 0, NULL, 1, &dd, &prop_size)  == ERROR_SUCCESS)
-    {   // the size of the required buffer was retrieved successfully.
-        if ((buffer =  (char*) malloc((size_t)   prop_size)) != NULL)
-        {   // memory was successfully allocated for the string buffer.
-            TdhGetProperty(ev, 0, NULL, 1, &dd,  prop_size, (PBYTE) buffer);
-        }
+    if (TdhGetPropertySize(ev, 0, NULL, 1, &dd, &prop_size) != ERROR_SUCCESS || prop_size == 0)
+    {   // the property is missing or empty.
+        return 0;
     }
-    return buffer;
+    if (rtev->PropertyBuffer.size() < size_t(prop_size))
+    {   // the scratch buffer is reused for every property, so it only grows to the size of the longest one.
+        rtev->PropertyBuffer.resize(size_t(prop_size));
+    }
+    if (TdhGetProperty(ev, 0, NULL, 1, &dd, prop_size, (PBYTE) &rtev->PropertyBuffer[0]) != ERROR_SUCCESS)
+    {   // the property value could not be decoded.
+        return 0;
+    }
+    return size_t(prop_size);
 }
 
-/// @summary Retrieve a wide string property value from an event record.
+/// @summary Retrieve an ANSI string property value from an event record. The string is allocated from the arena of the profiler events container.
+/// @param rtev The profiler events container that owns the string.
 /// @param ev The EVENT_RECORD passed to TaskProfilerRecordEvent.
 /// @param info_buf The TRACE_EVENT_INFO containing event metadata.
 /// @param index The zero-based index of the property to retrieve.
-/// @return The zero-terminated string buffer, or NULL. Free the returned buffer with the standard C library free function.
-public_function WCHAR*
+/// @return The NULL-terminated string buffer, or NULL. The string remains valid until the profiler events container is deleted.
+public_function char const*
+TraceEventGetAnsiStr
+(
+    WIN32_PROFILER_EVENTS *rtev, 
+    EVENT_RECORD             *ev, 
+    TRACE_EVENT_INFO   *info_buf, 
+    size_t                 index
+)
+{
+    size_t const size = TraceEventReadProperty(rtev, ev, info_buf, index);
+    char        *copy = size > 0 ? (char*) MemoryArenaAllocate(&rtev->Arena, size + 1, 1) : NULL;
+    if (copy != NULL)
+    {   // TDH includes the terminator in the property size, but don't rely on it.
+        memcpy(copy, &rtev->PropertyBuffer[0], size);
+        copy[size] = 0;
+    }
+    return copy;
+}
+
+/// @summary Retrieve a wide string property value from an event record and intern it in the string table of a profiler events container.
+/// @param rtev The profiler events container that owns the string.
+/// @param ev The EVENT_RECORD passed to TaskProfilerRecordEvent.
+/// @param info_buf The TRACE_EVENT_INFO containing event metadata.
+/// @param index The zero-based index of the property to retrieve.
+/// @return The identifier of the interned string, or WIN32_STRING_ID_NONE.
+public_function string_id_t
 TraceEventGetWideStr
 (
-    EVENT_RECORD           *ev, 
-    TRACE_EVENT_INFO *info_buf, 
-    size_t               index
+    WIN32_PROFILER_EVENTS *rtev, 
+    EVENT_RECORD             *ev, 
+    TRACE_EVENT_INFO   *info_buf, 
+    size_t                 index
 )
 {
-    PROPERTY_DATA_DESCRIPTOR dd;
-    ULONG prop_size =  0;
-    WCHAR   *buffer =  NULL;
-    dd.PropertyName = (ULONGLONG)((uint8_t*) info_buf + info_buf->EventPropertyInfoArray[index].NameOffset);
-    dd.ArrayIndex   =  ULONG_MAX;
-    dd.Reserved     =  0;
-    if (TdhGetPropertySize(ev, 0, NULL, 1, &dd, &prop_size)  == ERROR_SUCCESS)
-    {   // the size of the required buffer was retrieved successfully.
-        if ((buffer = (WCHAR*) malloc((size_t)   prop_size)) != NULL)
-        {   // memory was successfully allocated for the string buffer.
-            TdhGetProperty(ev, 0, NULL, 1, &dd,  prop_size, (PBYTE) buffer);
-        }
+    size_t const  size = TraceEventReadProperty(rtev, ev, info_buf, index);
+    WCHAR const   *str = (WCHAR const*) rtev->PropertyBuffer.data();
+    size_t         len = size / sizeof(WCHAR);
+    if (size == 0) return WIN32_STRING_ID_NONE;
+    while (len > 0 && str[len - 1] == 0)
+    {   // strip the terminator, so equal strings intern to the same identifier however they were encoded.
+        len--;
+    }
+    return InternWideString(&rtev->Strings, &rtev->Arena, str, len);
+}
+
+/// @summary Retrieve a 32-bit unsigned integer property value from an event record, using a direct load if the decoder plan gives the property a fixed offset.
+/// @param plan The decoder plan for the event schema, or NULL.
+/// @param ev The EVENT_RECORD passed to TaskProfilerRecordEvent.
+/// @param info_buf The TRACE_EVENT_INFO containing event metadata.
+/// @param index The zero-based index of the property to retrieve.
+/// @return The integer value.
+public_function inline uint32_t
+TraceEventDecodeUInt32
+(
+    WIN32_EVENT_DECODER_PLAN const *plan, 
+    EVENT_RECORD                     *ev, 
+    TRACE_EVENT_INFO           *info_buf, 
+    size_t                         index
+)
+{
+    if (EventDecoderHasField(plan, ev->UserDataLength, index) && plan->FieldSize[index] == sizeof(uint32_t))
+    {   // the common case - a fixed-layout event.
+        return EventDecoderGetUInt32(plan, ev->UserData, index);
     }
-    return buffer;
+    return TraceEventGetUInt32(ev, info_buf, index);
+}
+
+/// @summary Retrieve an array of 32-bit unsigned integers sized by another property, copying it into the scratch buffer of a profiler events container.
+/// The array is copied directly from the payload if it immediately follows the fixed-offset properties of the decoder plan.
+/// @param rtev The profiler events container whose PropertyBuffer receives the data.
+/// @param plan The decoder plan for the event schema, or NULL.
+/// @param ev The EVENT_RECORD passed to TaskProfilerRecordEvent.
+/// @param info_buf The TRACE_EVENT_INFO containing event metadata.
+/// @param index The zero-based index of the array property.
+/// @param count The number of elements in the array, read from the property that sizes it.
+/// @return A pointer to the count array elements, or NULL if count is zero or the array could not be read. The data is valid until the next property is read.
+internal_function uint32_t const*
+TraceEventDecodeUInt32Array
+(
+    WIN32_PROFILER_EVENTS          *rtev, 
+    WIN32_EVENT_DECODER_PLAN const *plan, 
+    EVENT_RECORD                     *ev, 
+    TRACE_EVENT_INFO           *info_buf, 
+    size_t                         index, 
+    uint32_t                       count
+)
+{
+    size_t const bytes = size_t(count) * sizeof(uint32_t);
+    if (count == 0)
+        return NULL;
+    if (plan != NULL && plan->FixedCount == index && size_t(plan->PayloadSize) + bytes <= ev->UserDataLength)
+    {   // the common case - the array starts where the fixed-layout properties end.
+        if (rtev->PropertyBuffer.size() < bytes) rtev->PropertyBuffer.resize(bytes);
+        memcpy(&rtev->PropertyBuffer[0], (uint8_t const*) ev->UserData + plan->PayloadSize, bytes);
+    }
+    else if (TraceEventReadProperty(rtev, ev, info_buf, index) < bytes)
+    {   // the array is shorter than its count property claims.
+        return NULL;
+    }
+    return (uint32_t const*) &rtev->PropertyBuffer[0];
+}
+
+/// @summary Retrieve a pointer-size unsigned integer property value from an event record, using a direct load if the decoder plan gives the property a fixed offset.
+/// @param plan The decoder plan for the event schema, or NULL.
+/// @param ev The EVENT_RECORD passed to TaskProfilerRecordEvent.
+/// @param info_buf The TRACE_EVENT_INFO containing event metadata.
+/// @param index The zero-based index of the property to retrieve.
+/// @return The pointer-size integer value, stored in a 64-bit unsigned integer.
+public_function inline uint64_t
+TraceEventDecodePointer
+(
+    WIN32_EVENT_DECODER_PLAN const *plan, 
+    EVENT_RECORD                     *ev, 
+    TRACE_EVENT_INFO           *info_buf, 
+    size_t                         index
+)
+{
+    if (EventDecoderHasField(plan, ev->UserDataLength, index) && (plan->FieldSize[index] == sizeof(uint32_t) || plan->FieldSize[index] == sizeof(uint64_t)))
+    {   // the common case - a fixed-layout event.
+        return EventDecoderGetPointer(plan, ev->UserData, index);
+    }
+    return TraceEventGetPointer(ev, info_buf, index);
+}
+
+/// @summary Retrieve an 8-bit signed integer property value from an event record, using a direct load if the decoder plan gives the property a fixed offset.
+/// @param plan The decoder plan for the event schema, or NULL.
+/// @param ev The EVENT_RECORD passed to TaskProfilerRecordEvent.
+/// @param info_buf The TRACE_EVENT_INFO containing event metadata.
+/// @param index The zero-based index of the property to retrieve.
+/// @return The integer value.
+public_function inline int8_t
+TraceEventDecodeSInt8
+(
+    WIN32_EVENT_DECODER_PLAN const *plan, 
+    EVENT_RECORD                     *ev, 
+    TRACE_EVENT_INFO           *info_buf, 
+    size_t                         index
+)
+{
+    if (EventDecoderHasField(plan, ev->UserDataLength, index) && plan->FieldSize[index] == sizeof(int8_t))
+    {   // the common case - a fixed-layout event.
+        return EventDecoderGetSInt8(plan, ev->UserData, index);
+    }
+    return TraceEventGetSInt8(ev, info_buf, index);
+}
+
+/// @summary Determine the size of a top-level event property from its metadata.
+/// @param prop The property metadata.
+/// @param pointer_size The size of pointer values on the producer, in bytes.
+/// @return The size of the property in bytes, or WIN32_EVENT_FIELD_VARIABLE if the size depends on the payload.
+internal_function uint32_t
+TraceEventPropertySize
+(
+    EVENT_PROPERTY_INFO const &prop, 
+    uint32_t           pointer_size
+)
+{
+    uint32_t size = WIN32_EVENT_FIELD_VARIABLE;
+    if (prop.Flags & (PropertyStruct | PropertyParamLength | PropertyParamCount))
+    {   // structures and arrays sized by another property have a payload-dependent size.
+        return WIN32_EVENT_FIELD_VARIABLE;
+    }
+    switch (prop.nonStructType.InType)
+    {
+        case TDH_INTYPE_INT8:
+        case TDH_INTYPE_UINT8:
+        case TDH_INTYPE_ANSICHAR:
+            size = 1; break;
+        case TDH_INTYPE_INT16:
+        case TDH_INTYPE_UINT16:
+        case TDH_INTYPE_UNICODECHAR:
+            size = 2; break;
+        case TDH_INTYPE_INT32:
+        case TDH_INTYPE_UINT32:
+        case TDH_INTYPE_HEXINT32:
+        case TDH_INTYPE_BOOLEAN:
+        case TDH_INTYPE_FLOAT:
+            size = 4; break;
+        case TDH_INTYPE_INT64:
+        case TDH_INTYPE_UINT64:
+        case TDH_INTYPE_HEXINT64:
+        case TDH_INTYPE_DOUBLE:
+        case TDH_INTYPE_FILETIME:
+            size = 8; break;
+        case TDH_INTYPE_POINTER:
+        case TDH_INTYPE_SIZET:
+            size = pointer_size; break;
+        case TDH_INTYPE_GUID:
+        case TDH_INTYPE_SYSTEMTIME:
+            size = 16; break;
+        default:
+            return WIN32_EVENT_FIELD_VARIABLE; // strings, binary data and SIDs.
+    }
+    // fixed-count arrays are a contiguous run of elements.
+    return size * (prop.count > 1 ? prop.count : 1);
+}
+
+/// @summary Build the decoder plan for an event schema from its metadata. Called once per schema.
+/// @param plan The plan to initialize. On return, plan->EventInfo holds a copy of the metadata allocated with malloc.
+/// @param info_buf The TRACE_EVENT_INFO returned by TdhGetEventInformation.
+/// @param info_size The size of the metadata, in bytes.
+/// @param pointer_size The size of pointer values on the producer, in bytes.
+/// @return true if the plan was built, or false if memory could not be allocated.
+internal_function bool
+BuildEventDecoderPlan
+(
+    WIN32_EVENT_DECODER_PLAN *plan, 
+    TRACE_EVENT_INFO const   *info_buf, 
+    ULONG                    info_size, 
+    uint32_t              pointer_size
+)
+{
+    uint32_t field_sizes[WIN32_EVENT_DECODER_MAX_FIELDS];
+    uint32_t field_count = info_buf->TopLevelPropertyCount;
+    uint32_t fixed_count = field_count < WIN32_EVENT_DECODER_MAX_FIELDS ? field_count : WIN32_EVENT_DECODER_MAX_FIELDS;
+    for (uint32_t i = 0; i < fixed_count; ++i)
+    {
+        field_sizes[i] = TraceEventPropertySize(info_buf->EventPropertyInfoArray[i], pointer_size);
+    }
+    InitEventDecoderPlan(plan, field_sizes, fixed_count);
+    plan->FieldCount = field_count;
+    if ((plan->EventInfo = (uint8_t*) malloc(info_size)) == NULL)
+    {   // the metadata is needed for dispatch and for properties without a fixed offset.
+        return false;
+    }
+    memcpy(plan->EventInfo, info_buf, info_size);
+    plan->EventInfoSize = uint32_t(info_size);
+    return true;
+}
+
+/// @summary Construct the decoder cache key for an event record.
+/// @param key On return, the schema key for the event.
+/// @param ev The EVENT_RECORD passed to TaskProfilerRecordEvent.
+internal_function inline void
+TraceEventSchemaKey
+(
+    WIN32_EVENT_SCHEMA_KEY &key, 
+    EVENT_RECORD            *ev
+)
+{
+    memset(&key, 0, sizeof(key));
+    memcpy(key.ProviderId, &ev->EventHeader.ProviderId, sizeof(key.ProviderId));
+    key.EventId     = ev->EventHeader.EventDescriptor.Id;
+    key.Opcode      = ev->EventHeader.EventDescriptor.Opcode;
+    key.Version     = ev->EventHeader.EventDescriptor.Version;
+    key.PointerSize =(ev->EventHeader.Flags & EVENT_HEADER_FLAG_32_BIT_HEADER) ? 4 : 8;
 }
 
 /// @summary Examine the ProviderGuid to determine whether an event was produced by the kernel logger.
@@ -746,13 +798,12 @@ ConsumeKernel_Process_TypeGroup1_Create
 )
 {
     uint32_t const        process_id = TraceEventGetUInt32(ev, info_buf, 1);
-    uint64_t const         timestamp = EventTimeToNanoseconds(ev, rtev->ClockFrequency);
+    uint64_t const         timestamp = EventTimeToNanoseconds(ev, rtev->ClockScale);
     size_t   const        process_ix = FindOrCreateProcess(rtev, process_id, timestamp);
     WIN32_PROCESS_INFO *process_info =&rtev->ProcessList.ProcessInfo[process_ix];
-    WCHAR              *process_path = TraceEventGetWideStr(ev, info_buf, 7);
-    uint32_t const      process_hash = HashWideString(process_path);
-    rtev->ProcessList.ProcessHash[process_ix] = process_hash;
-    process_info->Executable = process_path;
+    string_id_t const   process_path = TraceEventGetWideStr(rtev, ev, info_buf, 7);
+    rtev->ProcessList.ProcessNameId[process_ix] = process_path;
+    process_info->Executable = InternedString(&rtev->Strings, process_path);
     UNREFERENCED_PARAMETER(info_size);
     return process_info;
 }
@@ -774,7 +825,7 @@ ConsumeKernel_Process_TypeGroup1_Terminate
 )
 {   UNREFERENCED_PARAMETER(info_size);
     uint32_t const process_id  = TraceEventGetUInt32(ev, info_buf, 1);
-    uint64_t const  timestamp  = EventTimeToNanoseconds(ev, rtev->ClockFrequency);
+    uint64_t const  timestamp  = EventTimeToNanoseconds(ev, rtev->ClockScale);
     size_t         process_ix  = 0;
     if (FindProcessByPid(rtev, process_id, timestamp, process_ix))
     {   // update the lifetime of the process record.
@@ -804,12 +855,12 @@ ConsumeKernel_ImageLoad_Load
 )
 {   UNREFERENCED_PARAMETER(info_size);
     uint32_t const        process_id = TraceEventGetUInt32(ev, info_buf, 2);
-    uint64_t const         timestamp = EventTimeToNanoseconds(ev, rtev->ClockFrequency);
+    uint64_t const         timestamp = EventTimeToNanoseconds(ev, rtev->ClockScale);
     size_t   const        process_ix = FindOrCreateProcess(rtev, process_id, timestamp);
     WIN32_PROCESS_INFO *process_info =&rtev->ProcessList.ProcessInfo[process_ix];
-    WCHAR                *image_path = TraceEventGetWideStr(ev, info_buf, 11);
+    string_id_t const     image_path = TraceEventGetWideStr(rtev, ev, info_buf, 11);
     uint64_t const        image_base = TraceEventGetPointer(ev, info_buf, 0);
-    size_t   const          image_ix = FindOrCreateImage(process_info, image_path, image_base, timestamp);
+    size_t   const          image_ix = FindOrCreateImage(process_info, &rtev->Strings, image_path, image_base, timestamp);
     UNREFERENCED_PARAMETER (image_ix);
     return process_info;
 }
@@ -831,7 +882,7 @@ ConsumeKernel_ImageLoad_Unload
 )
 {   UNREFERENCED_PARAMETER(info_size);
     uint32_t const        process_id = TraceEventGetUInt32(ev, info_buf, 2);
-    uint64_t const         timestamp = EventTimeToNanoseconds(ev, rtev->ClockFrequency);
+    uint64_t const         timestamp = EventTimeToNanoseconds(ev, rtev->ClockScale);
     size_t   const        process_ix = FindOrCreateProcess(rtev, process_id, timestamp);
     WIN32_PROCESS_INFO *process_info =&rtev->ProcessList.ProcessInfo[process_ix];
     uint64_t const        image_base = TraceEventGetPointer(ev, info_buf, 0);
@@ -861,7 +912,7 @@ ConsumeKernel_Thread_V2_TypeGroup1_Create
 )
 {   UNREFERENCED_PARAMETER(info_size);
     uint32_t const        process_id = TraceEventGetUInt32(ev, info_buf, 0);
-    uint64_t const         timestamp = EventTimeToNanoseconds(ev, rtev->ClockFrequency);
+    uint64_t const         timestamp = EventTimeToNanoseconds(ev, rtev->ClockScale);
     size_t   const        process_ix = FindOrCreateProcess(rtev, process_id, timestamp);
     WIN32_PROCESS_INFO *process_info =&rtev->ProcessList.ProcessInfo[process_ix];
     uint32_t const         thread_id = TraceEventGetUInt32 (ev, info_buf, 1);
@@ -888,7 +939,7 @@ ConsumeKernel_Thread_V2_TypeGroup1_Terminate
 )
 {   UNREFERENCED_PARAMETER(info_size);
     uint32_t const        process_id = TraceEventGetUInt32(ev, info_buf, 0);
-    uint64_t const         timestamp = EventTimeToNanoseconds(ev, rtev->ClockFrequency);
+    uint64_t const         timestamp = EventTimeToNanoseconds(ev, rtev->ClockScale);
     size_t   const        process_ix = FindOrCreateProcess(rtev, process_id, timestamp);
     WIN32_PROCESS_INFO *process_info =&rtev->ProcessList.ProcessInfo[process_ix];
     uint32_t const         thread_id = TraceEventGetUInt32 (ev, info_buf, 1);
@@ -918,10 +969,10 @@ ConsumeKernel_Thread_ReadyThread
 )
 {   UNREFERENCED_PARAMETER(info_size);
     uint32_t const        process_id = ev->EventHeader.ProcessId;
-    uint64_t const         timestamp = EventTimeToNanoseconds(ev, rtev->ClockFrequency);
+    uint64_t const         timestamp = EventTimeToNanoseconds(ev, rtev->ClockScale);
     size_t   const        process_ix = FindOrCreateProcess(rtev, process_id, timestamp);
     WIN32_PROCESS_INFO *process_info =&rtev->ProcessList.ProcessInfo[process_ix];
-    uint32_t const         thread_id = TraceEventGetUInt32(ev, info_buf, 0);
+    uint32_t const         thread_id = TraceEventDecodeUInt32(rtev->DecoderPlan, ev, info_buf, 0);
     size_t                 thread_ix = 0;
 
     if (FindThreadByTid(process_info, thread_id, timestamp, thread_ix))
@@ -929,6 +980,7 @@ ConsumeKernel_Thread_ReadyThread
         WIN32_THREAD_INFO *thread_info = &process_info->ThreadInfo[thread_ix];
         thread_info->ReadyTimes.push_back(timestamp);
         thread_info->ReadyCount++;
+        SnapshotAppendSchedEvent(&rtev->Snapshots, WIN32_SCHED_EVENT_READY, timestamp, process_id, thread_id, uint16_t(GetEventProcessorIndex(ev)));
     }
     return process_info;
 }
@@ -950,36 +1002,39 @@ ConsumeKernel_Thread_CSwitch
 )
 {   UNREFERENCED_PARAMETER(info_size);
     uint32_t const        process_id = ev->EventHeader.ProcessId;
-    uint64_t const         timestamp = EventTimeToNanoseconds(ev, rtev->ClockFrequency);
+    uint64_t const         timestamp = EventTimeToNanoseconds(ev, rtev->ClockScale);
     size_t   const        process_ix = FindOrCreateProcess(rtev, process_id, timestamp);
     WIN32_PROCESS_INFO *process_info =&rtev->ProcessList.ProcessInfo[process_ix];
-    uint32_t const     new_thread_id = TraceEventGetUInt32(ev, info_buf, 0);
-    uint32_t const     old_thread_id = TraceEventGetUInt32(ev, info_buf, 1);
+    WIN32_EVENT_DECODER_PLAN const *plan = rtev->DecoderPlan;
+    uint32_t const     new_thread_id = TraceEventDecodeUInt32(plan, ev, info_buf, 0);
+    uint32_t const     old_thread_id = TraceEventDecodeUInt32(plan, ev, info_buf, 1);
     size_t                 thread_ix = 0;
 
     if (new_thread_id != 0 && FindThreadByTid(process_info, new_thread_id, timestamp, thread_ix))
     {   // the thread is being switched in.
         WIN32_THREAD_INFO *thread_info = &process_info->ThreadInfo[thread_ix];
         WIN32_SWITCH_IN_DATA      data;
-        data.WaitTime  = TraceEventGetUInt32(ev, info_buf, 10); // NewThreadWaitTime
-        data.Processor = TraceEventGetSInt8 (ev, info_buf,  9); // OldThreadWaitIdealProcessor
-        data.Priority  = TraceEventGetSInt8 (ev, info_buf,  2); // NewThreadPriority
+        data.WaitTime  = TraceEventDecodeUInt32(plan, ev, info_buf, 10); // NewThreadWaitTime
+        data.Processor = uint16_t(GetEventProcessorIndex(ev));          // CSwitch is logged by the processor performing the switch
+        data.Priority  = TraceEventDecodeSInt8 (plan, ev, info_buf,  2); // NewThreadPriority
         thread_info->SwitchInTime.push_back(timestamp);
         thread_info->SwitchInData.push_back(data);
         thread_info->SwitchInCount++;
+        SnapshotAppendSchedEvent(&rtev->Snapshots, WIN32_SCHED_EVENT_SWITCH_IN, timestamp, process_id, new_thread_id, data.Processor);
     }
     if (old_thread_id != 0 && FindThreadByTid(process_info, old_thread_id, timestamp, thread_ix))
     {   // the thread is being switched out.
         WIN32_THREAD_INFO *thread_info = &process_info->ThreadInfo[thread_ix];
         WIN32_SWITCH_OUT_DATA     data;
-        data.Processor  = TraceEventGetSInt8(ev, info_buf, 9); // OldThreadWaitIdealProcessor
-        data.State      = TraceEventGetSInt8(ev, info_buf, 8); // OldThreadState
-        data.WaitReason = TraceEventGetSInt8(ev, info_buf, 6); // OldThreadWaitReason
-        data.WaitMode   = TraceEventGetSInt8(ev, info_buf, 7); // OldThreadWaitMode
-        data.Priority   = TraceEventGetSInt8(ev, info_buf, 3); // OldThreadPriority
+        data.Processor  = uint16_t(GetEventProcessorIndex(ev));         // the same processor that switched the new thread in
+        data.State      = TraceEventDecodeSInt8(plan, ev, info_buf, 8); // OldThreadState
+        data.WaitReason = TraceEventDecodeSInt8(plan, ev, info_buf, 6); // OldThreadWaitReason
+        data.WaitMode   = TraceEventDecodeSInt8(plan, ev, info_buf, 7); // OldThreadWaitMode
+        data.Priority   = TraceEventDecodeSInt8(plan, ev, info_buf, 3); // OldThreadPriority
         thread_info->SwitchOutTime.push_back(timestamp);
         thread_info->SwitchOutData.push_back(data);
         thread_info->SwitchOutCount++;
+        SnapshotAppendSchedEvent(&rtev->Snapshots, WIN32_SCHED_EVENT_SWITCH_OUT, timestamp, process_id, old_thread_id, data.Processor);
     }
     return process_info;
 }
@@ -1108,13 +1163,116 @@ FilterTaskProfilerEvent
     ULONG                  info_size, 
     EVENT_RECORD                 *ev
 )
-{   // the following statements are ordered by event frequency, highest to lowest.
-    // ...
-    // else, the profiler doesn't currently care about this class of task profiler event.
-    UNREFERENCED_PARAMETER(rtev);
-    UNREFERENCED_PARAMETER(info_buf);
-    UNREFERENCED_PARAMETER(info_size);
-    UNREFERENCED_PARAMETER(ev);
+{   UNREFERENCED_PARAMETER(info_size);
+    // event identifiers and property indices are defined by the templates in profiler_manifest.man.
+    WIN32_EVENT_DECODER_PLAN const *plan = rtev->DecoderPlan;
+    uint64_t const             timestamp = EventTimeToNanoseconds(ev, rtev->ClockScale);
+    uint32_t                  worker_tid = ev->EventHeader.ThreadId;
+    uint32_t                source_index = 0;
+    task_id_t                  parent_id = INVALID_TASK_ID;
+    uint64_t                 entry_point = 0;
+    size_t                     dep_count = 0;
+    task_id_t const                *deps = NULL;
+    task_id_t                   dep_v0[3];
+    task_id_t                    task_id;
+    uint8_t                         type;
+
+    // the following statements are ordered by event frequency, highest to lowest.
+    switch (info_buf->EventDescriptor.Id)
+    {
+        case 108: // ZoneBeginEvent
+        case 109: // ZoneEndEvent
+            {   // zones are kept apart from task events, and nested under tasks once loading is complete.
+                type = info_buf->EventDescriptor.Id == 108 ? WIN32_ZONE_EVENT_BEGIN : WIN32_ZONE_EVENT_END;
+                AppendZoneEvent(&rtev->ZoneEvents, type, timestamp, worker_tid, TraceEventDecodeUInt32(plan, ev, info_buf, 0));
+            } return;
+        case 105: // TaskLaunchEvent
+        case 106: // TaskFinishEvent
+            {
+                type       = info_buf->EventDescriptor.Id == 105 ? WIN32_TASK_EVENT_LAUNCH : WIN32_TASK_EVENT_FINISH;
+                task_id    = TraceEventDecodeUInt32(plan, ev, info_buf, 0);
+                worker_tid = TraceEventDecodeUInt32(plan, ev, info_buf, 1);
+            } break;
+        case 104: // TaskReadyToRunEvent
+            {
+                type         = WIN32_TASK_EVENT_READY_TO_RUN;
+                task_id      = TraceEventDecodeUInt32(plan, ev, info_buf, 0);
+                source_index = TraceEventDecodeUInt32(plan, ev, info_buf, 1);
+            } break;
+        case 103: // DefineTaskEvent
+            {
+                type         = WIN32_TASK_EVENT_DEFINE_TASK;
+                task_id      = TraceEventDecodeUInt32 (plan, ev, info_buf, 0);
+                parent_id    = TraceEventDecodeUInt32 (plan, ev, info_buf, 1);
+                entry_point  = TraceEventDecodePointer(plan, ev, info_buf, 2);
+                source_index = TraceEventDecodeUInt32 (plan, ev, info_buf, 3);
+                if (info_buf->EventDescriptor.Version >= 1)
+                {   // a counted array of any length.
+                    uint32_t count = TraceEventDecodeUInt32(plan, ev, info_buf, 4);
+                    if ((deps = TraceEventDecodeUInt32Array(rtev, plan, ev, info_buf, 5, count)) != NULL)
+                        dep_count = count;
+                }
+                else
+                {   // version 0 has three fixed slots. unused slots are set to INVALID_TASK_ID.
+                    for (size_t i = 0; i < 3; ++i)
+                    {
+                        task_id_t dep = TraceEventDecodeUInt32(plan, ev, info_buf, 4 + i);
+                        if (dep != INVALID_TASK_ID) dep_v0[dep_count++] = dep;
+                    }
+                    deps = dep_v0;
+                }
+            } break;
+        case 107: // RegisterZoneSiteEvent
+            {
+                uint32_t const   site_id = TraceEventDecodeUInt32(plan, ev, info_buf, 0);
+                char const         *name = TraceEventGetAnsiStr(rtev, ev, info_buf, 1);
+                char const         *file = TraceEventGetAnsiStr(rtev, ev, info_buf, 2);
+                char const     *function = TraceEventGetAnsiStr(rtev, ev, info_buf, 3);
+                uint32_t const      line = TraceEventDecodeUInt32(plan, ev, info_buf, 4);
+                if (site_id != 0 && site_id <= 0xFFFF)
+                    SetZoneSite(&rtev->ZoneEvents, site_id, name ? name : "", file ? file : "", function ? function : "", line);
+            } return;
+        case 100: // RegisterProfiledProcessEvent
+            {   // version 1 adds the task sampling rate, which applies to every task event that follows.
+                if (info_buf->EventDescriptor.Version >= 1)
+                {
+                    uint32_t rate = TraceEventDecodeUInt32(plan, ev, info_buf, 7);
+                    rtev->TaskSampleRate = rate > 1 ? rate : 1;
+                }
+            } return;
+        default:
+            // the profiler doesn't currently care about this class of task profiler event.
+            return;
+    }
+    // ProcessTrace delivers events in timestamp order, so both structures can be appended to directly.
+    AppendTaskEvent(&rtev->TaskEvents, type, timestamp, task_id, worker_tid, source_index, parent_id, entry_point, deps, dep_count);
+    TaskTableAddEvent(&rtev->TaskTable, type, timestamp, task_id, worker_tid, source_index, parent_id, entry_point);
+    SnapshotAppendTaskEvent(&rtev->Snapshots, type, timestamp, task_id, worker_tid);
+}
+
+/// @summary Publish a snapshot of the events consumed so far for the user interface. Called only by the thread loading the trace.
+/// @param rtev The profiler events container being loaded.
+/// @param latest_time The timestamp of the most recently consumed event, in nanoseconds. Used to estimate progress.
+/// @param complete Specify true if all events have been consumed and the analyses have been built or loaded from the cache.
+internal_function void
+PublishLoadingSnapshot
+(
+    WIN32_PROFILER_EVENTS *rtev,
+    uint64_t        latest_time,
+    bool               complete
+)
+{
+    size_t thread_count = 0;
+    float  progress     = 0.0f;
+    for (size_t i = 0; i < rtev->ProcessList.ProcessCount; ++i)
+    {
+        thread_count += rtev->ProcessList.ProcessInfo[i].ThreadCount;
+    }
+    if (rtev->TraceDuration > 0 && latest_time > rtev->FirstEventTime)
+    {   // events are consumed in time order, so elapsed trace time approximates the fraction loaded.
+        progress = float(double(latest_time - rtev->FirstEventTime) / double(rtev->TraceDuration));
+    }
+    PublishProfilerSnapshot(&rtev->Snapshots, PlatformTimestamp(), progress, rtev->ProcessList.ProcessCount, thread_count, rtev->TaskTable.TaskCount, complete);
 }
 
 /// @summary Callback invoked for each event reported by Event Tracing for Windows.
@@ -1126,21 +1284,58 @@ ProfilerRecordEvent
 )
 {
     WIN32_PROFILER_EVENTS *profiler = (WIN32_PROFILER_EVENTS*) ev->UserContext;
-    TRACE_EVENT_INFO      *info_buf = (TRACE_EVENT_INFO*) profiler->EventBuffer;
-    ULONG                  size_buf = (ULONG) profiler->EventBufferSize;
-
-    // retrieve event metadata used to dispatch the event for processing.
-    if (TdhGetEventInformation(ev, 0, NULL, info_buf, &size_buf) == ERROR_SUCCESS)
-    {   // event metadata was successfully retrieved; dispatch the event 
-        // based on the system that produced it.
-        if      (IsKernelTraceProvider (info_buf)) FilterKernelProviderEvent(profiler, info_buf, size_buf, ev);
-        else if (IsTaskProfilerProvider(info_buf)) FilterTaskProfilerEvent  (profiler, info_buf, size_buf, ev);
-        // else, the profiler doesn't currently use events from the provider. drop it.
+    WIN32_EVENT_DECODER_PLAN  *plan = NULL;
+    WIN32_EVENT_SCHEMA_KEY      key;
+
+    // publish the prefix consumed so far so the user interface can display it while loading continues.
+    if (profiler->FirstEventTime == 0)
+    {
+        profiler->FirstEventTime = EventTimeToNanoseconds(ev, profiler->ClockScale);
     }
-    else
-    {   // TODO(rlk): probably the buffer size is too small.
-        // handle the case where TdhGetEventInformation fails.
+    if (++profiler->Snapshots.PollCounter >= WIN32_SNAPSHOT_POLL_EVENTS)
+    {
+        profiler->Snapshots.PollCounter = 0;
+        if (ProfilerSnapshotDue(&profiler->Snapshots, PlatformTimestamp()))
+            PublishLoadingSnapshot(profiler, EventTimeToNanoseconds(ev, profiler->ClockScale), false);
+    }
+
+    // look up the plan for the event schema. TdhGetEventInformation is 
+    // only called the first time a schema is seen.
+    TraceEventSchemaKey(key, ev);
+    if ((plan = FindEventDecoderPlan(&profiler->DecoderCache, key)) == NULL)
+    {
+        TRACE_EVENT_INFO *info_buf = (TRACE_EVENT_INFO*) profiler->EventBuffer;
+        ULONG             size_buf = (ULONG) profiler->EventBufferSize;
+        ULONG             result   = TdhGetEventInformation(ev, 0, NULL, info_buf, &size_buf);
+        if (result == ERROR_INSUFFICIENT_BUFFER)
+        {   // grow the buffer to the size requested by TDH and try again.
+            uint8_t *new_buf = (uint8_t*) realloc(profiler->EventBuffer, size_t(size_buf));
+            if (new_buf == NULL) return;
+            profiler->EventBuffer     = new_buf;
+            profiler->EventBufferSize = size_t(size_buf);
+            info_buf = (TRACE_EVENT_INFO*) new_buf;
+            result   = TdhGetEventInformation(ev, 0, NULL, info_buf, &size_buf);
+        }
+        if (result != ERROR_SUCCESS)
+        {   // no metadata is available for this event, so it can't be decoded. drop it.
+            return;
+        }
+        WIN32_EVENT_DECODER_PLAN new_plan;
+        if (!BuildEventDecoderPlan(&new_plan, info_buf, size_buf, key.PointerSize))
+        {   // insufficient memory to cache the schema.
+            return;
+        }
+        plan = InsertEventDecoderPlan(&profiler->DecoderCache, key, &new_plan);
     }
+
+    // dispatch the event based on the system that produced it.
+    TRACE_EVENT_INFO *info_buf = (TRACE_EVENT_INFO*) plan->EventInfo;
+    ULONG             size_buf = (ULONG) plan->EventInfoSize;
+    profiler->DecoderPlan = plan;
+    if      (IsKernelTraceProvider (info_buf)) FilterKernelProviderEvent(profiler, info_buf, size_buf, ev);
+    else if (IsTaskProfilerProvider(info_buf)) FilterTaskProfilerEvent  (profiler, info_buf, size_buf, ev);
+    // else, the profiler doesn't currently use events from the provider. drop it.
+    profiler->DecoderPlan = NULL;
 }
 
 /// @summary Implements the entry point of the thread that dispatches ETW context switch events.
@@ -1166,21 +1361,137 @@ EventConsumerThreadMain
     // ProcessTrace sorts events by timestamp and calls TaskProfilerRecordEvent.
     ULONG result  = ProcessTrace(&profiler->ConsumerHandle, 1, NULL, NULL);
     if   (result != ERROR_SUCCESS)
-    {   // the thread is going to terminate because an error occurred.
+    {   // the thread is going to terminate because an error occurred. keep whatever was loaded.
         ConsoleError("ERROR (%S): Context switch consumer terminating with result %08X.\n", __FUNCTION__, result);
+        BuildProfilerAnalyses(profiler);
+        PublishLoadingSnapshot(profiler, 0, true);
         return 1;
     }
 
+    // the columns won't change again, so the derived structures can be built once before the user interface reads them.
+    BuildProfilerAnalyses(profiler);
+    PublishLoadingSnapshot(profiler, 0, true);
+
+    // all events have been consumed; save the loaded columns and analyses so the trace opens quickly next time.
+    if (profiler->CacheFile != NULL)
+    {
+        if (!WriteAnalysisCache(profiler, profiler->CacheFile, profiler->SourceSize, profiler->SourceTime, profiler->SourceHash))
+            ConsoleError("WARNING (%S): Unable to write the analysis cache.\n", __FUNCTION__);
+        fclose(profiler->CacheFile); profiler->CacheFile = NULL;
+    }
+
     // all events have been consumed, so close the trace session.
     CloseHandle(profiler->ConsumerLaunch); profiler->ConsumerLaunch = NULL;
     CloseTrace(profiler->ConsumerHandle); profiler->ConsumerHandle = NULL;
     return 0;
 }
 
+/// @summary Initialize the fields of a newly allocated profiler events container.
+/// @param ev The profiler events container to initialize.
+internal_function void
+InitProfilerEvents
+(
+    WIN32_PROFILER_EVENTS *ev
+)
+{
+    ev->EventBuffer      = NULL;
+    ev->EventBufferSize  = 0;
+    ev->ConsumerHandle   = INVALID_PROCESSTRACE_HANDLE;
+    ev->ConsumerLaunch   = NULL;
+    ev->ConsumerThread   = NULL;
+    ev->ConsumerThreadId = 0;
+    ev->DecoderPlan      = NULL;
+    ev->DroppedEventCount= 0;
+    ev->TaskSampleRate   = 1;
+    InitEventDecoderCache(&ev->DecoderCache);
+    InitTaskEventList(&ev->TaskEvents);
+    InitTaskTable(&ev->TaskTable);
+    InitZoneEventList(&ev->ZoneEvents);
+    InitTaskCounterList(&ev->TaskCounters);
+    ev->ProcessList.ProcessCount  = 0;
+    InitObjectIndex(ev->ProcessList.ProcessIndex);
+    ev->Scheduler.WorkerCount     = 0;
+    ev->Scheduler.SourceCount     = 0;
+    ev->CacheFile        = NULL;
+    ev->SourceSize       = 0;
+    ev->SourceTime       = 0;
+    ev->SourceHash       = 0;
+    ev->CacheMapping.Data         = NULL;
+    ev->CacheMapping.Size         = 0;
+    ev->CacheMapping.ModifiedTime = 0;
+    ev->CacheMapping.Mapping      = NULL;
+    ev->FirstEventTime   = 0;
+    ev->TraceDuration    = 0;
+    InitMemoryArena(&ev->Arena, 0);
+    InitStringTable(&ev->Strings);
+    ev->PropertyBuffer.clear();
+    DeleteTimelineLod(&ev->TimelineLod);
+    DeleteCriticalPath(&ev->CriticalPath);
+    DeleteCpuTimeline(&ev->CpuTimeline);
+    DeleteWakeLatency(&ev->WakeLatency);
+    DeleteOffCpuReport(&ev->OffCpu);
+    DeleteQueueDepth(&ev->QueueDepth);
+    DeleteParallelismProfile(&ev->Parallelism);
+    DeleteZoneTree(&ev->ZoneTree);
+    DeleteTaskCounterReport(&ev->CounterReport);
+    DeleteTaskAllocReport(&ev->AllocReport);
+    InitSnapshotPublisher(&ev->Snapshots, (PlatformTimestampFrequency() * WIN32_SNAPSHOT_INTERVAL_MS) / 1000);
+}
+
+/// @summary Build the path of the analysis cache file for a trace file by appending the .pcache extension.
+/// @param buf The buffer to receive the path.
+/// @param buf_count The maximum number of characters that can be written to buf, including the terminator.
+/// @param trace_file A NULL-terminated string specifying the path of the trace file.
+/// @return true if the path fits in the buffer.
+internal_function bool
+AnalysisCachePath
+(
+    TCHAR             *buf,
+    size_t        buf_count,
+    TCHAR const *trace_file
+)
+{
+    return SUCCEEDED(StringCchCopy(buf, buf_count, trace_file)) && SUCCEEDED(StringCchCat(buf, buf_count, _T(".pcache")));
+}
+
+/// @summary Attempt to populate a profiler events container from the analysis cache file for a trace. The cache is mapped
+/// copy-on-write and the loaded columns view it directly, so on success the mapping is kept in ev->CacheMapping and is
+/// released by DeleteProfilerEvents.
+/// @param ev The freshly initialized profiler events container. SourceSize, SourceTime and SourceHash must be set.
+/// @param cache_path A NULL-terminated string specifying the path of the analysis cache file.
+/// @return true if the cache exists, matches the trace file and was loaded.
+internal_function bool
+LoadAnalysisCacheFile
+(
+    WIN32_PROFILER_EVENTS *ev,
+    TCHAR const   *cache_path
+)
+{
+    PLATFORM_FILE_MAPPING map;
+    FILE                  *fp = _tfopen(cache_path, _T("rb"));
+    bool               result = false;
+    if (fp == NULL)
+    {   // there's no cache for this trace yet.
+        return false;
+    }
+    if (PlatformMapFile(fp, &map, true))
+    {
+        if ((result = LoadAnalysisCache(ev, map.Data, map.Size, ev->SourceSize, ev->SourceTime, ev->SourceHash)))
+            ev->CacheMapping = map;
+        else
+            PlatformUnmapFile(&map);
+    }
+    fclose(fp);
+    return result;
+}
+
 /*////////////////////////
 //   Public Functions   //
 ////////////////////////*/
 /// @summary Allocate resources for a new WIN32_PROFILER_EVENTS container, open a trace session and consume the event data.
+/// Files with a .ptrace extension are written by the native profiler backend and are loaded before the function returns.
+/// If an analysis cache (<trace_file>.pcache) matching the trace exists, it is loaded instead and no session is opened;
+/// otherwise the cache is written once all events have been consumed.
 /// @param trace_file A NULL-terminated string specifying the path of the file to load.
 /// @return The profiler events container, or NULL.
 public_function WIN32_PROFILER_EVENTS*
@@ -1194,14 +1505,73 @@ NewProfilerEvents
     EVENT_TRACE_LOGFILE logfile = {};
     HANDLE               thread = NULL;
     unsigned int            tid = 0;
+    TCHAR const            *ext = _tcsrchr(trace_file, _T('.'));
+    TCHAR     cache_path[MAX_PATH + 8];
+    PLATFORM_FILE_MAPPING   src;
+    FILE                    *fp = NULL;
 
     // initialize the fields of the events structure.
-    ev->EventBuffer      = NULL;
-    ev->EventBufferSize  = 0;
-    ev->ConsumerHandle   = INVALID_PROCESSTRACE_HANDLE;
+    InitProfilerEvents(ev);
+
+    // map the trace file to identify it, and so that .ptrace files can be decoded without a copy.
+    if ((fp = _tfopen(trace_file, _T("rb"))) == NULL || !PlatformMapFile(fp, &src, false))
+    {   // the file doesn't exist, or can't be read.
+        ConsoleError("ERROR (%S): Unable to open trace file (errno = %d).\n", __FUNCTION__, errno);
+        if (fp != NULL) fclose(fp);
+        delete ev;
+        return NULL;
+    }
+    fclose(fp); fp = NULL;
+    ev->SourceSize = src.Size;
+    ev->SourceTime = src.ModifiedTime;
+    ev->SourceHash = AnalysisCacheSourceHash(src.Data, src.Size);
+    if (!AnalysisCachePath(cache_path, sizeof(cache_path) / sizeof(cache_path[0]), trace_file))
+    {   // the path is too long to append the extension; load the trace without a cache.
+        cache_path[0] = 0;
+    }
+    if (cache_path[0] != 0 && LoadAnalysisCacheFile(ev, cache_path))
+    {   // the trace was analyzed previously and hasn't changed since, so the analyses were loaded too.
+        PlatformUnmapFile(&src);
+        PublishLoadingSnapshot(ev, 0, true);
+        return ev;
+    }
+    if (cache_path[0] != 0)
+    {   // the cache is missing or stale; discard anything partially loaded from it.
+        uint64_t const source_hash = ev->SourceHash;
+        delete ev;
+        ev = new WIN32_PROFILER_EVENTS();
+        InitProfilerEvents(ev);
+        ev->SourceSize = src.Size;
+        ev->SourceTime = src.ModifiedTime;
+        ev->SourceHash = source_hash;
+        ev->CacheFile  = _tfopen(cache_path, _T("wb"));
+    }
+
+    if (ext != NULL && _tcsicmp(ext, _T(".ptrace")) == 0)
+    {   // native traces are loaded synchronously; there's no ETW session to consume.
+        if (src.Data == NULL || !LoadPtraceEvents(ev, src.Data, src.Size, 0))
+        {   // the file is empty, truncated or not a .ptrace file.
+            ConsoleError("ERROR (%S): Unable to load native trace file.\n", __FUNCTION__);
+            if (ev->CacheFile != NULL) fclose(ev->CacheFile);
+            PlatformUnmapFile(&src);
+            delete ev;
+            return NULL;
+        }
+        PlatformUnmapFile(&src);
+        BuildProfilerAnalyses(ev);
+        if (ev->CacheFile != NULL)
+        {   // a failure to write the cache only means the next load is slower.
+            if (!WriteAnalysisCache(ev, ev->CacheFile, ev->SourceSize, ev->SourceTime, ev->SourceHash))
+                ConsoleError("WARNING (%S): Unable to write the analysis cache.\n", __FUNCTION__);
+            fclose(ev->CacheFile); ev->CacheFile = NULL;
+        }
+        PublishLoadingSnapshot(ev, 0, true);
+        return ev;
+    }
+    PlatformUnmapFile(&src);
+
+    // ETW traces are consumed on a background thread launched below.
     ev->ConsumerLaunch   = CreateEvent(NULL, TRUE, FALSE, NULL); // manual-reset
-    ev->ConsumerThread   = NULL;
-    ev->ConsumerThreadId = 0;
 
     // attempt to open the trace file from the supplied path.
     logfile.LogFileName         = (TCHAR*)trace_file;
@@ -1213,6 +1583,7 @@ NewProfilerEvents
     {   // if the trace cannot be opened, there's no point in continuing.
         ConsoleError("ERROR (%S): Unable to open the trace session (%08X).\n", __FUNCTION__, GetLastError());
         CloseHandle(ev->ConsumerLaunch); ev->ConsumerLaunch = NULL;
+        if (ev->CacheFile != NULL) fclose(ev->CacheFile);
         delete ev;
         return NULL;
     }
@@ -1223,12 +1594,13 @@ NewProfilerEvents
         ConsoleError("ERROR (%S): Unable to start event consumer thread (errno = %d).\n", __FUNCTION__, errno);
         CloseHandle(ev->ConsumerLaunch); ev->ConsumerLaunch = NULL;
         CloseTrace(trace);
+        if (ev->CacheFile != NULL) fclose(ev->CacheFile);
         delete ev;
         return NULL;
     }
 
-    // TODO(rlk): might want to move to a memory arena system based around VirtualAlloc.
-    // this would provide better performance and probably lead to less memory waste.
+    // the metadata buffer is grown with realloc by ProfilerRecordEvent, so it lives outside of ev->Arena,
+    // which owns all of the strings referenced by the loaded data.
     ev->EventBuffer              =(uint8_t*) malloc(64 * 1024); // 64KB
     ev->EventBufferSize          = 64 * 1024;
     ev->ConsumerHandle           = trace;
@@ -1237,6 +1609,8 @@ NewProfilerEvents
     ev->PointerSize              =(size_t  ) logfile.LogfileHeader.PointerSize;
     ev->TimerResolution          =(uint64_t) logfile.LogfileHeader.TimerResolution;
     ev->ClockFrequency           = logfile.LogfileHeader.PerfFreq;
+    ev->ClockScale               = TimestampScale(uint64_t(logfile.LogfileHeader.PerfFreq.QuadPart), 1000000000ULL);
+    ev->TraceDuration            =(uint64_t)(logfile.LogfileHeader.EndTime.QuadPart - logfile.LogfileHeader.StartTime.QuadPart) * 100; // 100ns units
     ev->ProcessList.ProcessCount = 0;
 
     // TODO(rlk): initialize other event data containers here.
@@ -1281,6 +1655,15 @@ DeleteProfilerEvents
             ev->EventBuffer = NULL;
             ev->EventBufferSize = 0;
         }
+        if (ev->CacheFile != NULL)
+        {   // the consumer thread failed before writing the cache. the header was never written, so the file is ignored.
+            fclose(ev->CacheFile);
+            ev->CacheFile = NULL;
+        }
+        DeleteEventDecoderCache(&ev->DecoderCache);
+        DeleteSnapshotPublisher(&ev->Snapshots);
+        DeleteMemoryArena(&ev->Arena); // releases every loader-owned string.
+        PlatformUnmapFile(&ev->CacheMapping); // releases every column and string loaded from the cache.
         delete ev; *events = NULL;
     }
 }
@@ -45,7 +45,11 @@
 /*////////////////
 //   Includes   //
 ////////////////*/
+#include <algorithm>
+#include <atomic>
+#include <deque>
 #include <iostream>
+#include <string>
 #include <vector>
 
 #include <stddef.h>
@@ -69,8 +73,31 @@
 #include <io.h>
 
 #include "profiler.h"
+#include "ptrace.h"
+#include "platform.cc"
 #include "visualizer_types.h"
-
+#include "ptrace_codec.cc"
+#include "memory_arena.cc"
+#include "string_table.cc"
+#include "object_index.cc"
+#include "thread_intervals.cc"
+#include "event_decoder.cc"
+#include "task_table.cc"
+#include "lod_pyramid.cc"
+#include "cpu_timeline.cc"
+#include "latency_histogram.cc"
+#include "wake_latency.cc"
+#include "off_cpu.cc"
+#include "queue_depth.cc"
+#include "step_function.cc"
+#include "parallelism.cc"
+#include "zone_tree.cc"
+#include "task_counters.cc"
+#include "critical_path.cc"
+#include "schedule_replay.cc"
+#include "analysis_cache.cc"
+#include "snapshot.cc"
+#include "ptrace_loader.cc"
 #include "trace_loader.cc"
 
 #include "imgui.cpp"
@@ -96,6 +123,11 @@ struct COMMAND_LINE
     TCHAR                 *TraceFile;
 };
 
+/// @summary Define the maximum number of scheduler replay results kept for comparison. The oldest result is discarded first.
+#ifndef UI_REPLAY_MAX_RESULTS
+#define UI_REPLAY_MAX_RESULTS     16
+#endif
+
 /// @summary Define the global user interface state.
 struct UI_STATE
 {
@@ -104,9 +136,76 @@ struct UI_STATE
     COMMAND_LINE          *CommandLine;
     GLFWwindow            *MainWindow;
     bool                   ShowConsole;
+    float                  QueryStart;        /// The start of the time window being browsed, as a fraction of the loaded time span.
+    float                  QueryEnd;          /// The end of the time window being browsed, as a fraction of the loaded time span.
+    int                    ReplayWorkers;     /// The number of workers to simulate in the next scheduler replay.
+    int                    ReplayPolicy;      /// One of WIN32_SCHEDULER_POLICY, used for the next scheduler replay.
+    int                    ReplayStealCost;   /// The cost of stealing a task in the next scheduler replay, in nanoseconds.
+    size_t                 ReplayCount;       /// The number of valid entries in Replay.
+    WIN32_SCHEDULER_REPLAY Replay[UI_REPLAY_MAX_RESULTS]; /// The results of the most recent scheduler replays, oldest first.
+    int                    WhatIfPercent;     /// The percentage by which task execution times are reduced when ranking entry points.
+    int                    WhatIfMaxEntries;  /// The maximum number of entry points to rank, chosen by execution time, or 0 for all.
+    WIN32_VIRTUAL_SPEEDUP_REPORT *WhatIf;     /// The most recent ranking of entry points by virtual speedup, or NULL.
+    float                  CoreQueryTime;     /// The time inspected by the core occupancy report, as a fraction of the time window being browsed.
+    int                    WakeThresholdUs;   /// The latency above which a wakeup is listed as slow, in microseconds.
     TCHAR                  TracePath[32768];
 };
 
+/// @summary Define the snapshot reader slot used by the user interface thread.
+#ifndef UI_SNAPSHOT_READER
+#define UI_SNAPSHOT_READER        0
+#endif
+
+/// @summary Define the maximum number of events listed when browsing a trace that is still loading.
+#ifndef UI_LOADING_EVENT_LIST_MAX
+#define UI_LOADING_EVENT_LIST_MAX 64
+#endif
+
+/// @summary Define the height of a timeline row, in pixels.
+#ifndef UI_TIMELINE_ROW_HEIGHT
+#define UI_TIMELINE_ROW_HEIGHT    16.0f
+#endif
+
+/// @summary Define the maximum number of samples taken across a timeline row. Wider rows stretch the samples.
+#ifndef UI_TIMELINE_MAX_PIXELS
+#define UI_TIMELINE_MAX_PIXELS    8192
+#endif
+
+/// @summary Define the maximum number of entry points listed in the critical path report.
+#ifndef UI_CRITICAL_PATH_ENTRY_POINTS
+#define UI_CRITICAL_PATH_ENTRY_POINTS 10
+#endif
+
+/// @summary Define the maximum number of threads, worst first, listed in the wake latency report.
+#ifndef UI_WAKE_LATENCY_THREADS
+#define UI_WAKE_LATENCY_THREADS   16
+#endif
+
+/// @summary Define the maximum number of slow wakeups, slowest first, listed in the wake latency report.
+#ifndef UI_WAKE_LATENCY_SLOW_LIST
+#define UI_WAKE_LATENCY_SLOW_LIST 32
+#endif
+
+/// @summary Define the maximum number of threads and of entry points, most blocked first, listed in the off-CPU report.
+#ifndef UI_OFF_CPU_ROWS
+#define UI_OFF_CPU_ROWS           16
+#endif
+
+/// @summary Define the maximum number of zone sites, longest inclusive time first, listed in the zone report.
+#ifndef UI_ZONE_ROWS
+#define UI_ZONE_ROWS              32
+#endif
+
+/// @summary Define the maximum number of entry points, most cycles first, and of slowest tasks listed in the task counter report.
+#ifndef UI_COUNTER_ROWS
+#define UI_COUNTER_ROWS           16
+#endif
+
+/// @summary Define the maximum number of entry points and of tasks, most allocations first, listed in the allocation report.
+#ifndef UI_ALLOC_ROWS
+#define UI_ALLOC_ROWS             16
+#endif
+
 /*///////////////
 //   Globals   //
 ///////////////*/
@@ -366,10 +465,15 @@ NewUIState
         return NULL;
     }
     ZeroMemory(ui, sizeof(UI_STATE));
-    ui->TopLevelState   = UI_STATE_ID_NO_TRACE_LOADED;
-    ui->CommandLine     = command_line;
-    ui->MainWindow      = main_window;
-    ui->ShowConsole     = false;
+    ui->TopLevelState    = UI_STATE_ID_NO_TRACE_LOADED;
+    ui->CommandLine      = command_line;
+    ui->MainWindow       = main_window;
+    ui->ShowConsole      = false;
+    ui->QueryStart       = 0.0f;
+    ui->QueryEnd         = 1.0f;
+    ui->WhatIfPercent    = 20;
+    ui->WhatIfMaxEntries = 32;
+    ui->WakeThresholdUs  = int(WIN32_WAKE_LATENCY_DEFAULT_THRESHOLD / 1000);
     return ui;
 }
 
@@ -405,6 +509,7 @@ DeleteUIState
         {   // this also sets ui->EventData to NULL.
             DeleteProfilerEvents(&ui->EventData);
         }
+        delete ui->WhatIf;
         free(ui);
     }
 }
@@ -424,7 +529,7 @@ SelectTraceFile
     ZeroMemory(path , 32768 * sizeof(WCHAR));
     ofn.lStructSize = sizeof(OPENFILENAME);
     ofn.hwndOwner   = glfwGetWin32Window(ui->MainWindow);
-    ofn.lpstrFilter = _T("Trace Files (*.etl)\0*.etl\0All Files (*.*)\0*.*\0");
+    ofn.lpstrFilter = _T("Trace Files (*.etl;*.ptrace)\0*.etl;*.ptrace\0All Files (*.*)\0*.*\0");
     ofn.lpstrFile   = path;
     ofn.nMaxFile    = 32767;
     ofn.Flags       = OFN_EXPLORER | OFN_FILEMUSTEXIST;
@@ -441,6 +546,951 @@ SelectTraceFile
     }
 }
 
+/// @summary Display the progress of a trace that is still loading, and allow the prefix loaded so far to be browsed. Both the task events and
+/// the thread ready and switch events are read through the snapshot, never from the columns of WIN32_PROFILER_EVENTS, which the loader may
+/// still be reallocating. Switches the top-level state to UI_STATE_ID_TRACE_LOADED once the loader publishes its final snapshot.
+/// @param ui The application user interface state to update.
+internal_function void
+BuildTraceLoadingView
+(
+    UI_STATE *ui
+)
+{
+    local_persist char const *EventTypeName[] = { "define", "ready", "launch", "finish" };
+    local_persist char const *SchedTypeName[] = { "ready", "in", "out", "?" };
+    WIN32_PROFILER_SNAPSHOT const *s = AcquireProfilerSnapshot(&ui->EventData->Snapshots, UI_SNAPSHOT_READER);
+    char                     overlay[64];
+    size_t                   lower = 0, upper = 0, count = 0;
+    if (s == NULL)
+    {   // the loader hasn't consumed enough events to publish anything yet.
+        ImGui::ProgressBar(0.0f, ImVec2(-1, 0), "Opening trace...");
+        ReleaseProfilerSnapshot(&ui->EventData->Snapshots, UI_SNAPSHOT_READER);
+        return;
+    }
+    sprintf_s(overlay, "%.0f%% (%llu events)", s->Progress * 100.0f, (unsigned long long) (s->EventCount + s->SchedEventCount));
+    ImGui::ProgressBar(s->Progress, ImVec2(-1, 0), overlay);
+    ImGui::Text("%u processes, %u threads, %u tasks", unsigned(s->ProcessCount), unsigned(s->ThreadCount), unsigned(s->TaskCount));
+    if (s->EventCount > 0 || s->SchedEventCount > 0)
+    {   // browse the task and scheduling events loaded so far. the window is relative, so it stays valid as the prefix grows.
+        uint64_t const span = s->LastTime - s->FirstTime;
+        ImGui::DragFloatRange2("Time window", &ui->QueryStart, &ui->QueryEnd, 0.001f, 0.0f, 1.0f, "Start: %.3f", "End: %.3f");
+        uint64_t const t0   = s->FirstTime + uint64_t(double(span) * ui->QueryStart);
+        uint64_t const t1   = s->FirstTime + uint64_t(double(span) * ui->QueryEnd);
+        if (FindSnapshotEventsInTimeRange(s, t0, t1, lower, upper, count))
+        {
+            ImGui::Text("%llu events in [%.3f ms, %.3f ms]", (unsigned long long) count, double(t0 - s->FirstTime) / 1000000.0, double(t1 - s->FirstTime) / 1000000.0);
+            for (size_t i = lower; i <= upper && i < lower + UI_LOADING_EVENT_LIST_MAX; ++i)
+            {
+                WIN32_TASK_EVENT_CHUNK const *chunk = s->Chunks[i >> WIN32_SNAPSHOT_CHUNK_SHIFT];
+                size_t                 const j     = i & (WIN32_SNAPSHOT_CHUNK_SIZE - 1);
+                ImGui::Text("%12.3f ms  %-6s  task %08X  thread %u", double(chunk->EventTime[j] - s->FirstTime) / 1000000.0, EventTypeName[chunk->EventType[j] & 3], chunk->TaskId[j], chunk->ThreadId[j]);
+            }
+        }
+        else
+        {
+            ImGui::Text("No events in the selected time window.");
+        }
+        ImGui::Separator();
+        if (FindSnapshotSchedEventsInTimeRange(s, t0, t1, lower, upper, count))
+        {
+            ImGui::Text("%llu scheduling events in [%.3f ms, %.3f ms]", (unsigned long long) count, double(t0 - s->FirstTime) / 1000000.0, double(t1 - s->FirstTime) / 1000000.0);
+            for (size_t i = lower; i <= upper && i < lower + UI_LOADING_EVENT_LIST_MAX; ++i)
+            {
+                WIN32_SCHED_EVENT_CHUNK const *chunk = s->SchedChunks[i >> WIN32_SNAPSHOT_CHUNK_SHIFT];
+                size_t                  const j     = i & (WIN32_SNAPSHOT_CHUNK_SIZE - 1);
+                ImGui::Text("%12.3f ms  %-6s  process %u  thread %u  cpu %u", double(chunk->EventTime[j] - s->FirstTime) / 1000000.0, SchedTypeName[chunk->EventType[j] & 3], chunk->ProcessId[j], chunk->ThreadId[j], unsigned(chunk->Processor[j]));
+            }
+        }
+        else
+        {
+            ImGui::Text("No scheduling events in the selected time window.");
+        }
+    }
+    if (s->Complete)
+    {   // the loader has finished, so the full columns can be used directly.
+        ui->TopLevelState = UI_STATE_ID_TRACE_LOADED;
+        ui->QueryStart    = 0.0f;
+        ui->QueryEnd      = 1.0f;
+    }
+    ReleaseProfilerSnapshot(&ui->EventData->Snapshots, UI_SNAPSHOT_READER);
+}
+
+/// @summary Draw a single timeline row from its level-of-detail summary. The cost depends on the row width in pixels, not on the number of spans in the row.
+/// @param ev The loaded trace data. Labels are interpreted as rows of ev->TaskTable.
+/// @param pyr The summary of the row to draw.
+/// @param range_lower The time at the left edge of the row, in nanoseconds.
+/// @param range_upper The time at the right edge of the row, in nanoseconds.
+internal_function void
+BuildTimelineRow
+(
+    WIN32_PROFILER_EVENTS const *ev,
+    WIN32_LOD_PYRAMID const    *pyr,
+    uint64_t            range_lower,
+    uint64_t            range_upper
+)
+{
+    local_persist float    busy [UI_TIMELINE_MAX_PIXELS];
+    local_persist uint32_t label[UI_TIMELINE_MAX_PIXELS];
+    ImVec2 const size(ImGui::GetContentRegionAvail().x, UI_TIMELINE_ROW_HEIGHT);
+    if (size.x < 1.0f || !ImGui::IsRectVisible(size))
+    {   // rows scrolled out of view aren't sampled at all.
+        ImGui::Dummy(size);
+        return;
+    }
+    ImVec2      const pos         = ImGui::GetCursorScreenPos();
+    ImDrawList       *draw        = ImGui::GetWindowDrawList();
+    size_t      const pixel_count = size.x > float(UI_TIMELINE_MAX_PIXELS) ? size_t(UI_TIMELINE_MAX_PIXELS) : size_t(size.x);
+    float       const scale       = size.x / float(pixel_count);
+    SampleLodPyramid(pyr, range_lower, range_upper, pixel_count, busy, label);
+    draw->AddRectFilled(pos, ImVec2(pos.x + size.x, pos.y + size.y), ImColor(32, 32, 32));
+    for (size_t p = 0; p < pixel_count; )
+    {   // merge runs of pixels with the same label and shade into a single rectangle.
+        int    const shade = int(busy[p] * 31.0f + 0.5f);
+        size_t       q     = p + 1;
+        while (q < pixel_count && label[q] == label[p] && int(busy[q] * 31.0f + 0.5f) == shade)
+            q++;
+        if (shade > 0)
+        {   // tasks with the same entry point share a color; unlabeled spans are grey.
+            uint64_t const h = label[p] != WIN32_LOD_NO_LABEL ? ObjectIndexHash(ev->TaskTable.EntryPoint[label[p]]) : 0;
+            int      const r = label[p] != WIN32_LOD_NO_LABEL ? int(64 + ( h        & 0x7F)) : 160;
+            int      const g = label[p] != WIN32_LOD_NO_LABEL ? int(64 + ((h >>  8) & 0x7F)) : 160;
+            int      const b = label[p] != WIN32_LOD_NO_LABEL ? int(64 + ((h >> 16) & 0x7F)) : 160;
+            draw->AddRectFilled(ImVec2(pos.x + float(p) * scale, pos.y), ImVec2(pos.x + float(q) * scale, pos.y + size.y), ImColor(r, g, b, 64 + shade * 6));
+        }
+        p = q;
+    }
+    ImGui::Dummy(size);
+    if (ImGui::IsItemHovered())
+    {
+        size_t const p = size_t((ImGui::GetMousePos().x - pos.x) / scale);
+        if (p < pixel_count && label[p] != WIN32_LOD_NO_LABEL && label[p] < ev->CriticalPath.TaskCount)
+            ImGui::SetTooltip("%.1f%% busy, mostly task %08X (entry point %llX, slack %.3f ms)", busy[p] * 100.0f, ev->TaskTable.TaskId[label[p]], (unsigned long long) ev->TaskTable.EntryPoint[label[p]], double(ev->CriticalPath.Slack[label[p]]) / 1000000.0);
+        else if (p < pixel_count && label[p] != WIN32_LOD_NO_LABEL)
+            ImGui::SetTooltip("%.1f%% busy, mostly task %08X (entry point %llX)", busy[p] * 100.0f, ev->TaskTable.TaskId[label[p]], (unsigned long long) ev->TaskTable.EntryPoint[label[p]]);
+        else if (p < pixel_count)
+            ImGui::SetTooltip("%.1f%% busy", busy[p] * 100.0f);
+    }
+}
+
+/// @summary Display a queue depth series as a bar chart, scaled so that the peak depth of the series fills the row. Each bar shows the
+/// largest depth within its pixel, with the mean depth drawn brighter inside it.
+/// @param pyr The step function pyramid of the series.
+/// @param max_depth The peak depth of the series.
+/// @param range_lower The time at the left edge of the row, in nanoseconds.
+/// @param range_upper The time at the right edge of the row, in nanoseconds.
+internal_function void
+BuildQueueDepthRow
+(
+    WIN32_STEP_PYRAMID const *pyr,
+    uint32_t            max_depth,
+    uint64_t          range_lower,
+    uint64_t          range_upper
+)
+{
+    local_persist float peak[UI_TIMELINE_MAX_PIXELS];
+    local_persist float mean[UI_TIMELINE_MAX_PIXELS];
+    ImVec2 const size(ImGui::GetContentRegionAvail().x, UI_TIMELINE_ROW_HEIGHT);
+    if (size.x < 1.0f || !ImGui::IsRectVisible(size))
+    {   // rows scrolled out of view aren't sampled at all.
+        ImGui::Dummy(size);
+        return;
+    }
+    ImVec2      const pos         = ImGui::GetCursorScreenPos();
+    ImDrawList       *draw        = ImGui::GetWindowDrawList();
+    size_t      const pixel_count = size.x > float(UI_TIMELINE_MAX_PIXELS) ? size_t(UI_TIMELINE_MAX_PIXELS) : size_t(size.x);
+    float       const scale       = size.x / float(pixel_count);
+    float       const unit        = max_depth > 0 ? size.y / float(max_depth) : 0.0f;
+    SampleStepPyramid(pyr, range_lower, range_upper, pixel_count, peak, mean);
+    draw->AddRectFilled(pos, ImVec2(pos.x + size.x, pos.y + size.y), ImColor(32, 32, 32));
+    for (size_t p = 0; p < pixel_count; ++p)
+    {
+        if (peak[p] <= 0.0f) continue;
+        float const x0 = pos.x + float(p) * scale;
+        float const x1 = pos.x + float(p + 1) * scale;
+        draw->AddRectFilled(ImVec2(x0, pos.y + size.y - peak[p] * unit), ImVec2(x1, pos.y + size.y), ImColor(200, 120, 40, 96));
+        draw->AddRectFilled(ImVec2(x0, pos.y + size.y - mean[p] * unit), ImVec2(x1, pos.y + size.y), ImColor(240, 160, 60, 224));
+    }
+    ImGui::Dummy(size);
+    if (ImGui::IsItemHovered())
+    {
+        size_t const p = size_t((ImGui::GetMousePos().x - pos.x) / scale);
+        if (p < pixel_count)
+            ImGui::SetTooltip("%.0f tasks queued at most, %.1f on average", peak[p], mean[p]);
+    }
+}
+
+/// @summary Estimate a count or total over all tasks from its value over the tasks recorded by a sampled trace.
+/// @param ev The loaded trace data.
+/// @param value The count or total over the recorded tasks.
+/// @return The estimated count or total over all tasks.
+internal_function inline uint64_t
+SampledTotal
+(
+    WIN32_PROFILER_EVENTS const *ev,
+    uint64_t                  value
+)
+{
+    return ev->TaskSampleRate > 1 ? value * ev->TaskSampleRate : value;
+}
+
+/// @summary Display the critical path report of a fully loaded trace: total work, span, maximum speedup, and the entry points that bound the span.
+/// @param ev The loaded trace data.
+internal_function void
+BuildCriticalPathReport
+(
+    WIN32_PROFILER_EVENTS const *ev
+)
+{
+    WIN32_CRITICAL_PATH const *cp = &ev->CriticalPath;
+    if (ev->TaskSampleRate > 1)
+    {   // dependencies on tasks that weren't recorded are missing, so the span is a lower bound.
+        ImGui::Text("The span covers the recorded tasks only. Task count and work are estimated.");
+    }
+    ImGui::Text("%llu tasks, %.3f ms work, %.3f ms span, %.2fx maximum speedup", (unsigned long long) SampledTotal(ev, cp->TaskCount), double(SampledTotal(ev, cp->TotalWork)) / 1000000.0, double(cp->Span) / 1000000.0, cp->MaxSpeedup);
+    ImGui::Text("%u tasks on the critical path, %u distinct entry points", unsigned(cp->PathRow.size()), unsigned(cp->EntryPointCount));
+    for (size_t i = 0; i < cp->EntryPointCount && i < UI_CRITICAL_PATH_ENTRY_POINTS; ++i)
+    {
+        double const share = cp->Span > 0 ? double(cp->EntryPointTime[i]) * 100.0 / double(cp->Span) : 0.0;
+        ImGui::BulletText("Entry point %llX: %.3f ms (%.1f%% of span)", (unsigned long long) cp->EntryPoint[i], double(cp->EntryPointTime[i]) / 1000000.0, share);
+    }
+}
+
+/// @summary Run a scheduler replay of the loaded trace and keep the result for display. The replay runs on the calling thread.
+/// @param ui The application user interface state to update.
+/// @param worker_count The number of workers to simulate.
+/// @param entry_point The entry point whose tasks are sped up.
+/// @param percent The percentage by which the execution time of those tasks is reduced, or 0 to replay the observed execution times.
+internal_function void
+RunScheduleReplay
+(
+    UI_STATE     *ui,
+    uint32_t worker_count,
+    uint64_t  entry_point,
+    uint32_t      percent
+)
+{
+    if (ui->ReplayCount == UI_REPLAY_MAX_RESULTS)
+    {   // discard the oldest result.
+        memmove(&ui->Replay[0], &ui->Replay[1], (UI_REPLAY_MAX_RESULTS - 1) * sizeof(WIN32_SCHEDULER_REPLAY));
+        ui->ReplayCount--;
+    }
+    ReplayScheduleWhatIf(&ui->Replay[ui->ReplayCount++], &ui->EventData->TaskTable, worker_count, uint32_t(ui->ReplayPolicy), uint64_t(ui->ReplayStealCost), entry_point, percent);
+}
+
+/// @summary Display the scheduler replay controls and the results of previous replays, so the predicted makespan can be compared across worker counts and policies.
+/// @param ui The application user interface state to update.
+internal_function void
+BuildScheduleReplayReport
+(
+    UI_STATE *ui
+)
+{
+    local_persist char const *policy_names[WIN32_SCHEDULER_POLICY_COUNT] = { "FIFO", "LIFO", "Work stealing" };
+    WIN32_SCHEDULER_INFO const &sched = ui->EventData->Scheduler;
+    ImGui::Text("Captured with %u compute and %u general workers", sched.ComputePoolSize, sched.GeneralPoolSize);
+    ImGui::InputInt("Workers", &ui->ReplayWorkers);
+    ImGui::Combo("Policy", &ui->ReplayPolicy, policy_names, WIN32_SCHEDULER_POLICY_COUNT);
+    ImGui::InputInt("Steal cost (ns)", &ui->ReplayStealCost, 100, 1000);
+    if (ui->ReplayWorkers   < 1) ui->ReplayWorkers   = 1;
+    if (ui->ReplayStealCost < 0) ui->ReplayStealCost = 0;
+    if (ImGui::Button("Replay"))
+    {
+        RunScheduleReplay(ui, uint32_t(ui->ReplayWorkers), 0, 0);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Sweep 1 to 4x workers"))
+    {   // powers of two up to four times the selected worker count.
+        for (uint32_t n = 1; n <= uint32_t(ui->ReplayWorkers) * 4 && n <= WIN32_SCHEDULER_REPLAY_MAX_WORKERS; n *= 2)
+            RunScheduleReplay(ui, n, 0, 0);
+    }
+    ImGui::Columns(7, "ReplayResults");
+    ImGui::Text("Workers");     ImGui::NextColumn();
+    ImGui::Text("Policy");      ImGui::NextColumn();
+    ImGui::Text("Speedup");     ImGui::NextColumn();
+    ImGui::Text("Makespan");    ImGui::NextColumn();
+    ImGui::Text("Observed");    ImGui::NextColumn();
+    ImGui::Text("Utilization"); ImGui::NextColumn();
+    ImGui::Text("Steals");      ImGui::NextColumn();
+    for (size_t i = 0; i < ui->ReplayCount; ++i)
+    {
+        WIN32_SCHEDULER_REPLAY const &r = ui->Replay[i];
+        ImGui::Text("%u", r.WorkerCount); ImGui::NextColumn();
+        ImGui::Text("%s", policy_names[r.Policy]); ImGui::NextColumn();
+        if (r.SpeedupPercent > 0) ImGui::Text("%u%% of %llX", r.SpeedupPercent, (unsigned long long) r.SpeedupEntryPoint);
+        else ImGui::Text("-");
+        ImGui::NextColumn();
+        ImGui::Text("%.3f ms", double(r.Makespan) / 1000000.0); ImGui::NextColumn();
+        ImGui::Text("%.3f ms", double(r.ObservedMakespan) / 1000000.0); ImGui::NextColumn();
+        ImGui::Text("%.1f%%", r.Utilization * 100.0); ImGui::NextColumn();
+        ImGui::Text("%llu", (unsigned long long) r.StealCount); ImGui::NextColumn();
+    }
+    ImGui::Columns(1);
+}
+
+/// @summary Display the virtual speedup controls and the most recent ranking of entry points. Ranking replays the schedule once per
+/// entry point with the worker count, policy and steal cost of the scheduler replay controls, using every processor; the user interface
+/// is unresponsive until it completes.
+/// @param ui The application user interface state to update.
+internal_function void
+BuildVirtualSpeedupReport
+(
+    UI_STATE *ui
+)
+{
+    ImGui::SliderInt("Speedup (%)", &ui->WhatIfPercent, 1, 100);
+    ImGui::InputInt("Entry points (0 = all)", &ui->WhatIfMaxEntries);
+    if (ui->WhatIfMaxEntries < 0) ui->WhatIfMaxEntries = 0;
+    if (ImGui::Button("Rank entry points"))
+    {
+        if (ui->WhatIf == NULL) ui->WhatIf = new WIN32_VIRTUAL_SPEEDUP_REPORT();
+        RankVirtualSpeedups(ui->WhatIf, &ui->EventData->TaskTable, uint32_t(ui->ReplayWorkers), uint32_t(ui->ReplayPolicy), uint64_t(ui->ReplayStealCost), uint32_t(ui->WhatIfPercent), size_t(ui->WhatIfMaxEntries), 0);
+    }
+    if (ui->WhatIf == NULL)
+        return;
+
+    WIN32_VIRTUAL_SPEEDUP_REPORT const *report = ui->WhatIf;
+    WIN32_PROFILER_EVENTS        const *ev     = ui->EventData;
+    ImGui::Text("%u workers, baseline makespan %.3f ms, each entry point %u%% faster", report->WorkerCount, double(report->BaselineMakespan) / 1000000.0, report->SpeedupPercent);
+    ImGui::Columns(6, "WhatIfResults");
+    ImGui::Text("Entry point");  ImGui::NextColumn();
+    ImGui::Text("Tasks");        ImGui::NextColumn();
+    ImGui::Text("Task time");    ImGui::NextColumn();
+    ImGui::Text("Makespan");     ImGui::NextColumn();
+    ImGui::Text("Efficiency");   ImGui::NextColumn();
+    ImGui::Text("");             ImGui::NextColumn();
+    for (size_t i = 0; i < report->EntryCount; ++i)
+    {
+        WIN32_VIRTUAL_SPEEDUP const &e = report->Entries[i];
+        ImGui::Text("%llX", (unsigned long long) e.EntryPoint); ImGui::NextColumn();
+        ImGui::Text("%llu", (unsigned long long) SampledTotal(ev, e.TaskCount)); ImGui::NextColumn();
+        ImGui::Text("%.3f ms", double(SampledTotal(ev, e.TaskTime)) / 1000000.0); ImGui::NextColumn();
+        ImGui::Text("%+.3f ms", double(e.MakespanChange) / 1000000.0); ImGui::NextColumn();
+        ImGui::Text("%.2f", e.Efficiency); ImGui::NextColumn();
+        ImGui::PushID(int(i));
+        if (ImGui::SmallButton("Replay"))
+        {   // add the what-if replay to the scheduler replay results for comparison.
+            RunScheduleReplay(ui, report->WorkerCount, e.EntryPoint, report->SpeedupPercent);
+        }
+        ImGui::PopID();
+        ImGui::NextColumn();
+    }
+    ImGui::Columns(1);
+}
+
+/// @summary Display one row of the wake latency table: the number of wakeups and the latency percentiles of a histogram, in microseconds.
+/// @param name The name of the row.
+/// @param h The histogram summarized by the row.
+internal_function void
+BuildLatencyHistogramRow
+(
+    char const                    *name,
+    WIN32_LATENCY_HISTOGRAM const *h
+)
+{
+    ImGui::Text("%s", name); ImGui::NextColumn();
+    ImGui::Text("%llu", (unsigned long long) h->Count); ImGui::NextColumn();
+    ImGui::Text("%.1f", double(LatencyHistogramPercentile(h, 50.0)) / 1000.0); ImGui::NextColumn();
+    ImGui::Text("%.1f", double(LatencyHistogramPercentile(h, 90.0)) / 1000.0); ImGui::NextColumn();
+    ImGui::Text("%.1f", double(LatencyHistogramPercentile(h, 99.0)) / 1000.0); ImGui::NextColumn();
+    ImGui::Text("%.1f", double(LatencyHistogramPercentile(h, 99.9)) / 1000.0); ImGui::NextColumn();
+    ImGui::Text("%.1f", double(h->Max) / 1000.0); ImGui::NextColumn();
+}
+
+/// @summary Display the wake latency report: latency percentiles for the whole trace, for each thread pool and for the worst threads,
+/// and the slowest wakeups. Changing the threshold rebuilds the analysis on the calling thread.
+/// @param ui The application user interface state to update.
+internal_function void
+BuildWakeLatencyReport
+(
+    UI_STATE *ui
+)
+{
+    WIN32_PROFILER_EVENTS    *ev = ui->EventData;
+    WIN32_WAKE_LATENCY const &wl = ev->WakeLatency;
+    char                    name[64];
+    ImGui::InputInt("Slow threshold (us)", &ui->WakeThresholdUs, 10, 1000);
+    if (ui->WakeThresholdUs < 0) ui->WakeThresholdUs = 0;
+    if (uint64_t(ui->WakeThresholdUs) * 1000 != wl.Threshold && ImGui::Button("Apply"))
+    {
+        BuildWakeLatency(&ev->WakeLatency, &ev->ProcessList, &ev->Scheduler, uint64_t(ui->WakeThresholdUs) * 1000);
+    }
+    ImGui::Columns(7, "WakeLatency");
+    ImGui::Text("Threads");     ImGui::NextColumn();
+    ImGui::Text("Wakeups");     ImGui::NextColumn();
+    ImGui::Text("p50 (us)");    ImGui::NextColumn();
+    ImGui::Text("p90 (us)");    ImGui::NextColumn();
+    ImGui::Text("p99 (us)");    ImGui::NextColumn();
+    ImGui::Text("p99.9 (us)");  ImGui::NextColumn();
+    ImGui::Text("Max (us)");    ImGui::NextColumn();
+    BuildLatencyHistogramRow("All", &wl.All);
+    for (size_t i = 0; i < wl.PoolCount; ++i)
+    {
+        if (wl.PoolId[i] != WIN32_WAKE_LATENCY_NO_POOL) sprintf_s(name, "Pool %u", wl.PoolId[i]);
+        else sprintf_s(name, "Other threads");
+        BuildLatencyHistogramRow(name, &wl.PoolHistogram[i]);
+    }
+    for (size_t i = 0; i < wl.ThreadCount && i < UI_WAKE_LATENCY_THREADS; ++i)
+    {
+        WIN32_PROCESS_INFO const &proc = ev->ProcessList.ProcessInfo[wl.ThreadProcess[i]];
+        sprintf_s(name, "Process %u, thread %u", proc.ProcessId, proc.ThreadId[wl.ThreadIndex[i]]);
+        BuildLatencyHistogramRow(name, &wl.ThreadHistogram[i]);
+    }
+    ImGui::Columns(1);
+    ImGui::Text("%llu wakeups slower than %.1f us", (unsigned long long) wl.SlowCount, double(wl.Threshold) / 1000.0);
+    for (size_t i = 0; i < wl.SlowCount && i < UI_WAKE_LATENCY_SLOW_LIST; ++i)
+    {
+        WIN32_PROCESS_INFO const &proc = ev->ProcessList.ProcessInfo[wl.SlowProcess[i]];
+        ImGui::BulletText("%.1f us at %.3f ms, process %u, thread %u", double(wl.SlowLatency[i]) / 1000.0, double(wl.SlowReadyTime[i] - ev->TimelineLod.FirstTime) / 1000000.0, proc.ProcessId, proc.ThreadId[wl.SlowThread[i]]);
+    }
+}
+
+/// @summary Display the off-CPU report: blocked time by wait reason for the whole trace, and for the threads and task entry points that blocked the most.
+/// @param ev The loaded trace data.
+internal_function void
+BuildOffCpuReportView
+(
+    WIN32_PROFILER_EVENTS const *ev
+)
+{
+    WIN32_OFF_CPU_REPORT const &oc = ev->OffCpu;
+    ImGui::Text("%llu blocked intervals, %.3f ms blocked in %u threads", (unsigned long long) oc.All.Count, double(oc.All.Total) / 1000000.0, unsigned(oc.ThreadCount));
+    ImGui::Columns(6, "OffCpuReasons");
+    ImGui::Text("Wait reason");    ImGui::NextColumn();
+    ImGui::Text("Waits");          ImGui::NextColumn();
+    ImGui::Text("Blocked (ms)");   ImGui::NextColumn();
+    ImGui::Text("User mode");      ImGui::NextColumn();
+    ImGui::Text("p50 (us)");       ImGui::NextColumn();
+    ImGui::Text("p99 (us)");       ImGui::NextColumn();
+    for (size_t r = 0; r < oc.ReasonHistogram.size(); ++r)
+    {
+        WIN32_LATENCY_HISTOGRAM const &h = oc.ReasonHistogram[r];
+        if (h.Count == 0)
+            continue;
+        ImGui::Text("%s", WaitReasonName(int(r))); ImGui::NextColumn();
+        ImGui::Text("%llu", (unsigned long long) h.Count); ImGui::NextColumn();
+        ImGui::Text("%.3f", double(h.Total) / 1000000.0); ImGui::NextColumn();
+        ImGui::Text("%.0f%%", double(oc.ReasonUserTime[r]) * 100.0 / double(h.Total)); ImGui::NextColumn();
+        ImGui::Text("%.1f", double(LatencyHistogramPercentile(&h, 50.0)) / 1000.0); ImGui::NextColumn();
+        ImGui::Text("%.1f", double(LatencyHistogramPercentile(&h, 99.0)) / 1000.0); ImGui::NextColumn();
+    }
+    ImGui::Columns(4, "OffCpuThreads");
+    ImGui::Text("Thread");         ImGui::NextColumn();
+    ImGui::Text("Blocked (ms)");   ImGui::NextColumn();
+    ImGui::Text("p99 (us)");       ImGui::NextColumn();
+    ImGui::Text("Top reason");     ImGui::NextColumn();
+    for (size_t i = 0; i < oc.ThreadCount && i < UI_OFF_CPU_ROWS; ++i)
+    {
+        WIN32_PROCESS_INFO const &proc = ev->ProcessList.ProcessInfo[oc.ThreadProcess[i]];
+        uint64_t const           *time = &oc.ThreadReasonTime[i * WIN32_WAIT_REASON_COUNT];
+        size_t   const            top  = OffCpuTopReason(time);
+        ImGui::Text("Process %u, thread %u", proc.ProcessId, proc.ThreadId[oc.ThreadIndex[i]]); ImGui::NextColumn();
+        ImGui::Text("%.3f", double(oc.ThreadHistogram[i].Total) / 1000000.0); ImGui::NextColumn();
+        ImGui::Text("%.1f", double(LatencyHistogramPercentile(&oc.ThreadHistogram[i], 99.0)) / 1000.0); ImGui::NextColumn();
+        ImGui::Text("%s (%.0f%%)", WaitReasonName(int(top)), double(time[top]) * 100.0 / double(oc.ThreadHistogram[i].Total)); ImGui::NextColumn();
+    }
+    ImGui::Columns(3, "OffCpuEntryPoints");
+    ImGui::Text("Entry point");    ImGui::NextColumn();
+    ImGui::Text("Blocked (ms)");   ImGui::NextColumn();
+    ImGui::Text("Top reason");     ImGui::NextColumn();
+    for (size_t i = 0; i < oc.EntryPointCount && i < UI_OFF_CPU_ROWS; ++i)
+    {
+        uint64_t const *time = &oc.EntryPointReasonTime[i * WIN32_WAIT_REASON_COUNT];
+        size_t   const  top  = OffCpuTopReason(time);
+        ImGui::Text("%llX", (unsigned long long) oc.EntryPoint[i]); ImGui::NextColumn();
+        ImGui::Text("%.3f", double(SampledTotal(ev, oc.EntryPointTime[i])) / 1000000.0); ImGui::NextColumn();
+        ImGui::Text("%s (%.0f%%)", WaitReasonName(int(top)), double(time[top]) * 100.0 / double(oc.EntryPointTime[i])); ImGui::NextColumn();
+    }
+    ImGui::Columns(1);
+}
+
+/// @summary Display the zone report: the time spent at each PROFILER_ZONE site, longest first, and how many zones fell inside tasks.
+/// @param ev The loaded trace data.
+internal_function void
+BuildZoneReport
+(
+    WIN32_PROFILER_EVENTS const *ev
+)
+{
+    WIN32_ZONE_TREE       const &zt    = ev->ZoneTree;
+    WIN32_ZONE_EVENT_LIST const &zones = ev->ZoneEvents;
+    std::vector<std::pair<uint64_t, size_t> > order;
+    size_t in_task = 0;
+    for (size_t i = 0; i < zt.ZoneCount; ++i)
+    {
+        if (zt.TaskRow[i] != WIN32_OBJECT_INDEX_EMPTY) in_task++;
+    }
+    for (size_t s = 0; s < zt.SiteZoneCount.size(); ++s)
+    {
+        if (zt.SiteZoneCount[s] > 0) order.push_back(std::make_pair(zt.SiteInclusiveTime[s], s));
+    }
+    std::sort(order.begin(), order.end(), OffCpuTimeBefore);
+    ImGui::Text("%llu zones at %u sites, %llu inside tasks, %llu unmatched", (unsigned long long) zt.ZoneCount, unsigned(order.size()), (unsigned long long) in_task, (unsigned long long) zt.UnmatchedCount);
+    ImGui::Columns(6, "Zones");
+    ImGui::Text("Zone");           ImGui::NextColumn();
+    ImGui::Text("Location");       ImGui::NextColumn();
+    ImGui::Text("Count");          ImGui::NextColumn();
+    ImGui::Text("Inclusive (ms)"); ImGui::NextColumn();
+    ImGui::Text("Self (ms)");      ImGui::NextColumn();
+    ImGui::Text("Mean (us)");      ImGui::NextColumn();
+    for (size_t i = 0; i < order.size() && i < UI_ZONE_ROWS; ++i)
+    {
+        size_t const s = order[i].second;
+        bool   const known = s < zones.SiteCount && !zones.SiteName[s].empty();
+        if (known) ImGui::Text("%s", zones.SiteName[s].c_str());
+        else ImGui::Text("Site %u", unsigned(s));
+        ImGui::NextColumn();
+        if (known) ImGui::Text("%s:%u (%s)", zones.SiteFile[s].c_str(), zones.SiteLine[s], zones.SiteFunction[s].c_str());
+        else ImGui::Text("-");
+        ImGui::NextColumn();
+        ImGui::Text("%llu", (unsigned long long) zt.SiteZoneCount[s]); ImGui::NextColumn();
+        ImGui::Text("%.3f", double(zt.SiteInclusiveTime[s]) / 1000000.0); ImGui::NextColumn();
+        ImGui::Text("%.3f", double(zt.SiteSelfTime[s]) / 1000000.0); ImGui::NextColumn();
+        ImGui::Text("%.2f", double(zt.SiteInclusiveTime[s]) / (double(zt.SiteZoneCount[s]) * 1000.0)); ImGui::NextColumn();
+    }
+    ImGui::Columns(1);
+}
+
+/// @summary Display the ratio of two task counters in the current column, or a dash if either counter was not recorded.
+/// @param values WIN32_TASK_COUNTER_COUNT counter values, indexed by WIN32_TASK_COUNTER.
+/// @param mask The counters present in values.
+/// @param numerator The counter to divide, one of WIN32_TASK_COUNTER.
+/// @param denominator The counter to divide by, one of WIN32_TASK_COUNTER.
+/// @param scale The value the ratio is multiplied by.
+internal_function void
+TaskCounterRatioColumn
+(
+    uint64_t const *values,
+    uint32_t          mask,
+    uint32_t     numerator,
+    uint32_t   denominator,
+    double           scale
+)
+{
+    double ratio = 0.0;
+    if (TaskCounterRatio(values, mask, numerator, denominator, scale, ratio)) ImGui::Text("%.2f", ratio);
+    else ImGui::Text("-");
+    ImGui::NextColumn();
+}
+
+/// @summary Display the task counter report: instructions per cycle and miss rates for each entry point, and for the slowest tasks with
+/// counters, so that a slow task can be classified as compute-bound or memory-bound.
+/// @param ev The loaded trace data.
+internal_function void
+BuildTaskCounterReportView
+(
+    WIN32_PROFILER_EVENTS const *ev
+)
+{
+    WIN32_TASK_COUNTER_REPORT const &cr = ev->CounterReport;
+    WIN32_TASK_TABLE          const &tt = ev->TaskTable;
+    std::vector<std::pair<uint64_t, size_t> > slow;
+    for (size_t r = 0; r < tt.TaskCount; ++r)
+    {
+        if (cr.TaskCounterMask[r] != 0) slow.push_back(std::make_pair(tt.FinishTime[r] - tt.LaunchTime[r], r));
+    }
+    std::sort(slow.begin(), slow.end(), OffCpuTimeBefore);
+    ImGui::Text("%llu tasks with counters at %llu entry points, %llu samples unmatched", (unsigned long long) cr.TaskCount, (unsigned long long) cr.EntryPointCount, (unsigned long long) cr.UnmatchedCount);
+    ImGui::Columns(7, "CounterEntryPoints");
+    ImGui::Text("Entry point");  ImGui::NextColumn();
+    ImGui::Text("Tasks");        ImGui::NextColumn();
+    ImGui::Text("Cycles (M)");   ImGui::NextColumn();
+    ImGui::Text("IPC");          ImGui::NextColumn();
+    ImGui::Text("L1D MPKI");     ImGui::NextColumn();
+    ImGui::Text("LLC MPKI");     ImGui::NextColumn();
+    ImGui::Text("Branch MPKI");  ImGui::NextColumn();
+    for (size_t i = 0; i < cr.EntryPointCount && i < UI_COUNTER_ROWS; ++i)
+    {
+        uint64_t const *value = &cr.EntryPointValue[i * WIN32_TASK_COUNTER_COUNT];
+        uint32_t const  mask  = cr.EntryPointMask[i];
+        ImGui::Text("%llX", (unsigned long long) cr.EntryPoint[i]); ImGui::NextColumn();
+        ImGui::Text("%llu", (unsigned long long) cr.EntryPointTasks[i]); ImGui::NextColumn();
+        if (mask & (1U << WIN32_TASK_COUNTER_CYCLES)) ImGui::Text("%.3f", double(value[WIN32_TASK_COUNTER_CYCLES]) / 1000000.0);
+        else ImGui::Text("-");
+        ImGui::NextColumn();
+        TaskCounterRatioColumn(value, mask, WIN32_TASK_COUNTER_INSTRUCTIONS , WIN32_TASK_COUNTER_CYCLES      , 1.0);
+        TaskCounterRatioColumn(value, mask, WIN32_TASK_COUNTER_L1D_MISSES   , WIN32_TASK_COUNTER_INSTRUCTIONS, 1000.0);
+        TaskCounterRatioColumn(value, mask, WIN32_TASK_COUNTER_LLC_MISSES   , WIN32_TASK_COUNTER_INSTRUCTIONS, 1000.0);
+        TaskCounterRatioColumn(value, mask, WIN32_TASK_COUNTER_BRANCH_MISSES, WIN32_TASK_COUNTER_INSTRUCTIONS, 1000.0);
+    }
+    ImGui::Columns(1);
+    ImGui::Separator();
+    ImGui::Text("Slowest tasks");
+    ImGui::Columns(6, "CounterTasks");
+    ImGui::Text("Task");          ImGui::NextColumn();
+    ImGui::Text("Entry point");   ImGui::NextColumn();
+    ImGui::Text("Duration (us)"); ImGui::NextColumn();
+    ImGui::Text("IPC");           ImGui::NextColumn();
+    ImGui::Text("LLC MPKI");      ImGui::NextColumn();
+    ImGui::Text("Bound");         ImGui::NextColumn();
+    for (size_t i = 0; i < slow.size() && i < UI_COUNTER_ROWS; ++i)
+    {
+        size_t   const  r     = slow[i].second;
+        uint64_t const *value = &cr.TaskValue[r * WIN32_TASK_COUNTER_COUNT];
+        uint32_t const  mask  = cr.TaskCounterMask[r];
+        double          ipc   = 0.0;
+        double          mpki  = 0.0;
+        bool     const  has_ipc  = TaskCounterRatio(value, mask, WIN32_TASK_COUNTER_INSTRUCTIONS, WIN32_TASK_COUNTER_CYCLES, 1.0, ipc);
+        bool     const  has_mpki = TaskCounterRatio(value, mask, WIN32_TASK_COUNTER_LLC_MISSES, WIN32_TASK_COUNTER_INSTRUCTIONS, 1000.0, mpki);
+        ImGui::Text("%08X", tt.TaskId[r]); ImGui::NextColumn();
+        ImGui::Text("%llX", (unsigned long long) tt.EntryPoint[r]); ImGui::NextColumn();
+        ImGui::Text("%.1f", double(slow[i].first) / 1000.0); ImGui::NextColumn();
+        if (has_ipc) ImGui::Text("%.2f", ipc);
+        else ImGui::Text("-");
+        ImGui::NextColumn();
+        if (has_mpki) ImGui::Text("%.2f", mpki);
+        else ImGui::Text("-");
+        ImGui::NextColumn();
+        // a low IPC with frequent last-level cache misses means the task waits on memory; a high IPC means it is limited by execution.
+        if (has_ipc && has_mpki && ipc < 1.0 && mpki >= 1.0) ImGui::Text("Memory");
+        else if (has_ipc && ipc >= 1.0) ImGui::Text("Compute");
+        else ImGui::Text("-");
+        ImGui::NextColumn();
+    }
+    ImGui::Columns(1);
+}
+
+/// @summary Display the allocation report: the heap allocations made by the tasks at each entry point, and the tasks that made the most
+/// allocations, so that allocation churn inside hot tasks can be found.
+/// @param ev The loaded trace data.
+internal_function void
+BuildTaskAllocReportView
+(
+    WIN32_PROFILER_EVENTS const *ev
+)
+{
+    WIN32_TASK_ALLOC_REPORT const &ar = ev->AllocReport;
+    WIN32_TASK_TABLE        const &tt = ev->TaskTable;
+    std::vector<std::pair<uint64_t, size_t> > top;
+    for (size_t r = 0; r < tt.TaskCount; ++r)
+    {
+        if (tt.AllocCount[r] != 0) top.push_back(std::make_pair(tt.AllocCount[r], r));
+    }
+    size_t const top_count = top.size() < UI_ALLOC_ROWS ? top.size() : UI_ALLOC_ROWS;
+    std::partial_sort(top.begin(), top.begin() + top_count, top.end(), OffCpuTimeBefore);
+    ImGui::Text("%llu allocations (%.3f MB allocated, %.3f MB freed) by %llu tasks at %llu entry points", (unsigned long long) SampledTotal(ev, ar.AllocCount), double(SampledTotal(ev, ar.AllocBytes)) / (1024.0 * 1024.0), double(SampledTotal(ev, ar.FreeBytes)) / (1024.0 * 1024.0), (unsigned long long) ar.TaskCount, (unsigned long long) ar.EntryPointCount);
+    ImGui::Columns(7, "AllocEntryPoints");
+    ImGui::Text("Entry point");   ImGui::NextColumn();
+    ImGui::Text("Tasks");         ImGui::NextColumn();
+    ImGui::Text("Allocations");   ImGui::NextColumn();
+    ImGui::Text("Size (MB)");     ImGui::NextColumn();
+    ImGui::Text("Freed (MB)");    ImGui::NextColumn();
+    ImGui::Text("Allocs/task");   ImGui::NextColumn();
+    ImGui::Text("Bytes/alloc");   ImGui::NextColumn();
+    for (size_t i = 0; i < ar.EntryPointCount && i < UI_ALLOC_ROWS; ++i)
+    {
+        ImGui::Text("%llX", (unsigned long long) ar.EntryPoint[i]); ImGui::NextColumn();
+        ImGui::Text("%llu", (unsigned long long) ar.EntryPointTasks[i]); ImGui::NextColumn();
+        ImGui::Text("%llu", (unsigned long long) ar.EntryPointAllocs[i]); ImGui::NextColumn();
+        ImGui::Text("%.3f", double(ar.EntryPointBytes[i]) / (1024.0 * 1024.0)); ImGui::NextColumn();
+        ImGui::Text("%.3f", double(ar.EntryPointFreeBytes[i]) / (1024.0 * 1024.0)); ImGui::NextColumn();
+        ImGui::Text("%.1f", double(ar.EntryPointAllocs[i]) / double(ar.EntryPointTasks[i])); ImGui::NextColumn();
+        ImGui::Text("%.0f", ar.EntryPointAllocs[i] != 0 ? double(ar.EntryPointBytes[i]) / double(ar.EntryPointAllocs[i]) : 0.0); ImGui::NextColumn();
+    }
+    ImGui::Columns(1);
+    ImGui::Separator();
+    ImGui::Text("Tasks with the most allocations");
+    ImGui::Columns(6, "AllocTasks");
+    ImGui::Text("Task");          ImGui::NextColumn();
+    ImGui::Text("Entry point");   ImGui::NextColumn();
+    ImGui::Text("Duration (us)"); ImGui::NextColumn();
+    ImGui::Text("Allocations");   ImGui::NextColumn();
+    ImGui::Text("Size (KB)");     ImGui::NextColumn();
+    ImGui::Text("Freed (KB)");    ImGui::NextColumn();
+    for (size_t i = 0; i < top_count; ++i)
+    {
+        size_t const r = top[i].second;
+        ImGui::Text("%08X", tt.TaskId[r]); ImGui::NextColumn();
+        ImGui::Text("%llX", (unsigned long long) tt.EntryPoint[r]); ImGui::NextColumn();
+        ImGui::Text("%.1f", double(tt.FinishTime[r] - tt.LaunchTime[r]) / 1000.0); ImGui::NextColumn();
+        ImGui::Text("%llu", (unsigned long long) tt.AllocCount[r]); ImGui::NextColumn();
+        ImGui::Text("%.1f", double(tt.AllocBytes[r]) / 1024.0); ImGui::NextColumn();
+        ImGui::Text("%.1f", double(tt.FreeBytes[r]) / 1024.0); ImGui::NextColumn();
+    }
+    ImGui::Columns(1);
+}
+
+/// @summary Format the name of a queue depth series for display.
+/// @param ev The loaded trace data.
+/// @param series The index of the series in WIN32_QUEUE_DEPTH.
+/// @param name The buffer receiving the name.
+/// @param name_size The size of the buffer, in bytes.
+internal_function void
+QueueSeriesName
+(
+    WIN32_PROFILER_EVENTS const *ev,
+    size_t                   series,
+    char                      *name,
+    size_t                 name_size
+)
+{
+    WIN32_QUEUE_DEPTH    const &qd    = ev->QueueDepth;
+    WIN32_SCHEDULER_INFO const &sched = ev->Scheduler;
+    uint32_t             const  key   = qd.SeriesKey[series];
+    switch (qd.SeriesKind[series])
+    {
+        case WIN32_QUEUE_SERIES_TOTAL:
+            {
+                sprintf_s(name, name_size, "All tasks");
+            } return;
+        case WIN32_QUEUE_SERIES_SOURCE:
+            {
+                for (size_t i = 0; i < sched.SourceCount; ++i)
+                {
+                    if (sched.SourceIndex[i] == key && !sched.SourceName[i].empty())
+                    {
+                        sprintf_s(name, name_size, "Source %u (%s)", key, sched.SourceName[i].c_str());
+                        return;
+                    }
+                }
+                sprintf_s(name, name_size, "Source %u", key);
+            } return;
+        default:
+            {
+                if (key != WIN32_QUEUE_DEPTH_NO_POOL) sprintf_s(name, name_size, "Pool %u", key);
+                else sprintf_s(name, name_size, "No pool");
+            } return;
+    }
+}
+
+/// @summary Display the ready backlog report: for each series, the peak backlog and when it occurred, the backlog at the end of
+/// the time window being browsed, and the distribution of the time tasks spent queued between becoming ready and being launched.
+/// @param ev The loaded trace data.
+/// @param range_upper The end of the time window being browsed, in nanoseconds.
+internal_function void
+BuildQueueDepthReport
+(
+    WIN32_PROFILER_EVENTS const *ev,
+    uint64_t             range_upper
+)
+{
+    WIN32_QUEUE_DEPTH const &qd = ev->QueueDepth;
+    char                   name[64];
+    ImGui::Text("%llu tasks became ready, %llu never launched", (unsigned long long) SampledTotal(ev, qd.TaskCount), (unsigned long long) SampledTotal(ev, qd.PendingCount));
+    ImGui::Columns(7, "QueueDepth");
+    ImGui::Text("Series");        ImGui::NextColumn();
+    ImGui::Text("Peak");          ImGui::NextColumn();
+    ImGui::Text("Peak at (ms)");  ImGui::NextColumn();
+    ImGui::Text("At window end"); ImGui::NextColumn();
+    ImGui::Text("Delay p50 (us)"); ImGui::NextColumn();
+    ImGui::Text("Delay p99 (us)"); ImGui::NextColumn();
+    ImGui::Text("Delay max (us)"); ImGui::NextColumn();
+    for (size_t i = 0; i < qd.SeriesCount; ++i)
+    {
+        QueueSeriesName(ev, i, name, sizeof(name));
+        ImGui::Text("%s", name); ImGui::NextColumn();
+        ImGui::Text("%u", qd.SeriesMaxDepth[i]); ImGui::NextColumn();
+        ImGui::Text("%.3f", qd.SeriesMaxTime[i] > ev->TimelineLod.FirstTime ? double(qd.SeriesMaxTime[i] - ev->TimelineLod.FirstTime) / 1000000.0 : 0.0); ImGui::NextColumn();
+        ImGui::Text("%u", QueueDepthAtTime(&qd, i, range_upper)); ImGui::NextColumn();
+        ImGui::Text("%.1f", double(LatencyHistogramPercentile(&qd.SeriesDelay[i], 50.0)) / 1000.0); ImGui::NextColumn();
+        ImGui::Text("%.1f", double(LatencyHistogramPercentile(&qd.SeriesDelay[i], 99.0)) / 1000.0); ImGui::NextColumn();
+        ImGui::Text("%.1f", double(qd.SeriesDelay[i].Max) / 1000.0); ImGui::NextColumn();
+    }
+    ImGui::Columns(1);
+}
+
+/// @summary Display the parallelism report: for each pool, the number of tasks executing over the time window being browsed,
+/// and how much of the trace the pool spent with every worker busy. Average parallelism well below the worker count means
+/// the pool was starved of work, rather than short of workers.
+/// @param ev The loaded trace data.
+/// @param range_lower The start of the time window being browsed, in nanoseconds.
+/// @param range_upper The end of the time window being browsed, in nanoseconds.
+internal_function void
+BuildParallelismReport
+(
+    WIN32_PROFILER_EVENTS const *ev,
+    uint64_t             range_lower,
+    uint64_t             range_upper
+)
+{
+    WIN32_PARALLELISM_PROFILE const &profile = ev->Parallelism;
+    uint64_t                  const  span    = profile.EndTime - profile.FirstTime;
+    ImGui::Text("Compute pool size %u, general pool size %u", ev->Scheduler.ComputePoolSize, ev->Scheduler.GeneralPoolSize);
+    ImGui::Columns(7, "Parallelism");
+    ImGui::Text("Pool");              ImGui::NextColumn();
+    ImGui::Text("Workers");           ImGui::NextColumn();
+    ImGui::Text("Avg running");       ImGui::NextColumn();
+    ImGui::Text("Min");               ImGui::NextColumn();
+    ImGui::Text("Max");               ImGui::NextColumn();
+    ImGui::Text("Saturated (ms)");    ImGui::NextColumn();
+    ImGui::Text("Below (ms)");        ImGui::NextColumn();
+    for (size_t i = 0; i < profile.PoolCount; ++i)
+    {
+        WIN32_STEP_RANGE range;
+        StepFunctionRange(&profile.PoolRunning[i], range_lower, range_upper, &range);
+        if (profile.PoolId[i] != WIN32_QUEUE_DEPTH_NO_POOL) ImGui::Text("Pool %u", profile.PoolId[i]);
+        else ImGui::Text("No pool");
+        ImGui::NextColumn();
+        ImGui::Text("%u", profile.PoolWorkerCount[i]); ImGui::NextColumn();
+        ImGui::Text("%.2f", range.Mean * double(ev->TaskSampleRate > 1 ? ev->TaskSampleRate : 1)); ImGui::NextColumn();
+        ImGui::Text("%u", range.Min); ImGui::NextColumn();
+        ImGui::Text("%u", range.Max); ImGui::NextColumn();
+        ImGui::Text("%.3f", double(profile.PoolSaturatedTime[i]) / 1000000.0); ImGui::NextColumn();
+        ImGui::Text("%.3f", profile.PoolWorkerCount[i] > 0 ? double(span - profile.PoolSaturatedTime[i]) / 1000000.0 : 0.0); ImGui::NextColumn();
+    }
+    ImGui::Columns(1);
+}
+
+/// @summary Display what every logical processor was running at a chosen time, and how many threads were ready but not running.
+/// Ready threads while every core is busy indicate oversubscription; idle cores while threads are ready indicate affinity or pool limits.
+/// @param ui The application user interface state to update.
+/// @param range_lower The start of the time window being browsed, in nanoseconds.
+/// @param range_upper The end of the time window being browsed, in nanoseconds.
+internal_function void
+BuildCoreOccupancyReport
+(
+    UI_STATE        *ui,
+    uint64_t range_lower,
+    uint64_t range_upper
+)
+{
+    WIN32_PROFILER_EVENTS const *ev  = ui->EventData;
+    WIN32_CPU_TIMELINE    const &cpu = ev->CpuTimeline;
+    std::vector<uint32_t>    segment(cpu.ProcessorCount);
+    size_t                   index = 0;
+    size_t                   ready = 0;
+    ImGui::SliderFloat("Time", &ui->CoreQueryTime, 0.0f, 1.0f, "%.4f");
+    uint64_t const t    = range_lower + uint64_t(double(range_upper - range_lower) * ui->CoreQueryTime);
+    size_t   const busy = cpu.ProcessorCount > 0 ? FindCpuSegmentsAtTime(&cpu, t, &segment[0]) : 0;
+    for (size_t i = 0; i < ev->ProcessList.ProcessCount; ++i)
+    {
+        WIN32_PROCESS_INFO const &proc = ev->ProcessList.ProcessInfo[i];
+        for (size_t j = 0; j < proc.ThreadCount; ++j)
+        {
+            WIN32_THREAD_INTERVALS const &intervals = proc.ThreadInfo[j].Intervals;
+            if (FindThreadInterval(&intervals, t, index) && intervals.State[index] == WIN32_THREAD_STATE_READY)
+                ready++;
+        }
+    }
+    ImGui::Text("At %.3f ms: %u of %u cores running, %u threads ready", double(t - ev->TimelineLod.FirstTime) / 1000000.0, unsigned(busy), unsigned(cpu.ProcessorCount), unsigned(ready));
+    ImGui::Columns(4, "CoreOccupancy");
+    ImGui::Text("Core");    ImGui::NextColumn();
+    ImGui::Text("Process"); ImGui::NextColumn();
+    ImGui::Text("Thread");  ImGui::NextColumn();
+    ImGui::Text("Task");    ImGui::NextColumn();
+    for (size_t p = 0; p < cpu.ProcessorCount; ++p)
+    {
+        uint32_t const i = segment[p];
+        ImGui::Text("%u", unsigned(p)); ImGui::NextColumn();
+        if (i == WIN32_OBJECT_INDEX_EMPTY)
+        {
+            ImGui::Text("idle"); ImGui::NextColumn();
+            ImGui::Text("-");    ImGui::NextColumn();
+            ImGui::Text("-");    ImGui::NextColumn();
+            continue;
+        }
+        ImGui::Text("%u", ev->ProcessList.ProcessInfo[cpu.ProcessIndex[i]].ProcessId); ImGui::NextColumn();
+        ImGui::Text("%u", cpu.ThreadId[i]); ImGui::NextColumn();
+        if (cpu.TaskRow[i] != WIN32_OBJECT_INDEX_EMPTY) ImGui::Text("%08X (entry point %llX)", ev->TaskTable.TaskId[cpu.TaskRow[i]], (unsigned long long) ev->TaskTable.EntryPoint[cpu.TaskRow[i]]);
+        else ImGui::Text("-");
+        ImGui::NextColumn();
+    }
+    ImGui::Columns(1);
+}
+
+/// @summary Display the critical path report and the timeline of a fully loaded trace, with a row for the critical path and one row per queue depth series, per core, per worker and per thread.
+/// @param ui The application user interface state to update.
+internal_function void
+BuildTraceLoadedView
+(
+    UI_STATE *ui
+)
+{
+    WIN32_PROFILER_EVENTS const *ev  = ui->EventData;
+    WIN32_TIMELINE_LOD    const &lod = ev->TimelineLod;
+    uint64_t              const span = lod.LastTime - lod.FirstTime;
+    if (ui->ReplayWorkers <= 0)
+    {   // replays default to the size of the pools the trace was captured with.
+        ui->ReplayWorkers = int(ev->Scheduler.ComputePoolSize + ev->Scheduler.GeneralPoolSize);
+        if (ui->ReplayWorkers <= 0) ui->ReplayWorkers = int(lod.WorkerCount > 0 ? lod.WorkerCount : 1);
+    }
+    ImGui::DragFloatRange2("Time window", &ui->QueryStart, &ui->QueryEnd, 0.0001f, 0.0f, 1.0f, "Start: %.4f", "End: %.4f");
+    uint64_t const t0 = lod.FirstTime + uint64_t(double(span) * ui->QueryStart);
+    uint64_t const t1 = lod.FirstTime + uint64_t(double(span) * ui->QueryEnd);
+    ImGui::Text("%u workers, %u threads, [%.3f ms, %.3f ms]", unsigned(lod.WorkerCount), unsigned(lod.ThreadCount), double(t0 - lod.FirstTime) / 1000000.0, double(t1 - lod.FirstTime) / 1000000.0);
+    if (ev->TaskSampleRate > 1)
+    {   // counts, totals and averages over tasks scale with the sampling rate. peaks and per-task distributions don't.
+        ImGui::Text("Recorded 1 in %u tasks. Task counts, totals and averages are scaled; peaks, latencies and the timeline show recorded tasks only.", ev->TaskSampleRate);
+    }
+    if (ImGui::CollapsingHeader("Critical path"))
+    {
+        BuildCriticalPathReport(ev);
+    }
+    if (ImGui::CollapsingHeader("Scheduler replay"))
+    {
+        BuildScheduleReplayReport(ui);
+    }
+    if (ImGui::CollapsingHeader("Virtual speedup"))
+    {
+        BuildVirtualSpeedupReport(ui);
+    }
+    if (ImGui::CollapsingHeader("Wake latency"))
+    {
+        BuildWakeLatencyReport(ui);
+    }
+    if (ImGui::CollapsingHeader("Off-CPU"))
+    {
+        BuildOffCpuReportView(ev);
+    }
+    if (ev->ZoneTree.ZoneCount > 0 && ImGui::CollapsingHeader("Zones"))
+    {
+        BuildZoneReport(ev);
+    }
+    if (ev->CounterReport.TaskCount > 0 && ImGui::CollapsingHeader("Task counters"))
+    {
+        BuildTaskCounterReportView(ev);
+    }
+    if (ev->AllocReport.TaskCount > 0 && ImGui::CollapsingHeader("Allocations"))
+    {
+        BuildTaskAllocReportView(ev);
+    }
+    if (t1 <= t0)
+        return;
+    if (ImGui::CollapsingHeader("Queue depth"))
+    {
+        BuildQueueDepthReport(ev, t1);
+    }
+    if (ImGui::CollapsingHeader("Parallelism"))
+    {
+        BuildParallelismReport(ev, t0, t1);
+    }
+    if (ImGui::CollapsingHeader("Cores"))
+    {
+        BuildCoreOccupancyReport(ui, t0, t1);
+    }
+    if (ImGui::BeginChild("Timeline"))
+    {
+        if (!ev->CriticalPath.PathRow.empty())
+        {   // the tasks bounding the span, drawn where they actually executed.
+            ImGui::Text("Critical path");
+            BuildTimelineRow(ev, &ev->CriticalPath.PathLod, t0, t1);
+        }
+        for (size_t i = 0; i < ev->QueueDepth.SeriesCount; ++i)
+        {   // backlog lanes first, since queue build-up explains idle workers below.
+            char name[64];
+            QueueSeriesName(ev, i, name, sizeof(name));
+            ImGui::Text("Queue: %s (peak %u)", name, ev->QueueDepth.SeriesMaxDepth[i]);
+            BuildQueueDepthRow(&ev->QueueDepth.SeriesLod[i], ev->QueueDepth.SeriesMaxDepth[i], t0, t1);
+        }
+        for (size_t i = 0; i < ev->CpuTimeline.ProcessorCount; ++i)
+        {   // one lane per core, colored by the task its thread was executing.
+            ImGui::Text("Core %u", unsigned(i));
+            BuildTimelineRow(ev, &ev->CpuTimeline.ProcessorLod[i], t0, t1);
+        }
+        for (size_t i = 0; i < lod.WorkerCount; ++i)
+        {
+            ImGui::Text("Worker %u", lod.WorkerThreadId[i]);
+            BuildTimelineRow(ev, &lod.WorkerLod[i], t0, t1);
+        }
+        for (size_t i = 0; i < lod.ThreadCount; ++i)
+        {
+            WIN32_PROCESS_INFO const &proc = ev->ProcessList.ProcessInfo[lod.ThreadProcess[i]];
+            ImGui::Text("Process %u, thread %u", proc.ProcessId, proc.ThreadId[lod.ThreadIndex[i]]);
+            BuildTimelineRow(ev, &lod.ThreadLod[i], t0, t1);
+        }
+    }
+    ImGui::EndChild();
+}
+
 /// @summary Construct and implement the logic for the primary application user interface.
 /// @param ui The application user interface state to update.
 internal_function void
@@ -488,8 +1538,8 @@ BuildImgui
         switch (ui->TopLevelState)
         {
             case UI_STATE_ID_NO_TRACE_LOADED:  break;
-            case UI_STATE_ID_TRACE_LOADING:    break;
-            case UI_STATE_ID_TRACE_LOADED:     break;
+            case UI_STATE_ID_TRACE_LOADING:    BuildTraceLoadingView(ui); break;
+            case UI_STATE_ID_TRACE_LOADED:     BuildTraceLoadedView(ui); break;
             case UI_STATE_ID_TRACE_LOAD_ERROR: break;
             default: break; /* serious error */
         }
@@ -509,9 +1559,10 @@ BuildImgui
         {
             // TODO(rlk): a new trace file was loaded. re-initialize the UI.
             DeleteUIState(ui); ui = new_ui;
-            ui->TopLevelState = UI_STATE_ID_TRACE_LOADING;
-            ui->EventData = NewProfilerEvents(new_ui->TracePath);
-            // ...
+            ui->EventData     = NewProfilerEvents(new_ui->TracePath);
+            ui->TopLevelState = ui->EventData != NULL ? UI_STATE_ID_TRACE_LOADING : UI_STATE_ID_TRACE_LOAD_ERROR;
+            ui->QueryStart    = 0.0f;
+            ui->QueryEnd      = 1.0f;
         }
         else
         {   // the user cancelled.
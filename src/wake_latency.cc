@@ -0,0 +1,231 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implement wake-up latency analysis. Each ready interval that ends
+/// a wait in the materialized thread history is followed by a running
+/// interval; its duration is the scheduler latency of the wakeup. Latencies
+/// are recorded in log-linear histograms with fixed bucket boundaries, so the
+/// histograms of threads can be merged into pools and into a trace total.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*////////////////////
+//   Preprocessor   //
+////////////////////*/
+/// @summary Define the default latency above which a wakeup is listed as slow, in nanoseconds.
+#ifndef WIN32_WAKE_LATENCY_DEFAULT_THRESHOLD
+#define WIN32_WAKE_LATENCY_DEFAULT_THRESHOLD   1000000ULL
+#endif
+
+/*//////////////////
+//   Data Types   //
+//////////////////*/
+/// @summary Define a slow wakeup before it is stored in the columns of a WIN32_WAKE_LATENCY.
+struct WAKE_LATENCY_SLOW
+{
+    uint64_t                   Latency;      /// The latency of the wakeup, in nanoseconds.
+    uint64_t                   ReadyTime;    /// The time the wakeup was requested, in nanoseconds.
+    uint32_t                   ProcessIndex; /// The index of the process in WIN32_PROCESS_LIST::ProcessInfo.
+    uint32_t                   ThreadIndex;  /// The index of the thread in WIN32_PROCESS_INFO::ThreadInfo.
+};
+
+/*//////////////////////////
+//   Internal Functions   //
+//////////////////////////*/
+/// @summary Order slow wakeups by descending latency, and then by ascending ready time.
+/// @param a The first wakeup to compare.
+/// @param b The second wakeup to compare.
+/// @return true if a should be listed before b.
+internal_function bool
+WakeLatencySlowBefore
+(
+    WAKE_LATENCY_SLOW const &a,
+    WAKE_LATENCY_SLOW const &b
+)
+{
+    return (a.Latency != b.Latency) ? (a.Latency > b.Latency) : (a.ReadyTime < b.ReadyTime);
+}
+
+/// @summary Order threads by descending 99th percentile latency. Keys are (percentile, position), so ties keep thread order.
+/// @param a The first key to compare.
+/// @param b The second key to compare.
+/// @return true if a should be listed before b.
+internal_function bool
+WakeLatencyThreadBefore
+(
+    std::pair<uint64_t, size_t> const &a,
+    std::pair<uint64_t, size_t> const &b
+)
+{
+    return (a.first != b.first) ? (a.first > b.first) : (a.second < b.second);
+}
+
+/// @summary Record the latency of each wakeup of a thread from its materialized intervals. A wakeup is a ready interval that ended a wait,
+/// marked by BuildThreadIntervals with the reason of that wait; it completes when the next running interval starts. A waiting interval
+/// followed directly by a running interval was readied and run at the same instant, and is a wakeup with no latency.
+/// @param h The histogram to update.
+/// @param slow The list to which wakeups slower than threshold are appended.
+/// @param thread The thread whose intervals, built by BuildThreadIntervals, are read.
+/// @param process_index The index of the process owning the thread.
+/// @param thread_index The index of the thread within the process.
+/// @param threshold The latency above which a wakeup is slow, in nanoseconds.
+internal_function void
+GatherThreadWakeLatency
+(
+    WIN32_LATENCY_HISTOGRAM          *h,
+    std::vector<WAKE_LATENCY_SLOW> &slow,
+    WIN32_THREAD_INFO const     *thread,
+    uint32_t              process_index,
+    uint32_t               thread_index,
+    uint64_t                  threshold
+)
+{
+    WIN32_THREAD_INTERVALS const &intervals = thread->Intervals;
+    size_t const n = intervals.IntervalCount;
+    for (size_t k = 0; k < n; ++k)
+    {
+        if (intervals.State[k] == WIN32_THREAD_STATE_WAITING)
+        {   // other waits end with a ready interval, which is measured below.
+            if (k + 1 < n && intervals.State[k + 1] == WIN32_THREAD_STATE_RUNNING)
+                LatencyHistogramAdd(h, 0);
+            continue;
+        }
+        if (intervals.State[k] != WIN32_THREAD_STATE_READY || intervals.WaitReason[k] == WIN32_WAIT_REASON_NONE)
+            continue; // the thread was running, or was preempted rather than woken.
+        uint64_t const ready   = intervals.Start[k];
+        uint64_t       latency = intervals.Duration[k];
+        while (k + 1 < n && intervals.State[k + 1] == WIN32_THREAD_STATE_READY && intervals.Start[k + 1] == ready + latency)
+        {   // BuildThreadIntervals splits a wait longer than a uint32_t duration into consecutive intervals.
+            latency += intervals.Duration[++k];
+        }
+        if (k + 1 == n || intervals.State[k + 1] != WIN32_THREAD_STATE_RUNNING)
+            continue; // the thread never ran after it was woken.
+        LatencyHistogramAdd(h, latency);
+        if (latency > threshold)
+        {
+            WAKE_LATENCY_SLOW s;
+            s.Latency      = latency;
+            s.ReadyTime    = ready;
+            s.ProcessIndex = process_index;
+            s.ThreadIndex  = thread_index;
+            slow.push_back(s);
+        }
+    }
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Free the memory used by a wake-up latency analysis. The analysis is left empty.
+/// @param wl The analysis to delete.
+public_function void
+DeleteWakeLatency
+(
+    WIN32_WAKE_LATENCY *wl
+)
+{
+    wl->Threshold   = WIN32_WAKE_LATENCY_DEFAULT_THRESHOLD;
+    wl->PoolCount   = 0;
+    wl->ThreadCount = 0;
+    wl->SlowCount   = 0;
+    DeleteLatencyHistogram(&wl->All);
+    WIN32_COLUMN<uint32_t>().swap(wl->PoolId);
+    std::vector<WIN32_LATENCY_HISTOGRAM>().swap(wl->PoolHistogram);
+    WIN32_COLUMN<uint32_t>().swap(wl->ThreadProcess);
+    WIN32_COLUMN<uint32_t>().swap(wl->ThreadIndex);
+    WIN32_COLUMN<uint32_t>().swap(wl->ThreadPoolId);
+    std::vector<WIN32_LATENCY_HISTOGRAM>().swap(wl->ThreadHistogram);
+    WIN32_COLUMN<uint64_t>().swap(wl->SlowReadyTime);
+    WIN32_COLUMN<uint64_t>().swap(wl->SlowLatency);
+    WIN32_COLUMN<uint32_t>().swap(wl->SlowProcess);
+    WIN32_COLUMN<uint32_t>().swap(wl->SlowThread);
+}
+
+/// @summary Measure the scheduler latency of every thread wakeup in a trace.
+/// @param wl The analysis to build. Any existing contents are replaced.
+/// @param process_list The process list, with thread intervals built by BuildProcessThreadIntervals.
+/// @param scheduler The task scheduler configuration, used to assign worker threads to pools.
+/// @param threshold Wakeups with a latency greater than this value, in nanoseconds, are listed as slow.
+public_function void
+BuildWakeLatency
+(
+    WIN32_WAKE_LATENCY              *wl,
+    WIN32_PROCESS_LIST const *process_list,
+    WIN32_SCHEDULER_INFO const  *scheduler,
+    uint64_t                     threshold
+)
+{
+    std::vector<WAKE_LATENCY_SLOW>            slow;
+    std::vector<std::pair<uint32_t, uint32_t> > worker_pool(scheduler->WorkerCount);
+    std::vector<std::pair<uint64_t, size_t> >   order;
+    std::vector<uint32_t>                       process;
+    std::vector<uint32_t>                       index;
+    std::vector<uint32_t>                       pool;
+    std::vector<WIN32_LATENCY_HISTOGRAM>        hist;
+
+    DeleteWakeLatency(wl);
+    wl->Threshold = threshold;
+    for (size_t i = 0; i < scheduler->WorkerCount; ++i)
+    {
+        worker_pool[i] = std::make_pair(scheduler->WorkerThreadId[i], scheduler->WorkerPoolId[i]);
+    }
+    std::sort(worker_pool.begin(), worker_pool.end());
+
+    for (size_t i = 0; i < process_list->ProcessCount; ++i)
+    {
+        WIN32_PROCESS_INFO const &proc = process_list->ProcessInfo[i];
+        for (size_t j = 0; j < proc.ThreadCount; ++j)
+        {
+            WIN32_LATENCY_HISTOGRAM h = {};
+            GatherThreadWakeLatency(&h, slow, &proc.ThreadInfo[j], uint32_t(i), uint32_t(j), threshold);
+            if (h.Count == 0)
+                continue;
+            std::vector<std::pair<uint32_t, uint32_t> >::const_iterator w = std::lower_bound(worker_pool.begin(), worker_pool.end(), std::make_pair(proc.ThreadId[j], uint32_t(0)));
+            uint32_t const pool_id = (w != worker_pool.end() && w->first == proc.ThreadId[j]) ? w->second : uint32_t(WIN32_WAKE_LATENCY_NO_POOL);
+            order.push_back(std::make_pair(LatencyHistogramPercentile(&h, 99.0), hist.size()));
+            process.push_back(uint32_t(i));
+            index.push_back(uint32_t(j));
+            pool.push_back(pool_id);
+            hist.push_back(WIN32_LATENCY_HISTOGRAM());
+            std::swap(hist.back(), h);
+        }
+    }
+
+    // list threads worst first, and merge each into its pool and into the trace total.
+    std::sort(order.begin(), order.end(), WakeLatencyThreadBefore);
+    wl->ThreadCount = order.size();
+    wl->ThreadProcess.resize(order.size());
+    wl->ThreadIndex.resize(order.size());
+    wl->ThreadPoolId.resize(order.size());
+    wl->ThreadHistogram.resize(order.size());
+    for (size_t i = 0, n = order.size(); i < n; ++i)
+    {
+        size_t const k = order[i].second;
+        wl->ThreadProcess[i] = process[k];
+        wl->ThreadIndex  [i] = index[k];
+        wl->ThreadPoolId [i] = pool[k];
+        std::swap(wl->ThreadHistogram[i], hist[k]);
+        MergeLatencyHistogram(&wl->All, &wl->ThreadHistogram[i]);
+        wl->PoolId.push_back(pool[k]);
+    }
+    std::sort(wl->PoolId.begin(), wl->PoolId.end());
+    wl->PoolId.resize(size_t(std::unique(wl->PoolId.begin(), wl->PoolId.end()) - wl->PoolId.begin()));
+    wl->PoolCount = wl->PoolId.size();
+    wl->PoolHistogram.resize(wl->PoolCount);
+    for (size_t i = 0; i < wl->ThreadCount; ++i)
+    {
+        size_t const p = size_t(std::lower_bound(wl->PoolId.begin(), wl->PoolId.end(), wl->ThreadPoolId[i]) - wl->PoolId.begin());
+        MergeLatencyHistogram(&wl->PoolHistogram[p], &wl->ThreadHistogram[i]);
+    }
+
+    std::sort(slow.begin(), slow.end(), WakeLatencySlowBefore);
+    wl->SlowCount = slow.size();
+    wl->SlowReadyTime.resize(slow.size());
+    wl->SlowLatency.resize(slow.size());
+    wl->SlowProcess.resize(slow.size());
+    wl->SlowThread.resize(slow.size());
+    for (size_t i = 0, n = slow.size(); i < n; ++i)
+    {
+        wl->SlowReadyTime[i] = slow[i].ReadyTime;
+        wl->SlowLatency  [i] = slow[i].Latency;
+        wl->SlowProcess  [i] = slow[i].ProcessIndex;
+        wl->SlowThread   [i] = slow[i].ThreadIndex;
+    }
+}
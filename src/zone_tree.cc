@@ -0,0 +1,229 @@
+/*/////////////////////////////////////////////////////////////////////////////
+/// @summary Implement the reconstruction of nested zones from the zone events
+/// written by PROFILER_ZONE scopes. The events of each thread are replayed in
+/// order against a stack of open zones, which yields every zone with its
+/// parent and depth in preorder. Each zone is then attributed to the task its
+/// thread was executing when the zone began.
+///////////////////////////////////////////////////////////////////////////80*/
+
+/*//////////////////////////
+//   Internal Functions   //
+//////////////////////////*/
+/// @summary Close the zone on top of the open zone stack of a thread.
+/// @param tree The zone tree being built.
+/// @param stack The indices of the open zones of the thread, innermost last.
+/// @param time The time at which the zone ended, in nanoseconds.
+internal_function inline void
+CloseZone
+(
+    WIN32_ZONE_TREE          *tree,
+    std::vector<uint32_t>   &stack,
+    uint64_t                  time
+)
+{
+    uint32_t const zone = stack.back();
+    tree->EndTime[zone] = time > tree->BeginTime[zone] ? time : tree->BeginTime[zone];
+    stack.pop_back();
+}
+
+/*////////////////////////
+//   Public Functions   //
+////////////////////////*/
+/// @summary Initialize an empty zone event list.
+/// @param list The zone event list to initialize.
+public_function void
+InitZoneEventList
+(
+    WIN32_ZONE_EVENT_LIST *list
+)
+{
+    list->EventCount = 0;
+    list->EventTime.clear();
+    list->ThreadId.clear();
+    list->SiteId.clear();
+    list->EventType.clear();
+    list->SiteCount  = 0;
+    list->SiteName.clear();
+    list->SiteFile.clear();
+    list->SiteFunction.clear();
+    list->SiteLine.clear();
+}
+
+/// @summary Append an event to a zone event list. Events from one thread must be appended in the order they occurred.
+/// @param list The zone event list to update.
+/// @param type One of WIN32_ZONE_EVENT_TYPE.
+/// @param time The time at which the event occurred, in nanoseconds.
+/// @param thread_id The operating system identifier of the thread that produced the event.
+/// @param site_id The identifier of the zone site.
+public_function void
+AppendZoneEvent
+(
+    WIN32_ZONE_EVENT_LIST *list,
+    uint8_t                type,
+    uint64_t               time,
+    uint32_t          thread_id,
+    uint32_t            site_id
+)
+{
+    list->EventTime.push_back(time);
+    list->ThreadId.push_back(thread_id);
+    list->SiteId.push_back(site_id);
+    list->EventType.push_back(type);
+    list->EventCount++;
+}
+
+/// @summary Set the description of a zone site, growing the site columns if necessary. A site registered again replaces its previous description.
+/// @param list The zone event list to update.
+/// @param site_id The identifier of the zone site.
+/// @param name The name of the zone.
+/// @param file The source file containing the site.
+/// @param function The function containing the site.
+/// @param line The source line of the site.
+public_function void
+SetZoneSite
+(
+    WIN32_ZONE_EVENT_LIST *list,
+    uint32_t            site_id,
+    std::string const     &name,
+    std::string const     &file,
+    std::string const &function,
+    uint32_t               line
+)
+{
+    if (site_id >= list->SiteCount)
+    {
+        list->SiteCount = size_t(site_id) + 1;
+        list->SiteName.resize(list->SiteCount);
+        list->SiteFile.resize(list->SiteCount);
+        list->SiteFunction.resize(list->SiteCount);
+        list->SiteLine.resize(list->SiteCount, 0);
+    }
+    list->SiteName    [site_id] = name;
+    list->SiteFile    [site_id] = file;
+    list->SiteFunction[site_id] = function;
+    list->SiteLine    [site_id] = line;
+}
+
+/// @summary Free the memory used by a zone tree. The tree is left empty.
+/// @param tree The zone tree to delete.
+public_function void
+DeleteZoneTree
+(
+    WIN32_ZONE_TREE *tree
+)
+{
+    tree->ZoneCount      = 0;
+    tree->UnmatchedCount = 0;
+    WIN32_COLUMN<uint64_t>().swap(tree->BeginTime);
+    WIN32_COLUMN<uint64_t>().swap(tree->EndTime);
+    WIN32_COLUMN<uint32_t>().swap(tree->ThreadId);
+    WIN32_COLUMN<uint32_t>().swap(tree->SiteId);
+    WIN32_COLUMN<uint32_t>().swap(tree->ParentZone);
+    WIN32_COLUMN<uint32_t>().swap(tree->TaskRow);
+    WIN32_COLUMN<uint32_t>().swap(tree->Depth);
+    WIN32_COLUMN<uint64_t>().swap(tree->SiteZoneCount);
+    WIN32_COLUMN<uint64_t>().swap(tree->SiteInclusiveTime);
+    WIN32_COLUMN<uint64_t>().swap(tree->SiteSelfTime);
+}
+
+/// @summary Reconstruct the nested zones of every thread from a zone event list. An end event closes the innermost open zone with the
+/// same site, closing any zones opened inside it; an end event with no open zone at its site is ignored. Zones still open after the last
+/// event of their thread end at that event. Both cases are counted in UnmatchedCount, and happen when events were dropped.
+/// @param tree The zone tree to build. Any existing contents are replaced.
+/// @param events The zone event list.
+/// @param task_table The task table, with complete launch and finish columns.
+public_function void
+BuildZoneTree
+(
+    WIN32_ZONE_TREE                *tree,
+    WIN32_ZONE_EVENT_LIST const  *events,
+    WIN32_TASK_TABLE const   *task_table
+)
+{
+    std::vector<std::pair<uint32_t, uint32_t> > order(events->EventCount);
+    std::vector<std::pair<uint32_t, uint32_t> > worker_launch;
+    std::vector<uint32_t>                       stack;
+    size_t                                      site_count = events->SiteCount;
+
+    DeleteZoneTree(tree);
+    for (size_t i = 0, n = order.size(); i < n; ++i)
+    {   // sorting by (thread, index) groups the events by thread and keeps each thread's events in order.
+        order[i] = std::make_pair(events->ThreadId[i], uint32_t(i));
+        if (events->SiteId[i] >= site_count) site_count = size_t(events->SiteId[i]) + 1;
+    }
+    std::sort(order.begin(), order.end());
+    tree->BeginTime.reserve(order.size() / 2);
+    tree->EndTime.reserve(order.size() / 2);
+    tree->ThreadId.reserve(order.size() / 2);
+    tree->SiteId.reserve(order.size() / 2);
+    tree->ParentZone.reserve(order.size() / 2);
+    tree->Depth.reserve(order.size() / 2);
+
+    for (size_t i = 0, n = order.size(); i < n; )
+    {
+        uint32_t const thread_id = order[i].first;
+        uint64_t       last_time = 0;
+        stack.clear();
+        for ( ; i < n && order[i].first == thread_id; ++i)
+        {
+            uint32_t const e    = order[i].second;
+            uint32_t const site = events->SiteId[e];
+            uint64_t const time = events->EventTime[e];
+            last_time = time;
+            if (events->EventType[e] == WIN32_ZONE_EVENT_BEGIN)
+            {   // zones are appended as they begin, which produces preorder.
+                uint32_t const zone = uint32_t(tree->ZoneCount++);
+                tree->BeginTime.push_back(time);
+                tree->EndTime.push_back(time);
+                tree->ThreadId.push_back(thread_id);
+                tree->SiteId.push_back(site);
+                tree->ParentZone.push_back(stack.empty() ? WIN32_OBJECT_INDEX_EMPTY : stack.back());
+                tree->Depth.push_back(uint32_t(stack.size()));
+                stack.push_back(zone);
+                continue;
+            }
+            size_t depth = stack.size();
+            while (depth > 0 && tree->SiteId[stack[depth - 1]] != site)
+                depth--;
+            if (depth == 0)
+            {   // the begin event was lost, or was recorded before the trace started.
+                tree->UnmatchedCount++;
+                continue;
+            }
+            while (stack.size() > depth)
+            {   // zones opened inside this one lost their end events.
+                CloseZone(tree, stack, time);
+                tree->UnmatchedCount++;
+            }
+            CloseZone(tree, stack, time);
+        }
+        while (!stack.empty())
+        {   // the end events were lost, or the trace stopped inside the zones.
+            CloseZone(tree, stack, last_time);
+            tree->UnmatchedCount++;
+        }
+    }
+
+    // attribute each zone to the task its thread was executing when the zone began.
+    BuildWorkerLaunchIndex(task_table, worker_launch);
+    tree->TaskRow.resize(tree->ZoneCount);
+    for (size_t i = 0; i < tree->ZoneCount; ++i)
+    {
+        tree->TaskRow[i] = FindWorkerTask(task_table, worker_launch, tree->ThreadId[i], tree->BeginTime[i], tree->BeginTime[i]);
+    }
+
+    // a nested zone lies within its parent, so subtracting it from the parent's self time never makes the total negative.
+    tree->SiteZoneCount.assign(site_count, 0);
+    tree->SiteInclusiveTime.assign(site_count, 0);
+    tree->SiteSelfTime.assign(site_count, 0);
+    for (size_t i = 0; i < tree->ZoneCount; ++i)
+    {
+        uint32_t const site     = tree->SiteId[i];
+        uint32_t const parent   = tree->ParentZone[i];
+        uint64_t const duration = tree->EndTime[i] - tree->BeginTime[i];
+        tree->SiteZoneCount[site]++;
+        tree->SiteInclusiveTime[site] += duration;
+        tree->SiteSelfTime[site]      += duration;
+        if (parent != WIN32_OBJECT_INDEX_EMPTY) tree->SiteSelfTime[tree->SiteId[parent]] -= duration;
+    }
+}